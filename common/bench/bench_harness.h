@@ -0,0 +1,320 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Общая обвязка бенчмарков: фиксированный seed, прогрев, несколько замеров
+ * со статистикой и вывод результатов в JSON для отслеживания динамики.
+ * Единственная копия для всех проектов с бенчмарками: их CMakeLists.txt добавляют
+ * каталог common/bench к путям поиска заголовков.
+ *
+ * Параметры командной строки, общие для всех бенчмарков:
+ *   --filter <подстрока>      запускать только замеры, в имени которых есть подстрока
+ *   --samples <n>             количество замеров (по умолчанию 15)
+ *   --warmup-ms <мс>          длительность прогрева каждого замера (по умолчанию 100)
+ *   --sample-ms <мс>          минимальная длительность одного замера (по умолчанию 20)
+ *   --seed <n>                seed генераторов входных данных
+ *   --json <файл>             записать результаты в файл JSON
+ *   --baseline <файл>         сравнить медианы с результатами прежнего запуска (--json)
+ *   --max-regression <доля>   допустимое замедление медианы, по умолчанию 0.1.
+ *                             При большем замедлении программа завершается с кодом ошибки
+ * Остальные аргументы доступны бенчмарку в Options::positional.
+ */
+
+namespace bench {
+
+struct Options {
+    std::uint64_t seed = 20240415;
+    int samples = 15;
+    std::chrono::milliseconds warmup{100};
+    std::chrono::milliseconds sample_time{20};
+    std::string filter;
+    std::optional<std::string> json_file;
+    std::optional<std::string> baseline_file;
+    double max_regression = 0.1;
+    std::vector<std::string> positional;
+};
+
+[[noreturn]] inline void ExitWithUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--filter <substring>] [--samples <n>] [--warmup-ms <ms>] "
+                 "[--sample-ms <ms>] [--seed <n>] [--json <file>] "
+                 "[--baseline <file> [--max-regression <fraction>]] [args...]\n",
+                 program);
+    std::exit(EXIT_FAILURE);
+}
+
+inline Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (!arg.starts_with("--")) {
+            options.positional.emplace_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            ExitWithUsage(argv[0]);
+        }
+        const char* value = argv[++i];
+        char* end = nullptr;
+        if (arg == "--filter") {
+            options.filter = value;
+            continue;
+        } else if (arg == "--json") {
+            options.json_file = value;
+            continue;
+        } else if (arg == "--baseline") {
+            options.baseline_file = value;
+            continue;
+        } else if (arg == "--samples") {
+            options.samples = static_cast<int>(std::strtol(value, &end, 10));
+        } else if (arg == "--warmup-ms") {
+            options.warmup = std::chrono::milliseconds{std::strtol(value, &end, 10)};
+        } else if (arg == "--sample-ms") {
+            options.sample_time = std::chrono::milliseconds{std::strtol(value, &end, 10)};
+        } else if (arg == "--seed") {
+            options.seed = std::strtoull(value, &end, 10);
+        } else if (arg == "--max-regression") {
+            options.max_regression = std::strtod(value, &end);
+        } else {
+            ExitWithUsage(argv[0]);
+        }
+        if (end == value || *end != '\0') {
+            ExitWithUsage(argv[0]);
+        }
+    }
+    if (options.samples < 1) {
+        ExitWithUsage(argv[0]);
+    }
+    return options;
+}
+
+// Не позволяет компилятору выбросить вычисление value как неиспользуемое
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Статистика длительности одной операции по замерам, в наносекундах
+struct Stats {
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double stddev = 0;
+    double p90 = 0;
+};
+
+inline Stats ComputeStats(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto quantile = [&values](double q) {
+        // Линейная интерполяция между соседними упорядоченными значениями
+        const double pos = q * static_cast<double>(values.size() - 1);
+        const size_t lower = static_cast<size_t>(pos);
+        const size_t upper = std::min(lower + 1, values.size() - 1);
+        return values[lower] + (values[upper] - values[lower]) * (pos - static_cast<double>(lower));
+    };
+    Stats stats;
+    stats.min = values.front();
+    stats.median = quantile(0.5);
+    stats.p90 = quantile(0.9);
+    double sum = 0;
+    for (const double value : values) {
+        sum += value;
+    }
+    stats.mean = sum / static_cast<double>(values.size());
+    double squares = 0;
+    for (const double value : values) {
+        squares += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stddev = values.size() > 1 ? std::sqrt(squares / static_cast<double>(values.size() - 1)) : 0;
+    return stats;
+}
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations = 0;
+    Stats ns_per_op;
+    // Объём входных данных одной операции. 0, если пропускная способность не имеет смысла
+    size_t bytes_per_op = 0;
+};
+
+/*
+ * Набор замеров одной программы. Результаты печатаются по мере выполнения,
+ * а Finish записывает JSON и сравнивает результаты с базовыми
+ */
+class Suite {
+public:
+    Suite(std::string name, Options options)
+        : name_{std::move(name)}
+        , options_{std::move(options)} {
+        std::printf("%-40s %12s %12s %10s %12s %12s %10s\n", "benchmark", "median ns", "mean ns",
+                    "stddev %", "min ns", "p90 ns", "MB/s");
+    }
+
+    const Options& GetOptions() const noexcept {
+        return options_;
+    }
+
+    /*
+     * Измеряет длительность операции fn(). Число вызовов fn в одном замере подбирается
+     * по результатам прогрева так, чтобы замер длился не меньше Options::sample_time
+     */
+    template <typename Fn>
+    void Run(std::string_view name, Fn&& fn, size_t bytes_per_op = 0) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string_view::npos) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+
+        std::uint64_t warmup_calls = 0;
+        const auto warmup_start = Clock::now();
+        auto elapsed = Clock::duration{};
+        do {
+            fn();
+            ++warmup_calls;
+            elapsed = Clock::now() - warmup_start;
+        } while (elapsed < options_.warmup);
+        const double warmup_ns_per_op =
+            std::chrono::duration<double, std::nano>{elapsed}.count() / static_cast<double>(warmup_calls);
+        const double sample_ns = std::chrono::duration<double, std::nano>{options_.sample_time}.count();
+        const auto iterations =
+            std::max<std::uint64_t>(1, static_cast<std::uint64_t>(sample_ns / warmup_ns_per_op));
+
+        std::vector<double> samples;
+        samples.reserve(static_cast<size_t>(options_.samples));
+        for (int sample = 0; sample < options_.samples; ++sample) {
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                fn();
+            }
+            const std::chrono::duration<double, std::nano> duration = Clock::now() - start;
+            samples.push_back(duration.count() / static_cast<double>(iterations));
+        }
+
+        Result result{std::string{name}, iterations, ComputeStats(std::move(samples)), bytes_per_op};
+        Print(result);
+        results_.push_back(std::move(result));
+    }
+
+    // Записывает результаты в JSON и сравнивает их с базовыми.
+    // Возвращает код завершения программы
+    int Finish() const {
+        if (options_.json_file && !WriteJson(*options_.json_file)) {
+            std::fprintf(stderr, "Failed to write %s\n", options_.json_file->c_str());
+            return EXIT_FAILURE;
+        }
+        if (options_.baseline_file) {
+            return CompareWithBaseline(*options_.baseline_file) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+private:
+    static void Print(const Result& result) {
+        const auto& ns = result.ns_per_op;
+        char throughput[32] = "-";
+        if (result.bytes_per_op != 0) {
+            std::snprintf(throughput, sizeof(throughput), "%.0f",
+                          static_cast<double>(result.bytes_per_op) / ns.median * 1e3);
+        }
+        std::printf("%-40s %12.1f %12.1f %10.1f %12.1f %12.1f %10s\n", result.name.c_str(),
+                    ns.median, ns.mean, ns.mean > 0 ? ns.stddev / ns.mean * 100 : 0.0, ns.min,
+                    ns.p90, throughput);
+        std::fflush(stdout);
+    }
+
+    static std::string Escape(std::string_view str) {
+        std::string result;
+        for (const char c : str) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result;
+    }
+
+    // Каждый замер занимает одну строку файла, поэтому базовые результаты
+    // читаются без разбора JSON
+    bool WriteJson(const std::string& file) const {
+        std::ofstream out{file};
+        out << "{\n  \"suite\": \"" << Escape(name_) << "\",\n  \"seed\": " << options_.seed
+            << ",\n  \"samples\": " << options_.samples << ",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const auto& result = results_[i];
+            const auto& ns = result.ns_per_op;
+            char line[512];
+            std::snprintf(line, sizeof(line),
+                          "\"iterations\": %llu, \"min_ns\": %.3f, \"median_ns\": %.3f, "
+                          "\"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"p90_ns\": %.3f, "
+                          "\"bytes_per_op\": %zu",
+                          static_cast<unsigned long long>(result.iterations), ns.min, ns.median,
+                          ns.mean, ns.stddev, ns.p90, result.bytes_per_op);
+            out << "    {\"name\": \"" << Escape(result.name) << "\", " << line << '}'
+                << (i + 1 < results_.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out.flush());
+    }
+
+    static std::map<std::string, double> ReadBaseline(const std::string& file) {
+        constexpr std::string_view NAME_KEY = "{\"name\": \"";
+        constexpr std::string_view MEDIAN_KEY = "\"median_ns\": ";
+        std::map<std::string, double> medians;
+        std::ifstream in{file};
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto name_pos = line.find(NAME_KEY);
+            const auto median_pos = line.find(MEDIAN_KEY);
+            if (name_pos == std::string::npos || median_pos == std::string::npos) {
+                continue;
+            }
+            std::string name;
+            for (size_t i = name_pos + NAME_KEY.size(); i < line.size() && line[i] != '"'; ++i) {
+                if (line[i] == '\\' && i + 1 < line.size()) {
+                    ++i;
+                }
+                name += line[i];
+            }
+            medians[name] = std::strtod(line.c_str() + median_pos + MEDIAN_KEY.size(), nullptr);
+        }
+        return medians;
+    }
+
+    bool CompareWithBaseline(const std::string& file) const {
+        const auto baseline = ReadBaseline(file);
+        if (baseline.empty()) {
+            std::fprintf(stderr, "No baseline results in %s\n", file.c_str());
+            return false;
+        }
+        bool passed = true;
+        for (const auto& result : results_) {
+            const auto it = baseline.find(result.name);
+            if (it == baseline.end() || it->second <= 0) {
+                continue;
+            }
+            const double change = result.ns_per_op.median / it->second - 1;
+            const bool regressed = change > options_.max_regression;
+            std::printf("%-40s %+8.1f%% %s\n", result.name.c_str(), change * 100,
+                        regressed ? "REGRESSION" : "ok");
+            passed = passed && !regressed;
+        }
+        return passed;
+    }
+
+    std::string name_;
+    Options options_;
+    std::vector<Result> results_;
+};
+
+}  // namespace bench
@@ -0,0 +1,111 @@
+#include "admission.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace http_server {
+
+namespace {
+
+std::uint64_t Mix(std::uint64_t x) noexcept {
+    // Финализатор splitmix64: каждый бит результата зависит от всех битов аргумента
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+}  // namespace
+
+AdmissionControl::ClientKey AdmissionControl::MakeClientKey(
+    const net::ip::address& address) noexcept {
+    if (address.is_v4()) {
+        return net::ip::make_address_v6(net::ip::v4_mapped, address.to_v4()).to_bytes();
+    }
+    const auto v6 = address.to_v6();
+    auto key = v6.to_bytes();
+    if (!v6.is_v4_mapped()) {
+        std::fill(key.begin() + key.size() / 2, key.end(), 0);
+    }
+    return key;
+}
+
+size_t AdmissionControl::ClientKeyHasher::operator()(const ClientKey& key) const noexcept {
+    std::uint64_t hi;
+    std::uint64_t lo;
+    std::memcpy(&hi, key.data(), sizeof(hi));
+    std::memcpy(&lo, key.data() + sizeof(hi), sizeof(lo));
+    return static_cast<size_t>(Mix(hi ^ Mix(lo)));
+}
+
+AdmissionControl::AdmissionControl(AdmissionOptions options)
+    : options_{options} {
+    if (options_.burst < 1) {
+        options_.burst = std::max(1.0, options_.rate);
+    }
+}
+
+AdmissionControl::Decision AdmissionControl::Admit(const ClientKey& client, Permit& permit) {
+    if (options_.rate > 0 && !TakeToken(client)) {
+        return Decision::RATE_LIMITED;
+    }
+    if (options_.max_in_flight == 0) {
+        return Decision::ACCEPT;
+    }
+    // Счётчик увеличиваем сразу: при одновременных запросах лимит не будет превышен
+    if (in_flight_.fetch_add(1, std::memory_order_relaxed) >= options_.max_in_flight) {
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        return Decision::OVERLOADED;
+    }
+    permit = Permit{&in_flight_};
+    return Decision::ACCEPT;
+}
+
+bool AdmissionControl::TakeToken(const ClientKey& client) {
+    const size_t hash = ClientKeyHasher{}(client);
+    // Старшие биты хеша выбирают сегмент, а младшие используются внутри него
+    auto& shard = shards_[(hash >> 32) % SHARD_COUNT];
+    const auto now = Clock::now();
+
+    std::lock_guard lk{shard.mutex};
+    auto it = shard.buckets.find(client);
+    if (it == shard.buckets.end()) {
+        if (shard.buckets.size() >= MAX_CLIENTS_PER_SHARD) {
+            Sweep(shard, now);
+        }
+        it = shard.buckets.emplace(client, Bucket{options_.burst, now}).first;
+    }
+
+    auto& bucket = it->second;
+    bucket.tokens = Refill(bucket, now);
+    bucket.updated = now;
+    if (bucket.tokens < 1) {
+        return false;
+    }
+    bucket.tokens -= 1;
+    return true;
+}
+
+void AdmissionControl::Sweep(Shard& shard, Clock::time_point now) {
+    if (now - shard.last_sweep >= SWEEP_INTERVAL) {
+        shard.last_sweep = now;
+        std::erase_if(shard.buckets, [this, now](const auto& item) {
+            return Refill(item.second, now) >= options_.burst;
+        });
+    }
+    if (shard.buckets.size() >= MAX_CLIENTS_PER_SHARD) {
+        // Все клиенты активны. Жертвуем точностью ограничения для одного из них,
+        // но не даём памяти расти без предела
+        shard.buckets.erase(shard.buckets.begin());
+    }
+}
+
+double AdmissionControl::Refill(const Bucket& bucket, Clock::time_point now) const noexcept {
+    const std::chrono::duration<double> elapsed = now - bucket.updated;
+    return std::min(options_.burst, bucket.tokens + elapsed.count() * options_.rate);
+}
+
+}  // namespace http_server
@@ -0,0 +1,144 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+//
+#include <boost/asio/ip/address.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+// Параметры контроля допуска запросов. Нулевое значение отключает ограничение
+struct AdmissionOptions {
+    // Средняя частота запросов одного клиента, запросов в секунду
+    double rate = 0;
+    // Сколько запросов клиент может прислать подряд, не дожидаясь пополнения.
+    // Значения меньше 1 заменяются на max(1, rate)
+    double burst = 0;
+    // Максимальное количество запросов, одновременно находящихся у обработчика
+    size_t max_in_flight = 0;
+
+    bool IsEnabled() const noexcept {
+        return rate > 0 || max_in_flight > 0;
+    }
+};
+
+/*
+ * Контроль допуска запросов к обработчику.
+ * Частота запросов каждого клиента ограничивается «ведром токенов», а общее количество
+ * запросов в обработке — счётчиком. Запрос, не прошедший проверку, не доходит до обработчика
+ * и не занимает очередь, поэтому при перегрузке время ответа остальным клиентам не растёт.
+ * Состояние клиентов разделено на сегменты по хешу адреса, у каждого сегмента свой мьютекс,
+ * поэтому потоки, обслуживающие разных клиентов, почти не конкурируют между собой.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class AdmissionControl {
+public:
+    enum class Decision {
+        ACCEPT,
+        RATE_LIMITED,  // клиент превысил свою частоту запросов
+        OVERLOADED,    // у обработчика слишком много запросов
+    };
+
+    // Ключ клиента: IPv4-адрес в виде IPv6 либо префикс /64 адреса IPv6, поскольку
+    // одному клиенту IPv6 обычно принадлежит вся подсеть
+    using ClientKey = net::ip::address_v6::bytes_type;
+
+    static ClientKey MakeClientKey(const net::ip::address& address) noexcept;
+
+    // Место в лимите одновременных запросов. Освобождается при разрушении
+    class Permit {
+    public:
+        Permit() = default;
+
+        Permit(Permit&& other) noexcept
+            : counter_{std::exchange(other.counter_, nullptr)} {
+        }
+
+        Permit& operator=(Permit&& rhs) noexcept {
+            if (this != &rhs) {
+                Release();
+                counter_ = std::exchange(rhs.counter_, nullptr);
+            }
+            return *this;
+        }
+
+        ~Permit() {
+            Release();
+        }
+
+    private:
+        friend class AdmissionControl;
+
+        explicit Permit(std::atomic<size_t>* counter) noexcept
+            : counter_{counter} {
+        }
+
+        void Release() noexcept {
+            if (counter_) {
+                counter_->fetch_sub(1, std::memory_order_relaxed);
+                counter_ = nullptr;
+            }
+        }
+
+        std::atomic<size_t>* counter_ = nullptr;
+    };
+
+    explicit AdmissionControl(AdmissionOptions options);
+
+    AdmissionControl(const AdmissionControl&) = delete;
+    AdmissionControl& operator=(const AdmissionControl&) = delete;
+
+    // Решает, можно ли передать обработчику запрос клиента client. При положительном решении
+    // в permit помещается место в лимите одновременных запросов. Объект AdmissionControl
+    // должен жить дольше выданных мест
+    Decision Admit(const ClientKey& client, Permit& permit);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Количество сегментов состояния клиентов
+    constexpr static size_t SHARD_COUNT = 64;
+    // Когда в сегменте столько клиентов, из него удаляются неактивные
+    constexpr static size_t MAX_CLIENTS_PER_SHARD = 4096;
+    // Как часто сегмент можно просматривать в поисках неактивных клиентов
+    constexpr static Clock::duration SWEEP_INTERVAL = std::chrono::seconds{1};
+
+    struct Bucket {
+        double tokens;
+        Clock::time_point updated;
+    };
+
+    struct ClientKeyHasher {
+        size_t operator()(const ClientKey& key) const noexcept;
+    };
+
+    // Сегменты выровнены по строке кэша, чтобы мьютексы соседних сегментов
+    // не делили её между ядрами
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<ClientKey, Bucket, ClientKeyHasher> buckets;
+        Clock::time_point last_sweep;
+    };
+
+    bool TakeToken(const ClientKey& client);
+    // Освобождает место в сегменте, удаляя клиентов, чьи вёдра успели наполниться.
+    // Такое ведро ничем не отличается от нового. Вызывается под мьютексом сегмента
+    void Sweep(Shard& shard, Clock::time_point now);
+    double Refill(const Bucket& bucket, Clock::time_point now) const noexcept;
+
+    AdmissionOptions options_;
+    std::array<Shard, SHARD_COUNT> shards_;
+    alignas(64) std::atomic<size_t> in_flight_{0};
+};
+
+}  // namespace http_server
@@ -0,0 +1,145 @@
+#include "compression.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+std::string_view Trim(std::string_view str) noexcept {
+    const auto begin = str.find_first_not_of(" \t"sv);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(" \t"sv) - begin + 1);
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a))
+            == std::tolower(static_cast<unsigned char>(b));
+    });
+}
+
+// Возвращает false, если в параметрах кодирования указано q=0
+bool IsAcceptable(std::string_view params) noexcept {
+    while (!params.empty()) {
+        const auto end = std::min(params.find(';'), params.size());
+        const auto param = Trim(params.substr(0, end));
+        params.remove_prefix(std::min(end + 1, params.size()));
+        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            // Значение q состоит из нулей и точки тогда и только тогда, когда q == 0
+            return param.substr(2).find_first_not_of("0."sv) != std::string_view::npos;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string_view GetEncodingName(ContentEncoding encoding) noexcept {
+    switch (encoding) {
+        case ContentEncoding::GZIP:
+            return "gzip"sv;
+        case ContentEncoding::DEFLATE:
+            return "deflate"sv;
+        case ContentEncoding::IDENTITY:
+            break;
+    }
+    return "identity"sv;
+}
+
+AcceptedEncodings AcceptedEncodings::Parse(std::string_view accept_encoding) noexcept {
+    AcceptedEncodings result;
+    // Кодирования, явно перечисленные в заголовке, имеют приоритет над *
+    unsigned listed = 0;
+    bool any_accepted = false;
+    while (!accept_encoding.empty()) {
+        const auto end = std::min(accept_encoding.find(','), accept_encoding.size());
+        const auto item = accept_encoding.substr(0, end);
+        accept_encoding.remove_prefix(std::min(end + 1, accept_encoding.size()));
+
+        const auto params_pos = std::min(item.find(';'), item.size());
+        const auto name = Trim(item.substr(0, params_pos));
+        const bool acceptable = IsAcceptable(item.substr(params_pos));
+        if (name == "*"sv) {
+            any_accepted = acceptable;
+            continue;
+        }
+        for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+            if (EqualsIgnoreCase(name, GetEncodingName(encoding))
+                || (encoding == ContentEncoding::GZIP && EqualsIgnoreCase(name, "x-gzip"sv))) {
+                listed |= Bit(encoding);
+                if (acceptable) {
+                    result.bits_ |= Bit(encoding);
+                }
+            }
+        }
+    }
+    if (any_accepted) {
+        result.bits_ |= (Bit(ContentEncoding::GZIP) | Bit(ContentEncoding::DEFLATE)) & ~listed;
+    }
+    return result;
+}
+
+ContentEncoding AcceptedEncodings::GetPreferred() const noexcept {
+    for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+        if (Contains(encoding)) {
+            return encoding;
+        }
+    }
+    return ContentEncoding::IDENTITY;
+}
+
+std::optional<std::string> Compress(std::string_view data, ContentEncoding encoding, int level) {
+    if (encoding == ContentEncoding::IDENTITY) {
+        return std::nullopt;
+    }
+    // Размер окна 15 бит - формат zlib (заголовок deflate), +16 - формат gzip
+    const int window_bits = encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+    z_stream stream{};
+    if (deflateInit2(&stream, std::clamp(level, 1, 9), Z_DEFLATED, window_bits, 8,
+                     Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+        return std::nullopt;
+    }
+
+    std::string result(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+    // deflateBound гарантирует, что результат поместится в буфер за один вызов
+    const int status = deflate(&stream, Z_FINISH);
+    result.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+bool IsCompressibleType(std::string_view content_type) noexcept {
+    constexpr std::array COMPRESSIBLE_TYPES{
+        "application/javascript"sv, "application/json"sv, "application/xml"sv,
+        "image/svg+xml"sv,
+    };
+    // Параметры типа (например, charset) не учитываются
+    const auto params_pos = std::min(content_type.find(';'), content_type.size());
+    const auto type = Trim(content_type.substr(0, params_pos));
+    if (type.size() > 5 && EqualsIgnoreCase(type.substr(0, 5), "text/"sv)) {
+        return true;
+    }
+    return std::any_of(COMPRESSIBLE_TYPES.begin(), COMPRESSIBLE_TYPES.end(),
+                       [type](std::string_view compressible) {
+                           return EqualsIgnoreCase(type, compressible);
+                       });
+}
+
+}  // namespace http_server
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace http_server {
+
+// Кодирование тела ответа (Content-Encoding)
+enum class ContentEncoding : unsigned { IDENTITY, DEFLATE, GZIP };
+constexpr size_t CONTENT_ENCODING_COUNT = 3;
+
+// Название кодирования для заголовка Content-Encoding
+std::string_view GetEncodingName(ContentEncoding encoding) noexcept;
+
+// Набор кодирований, которые принимает клиент
+class AcceptedEncodings {
+public:
+    // Разбирает значение заголовка Accept-Encoding, учитывая q-значения
+    // (например, "gzip;q=0" запрещает gzip)
+    static AcceptedEncodings Parse(std::string_view accept_encoding) noexcept;
+
+    bool Contains(ContentEncoding encoding) const noexcept {
+        return (bits_ & Bit(encoding)) != 0;
+    }
+
+    // Возвращает предпочтительное кодирование: gzip, затем deflate, иначе IDENTITY
+    ContentEncoding GetPreferred() const noexcept;
+
+private:
+    constexpr static unsigned Bit(ContentEncoding encoding) noexcept {
+        return 1u << static_cast<unsigned>(encoding);
+    }
+
+    // Без сжатия клиент принимает ответ всегда
+    unsigned bits_ = Bit(ContentEncoding::IDENTITY);
+};
+
+// Сжимает data в формате encoding с уровнем сжатия level (1..9).
+// Возвращает std::nullopt, если сжатие не удалось или encoding == IDENTITY
+std::optional<std::string> Compress(std::string_view data, ContentEncoding encoding, int level);
+
+// Сообщает, имеет ли смысл сжимать содержимое с типом content_type.
+// Изображения, архивы и прочие уже сжатые форматы сжимать бесполезно
+bool IsCompressibleType(std::string_view content_type) noexcept;
+
+}  // namespace http_server
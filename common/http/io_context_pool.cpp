@@ -0,0 +1,62 @@
+#include "io_context_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Привязывает текущий поток к ядру cpu. Неудачная привязка не мешает работе сервера,
+// поэтому о ней только сообщаем
+void PinCurrentThread(unsigned cpu) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set)) {
+        std::cerr << "pin thread to cpu "sv << cpu << ": "sv << std::system_category().message(err)
+                  << std::endl;
+    }
+}
+
+}  // namespace
+
+IoContextPool::IoContextPool(unsigned size) {
+    size = std::max(1u, size);
+    contexts_.reserve(size);
+    for (unsigned i = 0; i < size; ++i) {
+        // Контекст обслуживается одним потоком, о чём сообщаем ему подсказкой concurrency_hint
+        contexts_.push_back(std::make_unique<net::io_context>(1));
+    }
+}
+
+void IoContextPool::Run(bool pin_threads) {
+    const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    auto run = [this, pin_threads, num_cpus](size_t index) {
+        if (pin_threads) {
+            PinCurrentThread(static_cast<unsigned>(index % num_cpus));
+        }
+        contexts_[index]->run();
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(contexts_.size() - 1);
+    for (size_t i = 1; i < contexts_.size(); ++i) {
+        workers.emplace_back(run, i);
+    }
+    run(0);
+}
+
+void IoContextPool::Stop() {
+    for (auto& ioc : contexts_) {
+        ioc->stop();
+    }
+}
+
+}  // namespace http_server
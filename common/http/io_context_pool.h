@@ -0,0 +1,46 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+//
+#include <boost/asio/io_context.hpp>
+#include <memory>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+/*
+ * Набор независимых io_context, по одному на поток.
+ * Каждый контекст обслуживается единственным потоком, поэтому сеанс, созданный в контексте,
+ * никогда не переходит на другое ядро, а потоки не конкурируют за общую очередь обработчиков.
+ * Обычно в каждом контексте запускается свой Listener с ListenOptions::reuse_port.
+ */
+class IoContextPool {
+public:
+    explicit IoContextPool(unsigned size);
+
+    IoContextPool(const IoContextPool&) = delete;
+    IoContextPool& operator=(const IoContextPool&) = delete;
+
+    size_t Size() const noexcept {
+        return contexts_.size();
+    }
+
+    net::io_context& Get(size_t index) noexcept {
+        return *contexts_[index];
+    }
+
+    // Запускает каждый контекст в отдельном потоке, включая текущий, и ждёт их завершения.
+    // Если pin_threads == true, i-й поток привязывается к ядру i (по модулю числа ядер)
+    void Run(bool pin_threads);
+
+    // Останавливает все контексты. Может быть вызван из любого потока
+    void Stop();
+
+private:
+    std::vector<std::unique_ptr<net::io_context>> contexts_;
+};
+
+}  // namespace http_server
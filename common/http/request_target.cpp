@@ -0,0 +1,67 @@
+#include "request_target.h"
+
+#include <stdexcept>
+
+namespace http_server {
+
+namespace {
+
+int HexDigitValue(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+}  // namespace
+
+std::string UrlDecode(std::string_view str, bool plus_as_space) {
+    std::string result;
+    // Декодированная строка не длиннее исходной
+    result.reserve(str.size());
+    for (size_t i = 0; i < str.size(); ++i) {
+        const char c = str[i];
+        if (c == '%') {
+            if (i + 2 >= str.size()) {
+                throw std::invalid_argument("Incomplete percent-encoded sequence");
+            }
+            const int hi = HexDigitValue(str[i + 1]);
+            const int lo = HexDigitValue(str[i + 2]);
+            if (hi < 0 || lo < 0) {
+                throw std::invalid_argument("Invalid percent-encoded sequence");
+            }
+            result.push_back(static_cast<char>(hi * 16 + lo));
+            i += 2;
+        } else if (c == '+' && plus_as_space) {
+            result.push_back(' ');
+        } else {
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+std::optional<EncodedView> RequestTarget::FindQueryParam(std::string_view name) const noexcept {
+    std::string_view rest = query_;
+    while (!rest.empty()) {
+        const auto end = std::min(rest.find('&'), rest.size());
+        const auto param = rest.substr(0, end);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+
+        const auto eq_pos = param.find('=');
+        if (param.substr(0, eq_pos) == name) {
+            return EncodedView{eq_pos == std::string_view::npos ? std::string_view{}
+                                                                : param.substr(eq_pos + 1),
+                               true};
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace http_server
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace http_server {
+
+/*
+ * Возвращает URL-декодированное представление строки str.
+ * Если plus_as_space == true, символ + заменяется на пробел (так кодируются параметры запроса).
+ * В случае ошибки выбрасывает исключение std::invalid_argument
+ */
+std::string UrlDecode(std::string_view str, bool plus_as_space = true);
+
+/*
+ * Фрагмент цели запроса в исходном, URL-кодированном виде.
+ * Ссылается на символы запроса и не владеет ими. Декодирование выполняется только тогда,
+ * когда во фрагменте действительно есть %-последовательности (или + в параметрах запроса).
+ */
+class EncodedView {
+public:
+    constexpr explicit EncodedView(std::string_view raw, bool plus_as_space = false) noexcept
+        : raw_{raw}
+        , plus_as_space_{plus_as_space} {
+    }
+
+    constexpr std::string_view Raw() const noexcept {
+        return raw_;
+    }
+
+    // Сообщает, отличается ли декодированное значение от исходного
+    bool NeedsDecoding() const noexcept {
+        return raw_.find_first_of(plus_as_space_ ? "%+" : "%") != std::string_view::npos;
+    }
+
+    // Возвращает декодированное значение. Если декодировать нечего, возвращает исходный
+    // фрагмент без копирования, иначе декодирует его в storage.
+    // В случае ошибки декодирования выбрасывает исключение std::invalid_argument
+    std::string_view Decode(std::string& storage) const {
+        if (!NeedsDecoding()) {
+            return raw_;
+        }
+        storage = UrlDecode(raw_, plus_as_space_);
+        return storage;
+    }
+
+private:
+    std::string_view raw_;
+    bool plus_as_space_;
+};
+
+/*
+ * Разбирает цель HTTP-запроса (req.target()) на путь и строку запроса.
+ * Все части являются срезами исходной строки, поэтому разбор не выделяет память.
+ */
+class RequestTarget {
+public:
+    // Последовательный обход сегментов пути: "/a/b" -> "a", "b"
+    class Segments {
+    public:
+        constexpr explicit Segments(std::string_view path) noexcept
+            : rest_{path} {
+        }
+
+        // Извлекает очередной сегмент. Возвращает std::nullopt, если сегменты закончились
+        std::optional<EncodedView> Next() noexcept {
+            if (rest_.empty() || rest_.front() != '/') {
+                return std::nullopt;
+            }
+            rest_.remove_prefix(1);
+            const auto end = std::min(rest_.find('/'), rest_.size());
+            const EncodedView segment{rest_.substr(0, end)};
+            rest_.remove_prefix(end);
+            return segment;
+        }
+
+    private:
+        std::string_view rest_;
+    };
+
+    constexpr explicit RequestTarget(std::string_view target) noexcept {
+        const auto query_pos = target.find('?');
+        path_ = target.substr(0, query_pos);
+        if (query_pos != std::string_view::npos) {
+            query_ = target.substr(query_pos + 1);
+        }
+    }
+
+    // Путь в исходном виде, без строки запроса
+    constexpr std::string_view Path() const noexcept {
+        return path_;
+    }
+
+    // Строка запроса (после ?) в исходном виде
+    constexpr std::string_view Query() const noexcept {
+        return query_;
+    }
+
+    Segments GetSegments() const noexcept {
+        return Segments{path_};
+    }
+
+    // Ищет параметр запроса name. Имя сравнивается в исходном виде
+    std::optional<EncodedView> FindQueryParam(std::string_view name) const noexcept;
+
+private:
+    std::string_view path_;
+    std::string_view query_;
+};
+
+}  // namespace http_server
@@ -0,0 +1,139 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+namespace http_server {
+
+TimerWheel::TimerWheel(net::io_context& ioc, Clock::duration tick)
+    : timer_{ioc}
+    , tick_{std::max(tick, Clock::duration{1})}
+    , start_time_{Clock::now()} {
+}
+
+void TimerWheel::Start() {
+    ScheduleTick();
+}
+
+void TimerWheel::Add(const std::shared_ptr<Entry>& entry) {
+    if (entry->scheduled_.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    const auto expiry = entry->expiry_.load(std::memory_order_relaxed);
+    std::lock_guard lk{mutex_};
+    Insert(entry, expiry);
+}
+
+void TimerWheel::NotifyAll() {
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        std::lock_guard lk{mutex_};
+        for (auto& level : levels_) {
+            for (auto& slot : level) {
+                for (const auto& weak_entry : slot) {
+                    if (auto entry = weak_entry.lock()) {
+                        entries.push_back(std::move(entry));
+                    }
+                }
+                slot.clear();
+            }
+        }
+    }
+    for (const auto& entry : entries) {
+        entry->scheduled_.store(false, std::memory_order_relaxed);
+        entry->OnExpired();
+    }
+}
+
+void TimerWheel::ScheduleTick() {
+    std::uint64_t next_tick;
+    {
+        std::lock_guard lk{mutex_};
+        next_tick = current_tick_ + 1;
+    }
+    // Момент срабатывания отсчитываем от начала работы колеса, чтобы задержки
+    // обработчиков не накапливались
+    timer_.expires_at(start_time_ + tick_ * next_tick);
+    timer_.async_wait([self = shared_from_this()](const boost::system::error_code& ec) {
+        if (!ec) {
+            self->OnTick();
+        }
+    });
+}
+
+void TimerWheel::OnTick() {
+    const auto now = Clock::now();
+    std::vector<std::shared_ptr<Entry>> expired;
+    {
+        std::lock_guard lk{mutex_};
+        // Если обработчик запоздал, проходим все пропущенные тики
+        while (start_time_ + tick_ * (current_tick_ + 1) <= now) {
+            Advance(now, expired);
+        }
+    }
+    // Обработчики срока вызываем без мьютекса: они могут снова добавить элемент в колесо
+    for (const auto& entry : expired) {
+        entry->scheduled_.store(false, std::memory_order_relaxed);
+        entry->OnExpired();
+    }
+    ScheduleTick();
+}
+
+void TimerWheel::Advance(Clock::time_point now, std::vector<std::shared_ptr<Entry>>& expired) {
+    ++current_tick_;
+
+    // Когда младший уровень делает полный оборот, элементы очередной ячейки старшего уровня
+    // распределяются по младшим уровням
+    for (size_t level = 1; level < LEVEL_COUNT; ++level) {
+        if (((current_tick_ >> ((level - 1) * SLOT_BITS)) & SLOT_MASK) != 0) {
+            break;
+        }
+        Slot cascade;
+        cascade.swap(levels_[level][(current_tick_ >> (level * SLOT_BITS)) & SLOT_MASK]);
+        for (auto& weak_entry : cascade) {
+            if (const auto entry = weak_entry.lock()) {
+                Insert(std::move(weak_entry), entry->expiry_.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    Slot due;
+    due.swap(levels_[0][current_tick_ & SLOT_MASK]);
+    for (auto& weak_entry : due) {
+        const auto entry = weak_entry.lock();
+        if (!entry) {
+            // Соединение уже закрыто
+            continue;
+        }
+        if (entry->IsExpired(now)) {
+            expired.push_back(entry);
+        } else {
+            // Срок был продлён после добавления в колесо
+            Insert(std::move(weak_entry), entry->expiry_.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void TimerWheel::Insert(std::weak_ptr<Entry> entry, Clock::rep expiry) {
+    constexpr std::uint64_t MAX_DELAY = (std::uint64_t{1} << (LEVEL_COUNT * SLOT_BITS)) - 1;
+
+    // Номер тика, к концу которого наступает срок, с округлением вверх
+    std::uint64_t delay = MAX_DELAY;
+    const auto since_start = expiry - start_time_.time_since_epoch().count();
+    if (since_start <= 0) {
+        delay = 1;
+    } else if (expiry != Entry::NEVER) {
+        const auto tick = static_cast<std::uint64_t>(tick_.count());
+        const auto due_tick = (static_cast<std::uint64_t>(since_start) + tick - 1) / tick;
+        delay = std::clamp<std::uint64_t>(due_tick > current_tick_ ? due_tick - current_tick_ : 1,
+                                          1, MAX_DELAY);
+    }
+
+    size_t level = 0;
+    while (level + 1 < LEVEL_COUNT && delay >= (std::uint64_t{1} << ((level + 1) * SLOT_BITS))) {
+        ++level;
+    }
+    const auto due_tick = current_tick_ + delay;
+    levels_[level][(due_tick >> (level * SLOT_BITS)) & SLOT_MASK].push_back(std::move(entry));
+}
+
+}  // namespace http_server
@@ -0,0 +1,120 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+//
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+/*
+ * Иерархическое колесо таймеров для сроков бездействия соединений.
+ * Вместо отдельного steady_timer на каждый сокет колесо использует один таймер на io_context
+ * и раз в тик проверяет только элементы текущей ячейки. Добавление элемента и проверка
+ * ячейки выполняются за O(1) независимо от количества соединений.
+ * Продление срока не затрагивает колесо: элемент лишь меняет атомарное значение срока,
+ * а колесо, обнаружив при проверке, что срок отодвинулся, переносит элемент в нужную ячейку.
+ */
+class TimerWheel : public std::enable_shared_from_this<TimerWheel> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Элемент колеса. Время жизни элемента управляется shared_ptr, колесо хранит weak_ptr
+    class Entry {
+    public:
+        // Устанавливает срок, отсчитывая его от текущего момента.
+        // Может быть вызван из любого потока
+        void ExpiresAfter(Clock::duration timeout) noexcept {
+            expiry_.store((Clock::now() + timeout).time_since_epoch().count(),
+                          std::memory_order_relaxed);
+        }
+
+        // Отменяет срок
+        void ExpiresNever() noexcept {
+            expiry_.store(NEVER, std::memory_order_relaxed);
+        }
+
+        // Сообщает, наступил ли срок к моменту now
+        bool IsExpired(Clock::time_point now) const noexcept {
+            return expiry_.load(std::memory_order_relaxed) <= now.time_since_epoch().count();
+        }
+
+    protected:
+        Entry() = default;
+        ~Entry() = default;
+
+    private:
+        friend class TimerWheel;
+
+        constexpr static Clock::rep NEVER = std::numeric_limits<Clock::rep>::max();
+
+        // Вызывается колесом из потока io_context после наступления срока.
+        // Элемент к этому моменту удалён из колеса; чтобы снова следить за сроком,
+        // его нужно добавить заново
+        virtual void OnExpired() = 0;
+
+        std::atomic<Clock::rep> expiry_{NEVER};
+        // Находится ли элемент в колесе
+        std::atomic<bool> scheduled_{false};
+    };
+
+    // Колесо начинает работу после вызова Start
+    explicit TimerWheel(net::io_context& ioc, Clock::duration tick = DEFAULT_TICK);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void Start();
+
+    // Начинает следить за сроком элемента, если колесо ещё не следит за ним.
+    // Может быть вызван из любого потока
+    void Add(const std::shared_ptr<Entry>& entry);
+
+    // Досрочно вызывает OnExpired у всех элементов колеса и удаляет их из колеса.
+    // Срок элементов не меняется: обработчик сам проверяет его при помощи IsExpired.
+    // Позволяет разбудить все соединения, например при плавной остановке сервера
+    void NotifyAll();
+
+    constexpr static Clock::duration DEFAULT_TICK = std::chrono::milliseconds{250};
+
+private:
+    constexpr static size_t SLOT_BITS = 6;
+    constexpr static size_t SLOTS_PER_LEVEL = size_t{1} << SLOT_BITS;
+    constexpr static size_t SLOT_MASK = SLOTS_PER_LEVEL - 1;
+    // С тиком 250 мс четыре уровня покрывают больше 48 суток. Более далёкие
+    // и бесконечные сроки попадают на последний уровень и проверяются заново
+    constexpr static size_t LEVEL_COUNT = 4;
+
+    using Slot = std::vector<std::weak_ptr<Entry>>;
+    using Level = std::array<Slot, SLOTS_PER_LEVEL>;
+
+    void ScheduleTick();
+    void OnTick();
+    // Продвигает колесо на один тик, собирая в expired элементы с наступившим сроком.
+    // Вызывается под мьютексом
+    void Advance(Clock::time_point now, std::vector<std::shared_ptr<Entry>>& expired);
+    // Помещает элемент в ячейку, соответствующую сроку. Вызывается под мьютексом
+    void Insert(std::weak_ptr<Entry> entry, Clock::rep expiry);
+
+    net::steady_timer timer_;
+    Clock::duration tick_;
+
+    std::mutex mutex_;
+    std::array<Level, LEVEL_COUNT> levels_;
+    // Тик с номером n заканчивается в момент start_time_ + n * tick_
+    Clock::time_point start_time_;
+    std::uint64_t current_tick_ = 0;
+};
+
+}  // namespace http_server
@@ -0,0 +1,120 @@
+#pragma once
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace postgres {
+
+// Выбрасывается, когда за отведённое время не освободилось ни одно соединение
+class ConnectionPoolTimeout : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/*
+Потокобезопасный пул соединений фиксированного размера.
+Соединение выдаётся на время одной единицы работы и возвращается в пул деструктором
+ConnectionWrapper. Если свободных соединений нет, GetConnection ждёт не дольше wait_timeout.
+Перед выдачей соединение проверяется, и закрытое (например, после обрыва связи с сервером)
+пересоздаётся фабрикой
+*/
+template <typename Connection>
+class BasicConnectionPool {
+public:
+    using ConnectionPtr = std::unique_ptr<Connection>;
+    using ConnectionFactory = std::function<ConnectionPtr()>;
+
+    class ConnectionWrapper {
+    public:
+        ConnectionWrapper(ConnectionPtr&& connection, BasicConnectionPool& pool) noexcept
+            : connection_{std::move(connection)}
+            , pool_{&pool} {
+        }
+
+        ConnectionWrapper(const ConnectionWrapper&) = delete;
+        ConnectionWrapper& operator=(const ConnectionWrapper&) = delete;
+
+        // Присваивание не поддерживается: прежнее соединение пришлось бы вернуть в пул молча
+        ConnectionWrapper(ConnectionWrapper&&) = default;
+        ConnectionWrapper& operator=(ConnectionWrapper&&) = delete;
+
+        Connection& operator*() const& noexcept {
+            return *connection_;
+        }
+        Connection& operator*() const&& = delete;
+
+        Connection* operator->() const& noexcept {
+            return connection_.get();
+        }
+
+        ~ConnectionWrapper() {
+            if (connection_) {
+                pool_->ReturnConnection(std::move(connection_));
+            }
+        }
+
+    private:
+        ConnectionPtr connection_;
+        BasicConnectionPool* pool_;
+    };
+
+    BasicConnectionPool(size_t capacity, ConnectionFactory factory, std::chrono::milliseconds wait_timeout)
+        : factory_{std::move(factory)}
+        , wait_timeout_{wait_timeout} {
+        if (capacity == 0) {
+            throw std::invalid_argument("Connection pool capacity must be positive");
+        }
+        // Соединения открываются сразу, чтобы ошибка в настройках базы обнаружилась при запуске
+        pool_.reserve(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            pool_.emplace_back(factory_());
+        }
+    }
+
+    ConnectionWrapper GetConnection() {
+        std::unique_lock lock{mutex_};
+        if (!cond_var_.wait_for(lock, wait_timeout_, [this] {
+                return !pool_.empty();
+            })) {
+            throw ConnectionPoolTimeout("No free database connection");
+        }
+        ConnectionPtr connection = std::move(pool_.back());
+        pool_.pop_back();
+        lock.unlock();
+
+        if (!connection || !connection->is_open()) {
+            try {
+                connection = factory_();
+            } catch (...) {
+                // Место в пуле не теряется: следующий GetConnection снова попробует подключиться
+                ReturnConnection(nullptr);
+                throw;
+            }
+        }
+        return ConnectionWrapper{std::move(connection), *this};
+    }
+
+private:
+    void ReturnConnection(ConnectionPtr&& connection) {
+        {
+            std::lock_guard lock{mutex_};
+            assert(pool_.size() < pool_.capacity());
+            pool_.emplace_back(std::move(connection));
+        }
+        cond_var_.notify_one();
+    }
+
+    ConnectionFactory factory_;
+    std::chrono::milliseconds wait_timeout_;
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    // Свободные соединения. nullptr обозначает место, соединение для которого не удалось открыть
+    std::vector<ConnectionPtr> pool_;
+};
+
+}  // namespace postgres
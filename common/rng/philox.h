@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace rng {
+
+/*
+ * Блочная функция Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+ * Превращает 128-битный счётчик и 64-битный ключ в 128 случайных бит. Разные счётчики при одном
+ * ключе дают независимые блоки, поэтому генератору не нужно хранить состояние, кроме счётчика
+ */
+class Philox4x32 {
+public:
+    using Counter = std::array<std::uint32_t, 4>;
+    using Key = std::array<std::uint32_t, 2>;
+
+    static constexpr Counter Generate(Counter counter, Key key) noexcept {
+        for (int round = 0; round < ROUNDS; ++round) {
+            if (round > 0) {
+                key[0] += WEYL_0;
+                key[1] += WEYL_1;
+            }
+            const std::uint64_t product_0 = std::uint64_t{MULTIPLIER_0} * counter[0];
+            const std::uint64_t product_1 = std::uint64_t{MULTIPLIER_1} * counter[2];
+            counter = {static_cast<std::uint32_t>(product_1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<std::uint32_t>(product_1),
+                       static_cast<std::uint32_t>(product_0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<std::uint32_t>(product_0)};
+        }
+        return counter;
+    }
+
+private:
+    constexpr static int ROUNDS = 10;
+    constexpr static std::uint32_t MULTIPLIER_0 = 0xD2511F53;
+    constexpr static std::uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+    constexpr static std::uint32_t WEYL_0 = 0x9E3779B9;
+    constexpr static std::uint32_t WEYL_1 = 0xBB67AE85;
+};
+
+/*
+ * Поток случайных чисел, заданный ключом key (например, номером сеанса) и номером stream
+ * внутри него (например, номером тика). Числа потока - блоки Philox4x32 со счётчиком
+ * (номер блока, stream), поэтому потоки с разными ключами или номерами независимы, создание
+ * потока ничего не стоит, а повтор с теми же key и stream даёт те же числа в любом потоке
+ * выполнения и при любом порядке обработки сеансов. Общее состояние генератора и блокировки
+ * не нужны.
+ *
+ * Удовлетворяет требованиям UniformRandomBitGenerator и годится для распределений <random>.
+ * Числа с плавающей точкой можно получать последовательно (NextDouble) или вычислять по номеру
+ * (GetDouble, Fill): i-е число собрано из 53 бит блока i / 2
+ */
+class PhiloxStream {
+public:
+    using result_type = std::uint32_t;
+
+    explicit constexpr PhiloxStream(std::uint64_t key, std::uint64_t stream = 0) noexcept
+        : key_{static_cast<std::uint32_t>(key), static_cast<std::uint32_t>(key >> 32)}
+        , stream_{stream} {
+    }
+
+    static constexpr result_type min() noexcept {
+        return 0;
+    }
+
+    static constexpr result_type max() noexcept {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() noexcept {
+        if (word_ == WORDS_PER_BLOCK) {
+            block_ = GetBlock(next_block_++);
+            word_ = 0;
+        }
+        return block_[word_++];
+    }
+
+    // Очередное число из [0, 1). Расходует 64 бита потока
+    constexpr double NextDouble() noexcept {
+        const std::uint32_t low = (*this)();
+        const std::uint32_t high = (*this)();
+        return ToDouble(low, high);
+    }
+
+    // Число из [0, 1) с номером index. Не зависит от последовательных вызовов
+    constexpr double GetDouble(std::uint64_t index) const noexcept {
+        const auto block = GetBlock(index / 2);
+        const size_t word = index % 2 * 2;
+        return ToDouble(block[word], block[word + 1]);
+    }
+
+    // Заполняет out числами из [0, 1) с номерами first, first + 1, ... Части массива можно
+    // заполнять из разных потоков выполнения, получая тот же результат, что и одним вызовом
+    constexpr void Fill(std::span<double> out, std::uint64_t first = 0) const noexcept {
+        size_t i = 0;
+        if (first % 2 != 0 && !out.empty()) {
+            out[i++] = GetDouble(first);
+        }
+        for (std::uint64_t block_index = (first + i) / 2; i + 1 < out.size(); i += 2, ++block_index) {
+            const auto block = GetBlock(block_index);
+            out[i] = ToDouble(block[0], block[1]);
+            out[i + 1] = ToDouble(block[2], block[3]);
+        }
+        if (i < out.size()) {
+            out[i] = GetDouble(first + i);
+        }
+    }
+
+private:
+    constexpr static size_t WORDS_PER_BLOCK = 4;
+
+    constexpr Philox4x32::Counter GetBlock(std::uint64_t index) const noexcept {
+        return Philox4x32::Generate({static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32),
+                                     static_cast<std::uint32_t>(stream_),
+                                     static_cast<std::uint32_t>(stream_ >> 32)},
+                                    key_);
+    }
+
+    // Старшие 53 бита из двух слов - вся точность мантиссы double
+    static constexpr double ToDouble(std::uint32_t low, std::uint32_t high) noexcept {
+        const std::uint64_t bits = (std::uint64_t{high} << 32 | low) >> 11;
+        return static_cast<double>(bits) * (1.0 / static_cast<double>(std::uint64_t{1} << 53));
+    }
+
+    Philox4x32::Key key_;
+    std::uint64_t stream_;
+    // Последовательный доступ: текущий блок и номер следующего
+    std::uint64_t next_block_ = 0;
+    Philox4x32::Counter block_{};
+    size_t word_ = WORDS_PER_BLOCK;
+};
+
+}  // namespace rng
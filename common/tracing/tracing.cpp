@@ -0,0 +1,352 @@
+#include "tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace tracing {
+
+using namespace std::literals;
+
+namespace {
+
+// Состояние генератора идентификаторов. Свой генератор у каждого потока
+// не требует синхронизации
+thread_local std::uint64_t id_state = [] {
+    std::random_device device;
+    return (std::uint64_t{device()} << 32) ^ device();
+}();
+
+thread_local SpanContext current_context;
+
+// Записывает value шестнадцатеричным числом из 16 цифр
+void AppendHex(std::string& out, std::uint64_t value) {
+    std::array<char, 16> digits;
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+        *it = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    }
+    out.append(digits.data(), digits.size());
+}
+
+// Разбирает ровно text.size() шестнадцатеричных цифр в нижнем регистре
+std::optional<std::uint64_t> ParseHex(std::string_view text) noexcept {
+    std::uint64_t value = 0;
+    for (const char c : text) {
+        if (c >= '0' && c <= '9') {
+            value = value << 4 | static_cast<std::uint64_t>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value = value << 4 | static_cast<std::uint64_t>(c - 'a' + 10);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return value;
+}
+
+// Записывает наносекунды ns микросекундами с дробной частью
+void WriteMicroseconds(std::ostream& out, std::int64_t ns) {
+    out << ns / 1000 << '.';
+    const auto fraction = ns % 1000;
+    out << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + fraction / 10 % 10)
+        << static_cast<char>('0' + fraction % 10);
+}
+
+// Записывает строку JSON. Имена интервалов и сервиса не содержат управляющих символов,
+// поэтому экранируются только кавычки и обратная косая черта
+void WriteJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+}  // namespace
+
+Tracer::Tracer()
+    : unix_offset_ns_{std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count()
+                      - ToNanoseconds(Clock::now())} {
+}
+
+Tracer& Tracer::Instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::SetSampleRate(double rate) noexcept {
+    rate = std::clamp(rate, 0.0, 1.0);
+    // Порог выборки - доля rate от диапазона младшей половины trace_id
+    const auto threshold = rate >= 1.0 ? std::numeric_limits<std::uint64_t>::max()
+                                       : static_cast<std::uint64_t>(std::ldexp(rate, 64));
+    sample_threshold_.store(threshold, std::memory_order_relaxed);
+}
+
+SpanContext Tracer::StartTrace() noexcept {
+    const auto threshold = sample_threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) {
+        return {};
+    }
+    const auto low = NewId();
+    if (low > threshold) {
+        return {};
+    }
+    return {NewId(), low, 0};
+}
+
+void Tracer::Record(const SpanRecord& span) noexcept {
+    try {
+        auto& local = GetLocal();
+        std::lock_guard lk{local.mutex};
+        if (local.spans.size() >= MAX_BUFFERED_SPANS) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        local.spans.push_back(span);
+        local.spans.back().thread_id = local.thread_id;
+    } catch (const std::exception&) {
+        // Нехватка памяти не должна прерывать обработку, ради которой ведётся трассировка
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::vector<SpanRecord> Tracer::Drain() {
+    std::vector<SpanRecord> spans;
+    std::lock_guard lk{mutex_};
+    for (const auto& buffer : threads_) {
+        std::vector<SpanRecord> local;
+        {
+            std::lock_guard local_lk{buffer->mutex};
+            local.swap(buffer->spans);
+        }
+        spans.insert(spans.end(), local.begin(), local.end());
+    }
+    return spans;
+}
+
+std::uint64_t Tracer::NewId() noexcept {
+    // splitmix64: быстрый генератор с хорошим перемешиванием, достаточный для идентификаторов
+    std::uint64_t id;
+    do {
+        id = id_state += 0x9e3779b97f4a7c15;
+        id = (id ^ (id >> 30)) * 0xbf58476d1ce4e5b9;
+        id = (id ^ (id >> 27)) * 0x94d049bb133111eb;
+        id ^= id >> 31;
+    } while (id == 0);
+    return id;
+}
+
+Tracer::ThreadBuffer& Tracer::GetLocal() {
+    thread_local ThreadBuffer* local = nullptr;
+    if (!local) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        std::lock_guard lk{mutex_};
+        buffer->thread_id = static_cast<std::uint32_t>(threads_.size() + 1);
+        local = buffer.get();
+        threads_.push_back(std::move(buffer));
+    }
+    return *local;
+}
+
+std::int64_t ToNanoseconds(Clock::time_point time) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+Span::Span(const char* name, const SpanContext& parent, Clock::time_point start) noexcept {
+    if (!parent.IsSampled()) {
+        return;
+    }
+    record_.context = {parent.trace_id_high, parent.trace_id_low, Tracer::NewId()};
+    record_.parent_id = parent.span_id;
+    record_.name = name;
+    record_.start_ns = ToNanoseconds(start);
+    active_ = true;
+}
+
+Span Span::StartRoot(const char* name, const std::optional<SpanContext>& remote,
+                     Clock::time_point start) noexcept {
+    return {name, remote ? *remote : Tracer::Instance().StartTrace(), start};
+}
+
+void Span::End(Clock::time_point end) noexcept {
+    if (!std::exchange(active_, false)) {
+        return;
+    }
+    record_.end_ns = ToNanoseconds(end);
+    Tracer::Instance().Record(record_);
+}
+
+const SpanContext& GetCurrentContext() noexcept {
+    return current_context;
+}
+
+Span StartSpan(const char* name) noexcept {
+    const auto& context = GetCurrentContext();
+    return context.IsSampled() ? Span{name, context} : Span::StartRoot(name);
+}
+
+ContextScope::ContextScope(const SpanContext& context) noexcept
+    : previous_{std::exchange(current_context, context)} {
+}
+
+ContextScope::~ContextScope() {
+    current_context = previous_;
+}
+
+std::optional<SpanContext> ParseTraceParent(std::string_view header) noexcept {
+    // version "-" trace-id "-" parent-id "-" trace-flags: 00-<32 hex>-<16 hex>-<2 hex>
+    constexpr size_t SIZE = 2 + 1 + 32 + 1 + 16 + 1 + 2;
+    if (header.size() != SIZE || header.substr(0, 3) != "00-"sv || header[35] != '-'
+        || header[52] != '-') {
+        return std::nullopt;
+    }
+    const auto high = ParseHex(header.substr(3, 16));
+    const auto low = ParseHex(header.substr(19, 16));
+    const auto parent = ParseHex(header.substr(36, 16));
+    const auto flags = ParseHex(header.substr(53, 2));
+    if (!high || !low || !parent || !flags || (*high == 0 && *low == 0) || *parent == 0) {
+        return std::nullopt;
+    }
+    if ((*flags & 1) == 0) {
+        // Отправитель не записывает трассу, поэтому её не записываем и мы
+        return SpanContext{};
+    }
+    return SpanContext{*high, *low, *parent};
+}
+
+std::string FormatTraceParent(const SpanContext& context) {
+    std::string header = "00-";
+    AppendHex(header, context.trace_id_high);
+    AppendHex(header, context.trace_id_low);
+    header += '-';
+    AppendHex(header, context.span_id);
+    header += context.IsSampled() ? "-01"sv : "-00"sv;
+    return header;
+}
+
+void WriteChromeEvents(std::ostream& out, std::span<const SpanRecord> spans, bool first) {
+    std::string id;
+    for (const auto& span : spans) {
+        if (!std::exchange(first, false)) {
+            out << ",\n"sv;
+        }
+        // Полные события ("X") с идентификаторами трассы и интервалов в аргументах
+        out << "{\"ph\":\"X\",\"pid\":1,\"tid\":"sv << span.thread_id << ",\"name\":"sv;
+        WriteJsonString(out, span.name);
+        out << ",\"ts\":"sv;
+        WriteMicroseconds(out, span.start_ns);
+        out << ",\"dur\":"sv;
+        WriteMicroseconds(out, span.end_ns - span.start_ns);
+        id.clear();
+        AppendHex(id, span.context.trace_id_high);
+        AppendHex(id, span.context.trace_id_low);
+        out << ",\"args\":{\"trace_id\":\""sv << id;
+        id.clear();
+        AppendHex(id, span.context.span_id);
+        out << "\",\"span_id\":\""sv << id;
+        id.clear();
+        AppendHex(id, span.parent_id);
+        out << "\",\"parent_id\":\""sv << id << "\"}}"sv;
+    }
+}
+
+void WriteOtlpBatch(std::ostream& out, std::span<const SpanRecord> spans, std::string_view service_name,
+                    std::int64_t unix_offset_ns) {
+    out << "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":"
+           "{\"stringValue\":"sv;
+    WriteJsonString(out, service_name);
+    out << "}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"tracing\"},\"spans\":["sv;
+    std::string id;
+    bool first = true;
+    for (const auto& span : spans) {
+        if (!std::exchange(first, false)) {
+            out << ',';
+        }
+        id.clear();
+        AppendHex(id, span.context.trace_id_high);
+        AppendHex(id, span.context.trace_id_low);
+        out << "{\"traceId\":\""sv << id;
+        id.clear();
+        AppendHex(id, span.context.span_id);
+        out << "\",\"spanId\":\""sv << id << '"';
+        if (span.parent_id != 0) {
+            id.clear();
+            AppendHex(id, span.parent_id);
+            out << ",\"parentSpanId\":\""sv << id << '"';
+        }
+        out << ",\"name\":"sv;
+        WriteJsonString(out, span.name);
+        // Моменты в OTLP/JSON - строки с наносекундами времени Unix
+        out << ",\"kind\":1,\"startTimeUnixNano\":\""sv << span.start_ns + unix_offset_ns
+            << "\",\"endTimeUnixNano\":\""sv << span.end_ns + unix_offset_ns << "\"}"sv;
+    }
+    out << "]}]}]}\n"sv;
+}
+
+TraceExporter::TraceExporter(std::filesystem::path path, ExportFormat format,
+                             std::string service_name, std::chrono::milliseconds interval,
+                             Tracer& tracer)
+    : tracer_{tracer}
+    , format_{format}
+    , service_name_{std::move(service_name)}
+    , interval_{interval}
+    , out_{path, std::ios::out | std::ios::trunc} {
+    if (!out_) {
+        throw std::runtime_error("Failed to open trace file "s + path.string());
+    }
+    if (format_ == ExportFormat::CHROME) {
+        // Закрывающая скобка массива необязательна, поэтому файл можно открыть, пока сервер работает
+        out_ << "[\n"sv;
+    }
+    worker_ = std::jthread{[this](std::stop_token stop) {
+        Run(stop);
+    }};
+}
+
+TraceExporter::~TraceExporter() {
+    worker_.request_stop();
+    worker_.join();
+    std::lock_guard lk{mutex_};
+    Export();
+    if (format_ == ExportFormat::CHROME) {
+        out_ << "\n]\n"sv;
+    }
+}
+
+void TraceExporter::Flush() {
+    std::lock_guard lk{mutex_};
+    Export();
+}
+
+void TraceExporter::Run(std::stop_token stop) {
+    std::unique_lock lk{mutex_};
+    while (!stop.stop_requested()) {
+        cv_.wait_for(lk, stop, interval_, [] {
+            return false;
+        });
+        Export();
+    }
+}
+
+void TraceExporter::Export() {
+    const auto spans = tracer_.Drain();
+    if (spans.empty()) {
+        return;
+    }
+    if (format_ == ExportFormat::CHROME) {
+        WriteChromeEvents(out_, spans, std::exchange(first_, false));
+    } else {
+        WriteOtlpBatch(out_, spans, service_name_, tracer_.GetUnixOffset());
+    }
+    out_.flush();
+}
+
+}  // namespace tracing
@@ -0,0 +1,317 @@
+#pragma once
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tracing {
+
+using Clock = std::chrono::steady_clock;
+
+// Контекст трассировки: трасса и интервал, к которым относится выполняемая работа.
+// Нулевой trace_id означает, что трасса не попала в выборку и не записывается
+struct SpanContext {
+    std::uint64_t trace_id_high = 0;
+    std::uint64_t trace_id_low = 0;
+    std::uint64_t span_id = 0;
+
+    bool IsSampled() const noexcept {
+        return trace_id_high != 0 || trace_id_low != 0;
+    }
+};
+
+// Завершённый интервал. Моменты начала и конца - наносекунды по Clock
+struct SpanRecord {
+    SpanContext context;
+    std::uint64_t parent_id = 0;
+    // Имя - строковый литерал, поэтому запись не выделяет под него память
+    const char* name = "";
+    std::int64_t start_ns = 0;
+    std::int64_t end_ns = 0;
+    // Порядковый номер потока, завершившего интервал
+    std::uint32_t thread_id = 0;
+};
+
+/*
+ * Сборщик интервалов трассировки.
+ * Каждый поток складывает завершённые интервалы в собственный буфер, поэтому запись
+ * не конкурирует с другими потоками: мьютекс буфера захватывает только Drain, забирающий
+ * интервалы пачкой. Глобальный мьютекс захватывается при первой записи из нового потока.
+ * Если буфер потока переполнен, интервалы отбрасываются и учитываются в GetDroppedCount.
+ * Интервалы трасс, не попавших в выборку, не создаются вовсе
+ */
+class Tracer {
+public:
+    // Сколько интервалов поток хранит до очередного Drain
+    constexpr static size_t MAX_BUFFERED_SPANS = 64 * 1024;
+
+    static Tracer& Instance();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Доля новых трасс, попадающих в выборку, от 0 до 1. По умолчанию трассы не записываются
+    void SetSampleRate(double rate) noexcept;
+
+    // Начинает новую трассу. Трасса попадает в выборку, если младшая половина её
+    // случайного trace_id меньше доли выборки, как в TraceIdRatioBased у OpenTelemetry.
+    // Возвращает контекст без интервала: он становится родителем корневого интервала
+    SpanContext StartTrace() noexcept;
+
+    void Record(const SpanRecord& span) noexcept;
+
+    // Забирает завершённые интервалы всех потоков
+    std::vector<SpanRecord> Drain();
+
+    std::uint64_t GetDroppedCount() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Разность часов system_clock и Clock в наносекундах, измеренная при создании сборщика.
+    // Переводит моменты интервалов во время Unix
+    std::int64_t GetUnixOffset() const noexcept {
+        return unix_offset_ns_;
+    }
+
+    // Случайный ненулевой идентификатор трассы или интервала
+    static std::uint64_t NewId() noexcept;
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<SpanRecord> spans;
+        std::uint32_t thread_id = 0;
+    };
+
+    Tracer();
+
+    ThreadBuffer& GetLocal();
+
+    std::atomic<std::uint64_t> sample_threshold_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::int64_t unix_offset_ns_;
+
+    std::mutex mutex_;
+    // Буферы завершившихся потоков сохраняются, чтобы не терять их интервалы
+    std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+};
+
+std::int64_t ToNanoseconds(Clock::time_point time) noexcept;
+
+/*
+ * Интервал трассы. Записывается в Tracer при вызове End или разрушении.
+ * Интервал трассы, не попавшей в выборку, ничего не записывает и не обращается к часам
+ * при завершении, поэтому отключённая трассировка почти ничего не стоит
+ */
+class Span {
+public:
+    // Пустой интервал, который ничего не записывает
+    Span() = default;
+
+    // Начинает интервал name, дочерний к parent. Имя должно быть строковым литералом
+    Span(const char* name, const SpanContext& parent, Clock::time_point start = Clock::now()) noexcept;
+
+    // Начинает корневой интервал запроса. Если удалённый участник передал контекст remote
+    // (см. ParseTraceParent), интервал продолжает его трассу и следует его решению о выборке.
+    // Иначе начинается новая трасса
+    static Span StartRoot(const char* name, const std::optional<SpanContext>& remote = std::nullopt,
+                          Clock::time_point start = Clock::now()) noexcept;
+
+    Span(Span&& other) noexcept
+        : record_{other.record_}
+        , active_{std::exchange(other.active_, false)} {
+    }
+
+    Span& operator=(Span&& other) noexcept {
+        if (this != &other) {
+            End();
+            record_ = other.record_;
+            active_ = std::exchange(other.active_, false);
+        }
+        return *this;
+    }
+
+    ~Span() {
+        End();
+    }
+
+    // Контекст для дочерних интервалов. У незаписываемого интервала trace_id нулевой
+    SpanContext GetContext() const noexcept {
+        return active_ ? record_.context : SpanContext{};
+    }
+
+    bool IsRecording() const noexcept {
+        return active_;
+    }
+
+    // Завершает интервал в момент end. Повторные вызовы ничего не делают
+    void End() noexcept {
+        if (active_) {
+            End(Clock::now());
+        }
+    }
+    void End(Clock::time_point end) noexcept;
+
+private:
+    SpanRecord record_;
+    bool active_ = false;
+};
+
+// Контекст трассировки, в котором выполняется текущий поток
+const SpanContext& GetCurrentContext() noexcept;
+
+// Начинает интервал name, дочерний к текущему контексту потока. Если поток выполняется
+// вне трассы, начинает новую трассу, например для работы фонового потока
+Span StartSpan(const char* name) noexcept;
+
+// Делает context текущим контекстом потока на время своего существования
+class ContextScope {
+public:
+    explicit ContextScope(const SpanContext& context) noexcept;
+    ~ContextScope();
+
+    ContextScope(const ContextScope&) = delete;
+    ContextScope& operator=(const ContextScope&) = delete;
+
+private:
+    SpanContext previous_;
+};
+
+/*
+ * Обработчик asio, выполняющийся в заданном контексте трассировки.
+ * Связанные исполнитель и аллокатор берутся у исходного обработчика, поэтому обёртка
+ * не меняет, в каком strand и с какой памятью он выполняется
+ */
+template <typename Handler>
+class ContextBoundHandler {
+public:
+    ContextBoundHandler(Handler handler, const SpanContext& context)
+        : handler_(std::move(handler))
+        , context_(context) {
+    }
+
+    template <typename... Args>
+    decltype(auto) operator()(Args&&... args) {
+        ContextScope scope{context_};
+        return handler_(std::forward<Args>(args)...);
+    }
+
+    const Handler& GetHandler() const noexcept {
+        return handler_;
+    }
+
+private:
+    Handler handler_;
+    SpanContext context_;
+};
+
+// Привязывает к обработчику контекст трассировки, по умолчанию - текущий контекст потока
+template <typename Handler>
+ContextBoundHandler<std::decay_t<Handler>> BindContext(Handler&& handler,
+                                                       const SpanContext& context = GetCurrentContext()) {
+    return {std::forward<Handler>(handler), context};
+}
+
+// Разбирает заголовок traceparent (W3C Trace Context). Флаг выборки из заголовка
+// сохраняется: контекст трассы, не попавшей в выборку у отправителя, не записывается.
+// Если заголовок некорректен, возвращает nullopt
+std::optional<SpanContext> ParseTraceParent(std::string_view header) noexcept;
+
+// Формирует заголовок traceparent для передачи контекста удалённому участнику
+std::string FormatTraceParent(const SpanContext& context);
+
+enum class ExportFormat {
+    // Trace Event Format, который открывают chrome://tracing и Perfetto
+    CHROME,
+    // OTLP/JSON: каждая пачка - строка с сообщением ExportTraceServiceRequest,
+    // как в файлах, которые читает OpenTelemetry Collector
+    OTLP,
+};
+
+// Записывает интервалы в формате Chrome. Моменты записываются в микросекундах с дробной частью,
+// поэтому наносекунды не теряются. Если first, перед первым событием не ставится запятая
+void WriteChromeEvents(std::ostream& out, std::span<const SpanRecord> spans, bool first);
+
+// Записывает интервалы одной строкой OTLP/JSON от имени сервиса service_name
+void WriteOtlpBatch(std::ostream& out, std::span<const SpanRecord> spans, std::string_view service_name,
+                    std::int64_t unix_offset_ns);
+
+/*
+ * Периодически забирает интервалы у Tracer и дописывает их пачкой в файл.
+ * Экспорт выполняется в отдельном потоке, поэтому запись в файл не задерживает обработку запросов
+ */
+class TraceExporter {
+public:
+    TraceExporter(std::filesystem::path path, ExportFormat format, std::string service_name,
+                  std::chrono::milliseconds interval = std::chrono::seconds{1},
+                  Tracer& tracer = Tracer::Instance());
+
+    TraceExporter(const TraceExporter&) = delete;
+    TraceExporter& operator=(const TraceExporter&) = delete;
+
+    // Экспортирует оставшиеся интервалы
+    ~TraceExporter();
+
+    // Экспортирует накопленные интервалы и дожидается окончания записи
+    void Flush();
+
+private:
+    void Run(std::stop_token stop);
+    // Вызывается под мьютексом
+    void Export();
+
+    Tracer& tracer_;
+    ExportFormat format_;
+    std::string service_name_;
+    std::chrono::milliseconds interval_;
+    std::ofstream out_;
+    // В файле Chrome ещё нет событий
+    bool first_ = true;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+
+    // Поток объявлен последним, чтобы остановиться раньше разрушения остальных полей
+    std::jthread worker_;
+};
+
+}  // namespace tracing
+
+namespace boost::asio {
+
+template <typename Handler, typename Executor>
+struct associated_executor<tracing::ContextBoundHandler<Handler>, Executor> {
+    using type = associated_executor_t<Handler, Executor>;
+
+    static type get(const tracing::ContextBoundHandler<Handler>& handler,
+                    const Executor& executor = Executor()) noexcept {
+        return associated_executor<Handler, Executor>::get(handler.GetHandler(), executor);
+    }
+};
+
+template <typename Handler, typename Allocator>
+struct associated_allocator<tracing::ContextBoundHandler<Handler>, Allocator> {
+    using type = associated_allocator_t<Handler, Allocator>;
+
+    static type get(const tracing::ContextBoundHandler<Handler>& handler,
+                    const Allocator& allocator = Allocator()) noexcept {
+        return associated_allocator<Handler, Allocator>::get(handler.GetHandler(), allocator);
+    }
+};
+
+}  // namespace boost::asio
@@ -0,0 +1,195 @@
+#include "hot_restart.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+extern char** environ;
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Номер первого переданного дескриптора
+constexpr int FIRST_FD = 3;
+
+// Максимальное количество передаваемых сокетов
+constexpr size_t MAX_SOCKETS = 64;
+
+// Имена переменных окружения. Строковые литералы завершаются нулём,
+// поэтому data() можно передавать в функции C
+constexpr std::string_view LISTEN_PID = "LISTEN_PID"sv;
+constexpr std::string_view LISTEN_FDS = "LISTEN_FDS"sv;
+constexpr std::string_view LISTEN_FDNAMES = "LISTEN_FDNAMES"sv;
+
+bool IsListenVariable(std::string_view var) noexcept {
+    for (auto name : {LISTEN_PID, LISTEN_FDS, LISTEN_FDNAMES}) {
+        if (var.starts_with(name) && var.substr(name.size()).starts_with('=')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+[[noreturn]] void ThrowSystemError(const char* what) {
+    throw std::system_error{errno, std::system_category(), what};
+}
+
+std::optional<long> ParseNumber(const char* str) {
+    if (!str) {
+        return std::nullopt;
+    }
+    const std::string_view value{str};
+    long result = 0;
+    const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc{} || end != value.data() + value.size()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+// Записывает число в буфер. В отличие от std::to_string, не выделяет память,
+// поэтому может вызываться в дочернем процессе между fork и exec
+void WriteNumber(char* out, long value) {
+    char digits[24];
+    size_t size = 0;
+    do {
+        digits[size++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (size != 0) {
+        *out++ = digits[--size];
+    }
+    *out = '\0';
+}
+
+// Выполняется в дочернем процессе. Между fork и exec многопоточной программы допустимы
+// только async-signal-safe функции, поэтому вся память выделена заранее
+[[noreturn]] void ExecChild(const char* const argv[], const std::vector<int>& sockets,
+                            char* const envp[], char* pid_value, int error_pipe, long max_fd) {
+    const int count = static_cast<int>(sockets.size());
+    // Сначала переносим дескрипторы за пределы целевого диапазона, чтобы не затереть
+    // сокеты, уже занимающие номера FIRST_FD и выше
+    const int first_free = FIRST_FD + count + 1;
+    int report_fd = ::fcntl(error_pipe, F_DUPFD_CLOEXEC, first_free);
+    int moved[MAX_SOCKETS];
+    for (int i = 0; i < count && report_fd >= 0; ++i) {
+        moved[i] = ::fcntl(sockets[i], F_DUPFD_CLOEXEC, first_free);
+        if (moved[i] < 0) {
+            report_fd = -1;
+        }
+    }
+    // dup2 снимает флаг FD_CLOEXEC, поэтому новые дескрипторы переживут exec
+    for (int i = 0; i < count && report_fd >= 0; ++i) {
+        if (::dup2(moved[i], FIRST_FD + i) < 0) {
+            report_fd = -1;
+        }
+    }
+    if (report_fd >= 0) {
+        report_fd = ::dup3(report_fd, FIRST_FD + count, O_CLOEXEC);
+    }
+    if (report_fd >= 0) {
+        // Остальные дескрипторы (например, сокеты клиентов) новому процессу не нужны
+        if (::close_range(first_free, ~0U, 0) != 0) {
+            for (long fd = first_free; fd < max_fd; ++fd) {
+                ::close(static_cast<int>(fd));
+            }
+        }
+        WriteNumber(pid_value, ::getpid());
+        ::execvpe(argv[0], const_cast<char* const*>(argv), envp);
+    }
+    // Сообщаем родительскому процессу код ошибки
+    const int error = errno;
+    [[maybe_unused]] const auto written =
+        ::write(report_fd >= 0 ? report_fd : error_pipe, &error, sizeof(error));
+    ::_exit(127);
+}
+
+}  // namespace
+
+std::vector<int> TakeInheritedSockets() {
+    std::vector<int> sockets;
+    const auto pid = ParseNumber(std::getenv(LISTEN_PID.data()));
+    const auto count = ParseNumber(std::getenv(LISTEN_FDS.data()));
+    if (pid && count && *pid == ::getpid() && *count > 0
+        && static_cast<size_t>(*count) <= MAX_SOCKETS) {
+        for (int fd = FIRST_FD; fd < FIRST_FD + *count; ++fd) {
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            sockets.push_back(fd);
+        }
+    }
+    for (auto name : {LISTEN_PID, LISTEN_FDS, LISTEN_FDNAMES}) {
+        ::unsetenv(name.data());
+    }
+    return sockets;
+}
+
+void SpawnWithSockets(const char* const argv[], const std::vector<int>& sockets) {
+    if (sockets.size() > MAX_SOCKETS) {
+        throw std::system_error{std::make_error_code(std::errc::argument_list_too_long),
+                                "Too many sockets to pass"};
+    }
+
+    // Окружение нового процесса: текущее без прежних переменных LISTEN_*
+    std::vector<std::string> env;
+    for (char** var = environ; *var; ++var) {
+        if (!IsListenVariable(*var)) {
+            env.emplace_back(*var);
+        }
+    }
+    env.push_back(std::string{LISTEN_FDS} + '=' + std::to_string(sockets.size()));
+    // pid дочернего процесса станет известен только после fork,
+    // поэтому резервируем место под него заранее
+    env.push_back(std::string{LISTEN_PID} + '=' + std::string(24, '\0'));
+    char* const pid_value = env.back().data() + LISTEN_PID.size() + 1;
+    std::vector<char*> envp;
+    envp.reserve(env.size() + 1);
+    for (auto& var : env) {
+        envp.push_back(var.data());
+    }
+    envp.push_back(nullptr);
+
+    const long max_fd = ::sysconf(_SC_OPEN_MAX);
+
+    // Через канал дочерний процесс сообщает об ошибке запуска. При успешном exec
+    // канал закрывается, и родитель читает конец потока
+    int error_pipe[2];
+    if (::pipe2(error_pipe, O_CLOEXEC) != 0) {
+        ThrowSystemError("pipe2");
+    }
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        const int error = errno;
+        ::close(error_pipe[0]);
+        ::close(error_pipe[1]);
+        throw std::system_error{error, std::system_category(), "fork"};
+    }
+    if (pid == 0) {
+        ::close(error_pipe[0]);
+        ExecChild(argv, sockets, envp.data(), pid_value, error_pipe[1], max_fd);
+    }
+
+    ::close(error_pipe[1]);
+    int error = 0;
+    ssize_t result;
+    do {
+        result = ::read(error_pipe[0], &error, sizeof(error));
+    } while (result < 0 && errno == EINTR);
+    ::close(error_pipe[0]);
+    if (result > 0) {
+        ::waitpid(pid, nullptr, 0);
+        throw std::system_error{error, std::system_category(), "exec"};
+    }
+}
+
+}  // namespace http_server
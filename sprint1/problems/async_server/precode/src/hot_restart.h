@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+namespace http_server {
+
+/*
+ * Передача слушающих сокетов новому экземпляру сервера.
+ * Сокеты передаются по соглашению systemd (socket activation): дескрипторы занимают номера
+ * начиная с 3, их количество задаёт переменная окружения LISTEN_FDS, а LISTEN_PID содержит
+ * pid процесса, которому они предназначены. Поэтому сервер можно запускать и через systemd.
+ * Соединения, ожидающие в очереди сокета, принимает новый процесс, так что при обновлении
+ * сервера клиенты не получают отказов в соединении.
+ */
+
+// Возвращает слушающие сокеты, переданные текущему процессу. Переменные окружения
+// удаляются, а у дескрипторов выставляется FD_CLOEXEC, чтобы сокеты не достались
+// посторонним дочерним процессам
+std::vector<int> TakeInheritedSockets();
+
+// Запускает новый экземпляр программы с аргументами argv (argv[argc] == nullptr)
+// и передаёт ему сокеты sockets. Программа ищется так же, как при запуске из оболочки,
+// поэтому запускается её текущая версия, даже если исполняемый файл был заменён.
+// Возвращает управление после успешного вызова exec в дочернем процессе.
+// В случае ошибки выбрасывает исключение std::system_error
+void SpawnWithSockets(const char* const argv[], const std::vector<int>& sockets);
+
+}  // namespace http_server
@@ -1,6 +1,468 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
 #include <iostream>
+#include <tuple>
 
-namespace http_server {}  // namespace http_server
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Ответ на запрос, не допущенный к обработчику. Ответы сериализуются один раз,
+// поэтому отказ обходится серверу дешевле обработки запроса
+const StaticResponse& GetRejectResponse(AdmissionControl::Decision decision) {
+    const auto make_response = [](http::status status, std::string_view body) {
+        http::response<http::string_body> response{status, 11};
+        response.set(http::field::content_type, "text/plain"sv);
+        response.set(http::field::retry_after, "1"sv);
+        response.body() = body;
+        return StaticResponse{std::move(response)};
+    };
+    static const StaticResponse too_many_requests =
+        make_response(http::status::too_many_requests, "Too many requests"sv);
+    static const StaticResponse service_unavailable =
+        make_response(http::status::service_unavailable, "Server is overloaded"sv);
+    return decision == AdmissionControl::Decision::RATE_LIMITED ? too_many_requests
+                                                                : service_unavailable;
+}
+
+}  // namespace
+
+void ReportError(beast::error_code ec, std::string_view what) {
+    std::cerr << what << ": "sv << ec.message() << std::endl;
+}
+
+void SetReusePort(tcp::acceptor& acceptor) {
+#ifdef SO_REUSEPORT
+    using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor.set_option(reuse_port(true));
+#else
+    throw sys::system_error{net::error::operation_not_supported, "SO_REUSEPORT"s};
+#endif
+}
+
+BufferPool::Lease BufferPool::Acquire() {
+    std::unique_ptr<Buffer> buffer;
+    {
+        std::lock_guard lk{mutex_};
+        if (!free_buffers_.empty()) {
+            buffer = std::move(free_buffers_.back());
+            free_buffers_.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer = std::make_unique<Buffer>();
+    }
+    return Lease{shared_from_this(), std::move(buffer)};
+}
+
+void BufferPool::Release(std::unique_ptr<Buffer> buffer) noexcept {
+    // Слишком большие буферы освобождаем, чтобы один «тяжёлый» запрос
+    // не удерживал память навсегда
+    if (buffer->capacity() > max_capacity_) {
+        return;
+    }
+    // Данные недочитанного запроса не должны попасть в следующий сеанс
+    buffer->clear();
+
+    std::lock_guard lk{mutex_};
+    if (free_buffers_.size() < max_pooled_) {
+        try {
+            free_buffers_.emplace_back(std::move(buffer));
+        } catch (...) {
+            // Не удалось сохранить буфер — просто освобождаем его
+        }
+    }
+}
+
+http::response<http::string_body> MakeMetricsResponse(const Request& request) {
+    std::ostringstream body;
+    Metrics::Instance().WritePrometheus(body);
+    http::response<http::string_body> response{http::status::ok, request.version()};
+    response.set(http::field::content_type, "text/plain; version=0.0.4"sv);
+    response.set(http::field::cache_control, "no-cache"sv);
+    response.body() = std::move(body).str();
+    response.prepare_payload();
+    response.keep_alive(request.keep_alive());
+    return response;
+}
+
+const StaticResponseData::Encoded& StaticResponse::GetVariant(
+    std::string_view accept_encoding) const noexcept {
+    const auto& variants = data_->variants;
+    if (variants[static_cast<size_t>(ContentEncoding::GZIP)]
+        || variants[static_cast<size_t>(ContentEncoding::DEFLATE)]) {
+        const auto accepted = AcceptedEncodings::Parse(accept_encoding);
+        for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+            if (const auto& variant = variants[static_cast<size_t>(encoding)];
+                variant && accepted.Contains(encoding)) {
+                return *variant;
+            }
+        }
+    }
+    return *variants[static_cast<size_t>(ContentEncoding::IDENTITY)];
+}
+
+void SessionBase::Run() {
+    // Вызываем метод Read, используя executor объекта socket_.
+    // Таким образом вся работа с socket_ будет выполняться, используя его executor
+    net::dispatch(socket_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
+}
+
+void SessionBase::Read() {
+    // Не читаем, если чтение уже идёт или очередь неотправленных ответов заполнена.
+    // В последнем случае чтение возобновится после записи очередного ответа
+    if (reading_ || read_closed_ || closed_ || pending_writes_.size() >= MAX_PIPELINED_REQUESTS) {
+        return;
+    }
+    if (IsDraining() && next_request_id_ != 0 && buffer_->size() == 0) {
+        // Сервер останавливается. Новых запросов не ждём, а соединение закрываем после
+        // отправки готовых ответов. Только что принятое соединение успеет прислать запрос
+        read_closed_ = true;
+        if (pending_writes_.empty() && !writing_) {
+            Close();
+        }
+        return;
+    }
+    reading_ = true;
+    SetDeadline(READ_TIMEOUT);
+    if (buffer_->size() != 0) {
+        // Начало следующего запроса уже прочитано вместе с предыдущим
+        return ReadRequest();
+    }
+    // Отдельно дожидаемся первых байтов запроса, чтобы время ожидания клиента
+    // не попадало в метрику разбора
+    awaiting_request_ = true;
+    socket_.async_read_some(buffer_->prepare(beast::read_size(*buffer_, MAX_READ_SIZE)),
+                            beast::bind_front_handler(&SessionBase::OnFirstBytes, GetSharedThis()));
+}
+
+void SessionBase::OnFirstBytes(beast::error_code ec, std::size_t bytes_read) {
+    awaiting_request_ = false;
+    buffer_->commit(bytes_read);
+    if (ec == net::error::eof) {
+        // Клиент закрыл соединение между запросами
+        return OnRead(http::error::end_of_stream, 0);
+    }
+    if (ec) {
+        return OnRead(ec, 0);
+    }
+    ReadRequest();
+}
+
+void SessionBase::ReadRequest() {
+    parse_start_ = Clock::now();
+    // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
+    request_.reset();
+    if (pending_writes_.empty() && !writing_) {
+        // Все прежние запросы обработаны и ответы на них отправлены - арену можно сбросить
+        arena_.release();
+    }
+    const RequestAllocator allocator{&arena_};
+    request_.emplace(std::piecewise_construct, std::make_tuple(allocator),
+                     std::make_tuple(allocator));
+    // Считываем request_ из socket_, используя буфер из пула
+    http::async_read(socket_, *buffer_, *request_,
+                     // По окончании операции будет вызван метод OnRead
+                     beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+}
+
+void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    reading_ = false;
+    if (closed_) {
+        // Сеанс закрыт по истечении срока, операция чтения была отменена
+        return;
+    }
+    if (ec == http::error::end_of_stream) {
+        // Нормальная ситуация - клиент закрыл соединение.
+        // Закрываем сокет только после отправки всех ответов
+        read_closed_ = true;
+        if (pending_writes_.empty() && !writing_) {
+            Close();
+        }
+        return;
+    }
+    if (ec) {
+        return ReportError(ec, "read"sv);
+    }
+
+    const auto handle_start = Clock::now();
+    Metrics::Instance().Record(Stage::PARSE, handle_start - parse_start_);
+
+    if (IsDraining()) {
+        // Сообщаем клиенту, что соединение будет закрыто после ответа на этот запрос
+        request_->keep_alive(false);
+    }
+    if (!request_->keep_alive()) {
+        // После этого запроса клиент не ждёт других ответов
+        read_closed_ = true;
+    }
+
+    // Резервируем место для ответа, чтобы сохранить порядок ответов
+    const RequestId request_id = next_request_id_++;
+    pending_writes_.push_back({std::nullopt, handle_start, {}});
+    if (IsMetricsRequest(*request_)) {
+        Write(request_id, MakeMetricsResponse(*request_));
+    } else if (const auto decision = Admit(pending_writes_.back().permit);
+               decision != AdmissionControl::Decision::ACCEPT) {
+        Write(request_id, GetRejectResponse(decision).Prepare(*request_));
+    } else {
+        HandleRequest(request_id, std::move(*request_));
+    }
+
+    // Не дожидаясь ответа, читаем следующий запрос
+    Read();
+}
+
+bool SessionBase::IsMetricsRequest(const HttpRequest& request) const noexcept {
+    return !metrics_path_.empty() && request.method() == http::verb::get
+        && request.target() == metrics_path_;
+}
+
+AdmissionControl::Decision SessionBase::Admit(AdmissionControl::Permit& permit) {
+    if (!group_->admission) {
+        return AdmissionControl::Decision::ACCEPT;
+    }
+    return group_->admission->Admit(client_, permit);
+}
+
+void SessionBase::EnqueueWrite(RequestId request_id, Writer writer) {
+    if (closed_) {
+        // Соединение уже закрыто, ответ отправлять некому
+        return;
+    }
+    assert(request_id >= next_write_id_ && request_id - next_write_id_ < pending_writes_.size());
+    auto& pending = pending_writes_[request_id - next_write_id_];
+    Metrics::Instance().Record(Stage::HANDLE, Clock::now() - pending.handle_start);
+    // Обработчик вернул ответ, и запрос больше не занимает место в лимите
+    pending.permit = {};
+    pending.writer = std::move(writer);
+    WriteNext();
+}
+
+void SessionBase::WriteNext() {
+    if (writing_ || pending_writes_.empty() || !pending_writes_.front().writer) {
+        // Ответ на самый старый запрос ещё не готов
+        return;
+    }
+    Writer writer = std::move(*pending_writes_.front().writer);
+    pending_writes_.pop_front();
+    ++next_write_id_;
+    writing_ = true;
+    write_start_ = Clock::now();
+    writer();
+}
+
+void SessionBase::OnWrite(bool close, beast::error_code ec,
+                          [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
+    Metrics::Instance().Record(Stage::WRITE, Clock::now() - write_start_);
+    if (closed_) {
+        // Сеанс закрыт по истечении срока, операция записи была отменена
+        return;
+    }
+    if (ec) {
+        closed_ = true;
+        pending_writes_.clear();
+        return ReportError(ec, "write"sv);
+    }
+
+    if (close || (read_closed_ && pending_writes_.empty() && !reading_)) {
+        // Семантика ответа требует закрыть соединение либо клиент больше не пришлёт запросов
+        return Close();
+    }
+
+    // Отправляем следующий готовый ответ и, если очередь освободилась, возобновляем чтение
+    WriteNext();
+    Read();
+}
+
+void SessionBase::Close() {
+    closed_ = true;
+    pending_writes_.clear();
+    beast::error_code ec;
+    socket_.shutdown(tcp::socket::shutdown_send, ec);
+}
+
+#ifdef __linux__
+void SessionBase::WriteFile(RequestId request_id, std::shared_ptr<FileTransfer> transfer) {
+    net::dispatch(socket_.get_executor(), [transfer = std::move(transfer), request_id,
+                                           self = GetSharedThis()]() mutable {
+        self->EnqueueWrite(request_id, [transfer = std::move(transfer), self] {
+            self->SetDeadline(WRITE_TIMEOUT);
+            net::async_write(self->socket_, net::buffer(transfer->head),
+                             [transfer, self](beast::error_code ec, std::size_t bytes_written) {
+                                 if (ec) {
+                                     return self->OnWrite(true, ec, bytes_written);
+                                 }
+                                 self->SendFile(transfer);
+                             });
+        });
+    });
+}
+
+void SessionBase::SendFile(std::shared_ptr<FileTransfer> transfer) {
+    if (transfer->remaining == 0) {
+        return OnWrite(transfer->need_eof, {}, transfer->head.size() + transfer->offset);
+    }
+
+    // sendfile работает с дескриптором сокета напрямую, поэтому он должен быть неблокирующим
+    beast::error_code ec;
+    socket_.native_non_blocking(true, ec);
+    if (ec) {
+        return OnWrite(true, ec, 0);
+    }
+
+    auto offset = static_cast<off_t>(transfer->offset);
+    const auto count = static_cast<size_t>(
+        std::min<std::uint64_t>(transfer->remaining, MAX_SENDFILE_CHUNK));
+    const ssize_t sent =
+        ::sendfile(socket_.native_handle(), transfer->file.native_handle(), &offset, count);
+    if (sent > 0) {
+        transfer->offset = static_cast<std::uint64_t>(offset);
+        transfer->remaining -= static_cast<std::uint64_t>(sent);
+        // Срок отсчитывается от последней успешной передачи, а не от начала ответа,
+        // иначе большой файл не успел бы уйти медленному клиенту
+        SetDeadline(WRITE_TIMEOUT);
+        // Продолжение ставим в очередь, чтобы дать поработать другим сеансам потока
+        net::post(socket_.get_executor(), [transfer = std::move(transfer), self = GetSharedThis()] {
+            self->SendFile(transfer);
+        });
+        return;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        // Буфер сокета заполнен: ждём, пока клиент прочитает данные
+        socket_.async_wait(tcp::socket::wait_write,
+                           [transfer = std::move(transfer), self = GetSharedThis()](
+                               beast::error_code ec) {
+                               if (ec) {
+                                   return self->OnWrite(true, ec, 0);
+                               }
+                               self->SendFile(transfer);
+                           });
+        return;
+    }
+    // Файл оказался короче, чем было заявлено в заголовке, либо произошла ошибка.
+    // Ответ уже не завершить корректно, поэтому соединение закрывается
+    ec = sent == 0 ? beast::error_code{net::error::eof}
+                   : beast::error_code{errno, sys::system_category()};
+    OnWrite(true, ec, transfer->head.size() + transfer->offset);
+    Close();
+}
+#endif
+
+void SessionBase::SetDeadline(Clock::duration timeout) {
+    ExpiresAfter(timeout);
+    // Колесо удаляет элемент, срок которого истёк, поэтому добавляем его при каждой установке.
+    // Если сеанс уже в колесе, вызов ничего не делает
+    timer_wheel_->Add(GetSharedEntry());
+}
+
+std::shared_ptr<TimerWheel::Entry> SessionBase::GetSharedEntry() {
+    // Entry - закрытый базовый класс, поэтому неявное преобразование shared_ptr недоступно.
+    // Конструктор псевдонима разделяет владение с сеансом
+    auto self = GetSharedThis();
+    TimerWheel::Entry* entry = self.get();
+    return {std::move(self), entry};
+}
+
+void SessionBase::OnExpired() {
+    net::dispatch(socket_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::OnDeadline, GetSharedThis()));
+}
+
+void SessionBase::OnDeadline() {
+    if (closed_) {
+        return;
+    }
+    if (awaiting_request_ && IsDraining() && next_request_id_ != 0) {
+        // Сервер останавливается, а клиент ещё не начал присылать очередной запрос.
+        // Чтение из сокета завершится концом потока, и сеанс закроется
+        // после отправки готовых ответов
+        beast::error_code ec;
+        socket_.shutdown(tcp::socket::shutdown_receive, ec);
+    }
+    if (!reading_ && !writing_) {
+        // Сеанс закрыт или ждёт ответа обработчика.
+        // Срок будет установлен заново при следующем чтении или записи
+        return;
+    }
+    if (!IsExpired(TimerWheel::Clock::now())) {
+        // Срок продлили, пока обработчик ждал своей очереди в strand-е
+        timer_wheel_->Add(GetSharedEntry());
+        return;
+    }
+    ReportError(beast::error::timeout, "session"sv);
+    closed_ = true;
+    pending_writes_.clear();
+    // Закрытие сокета отменяет незавершённые операции чтения и записи
+    beast::error_code ec;
+    socket_.close(ec);
+}
+
+namespace {
+
+// Ожидает завершения сеансов слушателей, см. AsyncDrain
+struct DrainWaiter : std::enable_shared_from_this<DrainWaiter> {
+    // Сеансы не сообщают о своём завершении, поэтому их количество проверяется периодически
+    constexpr static auto POLL_INTERVAL = 50ms;
+
+    DrainWaiter(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::time_point deadline, std::function<void()> on_drained)
+        : timer{ioc}
+        , listeners{std::move(listeners)}
+        , deadline{deadline}
+        , on_drained{std::move(on_drained)} {
+    }
+
+    void Wait() {
+        const bool drained =
+            std::all_of(listeners.begin(), listeners.end(), [](const auto& listener) {
+                return listener->GetActiveSessions() == 0;
+            });
+        if (drained || std::chrono::steady_clock::now() >= deadline) {
+            return on_drained();
+        }
+        timer.expires_after(POLL_INTERVAL);
+        timer.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Wait();
+            }
+        });
+    }
+
+    net::steady_timer timer;
+    std::vector<std::shared_ptr<ListenerBase>> listeners;
+    std::chrono::steady_clock::time_point deadline;
+    std::function<void()> on_drained;
+};
+
+}  // namespace
+
+void AsyncDrain(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::duration timeout, std::function<void()> on_drained) {
+    for (const auto& listener : listeners) {
+        listener->Drain();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto waiter = std::make_shared<DrainWaiter>(ioc, std::move(listeners), deadline,
+                                                std::move(on_drained));
+    // Первую проверку выполняем после того, как слушатели обработают Drain
+    net::post(ioc, [waiter] {
+        waiter->Wait();
+    });
+}
+
+}  // namespace http_server
@@ -3,10 +3,32 @@
 // boost.beast будет использовать std::string_view вместо boost::string_view
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "admission.h"
+#include "arena_allocator.h"
+#include "compression.h"
+#include "metrics.h"
+#include "timer_wheel.h"
 
 namespace http_server {
 
@@ -14,24 +36,692 @@ namespace net = boost::asio;
 using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace http = beast::http;
+namespace sys = boost::system;
+
+void ReportError(beast::error_code ec, std::string_view what);
+
+// Включает опцию SO_REUSEPORT. Если система её не поддерживает, выбрасывает
+// исключение sys::system_error
+void SetReusePort(tcp::acceptor& acceptor);
+
+// Аллокатор, через который поля и тело запроса получают память из арены сеанса
+using RequestAllocator = ArenaAllocator<char>;
+using RequestBody = http::basic_string_body<char, std::char_traits<char>, RequestAllocator>;
+using RequestFields = http::basic_fields<RequestAllocator>;
+// Тип запросов, которые сеанс передаёт обработчику
+using Request = http::request<RequestBody, RequestFields>;
+
+// Формирует ответ с текущими значениями метрик сервера
+http::response<http::string_body> MakeMetricsResponse(const Request& request);
+
+/*
+ * Пул буферов чтения.
+ * Буфер закрытого сеанса не уничтожается, а возвращается в пул вместе с выделенной памятью,
+ * поэтому новый сеанс получает уже «разогретый» буфер и не обращается к куче.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    using Buffer = beast::flat_buffer;
+
+    // Максимальное количество буферов, хранимых в пуле
+    constexpr static size_t DEFAULT_MAX_POOLED = 4096;
+    // Буферы, разросшиеся сильнее этого размера, не возвращаются в пул
+    constexpr static size_t DEFAULT_MAX_CAPACITY = 64 * 1024;
+
+    // Буфер, арендованный у пула. При разрушении возвращается в пул
+    class Lease {
+    public:
+        Lease() = default;
+
+        Lease(std::shared_ptr<BufferPool> pool, std::unique_ptr<Buffer> buffer) noexcept
+            : pool_{std::move(pool)}
+            , buffer_{std::move(buffer)} {
+        }
+
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&& rhs) noexcept {
+            if (this != &rhs) {
+                Release();
+                pool_ = std::move(rhs.pool_);
+                buffer_ = std::move(rhs.buffer_);
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() {
+            Release();
+        }
+
+        Buffer& operator*() const noexcept {
+            return *buffer_;
+        }
+
+        Buffer* operator->() const noexcept {
+            return buffer_.get();
+        }
+
+    private:
+        void Release() noexcept {
+            if (pool_ && buffer_) {
+                pool_->Release(std::move(buffer_));
+            }
+            pool_.reset();
+        }
+
+        std::shared_ptr<BufferPool> pool_;
+        std::unique_ptr<Buffer> buffer_;
+    };
+
+    explicit BufferPool(size_t max_pooled = DEFAULT_MAX_POOLED,
+                        size_t max_capacity = DEFAULT_MAX_CAPACITY)
+        : max_pooled_{max_pooled}
+        , max_capacity_{max_capacity} {
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Выдаёт буфер из пула либо создаёт новый, если пул пуст
+    Lease Acquire();
+
+private:
+    void Release(std::unique_ptr<Buffer> buffer) noexcept;
+
+    size_t max_pooled_;
+    size_t max_capacity_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Buffer>> free_buffers_;
+};
+
+// Параметры сжатия ответов
+struct Compression {
+    Compression() = delete;
+    // Заранее сериализованные ответы сжимаются один раз, поэтому сжимаем их максимально
+    constexpr static size_t STATIC_MIN_SIZE = 256;
+    constexpr static int STATIC_LEVEL = 9;
+    // Остальные ответы сжимаются при каждой отправке: небольшие тела сжимать невыгодно,
+    // а уровень выбран в пользу скорости
+    constexpr static size_t DYNAMIC_MIN_SIZE = 1024;
+    constexpr static int DYNAMIC_LEVEL = 1;
+};
+
+// Содержимое StaticResponse: заголовки для HTTP/1.0 и HTTP/1.1 с keep-alive и без
+// (см. StaticResponse::HeadIndex) и общее для них тело
+struct StaticResponseData {
+    // Вариант ответа с определённым кодированием тела
+    struct Encoded {
+        std::array<std::string, 4> heads;
+        std::string body;
+    };
+    // Индекс варианта - значение ContentEncoding. Вариант без сжатия есть всегда
+    std::array<std::optional<Encoded>, CONTENT_ENCODING_COUNT> variants;
+};
+
+/*
+ * Заранее сериализованный неизменяемый ответ.
+ * Заголовки и тело хранятся в общих буферах, которые отправляются в сокет без копирования
+ * (scatter/gather). Подходит для ответов, которые не зависят от запроса.
+ * Копирование объекта дешёвое: копируется только умный указатель.
+ */
+class StaticResponse {
+public:
+    // Ответ, подготовленный к записи для конкретного запроса
+    class Prepared {
+    public:
+        using Buffers = std::array<net::const_buffer, 2>;
+
+        // Возвращает буферы, которые нужно записать в сокет
+        Buffers GetBuffers() const noexcept {
+            return {net::buffer(variant_->heads[head_index_]),
+                    net::buffer(with_body_ ? variant_->body : std::string_view{})};
+        }
+
+        // Требует ли ответ закрыть соединение после отправки
+        bool NeedEof() const noexcept {
+            return need_eof_;
+        }
+
+    private:
+        friend class StaticResponse;
+
+        Prepared(std::shared_ptr<const StaticResponseData> data,
+                 const StaticResponseData::Encoded* variant, size_t head_index, bool with_body,
+                 bool need_eof) noexcept
+            : data_{std::move(data)}
+            , variant_{variant}
+            , head_index_{head_index}
+            , with_body_{with_body}
+            , need_eof_{need_eof} {
+        }
+
+        std::shared_ptr<const StaticResponseData> data_;
+        // Указывает внутрь data_
+        const StaticResponseData::Encoded* variant_;
+        size_t head_index_;
+        bool with_body_;
+        bool need_eof_;
+    };
+
+    template <typename Body, typename Fields>
+    explicit StaticResponse(http::response<Body, Fields> response);
+
+    // Выбирает вариант заголовков, соответствующий версии HTTP и keep-alive запроса,
+    // и сжатое тело, если клиент его принимает. На HEAD-запрос тело не отправляется
+    template <typename RequestBody, typename RequestFields>
+    Prepared Prepare(const http::request<RequestBody, RequestFields>& req) const {
+        const bool keep_alive = req.keep_alive();
+        return Prepared{data_, &GetVariant(req[http::field::accept_encoding]),
+                        HeadIndex(req.version(), keep_alive), req.method() != http::verb::head,
+                        !keep_alive};
+    }
+
+private:
+    const StaticResponseData::Encoded& GetVariant(std::string_view accept_encoding) const noexcept;
+
+    static size_t HeadIndex(unsigned version, bool keep_alive) noexcept {
+        return (version >= 11 ? 2 : 0) + (keep_alive ? 1 : 0);
+    }
+
+    std::shared_ptr<const StaticResponseData> data_;
+};
+
+template <typename Body, typename Fields>
+StaticResponse::StaticResponse(http::response<Body, Fields> response) {
+    auto data = std::make_shared<StaticResponseData>();
+    response.prepare_payload();
+
+    // Сериализуем ответ целиком, чтобы получить тело в том виде, в котором оно уходит в сеть
+    std::string body;
+    {
+        std::ostringstream out;
+        out << response;
+        std::ostringstream head;
+        head << response.base();
+        body = std::move(out).str().substr(head.str().size());
+    }
+
+    const bool compressible = !response.chunked() && body.size() >= Compression::STATIC_MIN_SIZE
+                           && response.count(http::field::content_encoding) == 0
+                           && IsCompressibleType(response[http::field::content_type]);
+    if (compressible) {
+        // Кэши между клиентом и сервером должны различать варианты ответа
+        response.set(http::field::vary, "Accept-Encoding");
+    }
+
+    const auto add_variant = [&response, &data](ContentEncoding encoding,
+                                                std::string encoded_body) {
+        auto& variant = data->variants[static_cast<size_t>(encoding)].emplace();
+        for (unsigned version : {10u, 11u}) {
+            for (bool keep_alive : {false, true}) {
+                response.version(version);
+                response.keep_alive(keep_alive);
+                std::ostringstream head;
+                head << response.base();
+                variant.heads[HeadIndex(version, keep_alive)] = std::move(head).str();
+            }
+        }
+        variant.body = std::move(encoded_body);
+    };
+
+    if (compressible) {
+        for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+            auto compressed = Compress(body, encoding, Compression::STATIC_LEVEL);
+            if (compressed && compressed->size() < body.size()) {
+                response.set(http::field::content_encoding, GetEncodingName(encoding));
+                response.content_length(compressed->size());
+                add_variant(encoding, std::move(*compressed));
+            }
+        }
+        response.erase(http::field::content_encoding);
+        response.content_length(body.size());
+    }
+    add_variant(ContentEncoding::IDENTITY, std::move(body));
+    data_ = std::move(data);
+}
+
+// Сжимает тело ответа в формате encoding, если тело достаточно велико и его тип сжимаем
+template <typename Fields>
+http::response<http::string_body, Fields> CompressResponse(
+    http::response<http::string_body, Fields>&& response, ContentEncoding encoding) {
+    auto& body = response.body();
+    if (body.size() < Compression::DYNAMIC_MIN_SIZE
+        || response.count(http::field::content_encoding) != 0
+        || !IsCompressibleType(response[http::field::content_type])) {
+        return std::move(response);
+    }
+    response.set(http::field::vary, "Accept-Encoding");
+    if (auto compressed = Compress(body, encoding, Compression::DYNAMIC_LEVEL);
+        compressed && compressed->size() < body.size()) {
+        body = std::move(*compressed);
+        response.set(http::field::content_encoding, GetEncodingName(encoding));
+        response.content_length(body.size());
+    }
+    return std::move(response);
+}
+
+// Ответы с другими типами тела (файлы, заранее сериализованные ответы) не сжимаются
+template <typename Response>
+Response&& CompressResponse(Response&& response, [[maybe_unused]] ContentEncoding encoding) {
+    return std::forward<Response>(response);
+}
+
+// Параметры сокета, принимающего соединения, и принятых на нём сеансов
+struct ListenOptions {
+    // Разрешает нескольким acceptor-ам слушать один и тот же порт (SO_REUSEPORT).
+    // Ядро само распределяет входящие соединения между ними
+    bool reuse_port = false;
+    // Путь, по которому сервер сам отвечает на GET-запросы метриками в формате Prometheus.
+    // Пустая строка отключает метрики. Строка должна жить не меньше сервера
+    std::string_view metrics_path;
+    // Уже открытый слушающий сокет, например унаследованный от предыдущего экземпляра
+    // сервера. Если задан, слушатель использует его вместо создания нового сокета,
+    // а из endpoint берётся только протокол
+    std::optional<tcp::acceptor::native_handle_type> native_handle;
+    // Контроль допуска запросов к обработчику. Один объект можно передать нескольким
+    // слушателям, чтобы ограничения были общими. nullptr отключает ограничения
+    std::shared_ptr<AdmissionControl> admission;
+};
 
-class SessionBase {
-    // Напишите недостающий код, используя информацию из урока
+// Общее состояние сеансов, принятых одним слушателем
+struct SessionGroup {
+    // Количество ещё не завершённых сеансов
+    std::atomic<size_t> active{0};
+    // Сервер плавно останавливается: сеансы отвечают на уже полученные запросы
+    // и закрывают соединения, не дожидаясь новых
+    std::atomic<bool> draining{false};
+    std::shared_ptr<AdmissionControl> admission;
+};
+
+// Сроки чтения и записи сеанса отслеживает колесо таймеров, общее для всех сеансов io_context
+class SessionBase : private TimerWheel::Entry {
+public:
+    // Запрещаем копирование и присваивание объектов SessionBase и его наследников
+    SessionBase(const SessionBase&) = delete;
+    SessionBase& operator=(const SessionBase&) = delete;
+
+    void Run();
+
+protected:
+    using HttpRequest = Request;
+    // Порядковый номер запроса внутри соединения
+    using RequestId = std::uint64_t;
+
+    // Максимальное количество запросов, ответы на которые ещё не отправлены.
+    // Пока лимит исчерпан, чтение следующих запросов приостанавливается
+    constexpr static size_t MAX_PIPELINED_REQUESTS = 16;
+
+    // Сокет должен быть создан на собственном strand-е сеанса. Тогда все обработчики сеанса
+    // выполняются последовательно без явной синхронизации
+    SessionBase(tcp::socket&& socket, BufferPool::Lease buffer,
+                std::shared_ptr<TimerWheel> timer_wheel, std::shared_ptr<SessionGroup> group,
+                std::string_view metrics_path)
+        : socket_(std::move(socket))
+        , timer_wheel_(std::move(timer_wheel))
+        , group_(std::move(group))
+        , buffer_(std::move(buffer))
+        , arena_(arena_buffer_.data(), arena_buffer_.size())
+        , metrics_path_(metrics_path) {
+        group_->active.fetch_add(1, std::memory_order_relaxed);
+        beast::error_code ec;
+        client_ = AdmissionControl::MakeClientKey(socket_.remote_endpoint(ec).address());
+    }
+
+    ~SessionBase() {
+        group_->active.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Отправляет ответ на запрос request_id. Может быть вызван из любого потока и в любом
+    // порядке: ответы ставятся в очередь и записываются в сокет в порядке поступления запросов
+    template <typename Body, typename Fields>
+    void Write(RequestId request_id, http::response<Body, Fields>&& response) {
+        // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
+        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
+
+        net::dispatch(socket_.get_executor(), [safe_response, request_id,
+                                               self = GetSharedThis()]() mutable {
+            self->EnqueueWrite(request_id, [safe_response = std::move(safe_response), self] {
+                self->SetDeadline(WRITE_TIMEOUT);
+                http::async_write(self->socket_, *safe_response,
+                                  [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
+                                      self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+                                  });
+            });
+        });
+    }
+
+    // Отправляет заранее сериализованный ответ на запрос request_id.
+    // Буферы ответа записываются в сокет напрямую, без копирования
+    void Write(RequestId request_id, StaticResponse::Prepared response) {
+        net::dispatch(socket_.get_executor(), [response = std::move(response), request_id,
+                                               self = GetSharedThis()]() mutable {
+            self->EnqueueWrite(request_id, [response = std::move(response), self] {
+                self->SetDeadline(WRITE_TIMEOUT);
+                net::async_write(self->socket_, response.GetBuffers(),
+                                 [response, self](beast::error_code ec, std::size_t bytes_written) {
+                                     self->OnWrite(response.NeedEof(), ec, bytes_written);
+                                 });
+            });
+        });
+    }
+
+#ifdef __linux__
+    // Отправляет ответ с содержимым файла. Заголовок записывается в сокет обычным образом,
+    // а тело передаётся из файла системным вызовом sendfile, минуя память процесса.
+    // Поэтому объём памяти на ответ не зависит от размера файла.
+    // На других платформах такие ответы отправляет общий шаблонный метод Write
+    template <typename Fields>
+    void Write(RequestId request_id, http::response<http::file_body, Fields>&& response) {
+        auto transfer = std::make_shared<FileTransfer>();
+        std::ostringstream head;
+        head << response.base();
+        transfer->head = std::move(head).str();
+        transfer->remaining = response.body().size();
+        transfer->need_eof = response.need_eof();
+        transfer->file = std::move(response.body().file());
+        WriteFile(request_id, std::move(transfer));
+    }
+#endif
+
+private:
+    // Запускает асинхронную запись очередного ответа
+    using Writer = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingWrite {
+        // Пустое значение означает, что обработчик ещё не вернул ответ
+        std::optional<Writer> writer;
+        // Момент передачи запроса обработчику
+        Clock::time_point handle_start;
+        // Место запроса в лимите одновременных запросов
+        AdmissionControl::Permit permit;
+    };
+
+    // Начальный буфер арены. Его хватает на заголовки типичного запроса,
+    // поэтому при их разборе куча не используется
+    constexpr static size_t ARENA_BUFFER_SIZE = 2048;
+    // Максимальный объём данных, запрашиваемый у сокета за одно чтение
+    constexpr static size_t MAX_READ_SIZE = 64 * 1024;
+
+    // Максимальное время ожидания и чтения очередного запроса. Срок не продлевается
+    // по мере поступления байтов, поэтому медленный клиент не удержит соединение дольше
+    constexpr static std::chrono::seconds READ_TIMEOUT{30};
+    // Максимальное время записи одного ответа
+    constexpr static std::chrono::seconds WRITE_TIMEOUT{30};
+
+    void Read();
+    void OnFirstBytes(beast::error_code ec, std::size_t bytes_read);
+    void ReadRequest();
+    void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    bool IsMetricsRequest(const HttpRequest& request) const noexcept;
+    AdmissionControl::Decision Admit(AdmissionControl::Permit& permit);
+    bool IsDraining() const noexcept {
+        return group_->draining.load(std::memory_order_relaxed);
+    }
+    void EnqueueWrite(RequestId request_id, Writer writer);
+    void WriteNext();
+    void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    void Close();
+
+#ifdef __linux__
+    // Состояние отправки файла
+    struct FileTransfer {
+        std::string head;
+        beast::file file;
+        std::uint64_t offset = 0;
+        std::uint64_t remaining = 0;
+        bool need_eof = false;
+    };
+
+    // Максимальный объём данных, передаваемый одним вызовом sendfile. Между вызовами
+    // поток может обслужить другие сеансы, даже если клиент читает очень быстро
+    constexpr static size_t MAX_SENDFILE_CHUNK = 1024 * 1024;
+
+    void WriteFile(RequestId request_id, std::shared_ptr<FileTransfer> transfer);
+    void SendFile(std::shared_ptr<FileTransfer> transfer);
+#endif
+
+    // Устанавливает срок текущей операции ввода-вывода
+    void SetDeadline(Clock::duration timeout);
+    // Вызывается колесом таймеров, когда срок истёк
+    void OnExpired() override;
+    void OnDeadline();
+    std::shared_ptr<TimerWheel::Entry> GetSharedEntry();
+
+    // Обработку запроса делегируем подклассу
+    virtual void HandleRequest(RequestId request_id, HttpRequest&& request) = 0;
+
+    virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
+
+    tcp::socket socket_;
+    std::shared_ptr<TimerWheel> timer_wheel_;
+    std::shared_ptr<SessionGroup> group_;
+    BufferPool::Lease buffer_;
+
+    // Монотонная арена для полей и тела запросов. Освобождать отдельные блоки не нужно:
+    // арена целиком сбрасывается, когда у сеанса не остаётся необработанных запросов.
+    // Поэтому обработчик не должен хранить запрос после отправки ответа на него
+    std::array<std::byte, ARENA_BUFFER_SIZE> arena_buffer_;
+    std::pmr::monotonic_buffer_resource arena_;
+    // Запрос, в который выполняется чтение. Пересоздаётся перед каждым чтением,
+    // чтобы его поля использовали арену
+    std::optional<HttpRequest> request_;
+
+    std::string_view metrics_path_;
+    AdmissionControl::ClientKey client_;
+    // Начало разбора текущего запроса и записи текущего ответа
+    Clock::time_point parse_start_;
+    Clock::time_point write_start_;
+
+    // Ответы на ещё не отправленные запросы. Первый элемент соответствует запросу
+    // next_write_id_
+    std::deque<PendingWrite> pending_writes_;
+    RequestId next_request_id_ = 0;
+    RequestId next_write_id_ = 0;
+    bool reading_ = false;
+    // Сеанс ждёт первых байтов очередного запроса
+    bool awaiting_request_ = false;
+    bool writing_ = false;
+    // Клиент больше не будет присылать запросы (конец потока или Connection: close)
+    bool read_closed_ = false;
+    bool closed_ = false;
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
-	// Напишите недостающий код, используя информацию из урока
+public:
+    template <typename Handler>
+    Session(tcp::socket&& socket, BufferPool::Lease buffer,
+            std::shared_ptr<TimerWheel> timer_wheel, std::shared_ptr<SessionGroup> group,
+            std::string_view metrics_path, Handler&& request_handler)
+        : SessionBase(std::move(socket), std::move(buffer), std::move(timer_wheel),
+                      std::move(group), metrics_path)
+        , request_handler_(std::forward<Handler>(request_handler)) {
+    }
+
+private:
+    void HandleRequest(RequestId request_id, HttpRequest&& request) override {
+        // Кодирование выбираем до того, как запрос будет передан обработчику
+        const auto encoding =
+            AcceptedEncodings::Parse(request[http::field::accept_encoding]).GetPreferred();
+        // Захватываем умный указатель на текущий объект Session в лямбде,
+        // чтобы продлить время жизни сессии до вызова лямбды
+        request_handler_(std::move(request), [self = this->shared_from_this(), request_id,
+                                              encoding](auto&& response) {
+            self->Write(request_id, CompressResponse(std::move(response), encoding));
+        });
+    }
+
+    std::shared_ptr<SessionBase> GetSharedThis() override {
+        return this->shared_from_this();
+    }
+
+    RequestHandler request_handler_;
+};
+
+// Управление слушателем, не зависящее от типа обработчика запросов
+class ListenerBase {
+public:
+    ListenerBase(const ListenerBase&) = delete;
+    ListenerBase& operator=(const ListenerBase&) = delete;
+
+    // Переводит слушатель в режим плавной остановки: новые соединения не принимаются,
+    // а сеансы отвечают на уже полученные запросы и закрывают соединения.
+    // Может быть вызван из любого потока
+    virtual void Drain() = 0;
+
+    // Количество ещё не завершённых сеансов. Может быть вызван из любого потока
+    size_t GetActiveSessions() const noexcept {
+        return sessions_->active.load(std::memory_order_acquire);
+    }
+
+    // Дескриптор слушающего сокета, например для передачи новому экземпляру сервера.
+    // После вызова Drain сокет закрывается
+    tcp::acceptor::native_handle_type GetNativeHandle() const noexcept {
+        return native_handle_;
+    }
+
+protected:
+    ListenerBase() = default;
+    ~ListenerBase() = default;
+
+    std::shared_ptr<SessionGroup> sessions_ = std::make_shared<SessionGroup>();
+    tcp::acceptor::native_handle_type native_handle_ = -1;
 };
 
+/*
+ * Плавно останавливает слушателей (см. ListenerBase::Drain) и вызывает on_drained в потоке
+ * ioc, когда все их сеансы завершатся, но не позднее чем через timeout
+ */
+void AsyncDrain(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::duration timeout, std::function<void()> on_drained);
+
 template <typename RequestHandler>
-class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
-    // Напишите недостающий код, используя информацию из урока
+class Listener : public ListenerBase,
+                 public std::enable_shared_from_this<Listener<RequestHandler>> {
+public:
+    template <typename Handler>
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+             ListenOptions options = {})
+        : ioc_(ioc)
+        // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
+        , acceptor_(net::make_strand(ioc))
+        , metrics_path_(options.metrics_path)
+        , request_handler_(std::forward<Handler>(request_handler)) {
+        sessions_->admission = std::move(options.admission);
+        if (options.native_handle) {
+            // Сокет уже привязан к адресу и принимает соединения
+            acceptor_.assign(endpoint.protocol(), *options.native_handle);
+            native_handle_ = acceptor_.native_handle();
+            return;
+        }
+        // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
+        acceptor_.open(endpoint.protocol());
+
+        // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
+        // чтобы компьютеры могли обменяться завершающими пакетами данных.
+        // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
+        // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (options.reuse_port) {
+            SetReusePort(acceptor_);
+        }
+        // Привязываем acceptor к адресу и порту endpoint
+        acceptor_.bind(endpoint);
+        // Переводим acceptor в состояние, в котором он способен принимать новые соединения
+        // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
+        acceptor_.listen(net::socket_base::max_listen_connections);
+        native_handle_ = acceptor_.native_handle();
+    }
+
+    void Run() {
+        timer_wheel_->Start();
+        DoAccept();
+    }
+
+    void Drain() override {
+        net::dispatch(acceptor_.get_executor(), [self = this->shared_from_this()] {
+            self->sessions_->draining = true;
+            // Закрытие отменяет ожидание нового соединения
+            beast::error_code ec;
+            self->acceptor_.close(ec);
+            // Сеансы, ожидающие следующего запроса, должны узнать об остановке сразу,
+            // а не по истечении срока чтения
+            self->timer_wheel_->NotifyAll();
+        });
+    }
+
+private:
+    void DoAccept() {
+        acceptor_.async_accept(
+            // Передаём последовательный исполнитель, в котором будут вызываться обработчики
+            // асинхронных операций сокета
+            net::make_strand(ioc_),
+            // С помощью bind_front_handler создаём обработчик, привязанный к методу OnAccept
+            // текущего объекта.
+            // Так как Listener — шаблонный класс, нужно подсказать компилятору, что
+            // shared_from_this — метод класса, а не свободная функция.
+            // Для этого вызываем его, используя this
+            // Этот вызов bind_front_handler аналогичен
+            // namespace ph = std::placeholders;
+            // std::bind(&Listener::OnAccept, this->shared_from_this(), ph::_1, ph::_2)
+            beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this()));
+    }
+
+    // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
+    void OnAccept(sys::error_code ec, tcp::socket socket) {
+        using namespace std::literals;
+
+        if (ec) {
+            if (sessions_->draining) {
+                // acceptor закрыт методом Drain
+                return;
+            }
+            return ReportError(ec, "accept"sv);
+        }
+
+        // Асинхронно обрабатываем сессию. Соединение, принятое до вызова Drain,
+        // обслуживается, даже если сервер уже останавливается
+        AsyncRunSession(std::move(socket));
+
+        // Принимаем новое соединение
+        if (!sessions_->draining) {
+            DoAccept();
+        }
+    }
+
+    void AsyncRunSession(tcp::socket&& socket) {
+        std::make_shared<Session<RequestHandler>>(std::move(socket), buffer_pool_->Acquire(),
+                                                  timer_wheel_, sessions_, metrics_path_,
+                                                  request_handler_)
+            ->Run();
+    }
+
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    std::string_view metrics_path_;
+    RequestHandler request_handler_;
+    std::shared_ptr<BufferPool> buffer_pool_ = std::make_shared<BufferPool>();
+    // Сроки всех сеансов, принятых слушателем, отслеживает одно колесо
+    std::shared_ptr<TimerWheel> timer_wheel_ = std::make_shared<TimerWheel>(ioc_);
 };
 
+// Запускает слушатель и возвращает объект для управления им.
+// Слушатель продолжает работу, даже если возвращённый указатель не сохранён
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
-    // Напишите недостающий код, используя информацию из урока
+std::shared_ptr<ListenerBase> ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint,
+                                        RequestHandler&& handler, ListenOptions options = {}) {
+    // При помощи decay_t исключим ссылки из типа RequestHandler,
+    // чтобы Listener хранил RequestHandler по значению
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+    auto listener = std::make_shared<MyListener>(ioc, endpoint,
+                                                 std::forward<RequestHandler>(handler), options);
+    listener->Run();
+    return listener;
 }
 
 }  // namespace http_server
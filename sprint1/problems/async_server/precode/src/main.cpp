@@ -1,12 +1,20 @@
 #include "sdk.h"
 //
 #include <boost/asio/signal_set.hpp>
+#include <unistd.h>
+
+#include <charconv>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <vector>
 
+#include "hot_restart.h"
 #include "http_server.h"
+#include "io_context_pool.h"
+#include "request_target.h"
 
 namespace {
 namespace net = boost::asio;
@@ -14,8 +22,6 @@ using namespace std::literals;
 namespace sys = boost::system;
 namespace http = boost::beast::http;
 
-// Запрос, тело которого представлено в виде строки
-using StringRequest = http::request<http::string_body>;
 // Ответ, тело которого представлено в виде строки
 using StringResponse = http::response<http::string_body>;
 
@@ -37,9 +43,52 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
     return response;
 }
 
-StringResponse HandleRequest(StringRequest&& req) {
-    // Подставьте сюда код из синхронной версии HTTP-сервера
-    return MakeStringResponse(http::status::ok, "OK"sv, req.version(), req.keep_alive());
+bool IsAllowedMethod(http::verb method) {
+    return method == http::verb::get || method == http::verb::head;
+}
+
+// Возвращает имя из цели запроса вида /<имя>, не копируя строку запроса.
+// Имя декодируется в storage, только если содержит %-последовательности
+std::string_view GetName(std::string_view target, std::string& storage) {
+    // Удаляем ведущий символ '/', если он есть
+    const http_server::EncodedView name{target.substr(target.starts_with('/') ? 1 : 0)};
+    try {
+        return name.Decode(storage);
+    } catch (const std::invalid_argument&) {
+        // Некорректно закодированное имя возвращаем как есть
+        return name.Raw();
+    }
+}
+
+// Обрабатывает GET- и HEAD-запросы
+template <typename Body, typename Fields>
+StringResponse HandleRequest(const http::request<Body, Fields>& req) {
+    std::string decoded_name;
+    const auto name = GetName(req.target(), decoded_name);
+    std::string body;
+    body.reserve("Hello, "sv.size() + name.size());
+    body.append("Hello, "sv).append(name);
+    if (req.method() == http::verb::head) {
+        // Тело не отправляем, но выставляем длину, как для GET
+        StringResponse response(http::status::ok, req.version());
+        response.set(http::field::content_type, ContentType::TEXT_HTML);
+        response.content_length(body.size());
+        response.keep_alive(req.keep_alive());
+        return response;
+    }
+    return MakeStringResponse(http::status::ok, body, req.version(), req.keep_alive());
+}
+
+// Ответ на запросы с неподдерживаемым методом не зависит от запроса,
+// поэтому сериализуется один раз
+const http_server::StaticResponse& GetMethodNotAllowedResponse() {
+    static const http_server::StaticResponse response = [] {
+        StringResponse res = MakeStringResponse(http::status::method_not_allowed,
+                                                "Invalid method"sv, 11, true);
+        res.set(http::field::allow, "GET, HEAD"sv);
+        return http_server::StaticResponse{std::move(res)};
+    }();
+    return response;
 }
 
 // Запускает функцию fn на n потоках, включая текущий
@@ -55,25 +104,195 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
-}  // namespace
+// По этому пути сервер вместо приветствия возвращает свои метрики
+constexpr std::string_view METRICS_PATH = "/metrics"sv;
 
-int main() {
-    const unsigned num_threads = std::thread::hardware_concurrency();
+// Время, которое даётся сеансам на завершение при плавной остановке сервера
+constexpr auto DRAIN_TIMEOUT = 30s;
 
-    net::io_context ioc(num_threads);
+/*
+ * Останавливает и перезапускает сервер по сигналам.
+ * SIGINT и SIGTERM плавно останавливают сервер: он перестаёт принимать соединения
+ * и отвечает на уже полученные запросы. Повторный сигнал останавливает сервер сразу.
+ * SIGUSR2 запускает новую версию сервера, передаёт ей слушающие сокеты и плавно
+ * останавливает текущую, поэтому при обновлении сервера соединения не теряются.
+ */
+class SignalHandler {
+public:
+    using Listeners = std::vector<std::shared_ptr<http_server::ListenerBase>>;
 
-    // Подписываемся на сигналы и при их получении завершаем работу сервера
-    net::signal_set signals(ioc, SIGINT, SIGTERM);
-    signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
-        if (!ec) {
-            ioc.stop();
+    // argv передаётся новой версии сервера и должен жить не меньше обработчика
+    SignalHandler(net::io_context& ioc, Listeners listeners, const char* const argv[],
+                  std::function<void()> stop)
+        : ioc_{ioc}
+        , signals_{ioc, SIGINT, SIGTERM, SIGUSR2}
+        , listeners_{std::move(listeners)}
+        , argv_{argv}
+        , stop_{std::move(stop)} {
+        Wait();
+    }
+
+private:
+    void Wait() {
+        signals_.async_wait([this](const sys::error_code& ec, int signal_number) {
+            if (!ec) {
+                OnSignal(signal_number);
+                Wait();
+            }
+        });
+    }
+
+    void OnSignal(int signal_number) {
+        if (draining_) {
+            if (signal_number != SIGUSR2) {
+                stop_();
+            }
+            return;
         }
-    });
+        if (signal_number == SIGUSR2) {
+            std::vector<int> sockets;
+            for (const auto& listener : listeners_) {
+                sockets.push_back(listener->GetNativeHandle());
+            }
+            try {
+                http_server::SpawnWithSockets(argv_, sockets);
+            } catch (const std::exception& ex) {
+                // Новая версия не запустилась, поэтому текущая продолжает работу
+                std::cerr << "restart: "sv << ex.what() << std::endl;
+                return;
+            }
+        }
+        draining_ = true;
+        http_server::AsyncDrain(ioc_, listeners_, DRAIN_TIMEOUT, stop_);
+    }
 
+    net::io_context& ioc_;
+    net::signal_set signals_;
+    Listeners listeners_;
+    const char* const* argv_;
+    std::function<void()> stop_;
+    bool draining_ = false;
+};
+
+// Возвращает index-й из унаследованных сокетов, если он есть
+std::optional<int> GetInheritedSocket(const std::vector<int>& sockets, size_t index) {
+    return index < sockets.size() ? std::optional{sockets[index]} : std::nullopt;
+}
+
+// Закрывает унаследованные сокеты, для которых не нашлось слушателя. Иначе ядро
+// продолжило бы направлять в них часть новых соединений
+void CloseUnusedSockets(const std::vector<int>& sockets, size_t used) {
+    for (size_t i = used; i < sockets.size(); ++i) {
+        ::close(sockets[i]);
+    }
+}
+
+struct ServerArgs {
+    // Отдельный io_context и acceptor с SO_REUSEPORT на каждое ядро
+    bool io_per_core = false;
+    // Привязка потоков к ядрам, имеет смысл только вместе с io_per_core
+    bool pin_threads = false;
+    // Ограничения частоты запросов клиентов и количества запросов в обработке
+    http_server::AdmissionOptions admission;
+};
+
+// Разбирает число, занимающее всю строку str
+template <typename T>
+bool ParseNumber(std::string_view str, T& value) {
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc{} && end == str.data() + str.size();
+}
+
+std::optional<ServerArgs> ParseCommandLine(int argc, const char* const argv[]) {
+    ServerArgs args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--io-per-core"sv) {
+            args.io_per_core = true;
+        } else if (arg == "--pin-threads"sv) {
+            args.pin_threads = true;
+        } else if (arg == "--rate-limit"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.rate)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--rate-burst"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.burst)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--max-in-flight"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.max_in_flight)) {
+                return std::nullopt;
+            }
+        } else {
+            return std::nullopt;
+        }
+    }
+    return args;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+        std::cerr << "Usage: hello_async [--io-per-core [--pin-threads]] "sv
+                  << "[--rate-limit <requests/s> [--rate-burst <n>]] [--max-in-flight <n>]"sv
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const unsigned num_threads = std::thread::hardware_concurrency();
     const auto address = net::ip::make_address("0.0.0.0");
     constexpr net::ip::port_type port = 8080;
-    http_server::ServeHttp(ioc, {address, port}, [](auto&& req, auto&& sender) {
-        // sender(HandleRequest(std::forward<decltype(req)>(req)));
+    const auto handler = [](auto&& req, auto&& sender) {
+        if (!IsAllowedMethod(req.method())) {
+            return sender(GetMethodNotAllowedResponse().Prepare(req));
+        }
+        sender(HandleRequest(req));
+    };
+
+    // Сокеты, переданные предыдущей версией сервера при перезапуске
+    const auto inherited = http_server::TakeInheritedSockets();
+    // Ограничения общие для всех слушателей
+    const auto admission = args->admission.IsEnabled()
+                             ? std::make_shared<http_server::AdmissionControl>(args->admission)
+                             : nullptr;
+
+    if (args->io_per_core) {
+        http_server::IoContextPool pool(num_threads);
+        SignalHandler::Listeners listeners;
+        for (size_t i = 0; i < pool.Size(); ++i) {
+            listeners.push_back(http_server::ServeHttp(
+                pool.Get(i), {address, port}, handler,
+                {.reuse_port = true,
+                 .metrics_path = METRICS_PATH,
+                 .native_handle = GetInheritedSocket(inherited, i),
+                 .admission = admission}));
+        }
+        CloseUnusedSockets(inherited, pool.Size());
+
+        SignalHandler signal_handler(pool.Get(0), std::move(listeners), argv, [&pool] {
+            pool.Stop();
+        });
+
+        // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
+        std::cout << "Server has started..."sv << std::endl;
+        pool.Run(args->pin_threads);
+        return EXIT_SUCCESS;
+    }
+
+    net::io_context ioc(num_threads);
+
+    auto listener = http_server::ServeHttp(
+        ioc, {address, port}, handler,
+        {.metrics_path = METRICS_PATH,
+         .native_handle = GetInheritedSocket(inherited, 0),
+         .admission = admission});
+    CloseUnusedSockets(inherited, 1);
+
+    // Подписываемся на сигналы и при их получении завершаем работу сервера
+    SignalHandler signal_handler(ioc, {std::move(listener)}, argv, [&ioc] {
+        ioc.stop();
     });
 
     // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
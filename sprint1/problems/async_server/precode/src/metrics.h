@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace http_server {
+
+// Этапы обработки запроса, время которых измеряет сервер
+enum class Stage {
+    PARSE,   // от получения первых байтов запроса до окончания его разбора
+    HANDLE,  // от передачи запроса обработчику до получения ответа
+    WRITE,   // запись ответа в сокет
+};
+
+/*
+ * Гистограмма длительностей с логарифмическими корзинами, как в HDR Histogram:
+ * на каждую степень двойки приходится две корзины (границы 1, 2, 3, 4, 6, 8, 12... мкс),
+ * поэтому относительная погрешность квантилей не превышает 50% во всём диапазоне
+ * от микросекунды до 33 секунд.
+ * Записывать значения может только один поток, читать — любой.
+ */
+class LatencyHistogram {
+public:
+    // Верхние границы корзин в микросекундах. Последняя корзина не ограничена сверху
+    constexpr static auto BOUNDS = [] {
+        std::array<std::uint64_t, 50> bounds{1, 2};
+        for (size_t i = 2; i < bounds.size(); i += 2) {
+            const std::uint64_t octave = std::uint64_t{1} << (i / 2);
+            bounds[i] = octave + octave / 2;
+            bounds[i + 1] = octave * 2;
+        }
+        return bounds;
+    }();
+    constexpr static size_t BUCKET_COUNT = BOUNDS.size() + 1;
+
+    struct Snapshot {
+        std::array<std::uint64_t, BUCKET_COUNT> counts{};
+        std::uint64_t sum_us = 0;
+
+        Snapshot& operator+=(const Snapshot& other) noexcept;
+    };
+
+    void Record(std::chrono::microseconds duration) noexcept;
+    Snapshot GetSnapshot() const noexcept;
+
+private:
+    // Значение меняет только поток-владелец, поэтому вместо атомарного инкремента
+    // достаточно чтения и записи с memory_order_relaxed
+    static void Increment(std::atomic<std::uint64_t>& counter, std::uint64_t delta) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> counts_{};
+    std::atomic<std::uint64_t> sum_us_{0};
+};
+
+/*
+ * Метрики HTTP-сервера.
+ * Каждый поток пишет в собственный набор гистограмм без блокировок. Мьютекс захватывается
+ * только при первой записи из нового потока и при формировании отчёта, когда гистограммы
+ * всех потоков суммируются.
+ */
+class Metrics {
+public:
+    constexpr static size_t STAGE_COUNT = 3;
+
+    static Metrics& Instance();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    template <typename Rep, typename Period>
+    void Record(Stage stage, std::chrono::duration<Rep, Period> duration) noexcept {
+        GetLocal()[static_cast<size_t>(stage)].Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(duration));
+    }
+
+    // Выводит гистограммы всех этапов в текстовом формате Prometheus
+    void WritePrometheus(std::ostream& out) const;
+
+private:
+    using StageHistograms = std::array<LatencyHistogram, STAGE_COUNT>;
+
+    Metrics() = default;
+
+    StageHistograms& GetLocal() noexcept;
+
+    mutable std::mutex mutex_;
+    // Гистограммы завершившихся потоков сохраняются, чтобы не терять их значения
+    std::vector<std::unique_ptr<StageHistograms>> threads_;
+};
+
+}  // namespace http_server
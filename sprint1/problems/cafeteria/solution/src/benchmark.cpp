@@ -0,0 +1,168 @@
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cafeteria.h"
+
+/*
+Бенчмарк кафетерия: одновременно заказывает num_orders хот-догов из num_threads потоков
+и выводит пропускную способность, задержки заказов, время ожидания горелок и их загрузку.
+Собирается с CAFETERIA_VIRTUAL_CLOCK, поэтому все длительности измеряются ускоренными
+часами VirtualClock, и прогон с тысячами заказов занимает секунды.
+
+Запуск: cafeteria_benchmark [заказы] [потоки] [горелки] [ускорение] [размер партии] [плиты]
+Размер партии 0 означает, что каждый хот-дог заказывается отдельно через OrderHotDog.
+Горелки задаются на одну плиту.
+*/
+
+using namespace std::literals;
+
+namespace {
+
+struct Options {
+    int num_orders = 1000;
+    unsigned num_threads = 4;
+    int num_burners = 8;
+    double speed = 20;
+    int batch_size = 0;
+    int num_cookers = 1;
+};
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    const auto arg = [argc, argv](int index, auto default_value) {
+        return index < argc ? static_cast<decltype(default_value)>(std::atof(argv[index]))
+                            : default_value;
+    };
+    options.num_orders = std::max(1, arg(1, options.num_orders));
+    options.num_threads = std::max(1u, arg(2, options.num_threads));
+    options.num_burners = std::max(1, arg(3, options.num_burners));
+    options.speed = std::max(1.0, arg(4, options.speed));
+    options.batch_size = std::max(0, arg(5, options.batch_size));
+    options.num_cookers = std::max(1, arg(6, options.num_cookers));
+    return options;
+}
+
+// Результаты заказов. Обработчики кафетерия вызываются из разных потоков
+struct Results {
+    std::mutex mutex;
+    std::vector<Clock::duration> latencies;
+    // Суммарное время занятости горелок хлебом и сосисками приготовленных хот-догов
+    Clock::duration burner_time{};
+    int failed = 0;
+    Clock::time_point last_done{};
+
+    void Add(const Result<HotDog>& result, Clock::time_point ordered) {
+        const auto now = Clock::now();
+        std::lock_guard lock{mutex};
+        last_done = std::max(last_done, now);
+        if (!result.HasValue()) {
+            ++failed;
+            return;
+        }
+        const auto& hot_dog = result.GetValue();
+        latencies.push_back(now - ordered);
+        burner_time +=
+            hot_dog.GetBread().GetBakingDuration() + hot_dog.GetSausage().GetCookDuration();
+    }
+};
+
+double ToSeconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+double ToMilliseconds(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+Clock::duration GetPercentile(const std::vector<Clock::duration>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return {};
+    }
+    const auto index = static_cast<size_t>(fraction * (sorted.size() - 1));
+    return sorted[index];
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const Options options = ParseOptions(argc, argv);
+    VirtualClock::SetSpeed(options.speed);
+
+    net::io_context io{static_cast<int>(options.num_threads)};
+    Cafeteria cafeteria{io, options.num_burners, options.num_cookers};
+    Results results;
+    results.latencies.reserve(options.num_orders);
+
+    const auto start_time = Clock::now();
+    const auto real_start_time = std::chrono::steady_clock::now();
+    if (options.batch_size == 0) {
+        for (int i = 0; i < options.num_orders; ++i) {
+            net::post(io, [&cafeteria, &results] {
+                cafeteria.OrderHotDog([&results, ordered = Clock::now()](Result<HotDog> result) {
+                    results.Add(result, ordered);
+                });
+            });
+        }
+    } else {
+        for (int ordered = 0; ordered < options.num_orders; ordered += options.batch_size) {
+            const int count = std::min(options.batch_size, options.num_orders - ordered);
+            net::post(io, [&cafeteria, &results, count] {
+                const auto ordered = Clock::now();
+                cafeteria.OrderHotDogs(count, [&results, ordered](Result<HotDog> result) {
+                    results.Add(result, ordered);
+                });
+            });
+        }
+    }
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned i = 1; i < options.num_threads; ++i) {
+            workers.emplace_back([&io] {
+                io.run();
+            });
+        }
+        io.run();
+    }
+
+    const auto real_duration = std::chrono::steady_clock::now() - real_start_time;
+    const auto duration = results.last_done - start_time;
+    auto& latencies = results.latencies;
+    std::sort(latencies.begin(), latencies.end());
+    const auto stats = cafeteria.GetGasCookers().GetStats();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Orders: " << options.num_orders << ", threads: " << options.num_threads
+              << ", cookers: " << options.num_cookers << ", burners: " << options.num_burners
+              << ", batch: " << options.batch_size
+              << ", clock speed: " << options.speed << "x" << std::endl;
+    std::cout << "Cooked: " << latencies.size() << ", failed: " << results.failed
+              << ", virtual time: " << ToSeconds(duration) << "s"
+              << ", real time: " << ToSeconds(real_duration) << "s" << std::endl;
+    std::cout << "Throughput: " << latencies.size() / std::max(ToSeconds(duration), 1e-9)
+              << " orders/s" << std::endl;
+    std::cout << "Latency p50: " << ToMilliseconds(GetPercentile(latencies, 0.5))
+              << "ms, p99: " << ToMilliseconds(GetPercentile(latencies, 0.99))
+              << "ms, max: " << ToMilliseconds(GetPercentile(latencies, 1.0)) << "ms"
+              << std::endl;
+    const Clock::duration mean_queue_delay =
+        stats.queued == 0 ? Clock::duration{}
+                          : stats.total_queue_delay / static_cast<Clock::rep>(stats.queued);
+    std::cout << "Burner queue: " << stats.queued << " waits, mean "
+              << ToMilliseconds(mean_queue_delay) << "ms, max "
+              << ToMilliseconds(stats.max_queue_delay) << "ms, stolen " << stats.stolen << std::endl;
+    const double capacity = ToSeconds(duration) * cafeteria.GetGasCookers().GetBurnerCount();
+    std::cout << "Burner utilisation: "
+              << 100 * ToSeconds(results.burner_time) / std::max(capacity, 1e-9) << "%"
+              << std::endl;
+}
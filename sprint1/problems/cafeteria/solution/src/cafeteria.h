@@ -3,204 +3,212 @@
 #include <sdkddkver.h>
 #endif
 
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
 #include <boost/asio/io_context.hpp>
-#include <boost/asio/steady_timer.hpp>
-#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
 #include <memory>
 #include <atomic>      // для счётчика ID
+#include <vector>
 
+#include "cooking_timer.h"
+#include "gascooker_group.h"
 #include "hotdog.h"
+#include "inplace_function.h"
+#include "pool_allocator.h"
 #include "result.h"
 
 namespace net = boost::asio;
 namespace sys = boost::system;
 
-// Функция-обработчик операции приготовления хот-дога
-using HotDogHandler = std::function<void(Result<HotDog> hot_dog)>;
+// Функция-обработчик операции приготовления хот-дога.
+// Хранится внутри сеанса приготовления, поэтому не выделяет память
+using HotDogHandler = InplaceFunction<void(Result<HotDog> hot_dog), 64>;
 
-// Класс, управляющий асинхронным приготовлением одного хот-дога
+// Сопрограммы приготовления выполняются в исполнителе io_context без стирания типа, поэтому их
+// обработчики помещаются в InplaceFunction ингредиентов и таймера
+using CookingExecutor = net::io_context::executor_type;
+template <typename T = void>
+using CookingAwaitable = net::awaitable<T, CookingExecutor>;
+constexpr net::use_awaitable_t<CookingExecutor> use_cooking_awaitable;
+
+// Класс, управляющий асинхронным приготовлением одного хот-дога.
+// Приготовление выполняется сопрограммой: хлеб и сосиска готовятся параллельно, а окончание
+// их приготовления отсчитывает timer, который может быть общим для нескольких сеансов
 class CookingSession : public std::enable_shared_from_this<CookingSession> {
 public:
     CookingSession(net::io_context& io,
                    std::shared_ptr<GasCooker> cooker,
+                   std::shared_ptr<CookingTimer> timer,
                    std::shared_ptr<Bread> bread,
                    std::shared_ptr<Sausage> sausage,
                    HotDogHandler handler,
-                   int hotdog_id)
+                   int hotdog_id,
+                   GasCooker::Ticket ticket = {})
         : io_(io)
-        , strand_(net::make_strand(io))
         , cooker_(std::move(cooker))
+        , timer_(std::move(timer))
         , bread_(std::move(bread))
         , sausage_(std::move(sausage))
         , user_handler_(std::move(handler))
         , hotdog_id_(hotdog_id)
-        , timer_bread_(io)
-        , timer_sausage_(io) {
+        , ticket_(ticket) {
     }
 
     void Start() {
-        net::dispatch(strand_, [self = shared_from_this()] {
-            self->StartImpl();
-        });
+        // Лямбда-функция хранится в кадре сопрограммы и продлевает время жизни сеанса
+        net::co_spawn(
+            io_.get_executor(),
+            [self = shared_from_this()]() -> CookingAwaitable<> {
+                co_await self->Cook();
+            },
+            net::detached);
     }
 
 private:
-    void StartImpl() {
-        try {
-            bread_->StartBake(*cooker_, [self = shared_from_this()] {
-                net::post(self->strand_, [self] { self->OnBreadStarted(); });
-            });
-            bread_invoked_ = true;
-        } catch (...) {
-            OnError(std::current_exception());
-            return;
-        }
+    CookingAwaitable<> Cook() {
+        using namespace net::experimental::awaitable_operators;
 
+        // Ветви работают с разными ингредиентами, поэтому им не нужен общий strand.
+        // Если одна из ветвей завершится ошибкой, оператор && дождётся второй ветви и
+        // выбросит исключение первой
+        std::exception_ptr error;
         try {
-            sausage_->StartFry(*cooker_, [self = shared_from_this()] {
-                net::post(self->strand_, [self] { self->OnSausageStarted(); });
-            });
-            sausage_invoked_ = true;
+            co_await (CookBread() && CookSausage());
         } catch (...) {
-            OnError(std::current_exception());
-            return;
+            error = std::current_exception();
         }
-    }
 
-    void OnBreadStarted() {
-        if (error_) {
-            // Уже произошла ошибка, освобождаем горелку и завершаем
+        if (error) {
+            // Освобождаем горелки, если ингредиенты начали готовиться, но не закончили.
+            // Для неначатых и уже готовых ингредиентов Stop* выбрасывают исключение
             try { bread_->StopBaking(); } catch (...) {}
-            return;
-        }
-        bread_started_ = true;
-        timer_bread_.expires_after(HotDog::MIN_BREAD_COOK_DURATION);
-        timer_bread_.async_wait([self = shared_from_this()](sys::error_code ec) {
-            net::post(self->strand_, [self, ec] { self->OnBreadTimer(ec); });
-        });
-    }
-
-    void OnSausageStarted() {
-        if (error_) {
             try { sausage_->StopFry(); } catch (...) {}
-            return;
+            user_handler_(Result<HotDog>(error));
+            co_return;
         }
-        sausage_started_ = true;
-        timer_sausage_.expires_after(HotDog::MIN_SAUSAGE_COOK_DURATION);
-        timer_sausage_.async_wait([self = shared_from_this()](sys::error_code ec) {
-            net::post(self->strand_, [self, ec] { self->OnSausageTimer(ec); });
-        });
-    }
 
-    void OnBreadTimer(sys::error_code ec) {
-        if (ec == net::error::operation_aborted || error_) return;
-        try {
-            bread_->StopBaking();
-        } catch (...) {
-            OnError(std::current_exception());
-            return;
-        }
-        bread_done_ = true;
-        CheckDone();
+        user_handler_(MakeHotDog());
     }
 
-    void OnSausageTimer(sys::error_code ec) {
-        if (ec == net::error::operation_aborted || error_) return;
+    // Собирает хот-дог из приготовленных ингредиентов. Брак - ожидаемый исход, поэтому
+    // он передаётся кодом ошибки, а исключением - только непредвиденная ошибка
+    Result<HotDog> MakeHotDog() const {
         try {
-            sausage_->StopFry();
+            return HotDog::Make(hotdog_id_, sausage_, bread_);
         } catch (...) {
-            OnError(std::current_exception());
-            return;
+            return Result<HotDog>::FromCurrentException();
         }
-        sausage_done_ = true;
-        CheckDone();
     }
 
-    void CheckDone() {
-        if (error_) return;
-        if (bread_done_ && sausage_done_) {
-            try {
-                HotDog hd(hotdog_id_, sausage_, bread_);
-                user_handler_(Result<HotDog>(std::move(hd)));
-            } catch (...) {
-                user_handler_(Result<HotDog>::FromCurrentException());
-            }
-            error_ = true;   // предотвращаем повторный вызов
-        }
+    CookingAwaitable<> CookBread() {
+        co_await bread_->AsyncStartBake(*cooker_, ticket_, use_cooking_awaitable);
+        co_await timer_->AsyncWait(HotDog::MIN_BREAD_COOK_DURATION, use_cooking_awaitable);
+        bread_->StopBaking();
     }
 
-    void OnError(std::exception_ptr ex) {
-        if (error_) return;
-        error_ = true;
-
-        // Отменяем таймеры
-        timer_bread_.cancel();
-        timer_sausage_.cancel();
-
-        // Освобождаем горелки, если ингредиенты уже начали готовиться, но ещё не закончили
-        if (bread_started_ && !bread_done_) {
-            try { bread_->StopBaking(); } catch (...) {}
-        }
-        if (sausage_started_ && !sausage_done_) {
-            try { sausage_->StopFry(); } catch (...) {}
-        }
-
-        user_handler_(Result<HotDog>(ex));
+    CookingAwaitable<> CookSausage() {
+        co_await sausage_->AsyncStartFry(*cooker_, ticket_, use_cooking_awaitable);
+        co_await timer_->AsyncWait(HotDog::MIN_SAUSAGE_COOK_DURATION, use_cooking_awaitable);
+        sausage_->StopFry();
     }
 
     net::io_context& io_;
-    net::strand<net::io_context::executor_type> strand_;
     std::shared_ptr<GasCooker> cooker_;
+    std::shared_ptr<CookingTimer> timer_;
     std::shared_ptr<Bread> bread_;
     std::shared_ptr<Sausage> sausage_;
     HotDogHandler user_handler_;
     int hotdog_id_;
-
-    net::steady_timer timer_bread_;
-    net::steady_timer timer_sausage_;
-
-    bool bread_invoked_ = false;
-    bool sausage_invoked_ = false;
-    bool bread_started_ = false;
-    bool sausage_started_ = false;
-    bool bread_done_ = false;
-    bool sausage_done_ = false;
-    bool error_ = false;
+    // Очерёдность ожидания горелок
+    GasCooker::Ticket ticket_;
 };
 
 // Класс "Кафетерий". Готовит хот-доги
 class Cafeteria {
 public:
-    explicit Cafeteria(net::io_context& io)
+    // Кафетерий с num_cookers газовыми плитами по num_burners горелок
+    explicit Cafeteria(net::io_context& io, int num_burners = 8, int num_cookers = 1)
         : io_{io}
-        , strand_{net::make_strand(io)}   // добавляем strand
+        , gas_cookers_{io, num_cookers, num_burners}
         , next_hotdog_id_{1} {
     }
 
     // Асинхронно готовит хот-дог и вызывает handler, как только хот-дог будет готов.
+    // Хот-дог готовится на наименее загруженной плите.
+    // Заказы одного класса priority получают горелки поровну.
     // Этот метод может быть вызван из произвольного потока
-    void OrderHotDog(HotDogHandler handler) {
-        // Получение ингредиентов выполняется последовательно через strand
-        net::dispatch(strand_, [this, handler = std::move(handler)]() mutable {
-            auto bread = store_.GetBread();
-            auto sausage = store_.GetSausage();
-            int hotdog_id = next_hotdog_id_++;   // atomic, безопасно
-            auto session = std::make_shared<CookingSession>(
-                io_, gas_cooker_, std::move(bread), std::move(sausage), std::move(handler), hotdog_id
+    void OrderHotDog(HotDogHandler handler, Priority priority = Priority::NORMAL) {
+        // Склад и счётчик id потокобезопасны, поэтому заказ не проходит через общий strand
+        auto bread = store_.GetBread();
+        auto sausage = store_.GetSausage();
+        int hotdog_id = next_hotdog_id_++;   // atomic, безопасно
+        // Одиночному заказу не с кем объединять сроки, поэтому таймер срабатывает точно
+        auto timer = std::allocate_shared<CookingTimer>(timer_allocator_, io_,
+                                                        Clock::duration::zero());
+        // Сеанс размещается в блоке, освобождённом одним из завершившихся сеансов
+        auto session = std::allocate_shared<CookingSession>(
+            session_allocator_, io_, gas_cookers_.Pick(), std::move(timer), std::move(bread),
+            std::move(sausage), std::move(handler), hotdog_id,
+            GasCooker::Ticket{priority, static_cast<GasCooker::CustomerId>(hotdog_id)}
+        );
+        session->Start();   // запуск сопрограммы приготовления
+    }
+
+    // Асинхронно готовит count хот-догов и вызывает handler для каждого из них, как только он
+    // будет готов. handler может вызываться параллельно из разных потоков.
+    // Ингредиенты всей партии берутся со склада одним запросом, а сроки приготовления
+    // отсчитывает общий таймер, объединяющий сроки, отстоящие не более чем на BATCH_TIMER_SLACK.
+    // Вся партия считается одним клиентом газовой плиты, поэтому при нехватке горелок
+    // она получает их наравне с другими заказами своего класса priority, а не все сразу.
+    // Горелки партия ещё не запросила, поэтому загрузка плит не учитывает её хот-доги:
+    // они распределяются по плитам по кругу, начиная с наименее загруженной.
+    // Этот метод может быть вызван из произвольного потока
+    void OrderHotDogs(int count, HotDogHandler handler, Priority priority = Priority::NORMAL) {
+        if (count <= 0) {
+            return;
+        }
+        auto breads = store_.GetBreads(count);
+        auto sausages = store_.GetSausages(count);
+        const int first_id = next_hotdog_id_.fetch_add(count);
+        auto timer = std::allocate_shared<CookingTimer>(timer_allocator_, io_, BATCH_TIMER_SLACK);
+        // Обработчик общий для всей партии
+        auto shared_handler = std::make_shared<HotDogHandler>(std::move(handler));
+        const GasCooker::Ticket ticket{priority, static_cast<GasCooker::CustomerId>(first_id)};
+        const size_t first_cooker = gas_cookers_.PickIndex();
+        for (int i = 0; i < count; ++i) {
+            auto session = std::allocate_shared<CookingSession>(
+                session_allocator_, io_, gas_cookers_.Get((first_cooker + i) % gas_cookers_.GetSize()),
+                timer, std::move(breads[i]), std::move(sausages[i]),
+                [shared_handler](Result<HotDog> hot_dog) {
+                    (*shared_handler)(std::move(hot_dog));
+                },
+                first_id + i, ticket
             );
-            session->Start();   // запуск сессии (внутри использует свой strand)
-        });
+            session->Start();
+        }
+    }
+
+    // Допустимая задержка окончания приготовления ингредиентов в партии. Она намного меньше
+    // разброса допустимого времени приготовления хлеба и сосиски
+    constexpr static Clock::duration BATCH_TIMER_SLACK = Milliseconds{100};
+
+    const GasCookerGroup& GetGasCookers() const noexcept {
+        return gas_cookers_;
     }
 
 private:
     net::io_context& io_;
     // Используется для создания ингредиентов хот-дога
     Store store_;
-    // Газовая плита. По условию задачи в кафетерии есть только одна газовая плита на 8 горелок
-    // Используйте её для приготовления ингредиентов хот-дога.
-    // Плита создаётся с помощью make_shared, так как GasCooker унаследован от
-    // enable_shared_from_this.
-    std::shared_ptr<GasCooker> gas_cooker_ = std::make_shared<GasCooker>(io_);
+    // Газовые плиты. По условию задачи в кафетерии есть только одна газовая плита на 8 горелок,
+    // бенчмарк может задать другое количество плит и горелок.
+    // Используйте их для приготовления ингредиентов хот-дога
+    GasCookerGroup gas_cookers_;
     std::atomic<int> next_hotdog_id_;
-    net::strand<net::io_context::executor_type> strand_;   // для синхронизации доступа к store_
+    // Память под сеансы приготовления используется повторно
+    PoolAllocator<CookingSession> session_allocator_{std::make_shared<BlockPool>()};
+    PoolAllocator<CookingTimer> timer_allocator_{std::make_shared<BlockPool>()};
 };
@@ -1,5 +1,19 @@
 #pragma once
+#include <boost/asio/wait_traits.hpp>
 #include <chrono>
 
+#ifdef CAFETERIA_VIRTUAL_CLOCK
+#include "virtual_clock.h"
+
+// Бенчмарк отсчитывает время ускоренными часами, чтобы не ждать реального приготовления
+using Clock = VirtualClock;
+using TimerClock = VirtualClock;
+using TimerWaitTraits = VirtualClock::WaitTraits;
+#else
 using Clock = std::chrono::high_resolution_clock;
+// Часы таймеров приготовления. Не зависят от перевода системного времени
+using TimerClock = std::chrono::steady_clock;
+using TimerWaitTraits = boost::asio::wait_traits<TimerClock>;
+#endif
+
 using Milliseconds = std::chrono::milliseconds;
\ No newline at end of file
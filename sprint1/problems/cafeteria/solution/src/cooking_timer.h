@@ -0,0 +1,121 @@
+#pragma once
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <algorithm>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/basic_waitable_timer.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "clock.h"
+#include "inplace_function.h"
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+
+/*
+Таймер, выполняющий несколько отложенных действий с помощью одного таймера asio.
+Срок срабатывания действия может быть отодвинут не более чем на slack, чтобы сработать вместе
+с другими действиями. Поэтому действия, сроки которых отстоят друг от друга не более чем на
+slack, выполняются за одно пробуждение таймера.
+Методы класса можно вызывать из разных потоков.
+*/
+class CookingTimer : public std::enable_shared_from_this<CookingTimer> {
+public:
+    // Вмещает указатель на сеанс приготовления
+    using Action = InplaceFunction<void(), 32>;
+
+    CookingTimer(net::io_context& io, TimerClock::duration slack)
+        : strand_{net::make_strand(io)}
+        , timer_{strand_}
+        , slack_{slack} {
+    }
+
+    CookingTimer(const CookingTimer&) = delete;
+    CookingTimer& operator=(const CookingTimer&) = delete;
+
+    // Выполняет action не раньше, чем через delay. Действие должно выполняться быстро,
+    // так как выполняется в strand таймера, например отправляя обработчик в другой strand
+    void ScheduleAfter(TimerClock::duration delay, Action action) {
+        const auto deadline = TimerClock::now() + delay;
+        net::dispatch(strand_,
+                      [self = shared_from_this(), deadline, action = std::move(action)]() mutable {
+                          self->actions_.push_back({deadline, std::move(action)});
+                          std::push_heap(self->actions_.begin(), self->actions_.end(), IsLater);
+                          self->Arm();
+                      });
+    }
+
+    // Асинхронно ждёт delay. Обработчик продолжает работу в своём исполнителе,
+    // поэтому вызов можно ожидать через co_await timer.AsyncWait(delay, net::use_awaitable)
+    template <typename CompletionToken>
+    auto AsyncWait(TimerClock::duration delay, CompletionToken&& token) {
+        return net::async_initiate<CompletionToken, void()>(
+            [self = shared_from_this()](auto handler, TimerClock::duration delay) {
+                self->ScheduleAfter(delay, [handler = std::move(handler)]() mutable {
+                    auto ex = net::get_associated_executor(handler);
+                    net::post(ex, std::move(handler));
+                });
+            },
+            token, delay);
+    }
+
+private:
+    struct Entry {
+        TimerClock::time_point deadline;
+        Action action;
+    };
+
+    // Упорядочивает кучу actions_ так, чтобы в её вершине было ближайшее действие
+    static bool IsLater(const Entry& lhs, const Entry& rhs) noexcept {
+        return lhs.deadline > rhs.deadline;
+    }
+
+    void Arm() {
+        if (actions_.empty()) {
+            return;
+        }
+        const auto fire_at = actions_.front().deadline + slack_;
+        if (armed_ && fire_at >= timer_.expiry()) {
+            // Таймер сработает раньше и выполнит это действие, если его срок уже наступит
+            return;
+        }
+        // Перезапуск отменяет прежнее ожидание, его обработчик получит operation_aborted
+        armed_ = true;
+        timer_.expires_at(fire_at);
+        timer_.async_wait(
+            net::bind_executor(strand_, [self = shared_from_this()](sys::error_code ec) {
+                self->OnTimer(ec);
+            }));
+    }
+
+    void OnTimer(sys::error_code ec) {
+        if (ec == net::error::operation_aborted) {
+            return;
+        }
+        armed_ = false;
+        const auto now = TimerClock::now();
+        while (!actions_.empty() && actions_.front().deadline <= now) {
+            std::pop_heap(actions_.begin(), actions_.end(), IsLater);
+            Action action = std::move(actions_.back().action);
+            actions_.pop_back();
+            action();
+        }
+        Arm();
+    }
+
+    net::strand<net::io_context::executor_type> strand_;
+    net::basic_waitable_timer<TimerClock, TimerWaitTraits> timer_;
+    TimerClock::duration slack_;
+    // Куча отложенных действий. Изменяется только в strand_
+    std::vector<Entry> actions_;
+    bool armed_ = false;
+};
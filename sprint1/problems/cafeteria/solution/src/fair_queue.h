@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <unordered_map>
+
+// Класс очереди: заявки более высокого класса всегда обслуживаются раньше
+enum class Priority {
+    HIGH,
+    NORMAL,
+    LOW,
+};
+
+/*
+Очередь заявок с классами приоритета и справедливым распределением между клиентами.
+Внутри класса клиенты обслуживаются по кругу алгоритмом deficit round robin: за один обход
+клиент получает quantum заявок подряд, поэтому клиент с большим количеством заявок
+не задерживает остальных дольше, чем на quantum заявок.
+Все заявки имеют одинаковую стоимость, поэтому Push и Pop выполняются за O(1)
+(амортизированно, с учётом хеш-таблицы клиентов).
+Класс не синхронизирован.
+*/
+template <typename T>
+class FairQueue {
+public:
+    using CustomerId = std::uint64_t;
+
+    explicit FairQueue(unsigned quantum = 1) noexcept
+        : quantum_{quantum == 0 ? 1 : quantum} {
+    }
+
+    bool IsEmpty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    void Push(Priority priority, CustomerId customer, T value) {
+        auto& level = levels_[static_cast<size_t>(priority)];
+        auto [it, inserted] = level.customers.try_emplace(customer);
+        it->second.items.push_back(std::move(value));
+        if (inserted) {
+            level.active.push_back(customer);
+        }
+        ++size_;
+    }
+
+    // Извлекает очередную заявку. Бросает logic_error, если очередь пуста
+    T Pop() {
+        for (auto& level : levels_) {
+            if (level.active.empty()) {
+                continue;
+            }
+            const CustomerId customer = level.active.front();
+            auto it = level.customers.find(customer);
+            assert(it != level.customers.end());
+            auto& queue = it->second;
+            if (queue.deficit == 0) {
+                // Клиент начинает новый обход
+                queue.deficit = quantum_;
+            }
+            T value = std::move(queue.items.front());
+            queue.items.pop_front();
+            --queue.deficit;
+            --size_;
+
+            if (queue.items.empty()) {
+                // У клиента не осталось заявок, он выходит из обхода
+                level.active.pop_front();
+                level.customers.erase(it);
+            } else if (queue.deficit == 0) {
+                // Клиент исчерпал свою долю и уступает очередь следующему
+                level.active.pop_front();
+                level.active.push_back(customer);
+            }
+            return value;
+        }
+        throw std::logic_error("Fair queue is empty");
+    }
+
+private:
+    struct CustomerQueue {
+        std::deque<T> items;
+        // Сколько заявок клиент ещё может получить в текущем обходе
+        unsigned deficit = 0;
+    };
+
+    struct Level {
+        std::unordered_map<CustomerId, CustomerQueue> customers;
+        // Клиенты с заявками в порядке обхода
+        std::deque<CustomerId> active;
+    };
+
+    unsigned quantum_;
+    std::array<Level, 3> levels_;
+    size_t size_ = 0;
+};
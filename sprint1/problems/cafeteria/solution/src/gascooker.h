@@ -5,93 +5,259 @@
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <deque>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#include "clock.h"
+#include "fair_queue.h"
+#include "inplace_function.h"
 
 namespace net = boost::asio;
 namespace sys = boost::system;
 
+// Чей запрос занимает горелку. Запросы одного клиента обслуживаются по очереди
+struct BurnerTicket {
+    using CustomerId = FairQueue<int>::CustomerId;
+
+    Priority priority = Priority::NORMAL;
+    CustomerId customer = 0;
+};
+
 /*
 Газовая плита - совместно используемый ресурс кафетерия
 Содержит несколько горелок (burner), которые можно асинхронно занимать (метод UseBurner) и
 освобождать (метод ReleaseBurner).
 Если свободных горелок нет, то запрос на занимание горелки ставится в очередь.
 Методы класса можно вызывать из разных потоков.
+
+Горелки учитываются как семафор в атомарном счётчике available_: пока свободные горелки
+есть, UseBurner и ReleaseBurner обходятся одной атомарной операцией, без захода в strand.
+Отрицательное значение счётчика — количество ожидающих обработчиков. Очередь ожидания
+обслуживается в strand только при нехватке горелок.
+
+Ожидающие обработчики получают горелки в порядке классов приоритета, а внутри класса —
+поровну между клиентами (см. FairQueue), поэтому большой заказ не задерживает маленькие.
+
+Плиты можно объединить в GasCookerGroup. Плита группы, у которой освободилась горелка,
+а своих ожидающих нет, забирает ожидающий обработчик соседней плиты и отдаёт ему горелку
+взаймы. Заём возвращается при следующем ReleaseBurner плиты-должника: горелки одинаковы,
+поэтому неважно, какой из её обработчиков освободил горелку.
 */
 class GasCooker : public std::enable_shared_from_this<GasCooker> {
 public:
-    using Handler = std::function<void()>;
+    // Вмещает обработчик ингредиента вместе с указателем на ингредиент
+    using Handler = InplaceFunction<void(), 64>;
+    using CustomerId = BurnerTicket::CustomerId;
+    using Ticket = BurnerTicket;
+
+    // Сколько горелок подряд получает клиент за один обход очереди: хлеб и сосиска одного
+    // хот-дога
+    constexpr static unsigned FAIR_SHARE_QUANTUM = 2;
+
+    // Статистика ожидания горелок
+    struct Stats {
+        // Количество обработчиков, ожидавших свободной горелки
+        std::uint64_t queued = 0;
+        // Суммарное и наибольшее время ожидания в очереди
+        Clock::duration total_queue_delay{};
+        Clock::duration max_queue_delay{};
+        // Сколько ожидавших обработчиков получили горелку соседней плиты группы
+        std::uint64_t stolen = 0;
+    };
 
     GasCooker(net::io_context& io, int num_burners = 8)
         : io_{io}
-        , number_of_burners_{num_burners} {
+        , number_of_burners_{num_burners}
+        , available_{num_burners} {
     }
 
     GasCooker(const GasCooker&) = delete;
     GasCooker& operator=(const GasCooker&) = delete;
 
     ~GasCooker() {
-        assert(burners_in_use_ == 0);
+        assert(available_ == number_of_burners_);
     }
 
     // Используется для того, чтобы занять горелку. handler будет вызван в момент, когда горелка
-    // занята
+    // занята. ticket определяет очерёдность, если горелку придётся ждать
     // Этот метод можно вызывать параллельно с вызовом других методов
-    void UseBurner(Handler handler) {
-        // Выполняем работу внутри strand, чтобы изменение состояния горелки выполнялось
-        // последовательно
-        net::dispatch(strand_,
-                      // За счёт захвата self в лямбда-функции, время жизни GasCooker будет продлено
-                      // до её вызова
-                      [handler = std::move(handler), self = shared_from_this(), this]() mutable {
-                          assert(strand_.running_in_this_thread());
-                          assert(burners_in_use_ >= 0 && burners_in_use_ <= number_of_burners_);
-
-                          // Есть свободные горелки?
-                          if (burners_in_use_ < number_of_burners_) {
-                              // Занимаем горелку
-                              ++burners_in_use_;
-                              // Асинхронно уведомляем обработчик о том, что горелка занята.
-                              // Используется асинхронный вызов, так как handler может
-                              // выполняться долго, а strand лучше освободить
-                              net::post(io_, std::move(handler));
-                          } else {  // Все горелки заняты
-                              // Ставим обработчик в хвост очереди
-                              pending_handlers_.emplace_back(std::move(handler));
-                          }
-
-                          // Проверка инвариантов класса
-                          assert(burners_in_use_ > 0 && burners_in_use_ <= number_of_burners_);
-                      });
+    void UseBurner(Handler handler, Ticket ticket = {}) {
+        const int available = available_.fetch_sub(1, std::memory_order_acq_rel);
+        assert(available <= number_of_burners_);
+        // Есть свободные горелки?
+        if (available > 0) {
+            // Горелка занята. Асинхронно уведомляем обработчик о том, что горелка занята.
+            // Используется асинхронный вызов, так как handler может выполняться долго
+            net::post(io_, std::move(handler));
+            return;
+        }
+
+        // Все горелки заняты: ставим обработчик в очередь ожидания.
+        // За счёт захвата self в лямбда-функции, время жизни GasCooker будет продлено
+        // до её вызова
+        net::dispatch(strand_, [handler = std::move(handler), self = shared_from_this(), this,
+                                ticket, enqueued = Clock::now()]() mutable {
+            assert(strand_.running_in_this_thread());
+            if (released_for_pending_ > 0) {
+                // Горелку уже освободили для этого обработчика раньше, чем он попал в strand
+                --released_for_pending_;
+                Dequeue(Pending{std::move(handler), enqueued});
+            } else {
+                // Ставим обработчик в очередь клиента
+                pending_handlers_.Push(ticket.priority, ticket.customer,
+                                       Pending{std::move(handler), enqueued});
+            }
+        });
     }
 
     void ReleaseBurner() {
-        // Освобождение выполняем также последовательно
-        net::dispatch(strand_, [this, self = shared_from_this()] {
+        // Должник сначала возвращает горелки, взятые взаймы у соседних плит
+        if (loans_.load(std::memory_order_acquire) > 0) {
+            if (auto lender = TakeLender()) {
+                lender->FreeBurner();
+                return;
+            }
+        }
+        FreeBurner();
+    }
+
+    // Количество свободных горелок минус количество ожидающих обработчиков.
+    // Значение может устареть сразу после чтения и годится только для балансировки
+    int GetAvailable() const noexcept {
+        return available_.load(std::memory_order_relaxed);
+    }
+
+    int GetBurnerCount() const noexcept {
+        return number_of_burners_;
+    }
+
+    // Статистику можно читать, когда обработчики плиты не выполняются,
+    // например после остановки io_context
+    const Stats& GetStats() const noexcept {
+        return stats_;
+    }
+
+private:
+    friend class GasCookerGroup;
+
+    struct Pending {
+        Handler handler;
+        // Момент вызова UseBurner
+        Clock::time_point enqueued;
+    };
+
+    void FreeBurner() {
+        const int available = available_.fetch_add(1, std::memory_order_acq_rel);
+        assert(available < number_of_burners_);
+        // Есть ли ожидающие обработчики?
+        if (available >= 0) {
+            StealWaiter();
+            return;
+        }
+        ServeWaiter();
+    }
+
+    // Передаёт горелку очередному ожидающему обработчику. Выполняется в strand
+    // последовательно с постановкой обработчиков в очередь.
+    // stolen - горелку дала соседняя плита
+    void ServeWaiter(bool stolen = false) {
+        net::dispatch(strand_, [this, self = shared_from_this(), stolen] {
             assert(strand_.running_in_this_thread());
-            assert(burners_in_use_ > 0 && burners_in_use_ <= number_of_burners_);
-
-            // Есть ли ожидающие обработчики?
-            if (!pending_handlers_.empty()) {
-                // Выполняем асинхронно обработчик первый обработчик
-                net::post(io_, std::move(pending_handlers_.front()));
-                // И удаляем его из очереди ожидания
-                pending_handlers_.pop_front();
+            stats_.stolen += stolen;
+            if (!pending_handlers_.IsEmpty()) {
+                // Выполняем асинхронно очередной обработчик, удаляя его из очереди ожидания
+                Dequeue(pending_handlers_.Pop());
             } else {
-                // Освобождаем горелку
-                --burners_in_use_;
+                // Обработчик уже учтён в счётчике, но ещё не добавлен в очередь
+                ++released_for_pending_;
             }
         });
     }
 
-private:
+    // Свободную горелку, которую не ждёт ни один свой обработчик, получает взаймы
+    // ожидающий обработчик соседней плиты
+    void StealWaiter() {
+        for (GasCooker* victim : siblings_) {
+            if (victim->available_.load(std::memory_order_relaxed) >= 0) {
+                continue;
+            }
+            // Занимаем свою горелку, если её ещё не занял UseBurner или другая кража
+            int available = available_.load(std::memory_order_relaxed);
+            do {
+                if (available <= 0) {
+                    return;
+                }
+            } while (!available_.compare_exchange_weak(available, available - 1,
+                                                       std::memory_order_acq_rel));
+            // Забираем у соседа одного ожидающего, как будто он освободил горелку
+            int victim_available = victim->available_.load(std::memory_order_relaxed);
+            do {
+                if (victim_available >= 0) {
+                    break;
+                }
+            } while (!victim->available_.compare_exchange_weak(
+                victim_available, victim_available + 1, std::memory_order_acq_rel));
+            if (victim_available < 0) {
+                victim->AddLender(shared_from_this());
+                victim->ServeWaiter(true);
+                return;
+            }
+            // Очередь соседа опустела раньше: возвращаем горелку себе
+            if (available_.fetch_add(1, std::memory_order_acq_rel) < 0) {
+                ServeWaiter();
+                return;
+            }
+        }
+    }
+
+    void AddLender(std::shared_ptr<GasCooker> lender) {
+        std::lock_guard lock{lenders_mutex_};
+        lenders_.push_back(std::move(lender));
+        loans_.fetch_add(1, std::memory_order_release);
+    }
+
+    std::shared_ptr<GasCooker> TakeLender() {
+        std::lock_guard lock{lenders_mutex_};
+        if (lenders_.empty()) {
+            return nullptr;
+        }
+        auto lender = std::move(lenders_.back());
+        lenders_.pop_back();
+        loans_.fetch_sub(1, std::memory_order_relaxed);
+        return lender;
+    }
+
+    // Передаёт горелку ожидавшему обработчику. Вызывается в strand_
+    void Dequeue(Pending pending) {
+        const auto delay = Clock::now() - pending.enqueued;
+        ++stats_.queued;
+        stats_.total_queue_delay += delay;
+        stats_.max_queue_delay = std::max(stats_.max_queue_delay, delay);
+        net::post(io_, std::move(pending.handler));
+    }
+
     using Strand = net::strand<net::io_context::executor_type>;
     net::io_context& io_;
     Strand strand_{net::make_strand(io_)};
     int number_of_burners_;
-    int burners_in_use_ = 0;
-    std::deque<Handler> pending_handlers_;
+    // Количество свободных горелок минус количество ожидающих обработчиков
+    std::atomic<int> available_;
+    // Поля ниже изменяются только в strand_
+    // Горелки, освобождённые для обработчиков, которые ещё не попали в очередь
+    int released_for_pending_ = 0;
+    FairQueue<Pending> pending_handlers_{FAIR_SHARE_QUANTUM};
+    Stats stats_;
+    // Другие плиты группы. Задаются GasCookerGroup до первого использования плиты
+    std::vector<GasCooker*> siblings_;
+    // Плиты, давшие горелки взаймы обработчикам этой плиты, по одной записи на заём
+    std::atomic<int> loans_{0};
+    std::mutex lenders_mutex_;
+    std::vector<std::shared_ptr<GasCooker>> lenders_;
 };
 
 // RAII-класс для автоматического освобождения газовой плиты
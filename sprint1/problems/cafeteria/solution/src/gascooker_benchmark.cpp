@@ -0,0 +1,105 @@
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <boost/asio/io_context.hpp>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "gascooker.h"
+#include "gascooker_group.h"
+
+/*
+Замеры распределения горелок GasCooker без приготовления: обработчик, получивший горелку,
+сразу её освобождает. Одна операция - requests запросов от customers клиентов
+к плите с burners горелками, io_context выполняется в текущем потоке до опустошения очереди.
+Пока запросов не больше горелок, UseBurner и ReleaseBurner обходятся атомарным счётчиком,
+иначе запросы ждут в FairQueue внутри strand.
+Замеры GasCookerGroup направляют все запросы на одну плиту группы, и их очередь разбирают
+горелки остальных плит.
+
+Запуск: gascooker_benchmark [параметры bench_harness.h]
+*/
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int BURNERS = 8;
+constexpr int GROUP_COOKERS = 4;
+
+struct Scenario {
+    const char* name;
+    int requests;
+    int customers;
+};
+
+constexpr Scenario SCENARIOS[]{
+    {"uncontended", BURNERS, BURNERS},
+    {"one-customer", 1000, 1},
+    {"many-customers", 1000, 100},
+};
+
+// Запросы клиентов в случайном порядке с разными приоритетами
+std::vector<GasCooker::Ticket> MakeTickets(const Scenario& scenario, std::mt19937_64& random) {
+    std::uniform_int_distribution<int> customer{0, scenario.customers - 1};
+    std::uniform_int_distribution<int> priority{0, 2};
+    std::vector<GasCooker::Ticket> tickets;
+    tickets.reserve(scenario.requests);
+    for (int i = 0; i < scenario.requests; ++i) {
+        tickets.push_back({static_cast<Priority>(priority(random)),
+                           static_cast<GasCooker::CustomerId>(customer(random))});
+    }
+    return tickets;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"gascooker", bench::ParseOptions(argc, argv)};
+    std::mt19937_64 random{suite.GetOptions().seed};
+
+    for (const auto& scenario : SCENARIOS) {
+        const auto tickets = MakeTickets(scenario, random);
+        net::io_context io;
+        const auto cooker = std::make_shared<GasCooker>(io, BURNERS);
+        suite.Run("GasCooker/"s + scenario.name + "/"s + std::to_string(scenario.requests), [&] {
+            int served = 0;
+            for (const auto& ticket : tickets) {
+                cooker->UseBurner(
+                    [&served, &cooker] {
+                        ++served;
+                        cooker->ReleaseBurner();
+                    },
+                    ticket);
+            }
+            io.restart();
+            io.run();
+            bench::DoNotOptimize(served);
+        });
+    }
+    for (const auto& scenario : SCENARIOS) {
+        const auto tickets = MakeTickets(scenario, random);
+        net::io_context io;
+        GasCookerGroup group{io, GROUP_COOKERS, BURNERS};
+        const auto& cooker = group.Get(0);
+        suite.Run("GasCookerGroup/"s + scenario.name + "/"s + std::to_string(scenario.requests), [&] {
+            int served = 0;
+            for (const auto& ticket : tickets) {
+                cooker->UseBurner(
+                    [&served, &cooker] {
+                        ++served;
+                        cooker->ReleaseBurner();
+                    },
+                    ticket);
+            }
+            io.restart();
+            io.run();
+            bench::DoNotOptimize(served);
+        });
+    }
+    return suite.Finish();
+}
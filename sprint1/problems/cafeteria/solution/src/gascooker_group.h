@@ -0,0 +1,99 @@
+#pragma once
+#ifdef _WIN32
+#include <sdkddkver.h>
+#endif
+
+#include <boost/asio/io_context.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "gascooker.h"
+
+/*
+Несколько газовых плит кафетерия. У каждой плиты свой strand, поэтому при нехватке горелок
+очереди ожидания разных плит обслуживаются параллельно, а не упираются в один strand.
+Заказы направляются на наименее загруженную плиту (PickIndex), а неравномерность, которая
+всё же возникает, выравнивают сами плиты: освободившаяся горелка без своих ожидающих
+достаётся ожидающему обработчику соседней плиты (см. GasCooker).
+Группа должна существовать, пока выполняются обработчики её плит.
+*/
+class GasCookerGroup {
+public:
+    GasCookerGroup(net::io_context& io, int num_cookers, int num_burners) {
+        assert(num_cookers > 0);
+        cookers_.reserve(num_cookers);
+        for (int i = 0; i < num_cookers; ++i) {
+            // make_shared, так как GasCooker унаследован от enable_shared_from_this
+            cookers_.push_back(std::make_shared<GasCooker>(io, num_burners));
+        }
+        for (const auto& cooker : cookers_) {
+            for (const auto& sibling : cookers_) {
+                if (sibling != cooker) {
+                    cooker->siblings_.push_back(sibling.get());
+                }
+            }
+        }
+    }
+
+    GasCookerGroup(const GasCookerGroup&) = delete;
+    GasCookerGroup& operator=(const GasCookerGroup&) = delete;
+
+    size_t GetSize() const noexcept {
+        return cookers_.size();
+    }
+
+    const std::shared_ptr<GasCooker>& Get(size_t index) const noexcept {
+        return cookers_[index];
+    }
+
+    // Индекс плиты, у которой больше всего свободных горелок, а если свободных нет ни у одной,
+    // то плиты с самой короткой очередью. Просмотр начинается с очередной плиты по кругу,
+    // чтобы одинаково загруженные плиты получали заказы поочерёдно.
+    // Этот метод можно вызывать из разных потоков
+    size_t PickIndex() noexcept {
+        const size_t size = cookers_.size();
+        const size_t start = next_.fetch_add(1, std::memory_order_relaxed) % size;
+        size_t best = start;
+        int best_available = cookers_[best]->GetAvailable();
+        for (size_t i = 1; i < size; ++i) {
+            const size_t index = (start + i) % size;
+            if (const int available = cookers_[index]->GetAvailable(); available > best_available) {
+                best = index;
+                best_available = available;
+            }
+        }
+        return best;
+    }
+
+    const std::shared_ptr<GasCooker>& Pick() noexcept {
+        return cookers_[PickIndex()];
+    }
+
+    int GetBurnerCount() const noexcept {
+        int count = 0;
+        for (const auto& cooker : cookers_) {
+            count += cooker->GetBurnerCount();
+        }
+        return count;
+    }
+
+    // Суммарная статистика плит. Её можно читать, когда обработчики плит не выполняются
+    GasCooker::Stats GetStats() const noexcept {
+        GasCooker::Stats total;
+        for (const auto& cooker : cookers_) {
+            const auto& stats = cooker->GetStats();
+            total.queued += stats.queued;
+            total.total_queue_delay += stats.total_queue_delay;
+            total.max_queue_delay = std::max(total.max_queue_delay, stats.max_queue_delay);
+            total.stolen += stats.stolen;
+        }
+        return total;
+    }
+
+private:
+    std::vector<std::shared_ptr<GasCooker>> cookers_;
+    std::atomic<size_t> next_{0};
+};
@@ -3,9 +3,54 @@
 #include <functional>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
 
 #include "gascooker.h"
 #include "ingredients.h"
+#include "result.h"
+
+// Причины, по которым хот-дог бракуется
+enum class HotDogError {
+    SAUSAGE_UNDERCOOKED = 1,
+    SAUSAGE_OVERCOOKED,
+    BREAD_UNDERBAKED,
+    BREAD_OVERBAKED,
+};
+
+class HotDogErrorCategory : public std::error_category {
+public:
+    const char* name() const noexcept override {
+        return "hot dog";
+    }
+
+    std::string message(int error) const override {
+        switch (static_cast<HotDogError>(error)) {
+            case HotDogError::SAUSAGE_UNDERCOOKED:
+                return "Sausage is undercooked";
+            case HotDogError::SAUSAGE_OVERCOOKED:
+                return "Sausage is overcooked";
+            case HotDogError::BREAD_UNDERBAKED:
+                return "Bread is underbaked";
+            case HotDogError::BREAD_OVERBAKED:
+                return "Bread is overbaked";
+        }
+        return "Unknown hot dog error";
+    }
+};
+
+inline const std::error_category& GetHotDogErrorCategory() noexcept {
+    static const HotDogErrorCategory category;
+    return category;
+}
+
+inline std::error_code make_error_code(HotDogError error) noexcept {
+    return {static_cast<int>(error), GetHotDogErrorCategory()};
+}
+
+template <>
+struct std::is_error_code_enum<HotDogError> : std::true_type {};
 
 /*
 Класс Хот-дог.
@@ -22,19 +67,43 @@ public:
     constexpr static Clock::duration MIN_BREAD_COOK_DURATION = Milliseconds{1000};
     constexpr static Clock::duration MAX_BREAD_COOK_DURATION = Milliseconds{1500};
 
+    // Если хот-дог бракуется, выбрасывает std::invalid_argument
     HotDog(int id, std::shared_ptr<Sausage> sausage, std::shared_ptr<Bread> bread)
         : id_{id}
         , sausage_{std::move(sausage)}
         , bread_{std::move(bread)} {
-        if (sausage_->GetCookDuration() < MIN_SAUSAGE_COOK_DURATION
-            || sausage_->GetCookDuration() > MAX_SAUSAGE_COOK_DURATION) {
-            throw std::invalid_argument("Invalid sausage cook duration");
+        if (const auto error = Validate(*sausage_, *bread_)) {
+            throw std::invalid_argument(error.message());
         }
+    }
 
-        if (bread_->GetBakingDuration() < MIN_BREAD_COOK_DURATION
-            || bread_->GetBakingDuration() > MAX_BREAD_COOK_DURATION) {
-            throw std::invalid_argument("Invalid sausage cook duration");
+    // Проверяет, годятся ли приготовленные ингредиенты для хот-дога.
+    // Возвращает нулевой код, если годятся, иначе - причину брака
+    static std::error_code Validate(const Sausage& sausage, const Bread& bread) {
+        const auto cook_duration = sausage.GetCookDuration();
+        if (cook_duration < MIN_SAUSAGE_COOK_DURATION) {
+            return HotDogError::SAUSAGE_UNDERCOOKED;
         }
+        if (cook_duration > MAX_SAUSAGE_COOK_DURATION) {
+            return HotDogError::SAUSAGE_OVERCOOKED;
+        }
+        const auto baking_duration = bread.GetBakingDuration();
+        if (baking_duration < MIN_BREAD_COOK_DURATION) {
+            return HotDogError::BREAD_UNDERBAKED;
+        }
+        if (baking_duration > MAX_BREAD_COOK_DURATION) {
+            return HotDogError::BREAD_OVERBAKED;
+        }
+        return {};
+    }
+
+    // Собирает хот-дог из приготовленных ингредиентов. Забракованный хот-дог возвращается
+    // кодом ошибки HotDogError без выброса исключения
+    static Result<HotDog> Make(int id, std::shared_ptr<Sausage> sausage, std::shared_ptr<Bread> bread) {
+        if (const auto error = Validate(*sausage, *bread)) {
+            return error;
+        }
+        return HotDog{UncheckedTag{}, id, std::move(sausage), std::move(bread)};
     }
 
     int GetId() const noexcept {
@@ -50,6 +119,15 @@ public:
     }
 
 private:
+    struct UncheckedTag {};
+
+    // Конструирует хот-дог из уже проверенных ингредиентов
+    HotDog(UncheckedTag, int id, std::shared_ptr<Sausage> sausage, std::shared_ptr<Bread> bread) noexcept
+        : id_{id}
+        , sausage_{std::move(sausage)}
+        , bread_{std::move(bread)} {
+    }
+
     int id_;
     std::shared_ptr<Sausage> sausage_;
     std::shared_ptr<Bread> bread_;
@@ -1,9 +1,16 @@
 #pragma once
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <atomic>
 #include <functional>
 #include <optional>
+#include <vector>
 
 #include "clock.h"
 #include "gascooker.h"
+#include "inplace_function.h"
+#include "pool_allocator.h"
 
 /*
 Класс "Сосиска".
@@ -11,7 +18,8 @@
 */
 class Sausage : public std::enable_shared_from_this<Sausage> {
 public:
-    using Handler = std::function<void()>;
+    // Обработчик хранится внутри обработчика GasCooker, поэтому он меньше его
+    using Handler = InplaceFunction<void(), 32>;
 
     explicit Sausage(int id)
         : id_{id} {
@@ -21,26 +29,37 @@ public:
         return id_;
     }
 
-    // Асинхронно начинает приготовление. Вызывает handler, как только началось приготовление
-    void StartFry(GasCooker& cooker, Handler handler) {
-        // Метод StartFry можно вызвать только один раз
-        if (frying_start_time_) {
-            throw std::logic_error("Frying already started");
-        }
-
-        // Запрещаем повторный вызов StartFry
-        frying_start_time_ = Clock::now();
-
-        // Готовимся занять газовую плиту
-        gas_cooker_lock_ = GasCookerLock{cooker.shared_from_this()};
+    // Асинхронно начинает приготовление. Вызывает handler, как только началось приготовление.
+    // ticket задаёт очерёдность ожидания горелки
+    void StartFry(GasCooker& cooker, Handler handler, GasCooker::Ticket ticket = {}) {
+        PrepareFry(cooker);
 
         // Занимаем горелку для начала обжаривания.
         // Чтобы продлить жизнь текущего объекта, захватываем shared_ptr в лямбде
-        cooker.UseBurner([self = shared_from_this(), handler = std::move(handler)] {
+        cooker.UseBurner([self = shared_from_this(), handler = std::move(handler)]() mutable {
             // Запоминаем время фактического начала обжаривания
             self->frying_start_time_ = Clock::now();
             handler();
-        });
+        }, ticket);
+    }
+
+    // То же, что StartFry, но завершение сообщается через token, например net::use_awaitable.
+    // Ошибки повторного вызова выбрасываются сразу, до начала асинхронной операции
+    template <typename CompletionToken>
+    auto AsyncStartFry(GasCooker& cooker, GasCooker::Ticket ticket, CompletionToken&& token) {
+        PrepareFry(cooker);
+        return net::async_initiate<CompletionToken, void()>(
+            [self = shared_from_this(), &cooker, ticket](auto handler) {
+                cooker.UseBurner(
+                    [self, handler = std::move(handler)]() mutable {
+                        self->frying_start_time_ = Clock::now();
+                        // Продолжаем ожидающую операцию в её исполнителе без лишнего перехода
+                        auto ex = net::get_associated_executor(handler);
+                        net::dispatch(ex, std::move(handler));
+                    },
+                    ticket);
+            },
+            token);
     }
 
     // Завершает приготовление и освобождает горелку
@@ -68,6 +87,19 @@ public:
     }
 
 private:
+    void PrepareFry(GasCooker& cooker) {
+        // Метод StartFry можно вызвать только один раз
+        if (frying_start_time_) {
+            throw std::logic_error("Frying already started");
+        }
+
+        // Запрещаем повторный вызов StartFry
+        frying_start_time_ = Clock::now();
+
+        // Готовимся занять газовую плиту
+        gas_cooker_lock_ = GasCookerLock{cooker.shared_from_this()};
+    }
+
     int id_;
     GasCookerLock gas_cooker_lock_;
     std::optional<Clock::time_point> frying_start_time_;
@@ -77,7 +109,7 @@ private:
 // Класс "Хлеб". Ведёт себя аналогично классу "Сосиска"
 class Bread : public std::enable_shared_from_this<Bread> {
 public:
-    using Handler = std::function<void()>;
+    using Handler = InplaceFunction<void(), 32>;
 
     explicit Bread(int id)
         : id_{id} {
@@ -89,16 +121,29 @@ public:
 
     // Начинает приготовление хлеба на газовой плите. Как только горелка будет занята, вызовет
     // handler
-    void StartBake(GasCooker& cooker, Handler handler) {
-        if (baking_start_time_) {
-            throw std::logic_error("Baking already started");
-        }
-        baking_start_time_ = Clock::now();               // время вызова
-        gas_cooker_lock_ = GasCookerLock{cooker.shared_from_this()};
-        cooker.UseBurner([self = shared_from_this(), handler = std::move(handler)] {
+    void StartBake(GasCooker& cooker, Handler handler, GasCooker::Ticket ticket = {}) {
+        PrepareBake(cooker);
+        cooker.UseBurner([self = shared_from_this(), handler = std::move(handler)]() mutable {
             self->baking_start_time_ = Clock::now();     // фактическое время начала
             handler();
-        });
+        }, ticket);
+    }
+
+    // Аналог Sausage::AsyncStartFry
+    template <typename CompletionToken>
+    auto AsyncStartBake(GasCooker& cooker, GasCooker::Ticket ticket, CompletionToken&& token) {
+        PrepareBake(cooker);
+        return net::async_initiate<CompletionToken, void()>(
+            [self = shared_from_this(), &cooker, ticket](auto handler) {
+                cooker.UseBurner(
+                    [self, handler = std::move(handler)]() mutable {
+                        self->baking_start_time_ = Clock::now();
+                        auto ex = net::get_associated_executor(handler);
+                        net::dispatch(ex, std::move(handler));
+                    },
+                    ticket);
+            },
+            token);
     }
 
     // Останавливает приготовление хлеба и освобождает горелку.
@@ -127,23 +172,59 @@ public:
     }
 
 private:
+    void PrepareBake(GasCooker& cooker) {
+        if (baking_start_time_) {
+            throw std::logic_error("Baking already started");
+        }
+        baking_start_time_ = Clock::now();               // время вызова
+        gas_cooker_lock_ = GasCookerLock{cooker.shared_from_this()};
+    }
+
     int id_;
     GasCookerLock gas_cooker_lock_;
     std::optional<Clock::time_point> baking_start_time_;
     std::optional<Clock::time_point> baking_end_time_;
 };
 
-// Склад ингредиентов (возвращает ингредиенты с уникальным id)
+// Склад ингредиентов (возвращает ингредиенты с уникальным id).
+// Id выдаются атомарным счётчиком, а память под ингредиенты берётся из пулов, поэтому
+// методы склада можно вызывать из разных потоков без внешней синхронизации
 class Store {
 public:
     std::shared_ptr<Bread> GetBread() {
-        return std::make_shared<Bread>(++next_id_);
+        return std::allocate_shared<Bread>(bread_allocator_, TakeIds(1));
     }
 
     std::shared_ptr<Sausage> GetSausage() {
-        return std::make_shared<Sausage>(++next_id_);
+        return std::allocate_shared<Sausage>(sausage_allocator_, TakeIds(1));
+    }
+
+    // Возвращают сразу count ингредиентов с идущими подряд id
+    std::vector<std::shared_ptr<Bread>> GetBreads(int count) {
+        std::vector<std::shared_ptr<Bread>> breads;
+        breads.reserve(count);
+        for (int id = TakeIds(count), end = id + count; id < end; ++id) {
+            breads.push_back(std::allocate_shared<Bread>(bread_allocator_, id));
+        }
+        return breads;
+    }
+
+    std::vector<std::shared_ptr<Sausage>> GetSausages(int count) {
+        std::vector<std::shared_ptr<Sausage>> sausages;
+        sausages.reserve(count);
+        for (int id = TakeIds(count), end = id + count; id < end; ++id) {
+            sausages.push_back(std::allocate_shared<Sausage>(sausage_allocator_, id));
+        }
+        return sausages;
     }
 
 private:
-    int next_id_ = 0;
+    // Резервирует count идущих подряд id и возвращает первый из них
+    int TakeIds(int count) noexcept {
+        return next_id_.fetch_add(count, std::memory_order_relaxed) + 1;
+    }
+
+    std::atomic<int> next_id_{0};
+    PoolAllocator<Bread> bread_allocator_{std::make_shared<BlockPool>()};
+    PoolAllocator<Sausage> sausage_allocator_{std::make_shared<BlockPool>()};
 };
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature, size_t Capacity>
+class InplaceFunction;
+
+/*
+Функция-обработчик, хранящая вызываемый объект внутри себя, а не в куче.
+В отличие от std::function, не выделяет память даже для лямбда-функций, захватывающих
+shared_ptr: объект размером больше Capacity байт не скомпилируется.
+Объект можно только перемещать, поэтому в нём можно хранить и некопируемые обработчики.
+*/
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+public:
+    InplaceFunction() noexcept = default;
+
+    template <typename Fn>
+        requires(!std::is_same_v<std::decay_t<Fn>, InplaceFunction>
+                 && std::is_invocable_r_v<R, std::decay_t<Fn>&, Args...>)
+    InplaceFunction(Fn&& fn) noexcept(std::is_nothrow_constructible_v<std::decay_t<Fn>, Fn>) {
+        using Stored = std::decay_t<Fn>;
+        static_assert(sizeof(Stored) <= Capacity, "Handler does not fit into InplaceFunction");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t));
+        static_assert(std::is_nothrow_move_constructible_v<Stored>);
+        ::new (static_cast<void*>(storage_)) Stored(std::forward<Fn>(fn));
+        ops_ = &OPS<Stored>;
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept
+        : ops_{other.ops_} {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& rhs) noexcept {
+        if (this != &rhs) {
+            Reset();
+            if (rhs.ops_) {
+                rhs.ops_->move(storage_, rhs.storage_);
+                ops_ = std::exchange(rhs.ops_, nullptr);
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() {
+        Reset();
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+    // Функция должна хранить вызываемый объект
+    R operator()(Args... args) {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void* fn, Args&&... args);
+        // Перемещает объект из src в неинициализированную память dst и разрушает src
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* fn) noexcept;
+    };
+
+    template <typename Stored>
+    constexpr static Ops OPS{
+        [](void* fn, Args&&... args) -> R {
+            return (*static_cast<Stored*>(fn))(std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Stored(std::move(*static_cast<Stored*>(src)));
+            static_cast<Stored*>(src)->~Stored();
+        },
+        [](void* fn) noexcept {
+            static_cast<Stored*>(fn)->~Stored();
+        },
+    };
+
+    void Reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) std::byte storage_[Capacity];
+    const Ops* ops_ = nullptr;
+};
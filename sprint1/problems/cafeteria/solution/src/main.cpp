@@ -44,6 +44,8 @@ void PrintHotDogResult(const Result<HotDog>& result, Clock::duration order_durat
            << ": bread bake time: " << as_seconds(hot_dog.GetBread().GetBakingDuration())
            << "s, sausage bake time: " << as_seconds(hot_dog.GetSausage().GetCookDuration()) << "s"
            << std::endl;
+    } else if (result.HasErrorCode()) {
+        os << "Error: " << result.GetErrorCode().message() << std::endl;
     } else {
         try {
             result.ThrowIfHoldsError();
@@ -0,0 +1,101 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/*
+Пул блоков памяти одного размера.
+Освобождённые блоки не возвращаются в кучу, а используются повторно, поэтому после
+разогрева выделение и освобождение блоков не обращаются к куче.
+Методы класса можно вызывать из разных потоков.
+*/
+class BlockPool {
+public:
+    BlockPool() = default;
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    ~BlockPool() {
+        for (void* block : free_blocks_) {
+            ::operator delete(block, std::align_val_t{alignof(std::max_align_t)});
+        }
+    }
+
+    // Все блоки пула имеют размер, запрошенный при первом выделении
+    void* Allocate(size_t size) {
+        {
+            std::lock_guard lock{mutex_};
+            assert(block_size_ == 0 || block_size_ == size);
+            block_size_ = size;
+            if (!free_blocks_.empty()) {
+                void* block = free_blocks_.back();
+                free_blocks_.pop_back();
+                return block;
+            }
+            // Место под блок в списке свободных резервируем заранее, чтобы Deallocate
+            // не выделял память и не выбрасывал исключений
+            free_blocks_.reserve(++allocated_);
+        }
+        return ::operator new(size, std::align_val_t{alignof(std::max_align_t)});
+    }
+
+    void Deallocate(void* block) noexcept {
+        std::lock_guard lock{mutex_};
+        free_blocks_.push_back(block);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<void*> free_blocks_;
+    size_t block_size_ = 0;
+    // Количество блоков, выделенных пулом за всё время
+    size_t allocated_ = 0;
+};
+
+/*
+Аллокатор, выделяющий одиночные объекты из BlockPool.
+Предназначен для std::allocate_shared: объект и счётчик ссылок размещаются в одном блоке,
+и созданный объект после уничтожения освобождает блок для следующего.
+Копии аллокатора владеют пулом, поэтому пул живёт, пока живы созданные в нём объекты
+*/
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool) noexcept
+        : pool_{std::move(pool)} {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : pool_{other.pool_} {
+    }
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        if (n != 1) {
+            throw std::bad_array_new_length{};
+        }
+        return static_cast<T*>(pool_->Allocate(sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        pool_->Deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<BlockPool> pool_;
+};
@@ -1,9 +1,17 @@
 #pragma once
 #include <stdexcept>
+#include <system_error>
 #include <type_traits>
 #include <variant>
 
-// Вспомогательный класс Result, способный хранить либо значение, либо исключение
+/*
+ * Вспомогательный класс Result, способный хранить значение, код ошибки или исключение.
+ * Ожидаемые ошибки, например забракованный хот-дог, передаются кодом ошибки: его создание
+ * не требует выброса и перехвата исключения, которые стоят микросекунды и захватывают
+ * глобальную блокировку раскрутки стека, поэтому поток с частыми ошибками не замедляется.
+ * Категория кода (std::error_category) задаёт тип ошибки. Исключения остаются для
+ * непредвиденных ошибок
+ */
 template <typename ValueType>
 class Result {
 public:
@@ -20,6 +28,14 @@ public:
     // Явно запрещаем конструировать из nullptr
     Result(std::nullptr_t) = delete;
 
+    // Конструирует результат, хранящий код ошибки. Код не должен быть нулевым
+    Result(std::error_code error)
+        : state_{error} {
+        if (!error) {
+            throw std::invalid_argument("Error code must not be zero");
+        }
+    }
+
     /*
      * Конструирует результат, хранящий исключение.
      * Способ использования:
@@ -51,30 +67,52 @@ public:
         return std::holds_alternative<ValueType>(state_);
     }
 
-    // Если внутри Result хранится исключение, то возвращает указатель на него
+    // Сообщает, хранится ли внутри код ошибки
+    bool HasErrorCode() const noexcept {
+        return std::holds_alternative<std::error_code>(state_);
+    }
+
+    // Возвращает хранящийся код ошибки. Если внутри значение или исключение, возвращает
+    // нулевой код
+    std::error_code GetErrorCode() const noexcept {
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            return *code;
+        }
+        return {};
+    }
+
+    // Если внутри Result хранится исключение, то возвращает указатель на него.
+    // Код ошибки возвращается в виде исключения std::system_error, созданного при вызове
     std::exception_ptr GetError() const {
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            return std::make_exception_ptr(std::system_error{*code});
+        }
         return std::get<std::exception_ptr>(state_);
     }
 
-    // Если внутри содержится исключение, то выбрасывает его. Иначе не делает ничего.
+    // Если внутри содержится исключение, то выбрасывает его, а если код ошибки -
+    // исключение std::system_error с этим кодом. Иначе не делает ничего.
     void ThrowIfHoldsError() const {
         if (auto e = std::get_if<std::exception_ptr>(&state_)) {
             std::rethrow_exception(*e);
         }
+        if (auto code = std::get_if<std::error_code>(&state_)) {
+            throw std::system_error{*code};
+        }
     }
 
-    // Возвращает ссылку на хранящееся значение. Если Result хранит исключение, выбрасывает
+    // Возвращает ссылку на хранящееся значение. Если Result хранит ошибку, выбрасывает
     // std::bad_variant_access
     const ValueType& GetValue() const& {
         return std::get<ValueType>(state_);
     }
 
-    // Возвращает rvalue-ссылку на хранящееся значение. Если Result хранит исключение, выбрасывает
+    // Возвращает rvalue-ссылку на хранящееся значение. Если Result хранит ошибку, выбрасывает
     // std::bad_variant_access
     ValueType&& GetValue() && {
         return std::get<ValueType>(std::move(state_));
     }
 
 private:
-    std::variant<ValueType, std::exception_ptr> state_;
+    std::variant<ValueType, std::error_code, std::exception_ptr> state_;
 };
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+/*
+Ускоренные часы для бенчмарка кафетерия.
+Время этих часов идёт в GetSpeed() раз быстрее реального, а таймеры, использующие WaitTraits,
+ждут во столько же раз меньше. Поэтому приготовление хот-дога, занимающее секунды,
+укладывается в миллисекунды реального времени, а все длительности, измеренные этими
+часами, сохраняют свой смысл.
+Задержки планировщика растягиваются в то же количество раз, поэтому слишком большое
+ускорение выводит время приготовления за допустимые пределы.
+*/
+class VirtualClock {
+public:
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<VirtualClock>;
+    constexpr static bool is_steady = true;
+
+    static time_point now() noexcept {
+        const auto real = std::chrono::steady_clock::now() - START;
+        return time_point{duration{static_cast<rep>(real.count() * GetSpeed())}};
+    }
+
+    // Скорость нужно задать до первого обращения к часам
+    static void SetSpeed(double speed) noexcept {
+        speed_.store(speed, std::memory_order_relaxed);
+    }
+
+    static double GetSpeed() noexcept {
+        return speed_.load(std::memory_order_relaxed);
+    }
+
+    // Переводит время ожидания по этим часам в реальное время ожидания для таймеров asio
+    struct WaitTraits {
+        static duration to_wait_duration(const duration& d) {
+            return duration{static_cast<rep>(d.count() / GetSpeed())};
+        }
+
+        static duration to_wait_duration(const time_point& t) {
+            return to_wait_duration(t - now());
+        }
+    };
+
+private:
+    inline static const std::chrono::steady_clock::time_point START =
+        std::chrono::steady_clock::now();
+    inline static std::atomic<double> speed_{1.0};
+};
@@ -0,0 +1,343 @@
+#include "bench.h"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace bench {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace beast = boost::beast;
+namespace sys = boost::system;
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Сколько ждать ответов на отправленные запросы после окончания измерений
+constexpr auto DRAIN_TIMEOUT = 5s;
+
+// Результаты одного соединения. Соединение изменяет их только в своём strand-е
+struct Stats {
+    std::uint64_t responses = 0;
+    std::uint64_t non_2xx = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t body_bytes = 0;
+    std::vector<std::uint32_t> latencies_us;
+};
+
+// Сериализованные запросы и накопленные веса для случайного выбора цели
+class RequestMix {
+public:
+    explicit RequestMix(const Config& config) {
+        unsigned total = 0;
+        for (const auto& target : config.targets) {
+            http::request<http::empty_body> req{config.method, target.path, 11};
+            req.set(http::field::host, config.host);
+            req.set(http::field::user_agent, "http_bench"sv);
+            if (!config.accept_encoding.empty()) {
+                req.set(http::field::accept_encoding, config.accept_encoding);
+            }
+            req.keep_alive(config.keep_alive);
+            std::ostringstream out;
+            out << req;
+            requests_.push_back(std::move(out).str());
+            total += std::max(1u, target.weight);
+            cumulative_weights_.push_back(total);
+        }
+    }
+
+    template <typename Random>
+    const std::string& Pick(Random& random) const {
+        std::uniform_int_distribution<unsigned> dist{0, cumulative_weights_.back() - 1};
+        const auto it = std::upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(),
+                                         dist(random));
+        return requests_[static_cast<size_t>(it - cumulative_weights_.begin())];
+    }
+
+private:
+    std::vector<std::string> requests_;
+    std::vector<unsigned> cumulative_weights_;
+};
+
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    Connection(net::io_context& ioc, const tcp::resolver::results_type& endpoints,
+               const RequestMix& mix, const Config& config, const std::atomic<bool>& stopped,
+               std::atomic<unsigned>& active, unsigned seed)
+        : socket_{net::make_strand(ioc)}
+        , endpoints_{endpoints}
+        , mix_{mix}
+        , depth_{config.keep_alive ? std::max(1u, config.pipeline) : 1u}
+        , head_{config.method == http::verb::head}
+        , stopped_{stopped}
+        , active_{active}
+        , random_{seed} {
+    }
+
+    void Start() {
+        net::dispatch(socket_.get_executor(),
+                      beast::bind_front_handler(&Connection::Connect, shared_from_this()));
+    }
+
+    // Вызывается после завершения работы io_context
+    const Stats& GetStats() const noexcept {
+        return stats_;
+    }
+
+private:
+    void Connect() {
+        if (stopped_) {
+            return Finish();
+        }
+        net::async_connect(socket_, endpoints_,
+                           [self = shared_from_this(), connection = connection_](sys::error_code ec,
+                                                                                 const tcp::endpoint&) {
+                               if (connection == self->connection_) {
+                                   self->OnConnect(ec);
+                               }
+                           });
+    }
+
+    void OnConnect(sys::error_code ec) {
+        if (ec == net::error::operation_aborted) {
+            // Подключение отменено, соединением занимается новая попытка
+            return;
+        }
+        if (ec) {
+            // Сервер недоступен: соединение прекращает работу, чтобы не создавать
+            // бесконечный поток повторных подключений
+            ++stats_.errors;
+            return Finish();
+        }
+        Send();
+        Read();
+    }
+
+    // Дополняет конвейер запросов до заданной глубины
+    void Send() {
+        if (writing_ || stopped_) {
+            return;
+        }
+        write_buffer_.clear();
+        while (in_flight_.size() < depth_) {
+            write_buffer_ += mix_.Pick(random_);
+            in_flight_.push_back(Clock::now());
+        }
+        if (write_buffer_.empty()) {
+            return;
+        }
+        writing_ = true;
+        net::async_write(socket_, net::buffer(write_buffer_),
+                         [self = shared_from_this(), connection = connection_](sys::error_code ec, std::size_t) {
+                             if (connection == self->connection_) {
+                                 self->OnWrite(ec);
+                             }
+                         });
+    }
+
+    void OnWrite(sys::error_code ec) {
+        writing_ = false;
+        if (ec) {
+            return Fail();
+        }
+        Send();
+    }
+
+    void Read() {
+        parser_.emplace();
+        parser_->body_limit(std::numeric_limits<std::uint64_t>::max());
+        // В ответе на HEAD-запрос тела нет, хотя Content-Length указан
+        parser_->skip(head_);
+        http::async_read(socket_, buffer_, *parser_,
+                         [self = shared_from_this(), connection = connection_](sys::error_code ec, std::size_t) {
+                             if (connection == self->connection_) {
+                                 self->OnRead(ec);
+                             }
+                         });
+    }
+
+    void OnRead(sys::error_code ec) {
+        if (ec) {
+            return Fail();
+        }
+        const auto latency = Clock::now() - in_flight_.front();
+        in_flight_.pop_front();
+
+        const auto& response = parser_->get();
+        ++stats_.responses;
+        stats_.body_bytes += response.body().size();
+        if (response.result_int() / 100 != 2) {
+            ++stats_.non_2xx;
+        }
+        stats_.latencies_us.push_back(static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+
+        if (response.need_eof()) {
+            return Reconnect();
+        }
+        Send();
+        if (!in_flight_.empty()) {
+            Read();
+        } else {
+            Close();
+            Finish();
+        }
+    }
+
+    // Запросы, ответы на которые не получены, считаются ошибками
+    void Fail() {
+        stats_.errors += std::max<size_t>(in_flight_.size(), 1);
+        Reconnect();
+    }
+
+    // Операции прежнего сокета завершатся с ошибкой, но их обработчики уже ничего не сделают:
+    // иначе неудачное чтение и незаконченная запись конвейера обе вызвали бы Fail
+    void Reconnect() {
+        ++connection_;
+        Close();
+        writing_ = false;
+        in_flight_.clear();
+        buffer_.clear();
+        socket_ = tcp::socket{socket_.get_executor()};
+        Connect();
+    }
+
+    // Соединение больше не будет отправлять запросы
+    void Finish() {
+        active_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Close() {
+        sys::error_code ec;
+        socket_.shutdown(tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+    }
+
+    tcp::socket socket_;
+    const tcp::resolver::results_type& endpoints_;
+    const RequestMix& mix_;
+    const size_t depth_;
+    const bool head_;
+    const std::atomic<bool>& stopped_;
+    std::atomic<unsigned>& active_;
+    std::minstd_rand random_;
+
+    beast::flat_buffer buffer_;
+    std::optional<http::response_parser<http::string_body>> parser_;
+    std::string write_buffer_;
+    // Моменты отправки запросов, ответы на которые ещё не получены
+    std::deque<Clock::time_point> in_flight_;
+    bool writing_ = false;
+    // Номер текущего подключения. Обработчики операций прежних подключений ничего не делают
+    std::uint64_t connection_ = 0;
+    Stats stats_;
+};
+
+std::uint32_t Percentile(const std::vector<std::uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+}  // namespace
+
+Report Run(const Config& config) {
+    net::io_context ioc(static_cast<int>(config.threads));
+    const auto endpoints =
+        tcp::resolver{ioc}.resolve(config.host, std::to_string(config.port));
+    const RequestMix mix{config};
+    std::atomic<bool> stopped{false};
+    std::atomic<unsigned> active{config.connections};
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    connections.reserve(config.connections);
+    for (unsigned i = 0; i < config.connections; ++i) {
+        connections.push_back(
+            std::make_shared<Connection>(ioc, endpoints, mix, config, stopped, active, i + 1));
+    }
+
+    const auto start = Clock::now();
+    // По истечении времени новые запросы не отправляются, а соединения закрываются после
+    // получения ответов на уже отправленные. Если сервер не отвечает на часть запросов,
+    // ожидание прекращается принудительно через DRAIN_TIMEOUT
+    net::steady_timer timer{ioc, config.duration};
+    std::function<void(sys::error_code)> on_timer = [&](sys::error_code) {
+        stopped = true;
+        if (active == 0 || Clock::now() - start >= config.duration + DRAIN_TIMEOUT) {
+            return ioc.stop();
+        }
+        timer.expires_after(10ms);
+        timer.async_wait(on_timer);
+    };
+    timer.async_wait(on_timer);
+    for (const auto& connection : connections) {
+        connection->Start();
+    }
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned i = 1; i < config.threads; ++i) {
+            workers.emplace_back([&ioc] {
+                ioc.run();
+            });
+        }
+        ioc.run();
+    }
+
+    Report report;
+    report.elapsed = Clock::now() - start;
+    for (const auto& connection : connections) {
+        const auto& stats = connection->GetStats();
+        report.responses += stats.responses;
+        report.non_2xx += stats.non_2xx;
+        report.errors += stats.errors;
+        report.body_bytes += stats.body_bytes;
+        report.latencies_us.insert(report.latencies_us.end(), stats.latencies_us.begin(),
+                                   stats.latencies_us.end());
+    }
+    std::sort(report.latencies_us.begin(), report.latencies_us.end());
+    return report;
+}
+
+void PrintReport(std::ostream& out, const Report& report) {
+    const double seconds = report.elapsed.count();
+    char line[256];
+    std::snprintf(line, sizeof(line), "Responses: %llu in %.2f s, %.1f RPS, %.2f MiB/s\n",
+                  static_cast<unsigned long long>(report.responses), seconds,
+                  seconds > 0 ? static_cast<double>(report.responses) / seconds : 0.0,
+                  seconds > 0 ? static_cast<double>(report.body_bytes) / seconds / (1 << 20) : 0.0);
+    out << line;
+    std::snprintf(line, sizeof(line), "Non-2xx responses: %llu, errors: %llu\n",
+                  static_cast<unsigned long long>(report.non_2xx),
+                  static_cast<unsigned long long>(report.errors));
+    out << line;
+    const auto& latencies = report.latencies_us;
+    std::snprintf(line, sizeof(line),
+                  "Latency, us: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u\n",
+                  Percentile(latencies, 50), Percentile(latencies, 90), Percentile(latencies, 99),
+                  Percentile(latencies, 99.9), latencies.empty() ? 0u : latencies.back());
+    out << line;
+}
+
+}  // namespace bench
@@ -0,0 +1,61 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/beast/http/verb.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+namespace http = boost::beast::http;
+
+// Цель запроса и её доля в общем потоке запросов
+struct Target {
+    std::string path;
+    unsigned weight = 1;
+};
+
+struct Config {
+    std::string host = "127.0.0.1";
+    unsigned short port = 8080;
+    // Количество одновременно открытых соединений
+    unsigned connections = 64;
+    // Количество потоков клиента
+    unsigned threads = 1;
+    std::chrono::seconds duration{10};
+    // Сколько запросов соединение отправляет, не дожидаясь ответов
+    unsigned pipeline = 1;
+    // Без keep-alive каждый запрос отправляется в новом соединении
+    bool keep_alive = true;
+    http::verb method = http::verb::get;
+    // Значение заголовка Accept-Encoding. Пустая строка - заголовок не отправляется
+    std::string accept_encoding;
+    std::vector<Target> targets;
+};
+
+struct Report {
+    std::chrono::duration<double> elapsed{};
+    std::uint64_t responses = 0;
+    // Ответы с кодом, отличным от 2xx
+    std::uint64_t non_2xx = 0;
+    // Ошибки соединения, чтения и записи
+    std::uint64_t errors = 0;
+    std::uint64_t body_bytes = 0;
+    // Отсортированные задержки ответов в микросекундах
+    std::vector<std::uint32_t> latencies_us;
+};
+
+// Нагружает сервер в соответствии с config и возвращает результаты измерений.
+// В случае ошибки разрешения адреса выбрасывает исключение boost::system::system_error
+Report Run(const Config& config);
+
+void PrintReport(std::ostream& out, const Report& report);
+
+}  // namespace bench
@@ -0,0 +1,448 @@
+#include "http_client.h"
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core.hpp>
+#include <deque>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+namespace http_client {
+
+namespace beast = boost::beast;
+using tcp = net::ip::tcp;
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Strand = net::strand<net::io_context::executor_type>;
+
+// Запрос, ожидающий ответа
+struct PendingRequest {
+    Request request;
+    ResponseHandler handler;
+    // Запрос уже отправлялся заново после закрытия соединения
+    bool retried = false;
+};
+
+bool IsIdempotent(http::verb method) noexcept {
+    switch (method) {
+        case http::verb::get:
+        case http::verb::head:
+        case http::verb::put:
+        case http::verb::delete_:
+        case http::verb::options:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Ошибки, с которыми завершается чтение из соединения, закрытого сервером
+bool IsConnectionClosed(sys::error_code ec) noexcept {
+    return ec == http::error::end_of_stream || ec == net::error::eof
+        || ec == net::error::connection_reset || ec == net::error::broken_pipe;
+}
+
+void Complete(PendingRequest& pending, sys::error_code ec, Response&& response = {}) {
+    pending.handler(ec, std::move(response));
+}
+
+}  // namespace
+
+// Соединения с одним сервером и очередь запросов к нему
+class Client::HostPool : public std::enable_shared_from_this<HostPool> {
+public:
+    HostPool(net::io_context& ioc, std::string host, std::string port, const ClientOptions& options,
+             std::shared_ptr<std::atomic<std::uint64_t>> connect_count)
+        : strand_{net::make_strand(ioc)}
+        , resolver_{strand_}
+        , host_{std::move(host)}
+        , port_{std::move(port)}
+        , options_{options}
+        , connect_count_{std::move(connect_count)} {
+    }
+
+    void Submit(PendingRequest pending) {
+        net::dispatch(strand_, [self = shared_from_this(), pending = std::move(pending)]() mutable {
+            self->pending_.push_back(std::move(pending));
+            self->Dispatch();
+        });
+    }
+
+    // Закрывает соединения и завершает ожидающие запросы ошибкой operation_aborted
+    void Shutdown();
+
+private:
+    class Connection;
+
+    // Распределяет ожидающие запросы по соединениям. Выполняется в strand_
+    void Dispatch();
+    void Resolve();
+    void FailPending(sys::error_code ec);
+    // Соединение закрыто. Запросы requeue ещё не получили ответа и отправляются заново
+    void OnConnectionClosed(const Connection* connection, std::deque<PendingRequest> requeue);
+
+    Strand strand_;
+    tcp::resolver resolver_;
+    std::string host_;
+    std::string port_;
+    const ClientOptions options_;
+    std::shared_ptr<std::atomic<std::uint64_t>> connect_count_;
+    std::optional<tcp::resolver::results_type> endpoints_;
+    bool resolving_ = false;
+    bool closed_ = false;
+    std::deque<PendingRequest> pending_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+};
+
+class Client::HostPool::Connection : public std::enable_shared_from_this<Connection> {
+public:
+    explicit Connection(std::shared_ptr<HostPool> pool)
+        : pool_{std::move(pool)}
+        , stream_{pool_->strand_}
+        , last_used_{Clock::now()} {
+    }
+
+    void Connect(const tcp::resolver::results_type& endpoints) {
+        pool_->connect_count_->fetch_add(1, std::memory_order_relaxed);
+        stream_.expires_after(pool_->options_.connect_timeout);
+        stream_.async_connect(endpoints,
+                              [self = shared_from_this()](sys::error_code ec, const tcp::endpoint&) {
+                                  self->OnConnect(ec);
+                              });
+    }
+
+    // Может ли соединение принять ещё один запрос
+    bool CanAccept() const noexcept {
+        return !closed_ && unsent_.size() + sent_.size() < pool_->options_.pipeline_depth;
+    }
+
+    // Соединение простаивало дольше idle_timeout, и сервер мог уже закрыть его
+    bool IsExpired() const noexcept {
+        return connected_ && unsent_.empty() && sent_.empty()
+            && Clock::now() - last_used_ > pool_->options_.idle_timeout;
+    }
+
+    bool IsClosed() const noexcept {
+        return closed_;
+    }
+
+    size_t GetLoad() const noexcept {
+        return unsent_.size() + sent_.size();
+    }
+
+    void Enqueue(PendingRequest pending) {
+        unsent_.push_back(std::move(pending));
+        if (connected_) {
+            Write();
+        }
+    }
+
+    // Закрывает соединение. Если ec задан, запросы без ответа завершаются этой ошибкой
+    void Abort(sys::error_code ec) {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        sys::error_code ignored;
+        stream_.socket().shutdown(tcp::socket::shutdown_both, ignored);
+        stream_.close();
+        auto unsent = std::move(unsent_);
+        auto sent = std::move(sent_);
+        for (auto* requests : {&sent, &unsent}) {
+            for (auto& pending : *requests) {
+                Complete(pending, ec ? ec : sys::error_code{net::error::operation_aborted});
+            }
+        }
+    }
+
+private:
+    void OnConnect(sys::error_code ec) {
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            // Сервер недоступен: повторная отправка в новое соединение ничего не даст
+            return Fail(ec, false);
+        }
+        connected_ = true;
+        last_used_ = Clock::now();
+        Write();
+    }
+
+    // Отправляет все запросы, поставленные в соединение, одной записью
+    void Write() {
+        if (writing_ || closed_ || unsent_.empty()) {
+            return;
+        }
+        // Буфер записи очищается, но сохраняет выделенную память
+        write_buffer_.clear();
+        while (!unsent_.empty()) {
+            std::ostringstream out;
+            out << unsent_.front().request;
+            write_buffer_ += std::move(out).str();
+            sent_.push_back(std::move(unsent_.front()));
+            unsent_.pop_front();
+        }
+        writing_ = true;
+        stream_.expires_after(pool_->options_.request_timeout);
+        net::async_write(stream_, net::buffer(write_buffer_),
+                         [self = shared_from_this()](sys::error_code ec, std::size_t) {
+                             self->OnWrite(ec);
+                         });
+        Read();
+    }
+
+    void OnWrite(sys::error_code ec) {
+        writing_ = false;
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            return Fail(ec, true);
+        }
+        Write();
+    }
+
+    void Read() {
+        if (reading_ || closed_ || sent_.empty()) {
+            return;
+        }
+        reading_ = true;
+        parser_.emplace();
+        parser_->body_limit(pool_->options_.body_limit);
+        // В ответе на HEAD-запрос тела нет, хотя Content-Length указан
+        parser_->skip(sent_.front().request.method() == http::verb::head);
+        stream_.expires_after(pool_->options_.request_timeout);
+        http::async_read(stream_, read_buffer_, *parser_,
+                         [self = shared_from_this()](sys::error_code ec, std::size_t) {
+                             self->OnRead(ec);
+                         });
+    }
+
+    void OnRead(sys::error_code ec) {
+        reading_ = false;
+        if (closed_) {
+            return;
+        }
+        if (ec) {
+            return Fail(ec, true);
+        }
+        auto pending = std::move(sent_.front());
+        sent_.pop_front();
+        ++responses_;
+        last_used_ = Clock::now();
+        Response response = parser_->release();
+        const bool close = response.need_eof();
+        Complete(pending, {}, std::move(response));
+
+        if (close) {
+            // Сервер закрывает соединение и не обработает отправленные следом запросы.
+            // Это не сбой соединения, поэтому повторная отправка идемпотентных запросов
+            // не расходует их единственную попытку
+            for (auto it = sent_.rbegin(); it != sent_.rend(); ++it) {
+                if (IsIdempotent(it->request.method())) {
+                    unsent_.push_front(std::move(*it));
+                } else {
+                    Complete(*it, http::error::end_of_stream);
+                }
+            }
+            sent_.clear();
+            return Fail(http::error::end_of_stream, true);
+        }
+        if (sent_.empty() && unsent_.empty()) {
+            stream_.expires_never();
+        }
+        Read();
+        // Соединение может принять следующие запросы
+        pool_->Dispatch();
+    }
+
+    // Закрывает соединение после ошибки. Запросы, которые можно безопасно повторить,
+    // возвращаются в очередь пула, остальные завершаются ошибкой
+    void Fail(sys::error_code ec, bool allow_retry) {
+        closed_ = true;
+        sys::error_code ignored;
+        stream_.socket().shutdown(tcp::socket::shutdown_both, ignored);
+        stream_.close();
+
+        std::deque<PendingRequest> requeue;
+        // Сервер закрывает простаивавшее соединение одновременно с отправкой запроса
+        // клиентом. В этом случае запрос не обработан, и его можно отправить заново
+        const bool stale = responses_ > 0 && IsConnectionClosed(ec);
+        for (auto& pending : sent_) {
+            if (allow_retry && stale && !pending.retried && IsIdempotent(pending.request.method())) {
+                pending.retried = true;
+                requeue.push_back(std::move(pending));
+            } else {
+                Complete(pending, ec);
+            }
+        }
+        sent_.clear();
+        // Неотправленные запросы сервер не видел
+        for (auto& pending : unsent_) {
+            if (allow_retry) {
+                requeue.push_back(std::move(pending));
+            } else {
+                Complete(pending, ec);
+            }
+        }
+        unsent_.clear();
+        pool_->OnConnectionClosed(this, std::move(requeue));
+    }
+
+    std::shared_ptr<HostPool> pool_;
+    beast::tcp_stream stream_;
+    beast::flat_buffer read_buffer_;
+    std::string write_buffer_;
+    std::optional<http::response_parser<http::string_body>> parser_;
+    // Запросы, ещё не записанные в сокет, и записанные, ответ на которые не получен
+    std::deque<PendingRequest> unsent_;
+    std::deque<PendingRequest> sent_;
+    Clock::time_point last_used_;
+    std::uint64_t responses_ = 0;
+    bool connected_ = false;
+    bool writing_ = false;
+    bool reading_ = false;
+    bool closed_ = false;
+};
+
+void Client::HostPool::Shutdown() {
+    net::dispatch(strand_, [self = shared_from_this()] {
+        self->closed_ = true;
+        self->resolver_.cancel();
+        for (const auto& connection : self->connections_) {
+            connection->Abort(net::error::operation_aborted);
+        }
+        self->connections_.clear();
+        self->Dispatch();
+    });
+}
+
+void Client::HostPool::Dispatch() {
+    if (closed_) {
+        return FailPending(net::error::operation_aborted);
+    }
+    std::erase_if(connections_, [](const auto& connection) {
+        if (connection->IsExpired()) {
+            connection->Abort({});
+        }
+        return connection->IsClosed();
+    });
+    while (!pending_.empty()) {
+        // Запрос получает наименее загруженное соединение
+        Connection* target = nullptr;
+        for (const auto& connection : connections_) {
+            if (connection->CanAccept() && (!target || connection->GetLoad() < target->GetLoad())) {
+                target = connection.get();
+            }
+        }
+        if (!target && connections_.size() < options_.max_connections_per_host) {
+            if (!endpoints_) {
+                // Адрес разрешается один раз, после чего Dispatch вызывается снова
+                return Resolve();
+            }
+            auto connection = std::make_shared<Connection>(shared_from_this());
+            connection->Connect(*endpoints_);
+            target = connection.get();
+            connections_.push_back(std::move(connection));
+        }
+        if (!target) {
+            // Все соединения заняты: запрос ждёт ответа на один из отправленных
+            return;
+        }
+        target->Enqueue(std::move(pending_.front()));
+        pending_.pop_front();
+    }
+}
+
+void Client::HostPool::Resolve() {
+    if (resolving_) {
+        return;
+    }
+    resolving_ = true;
+    resolver_.async_resolve(
+        host_, port_,
+        net::bind_executor(strand_, [self = shared_from_this()](
+                                        sys::error_code ec, tcp::resolver::results_type results) {
+            self->resolving_ = false;
+            if (ec) {
+                return self->FailPending(ec);
+            }
+            self->endpoints_ = std::move(results);
+            self->Dispatch();
+        }));
+}
+
+void Client::HostPool::FailPending(sys::error_code ec) {
+    auto pending = std::move(pending_);
+    pending_.clear();
+    for (auto& request : pending) {
+        Complete(request, ec);
+    }
+}
+
+void Client::HostPool::OnConnectionClosed(const Connection* connection,
+                                          std::deque<PendingRequest> requeue) {
+    std::erase_if(connections_, [connection](const auto& item) {
+        return item.get() == connection;
+    });
+    // Повторяемые запросы отправляются раньше новых, чтобы сохранить порядок
+    pending_.insert(pending_.begin(), std::make_move_iterator(requeue.begin()),
+                    std::make_move_iterator(requeue.end()));
+    // Соединение уничтожается после выхода из его обработчика, поэтому Dispatch
+    // откладываем, чтобы не открыть новое соединение внутри обработчика старого
+    net::post(strand_, [self = shared_from_this()] {
+        self->Dispatch();
+    });
+}
+
+Client::Client(net::io_context& ioc, ClientOptions options)
+    : ioc_{ioc}
+    , options_{options} {
+}
+
+Client::~Client() {
+    Shutdown();
+}
+
+void Client::AsyncRequest(std::string_view host, std::string_view port, Request request,
+                          ResponseHandler handler) {
+    if (request.find(http::field::host) == request.end()) {
+        request.set(http::field::host, host);
+    }
+    request.keep_alive(true);
+    request.prepare_payload();
+
+    std::shared_ptr<HostPool> pool;
+    {
+        std::string key{host};
+        key += ':';
+        key += port;
+        std::lock_guard lk{mutex_};
+        auto& entry = pools_[key];
+        if (!entry) {
+            entry = std::make_shared<HostPool>(ioc_, std::string{host}, std::string{port}, options_,
+                                               connect_count_);
+        }
+        pool = entry;
+    }
+    pool->Submit({std::move(request), std::move(handler)});
+}
+
+void Client::Shutdown() {
+    std::lock_guard lk{mutex_};
+    for (const auto& [key, pool] : pools_) {
+        pool->Shutdown();
+    }
+    pools_.clear();
+}
+
+}  // namespace http_client
@@ -0,0 +1,91 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/io_context.hpp>
+#include <boost/beast/http.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace http_client {
+
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+namespace sys = boost::system;
+
+using Request = http::request<http::string_body>;
+using Response = http::response<http::string_body>;
+// Получает ответ либо ошибку. Вызывается в одном из потоков io_context
+using ResponseHandler = std::function<void(sys::error_code ec, Response&& response)>;
+
+struct ClientOptions {
+    // Максимальное количество соединений с одним сервером
+    size_t max_connections_per_host = 8;
+    // Сколько запросов соединение отправляет, не дожидаясь ответов. 1 - без конвейера
+    size_t pipeline_depth = 1;
+    std::chrono::milliseconds connect_timeout{5000};
+    // Время ожидания очередного ответа или записи запросов
+    std::chrono::milliseconds request_timeout{10000};
+    // Соединение, простоявшее без запросов дольше, не используется повторно:
+    // сервер мог уже закрыть его
+    std::chrono::milliseconds idle_timeout{30000};
+    // Допустимый размер тела ответа
+    std::uint64_t body_limit = 8 * 1024 * 1024;
+};
+
+/*
+ * Асинхронный HTTP/1.1 клиент с постоянными соединениями.
+ * Для каждого сервера (host:port) клиент держит пул соединений и отправляет запросы
+ * в свободные соединения, открывая новые, пока их не станет max_connections_per_host.
+ * Запросы, которым не хватило соединений, ждут в очереди пула.
+ * Пул и его соединения работают в собственном strand-е, поэтому разные серверы
+ * обслуживаются параллельно. Буферы чтения и записи соединения используются повторно
+ * для всех его запросов.
+ * Если повторно используемое соединение оказалось закрыто сервером, идемпотентные запросы
+ * (GET, HEAD, PUT, DELETE, OPTIONS) однократно отправляются заново в другом соединении.
+ * Объект клиента можно уничтожить раньше io_context: пулы живут, пока у них есть работа.
+ */
+class Client {
+public:
+    explicit Client(net::io_context& ioc, ClientOptions options = {});
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // Отправляет запрос серверу host:port. Заголовок Host, если он не задан, и длина тела
+    // заполняются автоматически. Может быть вызван из любого потока
+    void AsyncRequest(std::string_view host, std::string_view port, Request request,
+                      ResponseHandler handler);
+
+    // Закрывает все соединения. Запросы, не получившие ответа, завершаются
+    // ошибкой operation_aborted
+    void Shutdown();
+
+    // Количество открытых клиентом соединений за всё время работы
+    std::uint64_t GetConnectCount() const noexcept {
+        return connect_count_->load(std::memory_order_relaxed);
+    }
+
+private:
+    class HostPool;
+
+    net::io_context& ioc_;
+    ClientOptions options_;
+    std::shared_ptr<std::atomic<std::uint64_t>> connect_count_ =
+        std::make_shared<std::atomic<std::uint64_t>>(0);
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<HostPool>> pools_;
+};
+
+}  // namespace http_client
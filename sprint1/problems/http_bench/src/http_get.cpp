@@ -0,0 +1,111 @@
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "http_client.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Config {
+    std::string host;
+    std::string port;
+    std::vector<std::string> targets;
+    unsigned repeat = 1;
+    http_client::ClientOptions client;
+};
+
+std::optional<Config> ParseCommandLine(int argc, const char* const argv[]) {
+    Config config;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (!arg.starts_with("--"sv)) {
+            positional.emplace_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        try {
+            const auto value = std::stoul(argv[++i]);
+            if (arg == "--repeat"sv) {
+                config.repeat = static_cast<unsigned>(value);
+            } else if (arg == "--connections"sv && value > 0) {
+                config.client.max_connections_per_host = value;
+            } else if (arg == "--pipeline"sv && value > 0) {
+                config.client.pipeline_depth = value;
+            } else {
+                return std::nullopt;
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    if (positional.size() < 3) {
+        return std::nullopt;
+    }
+    config.host = positional[0];
+    config.port = positional[1];
+    config.targets.assign(positional.begin() + 2, positional.end());
+    return config;
+}
+
+}  // namespace
+
+/*
+ * Выполняет GET-запросы к серверу через http_client::Client и печатает статус, размер
+ * и время получения каждого ответа. По количеству открытых соединений в конце видно,
+ * что запросы переиспользуют соединения пула.
+ */
+int main(int argc, const char* argv[]) {
+    const auto config = ParseCommandLine(argc, argv);
+    if (!config) {
+        std::cerr << "Usage: http_get <host> <port> <target>... [--repeat <n>] "sv
+                  << "[--connections <n>] [--pipeline <depth>]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    namespace http = http_client::http;
+    using Clock = std::chrono::steady_clock;
+
+    http_client::net::io_context ioc;
+    http_client::Client client{ioc, config->client};
+    bool failed = false;
+    size_t completed = 0;
+    for (unsigned i = 0; i < config->repeat; ++i) {
+        for (const auto& target : config->targets) {
+            http_client::Request request{http::verb::get, target, 11};
+            client.AsyncRequest(config->host, config->port, std::move(request),
+                                [&target, &failed, &completed, start = Clock::now()](
+                                    http_client::sys::error_code ec,
+                                    http_client::Response&& response) {
+                                    const std::chrono::duration<double, std::milli> elapsed =
+                                        Clock::now() - start;
+                                    ++completed;
+                                    if (ec) {
+                                        failed = true;
+                                        std::cout << target << ": "sv << ec.message() << '\n';
+                                        return;
+                                    }
+                                    std::cout << target << ": "sv << response.result_int() << ", "sv
+                                              << response.body().size() << " bytes, "sv
+                                              << elapsed.count() << " ms\n"sv;
+                                });
+        }
+    }
+    // Пулы держат открытые соединения, поэтому ioc.run() не завершится сам
+    // после получения всех ответов
+    const size_t total = config->repeat * config->targets.size();
+    while (completed < total && ioc.run_one() > 0) {
+    }
+    client.Shutdown();
+    ioc.run();
+    std::cout << "connections opened: "sv << client.GetConnectCount() << std::endl;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
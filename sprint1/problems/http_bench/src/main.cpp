@@ -0,0 +1,78 @@
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "bench.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::optional<bench::Config> ParseCommandLine(int argc, const char* const argv[]) {
+    bench::Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--no-keep-alive"sv) {
+            config.keep_alive = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--host"sv) {
+                config.host = value;
+            } else if (arg == "--port"sv) {
+                config.port = static_cast<unsigned short>(std::stoul(value));
+            } else if (arg == "--connections"sv) {
+                config.connections = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--threads"sv) {
+                config.threads = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+            } else if (arg == "--duration"sv) {
+                config.duration = std::chrono::seconds{std::stoul(value)};
+            } else if (arg == "--pipeline"sv) {
+                config.pipeline = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--method"sv && value == "GET"sv) {
+                config.method = bench::http::verb::get;
+            } else if (arg == "--method"sv && value == "HEAD"sv) {
+                config.method = bench::http::verb::head;
+            } else if (arg == "--accept-encoding"sv) {
+                config.accept_encoding = value;
+            } else if (arg == "--target"sv && value.starts_with('/')) {
+                config.targets.push_back({value});
+            } else if (arg == "--weight"sv && !config.targets.empty()) {
+                // Вес относится к последней указанной цели
+                config.targets.back().weight = static_cast<unsigned>(std::stoul(value));
+            } else {
+                return std::nullopt;
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    if (config.targets.empty()) {
+        config.targets.push_back({"/"});
+    }
+    return config;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    const auto config = ParseCommandLine(argc, argv);
+    if (!config) {
+        std::cerr << "Usage: http_bench [--host <host>] [--port <port>] [--connections <n>] "sv
+                  << "[--threads <n>] [--duration <seconds>] [--pipeline <depth>] "sv
+                  << "[--no-keep-alive] [--method GET|HEAD] [--accept-encoding <value>] "sv
+                  << "[--target <path> [--weight <n>]]..."sv << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        bench::PrintReport(std::cout, bench::Run(*config));
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
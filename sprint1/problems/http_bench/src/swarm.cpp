@@ -0,0 +1,575 @@
+#include "swarm.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "http_client.h"
+
+namespace swarm {
+
+namespace net = http_client::net;
+namespace http = http_client::http;
+namespace sys = http_client::sys;
+using http_client::Request;
+using http_client::Response;
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Strand = net::strand<net::io_context::executor_type>;
+
+// Сколько ждать ответов на отправленные запросы после окончания измерений
+constexpr auto DRAIN_TIMEOUT = 5s;
+
+constexpr std::string_view MOVES[] = {"L"sv, "R"sv, "U"sv, "D"sv};
+
+std::uint32_t ToMicroseconds(Clock::duration duration) {
+    return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+/*
+ * Ответы сервера не разбираются целиком: тысячам ботов, опрашивающим состояние
+ * по десять раз в секунду, пришлось бы строить дерево документа из сотен килобайт
+ * ради одного поля. Вместо этого значение ищется по ключу в тексте компактного JSON,
+ * который пишет сервер. Возвращает строку без кавычек или текст числа
+ */
+std::optional<std::string_view> FindValue(std::string_view json, std::string_view key, size_t from = 0) {
+    const std::string pattern = '"' + std::string{key} + "\":";
+    const auto pos = json.find(pattern, from);
+    if (pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto value = json.substr(pos + pattern.size());
+    if (value.starts_with('"')) {
+        const auto end = value.find('"', 1);
+        return end == std::string_view::npos ? std::nullopt : std::optional{value.substr(1, end - 1)};
+    }
+    return value.substr(0, std::min(value.find_first_of(",}]"sv), value.size()));
+}
+
+std::optional<std::uint64_t> FindNumber(std::string_view json, std::string_view key) {
+    const auto text = FindValue(json, key);
+    if (!text || text->empty()) {
+        return std::nullopt;
+    }
+    std::uint64_t value = 0;
+    for (const char c : *text) {
+        if (c < '0' || c > '9') {
+            return std::nullopt;
+        }
+        value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+    return value;
+}
+
+std::string ToJsonString(std::string_view str) {
+    std::string result = "\"";
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+Request MakeRequest(http::verb method, std::string target, std::string_view token = {},
+                    std::string body = {}) {
+    Request request{method, target, 11};
+    if (!token.empty()) {
+        request.set(http::field::authorization, "Bearer "s + std::string{token});
+    }
+    if (!body.empty()) {
+        request.set(http::field::content_type, "application/json"sv);
+        request.body() = std::move(body);
+    }
+    request.keep_alive(true);
+    return request;
+}
+
+// Процессорное время процесса pid: сумма utime и stime из /proc/<pid>/stat
+std::optional<std::chrono::duration<double>> GetProcessCpuTime(int pid) {
+    std::ifstream file{"/proc/"s + std::to_string(pid) + "/stat"s};
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return std::nullopt;
+    }
+    // Имя процесса в скобках может содержать пробелы, поэтому поля отсчитываются от ')'
+    const auto name_end = stat.rfind(')');
+    if (name_end == std::string::npos) {
+        return std::nullopt;
+    }
+    std::istringstream fields{stat.substr(name_end + 1)};
+    std::string skipped;
+    // Поля с 3 по 13, utime и stime - 14 и 15 поля
+    for (int field = 3; field <= 13; ++field) {
+        fields >> skipped;
+    }
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    if (!(fields >> utime >> stime)) {
+        return std::nullopt;
+    }
+    return std::chrono::duration<double>{static_cast<double>(utime + stime)
+                                         / static_cast<double>(::sysconf(_SC_CLK_TCK))};
+}
+
+// Результаты одного бота. Бот изменяет их только в своём strand-е
+struct Stats {
+    std::uint64_t actions = 0;
+    std::uint64_t polls = 0;
+    std::uint64_t non_2xx = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t unseen_actions = 0;
+    std::vector<std::uint32_t> action_latencies_us;
+    std::vector<std::uint32_t> state_latencies_us;
+    std::vector<std::uint32_t> visible_latencies_us;
+};
+
+// Моменты, когда боты впервые увидели каждый следующий тик
+class TickTracker {
+public:
+    void Observe(std::uint64_t tick, Clock::time_point now, bool record) {
+        std::lock_guard lock{mutex_};
+        if (last_tick_ && tick <= *last_tick_) {
+            return;
+        }
+        if (last_tick_ && record) {
+            intervals_us_.push_back(ToMicroseconds((now - last_seen_) / (tick - *last_tick_)));
+        }
+        last_tick_ = tick;
+        last_seen_ = now;
+    }
+
+    // Вызывается после завершения работы io_context
+    const std::vector<std::uint32_t>& GetIntervals() const noexcept {
+        return intervals_us_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::optional<std::uint64_t> last_tick_;
+    Clock::time_point last_seen_;
+    std::vector<std::uint32_t> intervals_us_;
+};
+
+// Общее состояние роя, доступное ботам из разных потоков
+struct Shared {
+    Shared(net::io_context& ioc, const Config& config)
+        : config{config}
+        , client{ioc, http_client::ClientOptions{.max_connections_per_host = std::max(1u, config.connections),
+                                                 .pipeline_depth = std::max(1u, config.pipeline)}} {
+    }
+
+    const Config& config;
+    http_client::Client client;
+    std::atomic<bool> measuring{false};
+    std::atomic<bool> stopped{false};
+    std::atomic<unsigned> joined{0};
+    std::atomic<unsigned> in_flight{0};
+    TickTracker ticks;
+};
+
+class Bot : public std::enable_shared_from_this<Bot> {
+public:
+    Bot(net::io_context& ioc, Shared& shared, unsigned index)
+        : shared_{shared}
+        , strand_{net::make_strand(ioc)}
+        , action_timer_{strand_}
+        , poll_timer_{strand_}
+        , index_{index}
+        , random_{index + 1} {
+    }
+
+    void Start(Clock::duration delay) {
+        action_timer_.expires_after(delay);
+        action_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Join();
+            }
+        });
+    }
+
+    // Вызывается после завершения работы io_context
+    const Stats& GetStats() const noexcept {
+        return stats_;
+    }
+
+private:
+    using ResponseMethod = void (Bot::*)(sys::error_code ec, Response&& response, Clock::time_point sent);
+
+    // Ответ обрабатывается в strand-е бота, а не в strand-е пула соединений клиента
+    void Send(Request request, ResponseMethod on_response) {
+        ++shared_.in_flight;
+        shared_.client.AsyncRequest(
+            shared_.config.host, shared_.config.port, std::move(request),
+            [self = shared_from_this(), on_response, sent = Clock::now()](sys::error_code ec,
+                                                                          Response&& response) {
+                net::post(self->strand_, [self, on_response, sent, ec, response = std::move(response)]() mutable {
+                    ((*self).*on_response)(ec, std::move(response), sent);
+                    --self->shared_.in_flight;
+                });
+            });
+    }
+
+    // Учитывает ошибку или код ответа. Возвращает true для успешного ответа
+    bool Check(sys::error_code ec, const Response& response) {
+        const bool ok = !ec && response.result_int() / 100 == 2;
+        if (!ok && shared_.measuring) {
+            ++(ec ? stats_.errors : stats_.non_2xx);
+        }
+        return ok;
+    }
+
+    void Join() {
+        if (shared_.stopped) {
+            return;
+        }
+        const auto& maps = shared_.config.maps;
+        std::string body = "{\"userName\":"s + ToJsonString("bot"s + std::to_string(index_))
+                         + ",\"mapId\":"s + ToJsonString(maps[index_ % maps.size()]) + "}"s;
+        Send(MakeRequest(http::verb::post, "/api/v1/game/join"s, {}, std::move(body)), &Bot::OnJoin);
+    }
+
+    void OnJoin(sys::error_code ec, Response&& response, Clock::time_point) {
+        if (!Check(ec, response)) {
+            return;
+        }
+        const auto token = FindValue(response.body(), "authToken"sv);
+        const auto player_id = FindNumber(response.body(), "playerId"sv);
+        if (!token || !player_id) {
+            return;
+        }
+        token_ = *token;
+        player_key_ = '"' + std::to_string(*player_id) + "\":{"s;
+        ++shared_.joined;
+        Poll();
+        ScheduleAction();
+    }
+
+    void ScheduleAction() {
+        std::exponential_distribution<double> delay{std::max(shared_.config.actions_per_second, 1e-3)};
+        action_timer_.expires_after(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>{delay(random_)}));
+        action_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Act();
+            }
+        });
+    }
+
+    void Act() {
+        if (shared_.stopped) {
+            return;
+        }
+        // Новое направление отличается от текущего, иначе его появление в состоянии не заметить
+        std::string_view move;
+        do {
+            move = MOVES[std::uniform_int_distribution<size_t>{0, std::size(MOVES) - 1}(random_)];
+        } while (move == direction_);
+        if (pending_move_ && shared_.measuring) {
+            ++stats_.unseen_actions;
+        }
+        pending_move_ = move;
+        pending_since_ = Clock::now();
+        Send(MakeRequest(http::verb::post, "/api/v1/game/player/action"s, token_,
+                         "{\"move\":\""s + std::string{move} + "\"}"s),
+             &Bot::OnAction);
+        ScheduleAction();
+    }
+
+    void OnAction(sys::error_code ec, Response&& response, Clock::time_point sent) {
+        if (Check(ec, response) && shared_.measuring) {
+            ++stats_.actions;
+            stats_.action_latencies_us.push_back(ToMicroseconds(Clock::now() - sent));
+        }
+    }
+
+    void Poll() {
+        if (shared_.stopped) {
+            return;
+        }
+        std::string target = "/api/v1/game/state"s;
+        if (shared_.config.delta_state && last_tick_) {
+            target += "?since_tick="s + std::to_string(*last_tick_);
+        }
+        Send(MakeRequest(http::verb::get, std::move(target), token_), &Bot::OnState);
+    }
+
+    void OnState(sys::error_code ec, Response&& response, Clock::time_point sent) {
+        const auto now = Clock::now();
+        if (Check(ec, response)) {
+            const bool measuring = shared_.measuring;
+            if (measuring) {
+                ++stats_.polls;
+                stats_.state_latencies_us.push_back(ToMicroseconds(now - sent));
+            }
+            const std::string_view body = response.body();
+            if (const auto tick = FindNumber(body, "tick"sv)) {
+                shared_.ticks.Observe(*tick, now, measuring);
+                last_tick_ = tick;
+            }
+            // Своего игрока нет в ответе с изменениями, если он с тех пор не менялся
+            if (const auto pos = body.find(player_key_); pos != std::string_view::npos) {
+                if (const auto dir = FindValue(body, "dir"sv, pos)) {
+                    direction_ = *dir;
+                }
+            }
+            if (pending_move_ && direction_ == *pending_move_) {
+                if (measuring) {
+                    stats_.visible_latencies_us.push_back(ToMicroseconds(now - pending_since_));
+                }
+                pending_move_.reset();
+            }
+        }
+        // Следующий запрос не раньше чем через poll_interval после предыдущего, как у клиента,
+        // который запрашивает состояние на каждом кадре и не отправляет запросы одновременно
+        poll_timer_.expires_at(sent + shared_.config.poll_interval);
+        poll_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Poll();
+            }
+        });
+    }
+
+    Shared& shared_;
+    Strand strand_;
+    net::steady_timer action_timer_;
+    net::steady_timer poll_timer_;
+    const unsigned index_;
+    std::minstd_rand random_;
+
+    std::string token_;
+    // Начало объекта игрока в ответе /state: "<id>":{
+    std::string player_key_;
+    std::string direction_;
+    std::optional<std::uint64_t> last_tick_;
+    // Отправленное направление, ещё не замеченное в состоянии
+    std::optional<std::string_view> pending_move_;
+    Clock::time_point pending_since_;
+    Stats stats_;
+};
+
+// Двигает время игры запросами /api/v1/game/tick, не отправляя следующий до ответа на предыдущий
+class TickDriver : public std::enable_shared_from_this<TickDriver> {
+public:
+    TickDriver(net::io_context& ioc, Shared& shared, std::chrono::milliseconds period)
+        : shared_{shared}
+        , strand_{net::make_strand(ioc)}
+        , timer_{strand_}
+        , period_{period} {
+    }
+
+    void Start() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            self->Tick();
+        });
+    }
+
+    // Вызывается после завершения работы io_context
+    const std::vector<std::uint32_t>& GetLatencies() const noexcept {
+        return latencies_us_;
+    }
+
+private:
+    void Tick() {
+        if (shared_.stopped) {
+            return;
+        }
+        const auto sent = Clock::now();
+        ++shared_.in_flight;
+        shared_.client.AsyncRequest(
+            shared_.config.host, shared_.config.port,
+            MakeRequest(http::verb::post, "/api/v1/game/tick"s, {},
+                        "{\"timeDelta\":"s + std::to_string(period_.count()) + "}"s),
+            [self = shared_from_this(), sent](sys::error_code ec, Response&& response) {
+                net::post(self->strand_, [self, sent, ok = !ec && response.result_int() / 100 == 2] {
+                    self->OnTick(ok, sent);
+                    --self->shared_.in_flight;
+                });
+            });
+    }
+
+    void OnTick(bool ok, Clock::time_point sent) {
+        if (ok && shared_.measuring) {
+            latencies_us_.push_back(ToMicroseconds(Clock::now() - sent));
+        }
+        timer_.expires_at(sent + period_);
+        timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Tick();
+            }
+        });
+    }
+
+    Shared& shared_;
+    Strand strand_;
+    net::steady_timer timer_;
+    std::chrono::milliseconds period_;
+    std::vector<std::uint32_t> latencies_us_;
+};
+
+std::uint32_t Percentile(const std::vector<std::uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+void Append(std::vector<std::uint32_t>& to, const std::vector<std::uint32_t>& from) {
+    to.insert(to.end(), from.begin(), from.end());
+}
+
+void PrintLatencies(std::ostream& out, std::string_view name, const std::vector<std::uint32_t>& sorted) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-22s p50 %8.2f, p90 %8.2f, p99 %8.2f, max %8.2f ms (%zu samples)\n",
+                  std::string{name}.c_str(), Percentile(sorted, 50) / 1000.0, Percentile(sorted, 90) / 1000.0,
+                  Percentile(sorted, 99) / 1000.0, sorted.empty() ? 0.0 : sorted.back() / 1000.0,
+                  sorted.size());
+    out << line;
+}
+
+}  // namespace
+
+Report Run(const Config& config) {
+    if (config.maps.empty() || config.bots == 0) {
+        throw std::invalid_argument("No bots or maps to play on");
+    }
+    net::io_context ioc(static_cast<int>(config.threads));
+    Shared shared{ioc, config};
+
+    std::vector<std::shared_ptr<Bot>> bots;
+    bots.reserve(config.bots);
+    for (unsigned i = 0; i < config.bots; ++i) {
+        bots.push_back(std::make_shared<Bot>(ioc, shared, i));
+        // Боты подключаются равномерно, чтобы не измерять лавину одновременных входов
+        bots.back()->Start(config.ramp_up * i / config.bots);
+    }
+    std::shared_ptr<TickDriver> tick_driver;
+    if (config.tick_period) {
+        tick_driver = std::make_shared<TickDriver>(ioc, shared, *config.tick_period);
+        tick_driver->Start();
+    }
+
+    Report report;
+    Clock::time_point start;
+    std::optional<std::chrono::duration<double>> cpu_at_start;
+    net::steady_timer timer{ioc, config.ramp_up};
+    timer.async_wait([&](sys::error_code) {
+        start = Clock::now();
+        cpu_at_start = config.server_pid ? GetProcessCpuTime(*config.server_pid) : std::nullopt;
+        shared.measuring = true;
+    });
+    // По окончании измерений боты перестают отправлять запросы, а рой дожидается ответов
+    // на уже отправленные. Если сервер не отвечает на часть из них, ожидание прекращается
+    // принудительно через DRAIN_TIMEOUT
+    net::steady_timer stop_timer{ioc, config.ramp_up + config.duration};
+    std::function<void(sys::error_code)> on_stop = [&](sys::error_code) {
+        if (!shared.stopped) {
+            shared.measuring = false;
+            shared.stopped = true;
+            report.elapsed = Clock::now() - start;
+            if (cpu_at_start) {
+                if (const auto cpu = GetProcessCpuTime(*config.server_pid)) {
+                    report.server_cpu = *cpu - *cpu_at_start;
+                }
+            }
+        }
+        if (shared.in_flight == 0 || Clock::now() - start >= config.duration + DRAIN_TIMEOUT) {
+            // Пулы держат открытые соединения, поэтому io_context не остановится сам
+            shared.client.Shutdown();
+            return ioc.stop();
+        }
+        stop_timer.expires_after(10ms);
+        stop_timer.async_wait(on_stop);
+    };
+    stop_timer.async_wait(on_stop);
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned i = 1; i < config.threads; ++i) {
+            workers.emplace_back([&ioc] {
+                ioc.run();
+            });
+        }
+        ioc.run();
+    }
+
+    report.joined = shared.joined;
+    for (const auto& bot : bots) {
+        const auto& stats = bot->GetStats();
+        report.actions += stats.actions;
+        report.polls += stats.polls;
+        report.non_2xx += stats.non_2xx;
+        report.errors += stats.errors;
+        report.unseen_actions += stats.unseen_actions;
+        Append(report.action_latencies_us, stats.action_latencies_us);
+        Append(report.state_latencies_us, stats.state_latencies_us);
+        Append(report.visible_latencies_us, stats.visible_latencies_us);
+    }
+    report.tick_intervals_us = shared.ticks.GetIntervals();
+    if (tick_driver) {
+        report.tick_request_latencies_us = tick_driver->GetLatencies();
+    }
+    for (auto* latencies : {&report.action_latencies_us, &report.state_latencies_us, &report.visible_latencies_us,
+                            &report.tick_intervals_us, &report.tick_request_latencies_us}) {
+        std::sort(latencies->begin(), latencies->end());
+    }
+    if (report.joined == 0) {
+        throw std::runtime_error("No bot could join the game");
+    }
+    return report;
+}
+
+void PrintReport(std::ostream& out, const Report& report) {
+    const double seconds = report.elapsed.count();
+    const auto per_second = [seconds](std::uint64_t count) {
+        return seconds > 0 ? static_cast<double>(count) / seconds : 0.0;
+    };
+    char line[256];
+    std::snprintf(line, sizeof(line), "Bots joined: %u, measured for %.2f s\n", report.joined, seconds);
+    out << line;
+    std::snprintf(line, sizeof(line), "Actions: %llu (%.1f/s), state polls: %llu (%.1f/s)\n",
+                  static_cast<unsigned long long>(report.actions), per_second(report.actions),
+                  static_cast<unsigned long long>(report.polls), per_second(report.polls));
+    out << line;
+    std::snprintf(line, sizeof(line), "Non-2xx responses: %llu, errors: %llu, actions never seen: %llu\n",
+                  static_cast<unsigned long long>(report.non_2xx), static_cast<unsigned long long>(report.errors),
+                  static_cast<unsigned long long>(report.unseen_actions));
+    out << line;
+    PrintLatencies(out, "Action request:"sv, report.action_latencies_us);
+    PrintLatencies(out, "State request:"sv, report.state_latencies_us);
+    PrintLatencies(out, "Action to visible:"sv, report.visible_latencies_us);
+    PrintLatencies(out, "Tick interval:"sv, report.tick_intervals_us);
+    if (!report.tick_request_latencies_us.empty()) {
+        PrintLatencies(out, "Tick request:"sv, report.tick_request_latencies_us);
+    }
+    if (report.server_cpu && seconds > 0) {
+        const double cpu_share = report.server_cpu->count() / seconds;
+        std::snprintf(line, sizeof(line), "Server CPU: %.1f%% of a core, %.3f ms per second per player\n",
+                      cpu_share * 100.0, cpu_share * 1000.0 / report.joined);
+        out << line;
+    }
+}
+
+}  // namespace swarm
@@ -0,0 +1,78 @@
+#pragma once
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace swarm {
+
+/*
+ * Рой ботов, играющих на игровом сервере через его HTTP API:
+ *  POST /api/v1/game/join {"userName":..., "mapId":...} -> {"authToken":..., "playerId":...}
+ *  POST /api/v1/game/player/action {"move":"L"|"R"|"U"|"D"}
+ *  GET  /api/v1/game/state -> {"tick":..., "players":{"<id>":{"dir":..., ...}, ...}}
+ *  POST /api/v1/game/tick {"timeDelta":...}, если тиками управляет рой
+ * Все боты отправляют запросы через один http_client::Client с пулом постоянных соединений.
+ */
+struct Config {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    unsigned bots = 1000;
+    // Карты, на которые боты заходят по очереди
+    std::vector<std::string> maps;
+    // Боты подключаются равномерно в течение ramp_up, и только затем начинаются измерения
+    std::chrono::seconds ramp_up{10};
+    std::chrono::seconds duration{30};
+    // Средняя частота смены направления одним ботом. Интервалы между действиями
+    // распределены экспоненциально, как у независимых игроков
+    double actions_per_second = 1.0;
+    // Как часто бот запрашивает состояние игры, как браузерный клиент на каждом кадре
+    std::chrono::milliseconds poll_interval{100};
+    // Запрашивать только изменения после последнего полученного тика (since_tick)
+    bool delta_state = false;
+    // Если задан, рой сам двигает время игры запросами /api/v1/game/tick с этим шагом.
+    // Нужен серверам, запущенным без --tick-period
+    std::optional<std::chrono::milliseconds> tick_period;
+    unsigned threads = 1;
+    unsigned connections = 64;
+    unsigned pipeline = 1;
+    // Процесс сервера на этой же машине, чтобы измерить потреблённое им процессорное время
+    std::optional<int> server_pid;
+};
+
+struct Report {
+    // Длительность измерений, без подключения ботов
+    std::chrono::duration<double> elapsed{};
+    unsigned joined = 0;
+    std::uint64_t actions = 0;
+    std::uint64_t polls = 0;
+    std::uint64_t non_2xx = 0;
+    std::uint64_t errors = 0;
+    // Отсортированные задержки ответов в микросекундах
+    std::vector<std::uint32_t> action_latencies_us;
+    std::vector<std::uint32_t> state_latencies_us;
+    // От отправки действия до первого ответа /state, в котором видно новое направление
+    std::vector<std::uint32_t> visible_latencies_us;
+    // Действия, которые бот так и не увидел в состоянии до следующего своего действия
+    std::uint64_t unseen_actions = 0;
+    // Интервалы между соседними тиками, как их видят боты: моменты первого появления
+    // номера тика в ответах /state, делённые на разность номеров
+    std::vector<std::uint32_t> tick_intervals_us;
+    // Время выполнения запросов /api/v1/game/tick, если тиками управлял рой
+    std::vector<std::uint32_t> tick_request_latencies_us;
+    // Процессорное время сервера за время измерений, если был задан server_pid
+    std::optional<std::chrono::duration<double>> server_cpu;
+};
+
+// Запускает рой в соответствии с config и возвращает результаты измерений.
+// В случае ошибки разрешения адреса или подключения ботов выбрасывает исключение
+Report Run(const Config& config);
+
+void PrintReport(std::ostream& out, const Report& report);
+
+}  // namespace swarm
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "swarm.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::optional<swarm::Config> ParseCommandLine(int argc, const char* const argv[]) {
+    swarm::Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--delta-state"sv) {
+            config.delta_state = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--host"sv) {
+                config.host = value;
+            } else if (arg == "--port"sv) {
+                config.port = value;
+            } else if (arg == "--bots"sv) {
+                config.bots = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--map"sv) {
+                config.maps.push_back(value);
+            } else if (arg == "--ramp-up"sv) {
+                config.ramp_up = std::chrono::seconds{std::stoul(value)};
+            } else if (arg == "--duration"sv) {
+                config.duration = std::chrono::seconds{std::stoul(value)};
+            } else if (arg == "--actions-per-second"sv) {
+                config.actions_per_second = std::stod(value);
+            } else if (arg == "--poll-interval"sv) {
+                config.poll_interval = std::chrono::milliseconds{std::stoul(value)};
+            } else if (arg == "--tick-period"sv) {
+                config.tick_period = std::chrono::milliseconds{std::stoul(value)};
+            } else if (arg == "--threads"sv) {
+                config.threads = std::max(1u, static_cast<unsigned>(std::stoul(value)));
+            } else if (arg == "--connections"sv) {
+                config.connections = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--pipeline"sv) {
+                config.pipeline = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--server-pid"sv) {
+                config.server_pid = std::stoi(value);
+            } else {
+                return std::nullopt;
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    if (config.maps.empty()) {
+        config.maps.push_back("map1"s);
+    }
+    return config;
+}
+
+}  // namespace
+
+/*
+ * Нагружает игровой сервер роем ботов и печатает задержки запросов, время от действия
+ * до его появления в состоянии игры, интервалы между тиками и процессорное время сервера
+ * на одного игрока
+ */
+int main(int argc, const char* argv[]) {
+    const auto config = ParseCommandLine(argc, argv);
+    if (!config) {
+        std::cerr << "Usage: bot_swarm [--host <host>] [--port <port>] [--bots <n>] [--map <id>]... "sv
+                  << "[--ramp-up <seconds>] [--duration <seconds>] [--actions-per-second <rate>] "sv
+                  << "[--poll-interval <ms>] [--delta-state] [--tick-period <ms>] [--threads <n>] "sv
+                  << "[--connections <n>] [--pipeline <depth>] [--server-pid <pid>]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        swarm::PrintReport(std::cout, swarm::Run(*config));
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,70 @@
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "game_file.h"
+#include "json_loader.h"
+#include "request_handler.h"
+
+/*
+ * Замеры загрузки конфигурации и сериализации карт в JSON.
+ * ResponseCache сериализует список карт и каждую карту и сжимает ответы при первом
+ * запросе, так же как после перезагрузки карт.
+ * Запуск: game_server_benchmarks [параметры bench_harness.h] [конфигурация, по умолчанию
+ * data/config.json]
+ */
+
+using namespace std::literals;
+namespace fs = std::filesystem;
+namespace http = boost::beast::http;
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"map_json", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const fs::path config = options.positional.empty() ? "data/config.json"s : options.positional[0];
+    const auto config_size = static_cast<size_t>(fs::file_size(config));
+
+    suite.Run("json_loader::LoadGame", [&] {
+        bench::DoNotOptimize(json_loader::LoadGame(config).GetMaps().size());
+    }, config_size);
+
+    const auto game = std::make_shared<const model::Game>(json_loader::LoadGame(config));
+    const auto game_path = fs::temp_directory_path() / "game_server_benchmarks.game";
+    game_file::SaveGame(*game, game_path);
+    suite.Run("game_file::LoadGame", [&] {
+        bench::DoNotOptimize(game_file::LoadGame(game_path).GetMaps().size());
+    }, static_cast<size_t>(fs::file_size(game_path)));
+    fs::remove(game_path);
+
+    // Ответы кэша строятся при первом запросе, поэтому построение всех ответов
+    // измеряется запросами каждой карты к новому кэшу
+    std::vector<std::string> map_targets{"/api/v1/maps"s};
+    for (const auto& map : game->GetMaps()) {
+        map_targets.push_back("/api/v1/maps/"s + *map.GetId());
+    }
+    const auto get_all = [&map_targets](const http_handler::ResponseCache& cache) {
+        size_t built = 0;
+        for (const auto& target : map_targets) {
+            cache.Find(http::verb::get, target).Get([&built](const auto* response) {
+                built += response != nullptr;
+            });
+        }
+        return built;
+    };
+    suite.Run("ResponseCache/build", [&] {
+        const http_handler::ResponseCache cache{game};
+        bench::DoNotOptimize(get_all(cache));
+    });
+
+    const http_handler::ResponseCache cache{game};
+    get_all(cache);
+    suite.Run("ResponseCache/find-map", [&] {
+        bench::DoNotOptimize(cache.Find(http::verb::get, map_targets.back()).TryGet());
+    });
+    suite.Run("ResponseCache/find-map-list", [&] {
+        bench::DoNotOptimize(cache.Find(http::verb::get, map_targets.front()).TryGet());
+    });
+    return suite.Finish();
+}
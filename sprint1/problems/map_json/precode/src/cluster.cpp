@@ -0,0 +1,124 @@
+#include "cluster.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace cluster {
+
+using namespace std::literals;
+
+std::uint64_t HashKey(std::string_view key) noexcept {
+    // FNV-1a плохо перемешивает близкие строки вроде "node-1#1" и "node-1#2",
+    // поэтому результат дополнительно проходит финализатор splitmix64
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : key) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+std::string MakeSessionKey(std::string_view map_id, std::string_view instance) {
+    std::string key;
+    key.reserve(map_id.size() + instance.size() + 1);
+    key += map_id;
+    key += '/';
+    key += instance;
+    return key;
+}
+
+HashRing::HashRing(std::vector<Node> nodes, size_t virtual_nodes)
+    : nodes_{std::move(nodes)} {
+    points_.reserve(nodes_.size() * virtual_nodes);
+    std::string point_name;
+    for (std::uint32_t i = 0; i < nodes_.size(); ++i) {
+        for (size_t v = 0; v < virtual_nodes; ++v) {
+            point_name = nodes_[i].id;
+            point_name += '#';
+            point_name += std::to_string(v);
+            points_.emplace_back(HashKey(point_name), i);
+        }
+    }
+    // При совпадении хешей точек владелец определяется индексом, но узлы в списке
+    // могут идти в разном порядке, поэтому сравниваются их идентификаторы
+    std::sort(points_.begin(), points_.end(), [this](const auto& lhs, const auto& rhs) {
+        if (lhs.first != rhs.first) {
+            return lhs.first < rhs.first;
+        }
+        return nodes_[lhs.second].id < nodes_[rhs.second].id;
+    });
+}
+
+const Node* HashRing::FindOwner(std::string_view key) const noexcept {
+    if (points_.empty()) {
+        return nullptr;
+    }
+    const std::uint64_t hash = HashKey(key);
+    auto it = std::lower_bound(points_.begin(), points_.end(), hash,
+                               [](const auto& point, std::uint64_t value) {
+                                   return point.first < value;
+                               });
+    // Кольцо замкнуто: ключи после последней точки принадлежат первой
+    if (it == points_.end()) {
+        it = points_.begin();
+    }
+    return &nodes_[it->second];
+}
+
+std::vector<Node> LoadNodes(const std::filesystem::path& file) {
+    std::ifstream in{file};
+    if (!in) {
+        throw std::runtime_error("Failed to open "s + file.string());
+    }
+    std::vector<Node> nodes;
+    std::unordered_set<std::string> ids;
+    std::string line;
+    for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+        std::istringstream fields{line};
+        Node node;
+        if (!(fields >> node.id) || node.id.starts_with('#')) {
+            continue;
+        }
+        std::string extra;
+        if (!(fields >> node.base_url) || fields >> extra) {
+            throw std::runtime_error(file.string() + ":"s + std::to_string(line_number)
+                                     + ": expected <node-id> <base-url>"s);
+        }
+        while (node.base_url.ends_with('/')) {
+            node.base_url.pop_back();
+        }
+        if (!ids.insert(node.id).second) {
+            throw std::runtime_error(file.string() + ": duplicate node "s + node.id);
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+Cluster::Cluster(std::string self_id, std::vector<Node> nodes)
+    : self_id_{std::move(self_id)}
+    , ring_{std::make_shared<const HashRing>(std::move(nodes))} {
+}
+
+std::optional<std::string> Cluster::FindRemoteOwner(std::string_view key) const {
+    const auto ring = ring_.load();
+    const Node* owner = ring->FindOwner(key);
+    if (!owner || owner->id == self_id_) {
+        return std::nullopt;
+    }
+    return owner->base_url;
+}
+
+void Cluster::SetNodes(std::vector<Node> nodes) {
+    ring_.store(std::make_shared<const HashRing>(std::move(nodes)));
+}
+
+}  // namespace cluster
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cluster {
+
+// Узел кластера: идентификатор и адрес, по которому к нему обращаются клиенты,
+// например "http://10.0.0.2:8080"
+struct Node {
+    std::string id;
+    std::string base_url;
+};
+
+/*
+ * Хеш-кольцо для согласованного хеширования (consistent hashing).
+ * Каждый узел занимает на кольце virtual_nodes точек, а ключ принадлежит узлу первой
+ * точки, не меньшей хеша ключа. Поэтому при добавлении или удалении узла меняют владельца
+ * только ключи, попадающие на его точки, - в среднем 1/N всех ключей, - а остальные
+ * остаются на прежних узлах.
+ * Хеш не зависит от платформы и сборки, так что все узлы строят одинаковое кольцо.
+ */
+class HashRing {
+public:
+    constexpr static size_t DEFAULT_VIRTUAL_NODES = 128;
+
+    explicit HashRing(std::vector<Node> nodes, size_t virtual_nodes = DEFAULT_VIRTUAL_NODES);
+
+    // Возвращает узел, владеющий ключом, или nullptr, если кольцо пусто
+    const Node* FindOwner(std::string_view key) const noexcept;
+
+    const std::vector<Node>& GetNodes() const noexcept {
+        return nodes_;
+    }
+
+private:
+    std::vector<Node> nodes_;
+    // Точки кольца, упорядоченные по хешу: хеш и индекс узла в nodes_
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> points_;
+};
+
+// Стабильный 64-битный хеш строки
+std::uint64_t HashKey(std::string_view key) noexcept;
+
+// Ключ игрового сеанса: экземпляр instance карты map_id
+std::string MakeSessionKey(std::string_view map_id, std::string_view instance);
+
+/*
+ * Читает список узлов. Каждая непустая строка файла, кроме начинающихся с #,
+ * содержит идентификатор узла и его адрес через пробел:
+ *   node-1 http://10.0.0.1:8080
+ * В случае ошибки выбрасывает std::runtime_error
+ */
+std::vector<Node> LoadNodes(const std::filesystem::path& file);
+
+/*
+ * Размещение игровых сеансов по узлам кластера.
+ * Узлы не обмениваются состоянием: каждый сам вычисляет владельца сеанса по общему
+ * списку узлов, поэтому запросы к своим сеансам обслуживаются без обращений к другим узлам,
+ * а чужие перенаправляются владельцу.
+ * Список узлов можно заменить из любого потока (SetNodes). Сеансы, сменившие владельца,
+ * перенаправляются новому владельцу со следующего запроса. Узел, исключённый из списка,
+ * перенаправляет все сеансы, пока его не остановят.
+ */
+class Cluster {
+public:
+    Cluster(std::string self_id, std::vector<Node> nodes);
+
+    Cluster(const Cluster&) = delete;
+    Cluster& operator=(const Cluster&) = delete;
+
+    // Возвращает адрес узла, владеющего сеансом key, если это не текущий узел
+    std::optional<std::string> FindRemoteOwner(std::string_view key) const;
+
+    void SetNodes(std::vector<Node> nodes);
+
+    size_t GetNodeCount() const {
+        return ring_.load()->GetNodes().size();
+    }
+
+private:
+    std::string self_id_;
+    std::atomic<std::shared_ptr<const HashRing>> ring_;
+};
+
+}  // namespace cluster
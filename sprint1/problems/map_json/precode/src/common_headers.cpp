@@ -0,0 +1,47 @@
+#include "common_headers.h"
+
+#include <ctime>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+std::shared_ptr<const CommonHeaders> MakeCommonHeaders(std::time_t now) {
+    std::tm tm{};
+    gmtime_r(&now, &tm);
+    char date[32];
+    const size_t size = std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    auto headers = std::make_shared<CommonHeaders>();
+    headers->date.assign(date, size);
+    headers->block.reserve("Date: \r\nServer: \r\n"sv.size() + size + SERVER_NAME.size());
+    headers->block.append("Date: "sv)
+        .append(headers->date)
+        .append("\r\nServer: "sv)
+        .append(SERVER_NAME)
+        .append("\r\n"sv);
+    return headers;
+}
+
+}  // namespace
+
+const std::shared_ptr<const CommonHeaders>& GetCommonHeaders() {
+    thread_local std::time_t second = -1;
+    thread_local std::shared_ptr<const CommonHeaders> headers;
+    // time() читает время без системного вызова и с точностью до секунды,
+    // которой достаточно заголовку Date
+    if (const std::time_t now = std::time(nullptr); now != second) {
+        headers = MakeCommonHeaders(now);
+        second = now;
+    }
+    return headers;
+}
+
+size_t GetStatusLineSize(std::string_view head) noexcept {
+    const auto end = head.find("\r\n"sv);
+    return end == std::string_view::npos ? 0 : end + 2;
+}
+
+}  // namespace http_server
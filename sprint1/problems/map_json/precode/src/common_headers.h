@@ -0,0 +1,31 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace http_server {
+
+// Значение заголовка Server в ответах сервера
+constexpr std::string_view SERVER_NAME = "game_server";
+
+// Заголовки, общие для всех ответов: Date и Server
+struct CommonHeaders {
+    // Значение заголовка Date в формате IMF-fixdate (RFC 7231)
+    std::string date;
+    // Оба заголовка в сериализованном виде, включая завершающие CRLF.
+    // Вставляется в ответ сразу после строки статуса
+    std::string block;
+};
+
+/*
+ * Возвращает общие заголовки для текущей секунды. Блок неизменяем, поэтому его можно
+ * записывать в сокет напрямую, удерживая указатель до окончания записи.
+ * Каждый поток хранит собственный блок и форматирует новый не чаще раза в секунду,
+ * поэтому вызов не обращается к общим данным и не требует синхронизации
+ */
+const std::shared_ptr<const CommonHeaders>& GetCommonHeaders();
+
+// Размер строки статуса сериализованного заголовка ответа, включая CRLF
+size_t GetStatusLineSize(std::string_view head) noexcept;
+
+}  // namespace http_server
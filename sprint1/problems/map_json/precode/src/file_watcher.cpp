@@ -0,0 +1,74 @@
+#include "file_watcher.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <system_error>
+
+namespace util {
+
+namespace {
+
+int OpenInotify(const std::filesystem::path& dir) {
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "inotify_init1");
+    }
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        const int err = errno;
+        close(fd);
+        throw std::system_error(err, std::system_category(), "inotify_add_watch " + dir.string());
+    }
+    return fd;
+}
+
+}  // namespace
+
+FileWatcher::FileWatcher(net::io_context& ioc, const std::filesystem::path& file,
+                         Handler on_changed, std::chrono::milliseconds debounce)
+    : inotify_{ioc, OpenInotify(std::filesystem::absolute(file).parent_path())}
+    , debounce_timer_{ioc}
+    , debounce_{debounce}
+    , file_name_{file.filename().string()}
+    , on_changed_{std::move(on_changed)} {
+    ReadEvents();
+}
+
+void FileWatcher::ReadEvents() {
+    inotify_.async_read_some(net::buffer(buffer_),
+                             [this](boost::system::error_code ec, size_t bytes) {
+                                 if (ec) {
+                                     // Дескриптор закрыт или io_context остановлен
+                                     return;
+                                 }
+                                 OnEvents(bytes);
+                                 ReadEvents();
+                             });
+}
+
+void FileWatcher::OnEvents(size_t bytes) {
+    bool changed = false;
+    // Событие состоит из заголовка inotify_event и имени файла переменной длины
+    for (size_t offset = 0; offset + sizeof(inotify_event) <= bytes;) {
+        inotify_event event;
+        std::memcpy(&event, buffer_.data() + offset, sizeof(event));
+        const char* name = buffer_.data() + offset + sizeof(event);
+        if (event.len != 0 && file_name_ == name) {
+            changed = true;
+        }
+        offset += sizeof(event) + event.len;
+    }
+    if (!changed) {
+        return;
+    }
+    // Перезапуск таймера отменяет ожидание предыдущего изменения
+    debounce_timer_.expires_after(debounce_);
+    debounce_timer_.async_wait([this](boost::system::error_code ec) {
+        if (!ec) {
+            on_changed_();
+        }
+    });
+}
+
+}  // namespace util
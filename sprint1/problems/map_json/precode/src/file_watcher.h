@@ -0,0 +1,47 @@
+#pragma once
+#include "sdk.h"
+//
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace util {
+
+namespace net = boost::asio;
+
+/*
+ * Следит за изменением файла через inotify и вызывает обработчик в потоке io_context.
+ * Наблюдается каталог файла, поэтому замечается и запись на месте, и замена файла
+ * переименованием, которой пользуются редакторы и системы развёртывания.
+ * Серия изменений, пришедших одна за другой, приводит к одному вызову обработчика
+ * по истечении паузы debounce после последнего изменения.
+ * Наблюдатель должен существовать, пока работает io_context.
+ */
+class FileWatcher {
+public:
+    using Handler = std::function<void()>;
+
+    FileWatcher(net::io_context& ioc, const std::filesystem::path& file, Handler on_changed,
+                std::chrono::milliseconds debounce = std::chrono::milliseconds{200});
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+    void ReadEvents();
+    void OnEvents(size_t bytes);
+
+    net::posix::stream_descriptor inotify_;
+    net::steady_timer debounce_timer_;
+    std::chrono::milliseconds debounce_;
+    std::string file_name_;
+    Handler on_changed_;
+    alignas(8) std::array<char, 4096> buffer_;
+};
+
+}  // namespace util
@@ -0,0 +1,26 @@
+// Компилирует JSON-конфигурацию игры в двоичный файл, который сервер загружает без разбора
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+
+#include "game_file.h"
+#include "json_loader.h"
+
+using namespace std::literals;
+
+int main(int argc, const char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: game_compile <game-config-json> <output-file>"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        const model::Game game = json_loader::LoadGame(argv[1]);
+        game_file::SaveGame(game, argv[2]);
+        // Убеждаемся, что записанный файл загружается
+        const model::Game compiled = game_file::LoadGame(argv[2]);
+        std::cout << "Compiled "sv << compiled.GetMaps().size() << " maps"sv << std::endl;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,322 @@
+#include "game_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace game_file {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC{'G', 'A', 'M', 'E', 'B', 'I', 'N', '\0'};
+// Записывается в заголовок, чтобы обнаружить файл с другим порядком байтов
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Все поля файла выровнены на размер числа, чтобы столбцы можно было читать на месте
+constexpr size_t ALIGNMENT = sizeof(std::int32_t);
+
+static_assert(sizeof(model::Coord) == sizeof(std::int32_t)
+              && sizeof(model::Dimension) == sizeof(std::int32_t));
+
+struct Header {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t file_size;
+    std::uint32_t map_count;
+    std::uint32_t reserved;
+};
+
+class Writer {
+public:
+    void WriteHeader(std::uint32_t map_count) {
+        const Header header{MAGIC, FORMAT_VERSION, BYTE_ORDER_MARK, 0, map_count, 0};
+        WriteBytes(&header, sizeof(header));
+    }
+
+    void WriteCount(size_t count) {
+        if (count > UINT32_MAX) {
+            throw std::length_error("Too many objects to save"s);
+        }
+        const auto value = static_cast<std::uint32_t>(count);
+        WriteBytes(&value, sizeof(value));
+    }
+
+    void WriteString(std::string_view str) {
+        WriteCount(str.size());
+        WriteBytes(str.data(), str.size());
+    }
+
+    // Записывает значения столбца без длины: все столбцы одного объекта одинаковой длины
+    void WriteColumn(const std::vector<std::int32_t>& column) {
+        WriteBytes(column.data(), column.size() * sizeof(std::int32_t));
+    }
+
+    // Возвращает содержимое файла, дописав его размер в заголовок
+    std::string Finish() && {
+        const std::uint64_t size = data_.size();
+        std::memcpy(data_.data() + offsetof(Header, file_size), &size, sizeof(size));
+        return std::move(data_);
+    }
+
+private:
+    void WriteBytes(const void* bytes, size_t size) {
+        data_.append(static_cast<const char*>(bytes), size);
+        data_.resize((data_.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+    }
+
+    std::string data_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::span<const char> data) noexcept
+        : data_{data} {
+    }
+
+    Header ReadHeader() {
+        Header header;
+        ReadBytes(&header, sizeof(header));
+        if (header.magic != MAGIC) {
+            throw std::runtime_error("Not a game file"s);
+        }
+        if (header.byte_order != BYTE_ORDER_MARK) {
+            throw std::runtime_error("Game file has different byte order"s);
+        }
+        if (header.version != FORMAT_VERSION) {
+            throw std::runtime_error("Unsupported game file version "s
+                                     + std::to_string(header.version));
+        }
+        if (header.file_size != data_.size()) {
+            throw std::runtime_error("Game file is truncated"s);
+        }
+        return header;
+    }
+
+    size_t ReadCount() {
+        std::uint32_t value;
+        ReadBytes(&value, sizeof(value));
+        return value;
+    }
+
+    std::string ReadString() {
+        const size_t size = ReadCount();
+        const auto bytes = Take(size);
+        return std::string{bytes.data(), bytes.size()};
+    }
+
+    // Возвращает count значений столбца. Файл отображён в память по границе страницы,
+    // а поля выровнены, поэтому значения читаются без копирования
+    std::span<const std::int32_t> ReadColumn(size_t count) {
+        if (count > data_.size() / sizeof(std::int32_t)) {
+            Fail();
+        }
+        const auto bytes = Take(count * sizeof(std::int32_t));
+        return {reinterpret_cast<const std::int32_t*>(bytes.data()), count};
+    }
+
+    bool AtEnd() const noexcept {
+        return pos_ == data_.size();
+    }
+
+private:
+    [[noreturn]] static void Fail() {
+        throw std::runtime_error("Game file is corrupted"s);
+    }
+
+    std::span<const char> Take(size_t size) {
+        const size_t padded = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        if (padded > data_.size() - pos_) {
+            Fail();
+        }
+        const auto bytes = data_.subspan(pos_, size);
+        pos_ += padded;
+        return bytes;
+    }
+
+    void ReadBytes(void* dst, size_t size) {
+        std::memcpy(dst, Take(size).data(), size);
+    }
+
+    std::span<const char> data_;
+    size_t pos_ = 0;
+};
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open "s + path.string());
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Failed to stat "s + path.string());
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        const int error = errno;
+        // Отображение остаётся действительным и после закрытия дескриптора
+        ::close(fd);
+        if (data_ == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "Failed to map "s + path.string());
+        }
+        if (data_) {
+            ::madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    std::span<const char> GetData() const noexcept {
+        return {static_cast<const char*>(data_), size_};
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+void WriteMap(Writer& writer, const model::Map& map) {
+    writer.WriteString(*map.GetId());
+    writer.WriteString(map.GetName());
+
+    const auto& roads = map.GetRoadColumns();
+    writer.WriteCount(roads.Size());
+    for (const auto* column : {&roads.start_x, &roads.start_y, &roads.end_x, &roads.end_y}) {
+        writer.WriteColumn(*column);
+    }
+
+    const auto& buildings = map.GetBuildingColumns();
+    writer.WriteCount(buildings.Size());
+    for (const auto* column : {&buildings.x, &buildings.y, &buildings.width, &buildings.height}) {
+        writer.WriteColumn(*column);
+    }
+
+    const auto& offices = map.GetOfficeColumns();
+    writer.WriteCount(offices.Size());
+    for (const auto& id : offices.ids) {
+        writer.WriteString(*id);
+    }
+    for (const auto* column : {&offices.x, &offices.y, &offices.offset_x, &offices.offset_y}) {
+        writer.WriteColumn(*column);
+    }
+}
+
+model::Map ReadMap(Reader& reader) {
+    auto id = reader.ReadString();
+    model::Map map{model::Map::Id{std::move(id)}, reader.ReadString()};
+
+    // Дороги и офисы добавляются через методы карты, чтобы карта построила свои индексы
+    const size_t road_count = reader.ReadCount();
+    const auto start_x = reader.ReadColumn(road_count);
+    const auto start_y = reader.ReadColumn(road_count);
+    const auto end_x = reader.ReadColumn(road_count);
+    const auto end_y = reader.ReadColumn(road_count);
+    for (size_t i = 0; i < road_count; ++i) {
+        const model::Point start{start_x[i], start_y[i]};
+        if (start.y == end_y[i]) {
+            map.AddRoad(model::Road{model::Road::HORIZONTAL, start, end_x[i]});
+        } else if (start.x == end_x[i]) {
+            map.AddRoad(model::Road{model::Road::VERTICAL, start, end_y[i]});
+        } else {
+            throw std::runtime_error("Game file is corrupted"s);
+        }
+    }
+
+    const size_t building_count = reader.ReadCount();
+    const auto x = reader.ReadColumn(building_count);
+    const auto y = reader.ReadColumn(building_count);
+    const auto width = reader.ReadColumn(building_count);
+    const auto height = reader.ReadColumn(building_count);
+    for (size_t i = 0; i < building_count; ++i) {
+        map.AddBuilding(model::Building{model::Rectangle{{x[i], y[i]}, {width[i], height[i]}}});
+    }
+
+    const size_t office_count = reader.ReadCount();
+    std::vector<model::Office::Id> office_ids;
+    office_ids.reserve(std::min<size_t>(office_count, 1024));
+    for (size_t i = 0; i < office_count; ++i) {
+        office_ids.emplace_back(reader.ReadString());
+    }
+    const auto office_x = reader.ReadColumn(office_count);
+    const auto office_y = reader.ReadColumn(office_count);
+    const auto offset_x = reader.ReadColumn(office_count);
+    const auto offset_y = reader.ReadColumn(office_count);
+    for (size_t i = 0; i < office_count; ++i) {
+        map.AddOffice(model::Office{std::move(office_ids[i]),
+                                    {office_x[i], office_y[i]},
+                                    {offset_x[i], offset_y[i]}});
+    }
+    return map;
+}
+
+}  // namespace
+
+void SaveGame(const model::Game& game, const std::filesystem::path& path) {
+    Writer writer;
+    writer.WriteHeader(static_cast<std::uint32_t>(game.GetMaps().size()));
+    for (const auto& map : game.GetMaps()) {
+        WriteMap(writer, map);
+    }
+    const std::string data = std::move(writer).Finish();
+
+    // Записываем во временный файл и переименовываем: rename заменяет файл атомарно
+    auto tmp_path = path;
+    tmp_path += ".tmp"sv;
+    {
+        std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write "s + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+model::Game LoadGame(const std::filesystem::path& path) {
+    const MappedFile file{path};
+    Reader reader{file.GetData()};
+
+    const auto header = reader.ReadHeader();
+    model::Game game;
+    for (std::uint32_t i = 0; i < header.map_count; ++i) {
+        game.AddMap(ReadMap(reader));
+    }
+    if (!reader.AtEnd()) {
+        throw std::runtime_error("Game file is corrupted"s);
+    }
+    return game;
+}
+
+bool IsGameFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    std::array<char, MAGIC.size()> magic{};
+    return file.read(magic.data(), magic.size()) && magic == MAGIC;
+}
+
+}  // namespace game_file
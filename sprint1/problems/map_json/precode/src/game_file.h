@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "model.h"
+
+namespace game_file {
+
+/*
+ * Двоичный файл с заранее скомпилированной моделью игры.
+ * Файл содержит карты в том виде, в каком они хранятся в модели: столбцы координат дорог,
+ * зданий и офисов записаны подряд, а строки - вместе с длиной. Ссылок между частями файла
+ * нет, поэтому его можно копировать и отображать в память по любому адресу.
+ * В отличие от JSON-конфигурации файл не разбирается, а лишь проверяется и копируется.
+ * Формат зависит от порядка байтов платформы, и файл, записанный на платформе
+ * с другим порядком байтов, будет отвергнут.
+ */
+
+// Увеличивается при любом несовместимом изменении формата
+constexpr std::uint32_t FORMAT_VERSION = 1;
+
+// Записывает игру в файл path. Файл заменяется целиком, поэтому процессы, которые
+// в это время загружают старую версию, дочитают её без ошибок
+void SaveGame(const model::Game& game, const std::filesystem::path& path);
+
+// Загружает игру из файла path. Если файл повреждён или записан в другой версии формата,
+// выбрасывает std::runtime_error
+model::Game LoadGame(const std::filesystem::path& path);
+
+// Сообщает, начинается ли файл path с сигнатуры двоичного файла игры
+bool IsGameFile(const std::filesystem::path& path);
+
+}  // namespace game_file
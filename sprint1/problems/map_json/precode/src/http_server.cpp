@@ -1,7 +1,708 @@
 #include "http_server.h"
 
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <iostream>
+#include <limits>
+#include <tuple>
+
+#ifdef __linux__
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#endif
+
 namespace http_server {
 
-// Разместите здесь реализацию http-сервера, взяв её из задания по разработке асинхронного сервера
+using namespace std::literals;
+
+namespace {
+
+// Ответ на запрос, не допущенный к обработчику. Ответы сериализуются один раз,
+// поэтому отказ обходится серверу дешевле обработки запроса
+const StaticResponse& GetRejectResponse(AdmissionControl::Decision decision) {
+    const auto make_response = [](http::status status, std::string_view body) {
+        http::response<http::string_body> response{status, 11};
+        response.set(http::field::content_type, "text/plain"sv);
+        response.set(http::field::retry_after, "1"sv);
+        response.body() = body;
+        return StaticResponse{std::move(response)};
+    };
+    static const StaticResponse too_many_requests =
+        make_response(http::status::too_many_requests, "Too many requests"sv);
+    static const StaticResponse service_unavailable =
+        make_response(http::status::service_unavailable, "Server is overloaded"sv);
+    return decision == AdmissionControl::Decision::RATE_LIMITED ? too_many_requests
+                                                                : service_unavailable;
+}
+
+const StaticResponse& GetPayloadTooLargeResponse() {
+    static const StaticResponse response = [] {
+        http::response<http::string_body> response{http::status::payload_too_large, 11};
+        response.set(http::field::content_type, "text/plain"sv);
+        response.body() = "Request body is too large"sv;
+        return StaticResponse{std::move(response)};
+    }();
+    return response;
+}
+
+}  // namespace
+
+void ReportError(beast::error_code ec, std::string_view what) {
+    std::cerr << what << ": "sv << ec.message() << std::endl;
+}
+
+void SetReusePort(tcp::acceptor& acceptor) {
+#ifdef SO_REUSEPORT
+    using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    acceptor.set_option(reuse_port(true));
+#else
+    throw sys::system_error{net::error::operation_not_supported, "SO_REUSEPORT"s};
+#endif
+}
+
+BufferPool::Lease BufferPool::Acquire() {
+    std::unique_ptr<Buffer> buffer;
+    {
+        std::lock_guard lk{mutex_};
+        if (!free_buffers_.empty()) {
+            buffer = std::move(free_buffers_.back());
+            free_buffers_.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer = std::make_unique<Buffer>(ArenaAllocator<char>{
+            &memory::MemoryAccounting::Instance().GetResource(memory::Subsystem::HTTP_BUFFERS)});
+    }
+    return Lease{shared_from_this(), std::move(buffer)};
+}
+
+void BufferPool::Release(std::unique_ptr<Buffer> buffer) noexcept {
+    // Слишком большие буферы освобождаем, чтобы один «тяжёлый» запрос
+    // не удерживал память навсегда
+    if (buffer->capacity() > max_capacity_) {
+        return;
+    }
+    // Данные недочитанного запроса не должны попасть в следующий сеанс
+    buffer->clear();
+
+    std::lock_guard lk{mutex_};
+    if (free_buffers_.size() < max_pooled_) {
+        try {
+            free_buffers_.emplace_back(std::move(buffer));
+        } catch (...) {
+            // Не удалось сохранить буфер — просто освобождаем его
+        }
+    }
+}
+
+std::string MakeEntityTag(std::string_view body) {
+    // FNV-1a: тег зависит только от байтов тела и не меняется между запусками сервера,
+    // поэтому кэш клиента остаётся действительным и после перезапуска
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : body) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    constexpr std::string_view DIGITS = "0123456789abcdef"sv;
+    std::string etag(18, '"');
+    for (size_t i = 16; i > 0; --i, hash >>= 4) {
+        etag[i] = DIGITS[hash & 0xf];
+    }
+    return etag;
+}
+
+bool MatchesEntityTag(std::string_view if_none_match, std::string_view etag) noexcept {
+    constexpr std::string_view WHITESPACE = " \t"sv;
+    while (!if_none_match.empty()) {
+        const size_t comma = if_none_match.find(',');
+        auto tag = if_none_match.substr(0, comma);
+        if_none_match.remove_prefix(comma == std::string_view::npos ? if_none_match.size() : comma + 1);
+
+        const size_t begin = tag.find_first_not_of(WHITESPACE);
+        if (begin == std::string_view::npos) {
+            continue;
+        }
+        tag = tag.substr(begin, tag.find_last_not_of(WHITESPACE) - begin + 1);
+        if (tag == "*"sv) {
+            return true;
+        }
+        if (tag.starts_with("W/"sv)) {
+            tag.remove_prefix(2);
+        }
+        if (tag == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+http::response<http::string_body> MakeMetricsResponse(const Request& request) {
+    std::ostringstream body;
+    Metrics::Instance().WritePrometheus(body);
+    memory::MemoryAccounting::Instance().WritePrometheus(body);
+    http::response<http::string_body> response{http::status::ok, request.version()};
+    response.set(http::field::content_type, "text/plain; version=0.0.4"sv);
+    response.set(http::field::cache_control, "no-cache"sv);
+    response.body() = std::move(body).str();
+    response.prepare_payload();
+    response.keep_alive(request.keep_alive());
+    return response;
+}
+
+const StaticResponseData::Encoded& StaticResponse::GetVariant(
+    std::string_view accept_encoding) const noexcept {
+    const auto& variants = data_->variants;
+    if (variants[static_cast<size_t>(ContentEncoding::GZIP)]
+        || variants[static_cast<size_t>(ContentEncoding::DEFLATE)]) {
+        const auto accepted = AcceptedEncodings::Parse(accept_encoding);
+        for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+            if (const auto& variant = variants[static_cast<size_t>(encoding)];
+                variant && accepted.Contains(encoding)) {
+                return *variant;
+            }
+        }
+    }
+    return *variants[static_cast<size_t>(ContentEncoding::IDENTITY)];
+}
+
+void SessionBase::Run() {
+    // Вызываем метод Read, используя executor объекта socket_.
+    // Таким образом вся работа с socket_ будет выполняться, используя его executor
+    net::dispatch(socket_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::Read, GetSharedThis()));
+}
+
+void SessionBase::Read() {
+    // Не читаем, если чтение уже идёт или очередь неотправленных ответов заполнена.
+    // В последнем случае чтение возобновится после записи очередного ответа
+    if (reading_ || read_closed_ || closed_ || pending_writes_.size() >= MAX_PIPELINED_REQUESTS) {
+        return;
+    }
+    if (IsDraining() && next_request_id_ != 0 && buffer_->size() == 0) {
+        // Сервер останавливается. Новых запросов не ждём, а соединение закрываем после
+        // отправки готовых ответов. Только что принятое соединение успеет прислать запрос
+        read_closed_ = true;
+        if (pending_writes_.empty() && !writing_) {
+            Close();
+        }
+        return;
+    }
+    reading_ = true;
+    SetDeadline(READ_TIMEOUT);
+    if (buffer_->size() != 0) {
+        // Начало следующего запроса уже прочитано вместе с предыдущим
+        return ReadRequest();
+    }
+    // Отдельно дожидаемся первых байтов запроса, чтобы время ожидания клиента
+    // не попадало в метрику разбора
+    awaiting_request_ = true;
+    WithStream([this](auto& stream) {
+        stream.async_read_some(
+            buffer_->prepare(beast::read_size(*buffer_, MAX_READ_SIZE)),
+            beast::bind_front_handler(&SessionBase::OnFirstBytes, GetSharedThis()));
+    });
+}
+
+void SessionBase::OnFirstBytes(beast::error_code ec, std::size_t bytes_read) {
+    awaiting_request_ = false;
+    buffer_->commit(bytes_read);
+    if (ec == net::error::eof || ec == ssl::error::stream_truncated) {
+        // Клиент закрыл соединение между запросами. Клиенты TLS нередко закрывают
+        // соединение, не отправив close_notify, - это тоже считается концом потока
+        return OnRead(http::error::end_of_stream, 0);
+    }
+    if (ec) {
+        return OnRead(ec, 0);
+    }
+    ReadRequest();
+}
+
+void SessionBase::ReadRequest() {
+    parse_start_ = Clock::now();
+    // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
+    parser_.reset();
+    if (pending_writes_.empty() && !writing_) {
+        // Все прежние запросы обработаны и ответы на них отправлены - арену можно сбросить
+        arena_.release();
+    }
+    const RequestAllocator allocator{&arena_};
+    parser_.emplace(std::piecewise_construct, std::make_tuple(allocator),
+                    std::make_tuple(allocator));
+    // Размер тела проверяется после чтения заголовка, когда известен маршрут,
+    // а не во время его разбора
+    parser_->body_limit(std::numeric_limits<std::uint64_t>::max());
+    // Сначала считываем только заголовок, используя буфер из пула
+    WithStream([this](auto& stream) {
+        http::async_read_header(
+            stream, *buffer_, *parser_,
+            beast::bind_front_handler(&SessionBase::OnReadHeader, GetSharedThis()));
+    });
+}
+
+void SessionBase::OnReadHeader(beast::error_code ec, std::size_t bytes_read) {
+    if (ec || closed_) {
+        return OnRead(ec, bytes_read);
+    }
+    const auto& header = parser_->get().base();
+    const std::uint64_t body_limit =
+        group_->body_limit ? group_->body_limit(header) : DEFAULT_BODY_LIMIT;
+    if (const auto content_length = parser_->content_length();
+        content_length && *content_length > body_limit) {
+        // Тело заранее известной длины не читаем вовсе
+        reading_ = false;
+        return DispatchRequest(&GetPayloadTooLargeResponse());
+    }
+    if (parser_->is_done()) {
+        // У запроса нет тела
+        return OnRead({}, 0);
+    }
+    // Тело неизвестной заранее длины (chunked) ограничивается по мере чтения
+    parser_->body_limit(body_limit);
+    WithStream([this](auto& stream) {
+        http::async_read(stream, *buffer_, *parser_,
+                         // По окончании операции будет вызван метод OnRead
+                         beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+    });
+}
+
+void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    reading_ = false;
+    if (closed_) {
+        // Сеанс закрыт по истечении срока, операция чтения была отменена
+        return;
+    }
+    if (ec == http::error::end_of_stream) {
+        // Нормальная ситуация - клиент закрыл соединение.
+        // Закрываем сокет только после отправки всех ответов
+        read_closed_ = true;
+        if (pending_writes_.empty() && !writing_) {
+            Close();
+        }
+        return;
+    }
+    if (ec == http::error::body_limit) {
+        return DispatchRequest(&GetPayloadTooLargeResponse());
+    }
+    if (ec) {
+        return ReportError(ec, "read"sv);
+    }
+    DispatchRequest(nullptr);
+}
+
+void SessionBase::DispatchRequest(const StaticResponse* reject) {
+    auto& request = parser_->get();
+    const auto handle_start = Clock::now();
+    Metrics::Instance().Record(Stage::PARSE, handle_start - parse_start_);
+    // Корневой интервал запроса продолжает трассу клиента, если тот передал её контекст,
+    // и завершается после записи ответа
+    auto span = tracing::Span::StartRoot(
+        "http.request", tracing::ParseTraceParent(request["traceparent"sv]), parse_start_);
+    tracing::Span{"http.parse", span.GetContext(), parse_start_}.End(handle_start);
+
+    if (IsDraining() || reject) {
+        // Сообщаем клиенту, что соединение будет закрыто после ответа на этот запрос.
+        // Тело отклонённого запроса не прочитано, поэтому продолжить чтение нельзя
+        request.keep_alive(false);
+    }
+    if (!request.keep_alive()) {
+        // После этого запроса клиент не ждёт других ответов
+        read_closed_ = true;
+    }
+
+    if (auto channel = reject ? nullptr : FindPushChannel(request)) {
+        return Upgrade(std::move(channel));
+    }
+
+    // Резервируем место для ответа, чтобы сохранить порядок ответов
+    const RequestId request_id = next_request_id_++;
+    pending_writes_.push_back({std::nullopt, handle_start, {}, std::move(span), {}});
+    // Интервалы обработчика становятся дочерними к интервалу запроса
+    const tracing::ContextScope trace_scope{pending_writes_.back().span.GetContext()};
+    if (reject) {
+        Write(request_id, reject->Prepare(request));
+    } else if (IsMetricsRequest(request)) {
+        Write(request_id, MakeMetricsResponse(request));
+    } else if (const auto decision = Admit(pending_writes_.back().permit);
+               decision != AdmissionControl::Decision::ACCEPT) {
+        Write(request_id, GetRejectResponse(decision).Prepare(request));
+    } else {
+        HandleRequest(request_id, parser_->release());
+    }
+
+    // Не дожидаясь ответа, читаем следующий запрос
+    Read();
+}
+
+bool SessionBase::IsMetricsRequest(const HttpRequest& request) const noexcept {
+    return !metrics_path_.empty() && request.method() == http::verb::get
+        && request.target() == metrics_path_;
+}
+
+std::shared_ptr<PushChannel> SessionBase::FindPushChannel(const HttpRequest& request) const {
+    // Переход возможен, только когда ответы на прежние запросы уже отправлены.
+    // Иначе запрос получит обычный ответ обработчика. Сеанс WebSocket работает
+    // только с открытым сокетом, поэтому через TLS переход не выполняется
+    if (!group_->push_router || tls_ || !websocket::is_upgrade(request) || IsDraining()
+        || !pending_writes_.empty() || writing_) {
+        return nullptr;
+    }
+    return group_->push_router(request);
+}
+
+void SessionBase::Upgrade(std::shared_ptr<PushChannel> channel) {
+    // Соединение переходит к сеансу WebSocket, а HTTP-сеанс завершается.
+    // Клиент не присылает данных до ответа на рукопожатие, поэтому в буфере чтения ничего не осталось
+    closed_ = true;
+    read_closed_ = true;
+    ExpiresNever();
+    std::make_shared<PushSession>(std::move(socket_), std::move(channel))->Run(parser_->get());
+}
+
+AdmissionControl::Decision SessionBase::Admit(AdmissionControl::Permit& permit) {
+    if (!group_->admission) {
+        return AdmissionControl::Decision::ACCEPT;
+    }
+    return group_->admission->Admit(client_, permit);
+}
+
+void SessionBase::Enqueue(RequestId request_id, ReadyResponse response) {
+    net::dispatch(socket_.get_executor(), [response = std::move(response), request_id,
+                                           self = GetSharedThis()]() mutable {
+        self->EnqueueWrite(request_id, std::move(response));
+    });
+}
+
+void SessionBase::EnqueueWrite(RequestId request_id, ReadyResponse response) {
+    if (closed_) {
+        // Соединение уже закрыто, ответ отправлять некому
+        return;
+    }
+    assert(request_id >= next_write_id_ && request_id - next_write_id_ < pending_writes_.size());
+    auto& pending = pending_writes_[request_id - next_write_id_];
+    pending.ready = Clock::now();
+    Metrics::Instance().Record(Stage::HANDLE, pending.ready - pending.handle_start);
+    tracing::Span{"http.handle", pending.span.GetContext(), pending.handle_start}.End(pending.ready);
+    // Обработчик вернул ответ, и запрос больше не занимает место в лимите
+    pending.permit = {};
+    pending.response = std::move(response);
+    WriteNext();
+}
+
+void SessionBase::WriteNext() {
+    if (writing_ || pending_writes_.empty() || !pending_writes_.front().response) {
+        // Ответ на самый старый запрос ещё не готов
+        return;
+    }
+    writing_ = true;
+    write_start_ = Clock::now();
+    Metrics::Instance().RecordWrite();
+    if (group_->cork && !corked_) {
+        SetCork(true);
+    }
+
+    if (Writer writer = std::move(pending_writes_.front().response->writer)) {
+        PopWrite();
+        return writer();
+    }
+
+    write_buffers_.clear();
+    size_t size = 0;
+    bool close = false;
+    while (!close && size < MAX_GATHER_SIZE && !pending_writes_.empty()) {
+        auto& response = pending_writes_.front().response;
+        if (!response || response->writer) {
+            // Следующий ответ не готов или записывается отдельно
+            break;
+        }
+        for (const auto& buffer : response->buffers) {
+            if (buffer.size() != 0) {
+                write_buffers_.push_back(buffer);
+                size += buffer.size();
+            }
+        }
+        write_owners_.push_back(std::move(response->owner));
+        // Ответы, следующие за ответом с закрытием соединения, отправлять не нужно
+        close = response->need_eof;
+        PopWrite();
+    }
+
+    SetDeadline(WRITE_TIMEOUT);
+    WithStream([this, close](auto& stream) {
+        net::async_write(stream, write_buffers_,
+                         [self = GetSharedThis(), close](beast::error_code ec,
+                                                         std::size_t bytes_written) {
+                             self->OnWrite(close, ec, bytes_written);
+                         });
+    });
+}
+
+void SessionBase::PopWrite() {
+    auto& next = pending_writes_.front();
+    // Ответ ждал записи ответов на предыдущие запросы соединения
+    tracing::Span{"http.queue", next.span.GetContext(), next.ready}.End(write_start_);
+    write_spans_.push_back(std::move(next.span));
+    pending_writes_.pop_front();
+    ++next_write_id_;
+}
+
+void SessionBase::OnWrite(bool close, beast::error_code ec,
+                          [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
+    const auto write_end = Clock::now();
+    for (auto& span : write_spans_) {
+        Metrics::Instance().Record(Stage::WRITE, write_end - write_start_);
+        tracing::Span{"http.write", span.GetContext(), write_start_}.End(write_end);
+        span.End(write_end);
+    }
+    write_spans_.clear();
+    write_owners_.clear();
+    if (closed_) {
+        // Сеанс закрыт по истечении срока, операция записи была отменена
+        return;
+    }
+    if (ec) {
+        closed_ = true;
+        pending_writes_.clear();
+        return ReportError(ec, "write"sv);
+    }
+
+    if (close || (read_closed_ && pending_writes_.empty() && !reading_)) {
+        // Семантика ответа требует закрыть соединение либо клиент больше не пришлёт запросов.
+        // Данные, придержанные TCP_CORK, отправляются при закрытии
+        return Close();
+    }
+
+    // Отправляем следующий готовый ответ и, если очередь освободилась, возобновляем чтение
+    WriteNext();
+    if (!writing_ && corked_) {
+        // Готовых ответов больше нет: отправляем придержанный неполный сегмент
+        SetCork(false);
+    }
+    Read();
+}
+
+void SessionBase::SetCork(bool cork) {
+    corked_ = cork;
+#ifdef TCP_CORK
+    using tcp_cork = net::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>;
+    beast::error_code ec;
+    socket_.set_option(tcp_cork(cork), ec);
+#endif
+}
+
+// Соединение TLS закрывается так же, как открытое, без close_notify: ответы уже
+// ограничены длиной или Connection: close, и ждать подтверждения клиента незачем
+void SessionBase::Close() {
+    closed_ = true;
+    pending_writes_.clear();
+    beast::error_code ec;
+    socket_.shutdown(tcp::socket::shutdown_send, ec);
+}
+
+#ifdef __linux__
+void SessionBase::WriteFile(RequestId request_id, std::shared_ptr<FileTransfer> transfer) {
+    ReadyResponse ready;
+    ready.need_eof = transfer->need_eof;
+    ready.writer = [transfer, self = GetSharedThis()] {
+        self->SetDeadline(WRITE_TIMEOUT);
+        self->WithStream([&](auto& stream) {
+            net::async_write(stream, net::buffer(transfer->head),
+                             [transfer, self](beast::error_code ec, std::size_t bytes_written) {
+                                 if (ec) {
+                                     return self->OnWrite(true, ec, bytes_written);
+                                 }
+                                 if (self->tls_) {
+                                     return self->SendFileTls(transfer);
+                                 }
+                                 self->SendFile(transfer);
+                             });
+        });
+    };
+    Enqueue(request_id, std::move(ready));
+}
+
+void SessionBase::SendFile(std::shared_ptr<FileTransfer> transfer) {
+    if (transfer->remaining == 0) {
+        return OnWrite(transfer->need_eof, {}, transfer->head.size() + transfer->offset);
+    }
+
+    // sendfile работает с дескриптором сокета напрямую, поэтому он должен быть неблокирующим
+    beast::error_code ec;
+    socket_.native_non_blocking(true, ec);
+    if (ec) {
+        return OnWrite(true, ec, 0);
+    }
+
+    auto offset = static_cast<off_t>(transfer->offset);
+    const auto count = static_cast<size_t>(
+        std::min<std::uint64_t>(transfer->remaining, MAX_SENDFILE_CHUNK));
+    const ssize_t sent =
+        ::sendfile(socket_.native_handle(), transfer->file.native_handle(), &offset, count);
+    if (sent > 0) {
+        transfer->offset = static_cast<std::uint64_t>(offset);
+        transfer->remaining -= static_cast<std::uint64_t>(sent);
+        // Срок отсчитывается от последней успешной передачи, а не от начала ответа,
+        // иначе большой файл не успел бы уйти медленному клиенту
+        SetDeadline(WRITE_TIMEOUT);
+        // Продолжение ставим в очередь, чтобы дать поработать другим сеансам потока
+        net::post(socket_.get_executor(), [transfer = std::move(transfer), self = GetSharedThis()] {
+            self->SendFile(transfer);
+        });
+        return;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        // Буфер сокета заполнен: ждём, пока клиент прочитает данные
+        socket_.async_wait(tcp::socket::wait_write,
+                           [transfer = std::move(transfer), self = GetSharedThis()](
+                               beast::error_code ec) {
+                               if (ec) {
+                                   return self->OnWrite(true, ec, 0);
+                               }
+                               self->SendFile(transfer);
+                           });
+        return;
+    }
+    // Файл оказался короче, чем было заявлено в заголовке, либо произошла ошибка.
+    // Ответ уже не завершить корректно, поэтому соединение закрывается
+    ec = sent == 0 ? beast::error_code{net::error::eof}
+                   : beast::error_code{errno, sys::system_category()};
+    OnWrite(true, ec, transfer->head.size() + transfer->offset);
+    Close();
+}
+
+void SessionBase::SendFileTls(std::shared_ptr<FileTransfer> transfer) {
+    if (transfer->remaining == 0) {
+        return OnWrite(transfer->need_eof, {}, transfer->head.size() + transfer->offset);
+    }
+
+    const auto count =
+        static_cast<size_t>(std::min<std::uint64_t>(transfer->remaining, TLS_FILE_CHUNK));
+    transfer->chunk.resize(count);
+    beast::error_code ec;
+    const size_t read = transfer->file.read(transfer->chunk.data(), count, ec);
+    if (ec || read == 0) {
+        // Как и в SendFile, ответ уже не завершить корректно
+        OnWrite(true, ec ? ec : beast::error_code{net::error::eof},
+                transfer->head.size() + transfer->offset);
+        return Close();
+    }
+    transfer->offset += read;
+    transfer->remaining -= read;
+    SetDeadline(WRITE_TIMEOUT);
+    net::async_write(*tls_, net::buffer(transfer->chunk.data(), read),
+                     [transfer, self = GetSharedThis()](beast::error_code ec, std::size_t) {
+                         if (ec) {
+                             return self->OnWrite(true, ec, 0);
+                         }
+                         self->SendFileTls(transfer);
+                     });
+}
+#endif
+
+void SessionBase::SetDeadline(Clock::duration timeout) {
+    ExpiresAfter(timeout);
+    // Колесо удаляет элемент, срок которого истёк, поэтому добавляем его при каждой установке.
+    // Если сеанс уже в колесе, вызов ничего не делает
+    timer_wheel_->Add(GetSharedEntry());
+}
+
+std::shared_ptr<TimerWheel::Entry> SessionBase::GetSharedEntry() {
+    // Entry - закрытый базовый класс, поэтому неявное преобразование shared_ptr недоступно.
+    // Конструктор псевдонима разделяет владение с сеансом
+    auto self = GetSharedThis();
+    TimerWheel::Entry* entry = self.get();
+    return {std::move(self), entry};
+}
+
+void SessionBase::OnExpired() {
+    net::dispatch(socket_.get_executor(),
+                  beast::bind_front_handler(&SessionBase::OnDeadline, GetSharedThis()));
+}
+
+void SessionBase::OnDeadline() {
+    if (closed_) {
+        return;
+    }
+    if (awaiting_request_ && IsDraining() && next_request_id_ != 0) {
+        // Сервер останавливается, а клиент ещё не начал присылать очередной запрос.
+        // Чтение из сокета завершится концом потока, и сеанс закроется
+        // после отправки готовых ответов
+        beast::error_code ec;
+        socket_.shutdown(tcp::socket::shutdown_receive, ec);
+    }
+    if (!reading_ && !writing_) {
+        // Сеанс закрыт или ждёт ответа обработчика.
+        // Срок будет установлен заново при следующем чтении или записи
+        return;
+    }
+    if (!IsExpired(TimerWheel::Clock::now())) {
+        // Срок продлили, пока обработчик ждал своей очереди в strand-е
+        timer_wheel_->Add(GetSharedEntry());
+        return;
+    }
+    ReportError(beast::error::timeout, "session"sv);
+    closed_ = true;
+    pending_writes_.clear();
+    // Закрытие сокета отменяет незавершённые операции чтения и записи
+    beast::error_code ec;
+    socket_.close(ec);
+}
+
+namespace {
+
+// Ожидает завершения сеансов слушателей, см. AsyncDrain
+struct DrainWaiter : std::enable_shared_from_this<DrainWaiter> {
+    // Сеансы не сообщают о своём завершении, поэтому их количество проверяется периодически
+    constexpr static auto POLL_INTERVAL = 50ms;
+
+    DrainWaiter(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::time_point deadline, std::function<void()> on_drained)
+        : timer{ioc}
+        , listeners{std::move(listeners)}
+        , deadline{deadline}
+        , on_drained{std::move(on_drained)} {
+    }
+
+    void Wait() {
+        const bool drained =
+            std::all_of(listeners.begin(), listeners.end(), [](const auto& listener) {
+                return listener->GetActiveSessions() == 0;
+            });
+        if (drained || std::chrono::steady_clock::now() >= deadline) {
+            return on_drained();
+        }
+        timer.expires_after(POLL_INTERVAL);
+        timer.async_wait([self = shared_from_this()](sys::error_code ec) {
+            if (!ec) {
+                self->Wait();
+            }
+        });
+    }
+
+    net::steady_timer timer;
+    std::vector<std::shared_ptr<ListenerBase>> listeners;
+    std::chrono::steady_clock::time_point deadline;
+    std::function<void()> on_drained;
+};
+
+}  // namespace
+
+void AsyncDrain(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::duration timeout, std::function<void()> on_drained) {
+    for (const auto& listener : listeners) {
+        listener->Drain();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    auto waiter = std::make_shared<DrainWaiter>(ioc, std::move(listeners), deadline,
+                                                std::move(on_drained));
+    // Первую проверку выполняем после того, как слушатели обработают Drain
+    net::post(ioc, [waiter] {
+        waiter->Wait();
+    });
+}
 
 }  // namespace http_server
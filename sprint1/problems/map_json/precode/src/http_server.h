@@ -1,13 +1,957 @@
 #pragma once
 #include "sdk.h"
-//
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "admission.h"
+#include "arena_allocator.h"
+#include "common_headers.h"
+#include "compression.h"
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "push_channel.h"
+#include "timer_wheel.h"
+#include "tls.h"
+#include "tracing.h"
 
 namespace http_server {
 
-// Разместите здесь реализацию http-сервера, взяв её из задания по разработке асинхронного сервера
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace sys = boost::system;
+
+void ReportError(beast::error_code ec, std::string_view what);
+
+// Включает опцию SO_REUSEPORT. Если система её не поддерживает, выбрасывает
+// исключение sys::system_error
+void SetReusePort(tcp::acceptor& acceptor);
+
+// Аллокатор, через который поля и тело запроса получают память из арены сеанса
+using RequestAllocator = ArenaAllocator<char>;
+using RequestBody = http::basic_string_body<char, std::char_traits<char>, RequestAllocator>;
+using RequestFields = http::basic_fields<RequestAllocator>;
+// Тип запросов, которые сеанс передаёт обработчику
+using Request = http::request<RequestBody, RequestFields>;
+using RequestHeader = http::request_header<RequestFields>;
+
+// Возвращает допустимый размер тела запроса по его заголовку, например в зависимости
+// от маршрута. Вызывается до чтения тела, поэтому запросы со слишком большим телом
+// отклоняются, не занимая память сеанса
+using BodyLimit = std::function<std::uint64_t(const RequestHeader&)>;
+
+// Допустимый размер тела, если BodyLimit не задан
+constexpr std::uint64_t DEFAULT_BODY_LIMIT = 1024 * 1024;
+
+// Формирует ответ с текущими значениями метрик сервера
+http::response<http::string_body> MakeMetricsResponse(const Request& request);
+
+/*
+ * Пул буферов чтения.
+ * Буфер закрытого сеанса не уничтожается, а возвращается в пул вместе с выделенной памятью,
+ * поэтому новый сеанс получает уже «разогретый» буфер и не обращается к куче.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    // Память буферов учитывается как memory::Subsystem::HTTP_BUFFERS
+    using Buffer = beast::basic_flat_buffer<ArenaAllocator<char>>;
+
+    // Максимальное количество буферов, хранимых в пуле
+    constexpr static size_t DEFAULT_MAX_POOLED = 4096;
+    // Буферы, разросшиеся сильнее этого размера, не возвращаются в пул
+    constexpr static size_t DEFAULT_MAX_CAPACITY = 64 * 1024;
+
+    // Буфер, арендованный у пула. При разрушении возвращается в пул
+    class Lease {
+    public:
+        Lease() = default;
+
+        Lease(std::shared_ptr<BufferPool> pool, std::unique_ptr<Buffer> buffer) noexcept
+            : pool_{std::move(pool)}
+            , buffer_{std::move(buffer)} {
+        }
+
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&& rhs) noexcept {
+            if (this != &rhs) {
+                Release();
+                pool_ = std::move(rhs.pool_);
+                buffer_ = std::move(rhs.buffer_);
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() {
+            Release();
+        }
+
+        Buffer& operator*() const noexcept {
+            return *buffer_;
+        }
+
+        Buffer* operator->() const noexcept {
+            return buffer_.get();
+        }
+
+    private:
+        void Release() noexcept {
+            if (pool_ && buffer_) {
+                pool_->Release(std::move(buffer_));
+            }
+            pool_.reset();
+        }
+
+        std::shared_ptr<BufferPool> pool_;
+        std::unique_ptr<Buffer> buffer_;
+    };
+
+    explicit BufferPool(size_t max_pooled = DEFAULT_MAX_POOLED,
+                        size_t max_capacity = DEFAULT_MAX_CAPACITY)
+        : max_pooled_{max_pooled}
+        , max_capacity_{max_capacity} {
+    }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Выдаёт буфер из пула либо создаёт новый, если пул пуст
+    Lease Acquire();
+
+private:
+    void Release(std::unique_ptr<Buffer> buffer) noexcept;
+
+    size_t max_pooled_;
+    size_t max_capacity_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Buffer>> free_buffers_;
+};
+
+// Параметры сжатия ответов
+struct Compression {
+    Compression() = delete;
+    // Заранее сериализованные ответы сжимаются один раз, поэтому сжимаем их максимально
+    constexpr static size_t STATIC_MIN_SIZE = 256;
+    constexpr static int STATIC_LEVEL = 9;
+    // Остальные ответы сжимаются при каждой отправке: небольшие тела сжимать невыгодно,
+    // а уровень выбран в пользу скорости
+    constexpr static size_t DYNAMIC_MIN_SIZE = 1024;
+    constexpr static int DYNAMIC_LEVEL = 1;
+};
+
+// Строгий ETag тела: хеш его байтов в кавычках. Тело, сжатое по-разному, получает разные теги
+std::string MakeEntityTag(std::string_view body);
+
+// Проверяет, упомянут ли etag в значении заголовка If-None-Match.
+// Как требует RFC 7232, теги сравниваются без учёта признака слабого тега W/
+bool MatchesEntityTag(std::string_view if_none_match, std::string_view etag) noexcept;
+
+// Содержимое StaticResponse: заголовки для HTTP/1.0 и HTTP/1.1 с keep-alive и без
+// (см. StaticResponse::HeadIndex) и общее для них тело
+struct StaticResponseData {
+    // Вариант ответа с определённым кодированием тела
+    struct Encoded {
+        std::array<std::string, 4> heads;
+        // Размер строки статуса заголовков. Общие заголовки (см. GetCommonHeaders)
+        // вставляются при записи сразу за ней
+        size_t status_line_size = 0;
+        std::string body;
+        // ETag варианта и заголовки ответа 304 Not Modified. Пусты, если у ответа нет ETag
+        std::string etag;
+        std::array<std::string, 4> not_modified_heads;
+        size_t not_modified_status_line_size = 0;
+    };
+    // Индекс варианта - значение ContentEncoding. Вариант без сжатия есть всегда
+    std::array<std::optional<Encoded>, CONTENT_ENCODING_COUNT> variants;
+};
+
+/*
+ * Заранее сериализованный неизменяемый ответ.
+ * Заголовки и тело хранятся в общих буферах, которые отправляются в сокет без копирования
+ * (scatter/gather) вместе с общими заголовками Date и Server.
+ * Подходит для ответов, которые не зависят от запроса.
+ * Успешный ответ получает строгий ETag, вычисленный один раз при создании. На запрос
+ * с совпадающим If-None-Match отправляются только заранее сериализованные заголовки
+ * ответа 304 Not Modified.
+ * Копирование объекта дешёвое: копируется только умный указатель.
+ */
+class StaticResponse {
+public:
+    // Ответ, подготовленный к записи для конкретного запроса
+    class Prepared {
+    public:
+        // Строка статуса, общие заголовки, остальные заголовки и тело
+        using Buffers = std::array<net::const_buffer, 4>;
+
+        // Возвращает буферы, которые нужно записать в сокет
+        Buffers GetBuffers() const noexcept {
+            const auto& head = (not_modified_ ? variant_->not_modified_heads
+                                              : variant_->heads)[head_index_];
+            const size_t status_line_size = not_modified_ ? variant_->not_modified_status_line_size
+                                                          : variant_->status_line_size;
+            return {net::buffer(head.data(), status_line_size),
+                    net::buffer(common_headers_->block),
+                    net::buffer(head.data() + status_line_size, head.size() - status_line_size),
+                    net::buffer(with_body_ ? variant_->body : std::string_view{})};
+        }
+
+        // Требует ли ответ закрыть соединение после отправки
+        bool NeedEof() const noexcept {
+            return need_eof_;
+        }
+
+    private:
+        friend class StaticResponse;
+
+        Prepared(std::shared_ptr<const StaticResponseData> data,
+                 const StaticResponseData::Encoded* variant, size_t head_index, bool with_body,
+                 bool need_eof, bool not_modified) noexcept
+            : data_{std::move(data)}
+            , common_headers_{GetCommonHeaders()}
+            , variant_{variant}
+            , head_index_{head_index}
+            , with_body_{with_body && !not_modified}
+            , need_eof_{need_eof}
+            , not_modified_{not_modified} {
+        }
+
+        std::shared_ptr<const StaticResponseData> data_;
+        std::shared_ptr<const CommonHeaders> common_headers_;
+        // Указывает внутрь data_
+        const StaticResponseData::Encoded* variant_;
+        size_t head_index_;
+        bool with_body_;
+        bool need_eof_;
+        // Вместо ответа отправляется 304 Not Modified
+        bool not_modified_;
+    };
+
+    template <typename Body, typename Fields>
+    explicit StaticResponse(http::response<Body, Fields> response);
+
+    // Выбирает вариант заголовков, соответствующий версии HTTP и keep-alive запроса,
+    // и сжатое тело, если клиент его принимает. На HEAD-запрос тело не отправляется.
+    // Если клиенту уже известен ETag варианта, готовит ответ 304 Not Modified
+    template <typename RequestBody, typename RequestFields>
+    Prepared Prepare(const http::request<RequestBody, RequestFields>& req) const {
+        const bool keep_alive = req.keep_alive();
+        const auto& variant = GetVariant(req[http::field::accept_encoding]);
+        const bool not_modified = !variant.etag.empty()
+                               && (req.method() == http::verb::get || req.method() == http::verb::head)
+                               && MatchesEntityTag(req[http::field::if_none_match], variant.etag);
+        return Prepared{data_, &variant, HeadIndex(req.version(), keep_alive),
+                        req.method() != http::verb::head, !keep_alive, not_modified};
+    }
+
+private:
+    const StaticResponseData::Encoded& GetVariant(std::string_view accept_encoding) const noexcept;
+
+    static size_t HeadIndex(unsigned version, bool keep_alive) noexcept {
+        return (version >= 11 ? 2 : 0) + (keep_alive ? 1 : 0);
+    }
+
+    std::shared_ptr<const StaticResponseData> data_;
+};
+
+template <typename Body, typename Fields>
+StaticResponse::StaticResponse(http::response<Body, Fields> response) {
+    auto data = std::make_shared<StaticResponseData>();
+    response.prepare_payload();
+
+    // Сериализуем ответ целиком, чтобы получить тело в том виде, в котором оно уходит в сеть
+    std::string body;
+    {
+        std::ostringstream out;
+        out << response;
+        std::ostringstream head;
+        head << response.base();
+        body = std::move(out).str().substr(head.str().size());
+    }
+
+    // Ответы об ошибках со временем могут смениться успешными, поэтому их не кэшируем
+    const bool tagged = response.result() == http::status::ok && response.count(http::field::etag) == 0;
+    const bool compressible = !response.chunked() && body.size() >= Compression::STATIC_MIN_SIZE
+                           && response.count(http::field::content_encoding) == 0
+                           && IsCompressibleType(response[http::field::content_type]);
+    if (compressible) {
+        // Кэши между клиентом и сервером должны различать варианты ответа
+        response.set(http::field::vary, "Accept-Encoding");
+    }
+
+    const auto add_variant = [&response, &data, tagged](ContentEncoding encoding,
+                                                        std::string encoded_body) {
+        auto& variant = data->variants[static_cast<size_t>(encoding)].emplace();
+        if (tagged) {
+            variant.etag = MakeEntityTag(encoded_body);
+            response.set(http::field::etag, variant.etag);
+        }
+        // Ответ 304 содержит только заголовки, которые описывают кэшируемое представление
+        http::response<http::empty_body> not_modified{http::status::not_modified, 11};
+        for (auto field : {http::field::etag, http::field::cache_control, http::field::vary}) {
+            if (const auto it = response.find(field); it != response.end()) {
+                not_modified.set(field, it->value());
+            }
+        }
+        for (unsigned version : {10u, 11u}) {
+            for (bool keep_alive : {false, true}) {
+                const size_t index = HeadIndex(version, keep_alive);
+                response.version(version);
+                response.keep_alive(keep_alive);
+                std::ostringstream head;
+                head << response.base();
+                variant.heads[index] = std::move(head).str();
+                if (tagged) {
+                    not_modified.version(version);
+                    not_modified.keep_alive(keep_alive);
+                    std::ostringstream not_modified_head;
+                    not_modified_head << not_modified.base();
+                    variant.not_modified_heads[index] = std::move(not_modified_head).str();
+                }
+            }
+        }
+        variant.status_line_size = GetStatusLineSize(variant.heads[0]);
+        variant.not_modified_status_line_size = GetStatusLineSize(variant.not_modified_heads[0]);
+        variant.body = std::move(encoded_body);
+    };
+
+    if (compressible) {
+        for (auto encoding : {ContentEncoding::GZIP, ContentEncoding::DEFLATE}) {
+            auto compressed = Compress(body, encoding, Compression::STATIC_LEVEL);
+            if (compressed && compressed->size() < body.size()) {
+                response.set(http::field::content_encoding, GetEncodingName(encoding));
+                response.content_length(compressed->size());
+                add_variant(encoding, std::move(*compressed));
+            }
+        }
+        response.erase(http::field::content_encoding);
+        response.content_length(body.size());
+    }
+    add_variant(ContentEncoding::IDENTITY, std::move(body));
+    data_ = std::move(data);
+}
+
+// Сжимает тело ответа в формате encoding, если тело достаточно велико и его тип сжимаем
+template <typename Fields>
+http::response<http::string_body, Fields> CompressResponse(
+    http::response<http::string_body, Fields>&& response, ContentEncoding encoding) {
+    auto& body = response.body();
+    if (body.size() < Compression::DYNAMIC_MIN_SIZE
+        || response.count(http::field::content_encoding) != 0
+        || !IsCompressibleType(response[http::field::content_type])) {
+        return std::move(response);
+    }
+    response.set(http::field::vary, "Accept-Encoding");
+    if (auto compressed = Compress(body, encoding, Compression::DYNAMIC_LEVEL);
+        compressed && compressed->size() < body.size()) {
+        body = std::move(*compressed);
+        response.set(http::field::content_encoding, GetEncodingName(encoding));
+        response.content_length(body.size());
+    }
+    return std::move(response);
+}
+
+// Ответы с другими типами тела (файлы, заранее сериализованные ответы) не сжимаются
+template <typename Response>
+Response&& CompressResponse(Response&& response, [[maybe_unused]] ContentEncoding encoding) {
+    return std::forward<Response>(response);
+}
+
+// Параметры сокета, принимающего соединения, и принятых на нём сеансов
+struct ListenOptions {
+    // Разрешает нескольким acceptor-ам слушать один и тот же порт (SO_REUSEPORT).
+    // Ядро само распределяет входящие соединения между ними
+    bool reuse_port = false;
+    // Путь, по которому сервер сам отвечает на GET-запросы метриками в формате Prometheus.
+    // Пустая строка отключает метрики. Строка должна жить не меньше сервера
+    std::string_view metrics_path{};
+    // Уже открытый слушающий сокет, например унаследованный от предыдущего экземпляра
+    // сервера. Если задан, слушатель использует его вместо создания нового сокета,
+    // а из endpoint берётся только протокол
+    std::optional<tcp::acceptor::native_handle_type> native_handle{};
+    // Контроль допуска запросов к обработчику. Один объект можно передать нескольким
+    // слушателям, чтобы ограничения были общими. nullptr отключает ограничения
+    std::shared_ptr<AdmissionControl> admission{};
+    // Выбирает канал для запросов на переход на WebSocket (см. PushChannel).
+    // Если не задан, такие запросы обрабатываются как обычные
+    PushRouter<Request> push_router{};
+    // Допустимый размер тела запроса. Если не задан, используется DEFAULT_BODY_LIMIT
+    BodyLimit body_limit{};
+    // Отключает алгоритм Нейгла (TCP_NODELAY) на принятых соединениях. Готовые ответы
+    // сеанс и так собирает в одну запись, поэтому ждать подтверждения от клиента незачем
+    bool no_delay = false;
+    // Пока у сеанса есть ответы для записи, ядро придерживает неполные TCP-сегменты
+    // (TCP_CORK, только Linux). Тогда заголовок файла уходит в одном сегменте с его началом,
+    // а ответы, записанные подряд, - полными сегментами
+    bool cork = false;
+    // Если задан, соединения слушателя защищены TLS. Один объект можно передать нескольким
+    // слушателям: тогда клиент возобновит сеанс TLS на любом из них
+    std::shared_ptr<TlsContext> tls{};
+};
+
+// Общее состояние сеансов, принятых одним слушателем
+struct SessionGroup {
+    // Количество ещё не завершённых сеансов
+    std::atomic<size_t> active{0};
+    // Сервер плавно останавливается: сеансы отвечают на уже полученные запросы
+    // и закрывают соединения, не дожидаясь новых
+    std::atomic<bool> draining{false};
+    std::shared_ptr<AdmissionControl> admission;
+    PushRouter<Request> push_router;
+    BodyLimit body_limit;
+    bool no_delay = false;
+    bool cork = false;
+};
+
+// Сроки чтения и записи сеанса отслеживает колесо таймеров, общее для всех сеансов io_context
+class SessionBase : private TimerWheel::Entry {
+public:
+    // Запрещаем копирование и присваивание объектов SessionBase и его наследников
+    SessionBase(const SessionBase&) = delete;
+    SessionBase& operator=(const SessionBase&) = delete;
+
+    void Run();
+
+protected:
+    using HttpRequest = Request;
+    // Порядковый номер запроса внутри соединения
+    using RequestId = std::uint64_t;
+
+    // Максимальное количество запросов, ответы на которые ещё не отправлены.
+    // Пока лимит исчерпан, чтение следующих запросов приостанавливается
+    constexpr static size_t MAX_PIPELINED_REQUESTS = 16;
+
+    // Сокет должен быть создан на собственном strand-е сеанса. Тогда все обработчики сеанса
+    // выполняются последовательно без явной синхронизации
+    SessionBase(tcp::socket&& socket, BufferPool::Lease buffer,
+                std::shared_ptr<TimerWheel> timer_wheel, std::shared_ptr<SessionGroup> group,
+                std::string_view metrics_path)
+        : SessionBase(std::optional<tcp::socket>{std::move(socket)}, std::nullopt,
+                      std::move(buffer), std::move(timer_wheel), std::move(group), metrics_path) {
+    }
+
+    // Сеанс поверх соединения, на котором уже выполнено рукопожатие TLS
+    SessionBase(TlsStream&& stream, BufferPool::Lease buffer,
+                std::shared_ptr<TimerWheel> timer_wheel, std::shared_ptr<SessionGroup> group,
+                std::string_view metrics_path)
+        : SessionBase(std::nullopt, std::optional<TlsStream>{std::move(stream)}, std::move(buffer),
+                      std::move(timer_wheel), std::move(group), metrics_path) {
+    }
+
+    ~SessionBase() {
+        group_->active.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Вызывает fn с потоком, через который сеанс читает и пишет данные: с сокетом
+    // или с потоком TLS поверх него
+    template <typename Fn>
+    void WithStream(Fn&& fn) {
+        if (tls_) {
+            fn(*tls_);
+        } else {
+            fn(socket_);
+        }
+    }
+
+    // Отправляет ответ на запрос request_id. Может быть вызван из любого потока и в любом
+    // порядке: ответы ставятся в очередь и записываются в сокет в порядке поступления запросов.
+    // Ответ со строковым телом сериализуется заранее и может быть записан одним вызовом
+    // вместе с соседними готовыми ответами. Заголовки Date и Server добавляются к ответу
+    // при отправке
+    template <typename Body, typename Fields>
+    void Write(RequestId request_id, http::response<Body, Fields>&& response) {
+        if constexpr (std::is_same_v<typename Body::value_type, std::string>) {
+            if (!response.chunked()) {
+                struct Serialized {
+                    std::string head;
+                    http::response<Body, Fields> response;
+                    std::shared_ptr<const CommonHeaders> common_headers;
+                };
+                std::ostringstream head;
+                head << response.base();
+                auto serialized = std::make_shared<Serialized>(
+                    std::move(head).str(), std::move(response), GetCommonHeaders());
+                const std::string& head_str = serialized->head;
+                const size_t status_line_size = GetStatusLineSize(head_str);
+                ReadyResponse ready;
+                ready.buffers = {
+                    net::buffer(head_str.data(), status_line_size),
+                    net::buffer(serialized->common_headers->block),
+                    net::buffer(head_str.data() + status_line_size, head_str.size() - status_line_size),
+                    net::buffer(serialized->response.body())};
+                ready.need_eof = serialized->response.need_eof();
+                ready.owner = std::move(serialized);
+                return Enqueue(request_id, std::move(ready));
+            }
+        }
+        // Остальные ответы сериализует beast, поэтому общие заголовки задаются полями
+        response.set(http::field::date, GetCommonHeaders()->date);
+        response.set(http::field::server, SERVER_NAME);
+        // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
+        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
+        ReadyResponse ready;
+        ready.need_eof = safe_response->need_eof();
+        ready.writer = [safe_response = std::move(safe_response), self = GetSharedThis()] {
+            self->SetDeadline(WRITE_TIMEOUT);
+            self->WithStream([&](auto& stream) {
+                http::async_write(
+                    stream, *safe_response,
+                    [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
+                        self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+                    });
+            });
+        };
+        Enqueue(request_id, std::move(ready));
+    }
+
+    // Отправляет заранее сериализованный ответ на запрос request_id.
+    // Буферы ответа записываются в сокет напрямую, без копирования
+    void Write(RequestId request_id, StaticResponse::Prepared response) {
+        ReadyResponse ready;
+        ready.buffers = response.GetBuffers();
+        ready.need_eof = response.NeedEof();
+        ready.owner = std::make_shared<StaticResponse::Prepared>(std::move(response));
+        Enqueue(request_id, std::move(ready));
+    }
+
+#ifdef __linux__
+    // Отправляет ответ с содержимым файла. Заголовок записывается в сокет обычным образом,
+    // а тело передаётся из файла системным вызовом sendfile, минуя память процесса.
+    // Поэтому объём памяти на ответ не зависит от размера файла. Через TLS данные нужно
+    // шифровать, поэтому файл читается частями по TLS_FILE_CHUNK.
+    // На других платформах такие ответы отправляет общий шаблонный метод Write
+    template <typename Fields>
+    void Write(RequestId request_id, http::response<http::file_body, Fields>&& response) {
+        auto transfer = std::make_shared<FileTransfer>();
+        std::ostringstream head;
+        head << response.base();
+        transfer->head = std::move(head).str();
+        transfer->head.insert(GetStatusLineSize(transfer->head), GetCommonHeaders()->block);
+        transfer->remaining = response.body().size();
+        transfer->need_eof = response.need_eof();
+        transfer->file = std::move(response.body().file());
+        WriteFile(request_id, std::move(transfer));
+    }
+#endif
+
+private:
+    // Задаётся либо socket, либо tls
+    SessionBase(std::optional<tcp::socket>&& socket, std::optional<TlsStream>&& tls,
+                BufferPool::Lease buffer, std::shared_ptr<TimerWheel> timer_wheel,
+                std::shared_ptr<SessionGroup> group, std::string_view metrics_path)
+        : tls_(std::move(tls))
+        // Для соединения TLS plain_socket_ остаётся закрытым
+        , plain_socket_(socket ? std::move(*socket) : tcp::socket{tls_->get_executor()})
+        , socket_(tls_ ? tls_->next_layer() : plain_socket_)
+        , timer_wheel_(std::move(timer_wheel))
+        , group_(std::move(group))
+        , buffer_(std::move(buffer))
+        , arena_(arena_buffer_.data(), arena_buffer_.size(),
+                 &memory::MemoryAccounting::Instance().GetResource(memory::Subsystem::SESSIONS))
+        , metrics_path_(metrics_path) {
+        group_->active.fetch_add(1, std::memory_order_relaxed);
+        beast::error_code ec;
+        client_ = AdmissionControl::MakeClientKey(socket_.remote_endpoint(ec).address());
+        if (group_->no_delay) {
+            socket_.set_option(tcp::no_delay(true), ec);
+        }
+    }
+
+    // Запускает асинхронную запись очередного ответа
+    using Writer = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    // Ответ, готовый к записи
+    struct ReadyResponse {
+        // Запускает запись ответа, который нельзя объединить с соседними, например файла
+        Writer writer;
+        // Если writer пуст, ответ состоит из этих буферов. Их память принадлежит owner
+        StaticResponse::Prepared::Buffers buffers;
+        std::shared_ptr<const void> owner;
+        bool need_eof = false;
+    };
+
+    struct PendingWrite {
+        // Пустое значение означает, что обработчик ещё не вернул ответ
+        std::optional<ReadyResponse> response;
+        // Момент передачи запроса обработчику
+        Clock::time_point handle_start;
+        // Место запроса в лимите одновременных запросов
+        AdmissionControl::Permit permit;
+        // Корневой интервал запроса и момент, когда обработчик вернул ответ
+        tracing::Span span;
+        Clock::time_point ready;
+    };
+
+    // Начальный буфер арены. Его хватает на заголовки типичного запроса,
+    // поэтому при их разборе куча не используется
+    constexpr static size_t ARENA_BUFFER_SIZE = 2048;
+    // Максимальный объём данных, запрашиваемый у сокета за одно чтение
+    constexpr static size_t MAX_READ_SIZE = 64 * 1024;
+    // Объём, после которого к записи не добавляются следующие готовые ответы.
+    // Количество ответов в одной записи ограничено MAX_PIPELINED_REQUESTS
+    constexpr static size_t MAX_GATHER_SIZE = 256 * 1024;
+
+    // Максимальное время ожидания и чтения очередного запроса. Срок не продлевается
+    // по мере поступления байтов, поэтому медленный клиент не удержит соединение дольше
+    constexpr static std::chrono::seconds READ_TIMEOUT{30};
+    // Максимальное время записи одного ответа
+    constexpr static std::chrono::seconds WRITE_TIMEOUT{30};
+
+    void Read();
+    void OnFirstBytes(beast::error_code ec, std::size_t bytes_read);
+    void ReadRequest();
+    void OnReadHeader(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    // Передаёт прочитанный запрос обработчику. Если задан reject, запрос отклоняется
+    // этим ответом, а соединение закрывается после его отправки
+    void DispatchRequest(const StaticResponse* reject);
+    bool IsMetricsRequest(const HttpRequest& request) const noexcept;
+    // Возвращает канал, если запрос нужно перевести на WebSocket
+    std::shared_ptr<PushChannel> FindPushChannel(const HttpRequest& request) const;
+    void Upgrade(std::shared_ptr<PushChannel> channel);
+    AdmissionControl::Decision Admit(AdmissionControl::Permit& permit);
+    bool IsDraining() const noexcept {
+        return group_->draining.load(std::memory_order_relaxed);
+    }
+    // Передаёт ответ в очередь записи из потока сеанса
+    void Enqueue(RequestId request_id, ReadyResponse response);
+    void EnqueueWrite(RequestId request_id, ReadyResponse response);
+    // Записывает ответ на самый старый запрос вместе со всеми готовыми за ним ответами,
+    // которые можно объединить, одним вызовом записи из нескольких буферов
+    void WriteNext();
+    // Снимает с очереди ответ на самый старый запрос, переходя к его записи
+    void PopWrite();
+    void SetCork(bool cork);
+    void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    void Close();
+
+#ifdef __linux__
+    // Состояние отправки файла
+    struct FileTransfer {
+        std::string head;
+        beast::file file;
+        std::uint64_t offset = 0;
+        std::uint64_t remaining = 0;
+        bool need_eof = false;
+        // Очередная часть файла, если соединение защищено TLS
+        std::vector<char> chunk;
+    };
+
+    // Максимальный объём данных, передаваемый одним вызовом sendfile. Между вызовами
+    // поток может обслужить другие сеансы, даже если клиент читает очень быстро
+    constexpr static size_t MAX_SENDFILE_CHUNK = 1024 * 1024;
+    // Объём части файла, которая шифруется и записывается за один раз
+    constexpr static size_t TLS_FILE_CHUNK = 64 * 1024;
+
+    void WriteFile(RequestId request_id, std::shared_ptr<FileTransfer> transfer);
+    void SendFile(std::shared_ptr<FileTransfer> transfer);
+    void SendFileTls(std::shared_ptr<FileTransfer> transfer);
+#endif
+
+    // Устанавливает срок текущей операции ввода-вывода
+    void SetDeadline(Clock::duration timeout);
+    // Вызывается колесом таймеров, когда срок истёк
+    void OnExpired() override;
+    void OnDeadline();
+    std::shared_ptr<TimerWheel::Entry> GetSharedEntry();
+
+    // Обработку запроса делегируем подклассу
+    virtual void HandleRequest(RequestId request_id, HttpRequest&& request) = 0;
+
+    virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
+
+    // Поток TLS, если соединение защищено. Операции уровня TCP (параметры сокета,
+    // завершение и закрытие) выполняются над socket_ в обоих случаях
+    std::optional<TlsStream> tls_;
+    tcp::socket plain_socket_;
+    // Сокет соединения: plain_socket_ либо нижний уровень tls_
+    tcp::socket& socket_;
+    std::shared_ptr<TimerWheel> timer_wheel_;
+    std::shared_ptr<SessionGroup> group_;
+    BufferPool::Lease buffer_;
+
+    // Монотонная арена для полей и тела запросов. Блоки сверх начального буфера
+    // учитываются как memory::Subsystem::SESSIONS. Освобождать отдельные блоки не нужно:
+    // арена целиком сбрасывается, когда у сеанса не остаётся необработанных запросов.
+    // Поэтому обработчик не должен хранить запрос после отправки ответа на него
+    std::array<std::byte, ARENA_BUFFER_SIZE> arena_buffer_;
+    std::pmr::monotonic_buffer_resource arena_;
+    // Разбор запроса, который сейчас читается: сначала заголовок, затем тело.
+    // Пересоздаётся перед каждым чтением, чтобы поля запроса использовали арену
+    std::optional<http::request_parser<RequestBody, RequestAllocator>> parser_;
+
+    std::string_view metrics_path_;
+    AdmissionControl::ClientKey client_;
+    // Начало разбора текущего запроса и записи текущего ответа
+    Clock::time_point parse_start_;
+    Clock::time_point write_start_;
+    // Корневые интервалы запросов, ответы на которые записываются
+    std::vector<tracing::Span> write_spans_;
+    // Буферы текущей записи и владельцы их памяти
+    std::vector<net::const_buffer> write_buffers_;
+    std::vector<std::shared_ptr<const void>> write_owners_;
+
+    // Ответы на ещё не отправленные запросы. Первый элемент соответствует запросу
+    // next_write_id_
+    std::deque<PendingWrite> pending_writes_;
+    RequestId next_request_id_ = 0;
+    RequestId next_write_id_ = 0;
+    bool reading_ = false;
+    // Сеанс ждёт первых байтов очередного запроса
+    bool awaiting_request_ = false;
+    bool writing_ = false;
+    // Включён TCP_CORK
+    bool corked_ = false;
+    // Клиент больше не будет присылать запросы (конец потока или Connection: close)
+    bool read_closed_ = false;
+    bool closed_ = false;
+};
+
+template <typename RequestHandler>
+class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
+public:
+    // Stream - принятый сокет либо поток TLS после рукопожатия
+    template <typename Stream, typename Handler>
+    Session(Stream&& stream, BufferPool::Lease buffer,
+            std::shared_ptr<TimerWheel> timer_wheel, std::shared_ptr<SessionGroup> group,
+            std::string_view metrics_path, Handler&& request_handler)
+        : SessionBase(std::forward<Stream>(stream), std::move(buffer), std::move(timer_wheel),
+                      std::move(group), metrics_path)
+        , request_handler_(std::forward<Handler>(request_handler)) {
+    }
+
+private:
+    void HandleRequest(RequestId request_id, HttpRequest&& request) override {
+        // Кодирование выбираем до того, как запрос будет передан обработчику
+        const auto encoding =
+            AcceptedEncodings::Parse(request[http::field::accept_encoding]).GetPreferred();
+        // Захватываем умный указатель на текущий объект Session в лямбде,
+        // чтобы продлить время жизни сессии до вызова лямбды
+        request_handler_(std::move(request), [self = this->shared_from_this(), request_id,
+                                              encoding](auto&& response) {
+            self->Write(request_id, CompressResponse(std::move(response), encoding));
+        });
+    }
+
+    std::shared_ptr<SessionBase> GetSharedThis() override {
+        return this->shared_from_this();
+    }
+
+    RequestHandler request_handler_;
+};
+
+// Управление слушателем, не зависящее от типа обработчика запросов
+class ListenerBase {
+public:
+    ListenerBase(const ListenerBase&) = delete;
+    ListenerBase& operator=(const ListenerBase&) = delete;
+
+    // Переводит слушатель в режим плавной остановки: новые соединения не принимаются,
+    // а сеансы отвечают на уже полученные запросы и закрывают соединения.
+    // Может быть вызван из любого потока
+    virtual void Drain() = 0;
+
+    // Количество ещё не завершённых сеансов. Может быть вызван из любого потока
+    size_t GetActiveSessions() const noexcept {
+        return sessions_->active.load(std::memory_order_acquire);
+    }
+
+    // Дескриптор слушающего сокета, например для передачи новому экземпляру сервера.
+    // После вызова Drain сокет закрывается
+    tcp::acceptor::native_handle_type GetNativeHandle() const noexcept {
+        return native_handle_;
+    }
+
+protected:
+    ListenerBase() = default;
+    ~ListenerBase() = default;
+
+    std::shared_ptr<SessionGroup> sessions_ = std::make_shared<SessionGroup>();
+    tcp::acceptor::native_handle_type native_handle_ = -1;
+};
+
+/*
+ * Плавно останавливает слушателей (см. ListenerBase::Drain) и вызывает on_drained в потоке
+ * ioc, когда все их сеансы завершатся, но не позднее чем через timeout
+ */
+void AsyncDrain(net::io_context& ioc, std::vector<std::shared_ptr<ListenerBase>> listeners,
+                std::chrono::steady_clock::duration timeout, std::function<void()> on_drained);
+
+template <typename RequestHandler>
+class Listener : public ListenerBase,
+                 public std::enable_shared_from_this<Listener<RequestHandler>> {
+public:
+    template <typename Handler>
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+             ListenOptions options = {})
+        : ioc_(ioc)
+        // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
+        , acceptor_(net::make_strand(ioc))
+        , metrics_path_(options.metrics_path)
+        , tls_(std::move(options.tls))
+        , request_handler_(std::forward<Handler>(request_handler)) {
+        sessions_->admission = std::move(options.admission);
+        sessions_->push_router = std::move(options.push_router);
+        sessions_->body_limit = std::move(options.body_limit);
+        sessions_->no_delay = options.no_delay;
+        sessions_->cork = options.cork;
+        if (options.native_handle) {
+            // Сокет уже привязан к адресу и принимает соединения
+            acceptor_.assign(endpoint.protocol(), *options.native_handle);
+            native_handle_ = acceptor_.native_handle();
+            return;
+        }
+        // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
+        acceptor_.open(endpoint.protocol());
+
+        // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
+        // чтобы компьютеры могли обменяться завершающими пакетами данных.
+        // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
+        // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (options.reuse_port) {
+            SetReusePort(acceptor_);
+        }
+        // Привязываем acceptor к адресу и порту endpoint
+        acceptor_.bind(endpoint);
+        // Переводим acceptor в состояние, в котором он способен принимать новые соединения
+        // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
+        acceptor_.listen(net::socket_base::max_listen_connections);
+        native_handle_ = acceptor_.native_handle();
+    }
+
+    void Run() {
+        timer_wheel_->Start();
+        DoAccept();
+    }
+
+    void Drain() override {
+        net::dispatch(acceptor_.get_executor(), [self = this->shared_from_this()] {
+            self->sessions_->draining = true;
+            // Закрытие отменяет ожидание нового соединения
+            beast::error_code ec;
+            self->acceptor_.close(ec);
+            // Сеансы, ожидающие следующего запроса, должны узнать об остановке сразу,
+            // а не по истечении срока чтения
+            self->timer_wheel_->NotifyAll();
+        });
+    }
+
+private:
+    void DoAccept() {
+        acceptor_.async_accept(
+            // Передаём последовательный исполнитель, в котором будут вызываться обработчики
+            // асинхронных операций сокета
+            net::make_strand(ioc_),
+            // С помощью bind_front_handler создаём обработчик, привязанный к методу OnAccept
+            // текущего объекта.
+            // Так как Listener — шаблонный класс, нужно подсказать компилятору, что
+            // shared_from_this — метод класса, а не свободная функция.
+            // Для этого вызываем его, используя this
+            // Этот вызов bind_front_handler аналогичен
+            // namespace ph = std::placeholders;
+            // std::bind(&Listener::OnAccept, this->shared_from_this(), ph::_1, ph::_2)
+            beast::bind_front_handler(&Listener::OnAccept, this->shared_from_this()));
+    }
+
+    // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
+    void OnAccept(sys::error_code ec, tcp::socket socket) {
+        using namespace std::literals;
+
+        if (ec) {
+            if (sessions_->draining) {
+                // acceptor закрыт методом Drain
+                return;
+            }
+            return ReportError(ec, "accept"sv);
+        }
+
+        // Асинхронно обрабатываем сессию. Соединение, принятое до вызова Drain,
+        // обслуживается, даже если сервер уже останавливается
+        AsyncRunSession(std::move(socket));
+
+        // Принимаем новое соединение
+        if (!sessions_->draining) {
+            DoAccept();
+        }
+    }
+
+    void AsyncRunSession(tcp::socket&& socket) {
+        if (!tls_) {
+            return RunSession(std::move(socket));
+        }
+        // Рукопожатие учитывается как незавершённый сеанс, чтобы плавная остановка
+        // дождалась его окончания
+        sessions_->active.fetch_add(1, std::memory_order_relaxed);
+        tls_->AsyncHandshake(std::move(socket), [self = this->shared_from_this()](
+                                                    sys::error_code ec, TlsStream&& stream) {
+            using namespace std::literals;
+            if (ec) {
+                ReportError(ec, "tls handshake"sv);
+            } else {
+                self->RunSession(std::move(stream));
+            }
+            self->sessions_->active.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    template <typename Stream>
+    void RunSession(Stream&& stream) {
+        std::make_shared<Session<RequestHandler>>(std::forward<Stream>(stream),
+                                                  buffer_pool_->Acquire(), timer_wheel_,
+                                                  sessions_, metrics_path_, request_handler_)
+            ->Run();
+    }
+
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    std::string_view metrics_path_;
+    std::shared_ptr<TlsContext> tls_;
+    RequestHandler request_handler_;
+    std::shared_ptr<BufferPool> buffer_pool_ = std::make_shared<BufferPool>();
+    // Сроки всех сеансов, принятых слушателем, отслеживает одно колесо
+    std::shared_ptr<TimerWheel> timer_wheel_ = std::make_shared<TimerWheel>(ioc_);
+};
+
+// Запускает слушатель и возвращает объект для управления им.
+// Слушатель продолжает работу, даже если возвращённый указатель не сохранён
+template <typename RequestHandler>
+std::shared_ptr<ListenerBase> ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint,
+                                        RequestHandler&& handler, ListenOptions options = {}) {
+    // При помощи decay_t исключим ссылки из типа RequestHandler,
+    // чтобы Listener хранил RequestHandler по значению
+    using MyListener = Listener<std::decay_t<RequestHandler>>;
+
+    auto listener = std::make_shared<MyListener>(ioc, endpoint,
+                                                 std::forward<RequestHandler>(handler), options);
+    listener->Run();
+    return listener;
+}
 
 }  // namespace http_server
@@ -0,0 +1,60 @@
+#pragma once
+#include <boost/json.hpp>
+#include <array>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace http_handler {
+
+namespace json = boost::json;
+
+// Размер буфера на стеке, из которого разбирается тело запроса. Его хватает на тела
+// запросов API с запасом, а больший объём берётся из кучи
+constexpr size_t JSON_BODY_BUFFER_SIZE = 4096;
+
+namespace detail {
+
+// Парсер потока. Парсер переиспользуется от запроса к запросу и сохраняет свой внутренний
+// стек разбора, поэтому после первого запроса потока не выделяет под него память
+inline json::stream_parser& GetThreadParser() {
+    thread_local json::stream_parser parser;
+    return parser;
+}
+
+}  // namespace detail
+
+/*
+ * Разбирает JSON-тело запроса и возвращает результат handler(const json::value&)
+ * либо std::nullopt, если тело не является корректным JSON.
+ * Значение строится в monotonic_resource поверх буфера на стеке, поэтому небольшое тело
+ * разбирается без обращений к куче, а освобождение памяти значения ничего не стоит.
+ * Значение существует только во время вызова handler и не должно сохраняться.
+ * handler должен возвращать значение
+ */
+template <typename Handler>
+auto ParseJsonBody(std::string_view body, Handler&& handler)
+    -> std::optional<std::invoke_result_t<Handler, const json::value&>> {
+    std::array<unsigned char, JSON_BODY_BUFFER_SIZE> buffer;
+    json::monotonic_resource resource{buffer.data(), buffer.size()};
+
+    auto& parser = detail::GetThreadParser();
+    parser.reset(&resource);
+    json::error_code ec;
+    parser.write(body.data(), body.size(), ec);
+    if (!ec) {
+        parser.finish(ec);
+    }
+    if (ec) {
+        // Парсер не должен хранить ссылку на resource после выхода из функции
+        parser.reset();
+        return std::nullopt;
+    }
+    // Значение разрушается раньше resource, из которого получило память
+    const json::value value = parser.release();
+    parser.reset();
+    return std::forward<Handler>(handler)(value);
+}
+
+}  // namespace http_handler
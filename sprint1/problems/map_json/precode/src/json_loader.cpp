@@ -1,13 +1,264 @@
 #include "json_loader.h"
 
+#include <boost/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "json_scanner.h"
+
 namespace json_loader {
 
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error("Failed to open "s + path.string());
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    return std::move(content).str();
+}
+
+// Ошибка в значении. Смещение отсчитывается от начала текста карты
+class ValueError : public std::runtime_error {
+public:
+    ValueError(size_t offset, const std::string& message)
+        : std::runtime_error{message}
+        , offset_{offset} {
+    }
+
+    size_t GetOffset() const noexcept {
+        return offset_;
+    }
+
+private:
+    size_t offset_;
+};
+
+// Ошибка в элементе массива карты. Положение элемента в тексте ищется, только когда ошибка
+// уже произошла, поэтому при успешной загрузке массивы просматриваются один раз
+class ItemError : public std::runtime_error {
+public:
+    ItemError(std::string_view array, size_t index, const std::string& message)
+        : std::runtime_error{std::string{array} + "["s + std::to_string(index) + "]: "s + message}
+        , array_{array}
+        , index_{index} {
+    }
+
+    std::string_view GetArray() const noexcept {
+        return array_;
+    }
+
+    size_t GetIndex() const noexcept {
+        return index_;
+    }
+
+private:
+    std::string_view array_;
+    size_t index_;
+};
+
+const json::value& GetField(const json::object& obj, std::string_view key) {
+    if (const auto value = obj.if_contains(key)) {
+        return *value;
+    }
+    throw std::invalid_argument("Missing key "s + std::string{key});
+}
+
+int GetInt(const json::object& obj, std::string_view key) {
+    const auto& value = GetField(obj, key);
+    if (!value.is_int64()) {
+        throw std::invalid_argument(std::string{key} + " must be an integer"s);
+    }
+    return static_cast<int>(value.get_int64());
+}
+
+std::string GetString(const json::object& obj, std::string_view key) {
+    const auto& value = GetField(obj, key);
+    if (!value.is_string()) {
+        throw std::invalid_argument(std::string{key} + " must be a string"s);
+    }
+    return std::string{value.get_string()};
+}
+
+const json::object& AsObject(const json::value& value) {
+    if (!value.is_object()) {
+        throw std::invalid_argument("Expected an object"s);
+    }
+    return value.get_object();
+}
+
+model::Road LoadRoad(const json::object& obj) {
+    const model::Point start{GetInt(obj, "x0"sv), GetInt(obj, "y0"sv)};
+    if (obj.contains("x1"sv)) {
+        return model::Road{model::Road::HORIZONTAL, start, GetInt(obj, "x1"sv)};
+    }
+    return model::Road{model::Road::VERTICAL, start, GetInt(obj, "y1"sv)};
+}
+
+model::Building LoadBuilding(const json::object& obj) {
+    return model::Building{model::Rectangle{{GetInt(obj, "x"sv), GetInt(obj, "y"sv)},
+                                            {GetInt(obj, "w"sv), GetInt(obj, "h"sv)}}};
+}
+
+model::Office LoadOffice(const json::object& obj) {
+    return model::Office{model::Office::Id{GetString(obj, "id"sv)},
+                         {GetInt(obj, "x"sv), GetInt(obj, "y"sv)},
+                         {GetInt(obj, "offsetX"sv), GetInt(obj, "offsetY"sv)}};
+}
+
+// Вызывает add(item) для каждого элемента массива obj[key]
+template <typename AddItem>
+void LoadArray(const json::object& obj, std::string_view key, bool required, AddItem&& add) {
+    const auto value = obj.if_contains(key);
+    if (!value) {
+        if (required) {
+            throw std::invalid_argument("Missing key "s + std::string{key});
+        }
+        return;
+    }
+    if (!value->is_array()) {
+        throw std::invalid_argument(std::string{key} + " must be an array"s);
+    }
+    const auto& items = value->get_array();
+    for (size_t i = 0; i < items.size(); ++i) {
+        try {
+            add(AsObject(items[i]));
+        } catch (const std::exception& e) {
+            throw ItemError{key, i, e.what()};
+        }
+    }
+}
+
+json::value ParseValue(std::string_view text) {
+    json::stream_parser parser;
+    boost::system::error_code ec;
+    const size_t consumed = parser.write(text.data(), text.size(), ec);
+    if (!ec) {
+        parser.finish(ec);
+    }
+    if (ec) {
+        throw ValueError{consumed, ec.message()};
+    }
+    return parser.release();
+}
+
+// Строит карту по тексту её объекта
+model::Map LoadMap(std::string_view text) {
+    const json::value value = ParseValue(text);
+    const auto& obj = AsObject(value);
+
+    model::Map map{model::Map::Id{GetString(obj, "id"sv)}, GetString(obj, "name"sv)};
+    LoadArray(obj, "roads"sv, true, [&map](const json::object& road) {
+        map.AddRoad(LoadRoad(road));
+    });
+    LoadArray(obj, "buildings"sv, false, [&map](const json::object& building) {
+        map.AddBuilding(LoadBuilding(building));
+    });
+    LoadArray(obj, "offices"sv, false, [&map](const json::object& office) {
+        map.AddOffice(LoadOffice(office));
+    });
+    return map;
+}
+
+// Выполняет fn(i) для i из [0, count) в нескольких потоках.
+// Если fn выбросила исключения, перевыбрасывает исключение с наименьшим i
+template <typename Fn>
+void ParallelFor(size_t count, Fn&& fn) {
+    const size_t num_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<size_t> next{0};
+    const auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(num_threads > 0 ? num_threads - 1 : 0);
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    threads.clear();
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}  // namespace
+
 model::Game LoadGame(const std::filesystem::path& json_path) {
-    // Загрузить содержимое файла json_path, например, в виде строки
-    // Распарсить строку как JSON, используя boost::json::parse
-    // Загрузить модель игры из файла
-    model::Game game;
+    const std::string config = ReadFile(json_path);
+
+    const auto fail = [&](size_t offset, std::string_view message) -> ConfigError {
+        const auto position = GetTextPosition(config, offset);
+        return ConfigError{json_path.string() + ":"s + std::to_string(position.line) + ":"s
+                           + std::to_string(position.column) + ": "s + std::string{message}};
+    };
+    const auto offset_of = [&config](std::string_view part) {
+        return static_cast<size_t>(part.data() - config.data());
+    };
+
+    // Файл целиком только просматривается, а DOM строится для одной карты за раз
+    std::vector<std::string_view> map_texts;
+    try {
+        auto items = FindArrayItems(config, "maps"sv);
+        if (!items) {
+            throw fail(0, "Missing key maps"sv);
+        }
+        map_texts = std::move(*items);
+    } catch (const ScanError& e) {
+        throw fail(e.GetOffset(), e.what());
+    }
 
+    std::vector<std::optional<model::Map>> maps(map_texts.size());
+    ParallelFor(map_texts.size(), [&](size_t i) {
+        const auto text = map_texts[i];
+        const auto map_error = [&](size_t offset, const std::exception& e) {
+            return fail(offset_of(text) + offset, "maps["s + std::to_string(i) + "]: "s + e.what());
+        };
+        try {
+            maps[i].emplace(LoadMap(text));
+        } catch (const ValueError& e) {
+            throw map_error(e.GetOffset(), e);
+        } catch (const ItemError& e) {
+            size_t offset = 0;
+            const auto items = FindArrayItems(text, e.GetArray());
+            if (items && e.GetIndex() < items->size()) {
+                offset = offset_of((*items)[e.GetIndex()]) - offset_of(text);
+            }
+            throw map_error(offset, e);
+        } catch (const std::exception& e) {
+            throw map_error(0, e);
+        }
+    });
+
+    model::Game game;
+    for (size_t i = 0; i < maps.size(); ++i) {
+        try {
+            game.AddMap(std::move(*maps[i]));
+        } catch (const std::invalid_argument& e) {
+            throw fail(offset_of(map_texts[i]), "maps["s + std::to_string(i) + "]: "s + e.what());
+        }
+    }
     return game;
 }
 
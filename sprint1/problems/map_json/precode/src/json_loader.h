@@ -1,11 +1,20 @@
 #pragma once
 
 #include <filesystem>
+#include <stdexcept>
 
 #include "model.h"
 
 namespace json_loader {
 
+// Ошибка в файле конфигурации. Сообщение начинается с имени файла, строки и столбца
+class ConfigError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Карты разбираются и строятся параллельно, не создавая DOM всего файла.
+// При ошибке в конфигурации выбрасывает ConfigError
 model::Game LoadGame(const std::filesystem::path& json_path);
 
 }  // namespace json_loader
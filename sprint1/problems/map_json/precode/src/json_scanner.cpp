@@ -0,0 +1,195 @@
+#include "json_scanner.h"
+
+#include <algorithm>
+
+namespace json_loader {
+
+using namespace std::literals;
+
+namespace {
+
+class Scanner {
+public:
+    explicit Scanner(std::string_view text) noexcept
+        : text_{text} {
+    }
+
+    size_t GetPos() const noexcept {
+        return pos_;
+    }
+
+    std::string_view Slice(size_t from) const noexcept {
+        return text_.substr(from, pos_ - from);
+    }
+
+    bool AtEnd() const noexcept {
+        return pos_ == text_.size();
+    }
+
+    void SkipSpace() noexcept {
+        while (pos_ < text_.size() && IsSpace(text_[pos_])) {
+            ++pos_;
+        }
+    }
+
+    // Пропускает пробелы и сообщает, стоит ли дальше символ c. Если стоит, пропускает его
+    bool TryConsume(char c) noexcept {
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c) {
+        if (!TryConsume(c)) {
+            Fail("Expected '"s + c + "'"s);
+        }
+    }
+
+    // Пропускает строку и возвращает её содержимое без кавычек
+    std::string_view ReadString() {
+        Expect('"');
+        const size_t start = pos_;
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_++];
+            if (c == '"') {
+                return text_.substr(start, pos_ - start - 1);
+            }
+            if (c == '\\') {
+                ++pos_;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                --pos_;
+                Fail("Control character in string"s);
+            }
+        }
+        Fail("Unterminated string"s);
+    }
+
+    // Пропускает значение любого типа
+    void SkipValue() {
+        SkipSpace();
+        if (AtEnd()) {
+            Fail("Expected value"s);
+        }
+        const char c = text_[pos_];
+        if (c == '"') {
+            ReadString();
+        } else if (c == '{' || c == '[') {
+            SkipContainer();
+        } else {
+            // Число или литерал. Их содержимое проверяет полноценный разбор
+            const size_t start = pos_;
+            while (pos_ < text_.size() && !IsSpace(text_[pos_]) && !IsDelimiter(text_[pos_])) {
+                ++pos_;
+            }
+            if (pos_ == start) {
+                Fail("Unexpected character"s);
+            }
+        }
+    }
+
+    [[noreturn]] void Fail(const std::string& message) const {
+        throw ScanError{pos_, message};
+    }
+
+private:
+    static bool IsSpace(char c) noexcept {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static bool IsDelimiter(char c) noexcept {
+        return c == ',' || c == ':' || c == '{' || c == '}' || c == '[' || c == ']' || c == '"';
+    }
+
+    // Пропускает объект или массив, проверяя парность скобок
+    void SkipContainer() {
+        std::vector<char> closing;
+        do {
+            // Строка внутри контейнера может закончиться вместе с текстом
+            if (AtEnd()) {
+                Fail("Unexpected end of text"s);
+            }
+            const char c = text_[pos_];
+            if (c == '"') {
+                ReadString();
+                continue;
+            }
+            if (c == '{') {
+                closing.push_back('}');
+            } else if (c == '[') {
+                closing.push_back(']');
+            } else if (c == '}' || c == ']') {
+                if (c != closing.back()) {
+                    Fail("Mismatched '"s + c + "'"s);
+                }
+                closing.pop_back();
+            }
+            ++pos_;
+            if (!closing.empty()) {
+                SkipSpace();
+            }
+        } while (!closing.empty());
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+TextPosition GetTextPosition(std::string_view text, size_t offset) noexcept {
+    const auto prefix = text.substr(0, offset);
+    TextPosition position;
+    position.line += std::count(prefix.begin(), prefix.end(), '\n');
+    const auto line_start = prefix.rfind('\n');
+    position.column += line_start == prefix.npos ? prefix.size() : prefix.size() - line_start - 1;
+    return position;
+}
+
+std::optional<std::vector<std::string_view>> FindArrayItems(std::string_view object,
+                                                            std::string_view key) {
+    Scanner scanner{object};
+    std::vector<std::string_view> items;
+    bool found = false;
+
+    scanner.Expect('{');
+    if (!scanner.TryConsume('}')) {
+        do {
+            const auto member = scanner.ReadString();
+            scanner.Expect(':');
+            if (member != key) {
+                scanner.SkipValue();
+                continue;
+            }
+            if (found) {
+                scanner.Fail("Duplicate key "s + std::string{key});
+            }
+            found = true;
+            scanner.Expect('[');
+            if (scanner.TryConsume(']')) {
+                continue;
+            }
+            do {
+                scanner.SkipSpace();
+                const size_t start = scanner.GetPos();
+                scanner.SkipValue();
+                items.push_back(scanner.Slice(start));
+            } while (scanner.TryConsume(','));
+            scanner.Expect(']');
+        } while (scanner.TryConsume(','));
+        scanner.Expect('}');
+    }
+
+    scanner.SkipSpace();
+    if (!scanner.AtEnd()) {
+        scanner.Fail("Unexpected text after object"s);
+    }
+    if (!found) {
+        return std::nullopt;
+    }
+    return items;
+}
+
+}  // namespace json_loader
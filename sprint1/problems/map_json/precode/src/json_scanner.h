@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json_loader {
+
+/*
+ * Поверхностный просмотр JSON без построения DOM.
+ * Просмотр проверяет только расстановку скобок, кавычек и разделителей и позволяет найти
+ * участки текста, занимаемые элементами массива. Каждый участок затем можно разобрать
+ * отдельно, не держа в памяти дерево всего документа.
+ */
+
+// Ошибка синтаксиса. Смещение отсчитывается от начала просматриваемого текста
+class ScanError : public std::runtime_error {
+public:
+    ScanError(size_t offset, const std::string& message)
+        : std::runtime_error{message}
+        , offset_{offset} {
+    }
+
+    size_t GetOffset() const noexcept {
+        return offset_;
+    }
+
+private:
+    size_t offset_;
+};
+
+// Строка и столбец символа, нумерация с единицы
+struct TextPosition {
+    size_t line = 1;
+    size_t column = 1;
+};
+
+TextPosition GetTextPosition(std::string_view text, size_t offset) noexcept;
+
+// Возвращает участки текста, занятые элементами массива, который лежит в объекте object
+// по ключу key, или std::nullopt, если ключа нет. Если по ключу лежит не массив
+// или текст не является объектом, выбрасывает ScanError.
+// Ключи сравниваются без раскодирования escape-последовательностей
+std::optional<std::vector<std::string_view>> FindArrayItems(std::string_view object, std::string_view key);
+
+}  // namespace json_loader
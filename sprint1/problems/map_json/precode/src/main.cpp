@@ -1,14 +1,29 @@
 #include "sdk.h"
 //
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <charconv>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <thread>
 
+#include "cluster.h"
+#include "file_watcher.h"
+#include "game_file.h"
+#include "io_context_pool.h"
 #include "json_loader.h"
+#include "memory_accounting.h"
 #include "request_handler.h"
+#include "tracing.h"
+#include "work_stealing_pool.h"
 
 using namespace std::literals;
 namespace net = boost::asio;
+namespace sys = boost::system;
 
 namespace {
 
@@ -25,40 +40,351 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
+// Загружает игру из конфигурации JSON или из файла, подготовленного game_compile.
+// Карты хранятся в стандартных контейнерах, поэтому их память учитывается по оценке
+// и перестаёт учитываться, когда игру освобождает последний использовавший её запрос
+std::shared_ptr<const model::Game> LoadGame(const std::filesystem::path& config_file) {
+    auto game = std::make_unique<model::Game>(game_file::IsGameFile(config_file)
+                                                  ? game_file::LoadGame(config_file)
+                                                  : json_loader::LoadGame(config_file));
+    const auto memory_usage = game->GetMemoryUsage();
+    auto& model_memory =
+        memory::MemoryAccounting::Instance().GetResource(memory::Subsystem::MODEL);
+    model_memory.AddRetained(memory_usage);
+    return {game.release(), [&model_memory, memory_usage](const model::Game* game) {
+                model_memory.SubRetained(memory_usage);
+                delete game;
+            }};
+}
+
+/*
+ * Перезагружает игру при изменении файла конфигурации, не останавливая сервер.
+ * Новая игра загружается в отдельном потоке, а затем публикуется обработчику запросов.
+ * Запросы, начатые до публикации, дообслуживаются по прежней игре.
+ * Если новую конфигурацию загрузить не удалось, сервер продолжает работать с прежней.
+ */
+class ConfigReloader {
+public:
+    ConfigReloader(net::io_context& ioc, std::filesystem::path config_file,
+                   http_handler::RequestHandler& handler)
+        : config_file_{std::move(config_file)}
+        , handler_{handler}
+        , watcher_{ioc, config_file_, [this] {
+                       net::post(loader_, [this] {
+                           Reload();
+                       });
+                   }} {
+    }
+
+private:
+    // Выполняется в потоке loader_, поэтому загрузки не пересекаются
+    void Reload() {
+        try {
+            handler_.SetGame(LoadGame(config_file_));
+            std::cerr << "Reloaded "sv << config_file_ << std::endl;
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to reload "sv << config_file_ << ": "sv << ex.what() << std::endl;
+        }
+    }
+
+    std::filesystem::path config_file_;
+    http_handler::RequestHandler& handler_;
+    net::thread_pool loader_{1};
+    util::FileWatcher watcher_;
+};
+
+// Перечитывает список узлов кластера при изменении файла. Файл мал, поэтому читается
+// прямо в потоке io_context. Если файл прочитать не удалось, остаётся прежний список
+class ClusterReloader {
+public:
+    ClusterReloader(net::io_context& ioc, std::filesystem::path nodes_file,
+                    cluster::Cluster& cluster)
+        : nodes_file_{std::move(nodes_file)}
+        , cluster_{cluster}
+        , watcher_{ioc, nodes_file_, [this] {
+                       Reload();
+                   }} {
+    }
+
+private:
+    void Reload() {
+        try {
+            cluster_.SetNodes(cluster::LoadNodes(nodes_file_));
+            std::cerr << "Cluster nodes reloaded: "sv << cluster_.GetNodeCount() << std::endl;
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to reload "sv << nodes_file_ << ": "sv << ex.what() << std::endl;
+        }
+    }
+
+    std::filesystem::path nodes_file_;
+    cluster::Cluster& cluster_;
+    util::FileWatcher watcher_;
+};
+
+// Путь, по которому сервер отдаёт метрики в формате Prometheus
+constexpr std::string_view METRICS_PATH = "/metrics"sv;
+
+struct ServerArgs {
+    const char* config_file = nullptr;
+    // Каталог со статическими файлами
+    std::optional<std::filesystem::path> www_root;
+    // Отдельный io_context и acceptor с SO_REUSEPORT на каждое ядро
+    bool io_per_core = false;
+    // Привязка потоков к ядрам, имеет смысл только вместе с io_per_core
+    bool pin_threads = false;
+    // Перезагрузка игры при изменении файла конфигурации
+    bool watch_config = false;
+    // Потоки, в которых строятся ответы (см. RequestHandler). По умолчанию - по количеству
+    // ядер, 0 - ответы строятся в потоках, обслуживающих сокеты
+    std::optional<unsigned> cpu_threads;
+    // Управление отправкой TCP-сегментов, см. http_server::ListenOptions
+    bool no_delay = false;
+    bool cork = false;
+    // Сертификат и ключ в формате PEM. Если заданы, сервер дополнительно принимает
+    // соединения TLS на порту tls_port
+    std::optional<std::filesystem::path> tls_cert;
+    std::optional<std::filesystem::path> tls_key;
+    net::ip::port_type tls_port = 8443;
+    // Потоки полных рукопожатий TLS, 0 - по количеству ядер
+    unsigned tls_handshake_threads = 0;
+    // Ограничения частоты запросов клиентов и количества запросов в обработке
+    http_server::AdmissionOptions admission;
+    // Файл, в который выгружаются интервалы трассировки, их формат и доля трассируемых запросов
+    std::optional<std::filesystem::path> trace_file;
+    tracing::ExportFormat trace_format = tracing::ExportFormat::CHROME;
+    double trace_sample = 1.0;
+    // Список узлов кластера (см. cluster::LoadNodes) и идентификатор текущего узла в нём.
+    // Сеансы карт, принадлежащие другим узлам, перенаправляются им
+    std::optional<std::filesystem::path> cluster_nodes;
+    std::optional<std::string> node_id;
+};
+
+// Разбирает число, занимающее всю строку str
+template <typename T>
+bool ParseNumber(std::string_view str, T& value) {
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return ec == std::errc{} && end == str.data() + str.size();
+}
+
+std::optional<ServerArgs> ParseCommandLine(int argc, const char* const argv[]) {
+    ServerArgs args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--io-per-core"sv) {
+            args.io_per_core = true;
+        } else if (arg == "--pin-threads"sv) {
+            args.pin_threads = true;
+        } else if (arg == "--watch-config"sv) {
+            args.watch_config = true;
+        } else if (arg == "--tcp-nodelay"sv) {
+            args.no_delay = true;
+        } else if (arg == "--tcp-cork"sv) {
+            args.cork = true;
+        } else if (arg == "--www-root"sv && i + 1 < argc) {
+            args.www_root = argv[++i];
+        } else if (arg == "--tls-cert"sv && i + 1 < argc) {
+            args.tls_cert = argv[++i];
+        } else if (arg == "--tls-key"sv && i + 1 < argc) {
+            args.tls_key = argv[++i];
+        } else if (arg == "--tls-port"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.tls_port)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--cpu-threads"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.cpu_threads.emplace())) {
+                return std::nullopt;
+            }
+        } else if (arg == "--tls-handshake-threads"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.tls_handshake_threads)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--rate-limit"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.rate)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--rate-burst"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.burst)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--max-in-flight"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.admission.max_in_flight)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--cluster-nodes"sv && i + 1 < argc) {
+            args.cluster_nodes = argv[++i];
+        } else if (arg == "--node-id"sv && i + 1 < argc) {
+            args.node_id = argv[++i];
+        } else if (arg == "--trace-file"sv && i + 1 < argc) {
+            args.trace_file = argv[++i];
+        } else if (arg == "--trace-format"sv && i + 1 < argc) {
+            const std::string_view format = argv[++i];
+            if (format == "chrome"sv) {
+                args.trace_format = tracing::ExportFormat::CHROME;
+            } else if (format == "otlp"sv) {
+                args.trace_format = tracing::ExportFormat::OTLP;
+            } else {
+                return std::nullopt;
+            }
+        } else if (arg == "--trace-sample"sv && i + 1 < argc) {
+            if (!ParseNumber(argv[++i], args.trace_sample)) {
+                return std::nullopt;
+            }
+        } else if (!args.config_file && !arg.starts_with("--"sv)) {
+            args.config_file = argv[i];
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (!args.config_file || args.tls_cert.has_value() != args.tls_key.has_value()
+        || args.cluster_nodes.has_value() != args.node_id.has_value()) {
+        return std::nullopt;
+    }
+    return args;
+}
+
 }  // namespace
 
 int main(int argc, const char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: game_server <game-config-json>"sv << std::endl;
+    const auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+        std::cerr << "Usage: game_server <game-config-json|compiled-game> [--www-root <dir>] "sv
+                  << "[--io-per-core [--pin-threads]] [--watch-config] [--cpu-threads <n>] "sv
+                  << "[--tcp-nodelay] [--tcp-cork] "sv
+                  << "[--tls-cert <file> --tls-key <file> [--tls-port <port>] "sv
+                  << "[--tls-handshake-threads <n>]] "sv
+                  << "[--rate-limit <requests/s> [--rate-burst <n>]] [--max-in-flight <n>] "sv
+                  << "[--cluster-nodes <file> --node-id <id>] "sv
+                  << "[--trace-file <file> [--trace-format chrome|otlp] [--trace-sample <0..1>]]"sv
+                  << std::endl;
         return EXIT_FAILURE;
     }
     try {
-        // 1. Загружаем карту из файла и построить модель игры
-        model::Game game = json_loader::LoadGame(argv[1]);
+        // 1. Загружаем карту из файла и построить модель игры.
+        // Файл, подготовленный game_compile, загружается без разбора JSON
+        auto game = LoadGame(args->config_file);
+
+        // Экспортёр объявлен раньше io_context и выгружает интервалы после его остановки
+        std::optional<tracing::TraceExporter> trace_exporter;
+        if (args->trace_file) {
+            tracing::Tracer::Instance().SetSampleRate(args->trace_sample);
+            trace_exporter.emplace(*args->trace_file, args->trace_format, "game_server"s);
+        }
 
-        // 2. Инициализируем io_context
         const unsigned num_threads = std::thread::hardware_concurrency();
+        const auto address = net::ip::make_address("0.0.0.0");
+        constexpr net::ip::port_type port = 8080;
+        // Пул объявлен раньше обработчика, который ставит в него задачи, а останавливается
+        // после io_context
+        const unsigned cpu_threads = args->cpu_threads.value_or(num_threads);
+        std::optional<util::WorkStealingPool> cpu_pool;
+        if (cpu_threads != 0) {
+            cpu_pool.emplace(cpu_threads);
+        }
+        // Кластер объявлен раньше обработчика, который к нему обращается
+        std::optional<cluster::Cluster> cluster;
+        if (args->cluster_nodes) {
+            cluster.emplace(*args->node_id, cluster::LoadNodes(*args->cluster_nodes));
+        }
+        http_handler::RequestHandler handler{std::move(game), args->www_root,
+                                             cpu_pool ? &*cpu_pool : nullptr,
+                                             cluster ? &*cluster : nullptr};
+        const auto serve = [&handler](auto&& req, auto&& send) {
+            handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+        };
+        const auto body_limit = &http_handler::RequestHandler::GetBodyLimit;
+        // Ограничения общие для всех слушателей
+        const auto admission =
+            args->admission.IsEnabled()
+                ? std::make_shared<http_server::AdmissionControl>(args->admission)
+                : nullptr;
+        // Контекст TLS общий для всех слушателей, чтобы билеты сеансов принимал любой из них.
+        // Объявлен раньше io_context, так как должен жить дольше него
+        const auto tls = args->tls_cert ? std::make_shared<http_server::TlsContext>(
+                                              *args->tls_cert, *args->tls_key,
+                                              args->tls_handshake_threads != 0
+                                                  ? args->tls_handshake_threads
+                                                  : num_threads)
+                                        : nullptr;
+        // Запускает слушатели открытого и, если задан сертификат, защищённого порта
+        const auto listen = [&](net::io_context& ioc, bool reuse_port) {
+            http_server::ListenOptions options{.reuse_port = reuse_port,
+                                               .metrics_path = METRICS_PATH,
+                                               .admission = admission,
+                                               .body_limit = body_limit,
+                                               .no_delay = args->no_delay,
+                                               .cork = args->cork};
+            http_server::ServeHttp(ioc, {address, port}, serve, options);
+            if (tls) {
+                options.tls = tls;
+                http_server::ServeHttp(ioc, {address, args->tls_port}, serve, options);
+            }
+        };
+
+        if (args->io_per_core) {
+            // Каждый поток принимает соединения и обслуживает сеансы в своём io_context,
+            // обработчик запросов остаётся общим
+            http_server::IoContextPool pool(num_threads);
+            for (size_t i = 0; i < pool.Size(); ++i) {
+                listen(pool.Get(i), true);
+            }
+
+            std::optional<ConfigReloader> reloader;
+            if (args->watch_config) {
+                reloader.emplace(pool.Get(0), args->config_file, handler);
+            }
+            std::optional<ClusterReloader> cluster_reloader;
+            if (cluster) {
+                cluster_reloader.emplace(pool.Get(0), *args->cluster_nodes, *cluster);
+            }
+
+            net::signal_set signals(pool.Get(0), SIGINT, SIGTERM);
+            signals.async_wait(
+                [&pool](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+                    if (!ec) {
+                        pool.Stop();
+                    }
+                });
+
+            // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
+            std::cout << "Server has started..."sv << std::endl;
+            pool.Run(args->pin_threads);
+            // Задачи пула удерживают сеансы, сокеты которых принадлежат io_context,
+            // поэтому пул останавливается раньше
+            cpu_pool.reset();
+            return EXIT_SUCCESS;
+        }
+
+        // 2. Инициализируем io_context
         net::io_context ioc(num_threads);
 
         // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+            if (!ec) {
+                ioc.stop();
+            }
+        });
 
-        // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        http_handler::RequestHandler handler{game};
+        std::optional<ConfigReloader> reloader;
+        if (args->watch_config) {
+            reloader.emplace(ioc, args->config_file, handler);
+        }
+        std::optional<ClusterReloader> cluster_reloader;
+        if (cluster) {
+            cluster_reloader.emplace(ioc, *args->cluster_nodes, *cluster);
+        }
 
-        // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
-        /*
-        http_server::ServeHttp(ioc, {address, port}, [&handler](auto&& req, auto&& send) {
-            handler(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        });
-        */
+        // 4. Запускаем обработчик HTTP-запросов, делегируя их обработчику запросов
+        listen(ioc, false);
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         std::cout << "Server has started..."sv << std::endl;
 
-        // 6. Запускаем обработку асинхронных операций
+        // 5. Запускаем обработку асинхронных операций
         RunWorkers(std::max(1u, num_threads), [&ioc] {
             ioc.run();
         });
+        cpu_pool.reset();
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << std::endl;
         return EXIT_FAILURE;
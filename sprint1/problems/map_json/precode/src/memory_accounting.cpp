@@ -0,0 +1,63 @@
+#include "memory_accounting.h"
+
+#include <string_view>
+
+namespace memory {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<std::string_view, SUBSYSTEM_COUNT> SUBSYSTEM_NAMES{
+    "model"sv, "sessions"sv, "http_buffers"sv, "serialization"sv};
+
+}  // namespace
+
+CountingResource::Snapshot CountingResource::GetSnapshot() const noexcept {
+    return {.live_bytes = live_bytes_.load(std::memory_order_relaxed),
+            .allocations = allocations_.load(std::memory_order_relaxed),
+            .allocated_bytes = allocated_bytes_.load(std::memory_order_relaxed)};
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void* p = upstream_->allocate(bytes, alignment);
+    live_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream_->deallocate(p, bytes, alignment);
+    live_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryAccounting& MemoryAccounting::Instance() {
+    static MemoryAccounting accounting;
+    return accounting;
+}
+
+void MemoryAccounting::WritePrometheus(std::ostream& out) const {
+    std::array<CountingResource::Snapshot, SUBSYSTEM_COUNT> snapshots;
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+        snapshots[i] = resources_[i].GetSnapshot();
+    }
+
+    const auto write_family = [&out, &snapshots](std::string_view name, std::string_view type,
+                                                 std::string_view help, auto field) {
+        out << "# HELP "sv << name << ' ' << help << '\n'
+            << "# TYPE "sv << name << ' ' << type << '\n';
+        for (size_t i = 0; i < SUBSYSTEM_COUNT; ++i) {
+            out << name << "{subsystem=\""sv << SUBSYSTEM_NAMES[i] << "\"} "sv
+                << snapshots[i].*field << '\n';
+        }
+    };
+    write_family("memory_live_bytes"sv, "gauge"sv, "Bytes currently allocated by subsystem."sv,
+                 &CountingResource::Snapshot::live_bytes);
+    write_family("memory_allocations_total"sv, "counter"sv,
+                 "Allocations made by subsystem."sv, &CountingResource::Snapshot::allocations);
+    write_family("memory_allocated_bytes_total"sv, "counter"sv,
+                 "Bytes allocated by subsystem."sv, &CountingResource::Snapshot::allocated_bytes);
+}
+
+}  // namespace memory
@@ -0,0 +1,119 @@
+#pragma once
+#include <boost/container/pmr/memory_resource.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+
+namespace memory {
+
+// Подсистемы, память которых учитывается раздельно
+enum class Subsystem {
+    MODEL,          // карты игры
+    SESSIONS,       // арены сеансов: поля и тела запросов
+    HTTP_BUFFERS,   // буферы чтения сеансов
+    SERIALIZATION,  // временные JSON-документы, из которых строятся ответы API
+};
+
+constexpr size_t SUBSYSTEM_COUNT = 4;
+
+/*
+ * Ресурс памяти, считающий выделения и освобождения и передающий их вышестоящему ресурсу.
+ * Счётчики атомарные, поэтому ресурс можно использовать из разных потоков,
+ * если это допускает вышестоящий ресурс.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    struct Snapshot {
+        // Занято в данный момент
+        std::uint64_t live_bytes = 0;
+        // Выделено за всё время
+        std::uint64_t allocations = 0;
+        std::uint64_t allocated_bytes = 0;
+    };
+
+    explicit CountingResource(
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept
+        : upstream_{upstream} {
+    }
+
+    Snapshot GetSnapshot() const noexcept;
+
+    // Учитывает память, выделенную в обход ресурса. Нужно для данных, которые хранятся
+    // в стандартных контейнерах и размер которых известен после построения
+    void AddRetained(std::uint64_t bytes) noexcept {
+        live_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void SubRetained(std::uint64_t bytes) noexcept {
+        live_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    std::atomic<std::uint64_t> live_bytes_{0};
+    std::atomic<std::uint64_t> allocations_{0};
+    std::atomic<std::uint64_t> allocated_bytes_{0};
+};
+
+/*
+ * Учёт памяти по подсистемам. Каждая подсистема получает память из собственного
+ * CountingResource, а отчёт выводится вместе с остальными метриками сервера.
+ * Скорость выделений Prometheus вычисляет по накопительным счётчикам (rate()).
+ */
+class MemoryAccounting {
+public:
+    static MemoryAccounting& Instance();
+
+    MemoryAccounting(const MemoryAccounting&) = delete;
+    MemoryAccounting& operator=(const MemoryAccounting&) = delete;
+
+    CountingResource& GetResource(Subsystem subsystem) noexcept {
+        return resources_[static_cast<size_t>(subsystem)];
+    }
+
+    // Выводит счётчики всех подсистем в текстовом формате Prometheus
+    void WritePrometheus(std::ostream& out) const;
+
+private:
+    MemoryAccounting() = default;
+
+    std::array<CountingResource, SUBSYSTEM_COUNT> resources_;
+};
+
+/*
+ * Представляет std::pmr::memory_resource в виде ресурса boost.container,
+ * через который получают память значения boost.json
+ */
+class BoostResourceAdapter : public boost::container::pmr::memory_resource {
+public:
+    explicit BoostResourceAdapter(std::pmr::memory_resource* resource) noexcept
+        : resource_{resource} {
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return resource_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        resource_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const boost::container::pmr::memory_resource& other) const noexcept override {
+        const auto* adapter = dynamic_cast<const BoostResourceAdapter*>(&other);
+        return adapter && adapter->resource_->is_equal(*resource_);
+    }
+
+    std::pmr::memory_resource* resource_;
+};
+
+}  // namespace memory
@@ -0,0 +1,140 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Механизм ожидания готовности сокетов в asio. Выбирается при компиляции (см. CMakeLists.txt),
+// метрика позволяет отличить варианты сервера при сравнении
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+constexpr std::string_view IO_BACKEND = "io_uring"sv;
+#elif defined(__linux__)
+constexpr std::string_view IO_BACKEND = "epoll"sv;
+#else
+constexpr std::string_view IO_BACKEND = "default"sv;
+#endif
+
+constexpr std::array<std::string_view, Metrics::STAGE_COUNT> STAGE_NAMES{"parse"sv, "handle"sv,
+                                                                         "write"sv};
+constexpr std::array<std::string_view, Metrics::TLS_HANDSHAKE_COUNT> TLS_HANDSHAKE_NAMES{
+    "full"sv, "resumed"sv, "failed"sv};
+
+// Переводит микросекунды в секунды, в которых Prometheus ожидает длительности
+void WriteSeconds(std::ostream& out, std::uint64_t us) {
+    char buf[32];
+    const int size = std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(us) / 1e6);
+    out.write(buf, size);
+}
+
+}  // namespace
+
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator+=(
+    const Snapshot& other) noexcept {
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    sum_us += other.sum_us;
+    return *this;
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds duration) noexcept {
+    const auto us = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+    const auto bucket = std::lower_bound(BOUNDS.begin(), BOUNDS.end(), us) - BOUNDS.begin();
+    Increment(counts_[static_cast<size_t>(bucket)], 1);
+    Increment(sum_us_, us);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const noexcept {
+    Snapshot snapshot;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sum_us = sum_us_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+Metrics& Metrics::Instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::ThreadMetrics& Metrics::GetLocal() noexcept {
+    thread_local ThreadMetrics* local = nullptr;
+    if (!local) {
+        auto metrics = std::make_unique<ThreadMetrics>();
+        local = metrics.get();
+        std::lock_guard lk{mutex_};
+        threads_.push_back(std::move(metrics));
+    }
+    return *local;
+}
+
+void Metrics::WritePrometheus(std::ostream& out) const {
+    std::array<LatencyHistogram::Snapshot, STAGE_COUNT> stages;
+    std::uint64_t writes = 0;
+    std::array<std::uint64_t, TLS_HANDSHAKE_COUNT> tls_handshakes{};
+    std::uint64_t cluster_redirects = 0;
+    {
+        std::lock_guard lk{mutex_};
+        for (const auto& metrics : threads_) {
+            for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+                stages[stage] += metrics->stages[stage].GetSnapshot();
+            }
+            writes += metrics->writes.load(std::memory_order_relaxed);
+            for (size_t result = 0; result < TLS_HANDSHAKE_COUNT; ++result) {
+                tls_handshakes[result] +=
+                    metrics->tls_handshakes[result].load(std::memory_order_relaxed);
+            }
+            cluster_redirects += metrics->cluster_redirects.load(std::memory_order_relaxed);
+        }
+    }
+
+    out << "# HELP http_request_stage_seconds Time spent in request processing stages.\n"sv
+        << "# TYPE http_request_stage_seconds histogram\n"sv;
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        const auto& snapshot = stages[stage];
+        const auto name = STAGE_NAMES[stage];
+        // В формате Prometheus значения корзин накопительные
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < LatencyHistogram::BOUNDS.size(); ++i) {
+            total += snapshot.counts[i];
+            out << "http_request_stage_seconds_bucket{stage=\""sv << name << "\",le=\""sv;
+            WriteSeconds(out, LatencyHistogram::BOUNDS[i]);
+            out << "\"} "sv << total << '\n';
+        }
+        total += snapshot.counts.back();
+        out << "http_request_stage_seconds_bucket{stage=\""sv << name << "\",le=\"+Inf\"} "sv
+            << total << '\n';
+        out << "http_request_stage_seconds_sum{stage=\""sv << name << "\"} "sv;
+        WriteSeconds(out, snapshot.sum_us);
+        out << '\n';
+        out << "http_request_stage_seconds_count{stage=\""sv << name << "\"} "sv << total << '\n';
+    }
+
+    out << "# HELP http_response_writes_total Socket write operations carrying responses.\n"sv
+        << "# TYPE http_response_writes_total counter\n"sv
+        << "http_response_writes_total "sv << writes << '\n';
+
+    out << "# HELP tls_handshakes_total TLS handshakes by result.\n"sv
+        << "# TYPE tls_handshakes_total counter\n"sv;
+    for (size_t result = 0; result < TLS_HANDSHAKE_COUNT; ++result) {
+        out << "tls_handshakes_total{result=\""sv << TLS_HANDSHAKE_NAMES[result] << "\"} "sv
+            << tls_handshakes[result] << '\n';
+    }
+
+    out << "# HELP cluster_redirects_total Requests redirected to the node owning the session.\n"sv
+        << "# TYPE cluster_redirects_total counter\n"sv
+        << "cluster_redirects_total "sv << cluster_redirects << '\n';
+
+    out << "# HELP server_io_backend_info I/O backend the server was built with.\n"sv
+        << "# TYPE server_io_backend_info gauge\n"sv
+        << "server_io_backend_info{backend=\""sv << IO_BACKEND << "\"} 1\n"sv;
+}
+
+}  // namespace http_server
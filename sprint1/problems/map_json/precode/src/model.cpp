@@ -1,38 +1,194 @@
 #include "model.h"
 
 #include <stdexcept>
+#include <tuple>
 
 namespace model {
 using namespace std::literals;
 
+void RoadIndex::Add(Lines& lines, Coord coord, Coord a, Coord b, size_t road) {
+    auto line = std::lower_bound(lines.begin(), lines.end(), coord,
+                                 [](const Line& line, Coord value) {
+                                     return line.coord < value;
+                                 });
+    if (line == lines.end() || line->coord != coord) {
+        line = lines.insert(line, Line{coord, {}});
+    }
+
+    auto& segments = line->segments;
+    const Segment segment{std::min(a, b), std::max(a, b), road, 0};
+    auto it = std::upper_bound(segments.begin(), segments.end(), segment.from,
+                               [](Coord value, const Segment& s) {
+                                   return value < s.from;
+                               });
+    it = segments.insert(it, segment);
+
+    // Карта загружается один раз, поэтому пересчёт хвоста линии при вставке допустим
+    Coord max_to = it == segments.begin() ? it->to : std::max(std::prev(it)->max_to, it->to);
+    for (; it != segments.end(); ++it) {
+        max_to = std::max(max_to, it->to);
+        it->max_to = max_to;
+    }
+}
+
+namespace {
+
+template <typename... Vectors>
+size_t CapacityBytes(const Vectors&... columns) noexcept {
+    return ((columns.capacity() * sizeof(typename Vectors::value_type)) + ... + 0);
+}
+
+}  // namespace
+
+size_t RoadIndex::GetMemoryUsage() const noexcept {
+    size_t bytes = CapacityBytes(horizontal_, vertical_);
+    for (const auto* lines : {&horizontal_, &vertical_}) {
+        for (const auto& line : *lines) {
+            bytes += CapacityBytes(line.segments);
+        }
+    }
+    return bytes;
+}
+
+namespace {
+
+// Добавляет значения в конец столбцов. Если добавить значение в один из столбцов не удалось,
+// возвращает столбцы к прежнему размеру, чтобы их длины оставались равными
+template <typename... Columns, typename... Values>
+void AppendRow(std::tuple<Columns&...> columns, const Values&... values) {
+    const size_t size = std::get<0>(columns).size();
+    try {
+        std::apply(
+            [&values...](auto&... column) {
+                (column.push_back(values), ...);
+            },
+            columns);
+    } catch (...) {
+        std::apply(
+            [size](auto&... column) {
+                (column.erase(column.begin() + std::min(column.size(), size), column.end()), ...);
+            },
+            columns);
+        throw;
+    }
+}
+
+template <typename... Columns>
+void PopRow(Columns&... columns) noexcept {
+    (columns.pop_back(), ...);
+}
+
+// Собирает строки идентификаторов для построения StringIndex.
+// Наборы объектов небольшие и не меняются после загрузки, поэтому при добавлении
+// объекта индекс строится заново
+template <typename Tagged>
+std::vector<std::string> CollectIds(const std::vector<Tagged>& ids) {
+    std::vector<std::string> result;
+    result.reserve(ids.size());
+    for (const auto& id : ids) {
+        result.push_back(*id);
+    }
+    return result;
+}
+
+}  // namespace
+
+void RoadColumns::Add(const Road& road) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    AppendRow(std::tie(start_x, start_y, end_x, end_y), start.x, start.y, end.x, end.y);
+}
+
+void RoadColumns::PopBack() noexcept {
+    PopRow(start_x, start_y, end_x, end_y);
+}
+
+void BuildingColumns::Add(const Building& building) {
+    const auto& bounds = building.GetBounds();
+    AppendRow(std::tie(x, y, width, height), bounds.position.x, bounds.position.y,
+              bounds.size.width, bounds.size.height);
+}
+
+void BuildingColumns::PopBack() noexcept {
+    PopRow(x, y, width, height);
+}
+
+void OfficeColumns::Add(const Office& office) {
+    AppendRow(std::tie(ids, x, y, offset_x, offset_y), office.GetId(), office.GetPosition().x,
+              office.GetPosition().y, office.GetOffset().dx, office.GetOffset().dy);
+}
+
+void OfficeColumns::PopBack() noexcept {
+    PopRow(ids, x, y, offset_x, offset_y);
+}
+
+void Map::AddRoad(const Road& road) {
+    const size_t index = roads_.Size();
+    roads_.Add(road);
+    try {
+        const auto start = road.GetStart();
+        const auto end = road.GetEnd();
+        if (road.IsHorizontal()) {
+            road_index_.AddHorizontal(start.y, start.x, end.x, index);
+        } else {
+            road_index_.AddVertical(start.x, start.y, end.y, index);
+        }
+    } catch (...) {
+        roads_.PopBack();
+        throw;
+    }
+}
+
 void Map::AddOffice(Office office) {
-    if (warehouse_id_to_index_.contains(office.GetId())) {
+    if (FindOffice(*office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
     }
 
-    const size_t index = offices_.size();
-    Office& o = offices_.emplace_back(std::move(office));
+    offices_.Add(office);
     try {
-        warehouse_id_to_index_.emplace(o.GetId(), index);
+        office_index_ = util::StringIndex{CollectIds(offices_.ids)};
     } catch (...) {
-        // Удаляем офис из вектора, если не удалось вставить в unordered_map
-        offices_.pop_back();
+        // Удаляем офис из столбцов, если не удалось перестроить индекс
+        offices_.PopBack();
         throw;
     }
 }
 
+size_t Map::GetMemoryUsage() const noexcept {
+    return (*id_).capacity() + name_.capacity()
+         + CapacityBytes(roads_.start_x, roads_.start_y, roads_.end_x, roads_.end_y)
+         + road_index_.GetMemoryUsage()
+         + CapacityBytes(buildings_.x, buildings_.y, buildings_.width, buildings_.height)
+         + CapacityBytes(offices_.ids, offices_.x, offices_.y, offices_.offset_x, offices_.offset_y)
+         + office_index_.GetMemoryUsage();
+}
+
 void Game::AddMap(Map map) {
-    const size_t index = maps_.size();
-    if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
+    if (FindMapHandle(*map.GetId())) {
         throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
-    } else {
-        try {
-            maps_.emplace_back(std::move(map));
-        } catch (...) {
-            map_id_to_index_.erase(it);
-            throw;
+    }
+
+    // Индекс строится заново по той же причине, что и индекс офисов
+    maps_.emplace_back(std::move(map));
+    try {
+        std::vector<std::string> ids;
+        ids.reserve(maps_.size());
+        for (const auto& m : maps_) {
+            ids.push_back(*m.GetId());
         }
+        map_index_ = util::StringIndex{std::move(ids)};
+    } catch (...) {
+        maps_.pop_back();
+        throw;
+    }
+}
+
+size_t Game::GetMemoryUsage() const noexcept {
+    size_t bytes = CapacityBytes(maps_) + map_index_.GetMemoryUsage();
+    for (const auto& map : maps_) {
+        bytes += map.GetMemoryUsage();
     }
+    return bytes;
 }
 
 }  // namespace model
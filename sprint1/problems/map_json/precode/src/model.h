@@ -1,8 +1,14 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+#include "string_index.h"
 #include "tagged.h"
 
 namespace model {
@@ -27,6 +33,94 @@ struct Offset {
     Dimension dx, dy;
 };
 
+/*
+ * Индекс дорог карты для поиска дорог, которым принадлежит точка.
+ * Горизонтальные дороги сгруппированы по координате y, вертикальные — по x. Группы
+ * и отрезки внутри группы упорядочены, поэтому поиск занимает O(log n + k), где k —
+ * количество найденных дорог и дорог той же линии, перекрывающихся с ними.
+ */
+class RoadIndex {
+public:
+    // Дорога занимает полосу шириной 2 * half_width вокруг своей оси,
+    // а её концы выступают на half_width за начальную и конечную точки
+    explicit RoadIndex(double half_width) noexcept
+        : half_width_{half_width} {
+    }
+
+    // Добавляет дорогу с номером road, заданную координатой оси и координатами концов
+    void AddHorizontal(Coord y, Coord x0, Coord x1, size_t road) {
+        Add(horizontal_, y, x0, x1, road);
+    }
+
+    void AddVertical(Coord x, Coord y0, Coord y1, size_t road) {
+        Add(vertical_, x, y0, y1, road);
+    }
+
+    // Вызывает fn(road) для номера каждой дороги, которой принадлежит точка (x, y).
+    // Дорога, проходящая через точку в обоих направлениях, не встречается дважды,
+    // так как каждая дорога хранится только в одной группе
+    template <typename Fn>
+    void ForEachRoadAt(double x, double y, Fn&& fn) const {
+        Find(horizontal_, y, x, fn);
+        Find(vertical_, x, y, fn);
+    }
+
+    // Объём памяти в куче, занимаемой индексом
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    struct Segment {
+        Coord from;
+        Coord to;
+        size_t road;
+        // Наибольшее значение to среди этого и предшествующих отрезков линии.
+        // Позволяет прекратить поиск, не просматривая все отрезки левее точки
+        Coord max_to;
+    };
+
+    struct Line {
+        Coord coord;
+        // Упорядочены по from
+        std::vector<Segment> segments;
+    };
+
+    using Lines = std::vector<Line>;
+
+    static void Add(Lines& lines, Coord coord, Coord a, Coord b, size_t road);
+
+    // Ищет отрезки, отстоящие от линии не далее half_width_ по across
+    // и содержащие along с учётом выступа концов
+    template <typename Fn>
+    void Find(const Lines& lines, double across, double along, Fn& fn) const {
+        auto line = std::lower_bound(lines.begin(), lines.end(), across - half_width_,
+                                     [](const Line& line, double value) {
+                                         return line.coord < value;
+                                     });
+        for (; line != lines.end() && line->coord <= across + half_width_; ++line) {
+            const auto& segments = line->segments;
+            // Отрезки за этой границей начинаются дальше точки
+            auto it = std::upper_bound(segments.begin(), segments.end(), along + half_width_,
+                                       [](double value, const Segment& segment) {
+                                           return value < segment.from;
+                                       });
+            while (it != segments.begin()) {
+                --it;
+                if (it->max_to < along - half_width_) {
+                    // Все предшествующие отрезки заканчиваются раньше точки
+                    break;
+                }
+                if (it->to >= along - half_width_) {
+                    fn(it->road);
+                }
+            }
+        }
+    }
+
+    double half_width_;
+    Lines horizontal_;
+    Lines vertical_;
+};
+
 class Road {
     struct HorizontalTag {
         explicit HorizontalTag() = default;
@@ -39,6 +133,8 @@ class Road {
 public:
     constexpr static HorizontalTag HORIZONTAL{};
     constexpr static VerticalTag VERTICAL{};
+    // Точка принадлежит дороге, если отстоит от её оси не более чем на HALF_WIDTH
+    constexpr static double HALF_WIDTH = 0.4;
 
     Road(HorizontalTag, Point start, Coord end_x) noexcept
         : start_{start}
@@ -113,12 +209,157 @@ private:
     Offset offset_;
 };
 
+/*
+ * Диапазон объектов, которые хранятся в Storage по столбцам.
+ * Объекты собираются из столбцов при обращении и возвращаются по значению.
+ * Storage должен предоставлять методы Size() и Get(index)
+ */
+template <typename Storage>
+class ColumnRange {
+public:
+    using value_type = decltype(std::declval<const Storage&>().Get(0));
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ColumnRange::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const Storage* storage, size_t index) noexcept
+            : storage_{storage}
+            , index_{index} {
+        }
+
+        value_type operator*() const {
+            return storage_->Get(index_);
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            auto old = *this;
+            ++index_;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const noexcept {
+            return index_ == other.index_;
+        }
+
+    private:
+        const Storage* storage_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    explicit ColumnRange(const Storage& storage) noexcept
+        : storage_{&storage} {
+    }
+
+    size_t size() const noexcept {
+        return storage_->Size();
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    value_type operator[](size_t index) const {
+        return storage_->Get(index);
+    }
+
+    Iterator begin() const noexcept {
+        return {storage_, 0};
+    }
+
+    Iterator end() const noexcept {
+        return {storage_, size()};
+    }
+
+private:
+    const Storage* storage_;
+};
+
+// Дороги карты по столбцам: i-я дорога идёт из (start_x[i], start_y[i]) в (end_x[i], end_y[i])
+struct RoadColumns {
+    std::vector<Coord> start_x;
+    std::vector<Coord> start_y;
+    std::vector<Coord> end_x;
+    std::vector<Coord> end_y;
+
+    size_t Size() const noexcept {
+        return start_x.size();
+    }
+
+    Road Get(size_t index) const noexcept {
+        const Point start{start_x[index], start_y[index]};
+        if (start.y == end_y[index]) {
+            return Road{Road::HORIZONTAL, start, end_x[index]};
+        }
+        return Road{Road::VERTICAL, start, end_y[index]};
+    }
+
+    void Add(const Road& road);
+    // Удаляет последний объект
+    void PopBack() noexcept;
+};
+
+// Здания карты по столбцам: прямоугольник i-го здания - (x[i], y[i], width[i], height[i])
+struct BuildingColumns {
+    std::vector<Coord> x;
+    std::vector<Coord> y;
+    std::vector<Dimension> width;
+    std::vector<Dimension> height;
+
+    size_t Size() const noexcept {
+        return x.size();
+    }
+
+    Building Get(size_t index) const noexcept {
+        return Building{Rectangle{{x[index], y[index]}, {width[index], height[index]}}};
+    }
+
+    void Add(const Building& building);
+    // Удаляет последний объект
+    void PopBack() noexcept;
+};
+
+// Офисы карты по столбцам. Идентификаторы хранятся отдельно от координат,
+// поэтому циклы по координатам не загружают в кэш строки
+struct OfficeColumns {
+    std::vector<Office::Id> ids;
+    std::vector<Coord> x;
+    std::vector<Coord> y;
+    std::vector<Dimension> offset_x;
+    std::vector<Dimension> offset_y;
+
+    size_t Size() const noexcept {
+        return ids.size();
+    }
+
+    Office Get(size_t index) const {
+        return Office{ids[index], {x[index], y[index]}, {offset_x[index], offset_y[index]}};
+    }
+
+    void Add(const Office& office);
+    // Удаляет последний объект
+    void PopBack() noexcept;
+};
+
 class Map {
 public:
     using Id = util::Tagged<std::string, Map>;
-    using Roads = std::vector<Road>;
-    using Buildings = std::vector<Building>;
-    using Offices = std::vector<Office>;
+    // Номер карты в игре. В отличие от Id сравнивается и копируется без обращения к строке
+    using Handle = util::Tagged<std::uint32_t, Map>;
+    using Roads = ColumnRange<RoadColumns>;
+    using Buildings = ColumnRange<BuildingColumns>;
+    using Offices = ColumnRange<OfficeColumns>;
 
     Map(Id id, std::string name) noexcept
         : id_(std::move(id))
@@ -133,38 +374,65 @@ public:
         return name_;
     }
 
-    const Buildings& GetBuildings() const noexcept {
-        return buildings_;
+    Buildings GetBuildings() const noexcept {
+        return Buildings{buildings_};
+    }
+
+    Roads GetRoads() const noexcept {
+        return Roads{roads_};
+    }
+
+    Offices GetOffices() const noexcept {
+        return Offices{offices_};
     }
 
-    const Roads& GetRoads() const noexcept {
+    // Столбцы координат для циклов, которым нужна только геометрия карты
+    const RoadColumns& GetRoadColumns() const noexcept {
         return roads_;
     }
 
-    const Offices& GetOffices() const noexcept {
+    const BuildingColumns& GetBuildingColumns() const noexcept {
+        return buildings_;
+    }
+
+    const OfficeColumns& GetOfficeColumns() const noexcept {
         return offices_;
     }
 
-    void AddRoad(const Road& road) {
-        roads_.emplace_back(road);
+    void AddRoad(const Road& road);
+
+    // Вызывает fn(Road) для каждой дороги, которой принадлежит точка (x, y)
+    template <typename Fn>
+    void ForEachRoadAt(double x, double y, Fn&& fn) const {
+        road_index_.ForEachRoadAt(x, y, [this, &fn](size_t index) {
+            fn(roads_.Get(index));
+        });
     }
 
     void AddBuilding(const Building& building) {
-        buildings_.emplace_back(building);
+        buildings_.Add(building);
     }
 
     void AddOffice(Office office);
 
+    // Возвращает номер офиса с идентификатором id в GetOffices()
+    std::optional<size_t> FindOffice(std::string_view id) const noexcept {
+        return office_index_.Find(id);
+    }
+
+    // Оценка объёма памяти в куче, занимаемой картой
+    size_t GetMemoryUsage() const noexcept;
+
 private:
-    using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
 
     Id id_;
     std::string name_;
-    Roads roads_;
-    Buildings buildings_;
+    RoadColumns roads_;
+    RoadIndex road_index_{Road::HALF_WIDTH};
+    BuildingColumns buildings_;
 
-    OfficeIdToIndex warehouse_id_to_index_;
-    Offices offices_;
+    OfficeColumns offices_;
+    util::StringIndex office_index_;
 };
 
 class Game {
@@ -177,19 +445,34 @@ public:
         return maps_;
     }
 
-    const Map* FindMap(const Map::Id& id) const noexcept {
-        if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end()) {
-            return &maps_.at(it->second);
+    // Поиск по строке не выделяет память, поэтому подходит для идентификаторов из запросов
+    std::optional<Map::Handle> FindMapHandle(std::string_view id) const noexcept {
+        if (const auto index = map_index_.Find(id)) {
+            return Map::Handle{static_cast<std::uint32_t>(*index)};
         }
-        return nullptr;
+        return std::nullopt;
     }
 
-private:
-    using MapIdHasher = util::TaggedHasher<Map::Id>;
-    using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
+    const Map& GetMap(Map::Handle handle) const noexcept {
+        return maps_[*handle];
+    }
 
+    const Map* FindMap(const Map::Id& id) const noexcept {
+        const auto handle = FindMapHandle(*id);
+        return handle ? &GetMap(*handle) : nullptr;
+    }
+
+    // Индекс идентификаторов карт. Номер строки в индексе совпадает с Map::Handle
+    const util::StringIndex& GetMapIndex() const noexcept {
+        return map_index_;
+    }
+
+    // Оценка объёма памяти в куче, занимаемой картами игры
+    size_t GetMemoryUsage() const noexcept;
+
+private:
     std::vector<Map> maps_;
-    MapIdToIndex map_id_to_index_;
+    util::StringIndex map_index_;
 };
 
 }  // namespace model
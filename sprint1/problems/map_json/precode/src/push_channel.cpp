@@ -0,0 +1,138 @@
+#include "push_channel.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <iterator>
+
+#include "http_server.h"
+
+namespace http_server {
+
+using namespace std::literals;
+
+namespace {
+
+// Клиент ничего не должен присылать, поэтому большие сообщения от него не принимаются
+constexpr size_t MAX_CLIENT_MESSAGE_SIZE = 4096;
+
+// Отправляет message живым подписчикам из subscribers и удаляет из списка завершившихся
+void SendToAll(std::vector<std::weak_ptr<PushSession>>& subscribers,
+               const PushChannel::Message& message) {
+    for (size_t i = 0; i < subscribers.size();) {
+        if (auto subscriber = subscribers[i].lock()) {
+            subscriber->Send(message);
+            ++i;
+        } else {
+            subscribers[i] = std::move(subscribers.back());
+            subscribers.pop_back();
+        }
+    }
+}
+
+}  // namespace
+
+void PushChannel::Publish(const Message& update, const SnapshotMaker& make_snapshot) {
+    std::lock_guard lk{mutex_};
+    SendToAll(subscribers_, update);
+    if (joining_.empty()) {
+        return;
+    }
+    SendToAll(joining_, make_snapshot());
+    subscribers_.insert(subscribers_.end(), std::make_move_iterator(joining_.begin()),
+                        std::make_move_iterator(joining_.end()));
+    joining_.clear();
+}
+
+size_t PushChannel::GetSubscriberCount() const {
+    std::lock_guard lk{mutex_};
+    return subscribers_.size() + joining_.size();
+}
+
+void PushChannel::Subscribe(std::weak_ptr<PushSession> subscriber) {
+    std::lock_guard lk{mutex_};
+    joining_.push_back(std::move(subscriber));
+}
+
+PushSession::PushSession(tcp::socket&& socket, std::shared_ptr<PushChannel> channel)
+    : ws_{std::move(socket)}
+    , channel_{std::move(channel)} {
+    ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws_.read_message_max(MAX_CLIENT_MESSAGE_SIZE);
+    ws_.text(true);
+}
+
+void PushSession::Accept() {
+    ws_.async_accept(upgrade_request_, beast::bind_front_handler(&PushSession::OnAccept, shared_from_this()));
+}
+
+void PushSession::OnAccept(beast::error_code ec) {
+    if (ec) {
+        return ReportError(ec, "websocket accept"sv);
+    }
+    channel_->Subscribe(weak_from_this());
+    Read();
+}
+
+void PushSession::Read() {
+    ws_.async_read(read_buffer_, beast::bind_front_handler(&PushSession::OnRead, shared_from_this()));
+}
+
+void PushSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    if (ec) {
+        // Клиент закрыл соединение, либо оно прервано по сроку или из-за ошибки.
+        // Незавершённая запись будет отменена, и сеанс удалится
+        closed_ = true;
+        if (ec != websocket::error::closed) {
+            Close();
+        }
+        return;
+    }
+    read_buffer_.clear();
+    Read();
+}
+
+void PushSession::Send(PushChannel::Message message) {
+    net::dispatch(ws_.get_executor(), [self = shared_from_this(), message = std::move(message)]() mutable {
+        if (self->closed_) {
+            return;
+        }
+        if (self->queue_.size() >= MAX_QUEUED_MESSAGES) {
+            ReportError(beast::error::timeout, "websocket subscriber is too slow"sv);
+            return self->Close();
+        }
+        self->queue_.push_back(std::move(message));
+        self->WriteNext();
+    });
+}
+
+void PushSession::WriteNext() {
+    if (writing_ || queue_.empty()) {
+        return;
+    }
+    writing_ = true;
+    // Буфер сообщения общий для всех подписчиков и живёт, пока сообщение в очереди
+    ws_.async_write(net::buffer(*queue_.front()),
+                    beast::bind_front_handler(&PushSession::OnWrite, shared_from_this()));
+}
+
+void PushSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_ = false;
+    if (closed_) {
+        return;
+    }
+    if (ec) {
+        ReportError(ec, "websocket write"sv);
+        return Close();
+    }
+    queue_.pop_front();
+    WriteNext();
+}
+
+void PushSession::Close() {
+    // Очередь не очищаем: первое сообщение в ней может записываться прямо сейчас.
+    // Закрытие сокета отменяет чтение и запись, после чего сеанс удаляется вместе с очередью
+    closed_ = true;
+    beast::error_code ec;
+    beast::get_lowest_layer(ws_).close(ec);
+}
+
+}  // namespace http_server
@@ -0,0 +1,125 @@
+#pragma once
+#include "sdk.h"
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+
+class PushSession;
+
+/*
+ * Канал, по которому сервер сам рассылает сообщения подписчикам, подключённым по WebSocket,
+ * вместо того чтобы отвечать на частые опросы. Например, игровой сеанс на каждом тике
+ * публикует изменения мира, а клиенты получают их без отдельных запросов.
+ *
+ * Сообщение сериализуется один раз: все подписчики получают указатель на общий буфер,
+ * и данные не копируются, сколько бы ни было подписчиков.
+ * Новый подписчик начинает получать сообщения со следующей публикации. Перед ней он получает
+ * полный снимок, созданный в том же вызове Publish, поэтому снимок и следующие изменения
+ * согласованы без дополнительной синхронизации.
+ * Методы класса можно вызывать из разных потоков
+ */
+class PushChannel {
+public:
+    using Message = std::shared_ptr<const std::string>;
+    // Создаёт полный снимок для новых подписчиков
+    using SnapshotMaker = std::function<Message()>;
+
+    PushChannel() = default;
+
+    PushChannel(const PushChannel&) = delete;
+    PushChannel& operator=(const PushChannel&) = delete;
+
+    // Отправляет update всем подписчикам. Если с прошлой публикации появились новые подписчики,
+    // один раз вызывает make_snapshot и отправляет снимок вместо update только им
+    void Publish(const Message& update, const SnapshotMaker& make_snapshot);
+
+    // Количество подписчиков, включая ещё не получивших снимок
+    size_t GetSubscriberCount() const;
+
+private:
+    friend class PushSession;
+
+    void Subscribe(std::weak_ptr<PushSession> subscriber);
+
+    mutable std::mutex mutex_;
+    std::vector<std::weak_ptr<PushSession>> subscribers_;
+    // Подписчики, ожидающие снимка
+    std::vector<std::weak_ptr<PushSession>> joining_;
+};
+
+// Выбирает канал для запроса на переход на WebSocket, например по пути и токену игрока.
+// nullptr означает, что запрос обрабатывается как обычный
+template <typename Request>
+using PushRouter = std::function<std::shared_ptr<PushChannel>(const Request& request)>;
+
+/*
+ * Соединение WebSocket подписчика канала.
+ * Сообщения ставятся в очередь и отправляются по одному. Подписчик, не успевающий читать,
+ * отключается, когда в очереди накопится MAX_QUEUED_MESSAGES сообщений: пропуск изменений
+ * нарушил бы согласованность его состояния, а при переподключении он получит новый снимок.
+ * Данные, присланные клиентом, не нужны и отбрасываются; чтение лишь обрабатывает
+ * служебные кадры и закрытие соединения
+ */
+class PushSession : public std::enable_shared_from_this<PushSession> {
+public:
+    constexpr static size_t MAX_QUEUED_MESSAGES = 64;
+
+    // Сокет должен быть создан на собственном strand-е, как и у HTTP-сеанса
+    PushSession(tcp::socket&& socket, std::shared_ptr<PushChannel> channel);
+
+    PushSession(const PushSession&) = delete;
+    PushSession& operator=(const PushSession&) = delete;
+
+    // Завершает рукопожатие WebSocket ответом на запрос request и подписывается на канал
+    template <typename Body, typename Fields>
+    void Run(const http::request<Body, Fields>& request) {
+        // Запрос может принадлежать арене HTTP-сеанса, поэтому копируем только заголовок
+        upgrade_request_.method(request.method());
+        upgrade_request_.target(request.target());
+        upgrade_request_.version(request.version());
+        for (const auto& field : request) {
+            upgrade_request_.insert(field.name_string(), field.value());
+        }
+        Accept();
+    }
+
+    // Ставит сообщение в очередь отправки. Может быть вызван из любого потока
+    void Send(PushChannel::Message message);
+
+private:
+    void Accept();
+    void OnAccept(beast::error_code ec);
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void WriteNext();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+    void Close();
+
+    websocket::stream<tcp::socket> ws_;
+    std::shared_ptr<PushChannel> channel_;
+    http::request<http::empty_body> upgrade_request_;
+    beast::flat_buffer read_buffer_;
+    std::deque<PushChannel::Message> queue_;
+    bool writing_ = false;
+    bool closed_ = false;
+};
+
+}  // namespace http_server
@@ -1,5 +1,283 @@
 #include "request_handler.h"
 
+#include <boost/json.hpp>
+
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "request_target.h"
+
 namespace http_handler {
 
+namespace json = boost::json;
+using namespace std::literals;
+
+namespace {
+
+using StringResponse = http::response<http::string_body>;
+
+// Структура ContentType задаёт область видимости для констант,
+// задающих значения HTTP-заголовка Content-Type
+struct ContentType {
+    ContentType() = delete;
+    constexpr static std::string_view TEXT_HTML = "text/html"sv;
+    constexpr static std::string_view APPLICATION_JSON = "application/json"sv;
+};
+
+struct Endpoint {
+    Endpoint() = delete;
+    constexpr static std::string_view API_PREFIX = "/api/"sv;
+};
+
+// Экземпляр игрового сеанса на карте задаётся параметром запроса instance
+constexpr std::string_view INSTANCE_PARAM = "instance"sv;
+constexpr std::string_view DEFAULT_INSTANCE = "0"sv;
+
+// Возвращает ключ сеанса, если target - запрос карты /api/v1/maps/{id}[?instance=...]
+std::optional<std::string> GetSessionKey(std::string_view target) {
+    const http_server::RequestTarget request_target{target};
+    auto segments = request_target.GetSegments();
+    for (const auto expected : {"api"sv, "v1"sv, "maps"sv}) {
+        const auto segment = segments.Next();
+        if (!segment || segment->Raw() != expected) {
+            return std::nullopt;
+        }
+    }
+    const auto map_id = segments.Next();
+    if (!map_id || segments.Next()) {
+        return std::nullopt;
+    }
+    // Один и тот же сеанс может быть закодирован по-разному, поэтому ключ
+    // строится из декодированных значений
+    std::string decoded_id;
+    std::string decoded_instance;
+    try {
+        const auto instance = request_target.FindQueryParam(INSTANCE_PARAM);
+        return cluster::MakeSessionKey(
+            map_id->Decode(decoded_id),
+            instance ? instance->Decode(decoded_instance) : DEFAULT_INSTANCE);
+    } catch (const std::invalid_argument&) {
+        // Запрос с некорректным кодированием получит ошибку от текущего узла
+        return std::nullopt;
+    }
+}
+
+StringResponse MakeStringResponse(http::status status, std::string_view body,
+                                  std::string_view content_type) {
+    StringResponse response(status, 11);
+    response.set(http::field::content_type, content_type);
+    response.body() = body;
+    return response;
+}
+
+StringResponse MakeJsonResponse(http::status status, const json::value& value) {
+    return MakeStringResponse(status, json::serialize(value), ContentType::APPLICATION_JSON);
+}
+
+// Карты меняются только при перезагрузке конфигурации. Клиент может хранить ответ, но перед
+// использованием проверяет его по ETag и при совпадении получает лишь 304 Not Modified
+StringResponse MakeCacheableJsonResponse(const json::value& value) {
+    auto response = MakeJsonResponse(http::status::ok, value);
+    response.set(http::field::cache_control, "no-cache"sv);
+    return response;
+}
+
+StringResponse MakeError(http::status status, std::string_view code, std::string_view message) {
+    return MakeJsonResponse(status, json::object{{"code"sv, code}, {"message"sv, message}});
+}
+
+StringResponse MakeMethodNotAllowed() {
+    auto response = MakeError(http::status::method_not_allowed, "invalidMethod"sv,
+                              "Invalid method"sv);
+    response.set(http::field::allow, "GET, HEAD"sv);
+    return response;
+}
+
+json::value RoadToJson(const model::Road& road, const json::storage_ptr& sp) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    json::object obj{{{"x0"sv, start.x}, {"y0"sv, start.y}}, sp};
+    if (road.IsHorizontal()) {
+        obj.emplace("x1"sv, end.x);
+    } else {
+        obj.emplace("y1"sv, end.y);
+    }
+    return obj;
+}
+
+json::value BuildingToJson(const model::Building& building, const json::storage_ptr& sp) {
+    const auto& bounds = building.GetBounds();
+    return json::object{{{"x"sv, bounds.position.x},
+                         {"y"sv, bounds.position.y},
+                         {"w"sv, bounds.size.width},
+                         {"h"sv, bounds.size.height}},
+                        sp};
+}
+
+json::value OfficeToJson(const model::Office& office, const json::storage_ptr& sp) {
+    return json::object{{{"id"sv, *office.GetId()},
+                         {"x"sv, office.GetPosition().x},
+                         {"y"sv, office.GetPosition().y},
+                         {"offsetX"sv, office.GetOffset().dx},
+                         {"offsetY"sv, office.GetOffset().dy}},
+                        sp};
+}
+
+// Элементы строятся в той же памяти, что и массив, поэтому не копируются при добавлении
+template <typename Container, typename Converter>
+json::array ToJsonArray(const Container& items, Converter&& converter, const json::storage_ptr& sp) {
+    json::array result(sp);
+    result.reserve(items.size());
+    for (const auto& item : items) {
+        result.emplace_back(converter(item, sp));
+    }
+    return result;
+}
+
+json::value MapToJson(const model::Map& map, const json::storage_ptr& sp) {
+    return json::object{{{"id"sv, *map.GetId()},
+                         {"name"sv, map.GetName()},
+                         {"roads"sv, ToJsonArray(map.GetRoads(), RoadToJson, sp)},
+                         {"buildings"sv, ToJsonArray(map.GetBuildings(), BuildingToJson, sp)},
+                         {"offices"sv, ToJsonArray(map.GetOffices(), OfficeToJson, sp)}},
+                        sp};
+}
+
+json::value MapListToJson(const model::Game::Maps& maps, const json::storage_ptr& sp) {
+    return ToJsonArray(
+        maps,
+        [](const model::Map& map, const json::storage_ptr& storage) {
+            return json::object{{{"id"sv, *map.GetId()}, {"name"sv, map.GetName()}}, storage};
+        },
+        sp);
+}
+
+// Память временных JSON-документов, из которых строятся ответы кэша
+json::storage_ptr GetSerializationStorage() {
+    static memory::BoostResourceAdapter resource{
+        &memory::MemoryAccounting::Instance().GetResource(memory::Subsystem::SERIALIZATION)};
+    return json::storage_ptr{&resource};
+}
+
+}  // namespace
+
+ResponseCache::ResponseCache(std::shared_ptr<const model::Game> game)
+    : game_{std::move(game)}
+    , map_list_{[game = game_.get()] {
+        return http_server::StaticResponse{
+            MakeCacheableJsonResponse(MapListToJson(game->GetMaps(), GetSerializationStorage()))};
+    }}
+    , map_not_found_{http_server::StaticResponse{
+          MakeError(http::status::not_found, "mapNotFound"sv, "Map not found"sv)}}
+    , bad_request_{http_server::StaticResponse{
+          MakeError(http::status::bad_request, "badRequest"sv, "Bad request"sv)}}
+    , method_not_allowed_{http_server::StaticResponse{MakeMethodNotAllowed()}}
+    , not_found_{http_server::StaticResponse{
+          MakeStringResponse(http::status::not_found, "Not found"sv, ContentType::TEXT_HTML)}}
+    , internal_error_{MakeError(http::status::internal_server_error, "internalError"sv,
+                                "Internal server error"sv)}
+    , map_index_{game_->GetMapIndex()} {
+    for (const auto& map : game_->GetMaps()) {
+        maps_.emplace_back([&map] {
+            return http_server::StaticResponse{
+                MakeCacheableJsonResponse(MapToJson(map, GetSerializationStorage()))};
+        });
+    }
+}
+
+const Router<ResponseCache::RouteHandler>& ResponseCache::GetRouter() {
+    using ApiRoute = Route<RouteHandler>;
+    constexpr MethodSet READ_METHODS{http::verb::get, http::verb::head};
+    constexpr std::array ROUTES{
+        ApiRoute{READ_METHODS, "/api/v1/maps"sv, &ResponseCache::GetMapList},
+        ApiRoute{READ_METHODS, "/api/v1/maps/{}"sv, &ResponseCache::GetMap},
+    };
+    static const Router<RouteHandler> router{ROUTES};
+    return router;
+}
+
+const ResponseCache::Entry& ResponseCache::Find(http::verb method,
+                                                std::string_view target) const {
+    // Строка запроса в маршрутизации не участвует
+    const auto path = http_server::RequestTarget{target}.Path();
+    if (!path.starts_with(Endpoint::API_PREFIX)) {
+        return not_found_;
+    }
+
+    using Status = Router<RouteHandler>::Status;
+    const auto match = GetRouter().Find(method, path);
+    switch (match.status) {
+        case Status::FOUND:
+            return (this->*match.handler)(match.params);
+        case Status::METHOD_NOT_ALLOWED:
+            return method_not_allowed_;
+        case Status::NOT_FOUND:
+            break;
+    }
+    // API принимает только запросы на чтение, поэтому на прочие методы по неизвестному
+    // пути отвечаем 405 с заголовком Allow, как и по известному
+    if (method != http::verb::get && method != http::verb::head) {
+        return method_not_allowed_;
+    }
+    return bad_request_;
+}
+
+std::uint64_t ResponseCache::GetBodyLimit(http::verb method, std::string_view target) {
+    const auto path = http_server::RequestTarget{target}.Path();
+    if (!path.starts_with(Endpoint::API_PREFIX)) {
+        return 0;
+    }
+    // Запросы, не попавшие в маршрут, получают ответ с ошибкой и тела не читают
+    return GetRouter().Find(method, path).body_limit;
+}
+
+const ResponseCache::Entry& ResponseCache::GetMapList(
+    [[maybe_unused]] const RouteParams& params) const {
+    return map_list_;
+}
+
+const ResponseCache::Entry& ResponseCache::GetMap(const RouteParams& params) const {
+    // Идентификатор декодируется, только если содержит %-последовательности
+    std::string decoded_id;
+    std::string_view map_id;
+    try {
+        map_id = http_server::EncodedView{params[0]}.Decode(decoded_id);
+    } catch (const std::invalid_argument&) {
+        return bad_request_;
+    }
+    if (const auto handle = map_index_.Find(map_id)) {
+        return maps_[*handle];
+    }
+    return map_not_found_;
+}
+
+bool RequestHandler::IsApiRequest(std::string_view target) noexcept {
+    return http_server::RequestTarget{target}.Path().starts_with(Endpoint::API_PREFIX);
+}
+
+std::optional<http::response<http::string_body>> RequestHandler::RedirectToOwner(
+    std::string_view target, unsigned version, bool keep_alive) const {
+    const auto key = GetSessionKey(target);
+    if (!key) {
+        return std::nullopt;
+    }
+    auto owner = cluster_->FindRemoteOwner(*key);
+    if (!owner) {
+        return std::nullopt;
+    }
+    http_server::Metrics::Instance().RecordClusterRedirect();
+    // 307 сохраняет метод запроса. Владелец сеанса меняется при изменении состава кластера,
+    // поэтому перенаправление не кэшируется
+    StringResponse response{http::status::temporary_redirect, version};
+    *owner += target;
+    response.set(http::field::location, *owner);
+    response.set(http::field::cache_control, "no-store"sv);
+    response.keep_alive(keep_alive);
+    response.prepare_payload();
+    return response;
+}
+
+void RequestHandler::SetGame(std::shared_ptr<const model::Game> game) {
+    cache_.store(std::make_shared<const ResponseCache>(std::move(game)));
+}
+
 }  // namespace http_handler
@@ -1,15 +1,118 @@
 #pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "cluster.h"
 #include "http_server.h"
 #include "model.h"
+#include "router.h"
+#include "single_flight.h"
+#include "static_files.h"
+#include "tracing.h"
+#include "work_stealing_pool.h"
 
 namespace http_handler {
 namespace beast = boost::beast;
 namespace http = beast::http;
 
+/*
+ * Заранее сериализованные ответы API.
+ * Карты не меняются после загрузки, поэтому JSON списка карт и каждой карты
+ * строится один раз, а в ответ на запрос отправляются готовые байты.
+ * Ответы с картами строятся при первом запросе, поэтому новый кэш создаётся быстро.
+ * Одновременные запросы ещё не построенного ответа не строят его заново: первый запрос
+ * строит ответ, а остальные ждут окончания построения и получают тот же ответ.
+ * Кэш владеет игрой, по которой строит ответы, поэтому после замены игры запросы
+ * к прежнему кэшу продолжают читать прежние карты.
+ */
+class ResponseCache {
+public:
+    // Ответ кэша, готовый или строящийся при первом запросе
+    class Entry {
+    public:
+        explicit Entry(http_server::StaticResponse response)
+            : response_{std::move(response)} {
+        }
+
+        explicit Entry(std::function<http_server::StaticResponse()> build)
+            : build_{std::move(build)} {
+        }
+
+        // Возвращает ответ, если он уже построен, иначе nullptr
+        const http_server::StaticResponse* TryGet() const noexcept {
+            return response_.TryGet();
+        }
+
+        // Вызывает handler(const StaticResponse*) с ответом, при необходимости построив его.
+        // Если построить ответ не удалось, handler получает nullptr.
+        // handler может быть вызван в потоке, строящем ответ для другого запроса
+        template <typename Handler>
+        void Get(Handler&& handler) const {
+            response_.Get(build_, std::forward<Handler>(handler));
+        }
+
+    private:
+        mutable util::SingleFlight<http_server::StaticResponse> response_;
+        std::function<http_server::StaticResponse()> build_;
+    };
+
+    explicit ResponseCache(std::shared_ptr<const model::Game> game);
+
+    // Возвращает ответ на запрос method target
+    const Entry& Find(http::verb method, std::string_view target) const;
+
+    // Допустимый размер тела запроса method target. Не зависит от игры
+    static std::uint64_t GetBodyLimit(http::verb method, std::string_view target);
+
+    // Ответ на случай, когда ответ кэша построить не удалось
+    const http_server::StaticResponse& GetInternalError() const noexcept {
+        return internal_error_;
+    }
+
+private:
+    using RouteHandler = const Entry& (ResponseCache::*)(const RouteParams&) const;
+
+    static const Router<RouteHandler>& GetRouter();
+
+    const Entry& GetMapList(const RouteParams& params) const;
+    const Entry& GetMap(const RouteParams& params) const;
+
+    std::shared_ptr<const model::Game> game_;
+    Entry map_list_;
+    // Ответы на запрос карты в порядке Map::Handle. Элементы не перемещаются
+    std::deque<Entry> maps_;
+    Entry map_not_found_;
+    Entry bad_request_;
+    Entry method_not_allowed_;
+    Entry not_found_;
+    http_server::StaticResponse internal_error_;
+    util::StringIndex map_index_;
+};
+
 class RequestHandler {
 public:
-    explicit RequestHandler(model::Game& game)
-        : game_{game} {
+    // Если задан каталог www_root, запросы вне /api/ обслуживаются файлами из него.
+    // Если задан cpu_pool, ответы кэша строятся в нём, а не в потоке, обслуживающем сокеты:
+    // построение ответа с сериализацией и сжатием занимает поток надолго, и сеансы этого
+    // потока ждали бы его окончания. Пул должен жить дольше обработчика.
+    // Если задан cluster, запросы к сеансам карт, принадлежащим другим узлам, получают
+    // перенаправление 307 на узел-владелец. Кластер должен жить дольше обработчика
+    explicit RequestHandler(std::shared_ptr<const model::Game> game,
+                            const std::optional<fs::path>& www_root = std::nullopt,
+                            util::WorkStealingPool* cpu_pool = nullptr,
+                            const cluster::Cluster* cluster = nullptr)
+        : cache_{std::make_shared<const ResponseCache>(std::move(game))}
+        , cpu_pool_{cpu_pool}
+        , cluster_{cluster} {
+        if (www_root) {
+            static_files_.emplace(*www_root);
+        }
     }
 
     RequestHandler(const RequestHandler&) = delete;
@@ -17,11 +120,71 @@ public:
 
     template <typename Body, typename Allocator, typename Send>
     void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
-        // Обработать запрос request и отправить ответ, используя send
+        if (static_files_ && !IsApiRequest(req.target())) {
+            tracing::Span span{"handler.static_file", tracing::GetCurrentContext()};
+            return std::visit(
+                [&send](auto&& response) {
+                    send(std::move(response));
+                },
+                static_files_->Get(req.method(), req.target(), req.version(), req.keep_alive(),
+                                   {.range = req[http::field::range],
+                                    .if_range = req[http::field::if_range],
+                                    .if_modified_since = req[http::field::if_modified_since]}));
+        }
+        // Кэш может быть заменён из другого потока, поэтому удерживаем его, пока ответ
+        // не будет подготовлен. Подготовленный ответ разделяет данные с кэшем
+        // и продлевает их время жизни до окончания записи
+        tracing::Span span{"handler.api", tracing::GetCurrentContext()};
+        if (cluster_) {
+            if (auto redirect = RedirectToOwner(req.target(), req.version(), req.keep_alive())) {
+                return send(std::move(*redirect));
+            }
+        }
+        const auto cache = cache_.load();
+        const auto& entry = cache->Find(req.method(), req.target());
+        if (const auto* response = entry.TryGet()) {
+            return send(response->Prepare(req));
+        }
+        // Ответ ещё не построен. Запрос ждёт построения вместе с ответом, поэтому
+        // переносим его в обработчик. Ответ передаётся сеансу из потока, построившего его,
+        // а сеанс сам продолжает работу в своём strand
+        auto build = [cache, entry = &entry, req = std::move(req),
+                      send = std::forward<Send>(send)]() mutable {
+            entry->Get([cache, req = std::move(req), send = std::move(send)](
+                           const http_server::StaticResponse* response) mutable {
+                send((response ? *response : cache->GetInternalError()).Prepare(req));
+            });
+        };
+        if (!cpu_pool_) {
+            return build();
+        }
+        cpu_pool_->Submit(tracing::BindContext(std::move(build)));
     }
 
+    // Допустимый размер тела запроса, см. http_server::ListenOptions::body_limit.
+    // Статические файлы отдаются только на GET и HEAD, поэтому тела не принимают
+    static std::uint64_t GetBodyLimit(const http_server::RequestHeader& header) {
+        return ResponseCache::GetBodyLimit(header.method(), header.target());
+    }
+
+    // Заменяет игру, например после перезагрузки конфигурации. Может быть вызван из любого
+    // потока. Ответы по новой игре строятся при первом запросе, а запросы, обрабатываемые
+    // в момент вызова, получат ответы по прежней игре, которая освободится после их отправки
+    void SetGame(std::shared_ptr<const model::Game> game);
+
 private:
-    model::Game& game_;
+    static bool IsApiRequest(std::string_view target) noexcept;
+
+    // Если цель запроса - сеанс карты, принадлежащий другому узлу кластера,
+    // возвращает перенаправление на этот узел
+    std::optional<http::response<http::string_body>> RedirectToOwner(std::string_view target,
+                                                                     unsigned version,
+                                                                     bool keep_alive) const;
+
+    std::atomic<std::shared_ptr<const ResponseCache>> cache_;
+    std::optional<StaticFiles> static_files_;
+    util::WorkStealingPool* cpu_pool_;
+    const cluster::Cluster* cluster_;
 };
 
 }  // namespace http_handler
@@ -0,0 +1,213 @@
+#pragma once
+#include <boost/beast/http/verb.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace http_handler {
+
+namespace http = boost::beast::http;
+
+// Набор HTTP-методов, который можно задать на этапе компиляции
+class MethodSet {
+public:
+    constexpr MethodSet(std::initializer_list<http::verb> methods) noexcept {
+        for (auto method : methods) {
+            bits_ |= Bit(method);
+        }
+    }
+
+    constexpr bool Contains(http::verb method) const noexcept {
+        return (bits_ & Bit(method)) != 0;
+    }
+
+private:
+    constexpr static std::uint64_t Bit(http::verb method) noexcept {
+        return std::uint64_t{1} << static_cast<unsigned>(method);
+    }
+
+    std::uint64_t bits_ = 0;
+};
+
+/*
+ * Описание маршрута: методы, шаблон пути, обработчик и допустимый размер тела запроса.
+ * Шаблон состоит из сегментов, разделённых '/'. Сегмент PARAM обозначает параметр пути.
+ * Пример: Route{{http::verb::get}, "/api/v1/maps/{}"sv, &Handler::GetMap}
+ */
+template <typename Handler>
+struct Route {
+    constexpr static std::string_view PARAM = "{}";
+
+    MethodSet methods;
+    std::string_view path;
+    Handler handler;
+    // 0 означает, что запросы к маршруту не должны иметь тела
+    std::uint64_t body_limit = 0;
+};
+
+// Значения параметров пути. Ссылаются на символы исходного пути, поэтому не должны
+// его пережить
+class RouteParams {
+public:
+    constexpr static size_t MAX_PARAMS = 4;
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    std::string_view operator[](size_t index) const noexcept {
+        return values_[index];
+    }
+
+    bool Add(std::string_view value) noexcept {
+        if (size_ == MAX_PARAMS) {
+            return false;
+        }
+        values_[size_++] = value;
+        return true;
+    }
+
+private:
+    std::array<std::string_view, MAX_PARAMS> values_;
+    size_t size_ = 0;
+};
+
+/*
+ * Маршрутизатор на основе префиксного дерева сегментов пути.
+ * Дерево строится один раз из списка маршрутов, поэтому время поиска зависит только от
+ * длины пути, а не от количества маршрутов. Ключи дерева ссылаются на строки из описаний
+ * маршрутов, а поиск работает со string_view, не создавая временных строк.
+ * Совпадение сегмента с фиксированной частью маршрута имеет приоритет над параметром.
+ */
+template <typename Handler>
+class Router {
+public:
+    enum class Status { FOUND, METHOD_NOT_ALLOWED, NOT_FOUND };
+
+    struct Match {
+        Status status = Status::NOT_FOUND;
+        Handler handler{};
+        RouteParams params;
+        std::uint64_t body_limit = 0;
+    };
+
+    // Строки path маршрутов должны жить не меньше маршрутизатора
+    template <size_t N>
+    explicit Router(const std::array<Route<Handler>, N>& routes) {
+        nodes_.emplace_back();
+        for (const auto& route : routes) {
+            AddRoute(route);
+        }
+    }
+
+    // Ищет обработчик для запроса method к пути path (без строки запроса)
+    Match Find(http::verb method, std::string_view path) const noexcept {
+        Match match;
+        size_t node = ROOT;
+        std::string_view segment;
+        while (NextSegment(path, segment)) {
+            const auto& children = nodes_[node].children;
+            if (auto it = FindChild(children, segment);
+                it != children.end() && it->first == segment) {
+                node = it->second;
+            } else if (nodes_[node].param_child != NO_NODE && !segment.empty()
+                       && match.params.Add(segment)) {
+                node = nodes_[node].param_child;
+            } else {
+                return {};
+            }
+        }
+
+        const auto& endpoints = nodes_[node].endpoints;
+        if (endpoints.empty()) {
+            return {};
+        }
+        for (const auto& endpoint : endpoints) {
+            if (endpoint.methods.Contains(method)) {
+                match.status = Status::FOUND;
+                match.handler = endpoint.handler;
+                match.body_limit = endpoint.body_limit;
+                return match;
+            }
+        }
+        return {Status::METHOD_NOT_ALLOWED, {}, {}, 0};
+    }
+
+private:
+    constexpr static size_t ROOT = 0;
+    constexpr static size_t NO_NODE = std::numeric_limits<size_t>::max();
+
+    struct Endpoint {
+        MethodSet methods;
+        Handler handler;
+        std::uint64_t body_limit;
+    };
+
+    // Дочерние узлы отсортированы по ключу для двоичного поиска
+    using Children = std::vector<std::pair<std::string_view, size_t>>;
+
+    struct Node {
+        Children children;
+        size_t param_child = NO_NODE;
+        std::vector<Endpoint> endpoints;
+    };
+
+    static typename Children::const_iterator FindChild(const Children& children,
+                                                       std::string_view key) noexcept {
+        return std::lower_bound(children.begin(), children.end(), key,
+                                [](const auto& child, std::string_view k) {
+                                    return child.first < k;
+                                });
+    }
+
+    // Отделяет от path очередной сегмент. Возвращает false, если сегменты закончились
+    static bool NextSegment(std::string_view& path, std::string_view& segment) noexcept {
+        if (path.empty() || path.front() != '/') {
+            return false;
+        }
+        path.remove_prefix(1);
+        const auto end = std::min(path.find('/'), path.size());
+        segment = path.substr(0, end);
+        path.remove_prefix(end);
+        return true;
+    }
+
+    void AddRoute(const Route<Handler>& route) {
+        size_t node = ROOT;
+        std::string_view path = route.path;
+        std::string_view segment;
+        while (NextSegment(path, segment)) {
+            node = segment == Route<Handler>::PARAM ? AddParamChild(node) : AddChild(node, segment);
+        }
+        nodes_[node].endpoints.push_back({route.methods, route.handler, route.body_limit});
+    }
+
+    size_t AddChild(size_t node, std::string_view key) {
+        auto& children = nodes_[node].children;
+        auto it = FindChild(children, key);
+        if (it != children.end() && it->first == key) {
+            return it->second;
+        }
+        const size_t child = nodes_.size();
+        children.emplace(it, key, child);
+        nodes_.emplace_back();
+        return child;
+    }
+
+    size_t AddParamChild(size_t node) {
+        if (nodes_[node].param_child == NO_NODE) {
+            nodes_[node].param_child = nodes_.size();
+            nodes_.emplace_back();
+        }
+        return nodes_[node].param_child;
+    }
+
+    std::vector<Node> nodes_;
+};
+
+}  // namespace http_handler
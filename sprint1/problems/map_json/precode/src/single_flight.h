@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ * Значение, которое вычисляется при первом обращении ровно один раз, сколько бы потоков
+ * ни запросили его одновременно.
+ * Первый запросивший вычисляет значение в своём потоке. Остальные, пришедшие во время
+ * вычисления, не блокируются: их обработчики сохраняются и вызываются потоком,
+ * вычислившим значение, сразу после вычисления.
+ * Готовое значение читается без блокировок.
+ * Если вычисление выбросило исключение, обработчики всех ожидавших получают nullptr,
+ * а следующее обращение повторяет вычисление.
+ */
+template <typename Value>
+class SingleFlight {
+public:
+    using Handler = std::function<void(const Value*)>;
+
+    SingleFlight() = default;
+
+    // Создаёт уже вычисленное значение
+    explicit SingleFlight(Value value)
+        : value_{std::move(value)}
+        , ready_{true} {
+    }
+
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    // Возвращает значение, если оно уже вычислено, иначе nullptr
+    const Value* TryGet() const noexcept {
+        return ready_.load(std::memory_order_acquire) ? &*value_ : nullptr;
+    }
+
+    // Вызывает handler(const Value*) со значением, при необходимости вычисляя его
+    // вызовом compute(). handler может быть вызван в другом потоке уже после возврата
+    // из Get, поэтому он должен владеть всеми нужными ему данными и быть копируемым
+    template <typename Compute, typename Fn>
+    void Get(Compute&& compute, Fn&& handler) {
+        if (const Value* value = TryGet()) {
+            return handler(value);
+        }
+        {
+            std::unique_lock lk{mutex_};
+            if (ready_.load(std::memory_order_relaxed)) {
+                lk.unlock();
+                return handler(&*value_);
+            }
+            if (computing_) {
+                waiters_.emplace_back(std::forward<Fn>(handler));
+                return;
+            }
+            computing_ = true;
+        }
+
+        // Значение читают только после того, как ready_ станет true,
+        // поэтому его можно записывать без блокировки
+        const Value* result = nullptr;
+        try {
+            value_.emplace(std::forward<Compute>(compute)());
+            result = &*value_;
+        } catch (...) {
+            value_.reset();
+        }
+
+        std::vector<Handler> waiters;
+        {
+            std::lock_guard lk{mutex_};
+            computing_ = false;
+            ready_.store(result != nullptr, std::memory_order_release);
+            waiters.swap(waiters_);
+        }
+        handler(result);
+        for (auto& waiter : waiters) {
+            waiter(result);
+        }
+    }
+
+private:
+    std::optional<Value> value_;
+    std::atomic<bool> ready_{false};
+    std::mutex mutex_;
+    bool computing_ = false;
+    std::vector<Handler> waiters_;
+};
+
+}  // namespace util
@@ -0,0 +1,389 @@
+#include "static_files.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "request_target.h"
+
+namespace http_handler {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::string_view DEFAULT_MIME_TYPE = "application/octet-stream"sv;
+
+// Расширения упорядочены по алфавиту для двоичного поиска
+constexpr std::array<std::pair<std::string_view, std::string_view>, 19> MIME_TYPES{{
+    {".bmp"sv, "image/bmp"sv},
+    {".css"sv, "text/css"sv},
+    {".gif"sv, "image/gif"sv},
+    {".htm"sv, "text/html"sv},
+    {".html"sv, "text/html"sv},
+    {".ico"sv, "image/vnd.microsoft.icon"sv},
+    {".jpe"sv, "image/jpeg"sv},
+    {".jpeg"sv, "image/jpeg"sv},
+    {".jpg"sv, "image/jpeg"sv},
+    {".js"sv, "text/javascript"sv},
+    {".json"sv, "application/json"sv},
+    {".mp3"sv, "audio/mpeg"sv},
+    {".png"sv, "image/png"sv},
+    {".svg"sv, "image/svg+xml"sv},
+    {".svgz"sv, "image/svg+xml"sv},
+    {".tif"sv, "image/tiff"sv},
+    {".tiff"sv, "image/tiff"sv},
+    {".txt"sv, "text/plain"sv},
+    {".xml"sv, "application/xml"sv},
+}};
+
+TextResponse MakeTextResponse(http::status status, std::string_view body, unsigned version,
+                              bool keep_alive) {
+    TextResponse response(status, version);
+    response.set(http::field::content_type, "text/plain"sv);
+    response.body() = body;
+    response.prepare_payload();
+    response.keep_alive(keep_alive);
+    return response;
+}
+
+// Проверяет, что путь path находится внутри каталога base. Оба пути должны быть канонизированы
+bool IsSubPath(const fs::path& path, const fs::path& base) {
+    return std::mismatch(base.begin(), base.end(), path.begin(), path.end()).first == base.end();
+}
+
+// Формат даты HTTP (IMF-fixdate), например "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr const char* HTTP_DATE_FORMAT = "%a, %d %b %Y %H:%M:%S GMT";
+
+std::chrono::system_clock::time_point ToSystemTime(fs::file_time_type time) {
+    return std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+        fs::file_time_type::clock::to_sys(time));
+}
+
+std::string FormatHttpDate(std::chrono::system_clock::time_point time) {
+    const std::time_t t = std::chrono::system_clock::to_time_t(time);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    std::array<char, 32> buffer;
+    const auto size = std::strftime(buffer.data(), buffer.size(), HTTP_DATE_FORMAT, &tm);
+    return {buffer.data(), size};
+}
+
+std::optional<std::chrono::system_clock::time_point> ParseHttpDate(std::string_view text) {
+    std::istringstream in{std::string{text}};
+    in.imbue(std::locale::classic());
+    std::tm tm{};
+    in >> std::get_time(&tm, HTTP_DATE_FORMAT);
+    if (in.fail()) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+
+// Файл не изменился с момента since. Дата в заголовке точна до секунды
+bool IsNotModifiedSince(fs::file_time_type modified, std::string_view since) {
+    const auto since_time = ParseHttpDate(since);
+    return since_time
+        && std::chrono::floor<std::chrono::seconds>(ToSystemTime(modified)) <= *since_time;
+}
+
+struct ByteRange {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+// Результат разбора заголовка Range
+struct RangeRequest {
+    // Заголовок отсутствует, некорректен или запрашивает несколько диапазонов:
+    // отправляется весь файл
+    bool whole_file = true;
+    // Диапазон не пересекается с файлом
+    bool unsatisfiable = false;
+    ByteRange range{};
+};
+
+std::optional<uint64_t> ParseUnsigned(std::string_view text) {
+    uint64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Разбирает заголовок Range вида bytes=first-last, bytes=first- или bytes=-suffix
+RangeRequest ParseRange(std::string_view header, uint64_t file_size) {
+    constexpr auto prefix = "bytes="sv;
+    if (!header.starts_with(prefix) || header.find(',') != std::string_view::npos) {
+        return {};
+    }
+    header.remove_prefix(prefix.size());
+    const auto dash = header.find('-');
+    if (dash == std::string_view::npos) {
+        return {};
+    }
+    const auto first_text = header.substr(0, dash);
+    const auto last_text = header.substr(dash + 1);
+
+    if (first_text.empty()) {
+        const auto suffix = ParseUnsigned(last_text);
+        if (!suffix) {
+            return {};
+        }
+        if (*suffix == 0 || file_size == 0) {
+            return {.whole_file = false, .unsatisfiable = true};
+        }
+        const auto size = std::min(*suffix, file_size);
+        return {.whole_file = false, .range = {file_size - size, size}};
+    }
+
+    const auto first = ParseUnsigned(first_text);
+    const auto last = last_text.empty() ? std::optional{UINT64_MAX} : ParseUnsigned(last_text);
+    if (!first || !last || *last < *first) {
+        return {};
+    }
+    if (*first >= file_size) {
+        return {.whole_file = false, .unsatisfiable = true};
+    }
+    const auto end = std::min(*last, file_size - 1);
+    return {.whole_file = false, .range = {*first, end - *first + 1}};
+}
+
+}  // namespace
+
+std::string_view GetMimeType(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    const auto it = std::lower_bound(MIME_TYPES.begin(), MIME_TYPES.end(), extension,
+                                     [](const auto& item, std::string_view ext) {
+                                         return item.first < ext;
+                                     });
+    if (it != MIME_TYPES.end() && it->first == extension) {
+        return it->second;
+    }
+    return DEFAULT_MIME_TYPE;
+}
+
+StaticFiles::StaticFiles(const fs::path& root, size_t cache_size)
+    : root_{fs::canonical(root)}
+    , cache_size_{cache_size} {
+}
+
+std::optional<fs::path> StaticFiles::Resolve(std::string_view path) const {
+    std::string decoded;
+    try {
+        // В пути запроса + не заменяется на пробел
+        decoded = http_server::UrlDecode(path, false);
+    } catch (const std::invalid_argument&) {
+        return std::nullopt;
+    }
+    // Путь запроса абсолютный, а к корню присоединяется относительный
+    const auto relative_pos = decoded.find_first_not_of('/');
+    const fs::path relative =
+        relative_pos == std::string::npos ? fs::path{} : fs::path{decoded.substr(relative_pos)};
+    std::error_code ec;
+    auto file = fs::weakly_canonical(root_ / relative, ec);
+    if (ec || !IsSubPath(file, root_)) {
+        return std::nullopt;
+    }
+    if (fs::is_directory(file, ec)) {
+        file /= "index.html"sv;
+    }
+    return file;
+}
+
+std::shared_ptr<const StaticFiles::CachedFile> StaticFiles::FindCached(const std::string& key) const {
+    std::shared_ptr<const CachedFile> file;
+    {
+        std::lock_guard lk{mutex_};
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        auto entry = it->second;
+        lru_.splice(lru_.begin(), lru_, entry);
+        const auto now = Clock::now();
+        if (now - entry->checked_at < REVALIDATE_INTERVAL) {
+            return entry->file;
+        }
+        // Остальные потоки до конца проверки отдают файл из кэша, не обращаясь к диску
+        entry->checked_at = now;
+        file = entry->file;
+    }
+
+    std::error_code ec;
+    const auto modified = fs::last_write_time(file->path, ec);
+    const auto size = ec ? 0 : fs::file_size(file->path, ec);
+    if (!ec && modified == file->modified && size == file->content->size()) {
+        return file;
+    }
+    // Файл изменился или удалён: запись удаляется, а файл будет прочитан заново
+    std::lock_guard lk{mutex_};
+    const auto it = index_.find(key);
+    if (it != index_.end() && it->second->file == file) {
+        cached_bytes_ -= file->content->size();
+        auto entry = it->second;
+        index_.erase(it);
+        lru_.erase(entry);
+    }
+    return nullptr;
+}
+
+void StaticFiles::AddToCache(std::string key, std::shared_ptr<const CachedFile> file) const {
+    std::lock_guard lk{mutex_};
+    if (const auto it = index_.find(key); it != index_.end()) {
+        // Файл одновременно прочитали несколько потоков
+        cached_bytes_ -= it->second->file->content->size();
+        auto entry = it->second;
+        index_.erase(it);
+        lru_.erase(entry);
+    }
+    cached_bytes_ += file->content->size();
+    lru_.push_front(CacheEntry{std::move(key), std::move(file), Clock::now()});
+    index_.emplace(lru_.front().key, lru_.begin());
+    while (cached_bytes_ > cache_size_) {
+        auto& oldest = lru_.back();
+        cached_bytes_ -= oldest.file->content->size();
+        index_.erase(oldest.key);
+        lru_.pop_back();
+    }
+}
+
+StaticFileResponse StaticFiles::Get(http::verb method, std::string_view target, unsigned version,
+                                    bool keep_alive, const FileRequestHeaders& headers) const {
+    if (method != http::verb::get && method != http::verb::head) {
+        auto response = MakeTextResponse(http::status::method_not_allowed, "Invalid method"sv,
+                                         version, keep_alive);
+        response.set(http::field::allow, "GET, HEAD"sv);
+        return response;
+    }
+
+    // Ключ кэша - путь запроса до декодирования, чтобы найти файл, не обращаясь к диску
+    std::string key{http_server::RequestTarget{target}.Path()};
+    auto cached = FindCached(key);
+    if (!cached) {
+        const auto file_path = Resolve(key);
+        if (!file_path) {
+            return MakeTextResponse(http::status::bad_request, "Bad request"sv, version, keep_alive);
+        }
+        std::error_code ec;
+        const auto modified = fs::last_write_time(*file_path, ec);
+        const auto size = ec ? 0 : fs::file_size(*file_path, ec);
+        if (ec) {
+            return MakeTextResponse(http::status::not_found, "File not found"sv, version, keep_alive);
+        }
+
+        if (size > MAX_CACHED_FILE_SIZE || size > cache_size_) {
+            return GetUncached(method, *file_path, modified, version, keep_alive, headers);
+        }
+
+        std::string content(size, '\0');
+        std::ifstream in{*file_path, std::ios::binary};
+        if (!in.read(content.data(), static_cast<std::streamsize>(size))) {
+            return MakeTextResponse(http::status::not_found, "File not found"sv, version, keep_alive);
+        }
+        cached = std::make_shared<const CachedFile>(CachedFile{
+            .path = *file_path,
+            .content = std::make_shared<const std::string>(std::move(content)),
+            .mime_type = GetMimeType(*file_path),
+            .modified = modified,
+            .last_modified = FormatHttpDate(ToSystemTime(modified)),
+        });
+        AddToCache(std::move(key), cached);
+    }
+
+    const auto set_headers = [&](auto& response) {
+        response.set(http::field::content_type, cached->mime_type);
+        response.set(http::field::last_modified, cached->last_modified);
+        response.set(http::field::accept_ranges, "bytes"sv);
+        response.keep_alive(keep_alive);
+    };
+    if (IsNotModifiedSince(cached->modified, headers.if_modified_since)) {
+        EmptyResponse response(http::status::not_modified, version);
+        set_headers(response);
+        return response;
+    }
+
+    const uint64_t file_size = cached->content->size();
+    RangeRequest range;
+    // If-Range с устаревшей датой означает, что нужен весь файл
+    if (!headers.range.empty() && (headers.if_range.empty() || headers.if_range == cached->last_modified)) {
+        range = ParseRange(headers.range, file_size);
+    }
+    if (range.unsatisfiable) {
+        auto response = MakeTextResponse(http::status::range_not_satisfiable, "Range not satisfiable"sv,
+                                         version, keep_alive);
+        response.set(http::field::content_range, "bytes */"s + std::to_string(file_size));
+        return response;
+    }
+    if (range.whole_file) {
+        range.range = {0, file_size};
+    }
+    const auto status = range.whole_file ? http::status::ok : http::status::partial_content;
+
+    const auto set_range = [&](auto& response) {
+        set_headers(response);
+        if (!range.whole_file) {
+            response.set(http::field::content_range,
+                         "bytes "s + std::to_string(range.range.offset) + "-"s
+                             + std::to_string(range.range.offset + range.range.size - 1) + "/"s
+                             + std::to_string(file_size));
+        }
+    };
+    if (method == http::verb::head) {
+        EmptyResponse response(status, version);
+        set_range(response);
+        response.content_length(range.range.size);
+        return response;
+    }
+    CachedFileResponse response(status, version);
+    set_range(response);
+    response.body() = {cached->content, range.range.offset, range.range.size};
+    response.prepare_payload();
+    return response;
+}
+
+StaticFileResponse StaticFiles::GetUncached(http::verb method, const fs::path& file_path,
+                                            fs::file_time_type modified, unsigned version,
+                                            bool keep_alive, const FileRequestHeaders& headers) const {
+    const auto set_headers = [&](auto& response) {
+        response.set(http::field::content_type, GetMimeType(file_path));
+        response.set(http::field::last_modified, FormatHttpDate(ToSystemTime(modified)));
+        response.keep_alive(keep_alive);
+    };
+    if (IsNotModifiedSince(modified, headers.if_modified_since)) {
+        EmptyResponse response(http::status::not_modified, version);
+        set_headers(response);
+        return response;
+    }
+
+    http::file_body::value_type file;
+    beast::error_code ec;
+    file.open(file_path.c_str(), beast::file_mode::scan, ec);
+    if (ec) {
+        return MakeTextResponse(http::status::not_found, "File not found"sv, version, keep_alive);
+    }
+    if (method == http::verb::head) {
+        EmptyResponse response(http::status::ok, version);
+        set_headers(response);
+        response.content_length(file.size());
+        return response;
+    }
+    FileResponse response(http::status::ok, version);
+    set_headers(response);
+    response.body() = std::move(file);
+    response.prepare_payload();
+    return response;
+}
+
+}  // namespace http_handler
@@ -0,0 +1,163 @@
+#pragma once
+#include "sdk.h"
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+namespace http_handler {
+
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace fs = std::filesystem;
+
+/*
+ * Тело ответа - часть общего неизменяемого буфера. Копирование тела копирует только
+ * умный указатель, поэтому один буфер отправляется многим клиентам без копирования данных
+ */
+struct SharedBufferBody {
+    struct value_type {
+        std::shared_ptr<const std::string> data;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) noexcept {
+        return body.size;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, typename Fields>
+        writer([[maybe_unused]] const http::header<isRequest, Fields>& header, const value_type& body) noexcept
+            : body_{body} {
+        }
+
+        void init(beast::error_code& ec) noexcept {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) noexcept {
+            ec = {};
+            if (done_) {
+                return boost::none;
+            }
+            done_ = true;
+            return std::pair{net::const_buffer{body_.data->data() + body_.offset, body_.size}, false};
+        }
+
+    private:
+        const value_type& body_;
+        bool done_ = false;
+    };
+};
+
+// Ответ на запрос статического файла
+using FileResponse = http::response<http::file_body>;
+using CachedFileResponse = http::response<SharedBufferBody>;
+using EmptyResponse = http::response<http::empty_body>;
+using TextResponse = http::response<http::string_body>;
+using StaticFileResponse = std::variant<FileResponse, CachedFileResponse, EmptyResponse, TextResponse>;
+
+// Заголовки запроса, от которых зависит ответ на запрос файла
+struct FileRequestHeaders {
+    std::string_view range;
+    std::string_view if_range;
+    std::string_view if_modified_since;
+};
+
+/*
+ * Отдаёт файлы из корневого каталога.
+ * Небольшие файлы хранятся в памяти в кэше, вытесняющем давно не запрашивавшиеся файлы.
+ * Запрос файла из кэша не обращается к диску: ни к содержимому, ни к пути. Изменения файлов
+ * замечаются не позднее чем через REVALIDATE_INTERVAL после изменения.
+ * Тело файла, не поместившегося в кэш, не загружается в память: сервер передаёт его
+ * в сокет по частям (на Linux — системным вызовом sendfile).
+ * Ответы содержат Last-Modified, а на запрос с If-Modified-Since, если файл с тех пор не менялся,
+ * отправляется 304 Not Modified. Для файлов из кэша поддерживается запрос одного диапазона
+ * байтов (Range и If-Range); запрос нескольких диапазонов получает файл целиком.
+ * HEAD-запрос получает только заголовки.
+ * Пути, выходящие за пределы корневого каталога, отклоняются.
+ * Методы класса можно вызывать из разных потоков.
+ */
+class StaticFiles {
+public:
+    // Суммарный размер файлов в кэше
+    constexpr static size_t DEFAULT_CACHE_SIZE = 64 * 1024 * 1024;
+    // Файлы больше этого размера не кэшируются
+    constexpr static size_t MAX_CACHED_FILE_SIZE = 4 * 1024 * 1024;
+    constexpr static std::chrono::seconds REVALIDATE_INTERVAL{1};
+
+    // Каталог root должен существовать
+    explicit StaticFiles(const fs::path& root, size_t cache_size = DEFAULT_CACHE_SIZE);
+
+    StaticFiles(const StaticFiles&) = delete;
+    StaticFiles& operator=(const StaticFiles&) = delete;
+
+    StaticFileResponse Get(http::verb method, std::string_view target, unsigned version,
+                           bool keep_alive, const FileRequestHeaders& headers = {}) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Файл, загруженный в память
+    struct CachedFile {
+        fs::path path;
+        std::shared_ptr<const std::string> content;
+        std::string_view mime_type;
+        fs::file_time_type modified;
+        // Значение Last-Modified
+        std::string last_modified;
+    };
+
+    struct CacheEntry {
+        std::string key;
+        std::shared_ptr<const CachedFile> file;
+        // Время последней проверки, что файл на диске не изменился
+        Clock::time_point checked_at;
+    };
+
+    // Возвращает путь к файлу для пути запроса path или std::nullopt,
+    // если путь некорректен или выходит за пределы корня
+    std::optional<fs::path> Resolve(std::string_view path) const;
+
+    // Возвращает файл из кэша по пути запроса. Давно не проверявшийся файл сверяется с диском
+    std::shared_ptr<const CachedFile> FindCached(const std::string& key) const;
+    void AddToCache(std::string key, std::shared_ptr<const CachedFile> file) const;
+
+    // Отвечает файлом, который не помещается в кэш. Диапазоны байтов не поддерживаются
+    StaticFileResponse GetUncached(http::verb method, const fs::path& file_path,
+                                   fs::file_time_type modified, unsigned version, bool keep_alive,
+                                   const FileRequestHeaders& headers) const;
+
+    fs::path root_;
+    size_t cache_size_;
+
+    mutable std::mutex mutex_;
+    // Записи кэша от недавно запрошенных к давно не запрашивавшимся
+    mutable std::list<CacheEntry> lru_;
+    mutable std::unordered_map<std::string_view, std::list<CacheEntry>::iterator> index_;
+    mutable size_t cached_bytes_ = 0;
+};
+
+// Возвращает MIME-тип файла по его расширению
+std::string_view GetMimeType(const fs::path& path);
+
+}  // namespace http_handler
@@ -0,0 +1,125 @@
+#include "string_index.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace util {
+
+using namespace std::literals;
+
+namespace {
+
+std::uint64_t Mix(std::uint64_t x) noexcept {
+    // Финализатор MurmurHash3: каждый бит результата зависит от всех битов аргумента
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+}  // namespace
+
+StringIndex::StringIndex(std::vector<std::string> keys)
+    : keys_{std::move(keys)} {
+    const size_t count = keys_.size();
+    if (count == 0) {
+        return;
+    }
+    if (count >= EMPTY) {
+        throw std::invalid_argument("Too many keys"s);
+    }
+
+    std::vector<std::uint64_t> hashes(count);
+    std::transform(keys_.begin(), keys_.end(), hashes.begin(), Hash);
+
+    // В среднем по четыре строки на корзину и четверть ячеек таблицы про запас:
+    // при таком заполнении смещения подбираются за несколько попыток
+    const size_t bucket_count = count / 4 + 1;
+    const size_t slot_count = count + count / 4 + 1;
+    std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        buckets[hashes[i] % bucket_count].push_back(i);
+    }
+    // Большие корзины размещаем первыми, пока в таблице много свободных ячеек
+    std::vector<size_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    seeds_.assign(bucket_count, 0);
+    slots_.assign(slot_count, EMPTY);
+    constexpr std::uint32_t MAX_SEED = 1u << 20;
+    std::vector<size_t> placement;
+    for (const size_t bucket : order) {
+        const auto& members = buckets[bucket];
+        if (members.empty()) {
+            break;
+        }
+        // Строки с одинаковым хешем не разделить никаким смещением
+        for (size_t i = 0; i < members.size(); ++i) {
+            for (size_t j = i + 1; j < members.size(); ++j) {
+                if (hashes[members[i]] != hashes[members[j]]) {
+                    continue;
+                }
+                if (keys_[members[i]] == keys_[members[j]]) {
+                    throw std::invalid_argument("Duplicate key "s + keys_[members[i]]);
+                }
+                throw std::runtime_error("Hash collision between "s + keys_[members[i]] + " and "s
+                                         + keys_[members[j]]);
+            }
+        }
+        std::uint32_t seed = 0;
+        for (;; ++seed) {
+            if (seed == MAX_SEED) {
+                throw std::runtime_error("Failed to build string index"s);
+            }
+            placement.clear();
+            bool placed = true;
+            for (const auto member : members) {
+                const size_t slot = Displace(hashes[member], seed) % slot_count;
+                if (slots_[slot] != EMPTY
+                    || std::find(placement.begin(), placement.end(), slot) != placement.end()) {
+                    placed = false;
+                    break;
+                }
+                placement.push_back(slot);
+            }
+            if (placed) {
+                break;
+            }
+        }
+        seeds_[bucket] = seed;
+        for (size_t i = 0; i < members.size(); ++i) {
+            slots_[placement[i]] = members[i];
+        }
+    }
+}
+
+size_t StringIndex::GetMemoryUsage() const noexcept {
+    size_t bytes = keys_.capacity() * sizeof(std::string) + seeds_.capacity() * sizeof(std::uint32_t)
+                 + slots_.capacity() * sizeof(std::uint32_t);
+    for (const auto& key : keys_) {
+        bytes += key.capacity();
+    }
+    return bytes;
+}
+
+std::uint64_t StringIndex::Hash(std::string_view key) noexcept {
+    // FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char c : key) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return Mix(hash);
+}
+
+std::uint64_t StringIndex::Displace(std::uint64_t hash, std::uint32_t seed) noexcept {
+    return Mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL));
+}
+
+}  // namespace util
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+/*
+ * Неизменяемый индекс строк: сопоставляет каждой строке из фиксированного набора
+ * её номер в наборе.
+ * Индекс построен на совершенном хешировании (алгоритм hash and displace): строки
+ * распределены по корзинам, и для каждой корзины подобрано смещение, при котором её строки
+ * попадают в свободные ячейки таблицы. Поэтому поиск вычисляет один хеш, читает две ячейки
+ * и сравнивает не более одной строки, независимо от количества строк в наборе.
+ */
+class StringIndex {
+public:
+    StringIndex() = default;
+
+    // Строит индекс строк keys. Номер строки - её позиция в keys.
+    // Если строки повторяются, выбрасывает исключение std::invalid_argument
+    explicit StringIndex(std::vector<std::string> keys);
+
+    // Возвращает номер строки key либо std::nullopt, если её нет в наборе
+    std::optional<size_t> Find(std::string_view key) const noexcept {
+        if (slots_.empty()) {
+            return std::nullopt;
+        }
+        const auto hash = Hash(key);
+        const auto slot = Displace(hash, seeds_[hash % seeds_.size()]) % slots_.size();
+        if (const auto index = slots_[slot]; index != EMPTY && keys_[index] == key) {
+            return index;
+        }
+        return std::nullopt;
+    }
+
+    size_t Size() const noexcept {
+        return keys_.size();
+    }
+
+    // Строка с номером index
+    const std::string& GetKey(size_t index) const noexcept {
+        return keys_[index];
+    }
+
+    // Объём памяти в куче, занимаемой индексом
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    constexpr static std::uint32_t EMPTY = UINT32_MAX;
+
+    static std::uint64_t Hash(std::string_view key) noexcept;
+    // Положение строки с хешем hash в таблице при смещении seed
+    static std::uint64_t Displace(std::uint64_t hash, std::uint32_t seed) noexcept;
+
+    std::vector<std::string> keys_;
+    // Смещение каждой корзины
+    std::vector<std::uint32_t> seeds_;
+    // Номера строк в ячейках таблицы
+    std::vector<std::uint32_t> slots_;
+};
+
+}  // namespace util
@@ -1,5 +1,10 @@
 #pragma once
 #include <compare>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace util {
 
@@ -54,12 +59,115 @@ private:
     Value value_;
 };
 
-// Хешер для Tagged-типа, чтобы Tagged-объекты можно было хранить в unordered-контейнерах
+namespace detail {
+
+// Строки хешируются как std::string_view: стандарт гарантирует, что хеши std::string
+// и std::string_view с одинаковым содержимым совпадают
+template <typename Value>
+size_t HashValue(const Value& value) {
+    if constexpr (std::is_convertible_v<const Value&, std::string_view>) {
+        return std::hash<std::string_view>{}(value);
+    } else {
+        return std::hash<Value>{}(value);
+    }
+}
+
+}  // namespace detail
+
+/**
+ * Tagged-тип, который вычисляет хеш значения один раз при создании.
+ * Подходит для ключей, которые часто ищут в unordered-контейнерах: TaggedHasher возвращает
+ * сохранённый хеш, а сравнение сначала сверяет хеши и только при совпадении сравнивает значения.
+ * Значение нельзя изменить, иначе сохранённый хеш устареет
+ */
+template <typename Value, typename Tag>
+class HashedTagged {
+public:
+    using ValueType = Value;
+    using TagType = Tag;
+
+    explicit HashedTagged(Value&& v)
+        : value_(std::move(v))
+        , hash_(detail::HashValue(value_)) {
+    }
+    explicit HashedTagged(const Value& v)
+        : value_(v)
+        , hash_(detail::HashValue(value_)) {
+    }
+
+    const Value& operator*() const {
+        return value_;
+    }
+
+    size_t GetHash() const noexcept {
+        return hash_;
+    }
+
+    bool operator==(const HashedTagged& other) const {
+        return hash_ == other.hash_ && value_ == other.value_;
+    }
+
+    auto operator<=>(const HashedTagged& other) const {
+        return value_ <=> other.value_;
+    }
+
+private:
+    Value value_;
+    size_t hash_;
+};
+
+/**
+ * Хешер для Tagged-типа, чтобы Tagged-объекты можно было хранить в unordered-контейнерах.
+ * Хешер прозрачный: вместе с TaggedEqual он позволяет искать по значению без создания Tagged-объекта,
+ * например по std::string_view в контейнере с ключами Tagged<std::string, Tag>:
+ *
+ *  std::unordered_map<Map::Id, size_t, util::TaggedHasher<Map::Id>, util::TaggedEqual<Map::Id>> index;
+ *  index.find("map1"sv);
+ */
 template <typename TaggedValue>
 struct TaggedHasher {
+    using is_transparent = void;
+
     size_t operator()(const TaggedValue& value) const {
-        // Возвращает хеш значения, хранящегося внутри value
-        return std::hash<typename TaggedValue::ValueType>{}(*value);
+        if constexpr (requires { value.GetHash(); }) {
+            return value.GetHash();
+        } else {
+            // Возвращает хеш значения, хранящегося внутри value
+            return detail::HashValue(*value);
+        }
+    }
+
+    // Значение должно хешироваться так же, как значение внутри TaggedValue
+    template <typename Value>
+        requires(!std::is_same_v<Value, TaggedValue>)
+    size_t operator()(const Value& value) const {
+        if constexpr (std::is_convertible_v<const Value&, std::string_view>) {
+            return std::hash<std::string_view>{}(value);
+        } else {
+            return detail::HashValue<typename TaggedValue::ValueType>(value);
+        }
+    }
+};
+
+// Прозрачное сравнение Tagged-объектов друг с другом и со значениями, которые в них хранятся
+template <typename TaggedValue>
+struct TaggedEqual {
+    using is_transparent = void;
+
+    bool operator()(const TaggedValue& lhs, const TaggedValue& rhs) const {
+        return lhs == rhs;
+    }
+
+    template <typename Value>
+        requires(!std::is_same_v<Value, TaggedValue>)
+    bool operator()(const TaggedValue& lhs, const Value& rhs) const {
+        return *lhs == rhs;
+    }
+
+    template <typename Value>
+        requires(!std::is_same_v<Value, TaggedValue>)
+    bool operator()(const Value& lhs, const TaggedValue& rhs) const {
+        return lhs == *rhs;
     }
 };
 
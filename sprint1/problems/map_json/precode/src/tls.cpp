@@ -0,0 +1,108 @@
+#include "tls.h"
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core/error.hpp>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "metrics.h"
+
+namespace http_server {
+
+using namespace std::literals;
+
+/*
+ * Рукопожатие одного соединения. Обработчики рукопожатия и таймера выполняются в strand
+ * пула рукопожатий. Операции ssl::stream выполняют свои промежуточные шаги, включая
+ * вычисления OpenSSL, в исполнителе обработчика завершения, поэтому вся работа
+ * рукопожатия, а не только его завершение, происходит в пуле
+ */
+class TlsContext::Handshake : public std::enable_shared_from_this<Handshake> {
+public:
+    Handshake(TlsContext& context, tcp::socket&& socket, HandshakeHandler on_done)
+        : strand_{net::make_strand(context.handshake_pool_)}
+        , stream_{std::in_place, std::move(socket), context.ssl_context_}
+        , timer_{strand_}
+        , on_done_{std::move(on_done)} {
+    }
+
+    void Start() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            self->timer_.expires_after(HANDSHAKE_TIMEOUT);
+            self->timer_.async_wait([self](boost::system::error_code ec) {
+                self->OnTimeout(ec);
+            });
+            self->stream_->async_handshake(
+                ssl::stream_base::server,
+                net::bind_executor(self->strand_, [self](boost::system::error_code ec) {
+                    self->OnHandshake(ec);
+                }));
+        });
+    }
+
+private:
+    void OnTimeout(boost::system::error_code ec) {
+        if (ec || done_) {
+            return;
+        }
+        // Закрытие сокета отменяет незавершённую операцию рукопожатия
+        timed_out_ = true;
+        stream_->next_layer().close(ec);
+    }
+
+    void OnHandshake(boost::system::error_code ec) {
+        done_ = true;
+        if (timed_out_) {
+            ec = boost::beast::error::timeout;
+        }
+        timer_.cancel();
+        Metrics::Instance().RecordTlsHandshake(
+            ec ? TlsHandshake::FAILED
+            : SSL_session_reused(stream_->native_handle()) ? TlsHandshake::RESUMED
+                                                           : TlsHandshake::FULL);
+        // Дальше соединение обслуживается в исполнителе сокета
+        const auto executor = stream_->get_executor();
+        net::dispatch(executor, [self = shared_from_this(), ec] {
+            self->on_done_(ec, std::move(*self->stream_));
+        });
+    }
+
+    net::strand<net::thread_pool::executor_type> strand_;
+    std::optional<TlsStream> stream_;
+    net::steady_timer timer_;
+    HandshakeHandler on_done_;
+    bool done_ = false;
+    bool timed_out_ = false;
+};
+
+TlsContext::TlsContext(const std::filesystem::path& certificate_chain,
+                       const std::filesystem::path& private_key, unsigned handshake_threads)
+    : ssl_context_{ssl::context::tls_server}
+    , handshake_pool_{std::max(1u, handshake_threads)} {
+    ssl_context_.set_options(ssl::context::default_workarounds | ssl::context::no_sslv2
+                             | ssl::context::no_sslv3 | ssl::context::no_tlsv1
+                             | ssl::context::no_tlsv1_1 | ssl::context::single_dh_use);
+    ssl_context_.use_certificate_chain_file(certificate_chain.string());
+    ssl_context_.use_private_key_file(private_key.string(), ssl::context::pem);
+
+    // Билеты сеансов OpenSSL выдаёт по умолчанию. Серверный кэш нужен клиентам,
+    // которые возобновляют сеанс по идентификатору
+    SSL_CTX* native = ssl_context_.native_handle();
+    SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(native, SESSION_CACHE_SIZE);
+    SSL_CTX_set_timeout(native, static_cast<long>(SESSION_LIFETIME.count()));
+    constexpr std::string_view session_id_context = "game_server"sv;
+    SSL_CTX_set_session_id_context(
+        native, reinterpret_cast<const unsigned char*>(session_id_context.data()),
+        static_cast<unsigned>(session_id_context.size()));
+}
+
+void TlsContext::AsyncHandshake(tcp::socket&& socket, HandshakeHandler on_done) {
+    std::make_shared<Handshake>(*this, std::move(socket), std::move(on_done))->Start();
+}
+
+}  // namespace http_server
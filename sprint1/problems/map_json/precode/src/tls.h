@@ -0,0 +1,68 @@
+#pragma once
+#include "sdk.h"
+//
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/beast/ssl/ssl_stream.hpp>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+
+namespace http_server {
+
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+using TlsStream = boost::beast::ssl_stream<tcp::socket>;
+
+/*
+ * Параметры TLS, общие для всех слушателей сервера.
+ *
+ * Возобновление сеансов: сервер хранит сеансы в кэше и выдаёт билеты (session tickets).
+ * Ключ билетов создаётся при запуске и общий для всех слушателей, поэтому клиент
+ * возобновляет сеанс, даже если новое соединение примет другой поток (SO_REUSEPORT).
+ *
+ * Полное рукопожатие требует дорогих операций с открытым ключом, поэтому оно выполняется
+ * в собственном пуле потоков и не задерживает обработку запросов в потоках io_context.
+ * Сокет при этом остаётся в io_context: пул только продолжает рукопожатие по мере
+ * поступления данных и не ждёт сеть.
+ *
+ * Объект должен жить дольше io_context, в котором работают его соединения, а к уничтожению
+ * io_context рукопожатия должны завершиться. Слушатель учитывает незавершённые рукопожатия
+ * как активные сеансы, поэтому после AsyncDrain это условие выполнено.
+ */
+class TlsContext {
+public:
+    // Допустимое время рукопожатия
+    constexpr static std::chrono::seconds HANDSHAKE_TIMEOUT{10};
+    // Количество сеансов в кэше сервера и время, в течение которого сеанс можно возобновить
+    constexpr static long SESSION_CACHE_SIZE = 20 * 1024;
+    constexpr static std::chrono::seconds SESSION_LIFETIME{2 * 60 * 60};
+
+    // Загружает цепочку сертификатов и закрытый ключ в формате PEM
+    TlsContext(const std::filesystem::path& certificate_chain,
+               const std::filesystem::path& private_key, unsigned handshake_threads);
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    ssl::context& GetSslContext() noexcept {
+        return ssl_context_;
+    }
+
+    using HandshakeHandler = std::function<void(boost::system::error_code ec, TlsStream&& stream)>;
+
+    // Выполняет рукопожатие на принятом сокете и вызывает on_done в исполнителе сокета.
+    // Если рукопожатие не завершилось за HANDSHAKE_TIMEOUT, on_done получает ошибку
+    void AsyncHandshake(tcp::socket&& socket, HandshakeHandler on_done);
+
+private:
+    class Handshake;
+
+    ssl::context ssl_context_;
+    net::thread_pool handshake_pool_;
+};
+
+}  // namespace http_server
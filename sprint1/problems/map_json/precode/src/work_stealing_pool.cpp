@@ -0,0 +1,104 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+namespace util {
+
+namespace {
+
+// Пул и очередь, которые обслуживает текущий поток
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    threads = std::max(1u, threads);
+    queues_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    threads_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        threads_.emplace_back(&WorkStealingPool::Run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lk{sleep_mutex_};
+        stopped_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task) {
+    const size_t index = current_pool == this
+                           ? current_queue
+                           : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        // Счётчик меняется под мьютексом ожидания, иначе поток, проверивший его
+        // перед засыпанием, пропустил бы пробуждение. Увеличиваем его до постановки задачи,
+        // чтобы забравший её поток не уменьшил счётчик раньше
+        std::lock_guard lk{sleep_mutex_};
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lk{queues_[index]->mutex};
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::Run(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    Task task;
+    while (true) {
+        if (TryPop(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock lk{sleep_mutex_};
+        wake_.wait(lk, [this] {
+            return stopped_ || pending_.load(std::memory_order_relaxed) != 0;
+        });
+        if (stopped_) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::TryPop(size_t index, Task& task) {
+    {
+        auto& own = *queues_[index];
+        std::lock_guard lk{own.mutex};
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return TrySteal(index, task);
+}
+
+bool WorkStealingPool::TrySteal(size_t thief, Task& task) {
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        auto& victim = *queues_[(thief + i) % queues_.size()];
+        std::lock_guard lk{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace util
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/*
+ * Пул потоков для вычислений, которые не должны занимать потоки ввода-вывода.
+ * У каждого потока своя очередь задач. Задачи, поставленные из потока пула, попадают
+ * в его очередь и выполняются им в обратном порядке, пока данные ещё в кэше процессора.
+ * Остальные задачи распределяются по очередям по кругу. Поток, очередь которого опустела,
+ * забирает самую старую задачу из очереди другого потока, поэтому одна долгая задача
+ * не задерживает стоящие за ней, пока есть свободные потоки.
+ * Задачи, не выполненные к уничтожению пула, уничтожаются без выполнения.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Ставит задачу в очередь. Может быть вызван из любого потока
+    void Submit(Task task);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Run(size_t index);
+    // Берёт задачу из своей очереди, а если она пуста - из чужой
+    bool TryPop(size_t index, Task& task);
+    bool TrySteal(size_t thief, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<size_t> next_queue_{0};
+    // Количество задач во всех очередях. Потоки засыпают, только когда оно равно нулю
+    std::atomic<size_t> pending_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace util
@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+#include "../src/json_body.h"
+
+using namespace http_handler;
+using namespace std::literals;
+
+namespace {
+
+// Возвращает поле name объекта, чтобы проверить, что handler получает разобранное значение
+std::string GetName(const json::value& value) {
+    return std::string{value.as_object().at("name").as_string()};
+}
+
+}  // namespace
+
+SCENARIO("JSON request body") {
+    GIVEN("a small body") {
+        const auto body = R"({"name": "Rex", "mapId": "map1"})"sv;
+
+        THEN("the value is passed to the handler") {
+            const auto name = ParseJsonBody(body, GetName);
+            REQUIRE(name);
+            CHECK(*name == "Rex"s);
+        }
+    }
+
+    GIVEN("a body larger than the stack buffer") {
+        const std::string long_name(2 * JSON_BODY_BUFFER_SIZE, 'x');
+        const auto body = R"({"name": ")"s + long_name + R"(", "mapId": "map1"})"s;
+        REQUIRE(body.size() > JSON_BODY_BUFFER_SIZE);
+
+        THEN("the value is built partly on the heap and passed whole") {
+            const auto name = ParseJsonBody(body, GetName);
+            REQUIRE(name);
+            CHECK(*name == long_name);
+        }
+    }
+
+    GIVEN("malformed bodies") {
+        THEN("they are rejected without calling the handler") {
+            bool called = false;
+            const auto handler = [&called](const json::value&) {
+                called = true;
+                return 0;
+            };
+            for (const auto body : {""sv, "{"sv, R"({"name": "Rex",})"sv, R"({"name": "Rex"} x)"sv}) {
+                CHECK_FALSE(ParseJsonBody(body, handler));
+            }
+            CHECK_FALSE(called);
+        }
+
+        THEN("the thread parser still handles the next body") {
+            CHECK_FALSE(ParseJsonBody(R"({"name": )"sv, GetName));
+            const auto name = ParseJsonBody(R"({"name": "Pluto"})"sv, GetName);
+            REQUIRE(name);
+            CHECK(*name == "Pluto"s);
+        }
+    }
+}
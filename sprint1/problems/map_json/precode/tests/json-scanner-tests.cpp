@@ -0,0 +1,44 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/json_scanner.h"
+
+using namespace json_loader;
+using namespace std::literals;
+
+SCENARIO("JSON scanner") {
+    GIVEN("an object with an array") {
+        const auto text = R"({"roads": [1], "maps": [{"id": "map1"}, [2, 3], "x"]})"sv;
+
+        THEN("array items are found without parsing them") {
+            const auto items = FindArrayItems(text, "maps"sv);
+            REQUIRE(items);
+            REQUIRE(items->size() == 3);
+            CHECK((*items)[0] == R"({"id": "map1"})"sv);
+            CHECK((*items)[1] == "[2, 3]"sv);
+            CHECK((*items)[2] == R"("x")"sv);
+            CHECK_FALSE(FindArrayItems(text, "offices"sv));
+        }
+    }
+
+    GIVEN("truncated documents") {
+        THEN("every prefix is rejected with ScanError") {
+            const auto text = R"({"maps":[{"id":"map1","roads":[{"x0":0}]}]})"sv;
+            for (size_t size = 0; size < text.size(); ++size) {
+                CHECK_THROWS_AS(FindArrayItems(text.substr(0, size), "maps"sv), ScanError);
+            }
+            CHECK_NOTHROW(FindArrayItems(text, "maps"sv));
+        }
+
+        THEN("a string at the end of a container reports the end of text") {
+            // Копия без завершающего нуля, чтобы чтение за концом было заметно санитайзеру
+            const std::string text{R"({"maps":[{"id")"};
+            try {
+                FindArrayItems(text, "maps"sv);
+                FAIL("ScanError expected");
+            } catch (const ScanError& e) {
+                CHECK(e.what() == "Unexpected end of text"s);
+                CHECK(e.GetOffset() == text.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "../src/request_handler.h"
+
+using namespace http_handler;
+using namespace std::literals;
+
+namespace {
+
+using Request = http::request<http::empty_body>;
+
+// Ответ кэша на запрос в том виде, в котором он уходит в сокет
+std::string GetResponse(const ResponseCache& cache, const Request& req) {
+    std::optional<std::string> result;
+    cache.Find(req.method(), req.target()).Get([&](const http_server::StaticResponse* response) {
+        REQUIRE(response);
+        std::string text;
+        for (const auto& buffer : response->Prepare(req).GetBuffers()) {
+            text.append(static_cast<const char*>(buffer.data()), buffer.size());
+        }
+        result = std::move(text);
+    });
+    // Без пула потоков ответ строится в вызывающем потоке
+    REQUIRE(result);
+    return *result;
+}
+
+// Значение заголовка name или пустая строка, если его нет
+std::string GetHeader(std::string_view response, std::string_view name) {
+    const auto start = response.find("\r\n"s + std::string{name} + ": "s);
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    const auto value_start = start + name.size() + 4;
+    return std::string{response.substr(value_start, response.find("\r\n"sv, value_start) - value_start)};
+}
+
+Request MakeRequest(std::string_view target, std::string_view if_none_match = {}) {
+    Request req{http::verb::get, target, 11};
+    if (!if_none_match.empty()) {
+        req.set(http::field::if_none_match, if_none_match);
+    }
+    return req;
+}
+
+}  // namespace
+
+SCENARIO("Map responses revalidation") {
+    GIVEN("a cache over a game with a map") {
+        auto game = std::make_shared<model::Game>();
+        game->AddMap(model::Map{model::Map::Id{"map1"s}, "Map 1"s});
+        const ResponseCache cache{std::move(game)};
+
+        for (const auto target : {"/api/v1/maps"sv, "/api/v1/maps/map1"sv}) {
+            WHEN("the client requests "s + std::string{target}) {
+                const auto response = GetResponse(cache, MakeRequest(target));
+                const auto etag = GetHeader(response, "ETag"sv);
+
+                THEN("the response must be revalidated by its ETag") {
+                    CHECK(response.starts_with("HTTP/1.1 200 OK\r\n"sv));
+                    CHECK(GetHeader(response, "Cache-Control"sv) == "no-cache"s);
+                    REQUIRE(etag.size() > 2);
+                    CHECK(etag.front() == '"');
+                    CHECK(etag.back() == '"');
+                }
+
+                THEN("a matching If-None-Match gets 304 without a body") {
+                    const auto not_modified = GetResponse(cache, MakeRequest(target, etag));
+                    CHECK(not_modified.starts_with("HTTP/1.1 304 Not Modified\r\n"sv));
+                    CHECK(GetHeader(not_modified, "ETag"sv) == etag);
+                    CHECK(GetHeader(not_modified, "Cache-Control"sv) == "no-cache"s);
+                    CHECK(not_modified.ends_with("\r\n\r\n"sv));
+                    CHECK(GetHeader(not_modified, "Content-Length"sv).empty());
+                }
+
+                THEN("a weak or listed match gets 304 too") {
+                    CHECK(GetResponse(cache, MakeRequest(target, "W/"s + etag))
+                              .starts_with("HTTP/1.1 304 "sv));
+                    CHECK(GetResponse(cache, MakeRequest(target, R"("other", )"s + etag))
+                              .starts_with("HTTP/1.1 304 "sv));
+                }
+
+                THEN("a different ETag gets the full response") {
+                    CHECK(GetResponse(cache, MakeRequest(target, R"("other")"sv)) == response);
+                }
+            }
+        }
+
+        WHEN("the map is not found") {
+            const auto response = GetResponse(cache, MakeRequest("/api/v1/maps/map2"sv));
+
+            THEN("the error has no ETag") {
+                CHECK(response.starts_with("HTTP/1.1 404 Not Found\r\n"sv));
+                CHECK(GetHeader(response, "ETag"sv).empty());
+            }
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "voice.h"
+
+/*
+Сжатие пакета с голосом примерно в 11 раз: частота понижается в ADPCM_DECIMATION раз
+(44100 -> 7350 Гц, полоса как у телефона), затем каждый отсчёт кодируется 4 битами IMA ADPCM.
+Пакет начинается с состояния кодера (предсказанный отсчёт и индекс шага), поэтому
+декодируется независимо от остальных, и потеря или перестановка пакетов не портит соседние
+*/
+constexpr size_t ADPCM_DECIMATION = 6;
+constexpr size_t ADPCM_SAMPLES_PER_PACKET = FRAMES_PER_PACKET / ADPCM_DECIMATION;
+static_assert(FRAMES_PER_PACKET % ADPCM_DECIMATION == 0);
+
+// Заголовок: предсказанный отсчёт (2 байта, big endian) и индекс шага (1 байт), затем по 4 бита на отсчёт
+constexpr size_t ADPCM_HEADER_SIZE = 3;
+constexpr size_t ADPCM_PACKET_SIZE = ADPCM_HEADER_SIZE + (ADPCM_SAMPLES_PER_PACKET + 1) / 2;
+constexpr size_t ADPCM_DATAGRAM_SIZE = VOICE_SEQUENCE_SIZE + ADPCM_PACKET_SIZE;
+
+namespace adpcm_detail {
+
+constexpr std::array<int8_t, 16> INDEX_TABLE = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                                -1, -1, -1, -1, 2, 4, 6, 8};
+
+constexpr std::array<int16_t, 89> STEP_TABLE = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,
+    25,    28,    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,
+    88,    97,    107,   118,   130,   143,   157,   173,   190,   209,   230,   253,   279,
+    307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,
+    1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,
+    3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+struct State {
+    int predictor = 0;
+    int index = 0;
+
+    // Обновляет предсказание по коду так же, как это сделает декодер
+    void Apply(uint8_t code) noexcept {
+        const int step = STEP_TABLE[index];
+        int diff = step >> 3;
+        if (code & 4) {
+            diff += step;
+        }
+        if (code & 2) {
+            diff += step >> 1;
+        }
+        if (code & 1) {
+            diff += step >> 2;
+        }
+        predictor = std::clamp(code & 8 ? predictor - diff : predictor + diff, -32768, 32767);
+        index = std::clamp(index + INDEX_TABLE[code], 0, static_cast<int>(STEP_TABLE.size()) - 1);
+    }
+
+    uint8_t Encode(int sample) noexcept {
+        int diff = sample - predictor;
+        uint8_t code = 0;
+        if (diff < 0) {
+            code = 8;
+            diff = -diff;
+        }
+        int step = STEP_TABLE[index];
+        for (uint8_t bit = 4; bit != 0; bit >>= 1) {
+            if (diff >= step) {
+                code |= bit;
+                diff -= step;
+            }
+            step >>= 1;
+        }
+        Apply(code);
+        return code;
+    }
+};
+
+// ma_format_u8 <-> 16-битный отсчёт со знаком, с которым работает IMA ADPCM
+inline int ToPcm16(char frame) noexcept {
+    return (static_cast<uint8_t>(frame) - 128) * 256;
+}
+
+inline char FromPcm16(int sample) noexcept {
+    return static_cast<char>(std::clamp((sample + 32768 + 128) / 256, 0, 255));
+}
+
+}  // namespace adpcm_detail
+
+/*
+Кодер хранит состояние между пакетами, чтобы предсказание не начиналось каждый раз с нуля.
+Используется в одном потоке
+*/
+class AdpcmEncoder {
+public:
+    // Кодирует FRAMES_PER_PACKET кадров в ADPCM_PACKET_SIZE байтов
+    void Encode(const std::array<char, FRAMES_PER_PACKET>& samples, char* out) noexcept {
+        out[0] = static_cast<char>(state_.predictor >> 8);
+        out[1] = static_cast<char>(state_.predictor);
+        out[2] = static_cast<char>(state_.index);
+        std::fill_n(out + ADPCM_HEADER_SIZE, ADPCM_PACKET_SIZE - ADPCM_HEADER_SIZE, 0);
+
+        for (size_t i = 0; i < ADPCM_SAMPLES_PER_PACKET; ++i) {
+            // Усреднение соседних кадров подавляет частоты, которые не передать после понижения частоты
+            int sum = 0;
+            for (size_t j = 0; j < ADPCM_DECIMATION; ++j) {
+                sum += adpcm_detail::ToPcm16(samples[i * ADPCM_DECIMATION + j]);
+            }
+            const uint8_t code = state_.Encode(sum / static_cast<int>(ADPCM_DECIMATION));
+            out[ADPCM_HEADER_SIZE + i / 2] |= static_cast<char>(i % 2 == 0 ? code : code << 4);
+        }
+    }
+
+private:
+    adpcm_detail::State state_;
+};
+
+/*
+Восстанавливает FRAMES_PER_PACKET кадров из ADPCM_PACKET_SIZE байтов. Промежуточные кадры
+интерполируются линейно, начиная с предсказанного отсчёта из заголовка, то есть с последнего
+отсчёта предыдущего пакета. Возвращает false, если заголовок повреждён
+*/
+inline bool DecodeAdpcm(const char* data, std::array<char, FRAMES_PER_PACKET>& samples) noexcept {
+    adpcm_detail::State state;
+    state.predictor = static_cast<int16_t>(static_cast<uint8_t>(data[0]) << 8 | static_cast<uint8_t>(data[1]));
+    state.index = static_cast<uint8_t>(data[2]);
+    if (state.index >= static_cast<int>(adpcm_detail::STEP_TABLE.size())) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ADPCM_SAMPLES_PER_PACKET; ++i) {
+        const int previous = state.predictor;
+        const auto byte = static_cast<uint8_t>(data[ADPCM_HEADER_SIZE + i / 2]);
+        state.Apply(i % 2 == 0 ? byte & 0x0F : byte >> 4);
+        for (size_t j = 0; j < ADPCM_DECIMATION; ++j) {
+            const int step = static_cast<int>(j) + 1;
+            const int sample = previous + (state.predictor - previous) * step / static_cast<int>(ADPCM_DECIMATION);
+            samples[i * ADPCM_DECIMATION + j] = adpcm_detail::FromPcm16(sample);
+        }
+    }
+    return true;
+}
+
+inline void SerializeAdpcmPacket(const VoicePacket& packet, AdpcmEncoder& encoder, char* out) {
+    WriteSequence(packet.sequence, out);
+    encoder.Encode(packet.samples, out + VOICE_SEQUENCE_SIZE);
+}
+
+inline bool ParseAdpcmPacket(const char* data, size_t size, VoicePacket& packet) {
+    if (size != ADPCM_DATAGRAM_SIZE) {
+        return false;
+    }
+    packet.sequence = ReadSequence(data);
+    return DecodeAdpcm(data + VOICE_SEQUENCE_SIZE, packet.samples);
+}
@@ -4,40 +4,111 @@
 #include <miniaudio.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <thread>
 #include <chrono>
 #include <vector>
 
+#include "spsc_ring.h"
+
+constexpr ma_uint32 AUDIO_SAMPLE_RATE = 44100;
+// Период обработчика miniaudio: короткий, чтобы при потоковой передаче звук не задерживался в драйвере
+constexpr ma_uint32 AUDIO_PERIOD_MS = 10;
+// Сколько ждать сверх ожидаемой длительности, прежде чем решить, что устройство не работает
+constexpr auto AUDIO_DEVICE_TIMEOUT = std::chrono::milliseconds{500};
+
+template <typename Rep, typename Period>
+size_t DurationToFrames(std::chrono::duration<Rep, Period> dur) {
+    return static_cast<size_t>(std::chrono::duration<double>(dur).count() * AUDIO_SAMPLE_RATE);
+}
+
+/*
+Счётчик кадров, обработанных обработчиком miniaudio, достижения которого может дождаться
+поток приложения. Обработчик не захватывает мьютекс: он увеличивает счётчик и будит
+ожидающего, если счётчик достиг заказанного значения. Уведомление, пришедшее между проверкой
+и засыпанием, теряется, но следующий вызов обработчика (через один период) разбудит снова
+*/
+class FrameCounter {
+public:
+    // Вызывается, когда устройство остановлено
+    void Reset() noexcept {
+        count_.store(0, std::memory_order_relaxed);
+    }
+
+    // Вызывается из обработчика miniaudio
+    void Add(size_t frames) noexcept {
+        const size_t total = count_.fetch_add(frames, std::memory_order_acq_rel) + frames;
+        if (total >= wake_at_.load(std::memory_order_relaxed)) {
+            cond_var_.notify_all();
+        }
+    }
+
+    size_t Get() const noexcept {
+        return count_.load(std::memory_order_acquire);
+    }
+
+    // Ждёт, пока счётчик достигнет frames, но не дольше deadline. Возвращает значение счётчика
+    size_t WaitFor(size_t frames, std::chrono::steady_clock::time_point deadline) {
+        wake_at_.store(frames, std::memory_order_relaxed);
+        std::unique_lock lock{mutex_};
+        cond_var_.wait_until(lock, deadline, [this, frames] {
+            return Get() >= frames;
+        });
+        wake_at_.store(NOBODY_WAITS, std::memory_order_relaxed);
+        return Get();
+    }
+
+private:
+    static constexpr size_t NOBODY_WAITS = std::numeric_limits<size_t>::max();
+
+    std::atomic<size_t> count_ = 0;
+    std::atomic<size_t> wake_at_ = NOBODY_WAITS;
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+};
+
 class Recorder {
     static void Callback(ma_device* pDevice, void* pOutput, const void* pInput,
                          ma_uint32 frameCount) {
         Recorder* recorder = reinterpret_cast<Recorder*>(pDevice->pUserData);
 
-        recorder->SaveBuffer(pInput, frameCount);
+        if (recorder->sink_) {
+            recorder->sink_(reinterpret_cast<const char*>(pInput), frameCount);
+        } else {
+            recorder->SaveBuffer(pInput, frameCount);
+        }
     }
 
+    // Выполняется в потоке miniaudio: только копирует кадры в кольцевой буфер.
+    // Если приложение не успевает их забирать, не поместившиеся кадры теряются
     void SaveBuffer(const void* pInput, ma_uint32 frameCount) {
-        size_t size = std::min(static_cast<size_t>(frameCount * frame_size_),
-                               buffer_.size() - current_off_);
+        const size_t frames = std::min<size_t>(frameCount, ring_.Free() / frame_size_);
 
-        std::copy_n(reinterpret_cast<const char*>(pInput), size, buffer_.data() + current_off_);
+        ring_.Write(reinterpret_cast<const char*>(pInput), frames * frame_size_);
 
-        current_off_ += size;
+        dropped_frames_.fetch_add(frameCount - frames, std::memory_order_relaxed);
+        captured_.Add(frames);
     }
 
 public:
-    Recorder(ma_format format, int channels) {
+    Recorder(ma_format format, int channels)
+        : frame_size_(ma_get_bytes_per_frame(format, channels))
+        , ring_(AUDIO_SAMPLE_RATE * frame_size_) {
         ma_device_config device_config;
 
         device_config = ma_device_config_init(ma_device_type_capture);
         device_config.capture.pDeviceID = NULL;
         device_config.capture.format = format;
         device_config.capture.channels = channels;
-        device_config.sampleRate = 44100;
+        device_config.sampleRate = AUDIO_SAMPLE_RATE;
+        device_config.periodSizeInMilliseconds = AUDIO_PERIOD_MS;
         device_config.dataCallback = Callback;
         device_config.pUserData = this;
 
-        frame_size_ = ma_get_bytes_per_frame(format, channels);
         init_result_ = ma_device_init(NULL, &device_config, &device_);
     }
 
@@ -50,17 +121,68 @@ public:
         size_t frames;
     };
 
+    // Записывает dur звука, но не больше max_frames кадров, и возвращается сразу, как только
+    // они записаны. Если устройство не присылает кадры, возвращает то, что успело прийти
     template <typename Rep, typename Period>
     RecordingResult Record(size_t max_frames, std::chrono::duration<Rep, Period> dur) {
-        current_off_ = 0;
+        const size_t target = std::min(max_frames, DurationToFrames(dur));
+        std::vector<char> data(max_frames * frame_size_);
+        size_t frames = 0;
+
+        const auto deadline = std::chrono::steady_clock::now()
+                            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(dur)
+                            + AUDIO_DEVICE_TIMEOUT;
+        Start();
+        while (frames < target) {
+            // Кадры забираются порциями по четверти буфера, чтобы он не переполнился
+            const size_t wait_for = std::min(target, frames + ring_.Capacity() / frame_size_ / 4);
+            const bool timed_out = WaitForFrames(wait_for, deadline) < wait_for;
+            frames += Read(data.data() + frames * frame_size_, target - frames);
+            if (timed_out) {
+                break;
+            }
+        }
+        Stop();
+
+        return {std::move(data), frames};
+    }
+
+    // Записывает непрерывно, пока не будет вызван Stop. Кадры нужно забирать через Read
+    void Start() {
+        // Устройство остановлено, поэтому буфер можно очистить от остатков прошлой записи
+        ring_.Clear();
+        captured_.Reset();
+        ma_device_start(&device_);
+    }
 
-        buffer_.resize(max_frames * frame_size_);
+    // Ждёт, пока с вызова Start будет записано не меньше frames кадров, но не дольше deadline.
+    // Возвращает количество записанных кадров
+    size_t WaitForFrames(size_t frames, std::chrono::steady_clock::time_point deadline) {
+        return captured_.WaitFor(frames, deadline);
+    }
+
+    // Забирает до max_frames записанных кадров в out и возвращает их количество
+    size_t Read(char* out, size_t max_frames) {
+        return ring_.Read(out, max_frames * frame_size_) / frame_size_;
+    }
 
+    // Сколько кадров потеряно из-за того, что приложение не успевало их забирать
+    size_t GetDroppedFrames() const {
+        return dropped_frames_.load(std::memory_order_relaxed);
+    }
+
+    // Получает записанные кадры в потоке miniaudio. Не должен блокироваться и выделять память
+    using FrameSink = std::function<void(const char* data, size_t frames)>;
+
+    // Записывает непрерывно, передавая кадры в sink по мере поступления, до вызова Stop
+    void Start(FrameSink sink) {
+        sink_ = std::move(sink);
         ma_device_start(&device_);
-        std::this_thread::sleep_for(dur);
-        ma_device_stop(&device_);
+    }
 
-        return {std::move(buffer_), current_off_ / frame_size_};
+    void Stop() {
+        ma_device_stop(&device_);
+        sink_ = nullptr;
     }
 
     int GetFrameSize() const {
@@ -72,9 +194,12 @@ private:
     ma_result init_result_;
     int frame_size_;
 
-    std::vector<char> buffer_;
+    SpscByteRing ring_;
+    std::atomic<size_t> dropped_frames_ = 0;
+    // Сколько кадров попало в ring_ с вызова Start
+    FrameCounter captured_;
 
-    size_t current_off_;
+    FrameSink sink_;
 };
 
 class Player {
@@ -82,31 +207,36 @@ class Player {
                          ma_uint32 frameCount) {
         Player* player = reinterpret_cast<Player*>(pDevice->pUserData);
 
-        player->FillBuffer(pOutput, frameCount);
+        if (player->source_) {
+            player->source_(reinterpret_cast<char*>(pOutput), frameCount);
+        } else {
+            player->FillBuffer(pOutput, frameCount);
+        }
     }
 
+    // Выполняется в потоке miniaudio: только копирует кадры из кольцевого буфера.
+    // Если кадров не хватает, остаток заполнен тишиной, которую miniaudio записывает заранее
     void FillBuffer(void* pOutput, ma_uint32 frameCount) {
-        size_t size = std::min(static_cast<size_t>(frameCount * frame_size_),
-                               max_frame_ * frame_size_ - current_off_);
-
-        std::copy_n(current_buffer_ + current_off_, size, reinterpret_cast<char*>(pOutput));
+        const size_t size = ring_.Read(reinterpret_cast<char*>(pOutput), frameCount * frame_size_);
 
-        current_off_ += size;
+        played_.Add(size / frame_size_);
     }
 
 public:
-    Player(ma_format format, int channels) {
+    Player(ma_format format, int channels)
+        : frame_size_(ma_get_bytes_per_frame(format, channels))
+        , ring_(AUDIO_SAMPLE_RATE * frame_size_) {
         ma_device_config device_config;
 
         device_config = ma_device_config_init(ma_device_type_playback);
         device_config.playback.pDeviceID = NULL;
         device_config.playback.format = format;
         device_config.playback.channels = channels;
-        device_config.sampleRate = 44100;
+        device_config.sampleRate = AUDIO_SAMPLE_RATE;
+        device_config.periodSizeInMilliseconds = AUDIO_PERIOD_MS;
         device_config.dataCallback = Callback;
         device_config.pUserData = this;
 
-        frame_size_ = ma_get_bytes_per_frame(format, channels);
         init_result_ = ma_device_init(NULL, &device_config, &device_);
     }
 
@@ -114,15 +244,62 @@ public:
         ma_device_uninit(&device_);
     }
 
+    // Воспроизводит frames кадров, но не дольше dur, и возвращается, как только они сыграны
     template <typename Rep, typename Period>
     void PlayBuffer(const char* data, size_t frames, std::chrono::duration<Rep, Period> dur) {
-        current_buffer_ = data;
-        current_off_ = 0;
-        max_frame_ = frames;
+        const auto deadline = std::chrono::steady_clock::now()
+                            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(dur);
+        const size_t half_ring = ring_.Capacity() / frame_size_ / 2;
+        Start();
+        size_t written = Write(data, frames);
+        for (;;) {
+            // Просыпаемся, когда освободилась половина буфера либо доиграны все кадры
+            const size_t wait_for = written < frames ? written - half_ring : frames;
+            if (WaitForPlayed(wait_for, deadline) < wait_for) {
+                break;
+            }
+            if (written == frames) {
+                // Последний период ещё звучит в устройстве
+                std::this_thread::sleep_for(std::chrono::milliseconds{AUDIO_PERIOD_MS});
+                break;
+            }
+            written += Write(data + written * frame_size_, frames - written);
+        }
+        Stop();
+    }
 
+    // Воспроизводит непрерывно, пока не будет вызван Stop. Кадры нужно добавлять через Write
+    void Start() {
+        // Устройство остановлено, поэтому недоигранные кадры можно отбросить
+        ring_.Clear();
+        played_.Reset();
         ma_device_start(&device_);
-        std::this_thread::sleep_for(dur);
+    }
+
+    // Ждёт, пока с вызова Start будет сыграно не меньше frames кадров, но не дольше deadline.
+    // Возвращает количество сыгранных кадров
+    size_t WaitForPlayed(size_t frames, std::chrono::steady_clock::time_point deadline) {
+        return played_.WaitFor(frames, deadline);
+    }
+
+    // Добавляет в очередь воспроизведения до frames кадров и возвращает, сколько поместилось
+    size_t Write(const char* data, size_t frames) {
+        const size_t fit = std::min(frames, ring_.Free() / frame_size_);
+        return ring_.Write(data, fit * frame_size_) / frame_size_;
+    }
+
+    // Заполняет буфер кадрами в потоке miniaudio. Не должен блокироваться и выделять память
+    using FrameSource = std::function<void(char* out, size_t frames)>;
+
+    // Воспроизводит непрерывно, запрашивая кадры у source, до вызова Stop
+    void Start(FrameSource source) {
+        source_ = std::move(source);
+        ma_device_start(&device_);
+    }
+
+    void Stop() {
         ma_device_stop(&device_);
+        source_ = nullptr;
     }
 
     int GetFrameSize() const {
@@ -134,7 +311,9 @@ private:
     ma_result init_result_;
     int frame_size_;
 
-    const char* current_buffer_;
-    size_t current_off_;
-    size_t max_frame_;
+    SpscByteRing ring_;
+    // Сколько кадров взято из ring_ с вызова Start
+    FrameCounter played_;
+
+    FrameSource source_;
 };
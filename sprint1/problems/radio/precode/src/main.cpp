@@ -1,9 +1,154 @@
+#include "adpcm.h"
 #include "audio.h"
+#include "relay_protocol.h"
+#include "spsc_ring.h"
+#include "voice.h"
+
+#include <boost/asio.hpp>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace net = boost::asio;
+using net::ip::udp;
 
 using namespace std::literals;
 
-int main(int argc, char** argv) {
+namespace {
+
+// Очередь между потоком miniaudio и сетевым потоком: 64 пакета - это 1,28 с звука
+using PacketQueue = SpscRing<VoicePacket, 64>;
+
+// Записывает звук и отправляет его пакетами по 20 мс, пока пользователь не нажмёт Enter.
+// Без compress кадры передаются как есть, около 350 кбит/с, со сжатием - около 32 кбит/с.
+// Если задан channel, пакеты отправляются ретранслятору для этого канала
+void SendVoice(const std::string& address, unsigned short port, bool compress, std::optional<uint16_t> channel) {
+    net::io_context io_context;
+    udp::socket socket(io_context, udp::v4());
+    const udp::endpoint endpoint{net::ip::make_address(address), port};
+
+    PacketQueue queue;
+    Packetizer packetizer;
+    Recorder recorder(ma_format_u8, 1);
+    recorder.Start([&queue, &packetizer](const char* data, size_t frames) {
+        // Если сеть не успевает, пакет теряется: задерживать запись нельзя
+        packetizer.Push(data, frames, [&queue](const VoicePacket& packet) {
+            queue.TryPush(packet);
+        });
+    });
+
+    std::atomic<bool> stop = false;
+    std::thread sender([&] {
+        VoicePacket packet;
+        // Пакеты кодируются здесь, а не в обработчике записи, чтобы не задерживать его
+        AdpcmEncoder encoder;
+        std::array<char, RELAY_HEADER_SIZE + VOICE_DATAGRAM_SIZE> datagram;
+        const size_t header_size = channel ? RELAY_HEADER_SIZE : 0;
+        if (channel) {
+            WriteRelayHeader(RelayMessage::VOICE, *channel, datagram.data());
+        }
+        while (!stop) {
+            if (!queue.TryPop(packet)) {
+                // Пакет появляется раз в 20 мс, поэтому короткая пауза почти не добавляет задержки
+                std::this_thread::sleep_for(1ms);
+                continue;
+            }
+            size_t size = VOICE_DATAGRAM_SIZE;
+            if (compress) {
+                SerializeAdpcmPacket(packet, encoder, datagram.data() + header_size);
+                size = ADPCM_DATAGRAM_SIZE;
+            } else {
+                SerializePacket(packet, datagram.data() + header_size);
+            }
+            boost::system::error_code ignored_error;
+            socket.send_to(net::buffer(datagram, header_size + size), endpoint, 0, ignored_error);
+        }
+    });
+
+    std::cout << "Streaming to "sv << endpoint << ". Press Enter to stop..."sv << std::endl;
+    std::string str;
+    std::getline(std::cin, str);
+
+    recorder.Stop();
+    stop = true;
+    sender.join();
+}
+
+// Принимает на socket пакеты, сжатые и несжатые, и сразу воспроизводит их через буфер,
+// выравнивающий задержки сети. Если задан keep_alive, он вызывается сразу и затем периодически
+void PlayIncomingVoice(net::io_context& io_context, udp::socket& socket, const std::function<void()>& keep_alive) {
+    PacketQueue queue;
+    // 3 пакета (60 мс) покрывают обычный разброс задержек и укладываются в 100 мс вместе с записью
+    JitterBuffer jitter_buffer{3};
+    Player player(ma_format_u8, 1);
+    player.Start([&queue, &jitter_buffer](char* out, size_t frames) {
+        for (VoicePacket packet; queue.TryPop(packet);) {
+            jitter_buffer.Put(packet);
+        }
+        jitter_buffer.Read(out, frames);
+    });
+
+    std::array<char, VOICE_DATAGRAM_SIZE + 1> datagram;
+    VoicePacket packet;
+    udp::endpoint sender;
+    std::function<void()> receive = [&] {
+        socket.async_receive_from(net::buffer(datagram), sender, [&](boost::system::error_code ec, size_t size) {
+            // Ошибки вроде недоступного порта ретранслятора не мешают принимать дальше
+            if (!ec
+                && (ParsePacket(datagram.data(), size, packet) || ParseAdpcmPacket(datagram.data(), size, packet))) {
+                queue.TryPush(packet);
+            }
+            receive();
+        });
+    };
+    receive();
+
+    net::steady_timer timer{io_context};
+    std::function<void()> refresh = [&] {
+        keep_alive();
+        timer.expires_after(RELAY_RESUBSCRIBE_INTERVAL);
+        timer.async_wait([&](boost::system::error_code ec) {
+            if (!ec) {
+                refresh();
+            }
+        });
+    };
+    if (keep_alive) {
+        refresh();
+    }
+
+    io_context.run();
+}
+
+void ReceiveVoice(unsigned short port) {
+    net::io_context io_context;
+    udp::socket socket(io_context, udp::endpoint(udp::v4(), port));
+
+    std::cout << "Listening on UDP port "sv << port << std::endl;
+    PlayIncomingVoice(io_context, socket, {});
+}
+
+// Подписывается на канал ретранслятора и воспроизводит то, что в нём передают
+void ListenToRelay(const std::string& address, unsigned short port, uint16_t channel) {
+    net::io_context io_context;
+    udp::socket socket(io_context, udp::v4());
+    const udp::endpoint relay{net::ip::make_address(address), port};
+
+    std::array<char, RELAY_HEADER_SIZE> subscribe;
+    WriteRelayHeader(RelayMessage::SUBSCRIBE, channel, subscribe.data());
+
+    std::cout << "Listening to channel "sv << channel << " of "sv << relay << std::endl;
+    PlayIncomingVoice(io_context, socket, [&] {
+        boost::system::error_code ignored_error;
+        socket.send_to(net::buffer(subscribe), relay, 0, ignored_error);
+    });
+}
+
+// Исходный режим: записать сообщение целиком, затем воспроизвести
+void RecordAndPlay() {
     Recorder recorder(ma_format_u8, 1);
     Player player(ma_format_u8, 1);
 
@@ -19,6 +164,51 @@ int main(int argc, char** argv) {
         player.PlayBuffer(rec_result.data.data(), rec_result.frames, 1.5s);
         std::cout << "Playing done" << std::endl;
     }
+}
+
+unsigned short ToPort(const char* str) {
+    return static_cast<unsigned short>(std::stoi(str));
+}
+
+// Разбирает необязательные аргументы команды send. Возвращает false, если встретился неизвестный
+bool ParseSendOptions(int argc, char** argv, bool& compress, std::optional<uint16_t>& channel) {
+    for (int i = 4; i < argc; ++i) {
+        if (argv[i] == "--raw"sv) {
+            compress = false;
+        } else if (argv[i] == "--channel"sv && i + 1 < argc) {
+            channel = static_cast<uint16_t>(std::stoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    try {
+        bool compress = true;
+        std::optional<uint16_t> channel;
+        if (argc == 1) {
+            RecordAndPlay();
+        } else if (argc >= 4 && argv[1] == "send"sv && ParseSendOptions(argc, argv, compress, channel)) {
+            SendVoice(argv[2], ToPort(argv[3]), compress, channel);
+        } else if (argc == 3 && argv[1] == "receive"sv) {
+            ReceiveVoice(ToPort(argv[2]));
+        } else if (argc == 5 && argv[1] == "listen"sv) {
+            ListenToRelay(argv[2], ToPort(argv[3]), static_cast<uint16_t>(std::stoi(argv[4])));
+        } else {
+            std::cout << "Usage: "sv << argv[0]
+                      << " [send <receiver IP> <port> [--raw] [--channel <channel>]"sv
+                         " | receive <port> | listen <relay IP> <port> <channel>]"sv
+                      << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,222 @@
+#include "mixer.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MIXER_KERNELS_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MIXER_KERNELS_NEON 1
+#endif
+
+namespace mixer {
+
+namespace {
+
+using AccumulateU8Fn = void (*)(std::int32_t*, const std::uint8_t*, size_t) noexcept;
+using AccumulateS16Fn = void (*)(std::int32_t*, const std::int16_t*, size_t) noexcept;
+using StoreU8Fn = void (*)(const std::int32_t*, std::uint8_t*, size_t) noexcept;
+using StoreS16Fn = void (*)(const std::int32_t*, std::int16_t*, size_t) noexcept;
+
+constexpr std::int32_t S16_MIN = -32768;
+constexpr std::int32_t S16_MAX = 32767;
+
+// Скалярные реализации для хвостов массивов и процессоров без векторных расширений
+void AccumulateU8Scalar(std::int32_t* acc, const std::uint8_t* src, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        acc[i] += (std::int32_t{src[i]} - 128) * 256;
+    }
+}
+
+void AccumulateS16Scalar(std::int32_t* acc, const std::int16_t* src, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        acc[i] += src[i];
+    }
+}
+
+void StoreU8Scalar(const std::int32_t* acc, std::uint8_t* out, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        // Сдвиг округляет вниз, как и арифметический сдвиг векторных реализаций
+        out[i] = static_cast<std::uint8_t>((std::clamp(acc[i], S16_MIN, S16_MAX) >> 8) + 128);
+    }
+}
+
+void StoreS16Scalar(const std::int32_t* acc, std::int16_t* out, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<std::int16_t>(std::clamp(acc[i], S16_MIN, S16_MAX));
+    }
+}
+
+#if defined(MIXER_KERNELS_AVX2)
+
+__attribute__((target("avx2"))) void AccumulateU8Avx2(std::int32_t* acc, const std::uint8_t* src,
+                                                      size_t count) noexcept {
+    const __m256i bias = _mm256_set1_epi32(128);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        const __m256i sample = _mm256_slli_epi32(_mm256_sub_epi32(wide, bias), 8);
+        auto* const sums = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(sums, _mm256_add_epi32(_mm256_loadu_si256(sums), sample));
+    }
+    AccumulateU8Scalar(acc + i, src + i, count - i);
+}
+
+__attribute__((target("avx2"))) void AccumulateS16Avx2(std::int32_t* acc, const std::int16_t* src,
+                                                       size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i sample = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        auto* const sums = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(sums, _mm256_add_epi32(_mm256_loadu_si256(sums), sample));
+    }
+    AccumulateS16Scalar(acc + i, src + i, count - i);
+}
+
+// Упаковывает 16 сумм в 16-битные отсчёты с насыщением. _mm256_packs_epi32 чередует
+// четвёрки отсчётов двух аргументов внутри 128-битных половин, перестановка возвращает порядок
+__attribute__((target("avx2"))) __m256i PackS16(const std::int32_t* acc) noexcept {
+    const __m256i packed = _mm256_packs_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + 8)));
+    return _mm256_permute4x64_epi64(packed, 0b11'01'10'00);
+}
+
+__attribute__((target("avx2"))) void StoreU8Avx2(const std::int32_t* acc, std::uint8_t* out,
+                                                 size_t count) noexcept {
+    const __m256i bias = _mm256_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i samples = _mm256_add_epi16(_mm256_srai_epi16(PackS16(acc + i), 8), bias);
+        // Значения уже в диапазоне 0..255; packus кладёт 8 байтов каждой половины
+        // в младшие 64 бита половин, перестановка собирает их в младшие 128 бит
+        const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(samples, samples), 0b00'00'10'00);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(bytes));
+    }
+    StoreU8Scalar(acc + i, out + i, count - i);
+}
+
+__attribute__((target("avx2"))) void StoreS16Avx2(const std::int32_t* acc, std::int16_t* out,
+                                                  size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), PackS16(acc + i));
+    }
+    StoreS16Scalar(acc + i, out + i, count - i);
+}
+
+#elif defined(MIXER_KERNELS_NEON)
+
+void AccumulateU8Neon(std::int32_t* acc, const std::uint8_t* src, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t centered = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src + i))), vdupq_n_s16(128));
+        // vshll расширяет до 32 бит и сдвигает на 8 за одну инструкцию
+        vst1q_s32(acc + i, vaddq_s32(vld1q_s32(acc + i), vshll_n_s16(vget_low_s16(centered), 8)));
+        vst1q_s32(acc + i + 4, vaddq_s32(vld1q_s32(acc + i + 4), vshll_n_s16(vget_high_s16(centered), 8)));
+    }
+    AccumulateU8Scalar(acc + i, src + i, count - i);
+}
+
+void AccumulateS16Neon(std::int32_t* acc, const std::int16_t* src, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples = vld1q_s16(src + i);
+        vst1q_s32(acc + i, vaddw_s16(vld1q_s32(acc + i), vget_low_s16(samples)));
+        vst1q_s32(acc + i + 4, vaddw_s16(vld1q_s32(acc + i + 4), vget_high_s16(samples)));
+    }
+    AccumulateS16Scalar(acc + i, src + i, count - i);
+}
+
+// 8 сумм в 16-битные отсчёты с насыщением
+int16x8_t PackS16(const std::int32_t* acc) noexcept {
+    return vcombine_s16(vqmovn_s32(vld1q_s32(acc)), vqmovn_s32(vld1q_s32(acc + 4)));
+}
+
+void StoreU8Neon(const std::int32_t* acc, std::uint8_t* out, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples = vaddq_s16(vshrq_n_s16(PackS16(acc + i), 8), vdupq_n_s16(128));
+        vst1_u8(out + i, vqmovun_s16(samples));
+    }
+    StoreU8Scalar(acc + i, out + i, count - i);
+}
+
+void StoreS16Neon(const std::int32_t* acc, std::int16_t* out, size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_s16(out + i, PackS16(acc + i));
+    }
+    StoreS16Scalar(acc + i, out + i, count - i);
+}
+
+#endif
+
+struct Kernels {
+    AccumulateU8Fn accumulate_u8;
+    AccumulateS16Fn accumulate_s16;
+    StoreU8Fn store_u8;
+    StoreS16Fn store_s16;
+    const char* name;
+};
+
+Kernels SelectKernels() noexcept {
+#if defined(MIXER_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return {AccumulateU8Avx2, AccumulateS16Avx2, StoreU8Avx2, StoreS16Avx2, "avx2"};
+    }
+#elif defined(MIXER_KERNELS_NEON)
+    return {AccumulateU8Neon, AccumulateS16Neon, StoreU8Neon, StoreS16Neon, "neon"};
+#endif
+    return {AccumulateU8Scalar, AccumulateS16Scalar, StoreU8Scalar, StoreS16Scalar, "scalar"};
+}
+
+const Kernels& GetKernels() noexcept {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+}  // namespace
+
+void AccumulateU8(std::int32_t* acc, const std::uint8_t* src, size_t count) noexcept {
+    GetKernels().accumulate_u8(acc, src, count);
+}
+
+void AccumulateS16(std::int32_t* acc, const std::int16_t* src, size_t count) noexcept {
+    GetKernels().accumulate_s16(acc, src, count);
+}
+
+void StoreU8(const std::int32_t* acc, std::uint8_t* out, size_t count) noexcept {
+    GetKernels().store_u8(acc, out, count);
+}
+
+void StoreS16(const std::int32_t* acc, std::int16_t* out, size_t count) noexcept {
+    GetKernels().store_s16(acc, out, count);
+}
+
+const char* GetKernelsName() noexcept {
+    return GetKernels().name;
+}
+
+size_t Resampler::Process(std::span<const std::int32_t> in, std::span<std::int32_t> out) noexcept {
+    assert(out.size() >= GetMaxOutput(in.size()));
+    // Отсчёт с номером k - in[k - 1], с номером 0 - previous_. Выходной отсчёт интерполируется
+    // между соседними входными, поэтому позиции от последнего отсчёта in ждут следующего пакета
+    const std::uint64_t end = std::uint64_t{in.size()} << 32;
+    size_t written = 0;
+    for (; position_ < end; position_ += step_) {
+        const auto index = static_cast<size_t>(position_ >> 32);
+        const std::int64_t from = index == 0 ? previous_ : in[index - 1];
+        const std::int64_t to = in[index];
+        // 16 бит дробной части: произведение на разность 32-битных отсчётов не переполняется
+        const auto fraction = static_cast<std::int64_t>(position_ >> 16 & 0xFFFF);
+        out[written++] = static_cast<std::int32_t>(from + ((to - from) * fraction >> 16));
+    }
+    if (!in.empty()) {
+        previous_ = in.back();
+        position_ -= end;
+    }
+    return written;
+}
+
+}  // namespace mixer
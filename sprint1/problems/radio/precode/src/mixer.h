@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace mixer {
+
+/*
+Сведение нескольких звуковых потоков в один. Отсчёты потоков приводятся к 16-битной шкале
+и складываются в 32-битные суммы, поэтому сумма до 65536 полных по громкости потоков
+не переполняется. Ограничение до диапазона выходного формата выполняется один раз,
+при записи результата.
+
+Преобразования форматов и сложение выполняются векторными инструкциями. Реализация
+выбирается при первом вызове по возможностям процессора: AVX2 на x86-64, NEON на AArch64,
+иначе скалярный цикл. Все реализации дают одинаковый результат
+*/
+
+// acc[i] += отсчёт src[i] формата ma_format_u8 в 16-битной шкале: (src[i] - 128) * 256
+void AccumulateU8(std::int32_t* acc, const std::uint8_t* src, size_t count) noexcept;
+
+// acc[i] += src[i], отсчёты формата ma_format_s16
+void AccumulateS16(std::int32_t* acc, const std::int16_t* src, size_t count) noexcept;
+
+// Ограничивает acc[i] 16-битным диапазоном и записывает в формате ma_format_u8.
+// Младшие 8 бит отбрасываются, поэтому поток u8, прошедший AccumulateU8, не меняется
+void StoreU8(const std::int32_t* acc, std::uint8_t* out, size_t count) noexcept;
+
+// Ограничивает acc[i] 16-битным диапазоном и записывает в формате ma_format_s16
+void StoreS16(const std::int32_t* acc, std::int16_t* out, size_t count) noexcept;
+
+// Название выбранной реализации, например для журнала запуска
+const char* GetKernelsName() noexcept;
+
+/*
+Пересчёт потока 32-битных отсчётов с частоты in_rate на out_rate линейной интерполяцией.
+Позиция выходного отсчёта хранится с фиксированной точкой 32.32, а последний входной отсчёт
+запоминается, поэтому поток можно обрабатывать пакетами произвольной длины без щелчков
+на их границах. Используется в одном потоке
+*/
+class Resampler {
+public:
+    Resampler(unsigned in_rate, unsigned out_rate) noexcept
+        : step_{(std::uint64_t{in_rate} << 32) / out_rate} {
+        assert(in_rate > 0 && out_rate > 0);
+    }
+
+    // Наибольшее количество выходных отсчётов для in_count входных
+    size_t GetMaxOutput(size_t in_count) const noexcept {
+        return static_cast<size_t>((std::uint64_t{in_count} << 32) / step_) + 1;
+    }
+
+    // Пересчитывает очередной пакет in и возвращает количество отсчётов, записанных в out.
+    // Размер out должен быть не меньше GetMaxOutput(in.size())
+    size_t Process(std::span<const std::int32_t> in, std::span<std::int32_t> out) noexcept;
+
+private:
+    // Шаг входа на один выходной отсчёт, 32.32
+    std::uint64_t step_;
+    // Позиция следующего выходного отсчёта: 0 - последний отсчёт предыдущего пакета,
+    // 1 - первый отсчёт текущего
+    std::uint64_t position_ = std::uint64_t{1} << 32;
+    std::int32_t previous_ = 0;
+};
+
+/*
+Сводит потоки одинаковой длины в пакет из frames отсчётов. Поток короче пакета
+дополняется тишиной. Используется в одном потоке
+*/
+class Mixer {
+public:
+    explicit Mixer(size_t frames)
+        : sums_(frames) {
+    }
+
+    size_t GetFrames() const noexcept {
+        return sums_.size();
+    }
+
+    // Начинает новый пакет
+    void Clear() noexcept {
+        std::fill(sums_.begin(), sums_.end(), 0);
+    }
+
+    void Add(std::span<const std::uint8_t> samples) noexcept {
+        assert(samples.size() <= sums_.size());
+        AccumulateU8(sums_.data(), samples.data(), samples.size());
+    }
+
+    void Add(std::span<const std::int16_t> samples) noexcept {
+        assert(samples.size() <= sums_.size());
+        AccumulateS16(sums_.data(), samples.data(), samples.size());
+    }
+
+    // Отсчёты в 16-битной шкале, например после Resampler
+    void Add(std::span<const std::int32_t> samples) noexcept {
+        assert(samples.size() <= sums_.size());
+        for (size_t i = 0; i < samples.size(); ++i) {
+            sums_[i] += samples[i];
+        }
+    }
+
+    void Store(std::span<std::uint8_t> out) const noexcept {
+        assert(out.size() == sums_.size());
+        StoreU8(sums_.data(), out.data(), out.size());
+    }
+
+    void Store(std::span<std::int16_t> out) const noexcept {
+        assert(out.size() == sums_.size());
+        StoreS16(sums_.data(), out.data(), out.size());
+    }
+
+private:
+    std::vector<std::int32_t> sums_;
+};
+
+}  // namespace mixer
@@ -0,0 +1,406 @@
+#include "adpcm.h"
+#include "mixer.h"
+#include "relay_protocol.h"
+
+#include <boost/asio.hpp>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using net::ip::udp;
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Период сведения равен длительности пакета
+constexpr auto PACKET_DURATION = std::chrono::milliseconds{20};
+
+using Samples = std::array<char, FRAMES_PER_PACKET>;
+
+inline std::span<const std::uint8_t> AsU8(const Samples& samples) noexcept {
+    return {reinterpret_cast<const std::uint8_t*>(samples.data()), samples.size()};
+}
+
+inline std::span<std::uint8_t> AsU8(Samples& samples) noexcept {
+    return {reinterpret_cast<std::uint8_t*>(samples.data()), samples.size()};
+}
+
+// Адрес IPv4 и порт в одном числе: ключ для поиска подписчика
+inline uint64_t AddressKey(const sockaddr_in& address) noexcept {
+    return uint64_t{address.sin_addr.s_addr} << 16 | address.sin_port;
+}
+
+/*
+Подписчики канала хранятся в непрерывных массивах: при рассылке адреса перебираются подряд
+и передаются в sendmmsg без копирования. Удаление переносит последний элемент на место удалённого.
+В режиме сведения канал работает как конференция: голос каждого участника копится в его очереди,
+и раз в период пакеты всех участников сводятся в один
+*/
+class Channel {
+public:
+    // Пакеты участника, ещё не попавшие в сведение. Очередь сглаживает неравномерную доставку,
+    // а при переполнении теряет старые пакеты, чтобы задержка не росла
+    static constexpr size_t MAX_QUEUED_PACKETS = 4;
+    // Участник, от которого так долго нет пакетов, перестаёт учитываться
+    static constexpr auto TALKER_TIMEOUT = std::chrono::seconds{1};
+
+    void Subscribe(const sockaddr_in& address, Clock::time_point expires) {
+        const auto [it, inserted] = index_.try_emplace(AddressKey(address), addresses_.size());
+        if (inserted) {
+            addresses_.push_back(address);
+            expires_.push_back(expires);
+        } else {
+            expires_[it->second] = expires;
+        }
+    }
+
+    void Unsubscribe(const sockaddr_in& address) {
+        if (const auto it = index_.find(AddressKey(address)); it != index_.end()) {
+            Remove(it->second);
+        }
+    }
+
+    void RemoveExpired(Clock::time_point now) {
+        for (size_t i = 0; i < addresses_.size();) {
+            if (expires_[i] <= now) {
+                Remove(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    const std::vector<sockaddr_in>& GetAddresses() const noexcept {
+        return addresses_;
+    }
+
+    bool IsEmpty() const noexcept {
+        return addresses_.empty();
+    }
+
+    void AddVoice(const sockaddr_in& sender, const VoicePacket& packet, bool compressed, Clock::time_point now) {
+        auto& talker = talkers_[AddressKey(sender)];
+        if (talker.packets.size() == MAX_QUEUED_PACKETS) {
+            talker.packets.pop_front();
+        }
+        talker.packets.push_back(packet.samples);
+        talker.last_heard = now;
+        compressed_ = compressed;
+    }
+
+    // Сводит по одному пакету каждого участника и записывает готовую датаграмму в out.
+    // Сведение сжимается, если сжат последний принятый пакет канала.
+    // Возвращает размер датаграммы или 0, если сводить нечего
+    size_t MixVoices(mixer::Mixer& mixer, char* out) {
+        mixer.Clear();
+        bool mixed = false;
+        for (auto& [key, talker] : talkers_) {
+            if (!talker.packets.empty()) {
+                mixer.Add(AsU8(talker.packets.front()));
+                talker.packets.pop_front();
+                mixed = true;
+            }
+        }
+        if (!mixed) {
+            return 0;
+        }
+        mix_.sequence = mix_sequence_++;
+        mixer.Store(AsU8(mix_.samples));
+        if (compressed_) {
+            SerializeAdpcmPacket(mix_, encoder_, out);
+            return ADPCM_DATAGRAM_SIZE;
+        }
+        SerializePacket(mix_, out);
+        return VOICE_DATAGRAM_SIZE;
+    }
+
+    void RemoveSilentTalkers(Clock::time_point now) {
+        std::erase_if(talkers_, [now](const auto& item) {
+            return item.second.packets.empty() && item.second.last_heard + TALKER_TIMEOUT <= now;
+        });
+    }
+
+private:
+    struct Talker {
+        std::deque<Samples> packets;
+        Clock::time_point last_heard;
+    };
+
+    void Remove(size_t pos) {
+        index_.erase(AddressKey(addresses_[pos]));
+        if (pos + 1 != addresses_.size()) {
+            addresses_[pos] = addresses_.back();
+            expires_[pos] = expires_.back();
+            index_[AddressKey(addresses_[pos])] = pos;
+        }
+        addresses_.pop_back();
+        expires_.pop_back();
+    }
+
+    std::vector<sockaddr_in> addresses_;
+    std::vector<Clock::time_point> expires_;
+    std::unordered_map<uint64_t, size_t> index_;
+
+    std::unordered_map<uint64_t, Talker> talkers_;
+    VoicePacket mix_;
+    uint32_t mix_sequence_ = 0;
+    bool compressed_ = false;
+    AdpcmEncoder encoder_;
+};
+
+/*
+Ретранслятор голоса. Датаграммы принимаются пачками через recvmmsg, голосовые пересылаются
+всем подписчикам канала пачками через sendmmsg. Все сообщения пачки ссылаются на данные
+в буфере приёма, так что данные не копируются, сколько бы ни было подписчиков.
+Работает в одном потоке: задержка не зависит от блокировок.
+В режиме сведения голосовые датаграммы декодируются и раз в PACKET_DURATION сводятся
+по каналам (см. Channel). Подписчики получают одно сведение на канал, в том числе голос
+говорящих, если они подписаны на свой канал
+*/
+class Relay {
+public:
+    static constexpr size_t RECV_BATCH_SIZE = 64;
+    static constexpr size_t SEND_BATCH_SIZE = 1024;
+    static constexpr size_t MAX_DATAGRAM_SIZE = 2048;
+    // Пачка рассылки тысячам подписчиков должна поместиться в буфер отправки целиком
+    static constexpr int SEND_BUFFER_SIZE = 8 * 1024 * 1024;
+
+    Relay(net::io_context& io, unsigned short port, bool mix)
+        : socket_{io, udp::endpoint(udp::v4(), port)}
+        , timer_{io}
+        , mix_timer_{io}
+        , mix_{mix} {
+        socket_.non_blocking(true);
+        socket_.set_option(net::socket_base::send_buffer_size(SEND_BUFFER_SIZE));
+        for (size_t i = 0; i < RECV_BATCH_SIZE; ++i) {
+            recv_iov_[i] = {buffers_[i].data(), buffers_[i].size()};
+            recv_msgs_[i].msg_hdr.msg_iov = &recv_iov_[i];
+            recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs_[i].msg_hdr.msg_name = &addresses_[i];
+        }
+        // Все сообщения одной рассылки содержат одни и те же данные
+        for (auto& msg : send_msgs_) {
+            msg.msg_hdr.msg_iov = &send_iov_;
+            msg.msg_hdr.msg_iovlen = 1;
+            msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+    }
+
+    void Start() {
+        WaitForDatagrams();
+        Tick();
+        if (mix_) {
+            mix_timer_.expires_at(Clock::now());
+            MixTick();
+        }
+    }
+
+private:
+    void WaitForDatagrams() {
+        socket_.async_wait(udp::socket::wait_read, [this](sys::error_code ec) {
+            if (ec) {
+                std::cerr << "Wait error: "sv << ec.message() << std::endl;
+                return;
+            }
+            ReceiveBatch();
+            WaitForDatagrams();
+        });
+    }
+
+    void ReceiveBatch() {
+        for (auto& msg : recv_msgs_) {
+            msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+        const int received = recvmmsg(socket_.native_handle(), recv_msgs_.data(), RECV_BATCH_SIZE,
+                                      MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "recvmmsg error: "sv << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        const auto now = Clock::now();
+        for (size_t i = 0; i < static_cast<size_t>(received); ++i) {
+            HandleDatagram(buffers_[i].data(), recv_msgs_[i].msg_len, addresses_[i], now);
+        }
+    }
+
+    void HandleDatagram(const char* data, size_t size, const sockaddr_in& sender, Clock::time_point now) {
+        RelayMessage type;
+        uint16_t channel_id;
+        if (!ReadRelayHeader(data, size, type, channel_id)) {
+            return;
+        }
+        ++received_;
+        switch (type) {
+            case RelayMessage::VOICE:
+                if (const auto it = channels_.find(channel_id); it != channels_.end()) {
+                    if (mix_) {
+                        AddVoice(it->second, data + RELAY_HEADER_SIZE, size - RELAY_HEADER_SIZE, sender, now);
+                    } else {
+                        FanOut(it->second, data + RELAY_HEADER_SIZE, size - RELAY_HEADER_SIZE);
+                    }
+                }
+                break;
+            case RelayMessage::SUBSCRIBE:
+                channels_[channel_id].Subscribe(sender, now + RELAY_SUBSCRIPTION_TIMEOUT);
+                break;
+            case RelayMessage::UNSUBSCRIBE:
+                if (const auto it = channels_.find(channel_id); it != channels_.end()) {
+                    it->second.Unsubscribe(sender);
+                }
+                break;
+        }
+    }
+
+    void AddVoice(Channel& channel, const char* payload, size_t size, const sockaddr_in& sender,
+                  Clock::time_point now) {
+        VoicePacket packet;
+        if (ParsePacket(payload, size, packet)) {
+            channel.AddVoice(sender, packet, false, now);
+        } else if (ParseAdpcmPacket(payload, size, packet)) {
+            channel.AddVoice(sender, packet, true, now);
+        }
+    }
+
+    // Сводит голос каналов. Срок следующего срабатывания отсчитывается от предыдущего срока,
+    // а не от момента обработки, поэтому период не накапливает задержку
+    void MixTick() {
+        mix_timer_.expires_at(mix_timer_.expiry() + PACKET_DURATION);
+        mix_timer_.async_wait([this](sys::error_code ec) {
+            if (ec) {
+                return;
+            }
+            for (auto& [id, channel] : channels_) {
+                if (const size_t size = channel.MixVoices(mixer_, mix_datagram_.data()); size != 0) {
+                    FanOut(channel, mix_datagram_.data(), size);
+                    ++mixed_;
+                }
+            }
+            MixTick();
+        });
+    }
+
+    void FanOut(const Channel& channel, const char* payload, size_t size) {
+        send_iov_ = {const_cast<char*>(payload), size};
+        const auto& addresses = channel.GetAddresses();
+        for (size_t begin = 0; begin < addresses.size(); begin += SEND_BATCH_SIZE) {
+            const size_t count = std::min(SEND_BATCH_SIZE, addresses.size() - begin);
+            for (size_t i = 0; i < count; ++i) {
+                send_msgs_[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&addresses[begin + i]);
+            }
+            size_t sent = 0;
+            while (sent < count) {
+                const int result = sendmmsg(socket_.native_handle(), send_msgs_.data() + sent,
+                                            static_cast<unsigned>(count - sent), MSG_DONTWAIT);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // Буфер отправки переполнен: пакет для оставшихся подписчиков теряется,
+                    // а не задерживает следующие
+                    break;
+                }
+                sent += static_cast<size_t>(result);
+            }
+            sent_ += sent;
+            dropped_ += count - sent;
+        }
+    }
+
+    // Раз в секунду удаляет истёкшие подписки и выводит статистику
+    void Tick() {
+        timer_.expires_after(1s);
+        timer_.async_wait([this](sys::error_code ec) {
+            if (ec) {
+                return;
+            }
+            size_t subscribers = 0;
+            const auto now = Clock::now();
+            for (auto it = channels_.begin(); it != channels_.end();) {
+                it->second.RemoveExpired(now);
+                it->second.RemoveSilentTalkers(now);
+                subscribers += it->second.GetAddresses().size();
+                it = it->second.IsEmpty() ? channels_.erase(it) : std::next(it);
+            }
+            if (received_ != 0) {
+                std::cout << "Channels: "sv << channels_.size() << ", subscribers: "sv << subscribers
+                          << ", received: "sv << received_ << "/s, sent: "sv << sent_ << "/s, dropped: "sv
+                          << dropped_ << "/s"sv;
+                if (mix_) {
+                    std::cout << ", mixed: "sv << mixed_ << "/s"sv;
+                }
+                std::cout << std::endl;
+            }
+            received_ = sent_ = dropped_ = mixed_ = 0;
+            Tick();
+        });
+    }
+
+    udp::socket socket_;
+    net::steady_timer timer_;
+    net::steady_timer mix_timer_;
+    std::unordered_map<uint16_t, Channel> channels_;
+
+    bool mix_;
+    mixer::Mixer mixer_{FRAMES_PER_PACKET};
+    std::array<char, VOICE_DATAGRAM_SIZE> mix_datagram_{};
+
+    std::array<std::array<char, MAX_DATAGRAM_SIZE>, RECV_BATCH_SIZE> buffers_;
+    std::array<sockaddr_in, RECV_BATCH_SIZE> addresses_{};
+    std::array<iovec, RECV_BATCH_SIZE> recv_iov_{};
+    std::array<mmsghdr, RECV_BATCH_SIZE> recv_msgs_{};
+    iovec send_iov_{};
+    std::array<mmsghdr, SEND_BATCH_SIZE> send_msgs_{};
+
+    size_t received_ = 0;
+    size_t sent_ = 0;
+    size_t dropped_ = 0;
+    size_t mixed_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const bool mix = argc == 3 && argv[2] == "--mix"sv;
+    if (argc != 2 && !mix) {
+        std::cout << "Usage: "sv << argv[0] << " <port> [--mix]"sv << std::endl;
+        return 1;
+    }
+
+    try {
+        net::io_context io_context{1};
+
+        Relay relay{io_context, static_cast<unsigned short>(std::stoi(argv[1])), mix};
+        relay.Start();
+        std::cout << "Relaying voice on UDP port "sv << argv[1];
+        if (mix) {
+            std::cout << ", mixing channels with "sv << mixer::GetKernelsName() << " kernels"sv;
+        }
+        std::cout << std::endl;
+
+        io_context.run();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
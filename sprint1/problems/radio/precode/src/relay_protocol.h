@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Датаграмма для ретранслятора: тип (1 байт), номер канала (2 байта, big endian), затем данные.
+Данные голосовой датаграммы ретранслятор пересылает подписчикам канала без изменений,
+поэтому слушатель принимает их так же, как датаграммы от отправителя напрямую
+*/
+enum class RelayMessage : uint8_t {
+    VOICE = 1,
+    SUBSCRIBE = 2,
+    UNSUBSCRIBE = 3,
+};
+
+constexpr size_t RELAY_HEADER_SIZE = 3;
+
+// UDP не сообщает об ушедших клиентах, поэтому подписка истекает, если её не продлевать
+constexpr auto RELAY_SUBSCRIPTION_TIMEOUT = std::chrono::seconds{15};
+constexpr auto RELAY_RESUBSCRIBE_INTERVAL = std::chrono::seconds{5};
+
+inline void WriteRelayHeader(RelayMessage type, uint16_t channel, char* out) {
+    out[0] = static_cast<char>(type);
+    out[1] = static_cast<char>(channel >> 8);
+    out[2] = static_cast<char>(channel);
+}
+
+inline bool ReadRelayHeader(const char* data, size_t size, RelayMessage& type, uint16_t& channel) {
+    if (size < RELAY_HEADER_SIZE) {
+        return false;
+    }
+    const auto raw_type = static_cast<uint8_t>(data[0]);
+    if (raw_type < static_cast<uint8_t>(RelayMessage::VOICE)
+        || raw_type > static_cast<uint8_t>(RelayMessage::UNSUBSCRIBE)) {
+        return false;
+    }
+    type = static_cast<RelayMessage>(raw_type);
+    channel = static_cast<uint16_t>(static_cast<uint8_t>(data[1]) << 8 | static_cast<uint8_t>(data[2]));
+    return true;
+}
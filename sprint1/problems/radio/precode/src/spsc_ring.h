@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+Кольцевой буфер фиксированного размера для одного писателя и одного читателя без блокировок.
+Нужен, чтобы передавать данные из обработчика miniaudio, который нельзя задерживать мьютексом
+или выделением памяти, в сетевой поток и обратно.
+Если буфер полон, TryPush возвращает false и значение не сохраняется
+*/
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Вызывается только писателем
+    bool TryPush(const T& value) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots_[head & (Capacity - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Вызывается только читателем
+    bool TryPop(T& value) noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Счётчики на разных кеш-линиях, чтобы писатель и читатель не мешали друг другу
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::array<T, Capacity> slots_{};
+};
+
+/*
+Байтовый кольцевой буфер для одного писателя и одного читателя без блокировок и ожидания.
+Память выделяется один раз в конструкторе, Write и Read только копируют и могут вызываться
+из обработчика miniaudio. Записывается и читается столько, сколько помещается либо есть в буфере
+*/
+class SpscByteRing {
+public:
+    explicit SpscByteRing(size_t capacity)
+        : buffer_(capacity) {
+    }
+
+    size_t Capacity() const noexcept {
+        return buffer_.size();
+    }
+
+    // Сколько байтов можно прочитать. Для читателя значение может только вырасти
+    size_t Size() const noexcept {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    // Сколько байтов можно записать. Для писателя значение может только вырасти
+    size_t Free() const noexcept {
+        return Capacity() - Size();
+    }
+
+    // Вызывается только писателем. Возвращает количество записанных байтов
+    size_t Write(const char* data, size_t size) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        size = std::min(size, Capacity() - (head - tail));
+        const size_t pos = head % Capacity();
+        const size_t first = std::min(size, Capacity() - pos);
+        std::copy_n(data, first, buffer_.data() + pos);
+        std::copy_n(data + first, size - first, buffer_.data());
+        head_.store(head + size, std::memory_order_release);
+        return size;
+    }
+
+    // Вызывается только читателем. Возвращает количество прочитанных байтов
+    size_t Read(char* out, size_t size) noexcept {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        size = std::min(size, head - tail);
+        const size_t pos = tail % Capacity();
+        const size_t first = std::min(size, Capacity() - pos);
+        std::copy_n(buffer_.data() + pos, first, out);
+        std::copy_n(buffer_.data(), size - first, out + first);
+        tail_.store(tail + size, std::memory_order_release);
+        return size;
+    }
+
+    // Отбрасывает всё, что записано. Вызывается только читателем
+    void Clear() noexcept {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<char> buffer_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
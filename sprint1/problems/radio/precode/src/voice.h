@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Звук передаётся в формате ma_format_u8, моно: один байт на кадр, тишина - 128
+constexpr int SAMPLE_RATE = 44100;
+constexpr char SILENCE = static_cast<char>(128);
+
+// Пакет содержит 20 мс звука: короче - больше накладных расходов, длиннее - больше задержка
+constexpr size_t FRAMES_PER_PACKET = SAMPLE_RATE / 50;
+
+struct VoicePacket {
+    uint32_t sequence = 0;
+    std::array<char, FRAMES_PER_PACKET> samples{};
+};
+
+// Датаграмма: номер пакета (4 байта, big endian), затем кадры
+constexpr size_t VOICE_SEQUENCE_SIZE = 4;
+constexpr size_t VOICE_DATAGRAM_SIZE = VOICE_SEQUENCE_SIZE + FRAMES_PER_PACKET;
+
+inline void WriteSequence(uint32_t sequence, char* out) {
+    for (size_t i = 0; i < VOICE_SEQUENCE_SIZE; ++i) {
+        out[i] = static_cast<char>(sequence >> (24 - 8 * i));
+    }
+}
+
+inline uint32_t ReadSequence(const char* data) {
+    uint32_t sequence = 0;
+    for (size_t i = 0; i < VOICE_SEQUENCE_SIZE; ++i) {
+        sequence = sequence << 8 | static_cast<uint8_t>(data[i]);
+    }
+    return sequence;
+}
+
+inline void SerializePacket(const VoicePacket& packet, char* out) {
+    WriteSequence(packet.sequence, out);
+    std::copy(packet.samples.begin(), packet.samples.end(), out + VOICE_SEQUENCE_SIZE);
+}
+
+inline bool ParsePacket(const char* data, size_t size, VoicePacket& packet) {
+    if (size != VOICE_DATAGRAM_SIZE) {
+        return false;
+    }
+    packet.sequence = ReadSequence(data);
+    std::copy_n(data + VOICE_SEQUENCE_SIZE, FRAMES_PER_PACKET, packet.samples.begin());
+    return true;
+}
+
+/*
+Собирает кадры, которые miniaudio отдаёт порциями произвольного размера, в пакеты по 20 мс
+и нумерует их. Вызывается из обработчика записи
+*/
+class Packetizer {
+public:
+    template <typename Sink>
+    void Push(const char* data, size_t frames, Sink&& sink) {
+        while (frames > 0) {
+            const size_t n = std::min(frames, FRAMES_PER_PACKET - filled_);
+            std::copy_n(data, n, packet_.samples.begin() + filled_);
+            data += n;
+            frames -= n;
+            filled_ += n;
+            if (filled_ == FRAMES_PER_PACKET) {
+                sink(packet_);
+                ++packet_.sequence;
+                filled_ = 0;
+            }
+        }
+    }
+
+private:
+    VoicePacket packet_;
+    size_t filled_ = 0;
+};
+
+/*
+Буфер на стороне приёмника, сглаживающий неравномерную доставку пакетов.
+Воспроизведение начинается, когда накоплено target_delay пакетов, и идёт строго по номерам:
+переставленные сетью пакеты встают на своё место, опоздавшие и повторные отбрасываются,
+вместо потерянных звучит тишина. Если пакеты кончились, буфер снова копит target_delay пакетов.
+Используется только из обработчика воспроизведения
+*/
+class JitterBuffer {
+public:
+    // Окно в 16 пакетов (320 мс): пакеты, забежавшие дальше, означают, что отправитель начал заново
+    static constexpr uint32_t SLOTS = 16;
+
+    explicit JitterBuffer(uint32_t target_delay = 3)
+        : target_delay_{std::clamp<uint32_t>(target_delay, 1, SLOTS)} {
+    }
+
+    void Put(const VoicePacket& packet) {
+        if (playing_) {
+            const auto ahead = static_cast<int32_t>(packet.sequence - next_sequence_);
+            if (ahead < 0) {
+                return;
+            }
+            if (ahead >= static_cast<int32_t>(SLOTS)) {
+                Reset();
+            }
+        } else if (stored_ > 0 && !InWindow(packet.sequence)) {
+            Reset();
+        }
+
+        Slot& slot = slots_[packet.sequence % SLOTS];
+        if (slot.filled && slot.packet.sequence == packet.sequence) {
+            return;
+        }
+        if (!slot.filled) {
+            ++stored_;
+        }
+        slot = {packet, true};
+
+        if (!playing_) {
+            if (stored_ == 1 || static_cast<int32_t>(packet.sequence - first_sequence_) < 0) {
+                first_sequence_ = packet.sequence;
+            }
+            if (stored_ >= target_delay_) {
+                playing_ = true;
+                next_sequence_ = first_sequence_;
+            }
+        }
+    }
+
+    // Заполняет out кадрами для воспроизведения
+    void Read(char* out, size_t frames) {
+        while (frames > 0) {
+            if (offset_ == FRAMES_PER_PACKET) {
+                NextPacket();
+            }
+            const size_t n = std::min(frames, FRAMES_PER_PACKET - offset_);
+            std::copy_n(current_.begin() + offset_, n, out);
+            out += n;
+            frames -= n;
+            offset_ += n;
+        }
+    }
+
+private:
+    struct Slot {
+        VoicePacket packet;
+        bool filled = false;
+    };
+
+    bool InWindow(uint32_t sequence) const {
+        const auto distance = static_cast<int32_t>(sequence - first_sequence_);
+        return distance > -static_cast<int32_t>(SLOTS) && distance < static_cast<int32_t>(SLOTS);
+    }
+
+    void NextPacket() {
+        offset_ = 0;
+        if (!playing_ || stored_ == 0) {
+            playing_ = false;
+            current_.fill(SILENCE);
+            return;
+        }
+        Slot& slot = slots_[next_sequence_ % SLOTS];
+        if (slot.filled && slot.packet.sequence == next_sequence_) {
+            current_ = slot.packet.samples;
+            slot.filled = false;
+            --stored_;
+        } else {
+            current_.fill(SILENCE);
+        }
+        ++next_sequence_;
+    }
+
+    void Reset() {
+        for (auto& slot : slots_) {
+            slot.filled = false;
+        }
+        stored_ = 0;
+        playing_ = false;
+    }
+
+    const uint32_t target_delay_;
+    std::array<Slot, SLOTS> slots_{};
+    uint32_t stored_ = 0;
+    bool playing_ = false;
+    uint32_t first_sequence_ = 0;
+    uint32_t next_sequence_ = 0;
+    std::array<char, FRAMES_PER_PACKET> current_{};
+    size_t offset_ = FRAMES_PER_PACKET;
+};
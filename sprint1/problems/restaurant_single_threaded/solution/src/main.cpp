@@ -3,13 +3,23 @@
 #endif
 
 #include <boost/asio.hpp>
+#include <cassert>
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <deque>
 #include <iostream>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <sstream>
+#include <string_view>
 #include <syncstream>
+#include <thread>
 #include <unordered_map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace net = boost::asio;
 namespace sys = boost::system;
@@ -86,63 +96,419 @@ private:
     steady_clock::time_point start_time_{steady_clock::now()};
 }; */
 
+/*
+Общий для всех Logger журнал.
+Каждый поток дописывает сообщения в свой буфер без блокировок. Буфер выводится в поток одной
+операцией записи под мьютексом, когда он заполнится, при вызове Flush из этого потока и при
+завершении потока. Потоки, писавшие в журнал, должны завершиться до его разрушения
+*/
+class LogSink {
+public:
+    explicit LogSink(std::ostream& output, size_t capacity = DEFAULT_CAPACITY)
+        : output_{output}
+        , capacity_{capacity} {
+    }
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    ~LogSink() {
+        Flush();
+        GetThreadBuffer().sink = nullptr;
+    }
+
+    // Дописывает строку вида "<id>> [<seconds>s] <message>"
+    void Write(std::string_view id, double seconds, std::string_view message) {
+        auto& buffer = GetThreadBuffer();
+        // Место под число секунд в формате %g
+        constexpr size_t max_seconds_size = 32;
+        const size_t size = id.size() + message.size() + max_seconds_size + "> [s] \n"sv.size();
+        if (buffer.data.size() + size > buffer.data.capacity()) {
+            WriteOut(buffer.data);
+        }
+        Append(buffer.data, id);
+        Append(buffer.data, "> ["sv);
+        char seconds_buf[max_seconds_size];
+        const auto [end, ec] = std::to_chars(std::begin(seconds_buf), std::end(seconds_buf),
+                                             seconds, std::chars_format::general, 6);
+        assert(ec == std::errc{});
+        Append(buffer.data, {seconds_buf, static_cast<size_t>(end - seconds_buf)});
+        Append(buffer.data, "s] "sv);
+        Append(buffer.data, message);
+        buffer.data.push_back('\n');
+    }
+
+    // Выводит сообщения, накопленные вызывающим потоком
+    void Flush() {
+        WriteOut(GetThreadBuffer().data);
+    }
+
+    constexpr static size_t DEFAULT_CAPACITY = 64 * 1024;
+
+private:
+    struct ThreadBuffer {
+        LogSink* sink = nullptr;
+        std::vector<char> data;
+
+        ~ThreadBuffer() {
+            if (sink) {
+                sink->WriteOut(data);
+            }
+        }
+    };
+
+    // Буфер потока привязан к последнему журналу, в который писал поток
+    ThreadBuffer& GetThreadBuffer() {
+        thread_local ThreadBuffer buffer;
+        if (buffer.sink != this) {
+            if (buffer.sink) {
+                buffer.sink->WriteOut(buffer.data);
+            }
+            buffer.sink = this;
+            buffer.data.reserve(capacity_);
+        }
+        return buffer;
+    }
+
+    static void Append(std::vector<char>& data, std::string_view text) {
+        data.insert(data.end(), text.begin(), text.end());
+    }
+
+    void WriteOut(std::vector<char>& data) {
+        if (data.empty()) {
+            return;
+        }
+        std::lock_guard lock{output_mutex_};
+        output_.write(data.data(), static_cast<std::streamsize>(data.size()));
+        output_.flush();
+        data.clear();
+    }
+
+    std::ostream& output_;
+    size_t capacity_;
+    std::mutex output_mutex_;
+};
+
 class Logger {
 public:
-    explicit Logger(std::string id)
-        : id_(std::move(id)) {
+    Logger(LogSink& sink, std::string id)
+        : sink_{&sink}
+        , id_(std::move(id)) {
     }
 
     void LogMessage(std::string_view message) const {
-        static std::mutex cout_mutex;               // один мьютекс для всех Logger
-        std::lock_guard lock(cout_mutex);
-        std::cout << id_ << "> ["sv
-                  << duration<double>(steady_clock::now() - start_time_).count()
-                  << "s] "sv << message << std::endl;
+        sink_->Write(id_, duration<double>(steady_clock::now() - start_time_).count(), message);
     }
 
 private:
+    LogSink* sink_;
+    // Короткие id хранятся в самой строке без выделения памяти
     std::string id_;
     steady_clock::time_point start_time_{steady_clock::now()};
 };
 
+/*
+Пул блоков памяти одного размера для объектов, создаваемых через std::allocate_shared.
+Освобождённые блоки используются повторно, поэтому после разогрева создание заказов
+не обращается к куче. Методы пула можно вызывать из разных потоков
+*/
+class BlockPool {
+public:
+    BlockPool() = default;
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    ~BlockPool() {
+        for (void* block : free_blocks_) {
+            ::operator delete(block, std::align_val_t{alignof(std::max_align_t)});
+        }
+    }
+
+    void* Allocate(size_t size) {
+        {
+            std::lock_guard lock{mutex_};
+            assert(block_size_ == 0 || block_size_ == size);
+            block_size_ = size;
+            if (!free_blocks_.empty()) {
+                void* block = free_blocks_.back();
+                free_blocks_.pop_back();
+                return block;
+            }
+            // Резервируем место в списке свободных блоков, чтобы Deallocate не выделял память
+            free_blocks_.reserve(++allocated_);
+        }
+        return ::operator new(size, std::align_val_t{alignof(std::max_align_t)});
+    }
+
+    void Deallocate(void* block) noexcept {
+        std::lock_guard lock{mutex_};
+        free_blocks_.push_back(block);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<void*> free_blocks_;
+    size_t block_size_ = 0;
+    size_t allocated_ = 0;
+};
+
+// Аллокатор одиночных объектов из BlockPool. Копии аллокатора продлевают жизнь пула
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BlockPool> pool) noexcept
+        : pool_{std::move(pool)} {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : pool_{other.pool_} {
+    }
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        if (n != 1) {
+            throw std::bad_array_new_length{};
+        }
+        return static_cast<T*>(pool_->Allocate(sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        pool_->Deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<BlockPool> pool_;
+};
+
+// Продолжительность этапов приготовления гамбургера
+struct CookingTimes {
+    steady_clock::duration roast = 1s;
+    steady_clock::duration marinade = 2s;
+    // Упаковка занимает процессор
+    steady_clock::duration pack = 500ms;
+};
+
 // Функция, которая будет вызвана по окончании обработки заказа
 using OrderHandler = std::function<void(sys::error_code ec, int id, Hamburger* hamburger)>;
 
+/*
+Участок кухни: гриль, маринование лука или упаковка.
+На участке одновременно выполняется не более slots работ, остальные ждут в очереди.
+Места и очередь учитываются в strand участка, а сами работы выполняются в потоках io_context,
+поэтому долгая работа не задерживает учёт мест.
+TryEnter отказывает, если очередь участка заполнена, — так перегрузка кухни доходит до
+вызывающего. Методы класса можно вызывать из разных потоков
+*/
+class Station {
+public:
+    // Занятое на участке место. Освобождается при разрушении
+    class Slot {
+    public:
+        Slot() = default;
+
+        explicit Slot(Station& station) noexcept
+            : station_{&station} {
+        }
+
+        Slot(Slot&& other) noexcept
+            : station_{std::exchange(other.station_, nullptr)} {
+        }
+
+        Slot& operator=(Slot&& rhs) noexcept {
+            if (this != &rhs) {
+                Release();
+                station_ = std::exchange(rhs.station_, nullptr);
+            }
+            return *this;
+        }
+
+        ~Slot() {
+            Release();
+        }
+
+        void Release() noexcept {
+            if (station_) {
+                std::exchange(station_, nullptr)->Leave();
+            }
+        }
+
+    private:
+        Station* station_ = nullptr;
+    };
+
+    // Работа получает занятое для неё место
+    using Job = std::function<void(Slot slot)>;
+
+    Station(net::io_context& io, int slots, size_t max_queue)
+        : io_{io}
+        , slots_{static_cast<size_t>(slots)}
+        , max_queue_{max_queue} {
+    }
+
+    Station(const Station&) = delete;
+    Station& operator=(const Station&) = delete;
+
+    // Ставит работу в очередь, если в очереди есть место
+    [[nodiscard]] bool TryEnter(Job job) {
+        if (load_.fetch_add(1, std::memory_order_relaxed) >= slots_ + max_queue_) {
+            load_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        Admit(std::move(job));
+        return true;
+    }
+
+    // Ставит работу в очередь без ограничения. Используется, когда количество работ уже
+    // ограничено местами на предыдущем участке
+    void Enter(Job job) {
+        load_.fetch_add(1, std::memory_order_relaxed);
+        Admit(std::move(job));
+    }
+
+private:
+    void Admit(Job job) {
+        net::dispatch(strand_, [this, job = std::move(job)]() mutable {
+            if (busy_ < slots_) {
+                ++busy_;
+                Run(std::move(job));
+            } else {
+                waiting_.push_back(std::move(job));
+            }
+        });
+    }
+
+    // Выполняет работу вне strand. Вызывается в strand_
+    void Run(Job job) {
+        net::post(io_, [this, job = std::move(job)] {
+            job(Slot{*this});
+        });
+    }
+
+    // Место переходит к первой ожидающей работе
+    void Leave() {
+        net::dispatch(strand_, [this] {
+            load_.fetch_sub(1, std::memory_order_relaxed);
+            if (waiting_.empty()) {
+                --busy_;
+            } else {
+                Job job = std::move(waiting_.front());
+                waiting_.pop_front();
+                Run(std::move(job));
+            }
+        });
+    }
+
+    net::io_context& io_;
+    net::strand<net::io_context::executor_type> strand_{net::make_strand(io_)};
+    size_t slots_;
+    size_t max_queue_;
+    // Занятые места и ожидающие работы
+    std::atomic<size_t> load_{0};
+    // Поля ниже изменяются только в strand_
+    size_t busy_ = 0;
+    std::deque<Job> waiting_;
+};
+
+// Вместимость участков кухни
+struct KitchenCapacity {
+    int grill_slots = 8;
+    // Столько заказов может ждать места у гриля. Остальные заказы отклоняются
+    size_t grill_queue = 1024;
+    int onion_slots = 4;
+    int packing_slots = 2;
+};
+
+// Участки, через которые заказ проходит как по конвейеру: гриль (и параллельно лук), затем
+// упаковка. Очереди лука и упаковки ограничены местами у гриля, так как котлета занимает
+// место у гриля, пока заказ не возьмут на упаковку
+struct Kitchen {
+    Kitchen(net::io_context& io, const KitchenCapacity& capacity)
+        : grill{io, capacity.grill_slots, capacity.grill_queue}
+        , onion{io, capacity.onion_slots, 0}
+        , packing{io, capacity.packing_slots, 0} {
+    }
+
+    Station grill;
+    Station onion;
+    Station packing;
+};
+
 class Order : public std::enable_shared_from_this<Order> {
 public:
-    Order(net::io_context& io, int id, bool with_onion, OrderHandler handler)
+    Order(net::io_context& io, Kitchen& kitchen, LogSink& log_sink, const CookingTimes& times,
+          int id, bool with_onion, OrderHandler handler)
         : io_{io}
+        , kitchen_{kitchen}
+        , times_{times}
         , id_{id}
         , with_onion_{with_onion}
-        , handler_{std::move(handler)} {
+        , handler_{std::move(handler)}
+        , logger_{log_sink, std::to_string(id_)}
+        , pending_stages_{with_onion ? 2 : 1} {
     }
 
     // Запускает асинхронное выполнение заказа
     void Execute() {
         logger_.LogMessage("Order has been started."sv);
-        RoastCutlet();
-        if (with_onion_) {
-            MarinadeOnion();
+        const bool accepted =
+            kitchen_.grill.TryEnter([self = shared_from_this()](Station::Slot slot) {
+                self->RoastCutlet(std::move(slot));
+            });
+        if (!accepted) {
+            // Очередь к грилю заполнена: отказываем сразу, не дожидаясь освобождения мест
+            logger_.LogMessage("Grill is overloaded"sv);
+            net::post(io_, [self = shared_from_this()] {
+                self->Deliver(net::error::no_buffer_space);
+            });
         }
     }
 private:
     net::io_context& io_;
+    Kitchen& kitchen_;
+    const CookingTimes& times_;
     int id_;
     bool with_onion_;
     OrderHandler handler_;
-    Logger logger_{std::to_string(id_)};
+    Logger logger_;
 
-    Timer roast_timer_ {io_, 1s};
-    Timer marinade_timer_{io_, 2s};
+    // Таймеры создаются, только когда начинается соответствующий этап
+    std::optional<Timer> roast_timer_;
+    std::optional<Timer> marinade_timer_;
 
     Hamburger hamburger_;
     bool onion_marinaded_ = false;
 
-    bool delivered_ = false; // Заказ доставлен?
+    // Этапы, которые должны завершиться до упаковки: жарка котлеты и маринование лука.
+    // Этапы выполняются параллельно и пишут только свои поля, а последний из них передаёт
+    // заказ дальше
+    std::atomic<int> pending_stages_;
+    sys::error_code roast_ec_;
+    sys::error_code marinade_ec_;
+    Station::Slot grill_slot_;
 
-    void RoastCutlet() {
+    void RoastCutlet(Station::Slot slot) {
+        grill_slot_ = std::move(slot);
         logger_.LogMessage("Start roasting cutlet"sv);
-        roast_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+        if (with_onion_) {
+            // Лук маринуется, пока жарится котлета
+            kitchen_.onion.Enter([self = shared_from_this()](Station::Slot slot) {
+                self->MarinadeOnion(std::move(slot));
+            });
+        }
+        roast_timer_.emplace(io_, times_.roast);
+        roast_timer_->async_wait([self = shared_from_this()](sys::error_code ec) {
             self->OnRoasted(ec);
         });
     }
@@ -154,14 +520,19 @@ private:
             logger_.LogMessage("Cutlet has been roasted."sv);
             hamburger_.SetCutletRoasted();
         }
-        CheckReadiness(ec);
+        roast_ec_ = ec;
+        OnStageDone();
     }
 
-    void MarinadeOnion() {
+    void MarinadeOnion(Station::Slot slot) {
         logger_.LogMessage("Start marinading onion"sv);
-        marinade_timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
-            self->OnOnionMarinaded(ec);
-        });
+        marinade_timer_.emplace(io_, times_.marinade);
+        marinade_timer_->async_wait(
+            [self = shared_from_this(), slot = std::move(slot)](sys::error_code ec) mutable {
+                // Замаринованный лук ждёт упаковки вне участка
+                slot.Release();
+                self->OnOnionMarinaded(ec);
+            });
     }
 
     void OnOnionMarinaded(sys::error_code ec) {
@@ -171,34 +542,25 @@ private:
             logger_.LogMessage("Onion has been marinaded."sv);
             onion_marinaded_ = true;
         }
-        CheckReadiness(ec);
+        marinade_ec_ = ec;
+        OnStageDone();
     }
 
-    void CheckReadiness(sys::error_code ec) {
-        if (delivered_) {
-            // Выходим, если заказ уже доставлен либо клиента уведомили об ошибке
+    void OnStageDone() {
+        if (pending_stages_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
             return;
         }
-        if (ec) {
+        if (const auto ec = roast_ec_ ? roast_ec_ : marinade_ec_) {
             // В случае ошибки уведомляем клиента о невозможности выполнить заказ
+            grill_slot_.Release();
             return Deliver(ec);
         }
-
-        // Самое время добавить лук
-        if (CanAddOnion()) {
-            logger_.LogMessage("Add onion"sv);
-            hamburger_.AddOnion();
-        }
-
-        // Если все компоненты гамбургера готовы, упаковываем его
-        if (IsReadyToPack()) {
-            Pack();
-        }
+        kitchen_.packing.Enter([self = shared_from_this()](Station::Slot slot) {
+            self->Pack(std::move(slot));
+        });
     }
 
     void Deliver(sys::error_code ec) {
-        // Защита заказа от повторной доставки
-        delivered_ = true;
         // Доставляем гамбургер в случае успеха либо nullptr, если возникла ошибка
         handler_(ec, id_, ec ? nullptr : &hamburger_);
     }
@@ -208,49 +570,131 @@ private:
         return hamburger_.IsCutletRoasted() && onion_marinaded_ && !hamburger_.HasOnion();
     }
 
-    [[nodiscard]] bool IsReadyToPack() const {
-        // Если котлета обжарена и лук добавлен, как просили, гамбургер можно упаковывать
-        return hamburger_.IsCutletRoasted() && (!with_onion_ || hamburger_.HasOnion());
-    }
+    void Pack(Station::Slot slot) {
+        // Заказ взяли на упаковку, котлета освобождает место у гриля
+        grill_slot_.Release();
+
+        // Самое время добавить лук
+        if (CanAddOnion()) {
+            logger_.LogMessage("Add onion"sv);
+            hamburger_.AddOnion();
+        }
 
-    void Pack() {
         logger_.LogMessage("Packing"sv);
 
-        // Просто потребляем ресурсы процессора в течение 0,5 с.
+        // Просто потребляем ресурсы процессора в течение times_.pack (0,5 с по умолчанию)
         auto start = steady_clock::now();
-        while (steady_clock::now() - start < 500ms) {
+        while (steady_clock::now() - start < times_.pack) {
         }
 
         hamburger_.Pack();
         logger_.LogMessage("Packed"sv);
 
+        // Упаковщик свободен ещё до уведомления клиента
+        slot.Release();
         Deliver({});
     }
-}; 
+};
 
 class Restaurant {
 public:
-    explicit Restaurant(net::io_context& io)
-        : io_(io) {
+    Restaurant(net::io_context& io, LogSink& log_sink, CookingTimes times = {},
+               KitchenCapacity capacity = {})
+        : io_(io)
+        , log_sink_(log_sink)
+        , times_(times)
+        , kitchen_(io, capacity) {
     }
 
+    // Принимает заказ. Если кухня перегружена, handler получит ошибку
+    // net::error::no_buffer_space. Метод можно вызывать из разных потоков
     int MakeHamburger(bool with_onion, OrderHandler handler) {
         const int order_id = ++next_order_id_;
-        std::make_shared<Order>(io_, order_id, with_onion, std::move(handler))->Execute();
+        // Заказ размещается в блоке, освобождённом одним из выполненных заказов
+        std::allocate_shared<Order>(order_allocator_, io_, kitchen_, log_sink_, times_, order_id,
+                                    with_onion, std::move(handler))
+            ->Execute();
         return order_id;
     }
 
 private:
     net::io_context& io_;
-    int next_order_id_ = 0;
+    LogSink& log_sink_;
+    CookingTimes times_;
+    Kitchen kitchen_;
+    std::atomic<int> next_order_id_ = 0;
+    PoolAllocator<Order> order_allocator_{std::make_shared<BlockPool>()};
 };
 
-int main() {
+// Выполняет count заказов в threads потоках и выводит в std::cerr их количество в секунду.
+// Продолжительность этапов равна обычной, умноженной на time_scale. Упаковщиков столько же,
+// сколько потоков, поэтому при ненулевом time_scale пропускная способность определяется
+// упаковкой. Заказы подаются по замкнутому циклу: выполненный или отклонённый заказ
+// освобождает место для следующего. Журнал выводится в std::cout
+void RunBenchmark(int count, int threads, double time_scale) {
+    constexpr int in_flight = 1024;
+    const CookingTimes default_times;
+    const auto scale = [time_scale](steady_clock::duration d) {
+        return duration_cast<steady_clock::duration>(d * time_scale);
+    };
+
+    net::io_context io{threads};
+    LogSink log_sink{std::cout};
+    Restaurant restaurant{
+        io, log_sink,
+        CookingTimes{scale(default_times.roast), scale(default_times.marinade),
+                     scale(default_times.pack)},
+        KitchenCapacity{.grill_slots = in_flight, .onion_slots = in_flight,
+                        .packing_slots = threads}};
+
+    std::atomic<int> submitted = 0;
+    std::atomic<int> delivered = 0;
+    std::atomic<int> rejected = 0;
+    std::function<void()> submit_next = [&] {
+        const int i = submitted++;
+        if (i >= count) {
+            return;
+        }
+        restaurant.MakeHamburger(i % 2 == 0, [&](sys::error_code ec, int, Hamburger*) {
+            ++(ec ? rejected : delivered);
+            submit_next();
+        });
+    };
+
+    const auto start = steady_clock::now();
+    for (int i = 0; i < std::min(count, in_flight); ++i) {
+        submit_next();
+    }
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads);
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([&io] {
+                io.run();
+            });
+        }
+    }
+    log_sink.Flush();
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+
+    std::cerr << "Delivered "sv << delivered << ", rejected "sv << rejected << " of "sv << count
+              << " orders in "sv << seconds << "s using "sv << threads << " threads, "sv
+              << static_cast<int>(count / seconds) << " orders/s"sv << std::endl;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc > 1 && argv[1] == "--benchmark"sv) {
+        RunBenchmark(argc > 2 ? std::stoi(argv[2]) : 100'000, argc > 3 ? std::stoi(argv[3]) : 1,
+                     argc > 4 ? std::stod(argv[4]) : 0.0);
+        return 0;
+    }
+
     net::io_context io;
+    LogSink log_sink{std::cout};
 
-    Restaurant restaurant{io};
+    Restaurant restaurant{io, log_sink};
 
-    Logger logger{"main"s};
+    Logger logger{log_sink, "main"s};
 
     struct OrderResult {
         sys::error_code ec;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "seabattle.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/*
+Двоичный протокол сервера, на котором идёт много партий одновременно.
+Ход клиента - один байт: номер клетки x * 8 + y.
+Сообщения сервера имеют фиксированную длину и начинаются с байта типа:
+  GAME_START    - 1, если первым ходит получатель, и маска его кораблей (8 байтов, big endian,
+                  клетке x * 8 + y соответствует бит с этим номером),
+  SHOT          - клетка и SeabattleField::ShotResult хода получателя,
+  OPPONENT_SHOT - клетка и SeabattleField::ShotResult хода соперника,
+  GAME_OVER     - 1, если получатель победил.
+После хода с результатом HIT или KILL ходит тот же игрок, после MISS - соперник
+*/
+namespace protocol {
+
+enum class Message : uint8_t {
+    GAME_START = 1,
+    SHOT = 2,
+    OPPONENT_SHOT = 3,
+    GAME_OVER = 4,
+};
+
+constexpr size_t MOVE_SIZE = 1;
+constexpr size_t GAME_START_SIZE = 10;
+constexpr size_t SHOT_SIZE = 3;
+constexpr size_t GAME_OVER_SIZE = 2;
+constexpr size_t MAX_MESSAGE_SIZE = GAME_START_SIZE;
+
+constexpr size_t CELL_COUNT = SeabattleField::field_size * SeabattleField::field_size;
+
+constexpr size_t GetMessageSize(Message type) {
+    switch (type) {
+        case Message::GAME_START:
+            return GAME_START_SIZE;
+        case Message::SHOT:
+        case Message::OPPONENT_SHOT:
+            return SHOT_SIZE;
+        case Message::GAME_OVER:
+            return GAME_OVER_SIZE;
+    }
+    return 0;
+}
+
+inline uint8_t EncodeCell(size_t x, size_t y) {
+    return static_cast<uint8_t>(x * SeabattleField::field_size + y);
+}
+
+inline std::pair<size_t, size_t> DecodeCell(uint8_t cell) {
+    return {cell / SeabattleField::field_size, cell % SeabattleField::field_size};
+}
+
+inline bool IsValidCell(uint8_t cell) {
+    return cell < CELL_COUNT;
+}
+
+using Buffer = std::array<char, MAX_MESSAGE_SIZE>;
+
+inline size_t MakeGameStart(const SeabattleField& field, bool your_turn, Buffer& out) {
+    uint64_t ships = 0;
+    for (size_t x = 0; x < SeabattleField::field_size; ++x) {
+        for (size_t y = 0; y < SeabattleField::field_size; ++y) {
+            if (field(x, y) == SeabattleField::State::SHIP) {
+                ships |= uint64_t{1} << EncodeCell(x, y);
+            }
+        }
+    }
+    out[0] = static_cast<char>(Message::GAME_START);
+    out[1] = your_turn ? 1 : 0;
+    for (size_t i = 0; i < 8; ++i) {
+        out[2 + i] = static_cast<char>(ships >> (56 - 8 * i));
+    }
+    return GAME_START_SIZE;
+}
+
+inline size_t MakeShot(Message type, uint8_t cell, SeabattleField::ShotResult result, Buffer& out) {
+    out[0] = static_cast<char>(type);
+    out[1] = static_cast<char>(cell);
+    out[2] = static_cast<char>(result);
+    return SHOT_SIZE;
+}
+
+inline size_t MakeGameOver(bool you_won, Buffer& out) {
+    out[0] = static_cast<char>(Message::GAME_OVER);
+    out[1] = you_won ? 1 : 0;
+    return GAME_OVER_SIZE;
+}
+
+}  // namespace protocol
@@ -1,11 +1,18 @@
 #pragma once
 #include <array>
+#include <algorithm>
+#include <bit>
 #include <cassert>
-#include <optional>
+#include <cstdint>
 #include <iostream>
 #include <random>
-#include <set>
 
+/*
+Поле хранится битовыми масками: 64 клетки - 64 бита, клетка (x, y) - бит x * 8 + y.
+Клетка входит не больше чем в одну из масок ships_, killed_, empty_, клетки вне всех масок
+неизвестны. Соседние клетки получаются сдвигами масок, поэтому расстановка кораблей и разбор
+выстрелов обходятся без циклов по клеткам
+*/
 class SeabattleField {
 public:
     enum class State {
@@ -18,134 +25,193 @@ public:
     static const size_t field_size = 8;
 
     SeabattleField(State default_elem = State::UNKNOWN) {
-        field_.fill(default_elem);
+        switch (default_elem) {
+            case State::UNKNOWN:
+                break;
+            case State::EMPTY:
+                empty_ = ALL_CELLS;
+                break;
+            case State::KILLED:
+                killed_ = ALL_CELLS;
+                break;
+            case State::SHIP:
+                ships_ = ALL_CELLS;
+                break;
+        }
     }
 
+    // Корабли ставятся по очереди, каждый - в случайное из положений, ещё оставшихся свободными.
+    // Если следующему кораблю места не осталось, выбирается другое положение предыдущего,
+    // поэтому поле строится за один проход без повторных попыток
     template <class T>
     static SeabattleField GetRandomField(T&& random_engine) {
-        std::optional<SeabattleField> res;
-        do {
-            res = TryGetRandomField(random_engine);
-        } while (!res);
-
-        return *res;
+        SeabattleField result{State::EMPTY};
+        [[maybe_unused]] const bool placed = PlaceShips(random_engine, 0, ALL_CELLS, result.ships_);
+        assert(placed);
+        result.empty_ = ~result.ships_;
+        return result;
     }
 
 private:
-    template<class T>
-    static std::optional<SeabattleField> TryGetRandomField(T&& random_engine) {
-        SeabattleField result{State::EMPTY};
+    using Cells = uint64_t;
 
-        std::set<std::pair<size_t, size_t>> availableElements;
-        std::vector ship_sizes = {4, 3, 3, 2, 2, 2, 1, 1, 1, 1};
+    static constexpr Cells ALL_CELLS = ~Cells{0};
+    // Клетки с y == 0 и с y == field_size - 1
+    static constexpr Cells FIRST_ROW = 0x0101010101010101;
+    static constexpr Cells LAST_ROW = 0x8080808080808080;
 
-        const auto mark_cell_as_used = [&](size_t x, size_t y) {
-            for (int dy = -1; dy <= 1; ++dy) {
-                for (int dx = -1; dx <= 1; ++dx) {
-                    availableElements.erase({x + dx, y + dy});
-                }
-            }
-        };
-
-        const auto dir_to_dxdy = [](size_t dir) -> std::pair<int, int> {
-            int dx = dir == 1 ? 1 : dir == 3 ? -1 : 0;
-            int dy = dir == 0 ? 1 : dir == 2 ? -1 : 0;
+    static constexpr Cells Bit(size_t x, size_t y) {
+        return Cells{1} << (x * field_size + y);
+    }
 
-            return {dx, dy};
-        };
+    // Добавляет к клеткам соседей слева и справа
+    static constexpr Cells GrowX(Cells cells) {
+        return cells | cells << field_size | cells >> field_size;
+    }
 
-        const auto check_ship_available = [&](size_t x, size_t y, size_t dir, int ship_length) {
-            auto [dx, dy] = dir_to_dxdy(dir);
+    // Добавляет к клеткам соседей сверху и снизу, не перенося их в соседний столбец
+    static constexpr Cells GrowY(Cells cells) {
+        return cells | (cells << 1 & ~FIRST_ROW) | (cells >> 1 & ~LAST_ROW);
+    }
 
-            for (int i = 0; i < ship_length; ++i) {
-                size_t cx = x + dx * i;
-                size_t cy = y + dy * i;
+    // Клетки из mask, до которых можно дойти от seed шагами grow
+    template <class Grow>
+    static constexpr Cells Fill(Cells seed, Cells mask, Grow grow) {
+        Cells filled = seed;
+        for (Cells prev = 0; prev != filled;) {
+            prev = filled;
+            filled |= grow(filled) & mask;
+        }
+        return filled;
+    }
 
-                if (cx >= field_size || cy >= field_size) {
-                    return false;
-                }
-                if (availableElements.count({cx, cy}) == 0) {
-                    return false;
-                }
-            }
+    // Номер n-го по счёту установленного бита
+    static size_t NthSetBit(Cells cells, size_t n) {
+        size_t base = 0;
+        for (size_t count; n >= (count = static_cast<size_t>(std::popcount(cells & 0xFF))); n -= count) {
+            cells >>= field_size;
+            base += field_size;
+        }
+        for (; n > 0; --n) {
+            cells &= cells - 1;
+        }
+        return base + static_cast<size_t>(std::countr_zero(cells));
+    }
 
-            return true;
-        };
+    // Клетки, из которых корабль длины length помещается в cells, идя вдоль оси, которую задаёт shift
+    template <class Shift>
+    static constexpr Cells GetShipStarts(Cells cells, size_t length, Shift shift) {
+        Cells starts = cells;
+        for (Cells next = cells; --length > 0;) {
+            next = shift(next);
+            starts &= next;
+        }
+        return starts;
+    }
 
-        const auto mark_ship = [&](size_t x, size_t y, size_t dir, int ship_length){
-            auto [dx, dy] = dir_to_dxdy(dir);
+    // Сдвиги, совмещающие с клеткой (x, y) клетки (x + 1, y) и (x, y + 1)
+    static constexpr Cells NextX(Cells cells) {
+        return cells >> field_size;
+    }
 
-            for (int i = 0; i < ship_length; ++i) {
-                size_t cx = x + dx * i;
-                size_t cy = y + dy * i;
+    static constexpr Cells NextY(Cells cells) {
+        return cells >> 1 & ~LAST_ROW;
+    }
 
-                result.Get(cx, cy) = State::SHIP;
-                mark_cell_as_used(cx, cy);
-            }
-        };
+    static constexpr std::array<size_t, 10> SHIP_SIZES = {4, 3, 3, 2, 2, 2, 1, 1, 1, 1};
 
-        for (size_t y = 0; y < field_size; ++y) {
-            for (size_t x = 0; x < field_size; ++x) {
-                availableElements.insert({x, y});
+    // Сколько блоков 2x2 нужно кораблям, начиная с i-го: два корабля не могут занимать один блок,
+    // потому что их клетки соприкасались бы, а корабль длины L занимает не меньше (L + 1) / 2 блоков
+    static constexpr std::array<size_t, SHIP_SIZES.size() + 1> BLOCKS_NEEDED = [] {
+        std::array<size_t, SHIP_SIZES.size() + 1> result{};
+        for (size_t i = SHIP_SIZES.size(); i-- > 0;) {
+            result[i] = result[i + 1] + (SHIP_SIZES[i] + 1) / 2;
+        }
+        return result;
+    }();
+
+    // Верхняя оценка числа кораблей, которые ещё можно поставить: количество блоков 2x2 со свободными
+    // клетками, минимальное по четырём способам разбить поле на блоки
+    static size_t CountFreeBlocks(Cells available) {
+        constexpr Cells EVEN_COLUMNS = 0x00FF00FF00FF00FF;
+        constexpr Cells EVEN_ROWS = 0x5555555555555555;
+        constexpr Cells FIRST_COLUMN = 0xFF;
+
+        // Блоки по x: {0, 1}, {2, 3}, ... либо {0}, {1, 2}, ..., {7}. Блок представлен первой клеткой
+        const Cells pairs_x = available | NextX(available);
+        size_t result = field_size * field_size;
+        for (const Cells blocks_x : {pairs_x & EVEN_COLUMNS, (pairs_x & ~EVEN_COLUMNS) | (available & FIRST_COLUMN)}) {
+            const Cells pairs_y = blocks_x | NextY(blocks_x);
+            for (const Cells blocks : {pairs_y & EVEN_ROWS, (pairs_y & ~EVEN_ROWS) | (blocks_x & FIRST_ROW)}) {
+                result = std::min(result, static_cast<size_t>(std::popcount(blocks)));
             }
         }
+        return result;
+    }
 
-        using Distr = std::uniform_int_distribution<size_t>;
-        using Param = Distr::param_type;
+    // Сколько клеток, попарно не соприкасающихся даже углами, можно выбрать в available, но не больше limit
+    static size_t CountIsolatedCells(Cells available, size_t limit) {
+        if (limit == 0 || available == 0) {
+            return 0;
+        }
+        // Либо берём первую свободную клетку и исключаем её соседей, либо обходимся без неё
+        const Cells cell = available & (~available + 1);
+        const size_t with_cell = 1 + CountIsolatedCells(available & ~GrowY(GrowX(cell)), limit - 1);
+        if (with_cell == limit) {
+            return with_cell;
+        }
+        return std::max(with_cell, CountIsolatedCells(available & ~cell, limit));
+    }
 
-        static const int max_attempts = 100;
+    // Расставляет корабли, начиная с ship, в клетках available. Возвращает false, если места нет
+    template <class T>
+    static bool PlaceShips(T& random_engine, size_t ship, Cells available, Cells& ships) {
+        if (ship == SHIP_SIZES.size()) {
+            return true;
+        }
+        // Отсекаем расстановки, в которых оставшиеся корабли заведомо не поместятся: сначала грубой
+        // оценкой, затем точной. В каждом корабле можно выбрать клетку, и эти клетки не соприкасаются
+        const size_t ships_left = SHIP_SIZES.size() - ship;
+        if (CountFreeBlocks(available) < BLOCKS_NEEDED[ship] || CountIsolatedCells(available, ships_left) < ships_left) {
+            return false;
+        }
 
-        for (int length : ship_sizes) {
-            std::pair<size_t, size_t> pos;
-            size_t direction;
-            int attempt = 0;
+        // Все положения корабля, которые ещё помещаются: по биту на клетку начала для каждого направления.
+        // Корабль из одной клетки в обоих направлениях один и тот же
+        const size_t length = SHIP_SIZES[ship];
+        Cells starts_x = GetShipStarts(available, length, NextX);
+        Cells starts_y = length > 1 ? GetShipStarts(available, length, NextY) : 0;
+        const Cells ship_x = FIRST_ROW >> (field_size - length) * field_size;
+        const Cells ship_y = (Cells{1} << length) - 1;
 
-            Distr d;
-            do {
-                if (attempt++ >= max_attempts || availableElements.empty()) {
-                    return std::nullopt;
-                }
+        using Distr = std::uniform_int_distribution<size_t>;
+        using Param = Distr::param_type;
 
-                size_t pos_index = d(random_engine, Param(0, availableElements.size() - 1));
-                direction = d(random_engine, Param(0, 3));
-                pos = *std::next(availableElements.begin(), pos_index);
-            } while (!check_ship_available(pos.first, pos.second, direction, length));
-            mark_ship(pos.first, pos.second, direction, length);
-        }
+        Distr d;
+        for (;;) {
+            const auto count_x = static_cast<size_t>(std::popcount(starts_x));
+            const auto count = count_x + static_cast<size_t>(std::popcount(starts_y));
+            if (count == 0) {
+                return false;
+            }
 
-        return result;
-    }
+            const size_t index = d(random_engine, Param(0, count - 1));
+            const bool along_x = index < count_x;
+            Cells& starts = along_x ? starts_x : starts_y;
+            const size_t start = NthSetBit(starts, along_x ? index : index - count_x);
+            // Если дальше корабли не встанут, это положение больше не выбирается
+            starts &= ~(Cells{1} << start);
 
-    bool IsKilledInDirection(size_t x, size_t y, int dx, int dy) const {
-        for (; x < field_size && y < field_size; x += dx, y += dy) {
-            if (Get(x, y) == State::EMPTY) {
+            const Cells ship_cells = (along_x ? ship_x : ship_y) << start;
+            if (PlaceShips(random_engine, ship + 1, available & ~GrowY(GrowX(ship_cells)), ships)) {
+                ships |= ship_cells;
                 return true;
             }
-            if (Get(x, y) != State::KILLED) {
-                return false;
-            }
         }
-        return true;
     }
 
-    void MarkKillInDirection(size_t x, size_t y, int dx, int dy) {
-        auto mark_cell_empty = [this](size_t x, size_t y) {
-            if (x >= field_size || y >= field_size) {
-                return;
-            }
-            if (Get(x, y) != State::UNKNOWN) {
-                return;
-            }
-            Get(x, y) = State::EMPTY;
-        };
-        for (; x < field_size && y < field_size; x += dx, y += dy) {
-            mark_cell_empty(x + dy, y + dx);
-            mark_cell_empty(x - dy, y - dx);
-            mark_cell_empty(x, y);
-            if (Get(x, y) != State::KILLED) {
-                return;
-            }
-        }
+    Cells GetUnknown() const {
+        return ~(ships_ | killed_ | empty_);
     }
 
 public:
@@ -156,47 +222,73 @@ public:
     };
 
     ShotResult Shoot(size_t x, size_t y) {
-        if (Get(x, y) != State::SHIP) return ShotResult::MISS;
+        const Cells cell = Bit(x, y);
+        if ((ships_ & cell) == 0) return ShotResult::MISS;
 
-        Get(x, y) = State::KILLED;
+        ships_ &= ~cell;
+        killed_ |= cell;
         --weight_;
 
         return IsKilled(x, y) ? ShotResult::KILL : ShotResult::HIT;
     }
 
     void MarkMiss(size_t x, size_t y) {
-        if (Get(x, y) != State::UNKNOWN) {
-            return;
-        }
-        Get(x, y) = State::EMPTY;
+        empty_ |= Bit(x, y) & GetUnknown();
     }
 
     void MarkHit(size_t x, size_t y) {
-        if (Get(x, y) != State::UNKNOWN) {
+        const Cells cell = Bit(x, y);
+        if ((cell & GetUnknown()) == 0) {
             return;
         }
         --weight_;
-        Get(x, y) = State::KILLED;
+        killed_ |= cell;
     }
 
+    // Отмечает убитый корабль, проходящий через (x, y), и все неизвестные клетки вокруг него как пустые
     void MarkKill(size_t x, size_t y) {
-        if (Get(x, y) != State::UNKNOWN) {
+        const Cells cell = Bit(x, y);
+        if ((cell & GetUnknown()) == 0) {
             return;
         }
         MarkHit(x, y);
-        MarkKillInDirection(x, y, 1, 0);
-        MarkKillInDirection(x, y, -1, 0);
-        MarkKillInDirection(x, y, 0, 1);
-        MarkKillInDirection(x, y, 0, -1);
+        // Подбитые клетки в строке и в столбце вместе с клетками за их концами и по бокам
+        const Cells around = GrowY(GrowX(Fill(cell, killed_, GrowX))) | GrowX(GrowY(Fill(cell, killed_, GrowY)));
+        empty_ |= around & GetUnknown();
     }
 
     State operator()(size_t x, size_t y) const {
         return Get(x, y);
     }
 
+    // Маска клеток в состоянии state: клетке (x, y) соответствует бит x * field_size + y
+    uint64_t GetCells(State state) const {
+        switch (state) {
+            case State::UNKNOWN:
+                return GetUnknown();
+            case State::EMPTY:
+                return empty_;
+            case State::KILLED:
+                return killed_;
+            case State::SHIP:
+                return ships_;
+        }
+        return 0;
+    }
+
+    // Корабль убит, если за обоими концами подбитых клеток в строке и в столбце пусто либо край поля
     bool IsKilled(size_t x, size_t y) const {
-        return IsKilledInDirection(x, y, 1, 0) && IsKilledInDirection(x, y, -1, 0)
-            && IsKilledInDirection(x, y, 0, 1) && IsKilledInDirection(x, y, 0, -1);
+        const Cells cell = Bit(x, y);
+        if ((empty_ & cell) != 0) {
+            return true;
+        }
+        if ((killed_ & cell) == 0) {
+            return false;
+        }
+        const auto is_closed = [this](Cells run, auto grow) {
+            return (grow(run) & ~run & ~empty_) == 0;
+        };
+        return is_closed(Fill(cell, killed_, GrowX), GrowX) && is_closed(Fill(cell, killed_, GrowY), GrowY);
     }
 
     static void PrintDigitLine(std::ostream& out) {
@@ -226,12 +318,18 @@ public:
     }
 
 private:
-    State& Get(size_t x, size_t y) {
-        return field_[x + y * field_size];
-    }
-
     State Get(size_t x, size_t y) const {
-        return field_[x + y * field_size];
+        const Cells cell = Bit(x, y);
+        if ((killed_ & cell) != 0) {
+            return State::KILLED;
+        }
+        if ((ships_ & cell) != 0) {
+            return State::SHIP;
+        }
+        if ((empty_ & cell) != 0) {
+            return State::EMPTY;
+        }
+        return State::UNKNOWN;
     }
 
     static char Repr(State state) {
@@ -250,6 +348,8 @@ private:
     }
 
 private:
-    std::array<State, field_size * field_size> field_;
+    Cells ships_ = 0;
+    Cells killed_ = 0;
+    Cells empty_ = 0;
     int weight_ = 1 * 4 + 2 * 3 + 3 * 2 + 4 * 1;
 };
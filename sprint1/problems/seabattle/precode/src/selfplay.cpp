@@ -0,0 +1,297 @@
+#include "philox.h"
+#include "seabattle.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+using Cell = std::pair<size_t, size_t>;
+using Cells = uint64_t;
+using Engine = rng::PhiloxStream;
+
+constexpr size_t SIZE = SeabattleField::field_size;
+// Клетки с y == 0 и с y == SIZE - 1 (клетке (x, y) соответствует бит x * SIZE + y)
+constexpr Cells FIRST_ROW = 0x0101010101010101;
+constexpr Cells LAST_ROW = 0x8080808080808080;
+// Клетки, у которых x + y чётно
+constexpr Cells EVEN_CELLS = 0xAA55AA55AA55AA55;
+
+Cells GetNeighboursX(Cells cells) {
+    return cells << SIZE | cells >> SIZE;
+}
+
+Cells GetNeighboursY(Cells cells) {
+    return (cells << 1 & ~FIRST_ROW) | (cells >> 1 & ~LAST_ROW);
+}
+
+// Случайная клетка из непустой маски
+Cell PickRandom(Cells cells, Engine& engine) {
+    const auto count = static_cast<size_t>(std::popcount(cells));
+    for (size_t n = std::uniform_int_distribution<size_t>{0, count - 1}(engine); n > 0; --n) {
+        cells &= cells - 1;
+    }
+    const auto index = static_cast<size_t>(std::countr_zero(cells));
+    return {index / SIZE, index % SIZE};
+}
+
+// Стреляет в случайную неизвестную клетку
+Cell ShootRandomly(const SeabattleField& view, Engine& engine) {
+    return PickRandom(view.GetCells(SeabattleField::State::UNKNOWN), engine);
+}
+
+/*
+Пока есть подбитый, но не убитый корабль, добивает его: стреляет рядом с подбитыми клетками,
+а если их две в ряд - только вдоль этого ряда. Иначе ищет корабли в шахматном порядке:
+так каждый корабль длиннее одной клетки найдётся вдвое меньшим числом выстрелов
+*/
+Cell HuntAndTarget(const SeabattleField& view, Engine& engine) {
+    const Cells unknown = view.GetCells(SeabattleField::State::UNKNOWN);
+
+    Cells wounded = 0;
+    for (Cells killed = view.GetCells(SeabattleField::State::KILLED); killed != 0; killed &= killed - 1) {
+        const auto index = static_cast<size_t>(std::countr_zero(killed));
+        if (!view.IsKilled(index / SIZE, index % SIZE)) {
+            wounded |= Cells{1} << index;
+        }
+    }
+    // От подбитой клетки ряд продолжается вдоль оси, если на другой оси у неё нет подбитых соседей
+    const Cells targets = unknown
+                        & (GetNeighboursX(wounded & ~GetNeighboursY(wounded))
+                           | GetNeighboursY(wounded & ~GetNeighboursX(wounded)));
+    if (targets != 0) {
+        return PickRandom(targets, engine);
+    }
+    if ((unknown & EVEN_CELLS) != 0) {
+        return PickRandom(unknown & EVEN_CELLS, engine);
+    }
+    return PickRandom(unknown, engine);
+}
+
+using Strategy = Cell (*)(const SeabattleField&, Engine&);
+
+struct Bot {
+    std::string_view name;
+    Strategy strategy;
+};
+
+struct GameResult {
+    size_t winner;
+    size_t shots;
+};
+
+// Играет одну партию, первым ходит бот first
+GameResult PlayGame(const std::array<Bot, 2>& bots, size_t first, Engine& engine) {
+    std::array<SeabattleField, 2> fields = {SeabattleField::GetRandomField(engine),
+                                            SeabattleField::GetRandomField(engine)};
+    std::array<SeabattleField, 2> views;
+
+    size_t turn = first;
+    for (size_t shots = 1;; ++shots) {
+        const auto [x, y] = bots[turn].strategy(views[turn], engine);
+        SeabattleField& target = fields[1 - turn];
+        switch (target.Shoot(x, y)) {
+            case SeabattleField::ShotResult::MISS:
+                views[turn].MarkMiss(x, y);
+                turn = 1 - turn;
+                continue;
+            case SeabattleField::ShotResult::HIT:
+                views[turn].MarkHit(x, y);
+                break;
+            case SeabattleField::ShotResult::KILL:
+                views[turn].MarkKill(x, y);
+                break;
+        }
+        if (target.IsLoser()) {
+            return {turn, shots};
+        }
+    }
+}
+
+/*
+Планировщик с перехватом работы. Номера партий делятся между потоками поровну, и каждый поток
+берёт их из своего диапазона порциями по BATCH_SIZE. Поток, исчерпавший свой диапазон,
+забирает вторую половину диапазона у первого соседа, у которого ещё осталось больше порции
+*/
+class WorkStealingQueue {
+public:
+    static constexpr size_t BATCH_SIZE = 256;
+
+    WorkStealingQueue(size_t total, size_t workers)
+        : ranges_(workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            ranges_[i].begin = total * i / workers;
+            ranges_[i].end = total * (i + 1) / workers;
+        }
+    }
+
+    // Возвращает очередную порцию номеров партий для потока worker либо nullopt, если работа кончилась
+    std::optional<std::pair<size_t, size_t>> Take(size_t worker) {
+        if (auto batch = TakeFront(ranges_[worker])) {
+            return batch;
+        }
+        for (size_t i = 1; i < ranges_.size(); ++i) {
+            Range& victim = ranges_[(worker + i) % ranges_.size()];
+            std::unique_lock lock{victim.mutex};
+            if (victim.end - victim.begin <= BATCH_SIZE) {
+                if (victim.begin == victim.end) {
+                    continue;
+                }
+                // Остаток меньше порции делить незачем
+                const std::pair batch{victim.begin, victim.end};
+                victim.begin = victim.end;
+                return batch;
+            }
+            const size_t middle = victim.begin + (victim.end - victim.begin) / 2;
+            const size_t stolen_end = victim.end;
+            victim.end = middle;
+            lock.unlock();
+
+            Range& own = ranges_[worker];
+            std::lock_guard own_lock{own.mutex};
+            own.begin = std::min(stolen_end, middle + BATCH_SIZE);
+            own.end = stolen_end;
+            return std::pair{middle, own.begin};
+        }
+        return std::nullopt;
+    }
+
+private:
+    // Счётчики разных потоков на разных кеш-линиях
+    struct alignas(64) Range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    static std::optional<std::pair<size_t, size_t>> TakeFront(Range& range) {
+        std::lock_guard lock{range.mutex};
+        if (range.begin == range.end) {
+            return std::nullopt;
+        }
+        const size_t begin = range.begin;
+        range.begin = std::min(range.end, begin + BATCH_SIZE);
+        return std::pair{begin, range.begin};
+    }
+
+    std::vector<Range> ranges_;
+};
+
+struct Totals {
+    std::array<size_t, 2> wins{};
+    size_t games = 0;
+    size_t shots = 0;
+
+    Totals& operator+=(const Totals& other) {
+        wins[0] += other.wins[0];
+        wins[1] += other.wins[1];
+        games += other.games;
+        shots += other.shots;
+        return *this;
+    }
+};
+
+// Каждая партия играет со своим потоком случайных чисел, заданным seed и номером партии, поэтому
+// итоги не зависят от того, какой поток выполнения взял партию. Итоги поток копит локально
+// и отдаёт один раз в конце
+Totals PlayGames(const std::array<Bot, 2>& bots, size_t games, size_t threads, uint64_t seed) {
+    WorkStealingQueue queue{games, threads};
+    std::vector<Totals> totals(threads);
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads);
+        for (size_t worker = 0; worker < threads; ++worker) {
+            workers.emplace_back([&, worker] {
+                Totals local;
+                while (const auto batch = queue.Take(worker)) {
+                    for (size_t game = batch->first; game < batch->second; ++game) {
+                        Engine engine{seed, game};
+                        // Боты ходят первыми по очереди, чтобы право первого хода не влияло на итог
+                        const GameResult result = PlayGame(bots, game % 2, engine);
+                        ++local.wins[result.winner];
+                        local.shots += result.shots;
+                        ++local.games;
+                    }
+                }
+                totals[worker] = local;
+            });
+        }
+    }
+
+    Totals result;
+    for (const Totals& t : totals) {
+        result += t;
+    }
+    return result;
+}
+
+void PrintUsage() {
+    std::cout << "Usage: seabattle_selfplay [<games>] [<threads>] [<seed>]" << std::endl;
+}
+
+// Разбирает неотрицательное число аргумента командной строки. Текст после числа не допускается
+uint64_t ParseArgument(const char* arg) {
+    const std::string text{arg};
+    size_t end = 0;
+    const uint64_t value = std::stoull(text, &end);
+    if (end != text.size() || text.find('-') != std::string::npos) {
+        throw std::invalid_argument{text};
+    }
+    return value;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    if (argc > 4) {
+        PrintUsage();
+        return 1;
+    }
+
+    size_t games = 1'000'000;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = std::random_device{}();
+    try {
+        games = argc > 1 ? ParseArgument(argv[1]) : games;
+        threads = argc > 2 ? ParseArgument(argv[2]) : threads;
+        seed = argc > 3 ? ParseArgument(argv[3]) : seed;
+    } catch (const std::logic_error&) {
+        // std::invalid_argument и std::out_of_range
+        PrintUsage();
+        return 1;
+    }
+    if (games == 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    const std::array<Bot, 2> bots = {Bot{"hunt-and-target"sv, HuntAndTarget}, Bot{"random"sv, ShootRandomly}};
+
+    const auto start = std::chrono::steady_clock::now();
+    const Totals totals = PlayGames(bots, games, std::max<size_t>(threads, 1), seed);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < bots.size(); ++i) {
+        std::cout << bots[i].name << ": "sv << 100.0 * totals.wins[i] / totals.games << "% wins"sv << std::endl;
+    }
+    std::cout << "Shots per game: "sv << static_cast<double>(totals.shots) / totals.games << std::endl;
+    std::cout << totals.games << " games in "sv << elapsed.count() << " s on "sv << threads << " threads, "sv
+              << totals.games / elapsed.count() << " games/s"sv << std::endl;
+}
@@ -0,0 +1,285 @@
+#ifdef WIN32
+#include <sdkddkver.h>
+#endif
+
+#include "philox.h"
+#include "protocol.h"
+#include "seabattle.h"
+
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using net::ip::tcp;
+using namespace std::literals;
+
+namespace {
+
+struct Statistics {
+    std::atomic<size_t> games_started = 0;
+    std::atomic<size_t> games_finished = 0;
+    std::atomic<size_t> moves = 0;
+};
+
+/*
+Партия двух игроков. Поля генерирует и выстрелы разбирает сервер, клиенты только присылают ходы.
+Все обработчики партии выполняются в её strand, поэтому состояние партии не требует блокировок,
+а разные партии идут параллельно на всех потоках пула.
+Если игрок отключился или прислал неверный ход, он проигрывает
+*/
+class Game : public std::enable_shared_from_this<Game> {
+public:
+    // Поля строятся из собственного потока случайных чисел партии, поэтому партии не делят
+    // состояние генератора, а поля партии воспроизводятся по seed сервера и номеру партии
+    Game(net::io_context& io, tcp::socket&& first, tcp::socket&& second, rng::PhiloxStream random_engine,
+         Statistics& stats)
+        : strand_{net::make_strand(io)}
+        , sides_{Side{std::move(first), SeabattleField::GetRandomField(random_engine)},
+                 Side{std::move(second), SeabattleField::GetRandomField(random_engine)}}
+        , stats_{stats} {
+        ++stats_.games_started;
+    }
+
+    Game(const Game&) = delete;
+    Game& operator=(const Game&) = delete;
+
+    ~Game() {
+        ++stats_.games_finished;
+    }
+
+    void Start() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            for (size_t side = 0; side < 2; ++side) {
+                protocol::Buffer message;
+                self->Send(side, message, protocol::MakeGameStart(self->sides_[side].field, side == 0, message));
+            }
+            self->ReadMove();
+        });
+    }
+
+private:
+    struct Side {
+        tcp::socket socket;
+        SeabattleField field;
+        // Сообщения, которые ещё не отправлялись, и сообщения, которые отправляются сейчас
+        std::vector<char> pending = {};
+        std::vector<char> writing = {};
+        bool writing_in_progress = false;
+    };
+
+    static size_t Opponent(size_t side) {
+        return 1 - side;
+    }
+
+    void ReadMove() {
+        net::async_read(sides_[turn_].socket, net::buffer(&move_, protocol::MOVE_SIZE),
+                        net::bind_executor(strand_, [self = shared_from_this()](sys::error_code ec, size_t) {
+                            self->OnMove(ec);
+                        }));
+    }
+
+    void OnMove(sys::error_code ec) {
+        if (finished_) {
+            return;
+        }
+        if (ec || !protocol::IsValidCell(move_)) {
+            Finish(Opponent(turn_));
+            return;
+        }
+        ++stats_.moves;
+
+        const auto [x, y] = protocol::DecodeCell(move_);
+        SeabattleField& target = sides_[Opponent(turn_)].field;
+        const auto result = target.Shoot(x, y);
+
+        protocol::Buffer message;
+        Send(turn_, message, protocol::MakeShot(protocol::Message::SHOT, move_, result, message));
+        Send(Opponent(turn_), message,
+             protocol::MakeShot(protocol::Message::OPPONENT_SHOT, move_, result, message));
+
+        if (target.IsLoser()) {
+            Finish(turn_);
+            return;
+        }
+        if (result == SeabattleField::ShotResult::MISS) {
+            turn_ = Opponent(turn_);
+        }
+        ReadMove();
+    }
+
+    void Finish(size_t winner) {
+        finished_ = true;
+        for (size_t side = 0; side < 2; ++side) {
+            protocol::Buffer message;
+            Send(side, message, protocol::MakeGameOver(side == winner, message));
+        }
+    }
+
+    // Сообщения, отправленные, пока идёт запись, уходят следующей записью одним блоком
+    void Send(size_t side, const protocol::Buffer& message, size_t size) {
+        auto& pending = sides_[side].pending;
+        pending.insert(pending.end(), message.begin(), message.begin() + size);
+        Write(side);
+    }
+
+    void Write(size_t side) {
+        Side& s = sides_[side];
+        if (s.writing_in_progress || s.pending.empty()) {
+            return;
+        }
+        s.writing_in_progress = true;
+        std::swap(s.pending, s.writing);
+        net::async_write(s.socket, net::buffer(s.writing),
+                         net::bind_executor(strand_, [self = shared_from_this(), side](sys::error_code ec, size_t) {
+                             self->OnWrite(side, ec);
+                         }));
+    }
+
+    void OnWrite(size_t side, sys::error_code ec) {
+        Side& s = sides_[side];
+        s.writing_in_progress = false;
+        s.writing.clear();
+        if (ec) {
+            if (!finished_) {
+                Finish(Opponent(side));
+            }
+            return;
+        }
+        Write(side);
+        if (finished_ && !s.writing_in_progress) {
+            // Итог партии отправлен: ожидающее чтение хода завершится, и партия будет удалена
+            s.socket.shutdown(tcp::socket::shutdown_both, ec);
+        }
+    }
+
+    net::strand<net::io_context::executor_type> strand_;
+    std::array<Side, 2> sides_;
+    Statistics& stats_;
+    size_t turn_ = 0;
+    uint8_t move_ = 0;
+    bool finished_ = false;
+};
+
+/*
+Принимает соединения и объединяет игроков в пары в порядке подключения.
+Подбор пар выполняется в strand акцептора
+*/
+class Server {
+public:
+    Server(net::io_context& io, unsigned short port)
+        : io_{io}
+        , acceptor_{net::make_strand(io), tcp::endpoint(tcp::v4(), port)}
+        , timer_{io}
+        , seed_{std::random_device{}()} {
+    }
+
+    void Start() {
+        Accept();
+        ReportStatistics();
+    }
+
+private:
+    void Accept() {
+        acceptor_.async_accept(io_, [this](sys::error_code ec, tcp::socket socket) {
+            if (ec) {
+                std::cerr << "Accept error: "sv << ec.message() << std::endl;
+            } else {
+                socket.set_option(tcp::no_delay(true));
+                Match(std::move(socket));
+            }
+            Accept();
+        });
+    }
+
+    void Match(tcp::socket&& socket) {
+        if (!waiting_) {
+            waiting_ = std::move(socket);
+            WatchWaiting(++waiting_id_);
+            return;
+        }
+        // Отменяем наблюдение, пока сокет не передан партии
+        waiting_->cancel();
+        std::make_shared<Game>(io_, std::move(*waiting_), std::move(socket),
+                               rng::PhiloxStream{seed_, next_game_id_++}, stats_)
+            ->Start();
+        waiting_.reset();
+    }
+
+    // До начала партии клиент ничего не присылает, поэтому готовность к чтению означает,
+    // что он отключился
+    void WatchWaiting(size_t id) {
+        waiting_->async_wait(tcp::socket::wait_read,
+                             net::bind_executor(acceptor_.get_executor(), [this, id](sys::error_code ec) {
+                                 if (!ec && waiting_ && waiting_id_ == id) {
+                                     waiting_.reset();
+                                 }
+                             }));
+    }
+
+    void ReportStatistics() {
+        timer_.expires_after(1s);
+        timer_.async_wait([this](sys::error_code ec) {
+            if (ec) {
+                return;
+            }
+            const size_t started = stats_.games_started;
+            const size_t finished = stats_.games_finished;
+            if (const size_t moves = stats_.moves.exchange(0); moves != 0 || started != finished) {
+                std::cout << "Games: "sv << started - finished << " active, "sv << finished << " finished, moves: "sv
+                          << moves << "/s"sv << std::endl;
+            }
+            ReportStatistics();
+        });
+    }
+
+    net::io_context& io_;
+    tcp::acceptor acceptor_;
+    net::steady_timer timer_;
+    Statistics stats_;
+    // Ключ потоков случайных чисел партий, номер партии выбирает поток
+    std::uint64_t seed_;
+    std::uint64_t next_game_id_ = 0;
+    std::optional<tcp::socket> waiting_;
+    size_t waiting_id_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+    if (argc != 2) {
+        std::cout << "Usage: seabattle_server <port>" << std::endl;
+        return 1;
+    }
+
+    try {
+        const unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+        net::io_context io_context{static_cast<int>(num_threads)};
+
+        Server server{io_context, static_cast<unsigned short>(std::stoi(argv[1]))};
+        server.Start();
+        std::cout << "Seabattle server is listening on port "sv << argv[1] << " with "sv << num_threads
+                  << " threads"sv << std::endl;
+
+        std::vector<std::jthread> workers;
+        workers.reserve(num_threads - 1);
+        for (unsigned i = 1; i < num_threads; ++i) {
+            workers.emplace_back([&io_context] {
+                io_context.run();
+            });
+        }
+        io_context.run();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
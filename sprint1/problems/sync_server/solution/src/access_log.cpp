@@ -0,0 +1,161 @@
+#include "access_log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+namespace access_log {
+
+using namespace std::literals;
+
+namespace {
+
+// Сколько записей фоновый поток форматирует перед выводом
+constexpr size_t MAX_BATCH_SIZE = 1024;
+// Пауза фонового потока, когда кольцо пусто
+constexpr auto IDLE_INTERVAL = 10ms;
+
+// Дописывает в out строку вида
+// 2023-01-01T12:00:00.123Z GET /target 200 12 35us
+void FormatRecord(std::string& out, const Record& record) {
+    namespace chrono = std::chrono;
+    const auto since_epoch = record.time.time_since_epoch();
+    const std::time_t seconds = chrono::duration_cast<chrono::seconds>(since_epoch).count();
+    const auto millis = chrono::duration_cast<chrono::milliseconds>(since_epoch).count() % 1000;
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+
+    char time_buf[32];
+    const int time_size = std::snprintf(time_buf, sizeof(time_buf),
+                                        "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ ", tm.tm_year + 1900,
+                                        tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min,
+                                        tm.tm_sec, static_cast<int>(millis));
+    out.append(time_buf, static_cast<size_t>(time_size));
+    out.append(http::to_string(record.method)).push_back(' ');
+    out.append(record.GetTarget()).push_back(' ');
+
+    char tail_buf[64];
+    const int tail_size = std::snprintf(tail_buf, sizeof(tail_buf), "%u %llu %lldus\n",
+                                        static_cast<unsigned>(record.status),
+                                        static_cast<unsigned long long>(record.body_size),
+                                        static_cast<long long>(record.duration.count()));
+    out.append(tail_buf, static_cast<size_t>(tail_size));
+}
+
+}  // namespace
+
+void Record::SetTarget(std::string_view value) noexcept {
+    target_size = static_cast<std::uint8_t>(std::min(value.size(), MAX_TARGET_SIZE));
+    std::copy_n(value.data(), target_size, target.data());
+}
+
+AccessLog::AccessLog(std::ostream& output, Options options)
+    : output_{output}
+    , options_{options}
+    , mask_{std::bit_ceil(std::max<size_t>(options.capacity, 2)) - 1}
+    , slots_{std::make_unique<Slot[]>(mask_ + 1)} {
+    options_.sample_rate = std::max(1u, options_.sample_rate);
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    if (options_.level != Level::NONE) {
+        writer_ = std::jthread{[this](std::stop_token stop) {
+            WriteLoop(stop);
+        }};
+    }
+}
+
+AccessLog::~AccessLog() {
+    if (writer_.joinable()) {
+        writer_.request_stop();
+        writer_.join();
+    }
+}
+
+bool AccessLog::ShouldLog(http::status status) const noexcept {
+    if (options_.level == Level::NONE) {
+        return false;
+    }
+    if (static_cast<unsigned>(status) >= 400) {
+        return true;
+    }
+    if (options_.level == Level::ERRORS) {
+        return false;
+    }
+    // Счётчик у каждого потока свой, поэтому прореживание не требует синхронизации
+    thread_local unsigned counter = 0;
+    return ++counter % options_.sample_rate == 0;
+}
+
+// Ограниченная очередь Дмитрия Вьюкова: номер в sequence сообщает, свободна ли ячейка
+// для записи с позицией pos (sequence == pos) или уже заполнена (sequence == pos + 1)
+void AccessLog::Push(const Record& record) noexcept {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots_[pos & mask_];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // Кольцо заполнено: фоновый поток не успевает за рабочими
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Записи забирает только фоновый поток, поэтому позицию чтения можно менять без CAS
+bool AccessLog::TryPop(Record& record) noexcept {
+    const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & mask_];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != pos + 1) {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void AccessLog::WriteLoop(std::stop_token stop) {
+    std::string buffer;
+    Record record;
+    while (true) {
+        // Флаг проверяем до опустошения кольца, чтобы не потерять записи,
+        // добавленные перед остановкой
+        const bool stopping = stop.stop_requested();
+        size_t count = 0;
+        while (count < MAX_BATCH_SIZE && TryPop(record)) {
+            FormatRecord(buffer, record);
+            ++count;
+        }
+        if (const auto dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+            buffer.append("access log: "sv)
+                .append(std::to_string(dropped))
+                .append(" records dropped\n"sv);
+        }
+        if (!buffer.empty()) {
+            output_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            output_.flush();
+            buffer.clear();
+        }
+        if (count == 0) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(IDLE_INTERVAL);
+        }
+    }
+}
+
+}  // namespace access_log
@@ -0,0 +1,101 @@
+#pragma once
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/beast/http/status.hpp>
+#include <boost/beast/http/verb.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+namespace access_log {
+
+namespace http = boost::beast::http;
+
+// Какие запросы попадают в журнал
+enum class Level {
+    NONE,    // журнал отключён
+    ERRORS,  // только ответы с кодом 4xx и 5xx
+    ALL,     // все запросы с учётом прореживания
+};
+
+// Компактная запись о запросе. Форматируется в текст только фоновым потоком
+struct Record {
+    constexpr static size_t MAX_TARGET_SIZE = 80;
+
+    std::chrono::system_clock::time_point time;
+    std::chrono::microseconds duration{};
+    std::uint64_t body_size = 0;
+    http::verb method = http::verb::unknown;
+    http::status status = http::status::unknown;
+    std::uint8_t target_size = 0;
+    // Цель запроса, обрезанная до MAX_TARGET_SIZE символов
+    std::array<char, MAX_TARGET_SIZE> target;
+
+    void SetTarget(std::string_view value) noexcept;
+    std::string_view GetTarget() const noexcept {
+        return {target.data(), target_size};
+    }
+};
+
+/*
+ * Асинхронный журнал доступа.
+ * Рабочие потоки помещают записи в ограниченное кольцо без блокировок, а фоновый поток
+ * забирает их, форматирует и пишет в поток вывода пачками, сбрасывая буфер один раз на пачку.
+ * Если кольцо переполнено, запись отбрасывается: обработка запроса никогда не ждёт вывода.
+ * Количество отброшенных записей периодически выводится в журнал.
+ */
+class AccessLog {
+public:
+    struct Options {
+        Level level = Level::ALL;
+        // В журнал попадает каждый sample_rate-й успешный запрос потока.
+        // Ответы с ошибками при level != NONE записываются всегда
+        unsigned sample_rate = 1;
+        // Количество записей в кольце, округляется вверх до степени двойки
+        size_t capacity = 8192;
+    };
+
+    // Поток output должен существовать, пока существует журнал
+    AccessLog(std::ostream& output, Options options);
+
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
+
+    // Дожидается записи всех принятых записей
+    ~AccessLog();
+
+    // Сообщает, нужно ли записывать ответ с кодом status. Вызывается до заполнения записи,
+    // чтобы не тратить время на записи, которые будут отброшены
+    bool ShouldLog(http::status status) const noexcept;
+
+    // Помещает запись в кольцо. Может быть вызван из любого потока
+    void Push(const Record& record) noexcept;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    bool TryPop(Record& record) noexcept;
+    void WriteLoop(std::stop_token stop);
+
+    std::ostream& output_;
+    Options options_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // Индексы записи и чтения находятся в разных кэш-линиях, чтобы производители
+    // и потребитель не мешали друг другу
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::jthread writer_;
+};
+
+}  // namespace access_log
@@ -7,9 +7,21 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <thread>
 #include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "access_log.h"
+#include "request_target.h"
 
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
@@ -22,25 +34,140 @@ using StringRequest = http::request<http::string_body>;
 // Ответ, тело которого представлено в виде строки
 using StringResponse = http::response<http::string_body>; 
 
-std::optional<StringRequest> ReadRequest(tcp::socket& socket, beast::flat_buffer& buffer) {
-    beast::error_code ec;
-    StringRequest req;
-    http::read(socket, buffer, req, ec);
+// Заголовки Date и Server, общие для всех ответов, в сериализованном виде.
+// Каждый поток форматирует их не чаще раза в секунду и не обращается к общим данным
+const std::string& GetCommonHeaders() {
+    thread_local std::time_t second = -1;
+    thread_local std::string headers;
+    if (const std::time_t now = std::time(nullptr); now != second) {
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+        char date[32];
+        const size_t size = std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        headers.assign("Date: "sv).append(date, size).append("\r\nServer: hello\r\n"sv);
+        second = now;
+    }
+    return headers;
+}
+
+/*
+ * Ответы на запросы, которые клиент прислал подряд, не дожидаясь ответов (pipelining).
+ * Накопленные ответы записываются в сокет одним вызовом из нескольких буферов,
+ * а не отдельным вызовом и TCP-сегментом на каждый ответ.
+ * Запись в журнал доступа выполняется после отправки ответа
+ */
+class ResponseBatch {
+public:
+    // Ограничивает объём памяти, занятой ответами, которые ещё не отправлены
+    constexpr static size_t MAX_RESPONSES = 16;
+
+    void Add(StringResponse&& response, const access_log::Record& record,
+             std::chrono::steady_clock::time_point start) {
+        std::ostringstream out;
+        out << response.base();
+        // Общие заголовки вставляются сразу за строкой статуса
+        std::string head = std::move(out).str();
+        head.insert(head.find("\r\n"sv) + 2, GetCommonHeaders());
+        entries_.push_back({std::move(head), std::move(response), record, start});
+    }
+
+    bool IsFull() const noexcept {
+        return entries_.size() >= MAX_RESPONSES;
+    }
+
+    void Flush(tcp::socket& socket, access_log::AccessLog& log) {
+        if (entries_.empty()) {
+            return;
+        }
+        std::vector<net::const_buffer> buffers;
+        buffers.reserve(entries_.size() * 2);
+        for (const auto& entry : entries_) {
+            buffers.push_back(net::buffer(entry.head));
+            if (!entry.response.body().empty()) {
+                buffers.push_back(net::buffer(entry.response.body()));
+            }
+        }
+        net::write(socket, buffers);
+
+        const auto end = std::chrono::steady_clock::now();
+        for (auto& entry : entries_) {
+            if (log.ShouldLog(entry.response.result())) {
+                entry.record.time = std::chrono::system_clock::now();
+                entry.record.duration =
+                    std::chrono::duration_cast<std::chrono::microseconds>(end - entry.start);
+                entry.record.status = entry.response.result();
+                entry.record.body_size = entry.response.body().size();
+                log.Push(entry.record);
+            }
+        }
+        entries_.clear();
+    }
+
+private:
+    struct Entry {
+        std::string head;
+        StringResponse response;
+        access_log::Record record;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::vector<Entry> entries_;
+};
+
+// Максимальный размер тела запроса. Сервер обслуживает только GET и HEAD,
+// поэтому тело запросу не нужно
+constexpr std::uint64_t MAX_BODY_SIZE = 0;
 
+// Отвечает клиенту, что тело запроса превышает допустимый размер. Ответ отправляется
+// после ответов на предыдущие запросы. Непрочитанное тело остаётся в сокете,
+// поэтому после ответа соединение закрывается
+void RejectBody(const http::request_header<>& header, ResponseBatch& batch) {
+    StringResponse response(http::status::payload_too_large, header.version());
+    response.set(http::field::content_type, "text/html"sv);
+    response.body() = "Request body is too large"sv;
+    response.content_length(response.body().size());
+    response.keep_alive(false);
+    access_log::Record record;
+    record.method = header.method();
+    record.SetTarget(header.target());
+    batch.Add(std::move(response), record, std::chrono::steady_clock::now());
+}
+
+// Читает запрос в два этапа: сначала заголовок, затем тело. Тело, превышающее
+// MAX_BODY_SIZE, не читается, поэтому клиент не может заставить сервер буферизовать
+// большие данные. Возвращает nullopt, если соединение нужно закрыть
+std::optional<StringRequest> ReadRequest(tcp::socket& socket, beast::flat_buffer& buffer,
+                                         ResponseBatch& batch) {
+    beast::error_code ec;
+    http::request_parser<http::string_body> parser;
+    // Размер тела проверяется после чтения заголовка, а не во время его разбора
+    parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+    http::read_header(socket, buffer, parser, ec);
     if (ec == http::error::end_of_stream) {
         return std::nullopt;
     }
     if (ec) {
         throw std::runtime_error("Failed to read request: "s.append(ec.message()));
     }
-    return req;
-}
 
-void DumpRequest(const StringRequest& req) {
-    std::cout << req.method_string() << ' ' << req.target() << std::endl;
-    for (const auto& header : req) {
-        std::cout << "  "sv << header.name_string() << ": "sv << header.value() << std::endl;
+    if (const auto content_length = parser.content_length();
+        content_length && *content_length > MAX_BODY_SIZE) {
+        RejectBody(parser.get().base(), batch);
+        return std::nullopt;
+    }
+    // Тело неизвестной заранее длины (chunked) ограничивается по мере чтения
+    parser.body_limit(MAX_BODY_SIZE);
+    if (!parser.is_done()) {
+        http::read(socket, buffer, parser, ec);
+    }
+    if (ec == http::error::body_limit) {
+        RejectBody(parser.get().base(), batch);
+        return std::nullopt;
+    }
+    if (ec) {
+        throw std::runtime_error("Failed to read request: "s.append(ec.message()));
     }
+    return parser.release();
 }
 
 // Структура ContentType задаёт область видимости для констант,
@@ -50,6 +177,13 @@ struct ContentType {
     constexpr static std::string_view TEXT_HTML = "text/html"sv;
 };
 
+// Прочитан ли уже заголовок следующего запроса. Тогда ответ на текущий запрос
+// можно отложить и отправить вместе с ответом на следующий
+bool HasPipelinedRequest(const beast::flat_buffer& buffer) {
+    const std::string_view data{static_cast<const char*>(buffer.data().data()), buffer.size()};
+    return data.find("\r\n\r\n"sv) != std::string_view::npos;
+}
+
 // Создаёт StringResponse с заданными параметрами
 StringResponse MakeStringResponse(http::status status, std::string_view body, unsigned http_version,
                                   bool keep_alive,
@@ -62,27 +196,37 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
     return response;
 }
 
+// Возвращает имя из цели запроса вида /<имя>, не копируя строку запроса.
+// Имя декодируется в storage, только если содержит %-последовательности
+std::string_view GetName(std::string_view target, std::string& storage) {
+    // Удаляем ведущий символ '/', если он есть
+    const http_server::EncodedView name{target.substr(target.starts_with('/') ? 1 : 0)};
+    try {
+        return name.Decode(storage);
+    } catch (const std::invalid_argument&) {
+        // Некорректно закодированное имя возвращаем как есть
+        return name.Raw();
+    }
+}
+
 StringResponse HandleRequest(StringRequest&& req) {
     // Обработка GET-запроса
     if (req.method() == http::verb::get) {
-        std::string target(req.target());
-        // Удаляем ведущий символ '/', если он есть
-        if (!target.empty() && target[0] == '/') {
-            target = target.substr(1);
-        }
-        std::string body = "Hello, " + target;
+        std::string decoded_name;
+        const auto name = GetName(req.target(), decoded_name);
+        std::string body;
+        body.reserve("Hello, "sv.size() + name.size());
+        body.append("Hello, "sv).append(name);
         return MakeStringResponse(http::status::ok, body, req.version(), req.keep_alive());
     }
     // Обработка HEAD-запроса
     else if (req.method() == http::verb::head) {
-        std::string target(req.target());
-        if (!target.empty() && target[0] == '/') {
-            target = target.substr(1);
-        }
-        std::string body = "Hello, " + target;   // тело, которое вернулось бы в GET
+        std::string decoded_name;
+        // Тело не формируем: достаточно знать длину тела, которое вернулось бы в GET
+        const auto body_size = "Hello, "sv.size() + GetName(req.target(), decoded_name).size();
         StringResponse response(http::status::ok, req.version());
         response.set(http::field::content_type, ContentType::TEXT_HTML);
-        response.content_length(body.size());    // выставляем длину, хотя тело пустое
+        response.content_length(body_size);      // выставляем длину, хотя тело пустое
         response.keep_alive(req.keep_alive());
         return response;
     }
@@ -99,18 +243,33 @@ StringResponse HandleRequest(StringRequest&& req) {
 }
 
 template <typename RequestHandler>
-void HandleConnection(tcp::socket& socket, RequestHandler&& handle_request) {
+void HandleConnection(tcp::socket& socket, RequestHandler&& handle_request,
+                      access_log::AccessLog& log) {
     try {
         beast::flat_buffer buffer;
+        ResponseBatch batch;
+
+        while (auto request = ReadRequest(socket, buffer, batch)) {
+            const auto start = std::chrono::steady_clock::now();
+            // Метод и цель запроса сохраняем до того, как запрос будет перемещён в обработчик
+            access_log::Record record;
+            record.method = request->method();
+            record.SetTarget(request->target());
 
-        while (auto request = ReadRequest(socket, buffer)) {
-            DumpRequest(*request);
             StringResponse response = handle_request(*std::move(request));
-            http::write(socket, response);
-            if (response.need_eof()) {
+            const bool need_eof = response.need_eof();
+            batch.Add(std::move(response), record, start);
+            // Ответы копятся, пока следующий запрос уже прочитан. Иначе клиент ждёт ответа,
+            // и чтение следующего запроса заблокировалось бы
+            if (need_eof || batch.IsFull() || !HasPipelinedRequest(buffer)) {
+                batch.Flush(socket, log);
+            }
+            if (need_eof) {
                 break;
             }
         }
+        // Ответ, которым отклонён последний запрос
+        batch.Flush(socket, log);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
@@ -118,23 +277,191 @@ void HandleConnection(tcp::socket& socket, RequestHandler&& handle_request) {
     socket.shutdown(tcp::socket::shutdown_send, ec);
 }
 
-int main() {
+// Поведение сервера, когда очередь соединений заполнена
+enum class OverloadPolicy {
+    REJECT,  // ответить 503 Service Unavailable и закрыть соединение
+    REFUSE,  // закрыть соединение, не отвечая
+};
+
+/*
+ * Пул рабочих потоков с ограниченной очередью принятых соединений.
+ * Количество потоков и объём очереди фиксированы, поэтому всплеск подключений
+ * не приводит к неограниченному росту числа потоков и потребляемой памяти.
+ */
+class ConnectionPool {
+public:
+    template <typename ConnectionHandler>
+    ConnectionPool(unsigned num_workers, size_t max_queue_size, ConnectionHandler handler)
+        : max_queue_size_{max_queue_size} {
+        num_workers = std::max(1u, num_workers);
+        workers_.reserve(num_workers);
+        for (unsigned i = 0; i < num_workers; ++i) {
+            workers_.emplace_back([this, handler] {
+                while (auto socket = Pop()) {
+                    handler(*socket);
+                }
+            });
+        }
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    ~ConnectionPool() {
+        {
+            std::lock_guard lk{mutex_};
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        // Деструкторы std::jthread дождутся завершения рабочих потоков
+    }
+
+    // Ставит соединение в очередь. Если очередь заполнена, возвращает false, а сокет остаётся
+    // у вызывающей стороны
+    bool TryPush(tcp::socket& socket) {
+        {
+            std::lock_guard lk{mutex_};
+            if (queue_.size() >= max_queue_size_) {
+                return false;
+            }
+            queue_.emplace_back(std::move(socket));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+private:
+    std::optional<tcp::socket> Pop() {
+        std::unique_lock lk{mutex_};
+        cv_.wait(lk, [this] {
+            return stopped_ || !queue_.empty();
+        });
+        if (queue_.empty()) {
+            return std::nullopt;
+        }
+        tcp::socket socket = std::move(queue_.front());
+        queue_.pop_front();
+        return socket;
+    }
+
+    size_t max_queue_size_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<tcp::socket> queue_;
+    bool stopped_ = false;
+    std::vector<std::jthread> workers_;
+};
+
+// Быстро отказывает клиенту, не занимая рабочий поток
+void RejectConnection(tcp::socket& socket, OverloadPolicy policy) {
+    beast::error_code ec;
+    if (policy == OverloadPolicy::REJECT) {
+        // Ответ не зависит от запроса, поэтому сериализуем его один раз
+        static const std::string response = [] {
+            StringResponse res = MakeStringResponse(http::status::service_unavailable,
+                                                    "Server is overloaded"sv, 11, false);
+            res.set(http::field::retry_after, "1"sv);
+            std::ostringstream out;
+            out << res;
+            return out.str();
+        }();
+        net::write(socket, net::buffer(response), ec);
+        socket.shutdown(tcp::socket::shutdown_send, ec);
+    }
+    socket.close(ec);
+}
+
+struct ServerArgs {
+    // 0 - по одному потоку на соединение (режим по умолчанию)
+    unsigned num_workers = 0;
+    size_t max_queue_size = 1024;
+    int backlog = net::socket_base::max_listen_connections;
+    OverloadPolicy overload_policy = OverloadPolicy::REJECT;
+    access_log::AccessLog::Options access_log;
+};
+
+std::optional<ServerArgs> ParseCommandLine(int argc, const char* const argv[]) {
+    ServerArgs args;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--workers"sv) {
+                args.num_workers = static_cast<unsigned>(std::stoul(value));
+            } else if (arg == "--queue-size"sv) {
+                args.max_queue_size = std::stoul(value);
+            } else if (arg == "--backlog"sv) {
+                args.backlog = std::stoi(value);
+            } else if (arg == "--on-overload"sv && value == "reject"sv) {
+                args.overload_policy = OverloadPolicy::REJECT;
+            } else if (arg == "--on-overload"sv && value == "refuse"sv) {
+                args.overload_policy = OverloadPolicy::REFUSE;
+            } else if (arg == "--access-log"sv && value == "none"sv) {
+                args.access_log.level = access_log::Level::NONE;
+            } else if (arg == "--access-log"sv && value == "errors"sv) {
+                args.access_log.level = access_log::Level::ERRORS;
+            } else if (arg == "--access-log"sv && value == "all"sv) {
+                args.access_log.level = access_log::Level::ALL;
+            } else if (arg == "--log-sample"sv) {
+                args.access_log.sample_rate = static_cast<unsigned>(std::stoul(value));
+            } else {
+                return std::nullopt;
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    return args;
+}
+
+int main(int argc, const char* argv[]) {
+    const auto args = ParseCommandLine(argc, argv);
+    if (!args) {
+        std::cerr << "Usage: hello [--workers <n>] [--queue-size <n>] [--backlog <n>] "sv
+                  << "[--on-overload reject|refuse] [--access-log none|errors|all] "sv
+                  << "[--log-sample <n>]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    access_log::AccessLog log{std::cout, args->access_log};
     net::io_context ioc;
-    
+
     const auto address = net::ip::make_address("0.0.0.0");
     constexpr unsigned short port = 8080;
 
-    tcp::acceptor acceptor(ioc, {address, port});
+    tcp::acceptor acceptor(ioc);
+    const tcp::endpoint endpoint{address, port};
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(net::socket_base::reuse_address(true));
+    acceptor.bind(endpoint);
+    // Длина очереди ещё не принятых соединений ограничивает нагрузку на уровне ядра
+    acceptor.listen(args->backlog);
     std::cout << "Server has started..."sv << std::endl;
 
+    if (args->num_workers == 0) {
+        while (true) {
+            tcp::socket socket(ioc);
+            acceptor.accept(socket);
+            std::thread t(
+                [&log](tcp::socket socket) {
+                    HandleConnection(socket, HandleRequest, log);
+                },
+                std::move(socket));
+            t.detach();
+        }
+    }
+
+    ConnectionPool pool{args->num_workers, args->max_queue_size, [&log](tcp::socket& socket) {
+                            HandleConnection(socket, HandleRequest, log);
+                        }};
     while (true) {
         tcp::socket socket(ioc);
         acceptor.accept(socket);
-        std::thread t(
-            [](tcp::socket socket) {
-                HandleConnection(socket, HandleRequest);
-            },
-            std::move(socket));
-        t.detach();
-    }
-}
\ No newline at end of file
+        if (!pool.TryPush(socket)) {
+            RejectConnection(socket, args->overload_policy);
+        }
+    }
+}
@@ -0,0 +1,266 @@
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using net::ip::tcp;
+
+using namespace std::literals;
+
+namespace {
+
+constexpr unsigned short PORT = 3333;
+constexpr std::string_view REPLY = "Hello, I'm server!\n"sv;
+
+/*
+Пул буферов, общий для всех соединений. Буфер, возвращённый закрытым соединением,
+сохраняет выделенную память и достаётся следующему, поэтому при постоянном потоке
+подключений память почти не выделяется
+*/
+class BufferPool {
+public:
+    using Buffer = std::vector<char>;
+
+    BufferPool(size_t buffer_size, size_t max_free)
+        : buffer_size_{buffer_size}
+        , max_free_{max_free} {
+    }
+
+    Buffer Acquire() {
+        {
+            std::lock_guard lock{mutex_};
+            if (!free_.empty()) {
+                Buffer buffer = std::move(free_.back());
+                free_.pop_back();
+                return buffer;
+            }
+        }
+        Buffer buffer;
+        buffer.reserve(buffer_size_);
+        return buffer;
+    }
+
+    void Release(Buffer&& buffer) {
+        buffer.clear();
+        std::lock_guard lock{mutex_};
+        if (free_.size() < max_free_) {
+            free_.push_back(std::move(buffer));
+        }
+    }
+
+    size_t GetBufferSize() const noexcept {
+        return buffer_size_;
+    }
+
+private:
+    const size_t buffer_size_;
+    const size_t max_free_;
+    std::mutex mutex_;
+    std::vector<Buffer> free_;
+};
+
+struct Statistics {
+    std::atomic<size_t> connections = 0;
+    std::atomic<size_t> lines = 0;
+};
+
+/*
+Соединение с клиентом. Клиент присылает строки, оканчивающиеся '\n', и на каждую получает ответ.
+Ответы на все строки, прочитанные одним вызовом, и накопленные, пока идёт запись, отправляются
+одной операцией записи. Все обработчики соединения выполняются в его strand
+*/
+class Session : public std::enable_shared_from_this<Session> {
+public:
+    // Сколько ответов может ждать отправки, прежде чем чтение приостановится
+    static constexpr size_t MAX_PENDING_OUTPUT = 64 * 1024;
+
+    Session(tcp::socket&& socket, BufferPool& pool, Statistics& stats)
+        : socket_{std::move(socket)}
+        , pool_{pool}
+        , stats_{stats}
+        , input_{pool.Acquire()}
+        , pending_{pool.Acquire()}
+        , writing_{pool.Acquire()} {
+        input_.resize(pool.GetBufferSize());
+        ++stats_.connections;
+    }
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    ~Session() {
+        pool_.Release(std::move(input_));
+        pool_.Release(std::move(pending_));
+        pool_.Release(std::move(writing_));
+        --stats_.connections;
+    }
+
+    void Start() {
+        net::dispatch(socket_.get_executor(), [self = shared_from_this()] {
+            self->Read();
+        });
+    }
+
+private:
+    void Read() {
+        reading_ = true;
+        socket_.async_read_some(net::buffer(input_.data() + used_, input_.size() - used_),
+                                [self = shared_from_this()](sys::error_code ec, size_t bytes_read) {
+                                    self->OnRead(ec, bytes_read);
+                                });
+    }
+
+    void OnRead(sys::error_code ec, size_t bytes_read) {
+        reading_ = false;
+        if (ec) {
+            // Соединение закрывается, когда завершатся все его операции
+            return;
+        }
+        used_ += bytes_read;
+
+        size_t line_begin = 0;
+        for (;;) {
+            const auto line_end = std::find(input_.begin() + line_begin, input_.begin() + used_, '\n');
+            if (line_end == input_.begin() + used_) {
+                break;
+            }
+            pending_.insert(pending_.end(), REPLY.begin(), REPLY.end());
+            line_begin = static_cast<size_t>(line_end - input_.begin()) + 1;
+            ++stats_.lines;
+        }
+        // Неполная строка переносится в начало буфера и дочитывается следующим вызовом
+        std::copy(input_.begin() + line_begin, input_.begin() + used_, input_.begin());
+        used_ -= line_begin;
+        if (used_ == input_.size()) {
+            std::cerr << "Line is too long, closing connection"sv << std::endl;
+            return;
+        }
+
+        Write();
+        if (pending_.size() < MAX_PENDING_OUTPUT) {
+            Read();
+        }
+    }
+
+    void Write() {
+        if (writing_in_progress_ || pending_.empty()) {
+            return;
+        }
+        writing_in_progress_ = true;
+        std::swap(pending_, writing_);
+        net::async_write(socket_, net::buffer(writing_), [self = shared_from_this()](sys::error_code ec, size_t) {
+            self->OnWrite(ec);
+        });
+    }
+
+    void OnWrite(sys::error_code ec) {
+        writing_in_progress_ = false;
+        writing_.clear();
+        if (ec) {
+            return;
+        }
+        Write();
+        // Чтение было приостановлено из-за переполнения очереди ответов
+        if (!reading_ && pending_.size() < MAX_PENDING_OUTPUT) {
+            Read();
+        }
+    }
+
+    tcp::socket socket_;
+    BufferPool& pool_;
+    Statistics& stats_;
+    BufferPool::Buffer input_;
+    size_t used_ = 0;
+    // Ответы, которые ещё не отправлялись, и ответы, которые отправляются сейчас
+    BufferPool::Buffer pending_;
+    BufferPool::Buffer writing_;
+    bool reading_ = false;
+    bool writing_in_progress_ = false;
+};
+
+class Server {
+public:
+    Server(net::io_context& io, unsigned short port, BufferPool& pool)
+        : io_{io}
+        , acceptor_{net::make_strand(io), tcp::endpoint(tcp::v4(), port)}
+        , pool_{pool}
+        , timer_{io} {
+    }
+
+    void Start() {
+        Accept();
+        ReportStatistics();
+    }
+
+private:
+    void Accept() {
+        // Каждое соединение получает свой strand, так что разные соединения обслуживаются параллельно
+        acceptor_.async_accept(net::make_strand(io_), [this](sys::error_code ec, tcp::socket socket) {
+            if (ec) {
+                std::cerr << "Accept error: "sv << ec.message() << std::endl;
+            } else {
+                socket.set_option(tcp::no_delay(true));
+                std::make_shared<Session>(std::move(socket), pool_, stats_)->Start();
+            }
+            Accept();
+        });
+    }
+
+    // Вместо вывода каждой строки раз в секунду выводим, сколько строк обработано за секунду
+    void ReportStatistics() {
+        timer_.expires_after(1s);
+        timer_.async_wait([this](sys::error_code ec) {
+            if (ec) {
+                return;
+            }
+            if (const size_t lines = stats_.lines.exchange(0); lines != 0) {
+                std::cout << "Clients: "sv << stats_.connections << ", lines: "sv << lines << "/s"sv
+                          << std::endl;
+            }
+            ReportStatistics();
+        });
+    }
+
+    net::io_context& io_;
+    tcp::acceptor acceptor_;
+    BufferPool& pool_;
+    Statistics stats_;
+    net::steady_timer timer_;
+};
+
+}  // namespace
+
+int main() {
+    static const size_t buffer_size = 16 * 1024;
+    static const size_t max_free_buffers = 1024;
+
+    try {
+        const unsigned num_threads = std::max(1u, std::thread::hardware_concurrency());
+        net::io_context io_context{static_cast<int>(num_threads)};
+
+        BufferPool pool{buffer_size, max_free_buffers};
+        Server server{io_context, PORT, pool};
+        server.Start();
+        std::cout << "Listening on TCP port "sv << PORT << " with "sv << num_threads << " threads"sv
+                  << std::endl;
+
+        std::vector<std::jthread> workers;
+        workers.reserve(num_threads - 1);
+        for (unsigned i = 1; i < num_threads; ++i) {
+            workers.emplace_back([&io_context] {
+                io_context.run();
+            });
+        }
+        io_context.run();
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,209 @@
+#include <boost/asio.hpp>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#endif
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using net::ip::udp;
+
+using namespace std::literals;
+
+namespace {
+
+constexpr unsigned short PORT = 3333;
+constexpr size_t MAX_BUFFER_SIZE = 1024;
+constexpr std::string_view REPLY = "Hello from UDP-server"sv;
+
+// Вместо вывода каждой датаграммы раз в секунду выводим, сколько их обработано за секунду
+class Statistics {
+public:
+    explicit Statistics(net::io_context& io)
+        : timer_{io} {
+    }
+
+    void Start() {
+        timer_.expires_after(1s);
+        timer_.async_wait([this](sys::error_code ec) {
+            if (ec) {
+                return;
+            }
+            if (received_ != 0) {
+                std::cout << "Received "sv << received_ << ", replied "sv << replied_ << ", dropped "sv
+                          << received_ - replied_ << " datagrams/s"sv << std::endl;
+            }
+            received_ = replied_ = 0;
+            Start();
+        });
+    }
+
+    void OnBatch(size_t received, size_t replied) noexcept {
+        received_ += received;
+        replied_ += replied;
+    }
+
+private:
+    net::steady_timer timer_;
+    size_t received_ = 0;
+    size_t replied_ = 0;
+};
+
+#if defined(__linux__)
+
+/*
+Принимает и отправляет датаграммы пачками: один вызов recvmmsg/sendmmsg обслуживает до
+BATCH_SIZE датаграмм. Буферы, адреса клиентов и заголовки сообщений выделены заранее и
+переиспользуются. Asio сообщает о готовности сокета к чтению (async_wait), а читаем мы сами
+*/
+class UdpServer {
+public:
+    static constexpr size_t BATCH_SIZE = 64;
+    // Сколько пачек прочитать подряд, прежде чем дать выполниться другим обработчикам
+    static constexpr int MAX_BATCHES_PER_WAKEUP = 16;
+
+    UdpServer(net::io_context& io, unsigned short port)
+        : socket_{io, udp::endpoint(udp::v4(), port)}
+        , stats_{io} {
+        socket_.non_blocking(true);
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            recv_iov_[i] = {buffers_[i].data(), buffers_[i].size()};
+            recv_msgs_[i].msg_hdr.msg_iov = &recv_iov_[i];
+            recv_msgs_[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs_[i].msg_hdr.msg_name = &addresses_[i];
+
+            // Ответ один и тот же, поэтому все отправляемые сообщения ссылаются на него
+            send_iov_[i] = {const_cast<char*>(REPLY.data()), REPLY.size()};
+            send_msgs_[i].msg_hdr.msg_iov = &send_iov_[i];
+            send_msgs_[i].msg_hdr.msg_iovlen = 1;
+            send_msgs_[i].msg_hdr.msg_name = &addresses_[i];
+        }
+    }
+
+    void Start() {
+        stats_.Start();
+        WaitForDatagrams();
+    }
+
+private:
+    void WaitForDatagrams() {
+        socket_.async_wait(udp::socket::wait_read, [this](sys::error_code ec) {
+            if (ec) {
+                std::cerr << "Wait error: "sv << ec.message() << std::endl;
+                return;
+            }
+            ReceiveBatches();
+            WaitForDatagrams();
+        });
+    }
+
+    void ReceiveBatches() {
+        for (int batch = 0; batch < MAX_BATCHES_PER_WAKEUP; ++batch) {
+            for (auto& msg : recv_msgs_) {
+                msg.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+            }
+            const int received = recvmmsg(socket_.native_handle(), recv_msgs_.data(), BATCH_SIZE,
+                                          MSG_DONTWAIT, nullptr);
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    std::cerr << "recvmmsg error: "sv << std::strerror(errno) << std::endl;
+                }
+                return;
+            }
+            Reply(static_cast<size_t>(received));
+            if (static_cast<size_t>(received) < BATCH_SIZE) {
+                return;
+            }
+        }
+    }
+
+    void Reply(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            send_msgs_[i].msg_hdr.msg_namelen = recv_msgs_[i].msg_hdr.msg_namelen;
+        }
+        size_t sent = 0;
+        while (sent < count) {
+            const int result = sendmmsg(socket_.native_handle(), send_msgs_.data() + sent,
+                                        static_cast<unsigned>(count - sent), MSG_DONTWAIT);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Буфер отправки переполнен: UDP не гарантирует доставку, оставшиеся ответы теряются
+                break;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        stats_.OnBatch(count, sent);
+    }
+
+    udp::socket socket_;
+    Statistics stats_;
+    std::array<std::array<char, MAX_BUFFER_SIZE>, BATCH_SIZE> buffers_;
+    std::array<sockaddr_storage, BATCH_SIZE> addresses_{};
+    std::array<iovec, BATCH_SIZE> recv_iov_{};
+    std::array<iovec, BATCH_SIZE> send_iov_{};
+    std::array<mmsghdr, BATCH_SIZE> recv_msgs_{};
+    std::array<mmsghdr, BATCH_SIZE> send_msgs_{};
+};
+
+#else
+
+// Без recvmmsg/sendmmsg датаграммы принимаются по одной, но без блокирующего цикла
+class UdpServer {
+public:
+    UdpServer(net::io_context& io, unsigned short port)
+        : socket_{io, udp::endpoint(udp::v4(), port)}
+        , stats_{io} {
+        socket_.non_blocking(true);
+    }
+
+    void Start() {
+        stats_.Start();
+        Receive();
+    }
+
+private:
+    void Receive() {
+        socket_.async_receive_from(net::buffer(buffer_), remote_endpoint_, [this](sys::error_code ec, size_t) {
+            if (ec) {
+                std::cerr << "Receive error: "sv << ec.message() << std::endl;
+                return;
+            }
+            // Сокет неблокирующий: если ответ не помещается в буфер отправки, он теряется
+            sys::error_code send_ec;
+            socket_.send_to(net::buffer(REPLY), remote_endpoint_, 0, send_ec);
+            stats_.OnBatch(1, send_ec ? 0 : 1);
+            Receive();
+        });
+    }
+
+    udp::socket socket_;
+    Statistics stats_;
+    std::array<char, MAX_BUFFER_SIZE> buffer_;
+    udp::endpoint remote_endpoint_;
+};
+
+#endif
+
+}  // namespace
+
+int main() {
+    try {
+        net::io_context io_context{1};
+
+        UdpServer server{io_context, PORT};
+        server.Start();
+        std::cout << "Listening on UDP port "sv << PORT << std::endl;
+
+        io_context.run();
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
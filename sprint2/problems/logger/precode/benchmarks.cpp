@@ -0,0 +1,108 @@
+#include <atomic>
+#include <barrier>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_harness.h"
+#include "my_logger.h"
+
+/*
+ * Замеры стоимости Log и LogFormat для пишущих потоков при разной конкуренции.
+ * Одна операция - каждый из потоков делает RECORDS_PER_THREAD записей. Потоки создаются
+ * заранее и ждут начала операции на барьере, поэтому их запуск в замер не попадает.
+ * Записи выводятся в обычные файлы журнала, время фонового потока не измеряется.
+ * Запуск: logger_benchmarks [параметры bench_harness.h] [наибольшее количество потоков]
+ */
+
+namespace {
+
+constexpr int RECORDS_PER_THREAD = 1000;
+
+// Порог модуля выше DEBUG, поэтому его отладочные записи пропускаются
+log_filter::Module bench_log{"bench"sv};
+
+// Потоки, одновременно выполняющие fn(thread_index) по команде Run
+template <typename Fn>
+class Writers {
+public:
+    Writers(unsigned count, Fn fn)
+        : start_(count + 1)
+        , done_(count + 1) {
+        threads_.reserve(count);
+        for (unsigned i = 0; i < count; ++i) {
+            threads_.emplace_back([this, i, fn] {
+                for (;;) {
+                    start_.arrive_and_wait();
+                    if (stop_.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    fn(i);
+                    done_.arrive_and_wait();
+                }
+            });
+        }
+    }
+
+    Writers(const Writers&) = delete;
+    Writers& operator=(const Writers&) = delete;
+
+    ~Writers() {
+        stop_.store(true, std::memory_order_relaxed);
+        start_.arrive_and_wait();
+    }
+
+    void Run() {
+        start_.arrive_and_wait();
+        done_.arrive_and_wait();
+    }
+
+private:
+    std::barrier<> start_;
+    std::barrier<> done_;
+    std::atomic<bool> stop_{false};
+    std::vector<std::jthread> threads_;
+};
+
+template <typename Fn>
+void RunContended(bench::Suite& suite, const std::string& name, unsigned threads, Fn fn) {
+    Writers writers{threads, fn};
+    suite.Run(name + "/"s + std::to_string(threads) + "x"s + std::to_string(RECORDS_PER_THREAD), [&] {
+        writers.Run();
+    });
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"logger", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const unsigned max_threads = options.positional.empty()
+                                     ? std::max(1u, std::thread::hardware_concurrency())
+                                     : std::stoul(options.positional[0]);
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        RunContended(suite, "Logger::Log"s, threads, [](unsigned thread) {
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i) {
+                LOG("Thread "sv, thread, ": attempt "sv, i, ". "sv, "I Love it"sv);
+            }
+        });
+        RunContended(suite, "Logger::LogFormat"s, threads, [](unsigned thread) {
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i) {
+                LOG_FMT("Thread {}: attempt {}. \"{}\"", thread, i, "I Love it"sv);
+            }
+        });
+        // Стоимость отключённой записи - одно чтение порога модуля
+        RunContended(suite, "LOG_DEBUG disabled"s, threads, [](unsigned thread) {
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i) {
+                LOG_DEBUG(bench_log, "Thread "sv, thread, ": attempt "sv, i, ". "sv, "I Love it"sv);
+            }
+        });
+        RunContended(suite, "LOG_RATE_LIMITED"s, threads, [](unsigned thread) {
+            for (int i = 0; i < RECORDS_PER_THREAD; ++i) {
+                LOG_RATE_LIMITED(INFO, bench_log, 100, "Thread "sv, thread, ": attempt "sv, i);
+            }
+        });
+    }
+    return suite.Finish();
+}
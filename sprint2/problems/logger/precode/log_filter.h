@@ -0,0 +1,207 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Наименьший уровень записей, попадающих в программу, например -DLOG_MIN_LEVEL=INFO.
+// Записи ниже него удаляются при компиляции вместе с вычислением аргументов
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL TRACE
+#endif
+
+namespace log_filter {
+
+using namespace std::literals;
+
+enum class LogLevel : std::uint8_t {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR,
+    // Порог, при котором модуль ничего не выводит
+    OFF,
+};
+
+constexpr LogLevel MIN_LEVEL = LogLevel::LOG_MIN_LEVEL;
+
+// Уровень модулей, для которых он не задан явно
+constexpr LogLevel DEFAULT_LEVEL = LogLevel::INFO;
+
+constexpr bool IsCompiledIn(LogLevel level) noexcept {
+    return level >= MIN_LEVEL && level != LogLevel::OFF;
+}
+
+constexpr std::string_view LEVEL_NAMES[] = {"trace"sv, "debug"sv, "info"sv,
+                                            "warning"sv, "error"sv, "off"sv};
+
+// Разбирает название уровня: "debug", "warning" и т.п.
+inline std::optional<LogLevel> ParseLevel(std::string_view name) {
+    for (size_t i = 0; i < std::size(LEVEL_NAMES); ++i) {
+        if (LEVEL_NAMES[i] == name) {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+/*
+ * Модуль программы со своим порогом вывода. Объявляется один раз на модуль
+ * и живёт до конца программы:
+ *   static log_filter::Module net_log{"net"sv};
+ *   LOG_DEBUG(net_log, "Accepted "sv, endpoint);
+ * Проверка порога - одно чтение атомарной переменной с memory_order_relaxed,
+ * поэтому отключённая запись не стоит ни форматирования, ни обращения к журналу.
+ * Порог меняется в любой момент через SetLevel или Configure
+ */
+class Module {
+public:
+    explicit Module(std::string_view name);
+
+    Module(const Module&) = delete;
+    Module& operator=(const Module&) = delete;
+
+    bool IsEnabled(LogLevel level) const noexcept {
+        return level >= threshold_.load(std::memory_order_relaxed);
+    }
+
+    std::string_view GetName() const noexcept {
+        return name_;
+    }
+
+private:
+    friend class Registry;
+
+    std::string name_;
+    std::atomic<LogLevel> threshold_{DEFAULT_LEVEL};
+};
+
+// Все модули программы и заданные для них пороги
+class Registry {
+public:
+    static Registry& GetInstance() {
+        static Registry obj;
+        return obj;
+    }
+
+    void Register(Module& module) {
+        std::lock_guard lock{mutex_};
+        modules_.push_back(&module);
+        module.threshold_.store(GetConfiguredLevel(module.GetName()), std::memory_order_relaxed);
+    }
+
+    // Задаёт порог модуля name, в том числе ещё не созданного. "*" - порог всех
+    // модулей, для которых он не задан по имени
+    void SetLevel(std::string_view name, LogLevel level) {
+        std::lock_guard lock{mutex_};
+        if (name == "*"sv) {
+            default_level_ = level;
+        } else {
+            levels_[std::string{name}] = level;
+        }
+        for (Module* module : modules_) {
+            module->threshold_.store(GetConfiguredLevel(module->GetName()),
+                                     std::memory_order_relaxed);
+        }
+    }
+
+    // Задаёт пороги строкой вида "*=warning,net=debug", например из переменной окружения.
+    // Возвращает false и ничего не меняет, если строка не разобрана
+    bool Configure(std::string_view spec) {
+        std::vector<std::pair<std::string_view, LogLevel>> levels;
+        while (!spec.empty()) {
+            const auto comma = std::min(spec.find(','), spec.size());
+            const auto item = spec.substr(0, comma);
+            spec.remove_prefix(std::min(comma + 1, spec.size()));
+            if (item.empty()) {
+                continue;
+            }
+            const auto eq = item.find('=');
+            if (eq == std::string_view::npos || eq == 0) {
+                return false;
+            }
+            const auto level = ParseLevel(item.substr(eq + 1));
+            if (!level) {
+                return false;
+            }
+            levels.emplace_back(item.substr(0, eq), *level);
+        }
+        for (const auto& [name, level] : levels) {
+            SetLevel(name, level);
+        }
+        return true;
+    }
+
+private:
+    Registry() = default;
+
+    LogLevel GetConfiguredLevel(std::string_view name) const {
+        const auto it = levels_.find(std::string{name});
+        return it != levels_.end() ? it->second : default_level_;
+    }
+
+    std::mutex mutex_;
+    std::vector<Module*> modules_;
+    std::unordered_map<std::string, LogLevel> levels_;
+    LogLevel default_level_ = DEFAULT_LEVEL;
+};
+
+inline Module::Module(std::string_view name)
+    : name_{name} {
+    Registry::GetInstance().Register(*this);
+}
+
+// Модуль записей, для которых модуль не указан (LOG, LOG_FMT)
+inline Module default_module{"default"sv};
+
+/*
+ * Ограничение частоты записей одного места программы: не больше limit записей
+ * за каждый интервал, остальные пропускаются и подсчитываются. Потокобезопасно
+ * и без блокировок, поэтому подходит для горячих циклов (см. LOG_RATE_LIMITED)
+ */
+class RateLimit {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    constexpr explicit RateLimit(std::uint32_t limit, Clock::duration interval = 1s) noexcept
+        : limit_{limit}
+        , interval_{interval.count()} {
+    }
+
+    // Можно ли вывести ещё одну запись. Если выводить можно, а в прошлых интервалах
+    // записи пропускались, их количество переносится в suppressed
+    bool Allow(std::uint64_t& suppressed) noexcept {
+        const auto now = Clock::now().time_since_epoch().count();
+        auto start = window_start_.load(std::memory_order_relaxed);
+        if (now - start >= interval_
+            && window_start_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            // Новый интервал начинает только один поток
+            const auto used = count_.exchange(0, std::memory_order_relaxed);
+            if (used > limit_) {
+                dropped_.fetch_add(used - limit_, std::memory_order_relaxed);
+            }
+        }
+        if (count_.fetch_add(1, std::memory_order_relaxed) >= limit_) {
+            return false;
+        }
+        suppressed = dropped_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::uint64_t limit_;
+    Clock::rep interval_;
+    std::atomic<Clock::rep> window_start_{0};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+}  // namespace log_filter
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace log_format {
+
+/*
+ * Строки формата с подстановками "{}", проверяемые при компиляции.
+ * Аргументы записи упаковываются в строку байтов без форматирования: числа копируются
+ * как есть, строки — длиной и содержимым. Разворачивает и форматирует их FormatPacked,
+ * обычно уже в фоновом потоке журнала.
+ * "{{" и "}}" выводят фигурные скобки
+ */
+
+// Строки хранятся в упакованных аргументах как string_view, остальные значения — как есть
+template <typename T>
+using Packed = std::conditional_t<std::is_convertible_v<const T&, std::string_view>,
+                                  std::string_view, std::remove_cvref_t<T>>;
+
+template <typename T>
+constexpr bool IS_SUPPORTED = std::is_same_v<Packed<T>, std::string_view>
+                              || std::is_arithmetic_v<Packed<T>>;
+
+namespace detail {
+
+// Вызов этой функции из consteval-конструктора делает ошибку в строке формата
+// ошибкой компиляции
+void FormatError(const char* message);
+
+// Количество подстановок в строке формата или -1, если скобки не парны
+constexpr int CountPlaceholders(std::string_view fmt) noexcept {
+    int count = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        if (fmt[i] != '{' && fmt[i] != '}') {
+            continue;
+        }
+        if (i + 1 == fmt.size()) {
+            return -1;
+        }
+        if (fmt[i] == '{' && fmt[i + 1] == '}') {
+            ++count;
+        } else if (fmt[i] != fmt[i + 1]) {
+            return -1;
+        }
+        ++i;
+    }
+    return count;
+}
+
+}  // namespace detail
+
+template <typename... Ts>
+class FormatString {
+public:
+    template <typename S>
+        requires std::is_convertible_v<const S&, std::string_view>
+    consteval FormatString(const S& str)
+        : str_{str} {
+        if (detail::CountPlaceholders(str_) < 0) {
+            detail::FormatError("unmatched brace in log format string");
+        }
+        if (detail::CountPlaceholders(str_) != sizeof...(Ts)) {
+            detail::FormatError("log format string does not match the number of arguments");
+        }
+        if (!(IS_SUPPORTED<Ts> && ...)) {
+            detail::FormatError("only strings and arithmetic values can be logged with a format");
+        }
+    }
+
+    std::string_view Get() const noexcept {
+        return str_;
+    }
+
+private:
+    std::string_view str_;
+};
+
+template <typename T>
+size_t GetPackedSize(const T& value) noexcept {
+    if constexpr (std::is_same_v<Packed<T>, std::string_view>) {
+        return sizeof(size_t) + std::string_view{value}.size();
+    } else {
+        return sizeof(Packed<T>);
+    }
+}
+
+template <typename T>
+void Pack(std::string& buffer, const T& value) {
+    if constexpr (std::is_same_v<Packed<T>, std::string_view>) {
+        const std::string_view str{value};
+        const size_t size = str.size();
+        buffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        buffer.append(str);
+    } else {
+        const Packed<T> packed = value;
+        buffer.append(reinterpret_cast<const char*>(&packed), sizeof(packed));
+    }
+}
+
+// Извлекает значение из начала args. Строка ссылается на байты внутри args
+template <typename T>
+T Unpack(std::string_view& args) noexcept {
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        size_t size;
+        std::memcpy(&size, args.data(), sizeof(size));
+        const std::string_view str = args.substr(sizeof(size), size);
+        args.remove_prefix(sizeof(size) + size);
+        return str;
+    } else {
+        T value;
+        std::memcpy(&value, args.data(), sizeof(value));
+        args.remove_prefix(sizeof(value));
+        return value;
+    }
+}
+
+inline void AppendValue(std::string& out, std::string_view value) {
+    out.append(value);
+}
+
+template <typename T>
+    requires std::is_arithmetic_v<T>
+void AppendValue(std::string& out, T value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out.append(value ? "true" : "false");
+    } else if constexpr (std::is_same_v<T, char>) {
+        out.push_back(value);
+    } else {
+        // Вещественные числа выводятся кратчайшей записью, однозначно задающей значение
+        char buffer[64];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+// Дописывает в out текст fmt до очередной подстановки и убирает его из fmt вместе с ней
+inline void AppendLiteral(std::string_view& fmt, std::string& out) {
+    size_t i = 0;
+    for (; i < fmt.size(); ++i) {
+        if (fmt[i] == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+            fmt.remove_prefix(i + 2);
+            return;
+        }
+        out.push_back(fmt[i]);
+        if (fmt[i] == '{' || fmt[i] == '}') {
+            // Вторая скобка пары "{{" или "}}"
+            ++i;
+        }
+    }
+    fmt.remove_prefix(i);
+}
+
+// Дописывает в out строку fmt, подставляя распакованные из args значения типов Ts.
+// Строка формата должна быть проверена FormatString<Ts...>
+template <typename... Ts>
+void FormatPacked(std::string_view fmt, std::string_view args, std::string& out) {
+    ((AppendLiteral(fmt, out), AppendValue(out, Unpack<Ts>(args))), ...);
+    AppendLiteral(fmt, out);
+}
+
+// Дописывает в out строку в кавычках, экранируя символы по правилам JSON
+inline void AppendJsonString(std::string& out, std::string_view str) {
+    constexpr std::string_view HEX_DIGITS = "0123456789abcdef";
+    out.push_back('"');
+    for (const char c : str) {
+        switch (c) {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(HEX_DIGITS[c >> 4]);
+                    out.push_back(HEX_DIGITS[c & 0xF]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+}  // namespace log_format
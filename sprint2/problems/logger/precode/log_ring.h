@@ -0,0 +1,217 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace log_ring {
+
+/*
+ * Кольцевой файл последних записей журнала для разбора падений.
+ * Файл отображается в память (MAP_SHARED), и записи копируются прямо в отображение,
+ * без системных вызовов. Страницы принадлежат ядру, поэтому после падения процесса
+ * ядро всё равно сохранит их в файл, и последние записи можно прочитать утилитой logdump.
+ *
+ * Файл - заголовок и кольцо из capacity байт. Запись кольца:
+ *  u64 position | u64 time | u32 size | u32 reserved | текст, выровнено до 8 байт
+ * Пишущий поток резервирует место атомарным увеличением head и последним записывает
+ * position - абсолютное смещение записи от начала всех записей. Оно служит отметкой
+ * готовности: у недописанной или затёртой записи position не совпадает с её смещением,
+ * и ReadRecords её пропускает. Числа хранятся в порядке байтов платформы
+ */
+
+constexpr char MAGIC[8] = {'L', 'O', 'G', 'R', 'I', 'N', 'G', '1'};
+
+struct FileHeader {
+    char magic[8];
+    std::uint64_t capacity;
+    // Сколько байт записей зарезервировано за всё время, см. std::atomic_ref
+    std::uint64_t head;
+    std::uint64_t reserved;
+};
+
+struct RecordHeader {
+    std::uint64_t position;
+    std::int64_t time;
+    std::uint32_t size;
+    std::uint32_t reserved;
+};
+
+constexpr std::uint64_t ALIGNMENT = 8;
+
+// Под этим суффиксом сохраняется кольцо предыдущего запуска
+constexpr std::string_view PREVIOUS_SUFFIX = ".prev";
+
+constexpr std::uint64_t Align(std::uint64_t size) noexcept {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+namespace detail {
+
+class Mapping {
+public:
+    Mapping(const std::string& path, bool writable, std::uint64_t size) {
+        const int fd = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Can't open " + path);
+        }
+        struct stat st {};
+        if (writable ? ::ftruncate(fd, size) < 0 : ::fstat(fd, &st) < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Can't size " + path);
+        }
+        size_ = writable ? size : st.st_size;
+        void* data = size_ == 0 ? MAP_FAILED
+                                : ::mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                         MAP_SHARED, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::system_error(size_ == 0 ? EINVAL : error, std::generic_category(),
+                                    "Can't map " + path);
+        }
+        data_ = static_cast<char*>(data);
+    }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+
+    ~Mapping() {
+        ::munmap(data_, size_);
+    }
+
+    char* Data() const noexcept {
+        return data_;
+    }
+
+    std::uint64_t Size() const noexcept {
+        return size_;
+    }
+
+private:
+    char* data_ = nullptr;
+    std::uint64_t size_ = 0;
+};
+
+// Переименовывает кольцо прошлого запуска path в path.prev, чтобы новое кольцо
+// не затёрло записи, оставшиеся после падения. Возвращает path
+inline const std::string& KeepPrevious(const std::string& path) {
+    if (::rename(path.c_str(), (path + std::string{PREVIOUS_SUFFIX}).c_str()) < 0 && errno != ENOENT) {
+        throw std::system_error(errno, std::generic_category(), "Can't rename " + path);
+    }
+    return path;
+}
+
+// Копирует size байт между буфером и кольцом начиная с позиции pos, переходя через конец кольца
+inline void CopyTo(char* ring, std::uint64_t capacity, std::uint64_t pos, const void* src, size_t size) {
+    const auto offset = pos % capacity;
+    const auto first = std::min<std::uint64_t>(size, capacity - offset);
+    std::memcpy(ring + offset, src, first);
+    std::memcpy(ring, static_cast<const char*>(src) + first, size - first);
+}
+
+inline void CopyFrom(const char* ring, std::uint64_t capacity, std::uint64_t pos, void* dst, size_t size) {
+    const auto offset = pos % capacity;
+    const auto first = std::min<std::uint64_t>(size, capacity - offset);
+    std::memcpy(dst, ring + offset, first);
+    std::memcpy(static_cast<char*>(dst) + first, ring, size - first);
+}
+
+}  // namespace detail
+
+/*
+ * Пишет записи в кольцевой файл. Append можно вызывать из любых потоков одновременно,
+ * он не блокируется и не выполняет системных вызовов. Файл создаётся заново, а кольцо
+ * прошлого запуска с тем же именем сохраняется рядом с суффиксом PREVIOUS_SUFFIX
+ * и читается той же ReadRecords
+ */
+class Ring {
+public:
+    constexpr static std::uint64_t MIN_CAPACITY = 4096;
+
+    Ring(const std::string& path, std::uint64_t capacity)
+        : capacity_{Align(std::max(capacity, MIN_CAPACITY))}
+        , mapping_{detail::KeepPrevious(path), true, sizeof(FileHeader) + capacity_} {
+        auto* header = reinterpret_cast<FileHeader*>(mapping_.Data());
+        header->capacity = capacity_;
+        header->head = 0;
+        header->reserved = 0;
+        std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        ring_ = mapping_.Data() + sizeof(FileHeader);
+        head_ = &header->head;
+    }
+
+    // Добавляет текст записи. Слишком длинный текст обрезается до половины кольца
+    void Append(std::int64_t time, std::string_view text) noexcept {
+        const auto size = std::min<std::uint64_t>(text.size(), capacity_ / 2 - sizeof(RecordHeader));
+        const auto total = Align(sizeof(RecordHeader) + size);
+        const auto pos = std::atomic_ref{*head_}.fetch_add(total, std::memory_order_relaxed);
+
+        RecordHeader record{~pos, time, static_cast<std::uint32_t>(size), 0};
+        detail::CopyTo(ring_, capacity_, pos, &record, sizeof(record));
+        detail::CopyTo(ring_, capacity_, pos + sizeof(record), text.data(), size);
+        // Позиция записывается последней: запись готова, когда position совпадает с pos.
+        // Заголовок выровнен до 8 байт, поэтому position не переходит через конец кольца
+        std::atomic_ref{*reinterpret_cast<std::uint64_t*>(ring_ + pos % capacity_)}.store(
+            pos, std::memory_order_release);
+    }
+
+private:
+    std::uint64_t capacity_;
+    detail::Mapping mapping_;
+    char* ring_ = nullptr;
+    std::uint64_t* head_ = nullptr;
+};
+
+/*
+ * Читает кольцевой файл path и вызывает fn(time, text) для каждой сохранившейся записи
+ * от старых к новым. Если файл не является кольцом журнала, выбрасывает std::runtime_error
+ */
+template <typename Fn>
+void ReadRecords(const std::string& path, Fn&& fn) {
+    detail::Mapping mapping{path, false, 0};
+    FileHeader header;
+    if (mapping.Size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a log ring");
+    }
+    std::memcpy(&header, mapping.Data(), sizeof(header));
+    const auto capacity = header.capacity;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || capacity == 0
+        || capacity % ALIGNMENT != 0 || mapping.Size() < sizeof(header) + capacity) {
+        throw std::runtime_error(path + " is not a log ring");
+    }
+
+    const char* ring = mapping.Data() + sizeof(header);
+    const auto head = header.head;
+    std::string text;
+    // Начало самой старой записи неизвестно, поэтому ищем первую запись,
+    // position которой совпадает с её смещением
+    for (auto pos = head > capacity ? head - capacity : 0; pos + sizeof(RecordHeader) <= head;) {
+        RecordHeader record;
+        detail::CopyFrom(ring, capacity, pos, &record, sizeof(record));
+        const auto total = Align(sizeof(RecordHeader) + record.size);
+        if (record.position != pos || total > head - pos) {
+            pos += ALIGNMENT;
+            continue;
+        }
+        text.resize(record.size);
+        detail::CopyFrom(ring, capacity, pos + sizeof(record), text.data(), text.size());
+        fn(record.time, std::string_view{text});
+        pos += total;
+    }
+}
+
+}  // namespace log_ring
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <zlib.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+namespace log_rotation {
+
+/*
+ * Сжатие файлов журнала в gzip в отдельном потоке.
+ * Поток журнала лишь ставит файл в очередь, поэтому сжатие больших файлов
+ * не задерживает запись. Деструктор дожидается сжатия всех поставленных файлов
+ */
+class Compressor {
+public:
+    Compressor()
+        : thread_{[this] {
+            Run();
+        }} {
+    }
+
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    ~Compressor() {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    // Сжимает файл path в path + ".gz" и удаляет его. Если сжать не удалось,
+    // исходный файл остаётся на месте
+    void Compress(std::string path) {
+        {
+            std::lock_guard lock{mutex_};
+            paths_.push_back(std::move(path));
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void Run() {
+        std::unique_lock lock{mutex_};
+        for (;;) {
+            cv_.wait(lock, [this] {
+                return stop_ || !paths_.empty();
+            });
+            if (paths_.empty()) {
+                return;
+            }
+            std::string path = std::move(paths_.front());
+            paths_.pop_front();
+            lock.unlock();
+            GzipFile(path);
+            lock.lock();
+        }
+    }
+
+    static bool GzipFile(const std::string& path) {
+        const std::string gz_path = path + ".gz";
+        std::ifstream in{path, std::ios::binary};
+        gzFile out = gzopen(gz_path.c_str(), "wb");
+        if (!in || !out) {
+            if (out) {
+                gzclose(out);
+            }
+            return false;
+        }
+
+        std::array<char, 1 << 16> buffer;
+        bool ok = true;
+        while (ok && in) {
+            in.read(buffer.data(), buffer.size());
+            const auto size = static_cast<unsigned>(in.gcount());
+            ok = size == 0 || gzwrite(out, buffer.data(), size) == static_cast<int>(size);
+        }
+        ok = gzclose(out) == Z_OK && ok && in.eof();
+        in.close();
+
+        std::error_code ec;
+        std::filesystem::remove(ok ? path : gz_path, ec);
+        return ok;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> paths_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+/*
+ * Файл журнала, разбитый по дням и по размеру.
+ * Первая часть дня пишется в <prefix><stamp><suffix>, следующие —
+ * в <prefix><stamp>.<n><suffix>. Файл следующей части открывается заранее, поэтому при
+ * переполнении части запись сразу продолжается в нём, а заполненная часть передаётся
+ * на сжатие в Compressor. Запись никогда не делится между частями.
+ * Класс не синхронизирован и используется только фоновым потоком журнала
+ */
+class RotatingFile {
+public:
+    RotatingFile(std::string_view prefix, std::string_view suffix, std::uintmax_t max_size,
+                 Compressor& compressor)
+        : prefix_{prefix}
+        , suffix_{suffix}
+        , max_size_{max_size}
+        , compressor_{&compressor} {
+    }
+
+    RotatingFile(const RotatingFile&) = delete;
+    RotatingFile& operator=(const RotatingFile&) = delete;
+
+    ~RotatingFile() {
+        DiscardNext();
+    }
+
+    // Дописывает text в файл за день stamp
+    void Write(std::string_view stamp, std::string_view text) {
+        if (!file_.is_open() || stamp != stamp_) {
+            StartDay(stamp);
+        } else if (size_ > 0 && size_ + text.size() > max_size_) {
+            Rotate();
+        }
+        file_.write(text.data(), static_cast<std::streamsize>(text.size()));
+        size_ += text.size();
+    }
+
+    void Flush() {
+        if (file_.is_open()) {
+            file_.flush();
+        }
+    }
+
+private:
+    std::string GetPath(size_t segment) const {
+        std::string path = prefix_ + stamp_;
+        if (segment > 0) {
+            path += '.' + std::to_string(segment);
+        }
+        return path + suffix_;
+    }
+
+    static std::uintmax_t GetSize(const std::string& path) noexcept {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : size;
+    }
+
+    void StartDay(std::string_view stamp) {
+        DiscardNext();
+        file_.close();
+        stamp_ = stamp;
+
+        // После перезапуска продолжаем первую ещё не сжатую часть дня
+        segment_ = 0;
+        std::error_code ec;
+        while (std::filesystem::exists(GetPath(segment_) + ".gz", ec)) {
+            ++segment_;
+        }
+        Open(file_, GetPath(segment_));
+        size_ = GetSize(GetPath(segment_));
+        OpenNext();
+    }
+
+    void Rotate() {
+        file_.close();
+        compressor_->Compress(GetPath(segment_));
+        ++segment_;
+        file_ = std::move(next_);
+        size_ = GetSize(GetPath(segment_));
+        OpenNext();
+    }
+
+    void OpenNext() {
+        Open(next_, GetPath(segment_ + 1));
+    }
+
+    // Удаляет заранее открытый файл следующей части, если в него ничего не записано
+    void DiscardNext() {
+        if (!next_.is_open()) {
+            return;
+        }
+        next_.close();
+        const std::string path = GetPath(segment_ + 1);
+        if (GetSize(path) == 0) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    }
+
+    static void Open(std::ofstream& file, const std::string& path) {
+        file.clear();
+        file.open(path, std::ios::app | std::ios::binary);
+    }
+
+    std::string prefix_;
+    std::string suffix_;
+    std::uintmax_t max_size_;
+    Compressor* compressor_;
+
+    std::string stamp_;
+    size_t segment_ = 0;
+    std::uintmax_t size_ = 0;
+    std::ofstream file_;
+    std::ofstream next_;
+};
+
+}  // namespace log_rotation
@@ -0,0 +1,30 @@
+#include <exception>
+#include <iostream>
+
+#include "log_ring.h"
+
+/*
+ * Выводит записи кольцевого файла журнала (см. log_ring::Ring) от старых к новым,
+ * например после падения процесса. Кольцо, записанное до перезапуска, лежит в файле с суффиксом .prev.
+ * Запуск: logdump <кольцевой файл>
+ */
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: logdump <ring file>" << std::endl;
+        return 1;
+    }
+    try {
+        size_t records = 0;
+        log_ring::ReadRecords(argv[1], [&records](std::int64_t, std::string_view text) {
+            std::cout << text;
+            if (text.empty() || text.back() != '\n') {
+                std::cout << '\n';
+            }
+            ++records;
+        });
+        std::cerr << records << " records" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,11 +1,17 @@
 #include "my_logger.h"
 
+#include <cstdlib>
 #include <string_view>
 #include <thread>
 
 using namespace std::literals;
 
 int main() {
+    // Последние записи сохраняются в кольцевом файле и после падения, см. logdump
+    if (const char* ring = std::getenv("LOG_RING")) {
+        Logger::GetInstance().EnableRing(ring, 4 << 20);
+    }
+
     // Будем устанавливать моменты времени в секундах от начала эпохи.
     // Конкретные значения не так важны, главное, что часы идут монотонно.
     Logger::GetInstance().SetTimestamp(std::chrono::system_clock::time_point{1000000s});
@@ -29,4 +35,10 @@ int main() {
 
         LOG("Logging attempt ", i, ". ", "I Love it");
     }
+
+    // Структурированные записи форматируются фоновым потоком и выводятся строками JSON.
+    // Число подстановок в строке формата проверяется при компиляции
+    for(int i = 0; i < attempts; ++i) {
+        LOG_FMT("Structured attempt {} of {}: \"{}\"", i, attempts, "I Love it"sv);
+    }
 }
@@ -1,40 +1,179 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <optional>
-#include <mutex>
 #include <thread>
 
+#include "log_filter.h"
+#include "log_format.h"
+#include "log_ring.h"
+#include "log_rotation.h"
+
 using namespace std::literals;
 
-#define LOG(...) Logger::GetInstance().Log(__VA_ARGS__)
+/*
+ * Запись уровня level (TRACE, DEBUG, INFO, WARNING, ERROR) в журнал модуля module
+ * (log_filter::Module): LOG_AT(DEBUG, net_log, "Accepted "sv, endpoint).
+ * Уровни ниже LOG_MIN_LEVEL удаляются при компиляции, а ниже порога модуля
+ * пропускаются после одного чтения атомарной переменной, в обоих случаях
+ * аргументы не вычисляются
+ */
+#define LOG_AT(level, module, ...)                                                   \
+    do {                                                                             \
+        if constexpr (log_filter::IsCompiledIn(log_filter::LogLevel::level)) {       \
+            if ((module).IsEnabled(log_filter::LogLevel::level)) {                   \
+                Logger::GetInstance().Log(__VA_ARGS__);                              \
+            }                                                                        \
+        }                                                                            \
+    } while (false)
+
+// То же для структурированной записи, см. LOG_FMT
+#define LOG_FMT_AT(level, module, ...)                                               \
+    do {                                                                             \
+        if constexpr (log_filter::IsCompiledIn(log_filter::LogLevel::level)) {       \
+            if ((module).IsEnabled(log_filter::LogLevel::level)) {                   \
+                Logger::GetInstance().LogFormat(__VA_ARGS__);                        \
+            }                                                                        \
+        }                                                                            \
+    } while (false)
+
+/*
+ * Запись для горячих циклов: из этого места программы выводится не больше
+ * per_second записей в секунду. К первой записи после пропусков добавляется
+ * количество пропущенных
+ */
+#define LOG_RATE_LIMITED(level, module, per_second, ...)                             \
+    do {                                                                             \
+        if constexpr (log_filter::IsCompiledIn(log_filter::LogLevel::level)) {       \
+            if ((module).IsEnabled(log_filter::LogLevel::level)) {                   \
+                static log_filter::RateLimit log_rate_limit{per_second};             \
+                std::uint64_t log_suppressed = 0;                                    \
+                if (log_rate_limit.Allow(log_suppressed)) {                          \
+                    if (log_suppressed == 0) {                                       \
+                        Logger::GetInstance().Log(__VA_ARGS__);                      \
+                    } else {                                                         \
+                        Logger::GetInstance().Log(__VA_ARGS__, " ("sv, log_suppressed, \
+                                                  " similar records suppressed)"sv); \
+                    }                                                                \
+                }                                                                    \
+            }                                                                        \
+        }                                                                            \
+    } while (false)
+
+#define LOG_TRACE(module, ...) LOG_AT(TRACE, module, __VA_ARGS__)
+#define LOG_DEBUG(module, ...) LOG_AT(DEBUG, module, __VA_ARGS__)
+#define LOG_INFO(module, ...) LOG_AT(INFO, module, __VA_ARGS__)
+#define LOG_WARNING(module, ...) LOG_AT(WARNING, module, __VA_ARGS__)
+#define LOG_ERROR(module, ...) LOG_AT(ERROR, module, __VA_ARGS__)
+
+// Запись уровня INFO без модуля
+#define LOG(...) LOG_AT(INFO, log_filter::default_module, __VA_ARGS__)
+// Структурированная запись: LOG_FMT("Attempt {} of {}", i, count).
+// Строка формата проверяется при компиляции, а форматирует запись фоновый поток
+#define LOG_FMT(...) LOG_FMT_AT(INFO, log_filter::default_module, __VA_ARGS__)
 
+/*
+ * Журнал, не блокирующий пишущие потоки.
+ * Log форматирует запись в буфер своего потока и добавляет её в очередь без блокировок.
+ * Фоновый поток забирает из очереди сразу все накопившиеся записи и пишет их в файл
+ * одной пачкой. Файл выбирается по дате записи, поэтому записи разных дней
+ * попадают в разные файлы.
+ * Записи одного потока выводятся в порядке вызовов Log.
+ * Записи LOG_FMT выводятся строками JSON в отдельный файл с расширением .jsonl.
+ * Файл дня, выросший до MAX_FILE_SIZE, продолжается в следующей части, а заполненная
+ * часть сжимается в gzip отдельным потоком (см. log_rotation::RotatingFile).
+ * После EnableRing каждая запись ещё и копируется в кольцевой файл в памяти
+ * пишущего потока, поэтому последние записи переживают падение процесса
+ * (см. log_ring::Ring)
+ */
 class Logger {
+    using Clock = std::chrono::system_clock;
+
     auto GetTime() const {
-        if (manual_ts_) {
-            return *manual_ts_;
+        const auto manual_ts = manual_ts_.load(std::memory_order_relaxed);
+        if (manual_ts != NO_MANUAL_TS) {
+            return Clock::time_point{Clock::duration{manual_ts}};
         }
 
-        return std::chrono::system_clock::now();
+        return Clock::now();
     }
 
-    auto GetTimeStamp() const {
-        const auto now = GetTime();
-        const auto t_c = std::chrono::system_clock::to_time_t(now);
-        return std::put_time(std::localtime(&t_c), "%F %T");
+    // Метки времени записи: "%F %T" для текста и "%Y_%m_%d" для имени файла
+    struct TimeStamps {
+        std::time_t time = std::numeric_limits<std::time_t>::min();
+        std::array<char, 32> text{};
+        size_t text_size = 0;
+        std::array<char, 32> file{};
+        size_t file_size = 0;
+    };
+
+    // Метки форматируются заново, только когда меняется секунда, а дата в имени файла
+    // берётся из того же разбора времени, поэтому меняется раз в сутки.
+    // Кэш у каждого потока свой, поэтому обновляется без синхронизации
+    static const TimeStamps& GetTimeStamps(Clock::time_point now) {
+        thread_local TimeStamps cache;
+        const auto t_c = Clock::to_time_t(now);
+        if (t_c != cache.time) {
+            // В отличие от std::localtime, localtime_r не использует общий буфер
+            std::tm tm{};
+            localtime_r(&t_c, &tm);
+            cache.text_size = std::strftime(cache.text.data(), cache.text.size(), "%F %T", &tm);
+            cache.file_size = std::strftime(cache.file.data(), cache.file.size(), "%Y_%m_%d", &tm);
+            cache.time = t_c;
+        }
+        return cache;
+    }
+
+    std::string_view GetTimeStamp(Clock::time_point now) const {
+        const auto& stamps = GetTimeStamps(now);
+        return {stamps.text.data(), stamps.text_size};
     }
 
     // Для имени файла возьмите дату с форматом "%Y_%m_%d"
-    std::string GetFileTimeStamp() const;
+    std::string_view GetFileTimeStamp(Clock::time_point now) const {
+        const auto& stamps = GetTimeStamps(now);
+        return {stamps.file.data(), stamps.file_size};
+    }
+
+    using FormatFn = void (*)(std::string_view fmt, std::string_view args, std::string& out);
+
+    // Запись журнала
+    struct Record {
+        std::string file_stamp;
+        // Отформатированный текст либо, если задана format, упакованные аргументы
+        std::string text;
+        // Последняя запись, после которой фоновый поток завершается
+        bool stop = false;
+        Record* next = nullptr;
+        // Для отложенного форматирования: время записи, строка формата
+        // и функция, разворачивающая аргументы
+        Clock::time_point time{};
+        std::string_view format_string{};
+        FormatFn format = nullptr;
+    };
+
+    Logger()
+        : writer_{[this] {
+            WriteRecords();
+        }} {
+    }
 
-    Logger() = default;
     Logger(const Logger&) = delete;
 
+    ~Logger() {
+        Push(std::make_unique<Record>(Record{{}, {}, true}));
+        writer_.join();
+    }
+
 public:
     static Logger& GetInstance() {
         static Logger obj;
@@ -43,13 +182,140 @@ public:
 
     // Выведите в поток все аргументы.
     template<class... Ts>
-    void Log(const Ts&... args);
+    void Log(const Ts&... args) {
+        // Буфер переиспользуется, поэтому его внутреннее состояние выделяется один раз на поток
+        thread_local std::ostringstream buffer;
+        buffer.str({});
+        buffer.clear();
+
+        const auto now = GetTime();
+        buffer << GetTimeStamp(now) << ": "sv;
+        (buffer << ... << args);
+        buffer << '\n';
+        auto record = std::make_unique<Record>(
+            Record{std::string{GetFileTimeStamp(now)}, std::move(buffer).str()});
+        if (auto* ring = ring_.load(std::memory_order_acquire)) {
+            ring->Append(now.time_since_epoch().count(), record->text);
+        }
+        Push(std::move(record));
+    }
+
+    // Копирует аргументы в запись без форматирования. Строки копируются целиком,
+    // поэтому после возврата их можно изменять.
+    // Метки времени, подстановка значений и экранирование выполняются в фоновом потоке
+    template <class... Ts>
+    void LogFormat(log_format::FormatString<std::type_identity_t<Ts>...> fmt,
+                   const Ts&... args) {
+        auto record = std::make_unique<Record>();
+        record->text.reserve((log_format::GetPackedSize(args) + ... + 0));
+        (log_format::Pack(record->text, args), ...);
+        record->time = GetTime();
+        record->format_string = fmt.Get();
+        record->format = &log_format::FormatPacked<log_format::Packed<Ts>...>;
+        if (auto* ring = ring_.load(std::memory_order_acquire)) {
+            // В кольце нужен готовый текст, поэтому с ним запись форматируется сразу
+            thread_local std::string line;
+            line.assign(GetTimeStamp(record->time));
+            line.append(": "sv);
+            record->format(record->format_string, record->text, line);
+            line.push_back('\n');
+            ring->Append(record->time.time_since_epoch().count(), line);
+        }
+        Push(std::move(record));
+    }
+
+    // Начинает копировать записи в кольцевой файл path из capacity байт.
+    // Вызывается один раз, обычно при запуске. Если файл не создать, выбрасывает
+    // std::system_error
+    void EnableRing(const std::string& path, std::uint64_t capacity) {
+        if (ring_owner_) {
+            throw std::logic_error("Log ring is already enabled");
+        }
+        ring_owner_ = std::make_unique<log_ring::Ring>(path, capacity);
+        ring_.store(ring_owner_.get(), std::memory_order_release);
+    }
 
     // Установите manual_ts_. Учтите, что эта операция может выполняться
-    // параллельно с выводом в поток, вам нужно предусмотреть 
+    // параллельно с выводом в поток, вам нужно предусмотреть
     // синхронизацию.
-    void SetTimestamp(std::chrono::system_clock::time_point ts);
+    void SetTimestamp(std::chrono::system_clock::time_point ts) {
+        manual_ts_.store(ts.time_since_epoch().count(), std::memory_order_relaxed);
+    }
 
 private:
-    std::optional<std::chrono::system_clock::time_point> manual_ts_;
+    constexpr static Clock::rep NO_MANUAL_TS = std::numeric_limits<Clock::rep>::min();
+    constexpr static std::string_view FILE_PREFIX = "/var/log/sample_log_"sv;
+    constexpr static std::string_view FILE_SUFFIX = ".log"sv;
+    constexpr static std::string_view JSON_FILE_SUFFIX = ".jsonl"sv;
+    constexpr static std::uintmax_t MAX_FILE_SIZE = std::uintmax_t{1} << 30;
+
+
+    // Добавляет запись в вершину стека pending_ и будит фоновый поток,
+    // если стек был пуст
+    void Push(std::unique_ptr<Record> record) {
+        Record* node = record.release();
+        // После публикации запись принадлежит фоновому потоку, поэтому прежнюю вершину
+        // храним в локальной переменной, а не читаем из записи
+        Record* top = pending_.load(std::memory_order_relaxed);
+        do {
+            node->next = top;
+        } while (!pending_.compare_exchange_weak(top, node, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+        if (!top) {
+            pending_.notify_one();
+        }
+    }
+
+    // Выполняется в фоновом потоке: забирает накопившиеся записи и пишет их в файлы
+    void WriteRecords() {
+        using log_rotation::RotatingFile;
+        RotatingFile text_output{FILE_PREFIX, FILE_SUFFIX, MAX_FILE_SIZE, compressor_};
+        RotatingFile json_output{FILE_PREFIX, JSON_FILE_SUFFIX, MAX_FILE_SIZE, compressor_};
+        std::string line;
+        std::string message;
+        for (bool stop = false; !stop;) {
+            pending_.wait(nullptr, std::memory_order_relaxed);
+            // Стек хранит записи от новых к старым, поэтому разворачиваем его
+            Record* batch = nullptr;
+            for (Record* node = pending_.exchange(nullptr, std::memory_order_acquire); node;) {
+                Record* next = node->next;
+                node->next = batch;
+                batch = node;
+                node = next;
+            }
+
+            while (batch) {
+                std::unique_ptr<Record> record{batch};
+                batch = record->next;
+                if (record->stop) {
+                    stop = true;
+                    continue;
+                }
+                if (!record->format) {
+                    text_output.Write(record->file_stamp, record->text);
+                    continue;
+                }
+                message.clear();
+                record->format(record->format_string, record->text, message);
+                line.clear();
+                line.append(R"({"timestamp":)");
+                log_format::AppendJsonString(line, GetTimeStamp(record->time));
+                line.append(R"(,"message":)");
+                log_format::AppendJsonString(line, message);
+                line.append("}\n");
+                json_output.Write(GetFileTimeStamp(record->time), line);
+            }
+            text_output.Flush();
+            json_output.Flush();
+        }
+    }
+
+    std::atomic<Clock::rep> manual_ts_{NO_MANUAL_TS};
+    std::unique_ptr<log_ring::Ring> ring_owner_;
+    std::atomic<log_ring::Ring*> ring_{nullptr};
+    // Стек записей, ещё не забранных фоновым потоком
+    std::atomic<Record*> pending_{nullptr};
+    // Сжимает части файлов, заполненные фоновым потоком. Создаётся раньше него
+    log_rotation::Compressor compressor_;
+    std::thread writer_;
 };
@@ -1,5 +1,22 @@
 #include "collision_detector.h"
+
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define COLLISION_DETECTOR_AVX2 1
+#endif
 
 namespace collision_detector {
 
@@ -22,11 +39,712 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
     return CollectionResult(sq_distance, proj_ratio);
 }
 
-// В задании на разработку тестов реализовывать следующую функцию не нужно -
-// она будет линковаться извне.
+namespace {
+
+using TryCollectPointsFn = size_t (*)(geom::Point2D, geom::Point2D, double, const double*,
+                                      const double*, const double*, size_t, CollectedPoints);
+
+// Повторяет вычисления TryCollectPoint для каждой точки
+size_t TryCollectPointsScalar(geom::Point2D a, geom::Point2D b, double gatherer_width,
+                              const double* x, const double* y, const double* width, size_t count,
+                              CollectedPoints out) {
+    size_t collected = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto result = TryCollectPoint(a, b, {x[i], y[i]});
+        if (result.IsCollected(gatherer_width + width[i])) {
+            out.index[collected] = i;
+            out.sq_distance[collected] = result.sq_distance;
+            out.proj_ratio[collected] = result.proj_ratio;
+            ++collected;
+        }
+    }
+    return collected;
+}
+
+#if defined(COLLISION_DETECTOR_AVX2)
+
+// Операции и их порядок совпадают с TryCollectPoint. Умножение и сложение не сливаются
+// в FMA, так как функция компилируется только с расширением AVX2
+__attribute__((target("avx2"))) size_t TryCollectPointsAvx2(
+    geom::Point2D a, geom::Point2D b, double gatherer_width, const double* x, const double* y,
+    const double* width, size_t count, CollectedPoints out) {
+    assert(b.x != a.x || b.y != a.y);
+    const double v_x = b.x - a.x;
+    const double v_y = b.y - a.y;
+    const __m256d a_x = _mm256_set1_pd(a.x);
+    const __m256d a_y = _mm256_set1_pd(a.y);
+    const __m256d vv_x = _mm256_set1_pd(v_x);
+    const __m256d vv_y = _mm256_set1_pd(v_y);
+    const __m256d v_len2 = _mm256_set1_pd(v_x * v_x + v_y * v_y);
+    const __m256d g_width = _mm256_set1_pd(gatherer_width);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1);
+
+    size_t collected = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(x + i), a_x);
+        const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(y + i), a_y);
+        const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, vv_x), _mm256_mul_pd(u_y, vv_y));
+        const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+        const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2);
+        const __m256d sq_distance =
+            _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2));
+        const __m256d radius = _mm256_add_pd(g_width, _mm256_loadu_pd(width + i));
+
+        const __m256d in_segment = _mm256_and_pd(_mm256_cmp_pd(proj_ratio, zero, _CMP_GE_OQ),
+                                                 _mm256_cmp_pd(proj_ratio, one, _CMP_LE_OQ));
+        const __m256d in_radius =
+            _mm256_cmp_pd(sq_distance, _mm256_mul_pd(radius, radius), _CMP_LE_OQ);
+        int mask = _mm256_movemask_pd(_mm256_and_pd(in_segment, in_radius));
+        if (mask == 0) {
+            continue;
+        }
+
+        alignas(32) double sq_distances[4];
+        alignas(32) double proj_ratios[4];
+        _mm256_store_pd(sq_distances, sq_distance);
+        _mm256_store_pd(proj_ratios, proj_ratio);
+        for (; mask != 0; mask &= mask - 1) {
+            const int lane = __builtin_ctz(static_cast<unsigned>(mask));
+            out.index[collected] = i + lane;
+            out.sq_distance[collected] = sq_distances[lane];
+            out.proj_ratio[collected] = proj_ratios[lane];
+            ++collected;
+        }
+    }
+
+    const size_t tail = TryCollectPointsScalar(
+        a, b, gatherer_width, x + i, y + i, width + i, count - i,
+        {out.index + collected, out.sq_distance + collected, out.proj_ratio + collected});
+    for (size_t j = collected; j < collected + tail; ++j) {
+        out.index[j] += i;
+    }
+    return collected + tail;
+}
+
+#endif
+
+TryCollectPointsFn SelectTryCollectPoints() noexcept {
+#if defined(COLLISION_DETECTOR_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return TryCollectPointsAvx2;
+    }
+#endif
+    return TryCollectPointsScalar;
+}
+
+}  // namespace
+
+size_t TryCollectPoints(geom::Point2D a, geom::Point2D b, double gatherer_width, const double* x,
+                        const double* y, const double* width, size_t count, CollectedPoints out) {
+    static const TryCollectPointsFn try_collect_points = SelectTryCollectPoints();
+    return try_collect_points(a, b, gatherer_width, x, y, width, count, out);
+}
+
+namespace {
+
+// Столбцы объектов провайдера. Для провайдера без BulkItemGathererProvider
+// объекты копируются в собственные массивы
+class ProviderColumns {
+public:
+    explicit ProviderColumns(const ItemGathererProvider& provider) {
+        if (const auto* bulk = dynamic_cast<const BulkItemGathererProvider*>(&provider)) {
+            items_ = bulk->GetItemColumns();
+            gatherers_ = bulk->GetGathererColumns();
+            return;
+        }
+
+        // Провайдер опрашивается один раз для каждого объекта
+        const size_t item_count = provider.ItemsCount();
+        storage_.resize(3 * item_count);
+        auto* out = storage_.data();
+        for (size_t i = 0; i < item_count; ++i) {
+            const auto item = provider.GetItem(i);
+            out[i] = item.position.x;
+            out[item_count + i] = item.position.y;
+            out[2 * item_count + i] = item.width;
+        }
+
+        const size_t gatherer_count = provider.GatherersCount();
+        gatherer_storage_.resize(5 * gatherer_count);
+        out = gatherer_storage_.data();
+        for (size_t i = 0; i < gatherer_count; ++i) {
+            const auto gatherer = provider.GetGatherer(i);
+            out[i] = gatherer.start_pos.x;
+            out[gatherer_count + i] = gatherer.start_pos.y;
+            out[2 * gatherer_count + i] = gatherer.end_pos.x;
+            out[3 * gatherer_count + i] = gatherer.end_pos.y;
+            out[4 * gatherer_count + i] = gatherer.width;
+        }
+
+        const auto column = [](const std::vector<double>& storage, size_t index, size_t size) {
+            return std::span<const double>{storage.data() + index * size, size};
+        };
+        items_ = {column(storage_, 0, item_count), column(storage_, 1, item_count),
+                  column(storage_, 2, item_count)};
+        gatherers_ = {column(gatherer_storage_, 0, gatherer_count),
+                      column(gatherer_storage_, 1, gatherer_count),
+                      column(gatherer_storage_, 2, gatherer_count),
+                      column(gatherer_storage_, 3, gatherer_count),
+                      column(gatherer_storage_, 4, gatherer_count)};
+    }
+
+    const ItemColumns& GetItems() const noexcept {
+        return items_;
+    }
+
+    const GathererColumns& GetGatherers() const noexcept {
+        return gatherers_;
+    }
+
+private:
+    std::vector<double> storage_;
+    std::vector<double> gatherer_storage_;
+    ItemColumns items_;
+    GathererColumns gatherers_;
+};
+
+using CellKey = std::uint64_t;
+
+// Номер ячейки сетки со стороной cell_size, содержащей координату coord
+std::int64_t GetCell(double coord, double cell_size) noexcept {
+    return static_cast<std::int64_t>(std::floor(coord / cell_size));
+}
+
+// Ключи ячеек с 32-битными номерами упорядочены так же, как пары номеров (x, y).
+// Ячейки, номера которых отличаются на 2^32, попадают в один ключ. Это лишь добавляет
+// кандидатов, которые отсеет точная проверка, а запрос к таким ячейкам перебирает
+// все предметы
+CellKey GetCellKey(std::int64_t x, std::int64_t y) noexcept {
+    constexpr std::uint32_t SIGN_BIT = 0x8000'0000u;
+    return (static_cast<CellKey>(static_cast<std::uint32_t>(x) ^ SIGN_BIT) << 32)
+         | (static_cast<std::uint32_t>(y) ^ SIGN_BIT);
+}
+
+bool IsOrderedCell(std::int64_t cell) noexcept {
+    return cell >= std::numeric_limits<std::int32_t>::min()
+        && cell <= std::numeric_limits<std::int32_t>::max();
+}
+
 /*
+ * Ячейки сетки со стороной cell_size, содержащие точки не дальше reach от отрезка ab.
+ * Ячейки перечисляются по столбцам: в столбце x отрезок вместе с окрестностью занимает
+ * ячейки от y0 до y1. Для диагонального отрезка это намного меньше, чем ячеек
+ * в описанном вокруг него прямоугольнике
+ */
+class SegmentCells {
+public:
+    SegmentCells(geom::Point2D a, geom::Point2D b, double reach, double cell_size) noexcept
+        : a_{a}
+        , min_x_{std::min(a.x, b.x)}
+        , max_x_{std::max(a.x, b.x)}
+        , min_y_{std::min(a.y, b.y)}
+        , max_y_{std::max(a.y, b.y)}
+        , slope_{a.x == b.x ? 0 : (b.y - a.y) / (b.x - a.x)}
+        , vertical_{a.x == b.x}
+        // Запас защищает от ошибок округления при вычислении границ
+        , reach_{reach + cell_size * 1e-9}
+        , cell_size_{cell_size}
+        , x0_{GetCell(min_x_ - reach_, cell_size)}
+        , x1_{GetCell(max_x_ + reach_, cell_size)}
+        , y0_{GetCell(min_y_ - reach_, cell_size)}
+        , y1_{GetCell(max_y_ + reach_, cell_size)} {
+    }
+
+    // Все номера ячеек умещаются в 32 бита
+    bool IsOrdered() const noexcept {
+        return IsOrderedCell(x0_) && IsOrderedCell(x1_) && IsOrderedCell(y0_)
+            && IsOrderedCell(y1_);
+    }
+
+    // Количество ячеек, но не больше limit
+    double Count(double limit) const noexcept {
+        const double columns = double(x1_) - double(x0_) + 1;
+        if (columns > limit) {
+            return columns;
+        }
+        double count = 0;
+        ForEachColumn([&](std::int64_t, std::int64_t y0, std::int64_t y1) {
+            count += double(y1) - double(y0) + 1;
+        });
+        return count;
+    }
+
+    // Вызывает fn(x, y0, y1) для каждого столбца ячеек
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn) const {
+        for (auto x = x0_; x <= x1_; ++x) {
+            // Точки столбца могут подобрать только с участка отрезка, выходящего
+            // за столбец не более чем на reach_
+            const double from = std::max(min_x_, double(x) * cell_size_ - reach_);
+            const double to = std::max(from, std::min(max_x_, double(x + 1) * cell_size_ + reach_));
+            double low = min_y_;
+            double high = max_y_;
+            if (!vertical_) {
+                const double y_from = a_.y + (from - a_.x) * slope_;
+                const double y_to = a_.y + (to - a_.x) * slope_;
+                low = std::max(min_y_, std::min(y_from, y_to));
+                high = std::min(max_y_, std::max(y_from, y_to));
+            }
+            fn(x, std::max(y0_, GetCell(low - reach_, cell_size_)),
+               std::min(y1_, GetCell(high + reach_, cell_size_)));
+        }
+    }
+
+private:
+    geom::Point2D a_;
+    double min_x_;
+    double max_x_;
+    double min_y_;
+    double max_y_;
+    double slope_;
+    bool vertical_;
+    double reach_;
+    double cell_size_;
+    std::int64_t x0_;
+    std::int64_t x1_;
+    std::int64_t y0_;
+    std::int64_t y1_;
+};
+
+/*
+ * Равномерная сетка предметов для отбора кандидатов на сбор.
+ * Предметы упорядочены по ячейкам, а их координаты и ширины скопированы в этом порядке,
+ * поэтому предметы одной ячейки лежат в памяти подряд
+ */
+class ItemGrid {
+public:
+    // Предметы всех классов classes попадают в одну сетку. Номер предмета в сетке -
+    // его номер в классе, сдвинутый на число предметов предыдущих классов
+    ItemGrid(std::span<const ItemColumns> classes, double cell_size)
+        : cell_size_{cell_size} {
+        size_t count = 0;
+        for (const auto& items : classes) {
+            count += items.Size();
+        }
+        std::vector<std::pair<CellKey, size_t>> keyed;
+        keyed.reserve(count);
+        for (const auto& items : classes) {
+            const size_t offset = keyed.size();
+            for (size_t i = 0; i < items.Size(); ++i) {
+                keyed.emplace_back(
+                    GetCellKey(GetCell(items.x[i], cell_size), GetCell(items.y[i], cell_size)),
+                    offset + i);
+                max_width_ = std::max(max_width_, items.width[i]);
+            }
+        }
+        std::sort(keyed.begin(), keyed.end());
+
+        for (auto* column : {&x_, &y_, &width_}) {
+            column->reserve(count);
+        }
+        ids_.reserve(count);
+        // Номер первого предмета следующего класса
+        std::vector<size_t> class_ends;
+        for (const auto& items : classes) {
+            class_ends.push_back((class_ends.empty() ? 0 : class_ends.back()) + items.Size());
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const auto [key, id] = keyed[i];
+            if (i == 0 || keyed[i - 1].first != key) {
+                cells_.emplace(key, Range{i, i});
+            }
+            ++cells_[key].end;
+            const size_t cls = std::upper_bound(class_ends.begin(), class_ends.end(), id) - class_ends.begin();
+            const auto& items = classes[cls];
+            const size_t index = id - (class_ends[cls] - items.Size());
+            x_.push_back(items.x[index]);
+            y_.push_back(items.y[index]);
+            width_.push_back(items.width[index]);
+            ids_.push_back(id);
+        }
+    }
+
+    double GetMaxWidth() const noexcept {
+        return max_width_;
+    }
+
+    // Вызывает fn(ids, x, y, width, count) для предметов ячеек, содержащих точки
+    // не дальше reach от отрезка ab. Предметы передаются столбцами длины count,
+    // по одному вызову на столбец сетки. Если таких ячеек больше, чем предметов,
+    // передаёт все предметы разом
+    template <typename Fn>
+    void ForEachCandidate(geom::Point2D a, geom::Point2D b, double reach, Fn&& fn) const {
+        const SegmentCells segment_cells{a, b, reach, cell_size_};
+        const double limit = double(ids_.size());
+        if (!segment_cells.IsOrdered() || segment_cells.Count(limit) > limit) {
+            ForEachInRange({0, ids_.size()}, fn);
+            return;
+        }
+        segment_cells.ForEachColumn([&](std::int64_t x, std::int64_t y0, std::int64_t y1) {
+            // Ячейки упорядочены по ключу, поэтому ячейки столбца x от y0 до y1 лежат подряд:
+            // достаточно найти первую и последнюю из них
+            auto y = y0;
+            auto first = cells_.end();
+            for (; y <= y1 && first == cells_.end(); ++y) {
+                first = cells_.find(GetCellKey(x, y));
+            }
+            if (first == cells_.end()) {
+                return;
+            }
+            auto last = first;
+            for (auto top = y1; top >= y; --top) {
+                if (const auto it = cells_.find(GetCellKey(x, top)); it != cells_.end()) {
+                    last = it;
+                    break;
+                }
+            }
+            ForEachInRange({first->second.begin, last->second.end}, fn);
+        });
+    }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    template <typename Fn>
+    void ForEachInRange(Range range, Fn& fn) const {
+        const size_t i = range.begin;
+        fn(ids_.data() + i, x_.data() + i, y_.data() + i, width_.data() + i, range.end - i);
+    }
+
+    double cell_size_;
+    double max_width_ = 0;
+    std::unordered_map<CellKey, Range> cells_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> width_;
+    std::vector<size_t> ids_;
+};
+
+// Подбирает размер ячейки сетки: не меньше суммы наибольших ширин, чтобы зона сбора
+// захватывала мало ячеек. Длинные перемещения собирателей проходят через много ячеек,
+// поэтому ячейку увеличивают до среднего размаха перемещения, но не больше, чем нужно,
+// чтобы в среднем на ячейку приходилось около одного предмета
+double ChooseCellSize(std::span<const ItemColumns> classes, const GathererColumns& gatherers) {
+    double min_x = std::numeric_limits<double>::infinity();
+    double max_x = -min_x;
+    double min_y = min_x;
+    double max_y = -min_x;
+    double max_item_width = 0;
+    size_t item_count = 0;
+    for (const auto& items : classes) {
+        for (size_t i = 0; i < items.Size(); ++i) {
+            min_x = std::min(min_x, items.x[i]);
+            max_x = std::max(max_x, items.x[i]);
+            min_y = std::min(min_y, items.y[i]);
+            max_y = std::max(max_y, items.y[i]);
+            max_item_width = std::max(max_item_width, items.width[i]);
+        }
+        item_count += items.Size();
+    }
+    const double area = (max_x - min_x) * (max_y - min_y);
+    const double item_spacing = std::sqrt(area / double(item_count));
+
+    double total_extent = 0;
+    for (size_t i = 0; i < gatherers.Size(); ++i) {
+        total_extent += std::max(std::abs(gatherers.end_x[i] - gatherers.start_x[i]),
+                                 std::abs(gatherers.end_y[i] - gatherers.start_y[i]));
+    }
+    const double mean_extent = total_extent / double(gatherers.Size());
+
+    const double max_gatherer_width = *std::max_element(gatherers.width.begin(), gatherers.width.end());
+    const double cell_size = std::max(2 * (max_item_width + max_gatherer_width),
+                                      std::min(mean_extent, item_spacing));
+    return cell_size > 0 && std::isfinite(cell_size) ? cell_size : 1.0;
+}
+
+// Резервирует место под size элементов, сохраняя геометрический рост ёмкости
+template <typename Column>
+void ReserveGrowing(Column& column, size_t size) {
+    if (column.capacity() < size) {
+        column.reserve(std::max(size, column.capacity() * 2));
+    }
+}
+
+// События упорядочены по времени. Одновременные события упорядочены по номерам
+// собирателя и предмета, поэтому порядок не зависит от устройства сетки и числа потоков
+bool IsEarlier(const GatheringEvent& lhs, const GatheringEvent& rhs) noexcept {
+    return std::tie(lhs.time, lhs.gatherer_id, lhs.item_id)
+         < std::tie(rhs.time, rhs.gatherer_id, rhs.item_id);
+}
+
+// Дописывает в events упорядоченные события собирателей с номерами из [begin, end).
+// for_each_candidate(a, b, reach, fn) передаёт в fn столбцы предметов, которые могут
+// находиться не дальше reach от отрезка ab
+template <typename ForEachCandidate>
+void FindChunkEvents(const ForEachCandidate& for_each_candidate, double max_item_width,
+                     const GathererColumns& gatherers, size_t begin, size_t end,
+                     std::vector<GatheringEvent>& events) {
+    const size_t first_event = events.size();
+    // Результаты проверки предметов одного столбца
+    std::vector<size_t> collected;
+    std::vector<double> sq_distances;
+    std::vector<double> proj_ratios;
+    for (size_t gatherer_id = begin; gatherer_id < end; ++gatherer_id) {
+        const geom::Point2D a{gatherers.start_x[gatherer_id], gatherers.start_y[gatherer_id]};
+        const geom::Point2D b{gatherers.end_x[gatherer_id], gatherers.end_y[gatherer_id]};
+        const double gatherer_width = gatherers.width[gatherer_id];
+        if (a.x == b.x && a.y == b.y) {
+            // Стоящий на месте собиратель ничего не подбирает
+            continue;
+        }
+        // Предмет можно подобрать, только если он не дальше суммы ширин от отрезка
+        for_each_candidate(
+            a, b, gatherer_width + max_item_width,
+            [&](const size_t* ids, const double* x, const double* y, const double* width,
+                size_t count) {
+                if (collected.size() < count) {
+                    collected.resize(count);
+                    sq_distances.resize(count);
+                    proj_ratios.resize(count);
+                }
+                const CollectedPoints out{collected.data(), sq_distances.data(),
+                                          proj_ratios.data()};
+                // Для коротких столбцов выбор векторной реализации не окупается
+                const size_t found =
+                    count < 4
+                        ? TryCollectPointsScalar(a, b, gatherer_width, x, y, width, count, out)
+                        : TryCollectPoints(a, b, gatherer_width, x, y, width, count, out);
+                for (size_t i = 0; i < found; ++i) {
+                    events.push_back(
+                        {ids[collected[i]], gatherer_id, sq_distances[i], proj_ratios[i]});
+                }
+            });
+    }
+    std::sort(events.begin() + first_event, events.end(), IsEarlier);
+}
+
+// Количество собирателей, которые поток обрабатывает за раз
+constexpr size_t GATHERERS_PER_CHUNK = 1024;
+
+// Находит события, обрабатывая собирателей частями в num_threads потоках
+template <typename ForEachCandidate>
+std::vector<GatheringEvent> FindEvents(const ForEachCandidate& for_each_candidate,
+                                       double max_item_width, const GathererColumns& gatherers,
+                                       unsigned num_threads) {
+    std::vector<GatheringEvent> events;
+    const size_t chunk_count = (gatherers.Size() + GATHERERS_PER_CHUNK - 1) / GATHERERS_PER_CHUNK;
+    num_threads = static_cast<unsigned>(std::min<size_t>(std::max(1u, num_threads), chunk_count));
+    if (num_threads <= 1) {
+        FindChunkEvents(for_each_candidate, max_item_width, gatherers, 0, gatherers.Size(),
+                        events);
+        return events;
+    }
+
+    // Потоки разбирают части собирателей по очереди. Результат каждой части упорядочен
+    // и хранится отдельно, поэтому слияние не зависит от того, какой поток её обработал
+    std::vector<std::vector<GatheringEvent>> chunk_events(chunk_count);
+    std::vector<std::exception_ptr> errors(chunk_count);
+    std::atomic<size_t> next{0};
+    const auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunk_count;) {
+            try {
+                const size_t begin = i * GATHERERS_PER_CHUNK;
+                FindChunkEvents(for_each_candidate, max_item_width, gatherers, begin,
+                                std::min(begin + GATHERERS_PER_CHUNK, gatherers.Size()),
+                                chunk_events[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(num_threads - 1);
+        for (unsigned i = 1; i < num_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Сливаем упорядоченные части попарно
+    std::vector<size_t> bounds{0};
+    for (auto& chunk : chunk_events) {
+        events.insert(events.end(), chunk.begin(), chunk.end());
+        bounds.push_back(events.size());
+        std::vector<GatheringEvent>{}.swap(chunk);
+    }
+    for (size_t step = 1; step < chunk_count; step *= 2) {
+        for (size_t i = 0; i + step < chunk_count; i += 2 * step) {
+            const auto middle = events.begin() + bounds[i + step];
+            const auto end = events.begin() + bounds[std::min(i + 2 * step, chunk_count)];
+            std::inplace_merge(events.begin() + bounds[i], middle, end, IsEarlier);
+        }
+    }
+    return events;
+}
+
+// Находит события собирателей с предметами классов classes через общую сетку.
+// Номера предметов в событиях - номера в сетке (см. ItemGrid).
+// Классы должны содержать хотя бы один предмет, а собиратели - хотя бы одного собирателя
+std::vector<GatheringEvent> FindGridEvents(std::span<const ItemColumns> classes,
+                                           const GathererColumns& gatherers, unsigned num_threads) {
+    const ItemGrid grid{classes, ChooseCellSize(classes, gatherers)};
+    return FindEvents(
+        [&grid](geom::Point2D a, geom::Point2D b, double reach, auto&& fn) {
+            grid.ForEachCandidate(a, b, reach, fn);
+        },
+        grid.GetMaxWidth(), gatherers, num_threads);
+}
+
+}  // namespace
+
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    return FindGatherEvents(provider, std::thread::hardware_concurrency());
+}
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider,
+                                             unsigned num_threads) {
+    if (provider.ItemsCount() == 0 || provider.GatherersCount() == 0) {
+        return {};
+    }
+
+    // Выбор размера ячейки полагается на то, что предметы и собиратели есть
+    const ProviderColumns columns{provider};
+    return FindGridEvents({&columns.GetItems(), 1}, columns.GetGatherers(), num_threads);
+}
+
+std::vector<CollisionEvent> FindCollisionEvents(std::span<const ItemColumns> target_classes,
+                                                const GathererColumns& gatherers) {
+    return FindCollisionEvents(target_classes, gatherers, std::thread::hardware_concurrency());
+}
+
+std::vector<CollisionEvent> FindCollisionEvents(std::span<const ItemColumns> target_classes,
+                                                const GathererColumns& gatherers,
+                                                unsigned num_threads) {
+    // Номер первого объекта каждого класса в общей сетке
+    std::vector<size_t> offsets;
+    offsets.reserve(target_classes.size());
+    size_t target_count = 0;
+    for (const auto& targets : target_classes) {
+        offsets.push_back(target_count);
+        target_count += targets.Size();
+    }
+    if (target_count == 0 || gatherers.Size() == 0) {
+        return {};
+    }
+
+    const auto grid_events = FindGridEvents(target_classes, gatherers, num_threads);
+    // Номера в сетке возрастают вместе с номерами класса и объекта,
+    // поэтому события остаются упорядоченными
+    std::vector<CollisionEvent> events;
+    events.reserve(grid_events.size());
+    for (const auto& event : grid_events) {
+        // Пустые классы имеют тот же сдвиг, что и следующий класс, и пропускаются
+        const size_t target_class =
+            std::upper_bound(offsets.begin(), offsets.end(), event.item_id) - offsets.begin() - 1;
+        events.push_back({target_class, event.item_id - offsets[target_class], event.gatherer_id,
+                          event.sq_distance, event.time});
+    }
+    return events;
+}
+
+CollisionWorld::CollisionWorld(double cell_size)
+    : cell_size_{cell_size} {
+    if (!(cell_size > 0) || !std::isfinite(cell_size)) {
+        throw std::invalid_argument("Cell size must be positive");
+    }
+}
+
+void CollisionWorld::AddItem(size_t id, Item item) {
+    if (locations_.contains(id)) {
+        throw std::invalid_argument("Duplicate item id " + std::to_string(id));
+    }
+    const auto key = GetCellKey(GetCell(item.position.x, cell_size_),
+                                GetCell(item.position.y, cell_size_));
+    auto& cell = cells_[key];
+    const size_t index = cell.ids.size();
+    try {
+        ReserveGrowing(cell.ids, index + 1);
+        for (auto* column : {&cell.x, &cell.y, &cell.width}) {
+            ReserveGrowing(*column, index + 1);
+        }
+        locations_.emplace(id, Location{key, index});
+    } catch (...) {
+        if (cell.ids.empty()) {
+            cells_.erase(key);
+        }
+        throw;
+    }
+
+    // После резервирования места добавление в столбцы не выбрасывает исключений
+    cell.ids.push_back(id);
+    cell.x.push_back(item.position.x);
+    cell.y.push_back(item.position.y);
+    cell.width.push_back(item.width);
+    max_width_ = std::max(max_width_, item.width);
+}
+
+bool CollisionWorld::RemoveItem(size_t id) {
+    const auto location = locations_.find(id);
+    if (location == locations_.end()) {
+        return false;
+    }
+    const auto cell_it = cells_.find(location->second.cell);
+    auto& cell = cell_it->second;
+    const size_t index = location->second.index;
+    const size_t last = cell.ids.size() - 1;
+    // Место удалённого предмета занимает последний предмет ячейки
+    if (index != last) {
+        locations_[cell.ids[last]].index = index;
+        cell.ids[index] = cell.ids[last];
+        cell.x[index] = cell.x[last];
+        cell.y[index] = cell.y[last];
+        cell.width[index] = cell.width[last];
+    }
+    cell.ids.pop_back();
+    cell.x.pop_back();
+    cell.y.pop_back();
+    cell.width.pop_back();
+    if (cell.ids.empty()) {
+        cells_.erase(cell_it);
+    }
+    locations_.erase(location);
+    return true;
+}
+
+template <typename Fn>
+void CollisionWorld::ForEachCandidate(geom::Point2D a, geom::Point2D b, double reach,
+                                      Fn&& fn) const {
+    const auto pass_cell = [&fn](const Cell& cell) {
+        fn(cell.ids.data(), cell.x.data(), cell.y.data(), cell.width.data(), cell.ids.size());
+    };
+    const SegmentCells segment_cells{a, b, reach, cell_size_};
+    const double limit = double(cells_.size());
+    if (!segment_cells.IsOrdered() || segment_cells.Count(limit) > limit) {
+        for (const auto& [key, cell] : cells_) {
+            pass_cell(cell);
+        }
+        return;
+    }
+    segment_cells.ForEachColumn([&](std::int64_t x, std::int64_t y0, std::int64_t y1) {
+        for (auto y = y0; y <= y1; ++y) {
+            if (const auto it = cells_.find(GetCellKey(x, y)); it != cells_.end()) {
+                pass_cell(it->second);
+            }
+        }
+    });
+}
+
+std::vector<GatheringEvent> CollisionWorld::FindGatherEvents(const GathererColumns& gatherers,
+                                                             unsigned num_threads) const {
+    if (locations_.empty()) {
+        return {};
+    }
+    return FindEvents(
+        [this](geom::Point2D a, geom::Point2D b, double reach, auto&& fn) {
+            ForEachCandidate(a, b, reach, fn);
+        },
+        max_width_, gatherers, num_threads);
 }
-*/
 
-}  // namespace collision_detector
\ No newline at end of file
+}  // namespace collision_detector
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace collision_detector {
@@ -23,6 +26,22 @@ struct CollectionResult {
 // Эта функция реализована в уроке.
 CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c);
 
+// Номера и результаты проверки подобранных точек по столбцам
+struct CollectedPoints {
+    size_t* index;
+    double* sq_distance;
+    double* proj_ratio;
+};
+
+// Движемся из точки a в точку b, имея ширину gatherer_width, и пытаемся подобрать точки
+// (x[i], y[i]) шириной width[i]. Для каждой подобранной точки по порядку записывает в out
+// её номер i и результат TryCollectPoint. Массивы out должны вмещать count элементов.
+// Возвращает количество подобранных точек.
+// Точки проверяются по нескольку за раз инструкциями AVX2, если процессор их поддерживает.
+// Результаты в точности совпадают с TryCollectPoint и CollectionResult::IsCollected
+size_t TryCollectPoints(geom::Point2D a, geom::Point2D b, double gatherer_width, const double* x,
+                        const double* y, const double* width, size_t count, CollectedPoints out);
+
 struct Item {
     geom::Point2D position;
     double width;
@@ -45,6 +64,67 @@ public:
     virtual Gatherer GetGatherer(size_t idx) const = 0;
 };
 
+// Объекты провайдера по столбцам: i-й предмет находится в (x[i], y[i]) и имеет ширину
+// width[i]. Все столбцы имеют одинаковую длину
+struct ItemColumns {
+    std::span<const double> x;
+    std::span<const double> y;
+    std::span<const double> width;
+
+    size_t Size() const noexcept {
+        return x.size();
+    }
+};
+
+// i-й собиратель перемещается из (start_x[i], start_y[i]) в (end_x[i], end_y[i])
+struct GathererColumns {
+    std::span<const double> start_x;
+    std::span<const double> start_y;
+    std::span<const double> end_x;
+    std::span<const double> end_y;
+    std::span<const double> width;
+
+    size_t Size() const noexcept {
+        return start_x.size();
+    }
+};
+
+/*
+ * Провайдер, хранящий предметы и собирателей в непрерывных массивах.
+ * FindGatherEvents читает такой провайдер через столбцы целиком, без вызова виртуальной
+ * функции для каждого объекта. Поэлементный интерфейс ItemGathererProvider реализован
+ * через столбцы для совместимости с другим кодом.
+ * Столбцы должны оставаться действительными, пока выполняется FindGatherEvents
+ */
+class BulkItemGathererProvider : public ItemGathererProvider {
+protected:
+    ~BulkItemGathererProvider() = default;
+
+public:
+    virtual ItemColumns GetItemColumns() const = 0;
+    virtual GathererColumns GetGathererColumns() const = 0;
+
+    size_t ItemsCount() const final {
+        return GetItemColumns().Size();
+    }
+
+    Item GetItem(size_t idx) const final {
+        const auto items = GetItemColumns();
+        return {{items.x[idx], items.y[idx]}, items.width[idx]};
+    }
+
+    size_t GatherersCount() const final {
+        return GetGathererColumns().Size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const final {
+        const auto gatherers = GetGathererColumns();
+        return {{gatherers.start_x[idx], gatherers.start_y[idx]},
+                {gatherers.end_x[idx], gatherers.end_y[idx]},
+                gatherers.width[idx]};
+    }
+};
+
 struct GatheringEvent {
     size_t item_id;
     size_t gatherer_id;
@@ -52,8 +132,96 @@ struct GatheringEvent {
     double time;
 };
 
-// Эту функцию вам нужно будет реализовать в соответствующем задании.
-// При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
+// Находит события сбора предметов собирателями, упорядоченные по времени, а одновременные
+// события - по номерам собирателя и предмета.
+// Провайдер BulkItemGathererProvider читается по столбцам, остальные - поэлементно.
+// Предметы раскладываются по равномерной сетке, и точная проверка выполняется только
+// для предметов из ячеек вблизи пути собирателя, поэтому время работы близко
+// к линейному от числа собирателей и предметов.
+// Собиратели обрабатываются частями в num_threads потоках. Результат не зависит
+// от числа потоков. Вариант без num_threads использует все ядра процессора
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider,
+                                             unsigned num_threads);
+
+struct CollisionEvent {
+    // Номер класса объекта в списке классов и номер объекта в классе
+    size_t target_class;
+    size_t target_id;
+    size_t gatherer_id;
+    double sq_distance;
+    double time;
+};
+
+// Находит события столкновения собирателей с объектами нескольких классов, например
+// с предметами и базами, в которые собиратели относят найденное. Объекты i-го класса
+// заданы столбцами target_classes[i], и у каждого объекта своя ширина, поэтому классы
+// могут иметь разные радиусы столкновения.
+// Объекты всех классов раскладываются в одну сетку, и для каждого собирателя выполняется
+// один запрос к ней, а не по запросу на класс. События всех классов возвращаются одним
+// потоком, упорядоченным по времени, а одновременные события - по номерам собирателя,
+// класса и объекта. Так собиратель, подобравший предмет и дошедший до базы за один тик,
+// сначала подбирает предмет, а затем сдаёт его.
+// Собиратели обрабатываются в num_threads потоках, как в FindGatherEvents
+std::vector<CollisionEvent> FindCollisionEvents(std::span<const ItemColumns> target_classes,
+                                                const GathererColumns& gatherers);
+std::vector<CollisionEvent> FindCollisionEvents(std::span<const ItemColumns> target_classes,
+                                                const GathererColumns& gatherers,
+                                                unsigned num_threads);
+
+/*
+ * Предметы, хранящиеся между тиками в равномерной сетке.
+ * Предметы редко перемещаются, поэтому сетка не перестраивается на каждом тике:
+ * появление и подбор предмета изменяют только его ячейку. Запрос проверяет лишь
+ * предметы из ячеек вдоль пути собирателя и стоит O(собиратели x плотность предметов).
+ * Для изменения мира нужен исключительный доступ, запросы можно выполнять одновременно
+ */
+class CollisionWorld {
+public:
+    // cell_size - сторона ячейки сетки. Хорошо подходит сумма наибольших ширин предмета
+    // и собирателя или длина перемещения собирателя за тик, если она больше.
+    // Если cell_size не положительна, выбрасывает std::invalid_argument
+    explicit CollisionWorld(double cell_size);
+
+    // Добавляет предмет с номером id. Если такой номер уже есть, выбрасывает
+    // std::invalid_argument
+    void AddItem(size_t id, Item item);
+
+    // Удаляет предмет. Возвращает false, если предмета с номером id нет
+    bool RemoveItem(size_t id);
+
+    size_t ItemsCount() const noexcept {
+        return locations_.size();
+    }
+
+    // Находит события сбора предметов мира собирателями gatherers в том же порядке,
+    // что и FindGatherEvents. item_id событий - номера предметов, заданные в AddItem
+    std::vector<GatheringEvent> FindGatherEvents(const GathererColumns& gatherers,
+                                                 unsigned num_threads = 1) const;
+
+private:
+    // Предметы ячейки по столбцам
+    struct Cell {
+        std::vector<size_t> ids;
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> width;
+    };
+
+    struct Location {
+        std::uint64_t cell;
+        size_t index;
+    };
+
+    template <typename Fn>
+    void ForEachCandidate(geom::Point2D a, geom::Point2D b, double reach, Fn&& fn) const;
+
+    double cell_size_;
+    // Наибольшая ширина среди когда-либо добавленных предметов. Не уменьшается
+    // при удалении предметов, что лишь немного расширяет область поиска
+    double max_width_ = 0;
+    std::unordered_map<std::uint64_t, Cell> cells_;
+    std::unordered_map<size_t, Location> locations_;
+};
 
-}  // namespace collision_detector
\ No newline at end of file
+}  // namespace collision_detector
\ No newline at end of file
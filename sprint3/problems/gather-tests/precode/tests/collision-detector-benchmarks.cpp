@@ -0,0 +1,154 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "../src/collision_detector.h"
+#include "bench_harness.h"
+
+/*
+ * Замеры производительности FindGatherEvents на синтетических данных.
+ * Запускаются отдельной программой collision_detection_benchmarks, например:
+ *   collision_detection_benchmarks --filter uniform --samples 10 [наибольший размер]
+ * Размеры растут от 10 до наибольшего (по умолчанию 100000) в 10 раз,
+ * параметры замеров описаны в bench_harness.h
+ */
+
+using namespace collision_detector;
+using namespace std::literals;
+
+namespace {
+
+class ColumnProvider : public BulkItemGathererProvider {
+public:
+    ItemColumns GetItemColumns() const override {
+        return {x, y, width};
+    }
+
+    GathererColumns GetGathererColumns() const override {
+        return {start_x, start_y, end_x, end_y, gatherer_width};
+    }
+
+    void AddItem(geom::Point2D position, double item_width) {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        width.push_back(item_width);
+    }
+
+    void AddGatherer(geom::Point2D start, geom::Point2D end, double width) {
+        start_x.push_back(start.x);
+        start_y.push_back(start.y);
+        end_x.push_back(end.x);
+        end_y.push_back(end.y);
+        gatherer_width.push_back(width);
+    }
+
+private:
+    std::vector<double> x, y, width;
+    std::vector<double> start_x, start_y, end_x, end_y, gatherer_width;
+};
+
+constexpr double ITEM_WIDTH = 0;
+constexpr double GATHERER_WIDTH = 0.6;
+
+// Сторона квадратной карты, на которой size объектов лежат с плотностью
+// один объект на 100 единиц площади
+double GetMapSide(size_t size) {
+    return 10 * std::sqrt(double(size));
+}
+
+// Предметы и собиратели равномерно распределены по карте. За тик собиратель
+// проходит не больше одной единицы по каждой оси
+ColumnProvider MakeUniform(size_t size, std::uint64_t seed) {
+    std::mt19937 random{static_cast<std::mt19937::result_type>(seed + 1)};
+    std::uniform_real_distribution<double> coord{0, GetMapSide(size)};
+    std::uniform_real_distribution<double> step{-1, 1};
+    ColumnProvider provider;
+    for (size_t i = 0; i < size; ++i) {
+        provider.AddItem({coord(random), coord(random)}, ITEM_WIDTH);
+        const geom::Point2D start{coord(random), coord(random)};
+        provider.AddGatherer(start, {start.x + step(random), start.y + step(random)},
+                             GATHERER_WIDTH);
+    }
+    return provider;
+}
+
+// Предметы и собиратели сосредоточены вокруг немногих точек карты
+ColumnProvider MakeClustered(size_t size, std::uint64_t seed) {
+    std::mt19937 random{static_cast<std::mt19937::result_type>(seed + 2)};
+    std::uniform_real_distribution<double> coord{0, GetMapSide(size)};
+    std::normal_distribution<double> offset{0, 3};
+    std::uniform_real_distribution<double> step{-1, 1};
+    std::vector<geom::Point2D> centers(std::max<size_t>(1, size / 1000));
+    for (auto& center : centers) {
+        center = {coord(random), coord(random)};
+    }
+    std::uniform_int_distribution<size_t> cluster{0, centers.size() - 1};
+    const auto near_center = [&] {
+        const auto center = centers[cluster(random)];
+        return geom::Point2D{center.x + offset(random), center.y + offset(random)};
+    };
+    ColumnProvider provider;
+    for (size_t i = 0; i < size; ++i) {
+        provider.AddItem(near_center(), ITEM_WIDTH);
+        const auto start = near_center();
+        provider.AddGatherer(start, {start.x + step(random), start.y + step(random)},
+                             GATHERER_WIDTH);
+    }
+    return provider;
+}
+
+// Предметы равномерно распределены по карте, а собиратели проходят за тик длинные
+// диагональные отрезки длиной в десятую часть стороны карты
+ColumnProvider MakeLongDiagonals(size_t size, std::uint64_t seed) {
+    std::mt19937 random{static_cast<std::mt19937::result_type>(seed + 3)};
+    const double side = GetMapSide(size);
+    std::uniform_real_distribution<double> coord{0, side};
+    std::bernoulli_distribution sign;
+    ColumnProvider provider;
+    for (size_t i = 0; i < size; ++i) {
+        provider.AddItem({coord(random), coord(random)}, ITEM_WIDTH);
+        const geom::Point2D start{coord(random), coord(random)};
+        const double dx = (sign(random) ? 1 : -1) * side / 10;
+        const double dy = (sign(random) ? 1 : -1) * side / 10;
+        provider.AddGatherer(start, {start.x + dx, start.y + dy}, GATHERER_WIDTH);
+    }
+    return provider;
+}
+
+struct Distribution {
+    const char* name;
+    ColumnProvider (*make_provider)(size_t size, std::uint64_t seed);
+};
+
+constexpr Distribution DISTRIBUTIONS[]{
+    {"uniform", MakeUniform}, {"clustered", MakeClustered}, {"diagonal", MakeLongDiagonals}};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"collision_detector", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t max_size = options.positional.empty() ? 100'000 : std::stoul(options.positional[0]);
+
+    for (size_t size = 10; size <= max_size; size *= 10) {
+        for (const auto& distribution : DISTRIBUTIONS) {
+            const auto provider = distribution.make_provider(size, options.seed);
+            suite.Run("FindGatherEvents/"s + distribution.name + "/"s + std::to_string(size), [&] {
+                bench::DoNotOptimize(FindGatherEvents(provider));
+            });
+        }
+
+        const auto provider = MakeUniform(size, options.seed);
+        // Ячейка того же размера, что выбирает FindGatherEvents: около одного предмета на ячейку
+        CollisionWorld world{10};
+        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+            world.AddItem(i, provider.GetItem(i));
+        }
+        const auto gatherers = provider.GetGathererColumns();
+        suite.Run("CollisionWorld/uniform/"s + std::to_string(size), [&] {
+            bench::DoNotOptimize(world.FindGatherEvents(gatherers));
+        });
+    }
+    return suite.Finish();
+}
@@ -1,5 +1,422 @@
 #define _USE_MATH_DEFINES
 
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <optional>
+#include <random>
+
 #include "../src/collision_detector.h"
 
-// Напишите здесь тесты для функции collision_detector::FindGatherEvents
\ No newline at end of file
+using namespace collision_detector;
+using Catch::Approx;
+
+namespace {
+
+class TestProvider : public ItemGathererProvider {
+public:
+    TestProvider(std::vector<Item> items, std::vector<Gatherer> gatherers)
+        : items_{std::move(items)}
+        , gatherers_{std::move(gatherers)} {
+    }
+
+    size_t ItemsCount() const override {
+        return items_.size();
+    }
+
+    Item GetItem(size_t idx) const override {
+        return items_.at(idx);
+    }
+
+    size_t GatherersCount() const override {
+        return gatherers_.size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const override {
+        return gatherers_.at(idx);
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Gatherer> gatherers_;
+};
+
+// Хранит копию объектов другого провайдера по столбцам
+class ColumnProvider : public BulkItemGathererProvider {
+public:
+    explicit ColumnProvider(const ItemGathererProvider& provider) {
+        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+            const auto item = provider.GetItem(i);
+            x_.push_back(item.position.x);
+            y_.push_back(item.position.y);
+            width_.push_back(item.width);
+        }
+        for (size_t i = 0; i < provider.GatherersCount(); ++i) {
+            const auto gatherer = provider.GetGatherer(i);
+            start_x_.push_back(gatherer.start_pos.x);
+            start_y_.push_back(gatherer.start_pos.y);
+            end_x_.push_back(gatherer.end_pos.x);
+            end_y_.push_back(gatherer.end_pos.y);
+            gatherer_width_.push_back(gatherer.width);
+        }
+    }
+
+    ItemColumns GetItemColumns() const override {
+        return {x_, y_, width_};
+    }
+
+    GathererColumns GetGathererColumns() const override {
+        return {start_x_, start_y_, end_x_, end_y_, gatherer_width_};
+    }
+
+private:
+    std::vector<double> x_, y_, width_;
+    std::vector<double> start_x_, start_y_, end_x_, end_y_, gatherer_width_;
+};
+
+// Проверяет каждую пару предмета и собирателя
+std::vector<GatheringEvent> FindGatherEventsNaive(const ItemGathererProvider& provider) {
+    std::vector<GatheringEvent> events;
+    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+        const auto gatherer = provider.GetGatherer(g);
+        if (gatherer.start_pos.x == gatherer.end_pos.x && gatherer.start_pos.y == gatherer.end_pos.y) {
+            continue;
+        }
+        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+            const auto item = provider.GetItem(i);
+            const auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+            if (result.IsCollected(gatherer.width + item.width)) {
+                events.push_back({i, g, result.sq_distance, result.proj_ratio});
+            }
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
+        return std::tie(lhs.time, lhs.gatherer_id, lhs.item_id)
+             < std::tie(rhs.time, rhs.gatherer_id, rhs.item_id);
+    });
+    return events;
+}
+
+}  // namespace
+
+namespace collision_detector {
+
+bool operator==(const GatheringEvent& lhs, const GatheringEvent& rhs) {
+    return lhs.item_id == rhs.item_id && lhs.gatherer_id == rhs.gatherer_id
+        && lhs.sq_distance == rhs.sq_distance && lhs.time == rhs.time;
+}
+
+}  // namespace collision_detector
+
+SCENARIO("Collecting many points at once") {
+    GIVEN("points around a diagonal segment") {
+        std::mt19937 random{7};
+        std::uniform_real_distribution<double> coord{-3, 13};
+        std::uniform_real_distribution<double> width{0, 1};
+        // Количество точек не кратно ширине векторного регистра
+        const size_t count = 103;
+        std::vector<double> x, y, widths;
+        for (size_t i = 0; i < count; ++i) {
+            x.push_back(coord(random));
+            y.push_back(coord(random));
+            widths.push_back(width(random));
+        }
+        const geom::Point2D a{0, 0};
+        const geom::Point2D b{10, 9};
+        const double gatherer_width = 0.6;
+
+        THEN("results match the single point version") {
+            std::vector<size_t> index(count);
+            std::vector<double> sq_distance(count), proj_ratio(count);
+            const size_t collected =
+                TryCollectPoints(a, b, gatherer_width, x.data(), y.data(), widths.data(), count,
+                                 {index.data(), sq_distance.data(), proj_ratio.data()});
+
+            size_t expected = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const auto result = TryCollectPoint(a, b, {x[i], y[i]});
+                if (!result.IsCollected(gatherer_width + widths[i])) {
+                    continue;
+                }
+                REQUIRE(expected < collected);
+                CHECK(index[expected] == i);
+                CHECK(sq_distance[expected] == result.sq_distance);
+                CHECK(proj_ratio[expected] == result.proj_ratio);
+                ++expected;
+            }
+            CHECK(collected == expected);
+            CHECK(expected > 0);
+        }
+    }
+}
+
+SCENARIO("Gather events") {
+    GIVEN("a gatherer moving along the x axis") {
+        const Gatherer gatherer{{0, 0}, {10, 0}, 0.6};
+
+        WHEN("items lie near and far from its path") {
+            const TestProvider provider{{{{5, 0.5}, 0.1}, {{2, 0}, 0}, {{5, 1}, 0.1}, {{11, 0}, 0}},
+                                        {gatherer}};
+            const auto events = FindGatherEvents(provider);
+
+            THEN("only reachable items are collected in time order") {
+                REQUIRE(events.size() == 2);
+                CHECK(events[0].item_id == 1);
+                CHECK(events[0].time == Approx(0.2));
+                CHECK(events[0].sq_distance == Approx(0));
+                CHECK(events[1].item_id == 0);
+                CHECK(events[1].gatherer_id == 0);
+                CHECK(events[1].time == Approx(0.5));
+                CHECK(events[1].sq_distance == Approx(0.25));
+            }
+        }
+
+        WHEN("an item lies on the border of the collection zone") {
+            const TestProvider provider{{{{10, 0.6}, 0}}, {gatherer}};
+
+            THEN("it is collected at the end of the move") {
+                const auto events = FindGatherEvents(provider);
+                REQUIRE(events.size() == 1);
+                CHECK(events[0].time == Approx(1));
+            }
+        }
+    }
+
+    GIVEN("a gatherer crossing the coordinate axes") {
+        std::vector<Item> items;
+        for (int i = -50; i < 50; ++i) {
+            items.push_back({{0.5, i + 0.5}, 0});
+        }
+        const TestProvider provider{std::move(items), {{{0.5, -3}, {0.5, 3}, 0.5}}};
+
+        THEN("items on both sides of the axes are collected") {
+            CHECK(FindGatherEvents(provider) == FindGatherEventsNaive(provider));
+            CHECK(FindGatherEvents(provider).size() == 6);
+        }
+    }
+
+    GIVEN("a gatherer that does not move") {
+        const TestProvider provider{{{{0, 0}, 1}}, {{{0, 0}, {0, 0}, 1}}};
+
+        THEN("it collects nothing") {
+            CHECK(FindGatherEvents(provider).empty());
+        }
+    }
+
+    GIVEN("no items or no gatherers") {
+        THEN("there are no events") {
+            CHECK(FindGatherEvents(TestProvider{{}, {{{0, 0}, {1, 0}, 1}}}).empty());
+            CHECK(FindGatherEvents(TestProvider{{{{0, 0}, 1}}, {}}).empty());
+        }
+    }
+
+    GIVEN("several gatherers picking the same item") {
+        const TestProvider provider{{{{5, 0}, 0}},
+                                    {{{0, 0}, {10, 0}, 0.5}, {{5, -5}, {5, 5}, 0.5}}};
+
+        THEN("simultaneous events are ordered by gatherer") {
+            const auto events = FindGatherEvents(provider);
+            REQUIRE(events.size() == 2);
+            CHECK(events[0].gatherer_id == 0);
+            CHECK(events[1].gatherer_id == 1);
+            CHECK(events[0].time == events[1].time);
+        }
+    }
+
+    GIVEN("many random items and gatherers") {
+        std::mt19937 random{42};
+        std::uniform_real_distribution<double> coord{-50, 50};
+        std::uniform_real_distribution<double> step{-5, 5};
+        std::uniform_real_distribution<double> width{0, 1};
+        std::vector<Item> items;
+        for (int i = 0; i < 2000; ++i) {
+            items.push_back({{coord(random), coord(random)}, width(random)});
+        }
+        std::vector<Gatherer> gatherers;
+        // Собирателей больше, чем обрабатывает за раз один поток
+        for (int i = 0; i < 5000; ++i) {
+            const geom::Point2D start{coord(random), coord(random)};
+            // Длинные диагональные перемещения охватывают много ячеек сетки
+            const double scale = i % 50 == 0 ? 20 : 1;
+            gatherers.push_back(
+                {start, {start.x + step(random) * scale, start.y + step(random) * scale}, width(random)});
+        }
+        const TestProvider provider{std::move(items), std::move(gatherers)};
+
+        THEN("events match the exhaustive search") {
+            const auto expected = FindGatherEventsNaive(provider);
+            CHECK(!expected.empty());
+            CHECK(FindGatherEvents(provider) == expected);
+        }
+
+        THEN("events do not depend on the number of threads") {
+            const auto expected = FindGatherEvents(provider, 1);
+            for (unsigned threads : {2u, 3u, 8u}) {
+                CHECK(FindGatherEvents(provider, threads) == expected);
+            }
+        }
+
+        THEN("a provider with columns gives the same events") {
+            const ColumnProvider columns{provider};
+            CHECK(columns.GetItem(7).position == provider.GetItem(7).position);
+            CHECK(FindGatherEvents(columns) == FindGatherEventsNaive(provider));
+        }
+    }
+}
+
+SCENARIO("Collision events with several target classes") {
+    GIVEN("a gatherer passing an item and then an office") {
+        const TestProvider items{{{{2, 0}, 0}, {{8, 3}, 0}}, {{{0, 0}, {10, 0}, 0.6}}};
+        // База шире предмета и достаётся собирателю, проходящему дальше от её центра
+        const TestProvider offices{{{{30, 0}, 0.5}, {{6, 1}, 0.5}}, {}};
+        const ColumnProvider item_columns{items};
+        const ColumnProvider office_columns{offices};
+        const ItemColumns classes[] = {item_columns.GetItemColumns(), office_columns.GetItemColumns()};
+
+        WHEN("collision events are found") {
+            const auto events = FindCollisionEvents(classes, item_columns.GetGathererColumns());
+
+            THEN("both classes are reported in one time-ordered stream") {
+                REQUIRE(events.size() == 2);
+                CHECK(events[0].target_class == 0);
+                CHECK(events[0].target_id == 0);
+                CHECK(events[0].time == Approx(0.2));
+                CHECK(events[1].target_class == 1);
+                CHECK(events[1].target_id == 1);
+                CHECK(events[1].gatherer_id == 0);
+                CHECK(events[1].time == Approx(0.6));
+                CHECK(events[1].sq_distance == Approx(1));
+            }
+        }
+    }
+
+    GIVEN("many gatherers, items and offices of different widths") {
+        std::mt19937 random{7};
+        std::uniform_real_distribution<double> coord{0, 200};
+        std::uniform_real_distribution<double> step{-5, 5};
+        std::vector<Item> items;
+        for (int i = 0; i < 1000; ++i) {
+            items.push_back({{coord(random), coord(random)}, 0});
+        }
+        std::vector<Item> offices;
+        for (int i = 0; i < 50; ++i) {
+            offices.push_back({{coord(random), coord(random)}, 2});
+        }
+        std::vector<Gatherer> gatherers;
+        for (int i = 0; i < 2000; ++i) {
+            const geom::Point2D start{coord(random), coord(random)};
+            gatherers.push_back({start, {start.x + step(random), start.y + step(random)}, 0.6});
+        }
+        const TestProvider item_provider{std::move(items), gatherers};
+        const TestProvider office_provider{std::move(offices), std::move(gatherers)};
+        const ColumnProvider item_columns{item_provider};
+        const ColumnProvider office_columns{office_provider};
+        const ItemColumns no_targets{};
+        const ItemColumns classes[] = {item_columns.GetItemColumns(), no_targets,
+                                       office_columns.GetItemColumns()};
+
+        THEN("events are the events of each class merged by time") {
+            std::vector<CollisionEvent> expected;
+            for (const auto& event : FindGatherEventsNaive(item_provider)) {
+                expected.push_back({0, event.item_id, event.gatherer_id, event.sq_distance, event.time});
+            }
+            for (const auto& event : FindGatherEventsNaive(office_provider)) {
+                expected.push_back({2, event.item_id, event.gatherer_id, event.sq_distance, event.time});
+            }
+            std::sort(expected.begin(), expected.end(), [](const CollisionEvent& lhs, const CollisionEvent& rhs) {
+                return std::tie(lhs.time, lhs.gatherer_id, lhs.target_class, lhs.target_id)
+                     < std::tie(rhs.time, rhs.gatherer_id, rhs.target_class, rhs.target_id);
+            });
+            CHECK(std::count_if(expected.begin(), expected.end(), [](const CollisionEvent& event) {
+                return event.target_class == 2;
+            }) > 0);
+
+            for (unsigned threads : {1u, 4u}) {
+                const auto events = FindCollisionEvents(classes, item_columns.GetGathererColumns(), threads);
+                REQUIRE(events.size() == expected.size());
+                for (size_t i = 0; i < events.size(); ++i) {
+                    CHECK(events[i].target_class == expected[i].target_class);
+                    CHECK(events[i].target_id == expected[i].target_id);
+                    CHECK(events[i].gatherer_id == expected[i].gatherer_id);
+                    CHECK(events[i].time == expected[i].time);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Collision world") {
+    GIVEN("a world with random items") {
+        std::mt19937 random{11};
+        std::uniform_real_distribution<double> coord{-100, 100};
+        std::uniform_real_distribution<double> step{-3, 3};
+        std::uniform_real_distribution<double> width{0, 0.5};
+        CollisionWorld world{2};
+        std::vector<std::optional<Item>> items;
+        for (size_t id = 0; id < 5000; ++id) {
+            items.push_back(Item{{coord(random), coord(random)}, width(random)});
+            world.AddItem(id, *items.back());
+        }
+
+        std::vector<Gatherer> gatherers;
+        for (int i = 0; i < 3000; ++i) {
+            const geom::Point2D start{coord(random), coord(random)};
+            const double scale = i % 100 == 0 ? 30 : 1;
+            gatherers.push_back({start,
+                                 {start.x + step(random) * scale, start.y + step(random) * scale},
+                                 0.6});
+        }
+        const TestProvider gatherer_provider{{}, gatherers};
+        const ColumnProvider gatherer_columns{gatherer_provider};
+
+        // Ожидаемые события для оставшихся в мире предметов
+        const auto expected_events = [&] {
+            std::vector<Item> remaining;
+            std::vector<size_t> ids;
+            for (size_t id = 0; id < items.size(); ++id) {
+                if (items[id]) {
+                    remaining.push_back(*items[id]);
+                    ids.push_back(id);
+                }
+            }
+            auto events = FindGatherEventsNaive(TestProvider{std::move(remaining), gatherers});
+            for (auto& event : events) {
+                event.item_id = ids[event.item_id];
+            }
+            std::sort(events.begin(), events.end(), [](const auto& lhs, const auto& rhs) {
+                return std::tie(lhs.time, lhs.gatherer_id, lhs.item_id)
+                     < std::tie(rhs.time, rhs.gatherer_id, rhs.item_id);
+            });
+            return events;
+        };
+
+        THEN("it finds the same events as the exhaustive search") {
+            CHECK(world.ItemsCount() == items.size());
+            CHECK(world.FindGatherEvents(gatherer_columns.GetGathererColumns())
+                  == expected_events());
+        }
+
+        WHEN("items are collected and new items spawn") {
+            for (size_t id = 0; id < items.size(); id += 3) {
+                CHECK(world.RemoveItem(id));
+                items[id].reset();
+            }
+            for (size_t id = items.size(); id < 6000; ++id) {
+                items.push_back(Item{{coord(random), coord(random)}, width(random)});
+                world.AddItem(id, *items.back());
+            }
+
+            THEN("queries reflect the changes") {
+                CHECK(!world.RemoveItem(0));
+                CHECK_THROWS_AS(world.AddItem(1, {{0, 0}, 0}), std::invalid_argument);
+                const auto expected = expected_events();
+                const auto columns = gatherer_columns.GetGathererColumns();
+                CHECK(world.FindGatherEvents(columns) == expected);
+                CHECK(world.FindGatherEvents(columns, 4) == expected);
+            }
+        }
+    }
+
+    THEN("a non-positive cell size is rejected") {
+        CHECK_THROWS_AS(CollisionWorld{0}, std::invalid_argument);
+    }
+}
\ No newline at end of file
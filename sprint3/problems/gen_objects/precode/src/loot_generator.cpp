@@ -5,14 +5,23 @@
 
 namespace loot_gen {
 
+namespace detail {
+
+unsigned GetGeneratedLoot(unsigned loot_shortage, double ratio, double probability, double random) {
+    const double spawn_probability
+        = std::clamp((1.0 - std::pow(1.0 - probability, ratio)) * random, 0.0, 1.0);
+    return static_cast<unsigned>(std::round(loot_shortage * spawn_probability));
+}
+
+}  // namespace detail
+
 unsigned LootGenerator::Generate(TimeInterval time_delta, unsigned loot_count,
                                  unsigned looter_count) {
     time_without_loot_ += time_delta;
     const unsigned loot_shortage = loot_count > looter_count ? 0u : looter_count - loot_count;
     const double ratio = std::chrono::duration<double>{time_without_loot_} / base_interval_;
-    const double probability
-        = std::clamp((1.0 - std::pow(1.0 - probability_, ratio)) * random_generator_(), 0.0, 1.0);
-    const unsigned generated_loot = static_cast<unsigned>(std::round(loot_shortage * probability));
+    const unsigned generated_loot
+        = detail::GetGeneratedLoot(loot_shortage, ratio, probability_, random_generator_());
     if (generated_loot > 0) {
         time_without_loot_ = {};
     }
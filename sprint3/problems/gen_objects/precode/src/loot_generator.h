@@ -1,9 +1,20 @@
 #pragma once
+#include <cassert>
 #include <chrono>
 #include <functional>
+#include <span>
+#include <vector>
 
 namespace loot_gen {
 
+namespace detail {
+
+// Количество трофеев, которое появится при нехватке loot_shortage трофеев, если трофеи
+// не появлялись ratio базовых интервалов. random - случайное число от 0 до 1
+unsigned GetGeneratedLoot(unsigned loot_shortage, double ratio, double probability, double random);
+
+}  // namespace detail
+
 /*
  *  Генератор трофеев
  */
@@ -45,4 +56,116 @@ private:
     RandomGenerator random_generator_;
 };
 
+/*
+ * Генераторы трофеев множества карт, хранящиеся по столбцам.
+ * Все генераторы продвигаются за один вызов Generate на одинаковый отрезок времени.
+ * Генератор случайных чисел Random задаётся типом, а не std::function, поэтому его вызов
+ * встраивается в цикл. Случайное число запрашивается только у генераторов, которым
+ * не хватает трофеев, поэтому генераторы карт, где трофеев достаточно, обходятся
+ * в несколько сравнений. В остальном i-й генератор ведёт себя как LootGenerator
+ * с теми же параметрами и тем же генератором случайных чисел
+ */
+template <typename Random = double (*)()>
+class LootGeneratorBatch {
+public:
+    using TimeInterval = LootGenerator::TimeInterval;
+
+    /*
+     * random - генератор псевдослучайных чисел в диапазоне от [0 до 1], общий для всех
+     * генераторов. По умолчанию всегда возвращает 1
+     */
+    explicit LootGeneratorBatch(Random random = DefaultGenerator)
+        : random_{std::move(random)} {
+    }
+
+    /*
+     * Добавляет генератор и возвращает его номер.
+     * base_interval - базовый отрезок времени > 0
+     * probability - вероятность появления трофея в течение базового интервала времени
+     */
+    size_t Add(TimeInterval base_interval, double probability) {
+        const size_t index = Size();
+        try {
+            base_intervals_.push_back(base_interval);
+            probabilities_.push_back(probability);
+            time_without_loot_.emplace_back();
+        } catch (...) {
+            // Возвращаем столбцы к одинаковой длине
+            base_intervals_.resize(index);
+            probabilities_.resize(index);
+            throw;
+        }
+        return index;
+    }
+
+    size_t Size() const noexcept {
+        return base_intervals_.size();
+    }
+
+    /*
+     * Для каждого генератора i записывает в generated[i] количество трофеев, которые
+     * должны появиться на карте спустя time_delta, как LootGenerator::Generate.
+     * loot_counts[i] - количество трофеев на карте до вызова Generate
+     * looter_counts[i] - количество мародёров на карте
+     * Длина массивов должна совпадать с Size()
+     */
+    void Generate(TimeInterval time_delta, std::span<const unsigned> loot_counts,
+                  std::span<const unsigned> looter_counts, std::span<unsigned> generated) {
+        GenerateWith(time_delta, loot_counts, looter_counts, generated, [this](size_t) {
+            return random_();
+        });
+    }
+
+    /*
+     * То же, но генератор i использует случайное число randoms[i], а не число Random.
+     * Так число карты не зависит от того, каким ещё картам не хватило трофеев, и прогон
+     * воспроизводится, если randoms заполнены потоком, заданным сеансом и номером тика,
+     * например rng::PhiloxStream{session, tick}.Fill(randoms)
+     */
+    void Generate(TimeInterval time_delta, std::span<const unsigned> loot_counts,
+                  std::span<const unsigned> looter_counts, std::span<const double> randoms,
+                  std::span<unsigned> generated) {
+        assert(randoms.size() == Size());
+        GenerateWith(time_delta, loot_counts, looter_counts, generated, [randoms](size_t i) {
+            return randoms[i];
+        });
+    }
+
+private:
+    static double DefaultGenerator() noexcept {
+        return 1.0;
+    }
+
+    // random(i) вызывается только для генераторов, которым не хватает трофеев
+    template <typename GetRandom>
+    void GenerateWith(TimeInterval time_delta, std::span<const unsigned> loot_counts,
+                      std::span<const unsigned> looter_counts, std::span<unsigned> generated,
+                      GetRandom&& random) {
+        const size_t count = Size();
+        assert(loot_counts.size() == count && looter_counts.size() == count
+               && generated.size() == count);
+        for (size_t i = 0; i < count; ++i) {
+            time_without_loot_[i] += time_delta;
+            const unsigned loot = loot_counts[i];
+            const unsigned looters = looter_counts[i];
+            if (loot >= looters) {
+                generated[i] = 0;
+                continue;
+            }
+            const double ratio
+                = std::chrono::duration<double>{time_without_loot_[i]} / base_intervals_[i];
+            generated[i]
+                = detail::GetGeneratedLoot(looters - loot, ratio, probabilities_[i], random(i));
+            if (generated[i] > 0) {
+                time_without_loot_[i] = {};
+            }
+        }
+    }
+
+    std::vector<TimeInterval> base_intervals_;
+    std::vector<double> probabilities_;
+    std::vector<TimeInterval> time_without_loot_;
+    Random random_;
+};
+
 }  // namespace loot_gen
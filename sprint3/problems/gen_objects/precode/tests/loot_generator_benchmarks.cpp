@@ -0,0 +1,98 @@
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/loot_generator.h"
+#include "../../../../../common/rng/philox.h"
+#include "../../../../../common/bench/bench_harness.h"
+
+/*
+ * Замеры генерации трофеев на каждом тике для множества карт.
+ * Запускаются отдельной программой, например:
+ *   loot_generator_benchmarks --filter batch [наибольшее количество карт]
+ * Количество карт растёт от 10 до наибольшего (по умолчанию 100000) в 10 раз,
+ * параметры замеров описаны в bench_harness.h
+ */
+
+using namespace std::literals;
+
+namespace {
+
+constexpr loot_gen::LootGenerator::TimeInterval TICK = 50ms;
+
+// Состояние карт: базовый интервал, вероятность, трофеи и мародёры.
+// Трофеев не хватает примерно на половине карт
+struct Maps {
+    std::vector<loot_gen::LootGenerator::TimeInterval> intervals;
+    std::vector<double> probabilities;
+    std::vector<unsigned> loot_counts;
+    std::vector<unsigned> looter_counts;
+};
+
+Maps MakeMaps(size_t count, std::mt19937_64& random) {
+    std::uniform_int_distribution<int> interval_ms{1000, 10000};
+    std::uniform_real_distribution<double> probability{0.1, 0.9};
+    std::uniform_int_distribution<unsigned> count_dist{0, 20};
+    Maps maps;
+    for (size_t i = 0; i < count; ++i) {
+        maps.intervals.emplace_back(interval_ms(random));
+        maps.probabilities.push_back(probability(random));
+        maps.loot_counts.push_back(count_dist(random));
+        maps.looter_counts.push_back(count_dist(random));
+    }
+    return maps;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"loot_generator", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t max_count = options.positional.empty() ? 100'000 : std::stoul(options.positional[0]);
+
+    std::mt19937_64 random{options.seed};
+    std::uniform_real_distribution<double> unit{0, 1};
+    const auto next_random = [&random, &unit] {
+        return unit(random);
+    };
+
+    for (size_t count = 10; count <= max_count; count *= 10) {
+        const auto maps = MakeMaps(count, random);
+
+        // Отдельный генератор на каждую карту, случайные числа через std::function
+        std::vector<loot_gen::LootGenerator> generators;
+        generators.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            generators.emplace_back(maps.intervals[i], maps.probabilities[i], next_random);
+        }
+        suite.Run("LootGenerator/per-map/"s + std::to_string(count), [&] {
+            unsigned generated = 0;
+            for (size_t i = 0; i < count; ++i) {
+                generated += generators[i].Generate(TICK, maps.loot_counts[i], maps.looter_counts[i]);
+            }
+            bench::DoNotOptimize(generated);
+        });
+
+        // Все карты в одном генераторе по столбцам
+        loot_gen::LootGeneratorBatch batch{next_random};
+        for (size_t i = 0; i < count; ++i) {
+            batch.Add(maps.intervals[i], maps.probabilities[i]);
+        }
+        std::vector<unsigned> generated(count);
+        suite.Run("LootGenerator/batch/"s + std::to_string(count), [&] {
+            batch.Generate(TICK, maps.loot_counts, maps.looter_counts, generated);
+            bench::DoNotOptimize(generated.data());
+        });
+
+        // Случайные числа тика заполняются потоком Philox и не зависят от порядка карт
+        std::vector<double> randoms(count);
+        std::uint64_t tick = 0;
+        suite.Run("LootGenerator/batch-philox/"s + std::to_string(count), [&] {
+            rng::PhiloxStream{options.seed, tick++}.Fill(randoms);
+            batch.Generate(TICK, maps.loot_counts, maps.looter_counts, randoms, generated);
+            bench::DoNotOptimize(generated.data());
+        });
+    }
+    return suite.Finish();
+}
@@ -1,7 +1,10 @@
 #include <cmath>
 #include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <vector>
 
 #include "../src/loot_generator.h"
+#include "../../../../../common/rng/philox.h"
 
 using namespace std::literals;
 
@@ -72,3 +75,141 @@ SCENARIO("Loot generation") {
         }
     }
 }
+
+SCENARIO("Batch loot generation") {
+    using loot_gen::LootGenerator;
+    using loot_gen::LootGeneratorBatch;
+    using namespace std::chrono;
+
+    GIVEN("a batch of generators with different parameters") {
+        const auto random = [] {
+            return 0.75;
+        };
+        LootGeneratorBatch<decltype(random)> batch{random};
+        std::vector<LootGenerator> generators;
+        for (unsigned i = 0; i < 20; ++i) {
+            const milliseconds base_interval{500 + 250 * i};
+            const double probability = 0.05 * (i + 1);
+            CHECK(batch.Add(base_interval, probability) == i);
+            generators.emplace_back(base_interval, probability, random);
+        }
+
+        WHEN("the batch and separate generators advance together") {
+            THEN("they generate the same loot") {
+                std::vector<unsigned> loot(batch.Size()), looters(batch.Size());
+                std::vector<unsigned> generated(batch.Size());
+                for (unsigned tick = 0; tick < 200; ++tick) {
+                    for (size_t i = 0; i < batch.Size(); ++i) {
+                        looters[i] = static_cast<unsigned>((tick + i) % 7);
+                        loot[i] = static_cast<unsigned>((tick * 3 + i) % 5);
+                    }
+                    const milliseconds time_delta{10 + tick % 90};
+                    batch.Generate(time_delta, loot, looters, generated);
+                    for (size_t i = 0; i < batch.Size(); ++i) {
+                        INFO("tick: " << tick << ", generator: " << i);
+                        REQUIRE(generated[i] == generators[i].Generate(time_delta, loot[i], looters[i]));
+                    }
+                }
+            }
+        }
+    }
+
+    GIVEN("a batch with the default random generator") {
+        LootGeneratorBatch batch;
+        batch.Add(1s, 1.0);
+
+        THEN("every missing item is generated") {
+            const unsigned loot[] = {1};
+            const unsigned looters[] = {4};
+            unsigned generated[1];
+            batch.Generate(1s, loot, looters, generated);
+            CHECK(generated[0] == 3);
+        }
+    }
+}
+
+SCENARIO("Philox random streams") {
+    using rng::Philox4x32;
+    using rng::PhiloxStream;
+
+    GIVEN("the Philox4x32-10 block function") {
+        THEN("it matches the Random123 known answers") {
+            CHECK(Philox4x32::Generate({0, 0, 0, 0}, {0, 0})
+                  == Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+            CHECK(Philox4x32::Generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                       {0xffffffff, 0xffffffff})
+                  == Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+            CHECK(Philox4x32::Generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                       {0xa4093822, 0x299f31d0})
+                  == Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+        }
+    }
+
+    GIVEN("streams keyed by session and tick") {
+        THEN("the same key and stream repeat the same numbers") {
+            PhiloxStream first{42, 7}, second{42, 7};
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(first() == second());
+            }
+        }
+
+        THEN("different sessions and ticks give different numbers") {
+            CHECK(PhiloxStream{42, 7}.GetDouble(0) != PhiloxStream{43, 7}.GetDouble(0));
+            CHECK(PhiloxStream{42, 7}.GetDouble(0) != PhiloxStream{42, 8}.GetDouble(0));
+        }
+
+        THEN("sequential, indexed and bulk access agree") {
+            const PhiloxStream stream{1, 2};
+            PhiloxStream sequential = stream;
+            std::vector<double> all(11);
+            stream.Fill(all);
+            std::vector<double> tail(6);
+            stream.Fill(tail, 5);
+            for (size_t i = 0; i < all.size(); ++i) {
+                INFO("index: " << i);
+                CHECK(all[i] == sequential.NextDouble());
+                CHECK(all[i] == stream.GetDouble(i));
+                CHECK(all[i] >= 0.0);
+                CHECK(all[i] < 1.0);
+                if (i >= 5) {
+                    CHECK(tail[i - 5] == all[i]);
+                }
+            }
+        }
+
+        THEN("the stream works with standard distributions") {
+            PhiloxStream stream{3};
+            std::uniform_int_distribution<int> die{1, 6};
+            int sum = 0;
+            for (int i = 0; i < 6000; ++i) {
+                sum += die(stream);
+            }
+            CHECK(sum > 6000 * 3);
+            CHECK(sum < 6000 * 4);
+        }
+    }
+
+    GIVEN("a loot generator batch driven by per-tick streams") {
+        using loot_gen::LootGeneratorBatch;
+        LootGeneratorBatch batch;
+        for (int i = 0; i < 4; ++i) {
+            batch.Add(std::chrono::milliseconds{1000}, 0.5);
+        }
+
+        THEN("every map gets its own number regardless of the other maps") {
+            const unsigned loot[] = {0, 10, 0, 10};
+            const unsigned looters[] = {10, 0, 10, 0};
+            std::vector<double> randoms(batch.Size());
+            PhiloxStream{42, 1}.Fill(randoms);
+            unsigned generated[4];
+            batch.Generate(std::chrono::milliseconds{1000}, loot, looters, randoms, generated);
+            for (size_t i : {0, 2}) {
+                INFO("map: " << i);
+                CHECK(generated[i]
+                      == loot_gen::detail::GetGeneratedLoot(10, 1.0, 0.5, PhiloxStream{42, 1}.GetDouble(i)));
+            }
+            CHECK(generated[1] == 0);
+            CHECK(generated[3] == 0);
+        }
+    }
+}
@@ -1,6 +1,201 @@
 #include "htmldecode.h"
 
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+struct Entity {
+    std::string_view name;
+    char value;
+};
+
+constexpr Entity kEntities[] = {
+    {"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"apos", '\''}, {"quot", '"'},
+};
+
+// Корень и по узлу на каждую букву каждой мнемоники в строчном и заглавном написании
+constexpr size_t kMaxStates = [] {
+    size_t states = 1;
+    for (const Entity& entity : kEntities) {
+        states += 2 * entity.name.size();
+    }
+    return states;
+}();
+static_assert(kMaxStates <= 256);
+
+/*
+ * Бор мнемоник в виде таблицы переходов: из состояния state по символу c автомат переходит
+ * в next[state][c], 0 означает, что мнемоники с таким началом нет. Ни одна мнемоника
+ * не является началом другой, поэтому дойдя до конечного состояния, разбор заканчивается
+ */
+struct Trie {
+    std::array<std::array<uint8_t, 256>, kMaxStates> next{};
+    std::array<char, kMaxStates> value{};
+    std::array<bool, kMaxStates> terminal{};
+};
+
+constexpr char ToUpper(char c) {
+    return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+constexpr Trie BuildTrie() {
+    Trie trie;
+    size_t states = 1;
+    for (const Entity& entity : kEntities) {
+        for (const bool upper : {false, true}) {
+            size_t state = 0;
+            for (const char c : entity.name) {
+                const auto byte = static_cast<unsigned char>(upper ? ToUpper(c) : c);
+                if (trie.next[state][byte] == 0) {
+                    trie.next[state][byte] = static_cast<uint8_t>(states++);
+                }
+                state = trie.next[state][byte];
+            }
+            trie.terminal[state] = true;
+            trie.value[state] = entity.value;
+        }
+    }
+    return trie;
+}
+
+constexpr Trie kTrie = BuildTrie();
+
+static_assert([] {
+    for (const Entity& entity : kEntities) {
+        // & и все буквы мнемоники, кроме последней, на которой разбор заканчивается
+        if (entity.name.size() > HtmlDecoder::kMaxPending) {
+            return false;
+        }
+    }
+    return true;
+}());
+
+}  // namespace
+
+size_t HtmlDecode(std::string_view str, char* out) noexcept {
+    const char* data = str.data();
+    const size_t size = str.size();
+    size_t written = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        // Текст до следующего & копируется целиком. При декодировании на месте
+        // участки могут перекрываться, поэтому memmove
+        const void* amp = std::memchr(data + pos, '&', size - pos);
+        const size_t run = amp ? static_cast<const char*>(amp) - (data + pos) : size - pos;
+        std::memmove(out + written, data + pos, run);
+        written += run;
+        pos += run;
+        if (pos == size) {
+            break;
+        }
+
+        size_t state = 0;
+        size_t end = pos + 1;
+        while (end < size && !kTrie.terminal[state]) {
+            state = kTrie.next[state][static_cast<unsigned char>(data[end])];
+            if (state == 0) {
+                break;
+            }
+            ++end;
+        }
+
+        if (kTrie.terminal[state]) {
+            out[written++] = kTrie.value[state];
+            pos = end < size && data[end] == ';' ? end + 1 : end;
+        } else {
+            // Не мнемоника: & остаётся, а буквы за ним скопируются как обычный текст
+            out[written++] = '&';
+            ++pos;
+        }
+    }
+    return written;
+}
+
+void HtmlDecodeInPlace(std::string& buffer) noexcept {
+    buffer.resize(HtmlDecode(buffer, buffer.data()));
+}
+
 std::string HtmlDecode(std::string_view str) {
-    //    
-    return {str.begin(), str.end()};
+    std::string result(str);
+    if (str.find('&') != std::string_view::npos) {
+        HtmlDecodeInPlace(result);
+    }
+    return result;
+}
+
+size_t HtmlDecoder::Feed(std::string_view chunk, char* out) noexcept {
+    const char* data = chunk.data();
+    const size_t size = chunk.size();
+    size_t written = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        if (skip_semicolon_) {
+            skip_semicolon_ = false;
+            if (data[pos] == ';') {
+                ++pos;
+                continue;
+            }
+        }
+
+        if (pending_size_ > 0) {
+            const uint8_t next = kTrie.next[state_][static_cast<unsigned char>(data[pos])];
+            if (next == 0) {
+                // Не мнемоника. За & в pending_ только буквы, поэтому они выводятся как текст,
+                // а текущий символ разбирается заново: он может начинать новую мнемонику
+                std::memcpy(out + written, pending_, pending_size_);
+                written += pending_size_;
+                pending_size_ = 0;
+                state_ = 0;
+                continue;
+            }
+            if (kTrie.terminal[next]) {
+                out[written++] = kTrie.value[next];
+                pending_size_ = 0;
+                state_ = 0;
+                skip_semicolon_ = true;
+            } else {
+                pending_[pending_size_++] = data[pos];
+                state_ = next;
+            }
+            ++pos;
+            continue;
+        }
+
+        const void* amp = std::memchr(data + pos, '&', size - pos);
+        const size_t run = amp ? static_cast<const char*>(amp) - (data + pos) : size - pos;
+        std::memcpy(out + written, data + pos, run);
+        written += run;
+        pos += run;
+        if (pos < size) {
+            pending_[0] = '&';
+            pending_size_ = 1;
+            ++pos;
+        }
+    }
+    return written;
+}
+
+void HtmlDecoder::Feed(std::string_view chunk, std::string& out) {
+    const size_t old_size = out.size();
+    out.resize(old_size + chunk.size() + kMaxPending);
+    out.resize(old_size + Feed(chunk, out.data() + old_size));
+}
+
+size_t HtmlDecoder::Finish(char* out) noexcept {
+    const size_t written = pending_size_;
+    std::memcpy(out, pending_, pending_size_);
+    pending_size_ = 0;
+    state_ = 0;
+    skip_semicolon_ = false;
+    return written;
+}
+
+void HtmlDecoder::Finish(std::string& out) {
+    const size_t old_size = out.size();
+    out.resize(old_size + kMaxPending);
+    out.resize(old_size + Finish(out.data() + old_size));
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 /*
  * Декодирует основные HTML-мнемоники:
@@ -18,4 +20,51 @@
  * - M&amp;M&APOSs декодируется в M&M's
  * - &amp;lt; декодируется в &lt;
  */
-std::string HtmlDecode(std::string_view str);
\ No newline at end of file
+std::string HtmlDecode(std::string_view str);
+
+/*
+ * Декодирует str так же, как HtmlDecode(str), в буфер out и возвращает длину результата.
+ * Результат никогда не длиннее str, поэтому out должен вмещать str.size() байт.
+ * out может совпадать с str.data(): тогда строка декодируется на месте
+ */
+size_t HtmlDecode(std::string_view str, char* out) noexcept;
+
+/*
+ * Декодирует содержимое buffer на месте, не выделяя память
+ */
+void HtmlDecodeInPlace(std::string& buffer) noexcept;
+
+/*
+ * Декодирует вход, поступающий частями, так же, как HtmlDecode декодирует его целиком.
+ * Мнемоника и ; после неё могут быть разрезаны между частями: начало мнемоники
+ * запоминается до следующего вызова Feed, поэтому памяти требуется O(1)
+ */
+class HtmlDecoder {
+public:
+    // Сколько байт входа может быть отложено до следующей части: & и начало самой длинной мнемоники
+    static constexpr size_t kMaxPending = 4;
+
+    /*
+     * Декодирует очередную часть входа в out и возвращает длину результата.
+     * out должен вмещать chunk.size() + kMaxPending байт и не пересекаться с chunk
+     */
+    size_t Feed(std::string_view chunk, char* out) noexcept;
+    // Дописывает результат декодирования chunk в конец out
+    void Feed(std::string_view chunk, std::string& out);
+
+    /*
+     * Завершает вход: недописанная мнемоника выводится как есть.
+     * out должен вмещать kMaxPending байт
+     */
+    size_t Finish(char* out) noexcept;
+    void Finish(std::string& out);
+
+private:
+    // & и буквы, совпавшие с началом мнемоники
+    char pending_[kMaxPending] = {};
+    size_t pending_size_ = 0;
+    // Состояние бора после букв из pending_
+    uint8_t state_ = 0;
+    // Только что декодирована мнемоника, и следующий за ней символ ; надо пропустить
+    bool skip_semicolon_ = false;
+};
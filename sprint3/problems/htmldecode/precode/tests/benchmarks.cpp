@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/htmldecode.h"
+#include "bench_harness.h"
+
+/*
+ * Замеры пропускной способности HtmlDecode на типичных и патологических входах.
+ * Запускаются отдельной программой benchmarks:
+ *   benchmarks [параметры bench_harness.h] [размер каждого корпуса в МБ, по умолчанию 16]
+ * Корпуса генерируются с фиксированным seed, поэтому результаты воспроизводимы
+ */
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct Corpus {
+    const char* name;
+    std::string data;
+};
+
+void AppendWord(std::string& str, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(1, 10);
+    for (int i = length(rng); i > 0; --i) {
+        str += static_cast<char>(letter(rng));
+    }
+}
+
+// HTML-страница: абзацы текста с разметкой, мнемоники встречаются редко
+std::string MakeHtmlPage(size_t size, std::mt19937& rng) {
+    constexpr const char* kEntities[] = {"&lt;", "&gt;", "&amp;", "&quot;", "&apos;"};
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::string str = "<html><body>";
+    while (str.size() < size) {
+        str += "<p class=\"text\">";
+        for (int words = 0; words < 40; ++words) {
+            AppendWord(str, rng);
+            str += percent(rng) < 2 ? kEntities[percent(rng) % 5] : " ";
+        }
+        str += "</p>\n";
+    }
+    str += "</body></html>";
+    return str;
+}
+
+// JSON, экранированный для атрибута: кавычка через каждые несколько букв
+std::string MakeEscapedJson(size_t size, std::mt19937& rng) {
+    std::string str = "{";
+    while (str.size() < size) {
+        str += "&quot;";
+        AppendWord(str, rng);
+        str += "&quot;:&quot;";
+        AppendWord(str, rng);
+        str += "&quot;,";
+    }
+    str += '}';
+    return str;
+}
+
+// Сплошные &: каждый символ начинает разбор мнемоники
+std::string MakeAmpersands(size_t size, std::mt19937&) {
+    return std::string(size, '&');
+}
+
+// Начала мнемоник, которые обрываются перед последней буквой
+std::string MakeNearMisses(size_t size, std::mt19937& rng) {
+    constexpr const char* kPrefixes[] = {"&l", "&g", "&am", "&apo", "&quo", "&AM", "&QUO"};
+    std::string str;
+    while (str.size() < size) {
+        str += kPrefixes[rng() % 7];
+        str += ' ';
+    }
+    return str;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"htmldecode", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t size = (options.positional.empty() ? 16 : std::stoul(options.positional[0])) << 20;
+
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(options.seed));
+    std::vector<Corpus> corpora;
+    corpora.push_back({"html", MakeHtmlPage(size, rng)});
+    corpora.push_back({"json", MakeEscapedJson(size, rng)});
+    corpora.push_back({"ampersands", MakeAmpersands(size, rng)});
+    corpora.push_back({"near-misses", MakeNearMisses(size, rng)});
+
+    std::vector<char> buffer(size + 64 + HtmlDecoder::kMaxPending);
+
+    for (const Corpus& corpus : corpora) {
+        const std::string& input = corpus.data;
+        const std::string name = "HtmlDecode/"s + corpus.name;
+        suite.Run(name + "/string", [&] {
+            bench::DoNotOptimize(HtmlDecode(input).size());
+        }, input.size());
+        suite.Run(name + "/buffer", [&] {
+            bench::DoNotOptimize(HtmlDecode(input, buffer.data()));
+        }, input.size());
+        suite.Run(name + "/chunks", [&] {
+            HtmlDecoder decoder;
+            size_t written = 0;
+            for (size_t pos = 0; pos < input.size(); pos += kChunkSize) {
+                written += decoder.Feed(std::string_view(input).substr(pos, kChunkSize),
+                                        buffer.data() + written);
+            }
+            bench::DoNotOptimize(written + decoder.Finish(buffer.data() + written));
+        }, input.size());
+    }
+    return suite.Finish();
+}
@@ -1,4 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <utility>
 
 #include "../src/htmldecode.h"
 
@@ -9,4 +11,130 @@ TEST_CASE("Text without mnemonics", "[HtmlDecode]") {
     CHECK(HtmlDecode("hello"sv) == "hello"s);
 }
 
-// Напишите недостающие тесты самостоятельно
+TEST_CASE("Mnemonics in lower and upper case", "[HtmlDecode]") {
+    CHECK(HtmlDecode("&lt&gt&amp&apos&quot"sv) == "<>&'\""s);
+    CHECK(HtmlDecode("&LT&GT&AMP&APOS&QUOT"sv) == "<>&'\""s);
+}
+
+TEST_CASE("Mnemonics in mixed case are not decoded", "[HtmlDecode]") {
+    CHECK(HtmlDecode("&Lt&lT&Amp&aPOS"sv) == "&Lt&lT&Amp&aPOS"s);
+}
+
+TEST_CASE("Optional semicolon after a mnemonic", "[HtmlDecode]") {
+    CHECK(HtmlDecode("M&amp;M&APOSs"sv) == "M&M's"s);
+    CHECK(HtmlDecode("&amp;lt;"sv) == "&lt;"s);
+    CHECK(HtmlDecode("&lt;;"sv) == "<;"s);
+}
+
+TEST_CASE("Incomplete mnemonics stay as they are", "[HtmlDecode]") {
+    CHECK(HtmlDecode("&"sv) == "&"s);
+    CHECK(HtmlDecode("&a"sv) == "&a"s);
+    CHECK(HtmlDecode("&am"sv) == "&am"s);
+    CHECK(HtmlDecode("&&amp"sv) == "&&"s);
+    CHECK(HtmlDecode("&qu&ot"sv) == "&qu&ot"s);
+    CHECK(HtmlDecode("a & b"sv) == "a & b"s);
+}
+
+TEST_CASE("Decoding in place", "[HtmlDecode]") {
+    std::string buffer = "x &lt; y &AMP;&amp; z &gt"s;
+    HtmlDecodeInPlace(buffer);
+    CHECK(buffer == "x < y && z >"s);
+
+    const auto str = "&quot;quoted&quot;"sv;
+    char out[32];
+    CHECK(std::string_view(out, HtmlDecode(str, out)) == "\"quoted\""sv);
+}
+
+TEST_CASE("Decoder splits input at any position", "[HtmlDecoder]") {
+    const auto str = "M&amp;M&APOSs &lt;&&amp;;&qu&ot &quot;x&gt;;&am"s;
+    const std::string expected = HtmlDecode(str);
+    for (size_t first = 0; first <= str.size(); ++first) {
+        for (size_t second = first; second <= str.size(); ++second) {
+            HtmlDecoder decoder;
+            std::string decoded;
+            decoder.Feed(std::string_view(str).substr(0, first), decoded);
+            decoder.Feed(std::string_view(str).substr(first, second - first), decoded);
+            decoder.Feed(std::string_view(str).substr(second), decoded);
+            decoder.Finish(decoded);
+            CHECK(decoded == expected);
+        }
+    }
+}
+
+TEST_CASE("Decoder flushes an incomplete mnemonic on finish", "[HtmlDecoder]") {
+    HtmlDecoder decoder;
+    std::string decoded;
+    decoder.Feed("a &qu"sv, decoded);
+    CHECK(decoded == "a "s);
+    decoder.Finish(decoded);
+    CHECK(decoded == "a &qu"s);
+
+    // После Finish декодер готов к новому входу
+    decoder.Feed("&amp"sv, decoded);
+    decoder.Finish(decoded);
+    decoder.Feed(";"sv, decoded);
+    CHECK(decoded == "a &qu&;"s);
+}
+
+namespace {
+
+// Эталонная реализация: у каждого & по очереди пробует все мнемоники
+std::string ReferenceHtmlDecode(std::string_view str) {
+    constexpr std::pair<std::string_view, char> kEntities[] = {
+        {"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"apos", '\''}, {"quot", '"'},
+        {"LT", '<'}, {"GT", '>'}, {"AMP", '&'}, {"APOS", '\''}, {"QUOT", '"'},
+    };
+    std::string result;
+    size_t pos = 0;
+    while (pos < str.size()) {
+        bool found = false;
+        if (str[pos] == '&') {
+            for (const auto& [name, value] : kEntities) {
+                if (str.substr(pos + 1, name.size()) == name) {
+                    result += value;
+                    pos += 1 + name.size();
+                    if (pos < str.size() && str[pos] == ';') {
+                        ++pos;
+                    }
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            result += str[pos++];
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST_CASE("Fast paths match the reference on random input", "[HtmlDecode][HtmlDecoder]") {
+    // Алфавит из букв мнемоник, & и ;, чтобы случайные строки были полны
+    // целых, оборванных и перемешанных мнемоник
+    constexpr std::string_view kAlphabet = "&&&&;;ltgampsoquLTGAMPSOQU x";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> length(0, 100);
+    std::uniform_int_distribution<size_t> symbol(0, kAlphabet.size() - 1);
+    std::uniform_int_distribution<size_t> chunk_size(1, 8);
+    for (int i = 0; i < 20000; ++i) {
+        std::string str(length(rng), ' ');
+        for (char& c : str) {
+            c = kAlphabet[symbol(rng)];
+        }
+        const std::string expected = ReferenceHtmlDecode(str);
+        INFO("input: " << str);
+        REQUIRE(HtmlDecode(str) == expected);
+
+        HtmlDecoder decoder;
+        std::string decoded;
+        const size_t step = chunk_size(rng);
+        for (size_t pos = 0; pos < str.size(); pos += step) {
+            decoder.Feed(std::string_view(str).substr(pos, step), decoded);
+        }
+        decoder.Finish(decoded);
+        REQUIRE(decoded == expected);
+    }
+}
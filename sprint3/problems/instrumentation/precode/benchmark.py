@@ -0,0 +1,170 @@
+import argparse
+import csv
+import os
+import random
+import shutil
+import subprocess
+
+# Builds v0, v1 and v2 of events2dot, runs them with --profile on generated
+# event logs of increasing size and charts read/summarize/dot time and peak
+# RSS of the three versions against each other.
+#
+#   python3 benchmark.py [--sizes 10000 100000 ...] [--timeout 120]
+#
+# Results go to benchmark/results.csv and, when matplotlib is installed,
+# benchmark/benchmark.png. Logs are generated with a fixed seed, so the
+# numbers are reproducible on the same machine.
+
+VERSIONS = ['v0', 'v1', 'v2']
+# v2 would reuse its summary of a log from an earlier run of the script
+EXTRA_ARGS = {'v2': ['--no-cache']}
+PHASES = ['read', 'summarize', 'dot']
+COMPILE = 'g++ -std=c++17 -O2 -pthread -w -o {binary} {sources}'
+
+SEED = 123456789
+DEFAULT_SIZES = [10000, 30000, 100000, 300000, 1000000]
+DEFAULT_TIMEOUT = 120
+
+PAGES = 20000
+MAX_SESSION_LENGTH = 12
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--sizes', type=int, nargs='+', default=DEFAULT_SIZES,
+                        help='number of events in the generated logs')
+    parser.add_argument('--timeout', type=float, default=DEFAULT_TIMEOUT,
+                        help='seconds before a run counts as too slow')
+    parser.add_argument('--out', type=str, default=os.path.join(HERE, 'benchmark'))
+    return parser.parse_args()
+
+
+def generate_log(path, n_events):
+    # sessions of a few pages each, popular pages far more likely than others,
+    # like the sample inputs
+    rng = random.Random(SEED)
+    timestamp = 1119634442
+    written = 0
+    session = 0
+    with open(path, 'w') as log:
+        while written < n_events:
+            session += 1
+            ip = '10.{}.{}.{}'.format(session >> 16 & 255, session >> 8 & 255, session & 255)
+            for _ in range(min(rng.randint(1, MAX_SESSION_LENGTH), n_events - written)):
+                page = int(rng.paretovariate(1.2)) % PAGES
+                timestamp += rng.randint(0, 30)
+                log.write('{}\t{}\t/wiki.pl?Page_{}\n'.format(ip, timestamp, page))
+                written += 1
+
+
+def build(version, out):
+    source_dir = os.path.join(HERE, version)
+    sources = ' '.join(os.path.join(source_dir, name)
+                       for name in sorted(os.listdir(source_dir)) if name.endswith('.cpp'))
+    binary = os.path.join(out, 'events2dot_' + version)
+    subprocess.run(COMPILE.format(binary=binary, sources=sources), shell=True, check=True)
+    return binary
+
+
+def run(version, binary, log, out, timeout):
+    # events2dot reads pathalizer.conf from the working directory
+    workdir = os.path.join(out, 'run_' + version)
+    os.makedirs(workdir, exist_ok=True)
+    shutil.copy(os.path.join(HERE, version, 'pathalizer.conf'), workdir)
+
+    try:
+        process = subprocess.run([binary, '--profile'] + EXTRA_ARGS.get(version, []) + [log], cwd=workdir, timeout=timeout,
+                                 stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    except subprocess.TimeoutExpired:
+        return None
+
+    phases = {}
+    for line in process.stderr.splitlines():
+        fields = line.split('\t')
+        if len(fields) == 4 and fields[0] == 'profile':
+            phases[fields[1]] = (float(fields[2]), int(fields[3]))
+    return phases
+
+
+def print_table(results):
+    print('{:>10} {:>4} {:>10} {:>10} {:>10} {:>10} {:>12}'.format(
+        'events', 'ver', 'read s', 'summ. s', 'dot s', 'total s', 'peak RSS kB'))
+    for row in results:
+        if row['total'] is None:
+            print('{:>10} {:>4} {:>10}'.format(row['events'], row['version'], 'timeout'))
+            continue
+        print('{:>10} {:>4} {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} {:>12}'.format(
+            row['events'], row['version'], row['read'], row['summarize'], row['dot'],
+            row['total'], row['rss']))
+
+
+def write_csv(results, path):
+    with open(path, 'w', newline='') as file:
+        writer = csv.DictWriter(file, fieldnames=['events', 'version'] + PHASES + ['total', 'rss'])
+        writer.writeheader()
+        writer.writerows(results)
+
+
+def chart(results, path):
+    try:
+        import matplotlib
+        matplotlib.use('Agg')
+        import matplotlib.pyplot as plt
+    except ImportError:
+        print('matplotlib not found, skipping the chart')
+        return
+
+    figure, (times, memory) = plt.subplots(1, 2, figsize=(12, 5))
+    for version in VERSIONS:
+        rows = [row for row in results if row['version'] == version and row['total'] is not None]
+        events = [row['events'] for row in rows]
+        times.plot(events, [row['total'] for row in rows], marker='o', label=version)
+        memory.plot(events, [row['rss'] / 1024 for row in rows], marker='o', label=version)
+
+    times.set(xscale='log', yscale='log', xlabel='events', ylabel='seconds', title='total time')
+    memory.set(xscale='log', xlabel='events', ylabel='MB', title='peak RSS')
+    times.legend()
+    memory.legend()
+    figure.tight_layout()
+    figure.savefig(path)
+    print('Chart written to', path)
+
+
+def main():
+    args = parse_args()
+    os.makedirs(args.out, exist_ok=True)
+
+    binaries = {version: build(version, args.out) for version in VERSIONS}
+
+    results = []
+    timed_out = set()
+    for n_events in sorted(args.sizes):
+        log = os.path.join(args.out, 'events_{}.log'.format(n_events))
+        if not os.path.exists(log):
+            generate_log(log, n_events)
+
+        for version in VERSIONS:
+            # a version too slow for a smaller log is too slow for this one
+            phases = None
+            if version not in timed_out:
+                phases = run(version, binaries[version], log, args.out, args.timeout)
+            if phases is None:
+                timed_out.add(version)
+
+            row = {'events': n_events, 'version': version, 'total': None, 'rss': None}
+            if phases is not None:
+                for phase in PHASES:
+                    row[phase] = phases[phase][0]
+                row['total'] = round(sum(phases[phase][0] for phase in PHASES), 6)
+                row['rss'] = max(rss for _, rss in phases.values())
+            results.append(row)
+
+    print_table(results)
+    write_csv(results, os.path.join(args.out, 'results.csv'))
+    chart(results, os.path.join(args.out, 'benchmark.png'))
+
+
+if __name__ == '__main__':
+    main()
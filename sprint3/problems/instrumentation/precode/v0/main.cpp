@@ -6,23 +6,39 @@
 #include "readfile.h"
 #include "dotgen.h"
 #include "config.h"
+#include "profile.h"
 
 NodeListNode * nodelist = NULL;
 
 void printUsage()
 {
-	fprintf(stderr, "events2dot <eventsfile>\n");
+	fprintf(stderr, "events2dot [--profile] <eventsfile>\n");
 }
 
 int main (int argc, char ** argv)
 {
 	GraphList g;
 
-	if ((argc != 2) 
-		|| (strcmp(argv[1], "--help") == 0)
-		|| (strcmp(argv[1], "-help") == 0)
-		|| (strcmp(argv[1], "-?") == 0)
-		|| (strcmp(argv[1], "-h") == 0))
+	char * file = NULL;
+
+	// anything but --profile starting with '-' is a request for help
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "--profile") == 0)
+		{
+			EnableProfile();
+		}
+		else if ((file == NULL) && (argv[i][0] != '-'))
+		{
+			file = argv[i];
+		}
+		else
+		{
+			printUsage();
+			exit(0);
+		}
+	}
+	if (file == NULL)
 	{
 		printUsage();
 		exit(0);
@@ -31,12 +47,15 @@ int main (int argc, char ** argv)
 	Config * config;
 	config = ReadConfig ("pathalizer.conf");
 
-	g = getGraphFromFile(argv[1], nodelist, config);
-
+	g = getGraphFromFile(file, nodelist, config);
+	EndPhase ("read");
 
 	AnnotatedGraph * ag = summarize(g, config);
+	EndPhase ("summarize");
 
 	GenerateDot (stdout, ag, nodelist, config);
+	fflush (stdout);
+	EndPhase ("dot");
 
 	return 0;
 }
@@ -0,0 +1,19 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*
+ * Poor man's phase profiler. When enabled, every phase reports its wall
+ * time and the peak RSS so far on stderr as one tab-separated line:
+ *
+ *   profile	<phase>	<seconds>	<peak rss in kB>
+ *
+ * so the versions of events2dot can be compared by benchmark.py.
+ */
+
+/* starts the first phase, nothing is reported unless this was called */
+void EnableProfile ();
+
+/* ends the current phase, reporting it as name, and starts the next one */
+void EndPhase (const char * name);
+
+#endif
@@ -16,6 +16,7 @@ Config * ReadConfig (char * file)
 	retval->min_edgewidth = -1; // auto
 	retval->max_edgecount = 60; // when auto, max 60 edges
 	retval->ignore_refresh = 0; // don't ignore refreshes
+	retval->approx_edges = 1000; // most taken edges kept by --approx
 
 	in = fopen (file, "r");
 
@@ -49,6 +50,10 @@ Config * ReadConfig (char * file)
 		{
 			sscanf(value, "%d", &retval->max_edgecount);
 		}
+		else if (strcmp(option, "approx_edges") == 0)
+		{
+			sscanf(value, "%d", &retval->approx_edges);
+		}
 		else if (strcmp(option, "ignore_refresh") == 0)
 		{
 			sscanf(value, "%d", &retval->ignore_refresh);
@@ -5,6 +5,7 @@ struct Config {
 	int min_edgewidth;
 	int ignore_refresh;
 	int max_edgecount; 
+	int approx_edges;	// edges kept by --approx
 };
 
 Config * ReadConfig (char * file);
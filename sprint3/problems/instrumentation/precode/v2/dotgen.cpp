@@ -1,98 +1,146 @@
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
 #include "graph.h"
 
 #define BUFSIZE 100
 #undef DEBUG
 
-/* a pointer to this struct * is passed on to FindTreshold while walking */
-struct findtreshold_arg
+/* a pointer to this vector is passed on to CollectCounts while walking */
+void CollectCounts (void * content, void * arg)
 {
-        int n_edges;
-        int current_treshold;
-};
-
-void CountEdges (void * content, void * arg)
-{
-        findtreshold_arg * args = (findtreshold_arg *) arg;
-        // TODO wat als edge->next != null? Juist!
+        std::vector<int> * counts = (std::vector<int> *) arg;
         AnnotatedEdge * current = (AnnotatedEdge *)content;
         while (current != NULL)
         {
-                if (current->n_taken > args->current_treshold)
-                        args->n_edges++;
+                counts->push_back(current->n_taken);
                 current = current->next;
         }
 }
 
-int FindTreshold(BinaryTree * tree_root, int max_edgecount)
+/*
+ * Returns the lowest treshold for which at most max_edgecount edges
+ * are taken more often than the treshold.
+ *
+ * That is the (max_edgecount+1)-th largest count, or 0 when there
+ * are few enough edges anyway, so one walk and an nth_element do
+ * instead of a walk per candidate treshold.
+ */
+int FindTreshold(EdgeHashTbl * tree_root, int max_edgecount)
 {
-	static findtreshold_arg * args = (findtreshold_arg*) malloc (sizeof(findtreshold_arg));
-	args->n_edges=-1;
-	args->current_treshold=0;
+	std::vector<int> counts;
+	counts.reserve(tree_root->count);
+	tree_root->walk(CollectCounts, &counts);
 
 #ifdef DEBUG
-	fprintf(stderr, "  Finding treshold. max_edgecount: %d\n", max_edgecount);
+	fprintf(stderr, "  Finding treshold. max_edgecount: %d, edges: %d\n",
+			max_edgecount, (int) counts.size());
 #endif
-	
-	while ((args->n_edges > max_edgecount) || (args->n_edges == -1))
-	{
-		//AnnotatedEdge * current_edge = start_edge;
-		args->n_edges = 0;
-
-		tree_root->walk(CountEdges, args);
 
-#ifdef DEBUG
-		fprintf(stderr, "  With treshold %d, found %d edges.\n", current_treshold, edges);
-#endif
+	if (counts.empty()
+			|| ((max_edgecount >= 0) && ((size_t) max_edgecount >= counts.size())))
+		return 0;
 
-		args->current_treshold++;
-	}
-	return args->current_treshold-1;
+	// a negative max_edgecount can only be met by dropping every edge
+	size_t nth = (max_edgecount < 0) ? 0 : max_edgecount;
+	std::nth_element(counts.begin(), counts.begin() + nth, counts.end(),
+			std::greater<int>());
+	return counts[nth];
 }
 
-struct printedge_arg
-{
-        int min_edgewidth;
-};
+const size_t kDotBufferSize = 1024 * 1024;
 
-void PrintNode (void * content, void * arg)
+/*
+ * Formats the dot file into one large block and hands it to
+ * stdio with a single fwrite whenever it fills up.
+ */
+class DotWriter
 {
-	Node * node  = (Node *)content;
-	FILE * dest  = (FILE *)arg;
-	char * shape = "ellipse";
+public:
+	DotWriter (FILE * n_dest)
+	{
+		dest = n_dest;
+		buffer = (char *) malloc (kDotBufferSize);
+		used = 0;
+	}
+	~DotWriter ()
+	{
+		flush();
+		free (buffer);
+	}
 
-	if (!node->used)
-		return;
-	if ((node->start > 0) && (node->end > 0))
+	void write (const char * str, size_t length)
 	{
-		shape = "octagon";
-	} 
-	else if (node->start > 0)
+		if (used + length > kDotBufferSize)
+		{
+			flush();
+			if (length > kDotBufferSize)
+			{
+				fwrite (str, 1, length, dest);
+				return;
+			}
+		}
+		memcpy (buffer + used, str, length);
+		used += length;
+	}
+	void write (const char * str)
 	{
-		shape = "box";
+		write (str, strlen(str));
 	}
-	else if (node->end > 0)
+	void writeInt (int value)
 	{
-		shape = "diamond";
+		char digits[16];
+		char * end = digits + sizeof(digits);
+		char * begin = end;
+		unsigned int rest = (value < 0) ? 0u - (unsigned int) value : value;
+		do
+		{
+			*--begin = '0' + rest % 10;
+			rest /= 10;
+		} while (rest != 0);
+		if (value < 0)
+			*--begin = '-';
+		write (begin, end - begin);
 	}
-	fprintf (dest, "\"%s\" [shape=%s];\n",
-			node->name,
-			shape);
-}
-void PrintEdge (void * content, void * arg)
+	/* same as printf's %f */
+	void writeDouble (double value)
+	{
+		char digits[64];
+		int length = snprintf (digits, sizeof(digits), "%f", value);
+		write (digits, length);
+	}
+	void flush ()
+	{
+		fwrite (buffer, 1, used, dest);
+		used = 0;
+	}
+private:
+	FILE * dest;
+	char * buffer;
+	size_t used;
+
+	DotWriter(const DotWriter &);
+};
+
+/* a pointer to this struct is passed on to CollectEdge while walking */
+struct collectedge_arg
+{
+        int min_edgewidth;
+        std::vector<AnnotatedEdge *> edges;
+};
+
+void CollectEdge (void * content, void * arg)
 {
-        printedge_arg * args = (printedge_arg*) arg;
+        collectedge_arg * args = (collectedge_arg *) arg;
         AnnotatedEdge * current = (AnnotatedEdge *)content;
 
         while (current != NULL)
         {
                 if (current->n_taken > args->min_edgewidth)
                 {
-                        printf("\"%s\" -> \"%s\"[label=%d,color=\"0,0,%f\"];\n", 
-                                        current->from->name,
-                                        current->to->name,
-                                        current->n_taken, 
-					1.0-current->n_taken/60.0);
+                         args->edges.push_back(current);
                          current->from->used = true;
                          current->to->used = true;
                 }
@@ -100,32 +148,189 @@ void PrintEdge (void * content, void * arg)
         }
 }
 
+/* a pointer to a vector of nodes is passed on to CollectNode while walking */
+void CollectNode (void * content, void * arg)
+{
+	Node * node = (Node *)content;
+	if (node->used)
+		((std::vector<Node *> *) arg)->push_back(node);
+}
+
+void ClearUsed (void * content, void * arg)
+{
+	((Node *)content)->used = false;
+}
+
+void CollectAllEdges (void * content, void * arg)
+{
+	std::vector<AnnotatedEdge *> * edges = (std::vector<AnnotatedEdge *> *) arg;
+	for (AnnotatedEdge * current = (AnnotatedEdge *)content; current != NULL; current = current->next)
+		edges->push_back(current);
+}
+
+void CollectAllNodes (void * content, void * arg)
+{
+	((std::vector<Node *> *) arg)->push_back((Node *)content);
+}
 
-	
+bool EdgeBefore (const AnnotatedEdge * a, const AnnotatedEdge * b)
+{
+	int order = strcmp (a->from->name, b->from->name);
+	if (order == 0)
+		order = strcmp (a->to->name, b->to->name);
+	return order < 0;
+}
+
+bool NodeBefore (const Node * a, const Node * b)
+{
+	return strcmp (a->name, b->name) < 0;
+}
+
+void PrintNode (DotWriter & out, Node * node)
+{
+	const char * shape = "ellipse";
+
+	if ((node->start > 0) && (node->end > 0))
+	{
+		shape = "octagon";
+	} 
+	else if (node->start > 0)
+	{
+		shape = "box";
+	}
+	else if (node->end > 0)
+	{
+		shape = "diamond";
+	}
+	// "name" [shape=shape];
+	out.write ("\"");
+	out.write (node->name);
+	out.write ("\" [shape=");
+	out.write (shape);
+	out.write ("];\n");
+}
+
+void PrintEdge (DotWriter & out, AnnotatedEdge * edge)
+{
+	// "from" -> "to"[label=n_taken,color="0,0,shade"];
+	out.write ("\"");
+	out.write (edge->from->name);
+	out.write ("\" -> \"");
+	out.write (edge->to->name);
+	out.write ("\"[label=");
+	out.writeInt (edge->n_taken);
+	out.write (",color=\"0,0,");
+	out.writeDouble (1.0-edge->n_taken/60.0);
+	out.write ("\"];\n");
+}
+
+/*
+ * Edges are printed sorted by the names of their nodes and nodes by
+ * name, so the same input always gives the same file.
+ */
 void GenerateDot (FILE * dest, AnnotatedGraph * g, NodeHashTbl * nodehash, Config * config)
 {
-	fprintf(dest, "digraph site_usage {\n");
-	//fprintf(dest, "concentrate=true\n");
-	fprintf(dest, "size=\"7,10\"\n");
-	fprintf(dest, "page=\"8.5,11\"\n");
-	fprintf(dest, "rotate=90\n");
-	fprintf(dest, "center=\"\";\n");
-	fprintf(dest, "node[width=.25,hight=.375,fontsize=9]\n");
+	DotWriter out (dest);
+
+	out.write("digraph site_usage {\n");
+	//out.write("concentrate=true\n");
+	out.write("size=\"7,10\"\n");
+	out.write("page=\"8.5,11\"\n");
+	out.write("rotate=90\n");
+	out.write("center=\"\";\n");
+	out.write("node[width=.25,hight=.375,fontsize=9]\n");
 
-	printedge_arg * args = (printedge_arg*) malloc (sizeof(printedge_arg));
+	// a graph can be printed more than once while following a file
+	nodehash->walk (ClearUsed, NULL);
+
+	collectedge_arg args;
 
 	if (config->min_edgewidth < 0)
 	{
-		args->min_edgewidth = FindTreshold(g->edgetree, config->max_edgecount);
-		fprintf(stderr, "  Chose treshold: %d\n", args->min_edgewidth);
+		args.min_edgewidth = FindTreshold(g->edgetree, config->max_edgecount);
+		fprintf(stderr, "  Chose treshold: %d\n", args.min_edgewidth);
 	} else {
-		args->min_edgewidth = config->min_edgewidth;
+		args.min_edgewidth = config->min_edgewidth;
+	}
+
+	g->edgetree->walk (CollectEdge, &args);
+	std::sort (args.edges.begin(), args.edges.end(), EdgeBefore);
+	for (AnnotatedEdge * edge : args.edges)
+		PrintEdge (out, edge);
+
+	std::vector<Node *> nodes;
+	nodehash->walk (CollectNode, &nodes);
+	std::sort (nodes.begin(), nodes.end(), NodeBefore);
+	for (Node * node : nodes)
+		PrintNode (out, node);
+
+	out.write("}\n");
+}
+
+/* writes str as a json string, quotes included */
+void WriteJsonString (DotWriter & out, const char * str)
+{
+	static const char * hex = "0123456789abcdef";
+
+	out.write ("\"");
+	const char * plain = str;
+	for (; *str != '\0'; str++)
+	{
+		unsigned char c = *str;
+		if ((c >= 0x20) && (c != '"') && (c != '\\'))
+			continue;
+
+		out.write (plain, str - plain);
+		if ((c == '"') || (c == '\\'))
+		{
+			char escaped[2] = { '\\', (char) c };
+			out.write (escaped, 2);
+		}
+		else
+		{
+			char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+			out.write (escaped, 6);
+		}
+		plain = str + 1;
 	}
+	out.write (plain, str - plain);
+	out.write ("\"");
+}
 
-	g->edgetree->walk (PrintEdge, args);
-	nodehash->walk (PrintNode, dest);
+void GenerateJson (FILE * dest, AnnotatedGraph * g, NodeHashTbl * nodehash)
+{
+	DotWriter out (dest);
 
-	/* TODO walk nodes */
+	std::vector<Node *> nodes;
+	nodehash->walk (CollectAllNodes, &nodes);
+	std::sort (nodes.begin(), nodes.end(), NodeBefore);
 
-	fprintf(dest, "}\n");
+	out.write ("{\"nodes\":[");
+	for (size_t i=0; i<nodes.size(); i++)
+	{
+		out.write ((i == 0) ? "{\"name\":" : ",{\"name\":");
+		WriteJsonString (out, nodes[i]->name);
+		out.write (",\"start\":");
+		out.writeInt (nodes[i]->start);
+		out.write (",\"end\":");
+		out.writeInt (nodes[i]->end);
+		out.write ("}");
+	}
+
+	std::vector<AnnotatedEdge *> edges;
+	g->edgetree->walk (CollectAllEdges, &edges);
+	std::sort (edges.begin(), edges.end(), EdgeBefore);
+
+	out.write ("],\"edges\":[");
+	for (size_t i=0; i<edges.size(); i++)
+	{
+		out.write ((i == 0) ? "{\"from\":" : ",{\"from\":");
+		WriteJsonString (out, edges[i]->from->name);
+		out.write (",\"to\":");
+		WriteJsonString (out, edges[i]->to->name);
+		out.write (",\"count\":");
+		out.writeInt (edges[i]->n_taken);
+		out.write ("}");
+	}
+	out.write ("]}\n");
 }
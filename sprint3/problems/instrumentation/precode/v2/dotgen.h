@@ -6,4 +6,11 @@
 
 void GenerateDot (FILE * dest, AnnotatedGraph * g, NodeHashTbl * nodes, Config * config);
 
+/*
+ * Writes all nodes and edges of g to dest as one line of json:
+ * {"nodes":[{"name":..,"start":..,"end":..}],"edges":[{"from":..,"to":..,"count":..}]}
+ * Unlike GenerateDot no edges are left out, dashboards can pick their own.
+ */
+void GenerateJson (FILE * dest, AnnotatedGraph * g, NodeHashTbl * nodes);
+
 #endif
@@ -1,317 +1,496 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <cstddef>
 #include "graph.h"
 
-void NodeHashTbl::walk (void (*func)(void *, void*), void* arg)
+const size_t kArenaChunkSize = 64 * 1024;
+
+Arena::Arena ()
 {
-	for (int x=0; x<size; x++)
-	{
-		if (table[x] != NULL)
-		{
-			table[x]->walk(func, arg);
-		}
-	}
+	chunks = NULL;
 }
 
-void HashNode::walk (void (*func)(void *, void *), void * arg)
+Arena::~Arena ()
 {
-	func (node, arg);
-	if (next != NULL)
-		next->walk(func, arg);
+	while (chunks != NULL)
+	{
+		Chunk * next = chunks->next;
+		free (chunks);
+		chunks = next;
+	}
 }
 
-unsigned int NodeHashTbl::HashString (const char * str)
+char * Arena::reserve (size_t size, size_t align)
 {
-        unsigned int retval = 0;
-        int length = strlen(str);
+	size_t padding = 0;
+	if (chunks != NULL)
+		padding = -(uintptr_t) (chunks->data + chunks->used) & (align - 1);
 
-        unsigned int top5bits = 0xf8000000;
-        unsigned int carry = 0;
-
-        const int kleftmove=5;
-        const int krightmove=27;
+	if ((chunks == NULL) || (chunks->size - chunks->used < padding + size))
+	{
+		// objects longer than a chunk get a chunk of their own
+		size_t chunk_size = (size + align > kArenaChunkSize) ? size + align : kArenaChunkSize;
+		Chunk * chunk = (Chunk *) malloc (sizeof(Chunk) + chunk_size);
+		chunk->next = chunks;
+		chunk->used = 0;
+		chunk->size = chunk_size;
+		chunks = chunk;
+		padding = -(uintptr_t) chunk->data & (align - 1);
+	}
+	char * retval = chunks->data + chunks->used + padding;
+	chunks->used += padding + size;
+	return retval;
+}
 
-        for (int i=0; i<length; i++)
-        {
-                carry = retval & top5bits;
-                carry = carry >> krightmove;
-                retval = retval << kleftmove;
-                retval ^= carry;
-                retval ^= str[i];
-        }
-        return retval;
+void * Arena::alloc (size_t size)
+{
+	return reserve (size, alignof(std::max_align_t));
 }
 
-NodeHashTbl::NodeHashTbl(int n_size)
+char * Arena::store (const char * str, size_t length)
 {
-        size = n_size;
-        table = (HashNode **) malloc (sizeof(HashNode*)*size); 
-        for (int i=0; i<size; i++)
-        {
-                table[i] = NULL;
-        }
+	char * retval = reserve (length + 1, 1);
+	memcpy (retval, str, length);
+	retval[length] = '\0';
+	return retval;
 }
 
-void NodeHashTbl::add(char * key, Node * content)
+void Arena::adopt (Arena & other)
 {
-        //assert (strcmp (key, content->name) == 0);
+	if (other.chunks == NULL)
+		return;
 
-        int hkey = HashString (key) % size;
-        table[hkey] = new HashNode(key, content, table[hkey]);
+	// keep our current chunk in front, it's the one being filled
+	Chunk * last = other.chunks;
+	while (last->next != NULL)
+		last = last->next;
+	if (chunks == NULL)
+	{
+		chunks = other.chunks;
+	}
+	else
+	{
+		last->next = chunks->next;
+		chunks->next = other.chunks;
+	}
+	other.chunks = NULL;
 }
 
-Node * NodeHashTbl::get(char * key)
+/* MurmurHash3 64 bit finalizer */
+static unsigned long long MixBits (unsigned long long x)
 {
-        HashNode * current_node = table[HashString (key) % size];
-        while (current_node != NULL)
-        {
-                if (strcmp(current_node->key, key) == 0)
-                {
-                        //assert (strcmp (key, current_node->node->name) == 0);
-
-                        return current_node->node;
-                }
-                current_node=current_node->next;
-        }
-        return NULL;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
 }
 
-Node * newNode (char * name)
+/* name must outlive the node, it is not copied */
+Node * newNode (Arena * memory, char * name, int id)
 {
-	Node * retval = (Node *) malloc (sizeof(Node));
-	retval->name = strdup(name);
+	Node * retval = (Node *) memory->alloc (sizeof(Node));
+	retval->name = name;
+	retval->id = id;
 	retval->start = 0;
 	retval->end = 0;
 	retval->used = false;
 	return retval;
 }
 
-/* remove bad characters from names, should move somewhere else probably */
-void FixName (char * name)
+/*
+ * 64 bit FNV-1a followed by the MurmurHash3 finalizer, which spreads
+ * the bits of similar names (/wiki.pl?A, /wiki.pl?B) over the whole hash
+ */
+unsigned long long NodeHashTbl::HashString (const char * str, size_t length)
 {
-	// Node names may not end with '\' or '/'
-	while ((name[strlen(name)-1] == '\\')
-		|| (name[strlen(name)-1] == '/'))
+	unsigned long long retval = 14695981039346656037ULL;
+	for (size_t i=0; i<length; i++)
 	{
-		name[strlen(name)-1] = '\0';
+		retval ^= (unsigned char) str[i];
+		retval *= 1099511628211ULL;
 	}
+	return MixBits (retval);
 }
 
-Node * getNode (char * name, NodeHashTbl * nodehash)
+NodeHashTbl::NodeHashTbl(int n_size)
 {
-        FixName(name);
+	size_t capacity = 16;
+	while (capacity * kShards < (size_t) n_size)
+	{
+		capacity *= 2;
+	}
+	for (int i=0; i<kShards; i++)
+	{
+		shards[i].capacity = capacity;
+		shards[i].count = 0;
+		shards[i].table = (Slot *) calloc (capacity, sizeof(Slot));
+	}
+	n_nodes = 0;
+	for (int i=0; i<kSegments; i++)
+	{
+		segments[i] = NULL;
+	}
+}
 
-        Node * retval = nodehash->get(name);
+NodeHashTbl::~NodeHashTbl()
+{
+	for (int i=0; i<kShards; i++)
+	{
+		free (shards[i].table);
+	}
+	for (int i=0; i<kSegments; i++)
+	{
+		free (segments[i]);
+	}
+}
 
-        if (retval == NULL)
-        {
-                retval = newNode(name);
-                nodehash->add(strdup(name), retval);
-        }
+NodeHashTbl::Shard * NodeHashTbl::shardFor (unsigned long long hash)
+{
+	// slots are picked by the low bits, so take the shard from the top
+	return &shards[hash >> (64 - kShardBits)];
+}
 
-        return retval;
+/*
+ * returns the slot holding key, or the empty slot where it
+ * should be inserted
+ */
+NodeHashTbl::Slot * NodeHashTbl::find (Shard * shard, const char * key, size_t length, unsigned long long hash)
+{
+	size_t mask = shard->capacity - 1;
+	for (size_t x = hash & mask; ; x = (x + 1) & mask)
+	{
+		Slot * slot = &shard->table[x];
+		if (slot->node == NULL)
+			return slot;
+		if ((slot->hash == hash) && (slot->length == length)
+				&& (memcmp(slot->key, key, length) == 0))
+			return slot;
+	}
 }
 
-GraphListNode * newGraphListNode (GraphListNode * next, Node * start)
+void NodeHashTbl::grow (Shard * shard)
 {
-	assert (start != NULL);
+	Slot * old_table = shard->table;
+	size_t old_capacity = shard->capacity;
 
-	Graph * new_graph = (Graph *) malloc (sizeof(Graph));
-	new_graph->name = "";
-	new_graph->start = start;
-	new_graph->edges = NULL;
+	shard->capacity *= 2;
+	shard->table = (Slot *) calloc (shard->capacity, sizeof(Slot));
 
-	GraphListNode * retval = (GraphListNode *) malloc (sizeof(GraphListNode));
-	retval->next = next;
-	retval->graph = new_graph;
+	size_t mask = shard->capacity - 1;
+	for (size_t i=0; i<old_capacity; i++)
+	{
+		if (old_table[i].node == NULL)
+			continue;
+		// keys are unique, so only an empty slot has to be found
+		size_t x = old_table[i].hash & mask;
+		while (shard->table[x].node != NULL)
+			x = (x + 1) & mask;
+		shard->table[x] = old_table[i];
+	}
+	free (old_table);
+}
 
-	assert (retval->graph != NULL);
-	
-	return retval;
+Node * NodeHashTbl::get(char * key)
+{
+	return get (key, strlen(key));
 }
 
-/* 
- * merges the strings in order to get a unique key identifying
- * this pair, using which the binary tree will be sorted.
- *
- * would be better to alternate characters from str1 and str2
- * instead of just concatenating the strings 
- */
-int MergeStrings (const char * str1, const char * str2)
+Node * NodeHashTbl::get(const char * key, size_t length)
 {
-        int retval = 0;
-        while (*str1 != '\0')
-                retval += *str1++;
-        while (*str2 != '\0')
-                retval += *str2++;
-        return retval;
+	unsigned long long hash = HashString (key, length);
+	Shard * shard = shardFor (hash);
+
+	std::lock_guard<std::mutex> guard (shard->lock);
+	return find (shard, key, length, hash)->node;
 }
 
-Edge * newEdge (Node * from, Node * to, Edge * next = NULL)
+Node * NodeHashTbl::intern(const char * key, size_t length)
 {
-	Edge * retval = (Edge *) malloc (sizeof(Edge));
+	unsigned long long hash = HashString (key, length);
+	Shard * shard = shardFor (hash);
 
-	assert (from->name != NULL);
-	assert (to->name != NULL);
+	std::lock_guard<std::mutex> guard (shard->lock);
+	Slot * slot = find (shard, key, length, hash);
+	if (slot->node != NULL)
+		return slot->node;
 
-	retval->from = from;
-	retval->to = to;
-	retval->next = next;
-	retval->key = MergeStrings(from->name, to->name);
+	if ((shard->count + 1) * 8 > shard->capacity * 5)
+	{
+		grow (shard);
+		slot = find (shard, key, length, hash);
+	}
+	shard->count++;
+
+	// the node and the table share one copy of the name
+	slot->hash = hash;
+	slot->length = length;
+	slot->key = shard->memory.store (key, length);
+	slot->node = newNode (&shard->memory, slot->key, n_nodes++);
+
+	/*
+	 * threads in other shards may need the same segment. Whoever
+	 * learns this id does so through this shard's lock, so they
+	 * see both the segment and the entry.
+	 */
+	std::atomic<Node **> & segment = segments[slot->node->id >> kSegmentBits];
+	Node ** entries = segment.load();
+	if (entries == NULL)
+	{
+		Node ** fresh = (Node **) calloc (kSegmentSize, sizeof(Node *));
+		if (segment.compare_exchange_strong (entries, fresh))
+			entries = fresh;
+		else
+			free (fresh);
+	}
+	entries[slot->node->id & (kSegmentSize - 1)] = slot->node;
 
-	return retval;
+	return slot->node;
 }
 
-void addEdge (Graph * g, Node * from, Node * to)
+Node * NodeHashTbl::byId(uint32_t id)
 {
-	Edge * current_edge = g->edges;
+	return segments[id >> kSegmentBits].load()[id & (kSegmentSize - 1)];
+}
 
-	if (current_edge == NULL)
+void NodeHashTbl::walk (void (*func)(void *, void*), void* arg)
+{
+	for (int i=0; i<kShards; i++)
 	{
-		g->edges = newEdge(from, to);
-		return;
+		for (size_t x=0; x<shards[i].capacity; x++)
+		{
+			if (shards[i].table[x].node != NULL)
+			{
+				func (shards[i].table[x].node, arg);
+			}
+		}
 	}
+}
 
-	while (current_edge->next != NULL)
+int NodeHashTbl::count ()
+{
+	return n_nodes;
+}
+
+EdgeHashTbl::EdgeHashTbl()
+{
+	capacity = 1024;
+	count = 0;
+	table = (Slot *) calloc (capacity, sizeof(Slot));
+}
+
+EdgeHashTbl::~EdgeHashTbl()
+{
+	free (table);
+}
+
+EdgeHashTbl::Slot * EdgeHashTbl::find (unsigned long long key)
+{
+	size_t mask = capacity - 1;
+	for (size_t x = MixBits(key) & mask; ; x = (x + 1) & mask)
 	{
-		current_edge = current_edge->next;
+		if ((table[x].edge == NULL) || (table[x].key == key))
+			return &table[x];
 	}
-
-	current_edge->next = newEdge(from, to);
 }
 
-AnnotatedEdge * newAnnotatedEdge (Edge * e, AnnotatedEdge * next = NULL)
+void EdgeHashTbl::grow ()
 {
-	AnnotatedEdge * retval = (AnnotatedEdge *) malloc (sizeof(AnnotatedEdge));
-	retval->from = e->from;
-	retval->to = e->to;
-	retval->next = next;
-	retval->n_taken = 1;
+	Slot * old_table = table;
+	size_t old_capacity = capacity;
 
-	return retval;
+	capacity *= 2;
+	table = (Slot *) calloc (capacity, sizeof(Slot));
+
+	for (size_t i=0; i<old_capacity; i++)
+	{
+		if (old_table[i].edge != NULL)
+			*find (old_table[i].key) = old_table[i];
+	}
+	free (old_table);
 }
 
-// Returns 0 if equal names
-bool CompareNodes (Node * a, Node * b)
+AnnotatedEdge * EdgeHashTbl::get (unsigned long long key)
 {
-	assert (a->name != NULL);
-	assert (b->name != NULL);
-	return strcmp (a->name, b->name);
+	return find (key)->edge;
 }
 
-// Returns 0 if equal
-bool CompareEdges (Edge * a, AnnotatedEdge * b)
+void EdgeHashTbl::add (unsigned long long key, AnnotatedEdge * content)
 {
-	return (CompareNodes (a->from, b->from) 
-			|| CompareNodes (a->to, b->to));
+	assert (content != NULL);
+
+	if ((size_t) (count + 1) * 8 > capacity * 5)
+		grow();
+
+	Slot * slot = find (key);
+	if (slot->edge == NULL)
+		count++;
+	slot->key = key;
+	slot->edge = content;
 }
 
-/* 
- * Looks for the AnnotatedEdge in the tree corresponding
- * to the Edge provided 
- */
-AnnotatedEdge * GetEdgeFromTree(BinaryTree * root, Edge * edge)
-{
-        AnnotatedEdge * temp;
-        if (! (temp = (AnnotatedEdge*)(root->get ((void*)&(edge->key)))))
-        {
-                return NULL;
-        }
-        while (temp != NULL)
-        {
-                if (CompareEdges(edge, temp) == 0)
-                        return temp;
-                temp = temp->next;
-        }
-        return NULL;
+void EdgeHashTbl::walk (void (*func)(void *, void*), void* arg)
+{
+	for (size_t x=0; x<capacity; x++)
+	{
+		if (table[x].edge != NULL)
+		{
+			func (table[x].edge, arg);
+		}
+	}
 }
 
 /*
- * convert an Edge to an AnnotatedEdge and
- * insert it in the tree
- */     
-void InsertEdgeInTree(BinaryTree * tree, Edge * edge)
+ * remove bad characters from names, should move somewhere else probably.
+ * returns the fixed length of name
+ */
+size_t FixName (const char * name, size_t length)
 {
-#ifdef DEBUG
-        assert (GetEdgeFromTree(tree, edge) == NULL);
-#endif  
-        void * key = &(edge->key);
-        AnnotatedEdge * list;
-
-        if (list = (AnnotatedEdge*)tree->get(key))
-        {
-                list->next = newAnnotatedEdge(edge, list->next);
-        }
-        else
-        {
-                tree->put(key, (void *)newAnnotatedEdge(edge));
-        }
+	// Node names may not end with '\' or '/'
+	while ((length > 0)
+		&& ((name[length-1] == '\\') || (name[length-1] == '/')))
+	{
+		length--;
+	}
+	return length;
 }
 
-void addAnnotatedEdge(AnnotatedGraph * g, Edge * edge)
+Node * getNode (const char * name, size_t length, NodeHashTbl * nodehash)
 {
-	AnnotatedEdge * this_edge = NULL;
-	AnnotatedEdge * last_edge = NULL;
-	BinaryTree * tree = g->edgetree;
+        length = FixName(name, length);
+
+        return nodehash->intern(name, length);
+}
 
-        if (this_edge = GetEdgeFromTree(tree, edge))
-        {
-                this_edge->n_taken++;
-        }
-        else
-        {
-                InsertEdgeInTree(tree, edge);
-        }
+void newSession (SessionList * sessions, Node * start)
+{
+	assert (start != NULL);
 
+	sessions->start.push_back(sessions->path.size());
+	sessions->path.push_back(start->id);
 }
 
-int CompareKey(const void * leftp, const void * rightp)
+void addEdge (SessionList * sessions, Node * to)
 {
-        int left  = *(int*)leftp;
-        int right = *(int*)rightp;
+	assert (!sessions->start.empty());
 
-        if (left < right)
-                return -1;
-        else if (left > right)
-                return 1;
-        else
-                return 0;
+	sessions->path.push_back(to->id);
 }
 
-AnnotatedGraph * summarize (GraphList g, Config * config)
+/* 
+ * packs the ids of both nodes into a key that is unique
+ * for this (from,to) pair
+ */
+unsigned long long EdgeKey (uint32_t from, uint32_t to)
 {
-	AnnotatedGraph * retval = (AnnotatedGraph *) malloc (sizeof(AnnotatedGraph));
-	int count = 1;
+	return ((unsigned long long) from << 32) | to;
+}
 
-	retval->edgetree = new BinaryTree(CompareKey);
+AnnotatedEdge * newAnnotatedEdge (Arena * memory, Node * from, Node * to, AnnotatedEdge * next = NULL)
+{
+	AnnotatedEdge * retval = (AnnotatedEdge *) memory->alloc (sizeof(AnnotatedEdge));
+	retval->from = from;
+	retval->to = to;
+	retval->next = next;
+	retval->n_taken = 1;
 
-	GraphListNode * current_graphlistnode = g;
+	return retval;
+}
 
-	while (current_graphlistnode != NULL)
+void addAnnotatedEdge(AnnotatedGraph * g, uint32_t from, uint32_t to, NodeHashTbl * nodehash, int n_taken)
+{
+	unsigned long long key = EdgeKey(from, to);
+	AnnotatedEdge * this_edge = g->edgetree->get(key);
+
+	if (this_edge != NULL)
+	{
+		this_edge->n_taken += n_taken;
+	}
+	else
 	{
-		assert (current_graphlistnode->graph != NULL);
+		// only new edges need the nodes themselves
+		this_edge = newAnnotatedEdge(g->memory, nodehash->byId(from), nodehash->byId(to));
+		this_edge->n_taken = n_taken;
+		g->edgetree->add(key, this_edge);
+	}
+}
 
-		current_graphlistnode->graph->start->start++;
+AnnotatedGraph * newAnnotatedGraph ()
+{
+	AnnotatedGraph * retval = (AnnotatedGraph *) malloc (sizeof(AnnotatedGraph));
+	retval->edgetree = new EdgeHashTbl();
+	retval->memory = new Arena();
+	return retval;
+}
 
-		Edge * current_edge = current_graphlistnode->graph->edges;
-		Node * last_node = NULL;
+void freeAnnotatedGraph (AnnotatedGraph * ag)
+{
+	delete (ag->edgetree);
+	delete (ag->memory);
+	free (ag);
+}
 
-		if (current_edge == NULL)
-		{
-			last_node = current_graphlistnode->graph->start;
-		}
+void addEdges (AnnotatedGraph * ag, SessionList * sessions, NodeHashTbl * nodehash)
+{
+	const uint32_t * path = sessions->path.data();
+	size_t n_sessions = sessions->start.size();
 
-		while (current_edge != NULL)
+	for (size_t i=0; i<n_sessions; i++)
+	{
+		size_t end = (i+1 < n_sessions) ? sessions->start[i+1] : sessions->path.size();
+		for (size_t x = sessions->start[i] + 1; x < end; x++)
 		{
-			last_node = current_edge->to;
-			addAnnotatedEdge(retval, current_edge);
-			current_edge = current_edge->next;
+			addAnnotatedEdge(ag, path[x-1], path[x], nodehash);
 		}
+	}
+}
+
+void countStartsAndEnds (SessionList * sessions, NodeHashTbl * nodehash)
+{
+	size_t n_sessions = sessions->start.size();
+
+	for (size_t i=0; i<n_sessions; i++)
+	{
+		size_t end = (i+1 < n_sessions) ? sessions->start[i+1] : sessions->path.size();
+		nodehash->byId(sessions->path[sessions->start[i]])->start++;
+		nodehash->byId(sessions->path[end-1])->end++;
+	}
+}
 
-		last_node->end++;
+/* a pointer to the AnnotatedGraph merged into is passed on while walking */
+void MergeEdge (void * content, void * arg)
+{
+	AnnotatedGraph * into = (AnnotatedGraph *) arg;
+	AnnotatedEdge * edge = (AnnotatedEdge *) content;
+	unsigned long long key = EdgeKey(edge->from->id, edge->to->id);
 
-		current_graphlistnode = current_graphlistnode->next;
+	AnnotatedEdge * this_edge = into->edgetree->get(key);
+	if (this_edge != NULL)
+	{
+		this_edge->n_taken += edge->n_taken;
 	}
+	else
+	{
+		into->edgetree->add(key, edge);
+	}
+}
+
+void mergeAnnotatedGraph (AnnotatedGraph * into, AnnotatedGraph * from)
+{
+	from->edgetree->walk (MergeEdge, into);
+	into->memory->adopt (*from->memory);
+	freeAnnotatedGraph (from);
+}
+
+AnnotatedGraph * summarize (SessionList * sessions, NodeHashTbl * nodehash, Config * config)
+{
+	AnnotatedGraph * retval = newAnnotatedGraph();
+
+	addEdges(retval, sessions, nodehash);
+	countStartsAndEnds(sessions, nodehash);
+
 	return retval;
 }
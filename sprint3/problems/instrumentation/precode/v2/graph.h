@@ -2,14 +2,19 @@
 #define GRAPH_H
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
 #include "config.h"
-#include "binarytree.h"
 
 #define N_PAGES 50
 
 struct Node
 {
 	char * name;
+	uint32_t id;	// dense number handed out by NodeHashTbl, see byId
 	int start;
 	int end;
 	int used;
@@ -21,49 +26,111 @@ struct NodeListNode
 	NodeListNode * next;
 };
 
-class HashNode
+/*
+ * Chunks of memory for objects and strings that live as long as the
+ * arena. Nothing is freed one by one, so allocating is a pointer bump
+ * and destroying the arena frees everything with a free per chunk.
+ * Not thread safe, every thread has to use its own arena.
+ */
+class Arena
 {
 public:
-        HashNode (char* n_key, Node* n_node, HashNode* n_next)
-        {
-                key = n_key;
-                node = n_node;
-                next = n_next;
-        }
-	void walk (void (*func)(void *, void *), void *);
-
-        char * key;
-        Node * node;
-        HashNode * next;
+	Arena ();
+	~Arena ();
+
+	/* returns size bytes aligned for any type, never NULL */
+	void * alloc (size_t size);
+	/* returns a copy of the first length characters of str, zero-terminated */
+	char * store (const char * str, size_t length);
+	/* takes over all memory of other, which is left empty */
+	void adopt (Arena & other);
+private:
+	struct Chunk
+	{
+		Chunk * next;
+		size_t used;
+		size_t size;
+		char data[1];
+	};
+	char * reserve (size_t size, size_t align);
+
+	Chunk * chunks;
+	Arena(const Arena &);
 };
 
+/*
+ * Open-addressing (linear probing) hash table from node names to nodes.
+ * Every slot caches the full hash of its key, so probing compares
+ * hashes first and only calls memcmp when they match. The table doubles
+ * when it gets more than 5/8 full, so lookups stay O(1) on average no
+ * matter how many distinct names the input has.
+ *
+ * The table is split into shards chosen by the top bits of the hash,
+ * each with its own lock, so several reader threads can intern names
+ * at the same time without waiting on each other much.
+ */
 class NodeHashTbl
 {
 public:
-        NodeHashTbl (int n_size);
-        ~NodeHashTbl ()
-        {
-                free (table);
-        }
-
-        void add (char * key, Node * content);
-        Node * get (char * key);
-        int size;
-        HashNode ** table;
+	/* n_size is only a hint, the table grows when needed */
+	NodeHashTbl (int n_size);
+	~NodeHashTbl ();
+
+	Node * get (char * key);
+	/* key does not have to be zero-terminated */
+	Node * get (const char * key, size_t length);
+	/*
+	 * returns the node named key, creating it when it doesn't exist yet.
+	 * safe to call from several threads at once.
+	 */
+	Node * intern (const char * key, size_t length);
+	/*
+	 * returns the node with this id. safe to call from several threads
+	 * for any id that intern returned to one of them.
+	 */
+	Node * byId (uint32_t id);
+	/* not thread safe, only walk when all threads are done */
 	void walk (void (*func)(void *, void *), void *);
-private:
-        unsigned int HashString (const char * str);
-        NodeHashTbl();
-        NodeHashTbl(const NodeHashTbl &);
-};
-
-struct Edge
-{
-	Node * from;
-	Node * to;
-	Edge * next;
 
-	int key;
+	/* number of nodes in the table */
+	int count ();
+private:
+	struct Slot
+	{
+		unsigned long long hash;
+		size_t length;
+		char * key;
+		Node * node;	// NULL for an empty slot
+	};
+
+	struct Shard
+	{
+		std::mutex lock;
+		Slot * table;
+		size_t capacity;	// always a power of two
+		size_t count;
+		Arena memory;	// nodes of this shard and their names
+	};
+
+	static const int kShardBits = 6;
+	static const int kShards = 1 << kShardBits;
+
+	// nodes by id, in segments allocated as ids get handed out
+	static const int kSegmentBits = 16;
+	static const int kSegmentSize = 1 << kSegmentBits;
+	static const int kSegments = 1 << (31 - kSegmentBits);
+
+	static unsigned long long HashString (const char * str, size_t length);
+	static Slot * find (Shard * shard, const char * key, size_t length, unsigned long long hash);
+	static void grow (Shard * shard);
+	Shard * shardFor (unsigned long long hash);
+
+	Shard shards[kShards];
+	std::atomic<int> n_nodes;	// also hands out node ids
+	std::atomic<Node **> segments[kSegments];
+
+	NodeHashTbl();
+	NodeHashTbl(const NodeHashTbl &);
 };
 
 struct AnnotatedEdge 
@@ -74,47 +141,103 @@ struct AnnotatedEdge
 	int n_taken;
 };
 
-struct Graph
+/*
+ * The sessions read from (part of) the input, stored CSR style: the
+ * ids of the nodes session i visited are path[start[i]] up to the next
+ * session's start, or the end of path for the last session. Every two
+ * consecutive nodes of a session make an edge.
+ */
+struct SessionList
 {
-	char * name;
-	Node * start;
-	Edge * edges;
+	std::vector<uint32_t> path;
+	std::vector<size_t> start;
 };
 
-struct AnnotatedGraph 
+/*
+ * Open-addressing hash table from packed (from,to) node id pairs to
+ * the annotated edge counting that pair. Like NodeHashTbl it probes
+ * linearly and doubles when more than 5/8 full, so counting an edge
+ * is O(1) on average regardless of the order edges arrive in.
+ */
+class EdgeHashTbl
 {
-	BinaryTree * edgetree;
+public:
+	EdgeHashTbl ();
+	~EdgeHashTbl ();
+
+	/* returns NULL when no edge with this key was added */
+	AnnotatedEdge * get (unsigned long long key);
+	void add (unsigned long long key, AnnotatedEdge * content);
+	void walk (void (*func)(void *, void *), void *);
+
+	/* number of edges in the table */
+	int count;
+private:
+	struct Slot
+	{
+		unsigned long long key;
+		AnnotatedEdge * edge;	// NULL for an empty slot
+	};
+
+	Slot * find (unsigned long long key);
+	void grow ();
+
+	Slot * table;
+	size_t capacity;	// always a power of two
+
+	EdgeHashTbl(const EdgeHashTbl &);
 };
 
-struct GraphListNode
+struct AnnotatedGraph 
 {
-	Graph * graph;
-	GraphListNode * next;
+	EdgeHashTbl * edgetree;
+	Arena * memory;		// owns the annotated edges
 };
 
-typedef struct GraphListNode * GraphList;
 typedef struct NodeListNode * NodeList;
 
 /*
- * Takes the name of a node and returns the node with that name, or, if that node doesn't
- * exist, adds a node with that name to the global nodelist.
+ * strips what may not end a node name from name,
+ * returns the length of what is left
  */
-Node * getNode (char * name, NodeHashTbl * nodehash);
+size_t FixName (const char * name, size_t length);
 
 /*
- * Creates a GraphListNode with an empty graph
+ * Takes the name of a node and returns the node with that name, or, if that node doesn't
+ * exist, adds a node with that name to the global nodelist.
+ * name is length characters long and does not have to be zero-terminated.
  */
-GraphListNode * newGraphListNode (GraphListNode * next, Node * start);
+Node * getNode (const char * name, size_t length, NodeHashTbl * nodehash);
 
-void addEdge (Graph * graph, Node * from, Node * to);
+/* starts a new session in sessions, beginning at node start */
+void newSession (SessionList * sessions, Node * start);
+
+/* adds an edge from the last node of the current session to node to */
+void addEdge (SessionList * sessions, Node * to);
 
 /*
  * adds an edge to an annotated graph, at the same time
  * converting it to an annotated edge and counting the number
- * of times it occurs.
+ * of times it occurs. n_taken is the number of times to count it.
+ */
+void addAnnotatedEdge(AnnotatedGraph * g, uint32_t from, uint32_t to, NodeHashTbl * nodehash, int n_taken = 1);
+
+AnnotatedGraph * newAnnotatedGraph ();
+/* frees ag together with all its annotated edges */
+void freeAnnotatedGraph (AnnotatedGraph * ag);
+
+/*
+ * counts the edges of all sessions into ag. Nodes are not touched,
+ * so threads can each fill their own ag from their own part of the input.
  */
-void addAnnotatedEdge(AnnotatedGraph * g, Edge * edge);
+void addEdges (AnnotatedGraph * ag, SessionList * sessions, NodeHashTbl * nodehash);
+
+/* counts how often nodes start and end the sessions */
+void countStartsAndEnds (SessionList * sessions, NodeHashTbl * nodehash);
+
+/* adds the edge counts of from to into, takes over its memory and frees from */
+void mergeAnnotatedGraph (AnnotatedGraph * into, AnnotatedGraph * from);
 
-AnnotatedGraph * summarize (GraphList g, Config * config);
+AnnotatedGraph * summarize (SessionList * sessions, NodeHashTbl * nodehash, Config * config);
 
 #endif
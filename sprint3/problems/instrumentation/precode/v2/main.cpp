@@ -2,39 +2,152 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
 #include "graph.h"
 #include "readfile.h"
 #include "dotgen.h"
 #include "config.h"
+#include "profile.h"
+#include "online.h"
+#include "summarycache.h"
+#include "sketch.h"
 
 void printUsage()
 {
-	fprintf(stderr, "events2dot <eventsfile>\n");
+	fprintf(stderr, "events2dot [--profile] [--follow | --approx] [--json] [--no-cache]\n");
+	fprintf(stderr, "           [--from <time>] [--to <time>] [--session <prefix>] <eventsfile>\n");
+	fprintf(stderr, "  --follow    keep reading as the file grows, SIGUSR1 prints a snapshot\n");
+	fprintf(stderr, "  --approx    count in fixed memory, keeping only the approx_edges most taken edges\n");
+	fprintf(stderr, "  --json      print json instead of dot\n");
+	fprintf(stderr, "  --no-cache  don't use or write <eventsfile>.summary\n");
+	fprintf(stderr, "  --from, --to  only events with timestamps in this range, both included;\n");
+	fprintf(stderr, "                the first such run writes the index <eventsfile>.tsidx\n");
+	fprintf(stderr, "  --session   only sessions starting with prefix\n");
+}
+
+/* parses a timestamp argument, returns false when it isn't one */
+bool parseTime (const char * str, int * value)
+{
+	char * end;
+	errno = 0;
+	long retval = strtol (str, &end, 10);
+	if ((*str == '\0') || (*end != '\0') || (errno != 0)
+			|| (retval < INT_MIN) || (retval > INT_MAX))
+		return false;
+	*value = retval;
+	return true;
 }
 
 int main (int argc, char ** argv)
 {
 	NodeHashTbl * nodehash = new NodeHashTbl (255);
-	GraphList g;
 
-	if ((argc != 2) 
-		|| (strcmp(argv[1], "--help") == 0)
-		|| (strcmp(argv[1], "-help") == 0)
-		|| (strcmp(argv[1], "-?") == 0)
-		|| (strcmp(argv[1], "-h") == 0))
+	char * file = NULL;
+	bool follow = false;
+	bool json = false;
+	bool cache = true;
+	bool approx = false;
+	EventFilter filter;
+
+	// anything else starting with '-' is a request for help
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "--profile") == 0)
+		{
+			EnableProfile();
+		}
+		else if (strcmp(argv[i], "--follow") == 0)
+		{
+			follow = true;
+		}
+		else if (strcmp(argv[i], "--json") == 0)
+		{
+			json = true;
+		}
+		else if (strcmp(argv[i], "--approx") == 0)
+		{
+			approx = true;
+		}
+		else if (strcmp(argv[i], "--no-cache") == 0)
+		{
+			cache = false;
+		}
+		else if ((strcmp(argv[i], "--from") == 0) && (i+1 < argc) && parseTime(argv[i+1], &filter.from))
+		{
+			i++;
+		}
+		else if ((strcmp(argv[i], "--to") == 0) && (i+1 < argc) && parseTime(argv[i+1], &filter.to))
+		{
+			i++;
+		}
+		else if ((strcmp(argv[i], "--session") == 0) && (i+1 < argc))
+		{
+			filter.session_prefix = argv[++i];
+		}
+		else if ((file == NULL) && (argv[i][0] != '-'))
+		{
+			file = argv[i];
+		}
+		else
+		{
+			printUsage();
+			exit(0);
+		}
+	}
+	if ((file == NULL) || (follow && approx))
 	{
 		printUsage();
 		exit(0);
 	}
 
+	// the summary is of the whole file, so filtered runs neither use nor replace it
+	if (filter.any())
+		cache = false;
+
 	Config * config;
 	config = ReadConfig ("pathalizer.conf");
 
-	g = getGraphFromFile(argv[1], nodehash, config);
+	if (follow)
+	{
+		FollowFile (file, nodehash, config, &filter, json);
+		delete (nodehash);
+		return 0;
+	}
+
+	InputStamp stamp;
+	AnnotatedGraph * ag = NULL;
+	if (approx)
+	{
+		// the summary cache holds exact counts, which is what doesn't fit here
+		ag = approximateFile(file, (config->approx_edges > 0) ? config->approx_edges : 0, nodehash, config, &filter);
+	}
+	else if (cache)
+	{
+		// an unchanged file was summarized before, only the dot file is new
+		ag = loadSummary(file, &stamp, nodehash, config);
+		if (ag != NULL)
+			EndPhase ("cache");
+	}
+	if (ag == NULL)
+	{
+		// reports the read and summarize phases itself
+		ag = summarizeFile(file, nodehash, config, &filter);
+		if (cache)
+		{
+			saveSummary(file, &stamp, ag, nodehash);
+			EndPhase ("cache");
+		}
+	}
 
-	AnnotatedGraph * ag = summarize(g, config);
+	if (json)
+		GenerateJson (stdout, ag, nodehash);
+	else
+		GenerateDot (stdout, ag, nodehash, config);
+	fflush (stdout);
+	EndPhase ("dot");
 
-	GenerateDot (stdout, ag, nodehash, config);
+	freeAnnotatedGraph (ag);
+	delete (nodehash);
 
 	return 0;
 }
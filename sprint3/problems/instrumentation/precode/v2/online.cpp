@@ -0,0 +1,146 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "online.h"
+#include "readfile.h"
+#include "dotgen.h"
+
+const size_t kFollowReadSize = 1024 * 1024;
+const long kFollowPollNs = 200 * 1000 * 1000;
+
+OnlineSummary::OnlineSummary (NodeHashTbl * n_nodehash, Config * n_config, const EventFilter * n_filter)
+{
+	nodehash = n_nodehash;
+	config = n_config;
+	filter = n_filter;
+	graph = newAnnotatedGraph();
+	last_node = NULL;
+}
+
+OnlineSummary::~OnlineSummary ()
+{
+	freeAnnotatedGraph (graph);
+}
+
+void OnlineSummary::add (const char * data, size_t size)
+{
+	EventReader in (data, size);
+	Event event;
+
+	while (in.next (event))
+	{
+		if (!filter->matches (event))
+			continue;
+		Node * current_node = getNode(event.name.data(), event.name.size(), nodehash);
+
+		if ((last_node == NULL) || (event.session != current_session))
+		{
+			// the previous session is over, so its end is final now
+			if (last_node != NULL)
+				last_node->end++;
+			current_session.assign (event.session.data(), event.session.size());
+			current_node->start++;
+		}
+		else if ((!config->ignore_refresh) // if false, just add the edge
+				|| (last_node != current_node))
+		{
+			addAnnotatedEdge(graph, last_node->id, current_node->id, nodehash);
+		}
+		last_node = current_node;
+	}
+}
+
+void OnlineSummary::snapshot (FILE * dest, bool json)
+{
+	if (last_node != NULL)
+		last_node->end++;
+
+	if (json)
+		GenerateJson (dest, graph, nodehash);
+	else
+		GenerateDot (dest, graph, nodehash, config);
+	fflush (dest);
+
+	if (last_node != NULL)
+		last_node->end--;
+}
+
+static volatile sig_atomic_t snapshot_requested = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static void OnSnapshot (int)
+{
+	snapshot_requested = 1;
+}
+
+static void OnStop (int)
+{
+	stop_requested = 1;
+}
+
+static void SetHandler (int signum, void (*handler)(int))
+{
+	// no SA_RESTART, so a signal cuts the poll sleep short
+	struct sigaction action;
+	memset (&action, 0, sizeof(action));
+	action.sa_handler = handler;
+	sigemptyset (&action.sa_mask);
+	sigaction (signum, &action, NULL);
+}
+
+void FollowFile (char * file, NodeHashTbl * nodehash, Config * config, const EventFilter * filter, bool json)
+{
+	int fd = open (file, O_RDONLY);
+	if (fd < 0)
+		FileError (file);
+
+	SetHandler (SIGUSR1, OnSnapshot);
+	SetHandler (SIGINT, OnStop);
+	SetHandler (SIGTERM, OnStop);
+
+	OnlineSummary summary (nodehash, config, filter);
+	std::vector<char> buffer (kFollowReadSize);
+	std::string pending;	// read, but not up to the end of a line yet
+
+	while (!stop_requested)
+	{
+		ssize_t n_read = read (fd, buffer.data(), buffer.size());
+		if (n_read > 0)
+		{
+			pending.append (buffer.data(), n_read);
+			size_t end = pending.rfind ('\n');
+			if (end != std::string::npos)
+			{
+				summary.add (pending.data(), end + 1);
+				pending.erase (0, end + 1);
+			}
+		}
+		else
+		{
+			struct stat st;
+			if ((fstat (fd, &st) == 0) && (st.st_size < lseek (fd, 0, SEEK_CUR)))
+			{
+				// truncated, the new contents start at the beginning
+				lseek (fd, 0, SEEK_SET);
+				pending.clear();
+			}
+			else
+			{
+				struct timespec poll = { 0, kFollowPollNs };
+				nanosleep (&poll, NULL);
+			}
+		}
+
+		if (snapshot_requested)
+		{
+			snapshot_requested = 0;
+			summary.snapshot (stdout, json);
+		}
+	}
+
+	summary.snapshot (stdout, json);
+	close (fd);
+}
@@ -0,0 +1,50 @@
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include <stdio.h>
+#include <string>
+#include "graph.h"
+#include "config.h"
+#include "readfile.h"
+
+/*
+ * Keeps the annotated graph of an events file up to date while events
+ * are appended to it. Every event is counted once, when it is added, so
+ * keeping up costs O(new events) however long the file already is.
+ */
+class OnlineSummary
+{
+public:
+	/* only events filter matches are counted */
+	OnlineSummary (NodeHashTbl * n_nodehash, Config * n_config, const EventFilter * n_filter);
+	~OnlineSummary ();
+
+	/* counts the events in data, which has to end at the end of a line */
+	void add (const char * data, size_t size);
+
+	/*
+	 * writes the graph so far to dest, as dot or as json. The session
+	 * still being read counts as ending at its last node.
+	 */
+	void snapshot (FILE * dest, bool json);
+private:
+	NodeHashTbl * nodehash;
+	Config * config;
+	const EventFilter * filter;
+	AnnotatedGraph * graph;
+
+	std::string current_session;	// copied, the read buffer gets reused
+	Node * last_node;		// NULL before the first event
+
+	OnlineSummary(const OnlineSummary &);
+};
+
+/*
+ * Reads file and keeps following it as it grows, like tail -f, until
+ * SIGINT or SIGTERM. Every SIGUSR1 writes a snapshot to stdout, and a
+ * last one is written before returning. A file that gets truncated is
+ * read again from the start, adding to the counts so far.
+ */
+void FollowFile (char * file, NodeHashTbl * nodehash, Config * config, const EventFilter * filter, bool json);
+
+#endif
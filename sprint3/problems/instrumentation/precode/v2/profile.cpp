@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "profile.h"
+
+static bool profile_enabled = false;
+static double phase_start;
+
+static double Now ()
+{
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * peak RSS in kB. ru_maxrss survives exec, so under a big parent like
+ * the benchmark script it would report the parent's peak; VmHWM doesn't
+ */
+static long PeakRss ()
+{
+	long retval = -1;
+	FILE * status = fopen ("/proc/self/status", "r");
+	if (status != NULL)
+	{
+		char line[256];
+		while (fgets (line, sizeof(line), status))
+		{
+			if (sscanf (line, "VmHWM: %ld kB", &retval) == 1)
+				break;
+		}
+		fclose (status);
+	}
+	if (retval < 0)
+	{
+		struct rusage usage;
+		getrusage (RUSAGE_SELF, &usage);	// ru_maxrss is in kB on Linux
+		retval = usage.ru_maxrss;
+	}
+	return retval;
+}
+
+void EnableProfile ()
+{
+	profile_enabled = true;
+	phase_start = Now();
+}
+
+void EndPhase (const char * name)
+{
+	if (!profile_enabled)
+		return;
+
+	double now = Now();
+	fprintf (stderr, "profile\t%s\t%.6f\t%ld\n", name, now - phase_start, PeakRss());
+	phase_start = now;
+}
@@ -1,65 +1,296 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
 #include "readfile.h"
+#include "profile.h"
+#include "timeindex.h"
 
 #undef DEBUG
 
-GraphList getGraphFromFile (char * file, NodeHashTbl * nodehash, Config * config)
+void FileError (const char * file)
 {
-	FILE * in;
-	GraphListNode * current_graphlistnode = NULL;
+	const char * error = "Error opening file with events ('";
+	char * errmsg = (char *) malloc (strlen(error) + strlen(file) + 2 + 1);
+	sprintf(errmsg, "%s%s')", error, file);
+	perror(errmsg);
+	exit(0);
+}
+
+EventFilter::EventFilter ()
+{
+	from = INT_MIN;
+	to = INT_MAX;
+}
+
+bool EventFilter::hasWindow () const
+{
+	return (from != INT_MIN) || (to != INT_MAX);
+}
+
+bool EventFilter::any () const
+{
+	return hasWindow() || !session_prefix.empty();
+}
+
+bool EventFilter::matches (const Event & event) const
+{
+	return (event.timestamp >= from) && (event.timestamp <= to)
+		&& (event.session.substr (0, session_prefix.size()) == session_prefix);
+}
+
+MappedFile::MappedFile (const char * file)
+{
+	data = NULL;
+	size = 0;
+
+	int fd = open (file, O_RDONLY);
+	if (fd < 0)
+		FileError (file);
 
-	in = fopen (file, "r");
+	struct stat st;
+	if (fstat (fd, &st) < 0)
+		FileError (file);
 
-	if (in == NULL)
+	size = st.st_size;
+	if (size > 0)	// mmap refuses empty mappings
 	{
-		char * error = "Error opening file with events ('";
-		char * errmsg = (char *) malloc (strlen(error) + strlen(file) + 2 + 1);
-		sprintf(errmsg, "%s%s')", error, file);
-		perror(errmsg);
-		exit(0);
-	};
-
-	char buffer[BUFSIZE];
-	char session[BUFSIZE];
-	int timestamp;
-	char name[BUFSIZE];
-
-	char * current_session = (char *) malloc (1); // so we can free it
-	Node * last_node = NULL;
-	Node * current_node = NULL;
+		void * mapping = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED)
+			FileError (file);
+		madvise (mapping, size, MADV_SEQUENTIAL);
+		data = (const char *) mapping;
+	}
+	close (fd);
+}
 
-#ifdef DEBUG
-	fprintf(stderr, "Ignoring refreshes: %d", config->ignore_refresh);
-#endif
+MappedFile::~MappedFile ()
+{
+	if (data != NULL)
+		munmap ((void *) data, size);
+}
+
+EventReader::EventReader (const char * n_data, size_t n_size)
+{
+	data = n_data;
+	size = n_size;
+	pos = 0;
+}
+
+/* splits the next tab-terminated field off line */
+static bool NextField (std::string_view & line, std::string_view & field)
+{
+	size_t tab = line.find ('\t');
+	if (tab == std::string_view::npos)
+		return false;
+	field = line.substr (0, tab);
+	line.remove_prefix (tab + 1);
+	return true;
+}
+
+/* parses a decimal number, without going through the locale like sscanf */
+static bool ParseInt (std::string_view str, int & value)
+{
+	if (str.empty())
+		return false;
 
-	// while (fscanf(in, "%s\t%d\t%s\n", &session, &timestamp, &name) > 0)
-	while (fgets (buffer, BUFSIZE, in))
+	bool negative = (str[0] == '-');
+	if (negative)
+		str.remove_prefix (1);
+	if (str.empty())
+		return false;
+
+	int retval = 0;
+	for (char c : str)
+	{
+		if ((c < '0') || (c > '9'))
+			return false;
+		retval = retval * 10 + (c - '0');
+	}
+	value = negative ? -retval : retval;
+	return true;
+}
+
+bool EventReader::next (Event & event)
+{
+	while (pos < size)
 	{
-		if (!sscanf(buffer, "%s\t%d\t%s\n", &session, &timestamp, &name))
-			break;
+		const char * start = data + pos;
+		const char * end = (const char *) memchr (start, '\n', size - pos);
+		size_t length = (end != NULL) ? end - start : size - pos;
+		pos += length + 1;
+
+		std::string_view line (start, length);
+		if (!line.empty() && (line.back() == '\r'))
+			line.remove_suffix (1);
+		if (line.empty())
+			continue;
+
+		std::string_view timestamp;
+		if (!NextField (line, event.session)
+				|| !NextField (line, timestamp)
+				|| !ParseInt (timestamp, event.timestamp)
+				|| line.empty())
+			return false;
+		event.name = line;
+		return true;
+	}
+	return false;
+}
 
+bool EventReader::atEnd () const
+{
+	return pos >= size;
+}
+
+/* reads the events of one chunk into sessions */
+static void getSessionsFromChunk (EventReader & in, SessionList * sessions, NodeHashTbl * nodehash, Config * config, const EventFilter * filter)
+{
+	Event event;
+	std::string_view current_session;
+	Node * last_node = NULL;
+	Node * current_node = NULL;
+
+	while (in.next (event))
+	{
+		if (!filter->matches (event))
+			continue;
 		last_node = current_node;
 
 #ifdef DEBUG
-		fprintf(stderr, "Session %s, node %s\n", session, name);
+		fprintf(stderr, "Session %.*s, node %.*s\n",
+				(int) event.session.size(), event.session.data(),
+				(int) event.name.size(), event.name.data());
 #endif
-		current_node = getNode(name, nodehash);
+		current_node = getNode(event.name.data(), event.name.size(), nodehash);
 
-		if (strcmp(session, current_session) != 0)
+		if ((last_node == NULL) || (event.session != current_session))
 		{
-			free (current_session);
-			current_session = strdup(session);
+			// the mapping outlives this loop, so no copy is needed
+			current_session = event.session;
 			// TODO maybe check for graphs without edges?
-			current_graphlistnode = newGraphListNode(current_graphlistnode, current_node);
+			newSession(sessions, current_node);
 		}
 		else
 		{
+			// nodes are unique per name, so comparing pointers is enough
 			if ((!config->ignore_refresh) // if false, just add the edge
-					|| (strcmp(last_node->name, current_node->name) != 0))
+					|| (last_node != current_node))
 			{
-				addEdge(current_graphlistnode->graph, last_node, current_node);
+				addEdge(sessions, current_node);
 			}
 		}
 	}
+}
+
+/* returns the position just after the line containing pos */
+static size_t NextLine (const MappedFile & in, size_t pos)
+{
+	const char * end = (const char *) memchr (in.data + pos, '\n', in.size - pos);
+	return (end != NULL) ? end - in.data + 1 : in.size;
+}
+
+/* returns the session field of the line starting at pos */
+static std::string_view SessionAt (const MappedFile & in, size_t pos)
+{
+	size_t end = pos;
+	while ((end < in.size) && (in.data[end] != '\t') && (in.data[end] != '\n'))
+		end++;
+	return std::string_view (in.data + pos, end - pos);
+}
+
+/*
+ * moves pos forward to the first line of a session that starts after it,
+ * so no session is split over two chunks
+ */
+static size_t SessionBoundary (const MappedFile & in, size_t pos)
+{
+	if (pos == 0)
+		return 0;
+
+	// find the line containing pos and remember its session
+	size_t line = pos;
+	while ((line > 0) && (in.data[line - 1] != '\n'))
+		line--;
+	std::string_view session = SessionAt (in, line);
+
+	line = NextLine (in, line);
+	while ((line < in.size) && (SessionAt (in, line) == session))
+		line = NextLine (in, line);
+	return line;
+}
+
+const size_t kMinChunkSize = 1024 * 1024;
+
+struct ChunkResult
+{
+	SessionList sessions;
+	AnnotatedGraph * edges;
+};
+
+std::vector<size_t> SplitOnSessions (const MappedFile & in, size_t begin, size_t end)
+{
+	size_t size = end - begin;
+	size_t n_chunks = std::thread::hardware_concurrency();
+	if (n_chunks > size / kMinChunkSize)
+		n_chunks = size / kMinChunkSize;
+	if (n_chunks < 1)
+		n_chunks = 1;
+
+	std::vector<size_t> bounds (n_chunks + 1);
+	bounds[0] = begin;
+	for (size_t i=1; i<n_chunks; i++)
+	{
+		bounds[i] = SessionBoundary (in, begin + size / n_chunks * i);
+		if (bounds[i] < bounds[i-1])	// one session spans a whole chunk
+			bounds[i] = bounds[i-1];
+		if (bounds[i] > end)
+			bounds[i] = end;
+	}
+	bounds[n_chunks] = end;
+	return bounds;
+}
+
+AnnotatedGraph * summarizeFile (char * file, NodeHashTbl * nodehash, Config * config, const EventFilter * filter)
+{
+	MappedFile in (file);
+
+#ifdef DEBUG
+	fprintf(stderr, "Ignoring refreshes: %d", config->ignore_refresh);
+#endif
+
+	size_t begin, end;
+	FilterRange (file, in, filter, &begin, &end);
+	std::vector<size_t> bounds = SplitOnSessions (in, begin, end);
+	size_t n_chunks = bounds.size() - 1;
+
+	std::vector<ChunkResult> results (n_chunks);
+	std::vector<std::thread> threads;
+	for (size_t i=0; i<n_chunks; i++)
+	{
+		threads.emplace_back ([&, i] {
+			EventReader reader (in.data + bounds[i], bounds[i+1] - bounds[i]);
+			getSessionsFromChunk (reader, &results[i].sessions, nodehash, config, filter);
+			results[i].edges = newAnnotatedGraph ();
+			addEdges (results[i].edges, &results[i].sessions, nodehash);
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+	EndPhase ("read");
+
+	AnnotatedGraph * retval = results[0].edges;
+	for (size_t i=0; i<n_chunks; i++)
+	{
+		if (i > 0)
+			mergeAnnotatedGraph (retval, results[i].edges);
+		// start and end counts live in the shared nodes, so count them here
+		countStartsAndEnds (&results[i].sessions, nodehash);
+	}
+	EndPhase ("summarize");
 
-	return current_graphlistnode;
+	return retval;
 }
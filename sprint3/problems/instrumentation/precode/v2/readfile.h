@@ -1,10 +1,99 @@
+#ifndef READFILE_H
+#define READFILE_H
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <string_view>
+#include <vector>
 #include "graph.h"
 #include "config.h"
 
-#define BUFSIZE 255
+/* reports that file can't be read and exits */
+void FileError (const char * file);
+
+/* one line of the events file: "session\ttimestamp\tname" */
+struct Event
+{
+	std::string_view session;
+	int timestamp;
+	std::string_view name;
+};
+
+/*
+ * Which events to graph: the ones with a timestamp from from up to and
+ * including to, of sessions starting with session_prefix. Events left
+ * out are skipped as if they weren't in the file at all.
+ */
+struct EventFilter
+{
+	EventFilter ();
+
+	int from;
+	int to;
+	std::string_view session_prefix;
+
+	/* true when only part of the timestamps is wanted */
+	bool hasWindow () const;
+	/* true when some events may be left out */
+	bool any () const;
+	bool matches (const Event & event) const;
+};
+
+/* a whole file mapped read-only into memory */
+class MappedFile
+{
+public:
+	/* exits with a message when file can't be opened or mapped */
+	MappedFile (const char * file);
+	~MappedFile ();
+
+	const char * data;
+	size_t size;
+private:
+	MappedFile(const MappedFile &);
+};
+
+/*
+ * Reads events from a range of a memory-mapped file. The fields of an
+ * Event point straight into the mapping, so they stay valid as long as
+ * the mapping and nothing is copied while parsing. Lines can be of any
+ * length.
+ */
+class EventReader
+{
+public:
+	/* data should start at the beginning of a line */
+	EventReader (const char * data, size_t size);
+
+	/*
+	 * parses the next line into event, skipping empty lines.
+	 * returns false at the end of the range or on a malformed line.
+	 */
+	bool next (Event & event);
+	/* true when the whole range has been read */
+	bool atEnd () const;
+private:
+	const char * data;
+	size_t size;
+	size_t pos;
+};
+
+/*
+ * Splits begin up to end of in, which start and end at line boundaries,
+ * into chunks for one thread each. Chunk i is bounds[i] up to bounds[i+1];
+ * chunks after the first start at the first line of a session, so no
+ * session is split over two of them.
+ */
+std::vector<size_t> SplitOnSessions (const MappedFile & in, size_t begin, size_t end);
+
+/*
+ * Reads the events file and counts the edges between the events filter
+ * matches. The part of the file holding them is split into chunks on
+ * session boundaries which are read and counted by one thread each,
+ * sharing nodehash; the partial counts are merged at the end.
+ */
+AnnotatedGraph * summarizeFile (char * file, NodeHashTbl * nodehash, Config * config, const EventFilter * filter);
 
-GraphList getGraphFromFile (char * file, NodeHashTbl * nodelist, Config * config);
+#endif
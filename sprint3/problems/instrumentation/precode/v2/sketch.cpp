@@ -0,0 +1,286 @@
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+#include "sketch.h"
+#include "readfile.h"
+#include "profile.h"
+#include "timeindex.h"
+
+// rows for the edges, which are many, and for session starts and ends
+const int kEdgeWidthBits = 17;
+const int kNodeWidthBits = 15;
+
+/* MurmurHash3 64 bit finalizer */
+static unsigned long long Mix (unsigned long long x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+/* 64 bit FNV-1a, mixed like NodeHashTbl does */
+unsigned long long NameHash (std::string_view name)
+{
+	unsigned long long retval = 14695981039346656037ULL;
+	for (char c : name)
+	{
+		retval ^= (unsigned char) c;
+		retval *= 1099511628211ULL;
+	}
+	return Mix (retval);
+}
+
+unsigned long long EdgeHash (unsigned long long from, unsigned long long to)
+{
+	// not symmetric, a->b and b->a are different edges
+	return Mix (from * 0x9e3779b97f4a7c15ULL + to);
+}
+
+CountMinSketch::CountMinSketch (int width_bits)
+{
+	total = 0;
+	width = (size_t) 1 << width_bits;
+	counters.assign (kDepth * width, 0);
+}
+
+size_t CountMinSketch::column (unsigned long long key, int row) const
+{
+	// every row needs a hash independent of the others
+	return Mix (key + (row + 1) * 0x9e3779b97f4a7c15ULL) & (width - 1);
+}
+
+void CountMinSketch::add (unsigned long long key, uint64_t count)
+{
+	for (int row=0; row<kDepth; row++)
+		counters[row * width + column (key, row)] += count;
+	total += count;
+}
+
+uint64_t CountMinSketch::estimate (unsigned long long key) const
+{
+	uint64_t retval = UINT64_MAX;
+	for (int row=0; row<kDepth; row++)
+		retval = std::min (retval, counters[row * width + column (key, row)]);
+	return retval;
+}
+
+void CountMinSketch::merge (const CountMinSketch & other)
+{
+	for (size_t i=0; i<counters.size(); i++)
+		counters[i] += other.counters[i];
+	total += other.total;
+}
+
+uint64_t CountMinSketch::errorBound () const
+{
+	return (uint64_t) ceil (M_E / width * total);
+}
+
+HyperLogLog::HyperLogLog ()
+{
+	registers.assign (kRegisters, 0);
+}
+
+void HyperLogLog::add (unsigned long long key)
+{
+	size_t index = key >> (64 - kPrecision);
+	unsigned long long rest = key << kPrecision;
+	uint8_t rank = (rest == 0) ? 64 - kPrecision + 1 : __builtin_clzll (rest) + 1;
+	if (rank > registers[index])
+		registers[index] = rank;
+}
+
+double HyperLogLog::estimate () const
+{
+	double sum = 0;
+	size_t zeros = 0;
+	for (uint8_t rank : registers)
+	{
+		sum += ldexp (1.0, -rank);
+		if (rank == 0)
+			zeros++;
+	}
+	double m = kRegisters;
+	double retval = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+	// few keys leave many registers empty, counting those is more precise then
+	if ((retval <= 2.5 * m) && (zeros > 0))
+		retval = m * log (m / zeros);
+	return retval;
+}
+
+void HyperLogLog::merge (const HyperLogLog & other)
+{
+	for (size_t i=0; i<kRegisters; i++)
+		registers[i] = std::max (registers[i], other.registers[i]);
+}
+
+TopEdges::TopEdges (size_t n_capacity)
+{
+	capacity = n_capacity;
+	admission = 0;
+	candidates.reserve (2 * capacity + 1);
+}
+
+void TopEdges::offer (unsigned long long key, std::string_view from, std::string_view to, uint64_t count)
+{
+	if (count <= admission)
+		return;
+
+	EdgeCandidate & candidate = candidates[key];
+	candidate.from = from;
+	candidate.to = to;
+	candidate.count = count;
+	if (candidates.size() > 2 * capacity)
+		prune ();
+}
+
+static bool CountAbove (const EdgeCandidate & a, const EdgeCandidate & b)
+{
+	return a.count > b.count;
+}
+
+void TopEdges::prune ()
+{
+	std::vector<uint64_t> counts;
+	counts.reserve (candidates.size());
+	for (const auto & candidate : candidates)
+		counts.push_back (candidate.second.count);
+	std::nth_element (counts.begin(), counts.begin() + capacity, counts.end(), std::greater<uint64_t>());
+
+	// estimates only grow, so an edge dropped now has to beat this to come back
+	admission = counts[capacity];
+	for (auto it = candidates.begin(); it != candidates.end(); )
+	{
+		if (it->second.count <= admission)
+			it = candidates.erase (it);
+		else
+			++it;
+	}
+}
+
+std::vector<EdgeCandidate> TopEdges::top ()
+{
+	std::vector<EdgeCandidate> retval;
+	retval.reserve (candidates.size());
+	for (const auto & candidate : candidates)
+		retval.push_back (candidate.second);
+	std::sort (retval.begin(), retval.end(), CountAbove);
+	if (retval.size() > capacity)
+		retval.resize (capacity);
+	return retval;
+}
+
+Sketches::Sketches (size_t n_edges)
+	: edges (kEdgeWidthBits), starts (kNodeWidthBits), ends (kNodeWidthBits), top (n_edges)
+{
+}
+
+/* counts the events of one chunk into sketches */
+static void SketchChunk (EventReader & in, Sketches * sketches, Config * config, const EventFilter * filter)
+{
+	Event event;
+	std::string_view current_session;
+	std::string_view last_name;
+	unsigned long long last_hash = 0;
+	bool in_session = false;
+
+	while (in.next (event))
+	{
+		if (!filter->matches (event))
+			continue;
+		std::string_view name (event.name.data(), FixName (event.name.data(), event.name.size()));
+		unsigned long long hash = NameHash (name);
+		sketches->nodes.add (hash);
+
+		if (!in_session || (event.session != current_session))
+		{
+			if (in_session)
+				sketches->ends.add (last_hash);
+			current_session = event.session;
+			sketches->starts.add (hash);
+			in_session = true;
+		}
+		else if ((!config->ignore_refresh) || (name != last_name))
+		{
+			unsigned long long key = EdgeHash (last_hash, hash);
+			sketches->edges.add (key);
+			sketches->top.offer (key, last_name, name, sketches->edges.estimate (key));
+		}
+		last_name = name;
+		last_hash = hash;
+	}
+	if (in_session)
+		sketches->ends.add (last_hash);
+}
+
+AnnotatedGraph * approximateFile (char * file, size_t top_edges, NodeHashTbl * nodehash, Config * config, const EventFilter * filter)
+{
+	MappedFile in (file);
+
+	size_t begin, end;
+	FilterRange (file, in, filter, &begin, &end);
+	std::vector<size_t> bounds = SplitOnSessions (in, begin, end);
+	size_t n_chunks = bounds.size() - 1;
+
+	std::vector<Sketches *> results (n_chunks);
+	std::vector<std::thread> threads;
+	for (size_t i=0; i<n_chunks; i++)
+	{
+		threads.emplace_back ([&, i] {
+			EventReader reader (in.data + bounds[i], bounds[i+1] - bounds[i]);
+			results[i] = new Sketches (top_edges);
+			SketchChunk (reader, results[i], config, filter);
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+	EndPhase ("read");
+
+	Sketches * sketches = results[0];
+	for (size_t i=1; i<n_chunks; i++)
+	{
+		sketches->edges.merge (results[i]->edges);
+		sketches->starts.merge (results[i]->starts);
+		sketches->ends.merge (results[i]->ends);
+		sketches->nodes.merge (results[i]->nodes);
+	}
+	// an edge may be among the top of the whole file without being in every chunk's
+	TopEdges top (top_edges);
+	for (size_t i=0; i<n_chunks; i++)
+	{
+		for (const auto & candidate : results[i]->top.candidates)
+		{
+			top.offer (candidate.first, candidate.second.from, candidate.second.to,
+					sketches->edges.estimate (candidate.first));
+		}
+	}
+
+	AnnotatedGraph * retval = newAnnotatedGraph ();
+	for (const EdgeCandidate & edge : top.top())
+	{
+		Node * from = getNode (edge.from.data(), edge.from.size(), nodehash);
+		Node * to = getNode (edge.to.data(), edge.to.size(), nodehash);
+		from->start = sketches->starts.estimate (NameHash (edge.from));
+		from->end = sketches->ends.estimate (NameHash (edge.from));
+		to->start = sketches->starts.estimate (NameHash (edge.to));
+		to->end = sketches->ends.estimate (NameHash (edge.to));
+		addAnnotatedEdge (retval, from->id, to->id, nodehash, edge.count);
+	}
+
+	fprintf(stderr, "  Approximate: %llu edges between ~%.0f distinct nodes (+-%.1f%%),\n",
+			(unsigned long long) sketches->edges.total, sketches->nodes.estimate(),
+			104.0 / sqrt ((double) HyperLogLog::kRegisters));
+	fprintf(stderr, "  edge counts at most %llu too high with probability %.1f%%\n",
+			(unsigned long long) sketches->edges.errorBound(),
+			100 * (1 - exp (-CountMinSketch::kDepth)));
+
+	for (Sketches * result : results)
+		delete result;
+	EndPhase ("summarize");
+
+	return retval;
+}
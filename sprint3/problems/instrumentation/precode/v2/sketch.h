@@ -0,0 +1,125 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdint.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "graph.h"
+#include "config.h"
+#include "readfile.h"
+
+/*
+ * Count-min sketch: depth rows of width counters, every key counts in
+ * one counter per row picked by a hash of its own. A count is the
+ * minimum over the rows, so it is never too low, and with probability
+ * 1 - e^-depth it is at most e/width * total too high. Sketches of the
+ * same size add up counter by counter.
+ */
+class CountMinSketch
+{
+public:
+	static const int kDepth = 4;
+
+	/* rows get 2^width_bits counters */
+	CountMinSketch (int width_bits);
+
+	/* key should already be a good hash */
+	void add (unsigned long long key, uint64_t count = 1);
+	uint64_t estimate (unsigned long long key) const;
+	/* adds the counts of other to this one */
+	void merge (const CountMinSketch & other);
+
+	/* the most an estimate can be too high with probability 1 - e^-kDepth */
+	uint64_t errorBound () const;
+
+	/* sum of everything added */
+	uint64_t total;
+private:
+	size_t column (unsigned long long key, int row) const;
+
+	size_t width;	// always a power of two
+	std::vector<uint64_t> counters;	// kDepth rows of width
+};
+
+/*
+ * HyperLogLog: estimates the number of distinct keys from the longest
+ * run of leading zero bits of their hashes, with a relative standard
+ * error of about 1.04 / sqrt(2^kPrecision) in 2^kPrecision bytes.
+ */
+class HyperLogLog
+{
+public:
+	static const int kPrecision = 14;
+	static const size_t kRegisters = (size_t) 1 << kPrecision;
+
+	HyperLogLog ();
+
+	/* key should already be a good hash */
+	void add (unsigned long long key);
+	double estimate () const;
+	/* counts the keys of other as well */
+	void merge (const HyperLogLog & other);
+private:
+	std::vector<uint8_t> registers;
+};
+
+/* an edge that may be one of the most taken ones */
+struct EdgeCandidate
+{
+	std::string_view from;
+	std::string_view to;
+	uint64_t count;		// its estimate when last updated
+};
+
+/*
+ * The at most capacity edges with the highest estimated counts seen so
+ * far. Keeps up to twice as many candidates and drops the lower half
+ * when that fills up, so offering an edge is O(1) amortized.
+ */
+class TopEdges
+{
+public:
+	TopEdges (size_t n_capacity);
+
+	/* offers edge key with its current estimate */
+	void offer (unsigned long long key, std::string_view from, std::string_view to, uint64_t count);
+	/* the candidates, highest count first, at most capacity of them */
+	std::vector<EdgeCandidate> top ();
+
+	std::unordered_map<unsigned long long, EdgeCandidate> candidates;
+private:
+	void prune ();
+
+	size_t capacity;
+	uint64_t admission;	// counts up to here were dropped before
+};
+
+/*
+ * What --approx remembers of an events file: memory doesn't grow with
+ * the number of distinct nodes or edges.
+ */
+struct Sketches
+{
+	Sketches (size_t n_edges);
+
+	CountMinSketch edges;	// by EdgeHash
+	CountMinSketch starts;	// by NameHash of the first node of a session
+	CountMinSketch ends;	// by NameHash of the last node of a session
+	HyperLogLog nodes;	// by NameHash
+	TopEdges top;
+};
+
+unsigned long long NameHash (std::string_view name);
+unsigned long long EdgeHash (unsigned long long from, unsigned long long to);
+
+/*
+ * Like summarizeFile, but the edges are counted in sketches instead of
+ * exactly. Only the top_edges edges with the highest estimates and
+ * their nodes end up in the returned graph and in nodehash, with
+ * estimated counts that may be a little too high; the error bounds and
+ * the estimated number of distinct nodes are reported on stderr.
+ */
+AnnotatedGraph * approximateFile (char * file, size_t top_edges, NodeHashTbl * nodehash, Config * config, const EventFilter * filter);
+
+#endif
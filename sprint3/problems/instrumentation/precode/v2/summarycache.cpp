@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "summarycache.h"
+#include "readfile.h"
+
+static const char kMagic[8] = { 'E', '2', 'D', 'S', 'U', 'M', 'R', 'Y' };
+static const uint32_t kVersion = 1;
+
+struct SummaryHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t ignore_refresh;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint32_t n_nodes;
+	uint32_t n_edges;
+};
+
+struct SummaryNode
+{
+	uint32_t length;
+	int32_t start;
+	int32_t end;
+};
+
+struct SummaryEdge
+{
+	uint32_t from;
+	uint32_t to;
+	int32_t n_taken;
+};
+
+static std::string SidecarName (const char * file)
+{
+	return std::string (file) + ".summary";
+}
+
+/* reads the fixed size record at pos, returns false when data ends before it */
+template <typename T>
+static bool ReadRecord (const std::vector<char> & data, size_t & pos, T & record)
+{
+	if (data.size() - pos < sizeof(T))
+		return false;
+	memcpy (&record, data.data() + pos, sizeof(T));
+	pos += sizeof(T);
+	return true;
+}
+
+/* reads all of file, returns false when it can't be read */
+static bool ReadAll (const char * file, std::vector<char> & data)
+{
+	FILE * in = fopen (file, "rb");
+	if (in == NULL)
+		return false;
+
+	bool retval = false;
+	struct stat st;
+	if (fstat (fileno (in), &st) == 0)
+	{
+		data.resize (st.st_size);
+		retval = fread (data.data(), 1, data.size(), in) == data.size();
+	}
+	fclose (in);
+	return retval;
+}
+
+/*
+ * checks that the nodes and edges after the header are all there and
+ * that edges only refer to those nodes, before anything is interned
+ */
+static bool CheckLayout (const std::vector<char> & data, size_t pos, const SummaryHeader & header)
+{
+	for (uint32_t i=0; i<header.n_nodes; i++)
+	{
+		SummaryNode node;
+		if (!ReadRecord (data, pos, node) || (data.size() - pos < node.length))
+			return false;
+		pos += node.length;
+	}
+	for (uint32_t i=0; i<header.n_edges; i++)
+	{
+		SummaryEdge edge;
+		if (!ReadRecord (data, pos, edge)
+				|| (edge.from >= header.n_nodes) || (edge.to >= header.n_nodes))
+			return false;
+	}
+	return pos == data.size();
+}
+
+AnnotatedGraph * loadSummary (const char * file, InputStamp * stamp, NodeHashTbl * nodehash, Config * config)
+{
+	struct stat st;
+	if (stat (file, &st) < 0)
+		FileError (file);
+	stamp->size = st.st_size;
+	stamp->mtime_sec = st.st_mtim.tv_sec;
+	stamp->mtime_nsec = st.st_mtim.tv_nsec;
+	stamp->ignore_refresh = config->ignore_refresh;
+
+	std::string sidecar = SidecarName (file);
+	std::vector<char> data;
+	if (!ReadAll (sidecar.c_str(), data))
+		return NULL;
+
+	size_t pos = 0;
+	SummaryHeader header;
+	if (!ReadRecord (data, pos, header)
+			|| (memcmp (header.magic, kMagic, sizeof(kMagic)) != 0)
+			|| (header.version != kVersion)
+			|| (header.ignore_refresh != stamp->ignore_refresh)
+			|| (header.size != stamp->size)
+			|| (header.mtime_sec != stamp->mtime_sec)
+			|| (header.mtime_nsec != stamp->mtime_nsec)
+			|| !CheckLayout (data, pos, header))
+		return NULL;
+
+	// nodes come in id order, so interning them into an empty table gives the same ids
+	for (uint32_t i=0; i<header.n_nodes; i++)
+	{
+		SummaryNode record;
+		ReadRecord (data, pos, record);
+		Node * node = nodehash->intern (data.data() + pos, record.length);
+		pos += record.length;
+		if (node->id != i)
+		{
+			// only a sidecar with a name twice gets here, and nodehash is spoiled by then
+			fprintf (stderr, "Corrupt summary file '%s', remove it and run again\n", sidecar.c_str());
+			exit (1);
+		}
+		node->start = record.start;
+		node->end = record.end;
+	}
+
+	AnnotatedGraph * retval = newAnnotatedGraph ();
+	for (uint32_t i=0; i<header.n_edges; i++)
+	{
+		SummaryEdge record;
+		ReadRecord (data, pos, record);
+		addAnnotatedEdge (retval, record.from, record.to, nodehash, record.n_taken);
+	}
+	return retval;
+}
+
+/* a pointer to a vector of edges is passed on to CollectSummaryEdge while walking */
+static void CollectSummaryEdge (void * content, void * arg)
+{
+	std::vector<SummaryEdge> * edges = (std::vector<SummaryEdge> *) arg;
+	for (AnnotatedEdge * current = (AnnotatedEdge *)content; current != NULL; current = current->next)
+	{
+		SummaryEdge edge = { current->from->id, current->to->id, current->n_taken };
+		edges->push_back (edge);
+	}
+}
+
+void saveSummary (const char * file, const InputStamp * stamp, AnnotatedGraph * ag, NodeHashTbl * nodehash)
+{
+	std::vector<SummaryEdge> edges;
+	edges.reserve (ag->edgetree->count);
+	ag->edgetree->walk (CollectSummaryEdge, &edges);
+
+	SummaryHeader header;
+	memset (&header, 0, sizeof(header));
+	memcpy (header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.ignore_refresh = stamp->ignore_refresh;
+	header.size = stamp->size;
+	header.mtime_sec = stamp->mtime_sec;
+	header.mtime_nsec = stamp->mtime_nsec;
+	header.n_nodes = nodehash->count();
+	header.n_edges = edges.size();
+
+	// written next to the sidecar and renamed over it, so readers never see half a file
+	std::string sidecar = SidecarName (file);
+	std::string temporary = sidecar + ".tmp";
+	FILE * out = fopen (temporary.c_str(), "wb");
+	if (out == NULL)
+	{
+		perror (("Can't write summary file ('" + temporary + "')").c_str());
+		return;
+	}
+
+	fwrite (&header, sizeof(header), 1, out);
+	for (uint32_t i=0; i<header.n_nodes; i++)
+	{
+		Node * node = nodehash->byId (i);
+		SummaryNode record = { (uint32_t) strlen (node->name), node->start, node->end };
+		fwrite (&record, sizeof(record), 1, out);
+		fwrite (node->name, 1, record.length, out);
+	}
+	fwrite (edges.data(), sizeof(SummaryEdge), edges.size(), out);
+
+	bool failed = ferror (out) != 0;
+	failed = (fclose (out) != 0) || failed;
+	if (failed || (rename (temporary.c_str(), sidecar.c_str()) < 0))
+	{
+		perror (("Can't write summary file ('" + sidecar + "')").c_str());
+		remove (temporary.c_str());
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef SUMMARYCACHE_H
+#define SUMMARYCACHE_H
+
+#include <stdint.h>
+#include "graph.h"
+#include "config.h"
+
+/*
+ * Summary cache: what summarizeFile computes for an events file, kept in
+ * a binary sidecar <eventsfile>.summary so that running events2dot again
+ * on the same file, say to try another min_edgewidth or max_edgecount,
+ * skips reading and counting and only generates the dot file.
+ *
+ * The sidecar is a header followed by the node table in id order and
+ * the edge counts:
+ *
+ *   header  magic "E2DSUMRY" | u32 version | u32 ignore_refresh
+ *           | u64 input size | i64 input mtime s | i64 input mtime ns
+ *           | u32 nodes | u32 edges
+ *   node    u32 name length | i32 start | i32 end | name
+ *   edge    u32 from id | u32 to id | i32 count
+ *
+ * Numbers are in the byte order of the machine that wrote the sidecar,
+ * a sidecar from another machine just doesn't match and is rebuilt.
+ * It only counts when size and mtime of the events file and the
+ * ignore_refresh setting it was built with are still the same.
+ */
+
+/* what a sidecar is valid for */
+struct InputStamp
+{
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint32_t ignore_refresh;
+};
+
+/*
+ * fills nodehash, which has to be empty, from the sidecar of file and
+ * returns its graph, or NULL when there is no valid sidecar. stamp is
+ * set to the current one of file either way, taken before file is read,
+ * so a file that changes while it is summarized gets a stale sidecar.
+ */
+AnnotatedGraph * loadSummary (const char * file, InputStamp * stamp, NodeHashTbl * nodehash, Config * config);
+
+/*
+ * writes the sidecar of file for stamp. Failing to write it only gives
+ * a warning, the next run just summarizes again
+ */
+void saveSummary (const char * file, const InputStamp * stamp, AnnotatedGraph * ag, NodeHashTbl * nodehash);
+
+#endif
@@ -0,0 +1,196 @@
+#include <limits.h>
+#include <sys/stat.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "timeindex.h"
+
+static const char kMagic[8] = { 'E', '2', 'D', 'T', 'S', 'I', 'D', 'X' };
+static const uint32_t kVersion = 1;
+
+struct IndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t block_size;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t n_blocks;
+};
+
+struct IndexBlock
+{
+	uint64_t offset;
+	int32_t lowest;
+	int32_t highest;
+};
+
+static std::string SidecarName (const char * file)
+{
+	return std::string (file) + ".tsidx";
+}
+
+/* returns the index in the sidecar if it belongs to expected */
+static bool LoadIndex (const std::string & sidecar, const IndexHeader & expected, std::vector<IndexBlock> & blocks)
+{
+	FILE * in = fopen (sidecar.c_str(), "rb");
+	if (in == NULL)
+		return false;
+
+	IndexHeader header;
+	bool retval = (fread (&header, sizeof(header), 1, in) == 1)
+		&& (memcmp (header.magic, expected.magic, sizeof(header.magic)) == 0)
+		&& (header.version == expected.version)
+		&& (header.block_size == expected.block_size)
+		&& (header.size == expected.size)
+		&& (header.mtime_sec == expected.mtime_sec)
+		&& (header.mtime_nsec == expected.mtime_nsec)
+		&& (header.n_blocks <= header.size / header.block_size + 1);
+	if (retval)
+	{
+		blocks.resize (header.n_blocks);
+		retval = (fread (blocks.data(), sizeof(IndexBlock), blocks.size(), in) == blocks.size())
+			&& (fgetc (in) == EOF);
+	}
+	fclose (in);
+
+	// offsets have to go up and stay in the file, or the range would be nonsense
+	for (size_t i=0; retval && (i<blocks.size()); i++)
+	{
+		retval = (blocks[i].offset <= header.size)
+			&& ((i == 0) || (blocks[i].offset >= blocks[i-1].offset));
+	}
+	return retval;
+}
+
+/* writes the sidecar; failing to only gives a warning */
+static void SaveIndex (const std::string & sidecar, const IndexHeader & header, const std::vector<IndexBlock> & blocks)
+{
+	std::string temporary = sidecar + ".tmp";
+	FILE * out = fopen (temporary.c_str(), "wb");
+	if (out == NULL)
+	{
+		perror (("Can't write timestamp index ('" + temporary + "')").c_str());
+		return;
+	}
+	fwrite (&header, sizeof(header), 1, out);
+	fwrite (blocks.data(), sizeof(IndexBlock), blocks.size(), out);
+
+	bool failed = ferror (out) != 0;
+	failed = (fclose (out) != 0) || failed;
+	if (failed || (rename (temporary.c_str(), sidecar.c_str()) < 0))
+	{
+		perror (("Can't write timestamp index ('" + sidecar + "')").c_str());
+		remove (temporary.c_str());
+	}
+}
+
+/* returns the start of the first line starting at or after pos */
+static size_t LineStart (const MappedFile & in, size_t pos)
+{
+	if ((pos == 0) || (pos >= in.size))
+		return (pos == 0) ? 0 : in.size;
+	if (in.data[pos - 1] == '\n')
+		return pos;
+	const char * end = (const char *) memchr (in.data + pos, '\n', in.size - pos);
+	return (end != NULL) ? end - in.data + 1 : in.size;
+}
+
+/* indexes the blocks first up to last, every thread takes a part of them */
+static void IndexBlocks (const MappedFile & in, std::vector<IndexBlock> & blocks, size_t first, size_t last)
+{
+	for (size_t i=first; i<last; i++)
+	{
+		size_t end = (i + 1 < blocks.size()) ? blocks[i + 1].offset : in.size;
+		EventReader reader (in.data + blocks[i].offset, end - blocks[i].offset);
+		Event event;
+		while (!reader.atEnd())
+		{
+			// malformed lines don't count, the lines after them do
+			if (!reader.next (event))
+				continue;
+			if (event.timestamp < blocks[i].lowest)
+				blocks[i].lowest = event.timestamp;
+			if (event.timestamp > blocks[i].highest)
+				blocks[i].highest = event.timestamp;
+		}
+	}
+}
+
+static void BuildIndex (const MappedFile & in, std::vector<IndexBlock> & blocks)
+{
+	size_t n_blocks = (in.size + kIndexBlock - 1) / kIndexBlock;
+	blocks.resize (n_blocks);
+	for (size_t i=0; i<n_blocks; i++)
+	{
+		// a line longer than a block leaves the blocks after it empty
+		blocks[i].offset = LineStart (in, i * kIndexBlock);
+		blocks[i].lowest = INT_MAX;
+		blocks[i].highest = INT_MIN;
+	}
+
+	size_t n_threads = std::thread::hardware_concurrency();
+	if (n_threads > n_blocks)
+		n_threads = n_blocks;
+	std::vector<std::thread> threads;
+	for (size_t i=0; i<n_threads; i++)
+	{
+		threads.emplace_back ([&, i] {
+			IndexBlocks (in, blocks, n_blocks * i / n_threads, n_blocks * (i + 1) / n_threads);
+		});
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+}
+
+void FilterRange (const char * file, const MappedFile & in, const EventFilter * filter, size_t * begin, size_t * end)
+{
+	*begin = 0;
+	*end = in.size;
+	if (!filter->hasWindow())
+		return;
+
+	struct stat st;
+	if (stat (file, &st) < 0)
+		FileError (file);
+
+	IndexHeader header;
+	memset (&header, 0, sizeof(header));
+	memcpy (header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.block_size = kIndexBlock;
+	header.size = in.size;
+	header.mtime_sec = st.st_mtim.tv_sec;
+	header.mtime_nsec = st.st_mtim.tv_nsec;
+
+	std::string sidecar = SidecarName (file);
+	std::vector<IndexBlock> blocks;
+	if (!LoadIndex (sidecar, header, blocks))
+	{
+		BuildIndex (in, blocks);
+		header.n_blocks = blocks.size();
+		// a file that grew since it was mapped would get an index of what was mapped
+		if ((uint64_t) st.st_size == in.size)
+			SaveIndex (sidecar, header, blocks);
+	}
+
+	size_t first = blocks.size();
+	size_t last = 0;
+	for (size_t i=0; i<blocks.size(); i++)
+	{
+		if ((blocks[i].highest < filter->from) || (blocks[i].lowest > filter->to))
+			continue;
+		if (first == blocks.size())
+			first = i;
+		last = i;
+	}
+
+	if (first == blocks.size())
+	{
+		*end = 0;	// nothing in the window
+		return;
+	}
+	*begin = blocks[first].offset;
+	*end = (last + 1 < blocks.size()) ? blocks[last + 1].offset : in.size;
+}
@@ -0,0 +1,33 @@
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include "readfile.h"
+
+/*
+ * Sparse timestamp index of an events file, kept in a sidecar
+ * <eventsfile>.tsidx. The file is cut into blocks of about kIndexBlock
+ * bytes at line boundaries and the index holds where every block starts
+ * and the lowest and highest timestamp in it, so a time window maps to
+ * the blocks that may hold its events without reading anything else.
+ * Logs are mostly in time order, so that is a narrow byte range even
+ * when sessions overlap a little.
+ *
+ *   header  magic "E2DTSIDX" | u32 version | u32 block size
+ *           | u64 input size | i64 input mtime s | i64 input mtime ns
+ *           | u64 blocks
+ *   block   u64 offset | i32 lowest timestamp | i32 highest timestamp
+ *
+ * Like the summary sidecar it is only used while size and mtime of the
+ * events file still match, and is built again otherwise.
+ */
+
+const size_t kIndexBlock = 64 * 1024;
+
+/*
+ * sets begin and end to the part of in, which is file, that holds all
+ * events in the time window of filter. The index is built when file has
+ * none yet. Without a window that is all of in.
+ */
+void FilterRange (const char * file, const MappedFile & in, const EventFilter * filter, size_t * begin, size_t * end);
+
+#endif
@@ -1,8 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <functional>
 #include <iomanip>
-#include <map>
-#include <sstream>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 class Menu {
 public:
@@ -24,10 +31,15 @@ public:
     }
 
     void Run() {
+        // Строка, буфер и поток аргументов переиспользуются для всех команд
         std::string line;
+        ViewStreamBuf args_buf;
+        std::istream args{&args_buf};
         while (std::getline(input_, line)) {
-            std::istringstream cmd_stream{std::move(line)};
-            if (!ParseCommand(cmd_stream)) {
+            const auto [cmd, cmd_args] = SplitCommand(line);
+            args_buf.Reset(cmd_args);
+            args.clear();
+            if (!ExecuteCommand(cmd, args)) {
                 break;
             }
         }
@@ -37,12 +49,19 @@ public:
         if (actions_.empty()) {
             return;
         }
+        // Команды хранятся в хеш-таблице, а показываются по алфавиту
+        std::vector<const Actions::value_type*> sorted_actions;
+        sorted_actions.reserve(actions_.size());
         size_t actions_width = 0;
         size_t args_width = 0;
-        for (const auto& [action_name, info] : actions_) {
-            actions_width = std::max(actions_width, action_name.length());
-            args_width = std::max(args_width, info.args.length());
+        for (const auto& action : actions_) {
+            sorted_actions.push_back(&action);
+            actions_width = std::max(actions_width, action.first.length());
+            args_width = std::max(args_width, action.second.args.length());
         }
+        std::sort(sorted_actions.begin(), sorted_actions.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->first < rhs->first;
+        });
 
         const auto old_flags = output_.flags();
         const auto old_fill = output_.fill();
@@ -53,7 +72,8 @@ public:
 
         try {
             output_ << std::left << std::setfill(' ');
-            for (const auto& [action_name, info] : actions_) {
+            for (const auto* action : sorted_actions) {
+                const auto& [action_name, info] = *action;
                 output_ << std::setw(actions_width + 1) << action_name;
                 output_ << std::setw(args_width + 1) << info.args;
                 output_ << info.description << std::endl;
@@ -72,14 +92,43 @@ private:
         std::string description;
     };
 
-    [[nodiscard]] bool ParseCommand(std::istream& input) {
+    // Позволяет искать команду по std::string_view без создания std::string
+    struct NameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const noexcept {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    using Actions = std::unordered_map<std::string, ActionInfo, NameHash, std::equal_to<>>;
+
+    // Буфер потока, читающий прямо из чужой строки. В отличие от std::istringstream,
+    // не копирует строку и не выделяет память на каждую команду
+    class ViewStreamBuf : public std::streambuf {
+    public:
+        void Reset(std::string_view text) {
+            char* begin = const_cast<char*>(text.data());
+            setg(begin, begin, begin + text.size());
+        }
+    };
+
+    // Делит строку на имя команды и остаток с аргументами, как это делал бы input >> cmd
+    static std::pair<std::string_view, std::string_view> SplitCommand(std::string_view line) {
+        // Пробельные символы, которые пропускает operator>> в локали "C"
+        constexpr std::string_view whitespace = " \t\n\v\f\r";
+        const size_t begin = std::min(line.find_first_not_of(whitespace), line.size());
+        const size_t end = std::min(line.find_first_of(whitespace, begin), line.size());
+        return {line.substr(begin, end - begin), line.substr(end)};
+    }
+
+    [[nodiscard]] bool ExecuteCommand(std::string_view cmd, std::istream& args) {
         using namespace std::literals;
 
         try {
-            std::string cmd;
-            if (input >> cmd) {
+            if (!cmd.empty()) {
                 if (const auto it = actions_.find(cmd); it != actions_.cend()) {
-                    if (!it->second.handler(input, output_)) {
+                    if (!it->second.handler(args, output_)) {
                         return false;
                     }
                 } else {
@@ -96,5 +145,5 @@ private:
 
     std::istream& input_;
     std::ostream& output_;
-    std::map<std::string, ActionInfo> actions_;
+    Actions actions_;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <boost/beast/core/buffers_range.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <boost/system/error_code.hpp>
+#include <stdexcept>
+#include <string>
+
+#include "urldecode.h"
+
+/*
+Тело HTTP-сообщения для boost::beast, которое URL-декодируется по мере получения.
+Закодированное тело целиком в памяти не хранится, только декодированный результат.
+Ошибка декодирования прерывает разбор сообщения с errc::invalid_argument
+*/
+struct UrlDecodedBody {
+    using value_type = std::string;
+
+    class reader {
+    public:
+        template <bool isRequest, class Fields>
+        reader(boost::beast::http::header<isRequest, Fields>&, value_type& body)
+            : body_(body) {
+        }
+
+        void init(const boost::optional<std::uint64_t>& content_length,
+                  boost::system::error_code& ec) {
+            if (content_length) {
+                // Декодированное тело не длиннее закодированного
+                body_.reserve(static_cast<size_t>(*content_length));
+            }
+            ec = {};
+        }
+
+        template <class ConstBufferSequence>
+        std::size_t put(const ConstBufferSequence& buffers, boost::system::error_code& ec) {
+            std::size_t consumed = 0;
+            try {
+                for (const auto buffer : boost::beast::buffers_range_ref(buffers)) {
+                    decoder_.Feed({static_cast<const char*>(buffer.data()), buffer.size()}, body_);
+                    consumed += buffer.size();
+                }
+            } catch (const std::invalid_argument&) {
+                ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+                return consumed;
+            }
+            ec = {};
+            return consumed;
+        }
+
+        void finish(boost::system::error_code& ec) {
+            try {
+                decoder_.Finish();
+                ec = {};
+            } catch (const std::invalid_argument&) {
+                ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+            }
+        }
+
+    private:
+        value_type& body_;
+        UrlDecoder decoder_;
+    };
+};
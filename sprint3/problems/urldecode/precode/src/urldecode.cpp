@@ -1,9 +1,211 @@
 #include "urldecode.h"
 
 #include <charconv>
+#include <cstring>
 #include <stdexcept>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define URLDECODE_SSE2 1
+#define URLDECODE_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define URLDECODE_NEON 1
+#endif
+
+namespace {
+
+// Возвращает позицию первого '%' или '+' в [data, data + size) либо size, если их нет
+using FindEscapeFn = size_t (*)(const char*, size_t) noexcept;
+
+size_t FindEscapeScalar(const char* data, size_t size) noexcept {
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == '%' || data[i] == '+') {
+            return i;
+        }
+    }
+    return size;
+}
+
+#if defined(URLDECODE_SSE2)
+
+// SSE2 есть на любом x86_64, поэтому эта версия не требует проверки процессора
+size_t FindEscapeSse2(const char* data, size_t size) noexcept {
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i plus = _mm_set1_epi8('+');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const int mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus)));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + FindEscapeScalar(data + i, size - i);
+}
+
+#endif
+
+#if defined(URLDECODE_AVX2)
+
+__attribute__((target("avx2"))) size_t FindEscapeAvx2(const char* data, size_t size) noexcept {
+    const __m256i percent = _mm256_set1_epi8('%');
+    const __m256i plus = _mm256_set1_epi8('+');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percent), _mm256_cmpeq_epi8(chunk, plus))));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + FindEscapeSse2(data + i, size - i);
+}
+
+#elif defined(URLDECODE_NEON)
+
+size_t FindEscapeNeon(const char* data, size_t size) noexcept {
+    const uint8x16_t percent = vdupq_n_u8('%');
+    const uint8x16_t plus = vdupq_n_u8('+');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        const uint8x16_t found = vorrq_u8(vceqq_u8(chunk, percent), vceqq_u8(chunk, plus));
+        if (vmaxvq_u8(found) != 0) {
+            return i + FindEscapeScalar(data + i, 16);
+        }
+    }
+    return i + FindEscapeScalar(data + i, size - i);
+}
+
+#endif
+
+FindEscapeFn SelectFindEscape() noexcept {
+#if defined(URLDECODE_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return FindEscapeAvx2;
+    }
+    return FindEscapeSse2;
+#elif defined(URLDECODE_NEON)
+    return FindEscapeNeon;
+#else
+    return FindEscapeScalar;
+#endif
+}
+
+size_t FindEscape(const char* data, size_t size) noexcept {
+    static const FindEscapeFn find_escape = SelectFindEscape();
+    return find_escape(data, size);
+}
+
+int HexValue(char c) noexcept {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+}  // namespace
+
+size_t UrlDecode(std::string_view str, char* out) {
+    const char* data = str.data();
+    const size_t size = str.size();
+    size_t written = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        // Участки без escape-последовательностей копируются целиком
+        const size_t run = FindEscape(data + pos, size - pos);
+        std::memcpy(out + written, data + pos, run);
+        written += run;
+        pos += run;
+        if (pos == size) {
+            break;
+        }
+
+        if (data[pos] == '+') {
+            out[written++] = ' ';
+            ++pos;
+            continue;
+        }
+
+        const int high = pos + 2 < size ? HexValue(data[pos + 1]) : -1;
+        const int low = high >= 0 ? HexValue(data[pos + 2]) : -1;
+        if (low < 0) {
+            throw std::invalid_argument("Invalid percent-encoding at position "
+                                        + std::to_string(pos));
+        }
+        out[written++] = static_cast<char>(high * 16 + low);
+        pos += 3;
+    }
+    return written;
+}
+
 std::string UrlDecode(std::string_view str) {
-    // Реализуйте функцию UrlDecode самостоятельно
-    return {};
+    // Чаще всего декодировать нечего, и хватает одного копирования
+    if (FindEscape(str.data(), str.size()) == str.size()) {
+        return std::string(str);
+    }
+
+    std::string result(str.size(), '\0');
+    result.resize(UrlDecode(str, result.data()));
+    return result;
+}
+
+size_t UrlDecoder::Feed(std::string_view chunk, char* out) {
+    size_t written = 0;
+    size_t pos = 0;
+
+    if (pending_size_ > 0) {
+        // Дописываем начатую в прошлой части последовательность
+        char escape[3];
+        std::memcpy(escape, pending_, pending_size_);
+        size_t escape_size = pending_size_;
+        while (escape_size < 3 && pos < chunk.size()) {
+            escape[escape_size++] = chunk[pos++];
+        }
+        if (escape_size < 3) {
+            std::memcpy(pending_, escape, escape_size);
+            pending_size_ = escape_size;
+            return 0;
+        }
+        pending_size_ = 0;
+        written = UrlDecode(std::string_view(escape, 3), out);
+    }
+
+    // Шестнадцатеричные цифры не бывают '%', поэтому '%' среди двух последних байт
+    // всегда начинает последовательность, которая закончится в следующей части
+    std::string_view rest = chunk.substr(pos);
+    size_t tail = 0;
+    if (rest.size() >= 2 && rest[rest.size() - 2] == '%') {
+        tail = 2;
+    } else if (!rest.empty() && rest.back() == '%') {
+        tail = 1;
+    }
+    written += UrlDecode(rest.substr(0, rest.size() - tail), out + written);
+    std::memcpy(pending_, rest.data() + rest.size() - tail, tail);
+    pending_size_ = tail;
+
+    return written;
+}
+
+void UrlDecoder::Feed(std::string_view chunk, std::string& out) {
+    const size_t old_size = out.size();
+    out.resize(old_size + chunk.size() + kMaxPending);
+    out.resize(old_size + Feed(chunk, out.data() + old_size));
+}
+
+void UrlDecoder::Finish() {
+    if (pending_size_ > 0) {
+        pending_size_ = 0;
+        throw std::invalid_argument("Incomplete percent-encoding at the end of input");
+    }
 }
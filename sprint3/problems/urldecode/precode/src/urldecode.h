@@ -8,3 +8,36 @@
 В случае ошибки выбрасывает исключение std::invalid_argument
 */
 std::string UrlDecode(std::string_view str);
+
+/*
+Декодирует str в буфер out без выделения памяти и возвращает длину результата.
+Результат никогда не длиннее исходной строки, поэтому out должен вмещать str.size() байт.
+Ошибки обрабатываются так же, как в UrlDecode(str)
+*/
+size_t UrlDecode(std::string_view str, char* out);
+
+/*
+Декодирует вход, поступающий частями, например тело большого запроса.
+Escape-последовательность может быть разрезана между частями: её начало запоминается
+до следующего вызова Feed. Памяти требуется O(1) сверх буферов вызывающего кода
+*/
+class UrlDecoder {
+public:
+    // Сколько байт входа может быть отложено до следующей части
+    static constexpr size_t kMaxPending = 2;
+
+    /*
+    Декодирует очередную часть входа в out, который должен вмещать chunk.size() + kMaxPending
+    байт, и возвращает длину результата. Ошибки обрабатываются так же, как в UrlDecode
+    */
+    size_t Feed(std::string_view chunk, char* out);
+    // Дописывает результат декодирования chunk в конец out
+    void Feed(std::string_view chunk, std::string& out);
+
+    // Завершает вход. Выбрасывает std::invalid_argument, если последняя последовательность не дописана
+    void Finish();
+
+private:
+    char pending_[kMaxPending] = {};
+    size_t pending_size_ = 0;
+};
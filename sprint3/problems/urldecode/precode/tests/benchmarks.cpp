@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/urldecode.h"
+#include "bench_harness.h"
+
+/*
+Замеры пропускной способности UrlDecode на типичных и патологических входах.
+Запускаются отдельной программой benchmarks:
+  benchmarks [параметры bench_harness.h] [размер каждого корпуса в МБ, по умолчанию 16]
+Корпуса генерируются с фиксированным seed, поэтому результаты воспроизводимы
+*/
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct Corpus {
+    const char* name;
+    std::string data;
+};
+
+void AppendEscape(std::string& str, unsigned char c) {
+    constexpr char kHex[] = "0123456789ABCDEF";
+    str += '%';
+    str += kHex[c >> 4];
+    str += kHex[c & 0xF];
+}
+
+// Тело формы: короткие ключи и значения из слов через +, изредка закодированные символы
+std::string MakeQueryStrings(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(1, 10);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::string str;
+    while (str.size() < size) {
+        str += str.empty() ? "" : "&";
+        for (int i = length(rng); i > 0; --i) {
+            str += static_cast<char>(letter(rng));
+        }
+        str += '=';
+        for (int words = length(rng) / 3 + 1; words > 0; --words) {
+            for (int i = length(rng); i > 0; --i) {
+                if (percent(rng) < 3) {
+                    AppendEscape(str, "/:@,;"[percent(rng) % 5]);
+                } else {
+                    str += static_cast<char>(letter(rng));
+                }
+            }
+            str += words > 1 ? "+" : "";
+        }
+    }
+    return str;
+}
+
+// URL-кодированный JSON: кавычки, скобки и двоеточия закодированы через каждые несколько букв
+std::string MakeEscapedJson(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(2, 8);
+    std::string str;
+    AppendEscape(str, '{');
+    while (str.size() < size) {
+        AppendEscape(str, '"');
+        for (int i = length(rng); i > 0; --i) {
+            str += static_cast<char>(letter(rng));
+        }
+        AppendEscape(str, '"');
+        AppendEscape(str, ':');
+        str += std::to_string(rng() % 100000);
+        AppendEscape(str, ',');
+    }
+    AppendEscape(str, '}');
+    return str;
+}
+
+// Каждый байт закодирован: векторный поиск ничего не пропускает
+std::string MakeAllEscapes(size_t size, std::mt19937& rng) {
+    std::string str;
+    str.reserve(size + 3);
+    while (str.size() < size) {
+        AppendEscape(str, static_cast<unsigned char>(rng()));
+    }
+    return str;
+}
+
+// Текст без escape-последовательностей: предельная скорость поиска
+std::string MakePlainText(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string str(size, ' ');
+    std::generate(str.begin(), str.end(), [&] {
+        return static_cast<char>(letter(rng));
+    });
+    return str;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"urldecode", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t size = (options.positional.empty() ? 16 : std::stoul(options.positional[0])) << 20;
+
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(options.seed));
+    std::vector<Corpus> corpora;
+    corpora.push_back({"query", MakeQueryStrings(size, rng)});
+    corpora.push_back({"json", MakeEscapedJson(size, rng)});
+    corpora.push_back({"all-escapes", MakeAllEscapes(size, rng)});
+    corpora.push_back({"plain", MakePlainText(size, rng)});
+
+    std::vector<char> buffer(size + UrlDecoder::kMaxPending + 3);
+
+    for (const Corpus& corpus : corpora) {
+        const std::string& input = corpus.data;
+        const std::string name = "UrlDecode/"s + corpus.name;
+        suite.Run(name + "/string", [&] {
+            bench::DoNotOptimize(UrlDecode(input).size());
+        }, input.size());
+        suite.Run(name + "/buffer", [&] {
+            bench::DoNotOptimize(UrlDecode(input, buffer.data()));
+        }, input.size());
+        suite.Run(name + "/chunks", [&] {
+            UrlDecoder decoder;
+            size_t written = 0;
+            for (size_t pos = 0; pos < input.size(); pos += kChunkSize) {
+                written += decoder.Feed(std::string_view(input).substr(pos, kChunkSize),
+                                        buffer.data() + written);
+            }
+            decoder.Finish();
+            bench::DoNotOptimize(written);
+        }, input.size());
+    }
+    return suite.Finish();
+}
@@ -1,11 +1,189 @@
 #define BOOST_TEST_MODULE urlencode tests
 #include <boost/test/unit_test.hpp>
 
+#include <boost/beast/http/parser.hpp>
+#include <cctype>
+#include <optional>
+#include <random>
+#include <stdexcept>
+
+#include "../src/url_decoded_body.h"
 #include "../src/urldecode.h"
 
 BOOST_AUTO_TEST_CASE(UrlDecode_tests) {
     using namespace std::literals;
 
     BOOST_TEST(UrlDecode(""sv) == ""s);
-    // Напишите остальные тесты для функции UrlDecode самостоятельно
-}
\ No newline at end of file
+    BOOST_TEST(UrlDecode("Hello World !"sv) == "Hello World !"s);
+    BOOST_TEST(UrlDecode("Hello+World%20%21"sv) == "Hello World !"s);
+    BOOST_TEST(UrlDecode("%2f%2F%4a%4A"sv) == "//JJ"s);
+    BOOST_TEST(UrlDecode("%25%2B+"sv) == "%+ "s);
+    BOOST_TEST(UrlDecode("%00"sv) == "\0"s);
+
+    BOOST_CHECK_THROW(UrlDecode("%"sv), std::invalid_argument);
+    BOOST_CHECK_THROW(UrlDecode("abc%2"sv), std::invalid_argument);
+    BOOST_CHECK_THROW(UrlDecode("%zz"sv), std::invalid_argument);
+    BOOST_CHECK_THROW(UrlDecode("%2z"sv), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(UrlDecode_finds_escapes_at_any_offset) {
+    using namespace std::literals;
+
+    // Строки длиннее векторного регистра с escape-последовательностью на каждой позиции
+    for (size_t length = 0; length < 80; ++length) {
+        for (size_t pos = 0; pos < length; ++pos) {
+            std::string str(length, 'a');
+            str[pos] = '+';
+            std::string expected = str;
+            expected[pos] = ' ';
+            BOOST_TEST(UrlDecode(str) == expected);
+
+            str.replace(pos, 1, "%41"s);
+            expected[pos] = 'A';
+            BOOST_TEST(UrlDecode(str) == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UrlDecode_into_buffer) {
+    using namespace std::literals;
+
+    constexpr auto str = "path%2Fto+file?q=1"sv;
+    char out[str.size()];
+    const size_t length = UrlDecode(str, out);
+    BOOST_TEST(std::string_view(out, length) == "path/to file?q=1"sv);
+
+    BOOST_TEST(UrlDecode(""sv, out) == 0u);
+    BOOST_CHECK_THROW(UrlDecode("100%"sv, out), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(UrlDecoder_splits_input_at_any_position) {
+    using namespace std::literals;
+
+    const auto str = "a+b%20c%2f%2F%25%2B+%41"s;
+    const std::string expected = UrlDecode(str);
+    for (size_t first = 0; first <= str.size(); ++first) {
+        for (size_t second = first; second <= str.size(); ++second) {
+            UrlDecoder decoder;
+            std::string decoded;
+            decoder.Feed(std::string_view(str).substr(0, first), decoded);
+            decoder.Feed(std::string_view(str).substr(first, second - first), decoded);
+            decoder.Feed(std::string_view(str).substr(second), decoded);
+            decoder.Finish();
+            BOOST_TEST(decoded == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UrlDecoder_reports_errors) {
+    using namespace std::literals;
+
+    {
+        UrlDecoder decoder;
+        std::string decoded;
+        decoder.Feed("abc%4"sv, decoded);
+        BOOST_TEST(decoded == "abc"s);
+        BOOST_CHECK_THROW(decoder.Finish(), std::invalid_argument);
+    }
+    {
+        UrlDecoder decoder;
+        std::string decoded;
+        decoder.Feed("%"sv, decoded);
+        decoder.Feed("z"sv, decoded);
+        BOOST_CHECK_THROW(decoder.Feed("z"sv, decoded), std::invalid_argument);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(UrlDecodedBody_decodes_while_parsing) {
+    namespace http = boost::beast::http;
+    using namespace std::literals;
+
+    const auto header = "POST /form HTTP/1.1\r\nContent-Length: 22\r\n\r\n"s;
+    const auto body = "name=J%C3%B6rg+M%C3%BC"s;
+
+    http::request_parser<UrlDecodedBody> parser;
+    boost::system::error_code ec;
+    BOOST_TEST(parser.put(boost::asio::buffer(header), ec) == header.size());
+    BOOST_TEST(!ec);
+    // Подаём тело по одному байту, чтобы escape-последовательности разрезались
+    for (char c : body) {
+        BOOST_TEST(parser.put(boost::asio::buffer(&c, 1), ec) == 1u);
+        BOOST_TEST(!ec);
+    }
+    BOOST_TEST(parser.is_done());
+    BOOST_TEST(parser.get().body() == "name=J\xC3\xB6rg M\xC3\xBC"s);
+
+    http::request_parser<UrlDecodedBody> bad_parser;
+    bad_parser.eager(true);
+    const auto bad_message = "POST /form HTTP/1.1\r\nContent-Length: 3\r\n\r\n%zz"s;
+    bad_parser.put(boost::asio::buffer(bad_message), ec);
+    BOOST_TEST(ec == boost::system::errc::invalid_argument);
+}
+
+namespace {
+
+// Посимвольная эталонная реализация, с которой сравниваются быстрые пути
+std::optional<std::string> ReferenceUrlDecode(std::string_view str) {
+    auto is_hex = [](char c) {
+        return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+    };
+    std::string result;
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (str[i] == '+') {
+            result += ' ';
+        } else if (str[i] != '%') {
+            result += str[i];
+        } else if (i + 2 < str.size() && is_hex(str[i + 1]) && is_hex(str[i + 2])) {
+            result += static_cast<char>(std::stoi(std::string(str.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            return std::nullopt;
+        }
+    }
+    return result;
+}
+
+std::optional<std::string> TryDecode(std::string_view str) {
+    try {
+        return UrlDecode(str);
+    } catch (const std::invalid_argument&) {
+        return std::nullopt;
+    }
+}
+
+std::optional<std::string> TryDecodeInChunks(std::string_view str, size_t chunk_size) {
+    try {
+        UrlDecoder decoder;
+        std::string result;
+        for (size_t pos = 0; pos < str.size(); pos += chunk_size) {
+            decoder.Feed(str.substr(pos, chunk_size), result);
+        }
+        decoder.Finish();
+        return result;
+    } catch (const std::invalid_argument&) {
+        return std::nullopt;
+    }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(UrlDecode_matches_reference_on_random_input) {
+    // Алфавит, в котором часто встречаются '%', '+' и шестнадцатеричные цифры,
+    // чтобы случайные строки содержали и верные, и испорченные последовательности
+    constexpr std::string_view kAlphabet = "%%%%++0123456789abcdefABCDEFxyz \xff";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> length(0, 100);
+    std::uniform_int_distribution<size_t> symbol(0, kAlphabet.size() - 1);
+    std::uniform_int_distribution<size_t> chunk(1, 8);
+    for (int i = 0; i < 20000; ++i) {
+        std::string str(length(rng), ' ');
+        for (char& c : str) {
+            c = kAlphabet[symbol(rng)];
+        }
+        const auto expected = ReferenceUrlDecode(str);
+        BOOST_TEST_INFO("input: " << str);
+        BOOST_TEST((TryDecode(str) == expected));
+        BOOST_TEST((TryDecodeInChunks(str, chunk(rng)) == expected));
+    }
+}
@@ -1,6 +1,30 @@
 #include "urlencode.h"
 
+size_t UrlEncodedSize(std::string_view str) noexcept {
+    using namespace urlencode_detail;
+
+    // Каждый %-кодированный символ добавляет к длине два байта
+    size_t percent_count = 0;
+    for (const char c : str) {
+        percent_count += Classify(c) == CharClass::kPercent;
+    }
+    return str.size() + 2 * percent_count;
+}
+
 std::string UrlEncode(std::string_view str) {
-    // Напишите реализацию самостоятельно
-    return {str.begin(), str.end()};
+    const size_t size = UrlEncodedSize(str);
+    if (size == str.size()) {
+        // Кодировать нужно разве что пробелы, длина от этого не меняется
+        std::string result(str);
+        for (char& c : result) {
+            if (c == ' ') {
+                c = '+';
+            }
+        }
+        return result;
+    }
+
+    std::string result(size, '\0');
+    UrlEncode(str, result.data());
+    return result;
 }
@@ -1,7 +1,35 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 
+namespace urlencode_detail {
+
+enum class CharClass : uint8_t {
+    kKeep,     // буквы, цифры и -._~ остаются как есть
+    kSpace,    // пробел заменяется на +
+    kPercent,  // все остальные символы кодируются как %XX
+};
+
+inline constexpr std::array<CharClass, 256> kCharClasses = [] {
+    std::array<CharClass, 256> classes{};
+    for (int c = 0; c < 256; ++c) {
+        const bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                       || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+        classes[c] = keep ? CharClass::kKeep : c == ' ' ? CharClass::kSpace : CharClass::kPercent;
+    }
+    return classes;
+}();
+
+inline constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+inline CharClass Classify(char c) noexcept {
+    return kCharClasses[static_cast<unsigned char>(c)];
+}
+
+}  // namespace urlencode_detail
+
 /*
  * URL-кодирует строку str.
  * Пробел заменяется на +,
@@ -10,3 +38,36 @@
  * Зарезервированные символы: !#$&'()*+,/:;=?@[]
  */
 std::string UrlEncode(std::string_view str);
+
+/*
+ * Возвращает длину URL-кодированного представления str, не кодируя её
+ */
+size_t UrlEncodedSize(std::string_view str) noexcept;
+
+/*
+ * URL-кодирует str в out так же, как UrlEncode(str), и возвращает итератор за последним
+ * записанным символом. Позволяет писать, например, сразу в буфер заголовка ответа
+ */
+template <typename OutputIt>
+OutputIt UrlEncode(std::string_view str, OutputIt out) {
+    using namespace urlencode_detail;
+
+    for (const char c : str) {
+        switch (Classify(c)) {
+            case CharClass::kKeep:
+                *out++ = c;
+                break;
+            case CharClass::kSpace:
+                *out++ = '+';
+                break;
+            case CharClass::kPercent: {
+                const auto byte = static_cast<unsigned char>(c);
+                *out++ = '%';
+                *out++ = kHexDigits[byte >> 4];
+                *out++ = kHexDigits[byte & 0xF];
+                break;
+            }
+        }
+    }
+    return out;
+}
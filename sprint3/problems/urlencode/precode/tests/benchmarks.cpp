@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/urlencode.h"
+#include "bench_harness.h"
+
+/*
+ * Замеры пропускной способности UrlEncode на типичных и патологических входах.
+ * Запускаются отдельной программой benchmarks:
+ *   benchmarks [параметры bench_harness.h] [размер каждого корпуса в МБ, по умолчанию 16]
+ * Корпуса генерируются с фиксированным seed, поэтому результаты воспроизводимы
+ */
+
+using namespace std::literals;
+
+namespace {
+
+
+struct Corpus {
+    const char* name;
+    std::string data;
+};
+
+// Значения полей формы: слова через пробел, изредка знаки препинания
+std::string MakeQueryValues(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(1, 10);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::string str;
+    while (str.size() < size) {
+        for (int i = length(rng); i > 0; --i) {
+            str += static_cast<char>(letter(rng));
+        }
+        str += percent(rng) < 5 ? ", " : " ";
+    }
+    return str;
+}
+
+// JSON-документ, который кладут в параметр запроса: кавычки, скобки и двоеточия через каждые
+// несколько букв
+std::string MakeJson(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(2, 8);
+    std::string str = "{";
+    while (str.size() < size) {
+        str += '"';
+        for (int i = length(rng); i > 0; --i) {
+            str += static_cast<char>(letter(rng));
+        }
+        str += "\":" + std::to_string(rng() % 100000) + ",";
+    }
+    str += '}';
+    return str;
+}
+
+// Случайные байты: почти каждый символ кодируется, результат втрое длиннее входа
+std::string MakeBinary(size_t size, std::mt19937& rng) {
+    std::string str(size, '\0');
+    std::generate(str.begin(), str.end(), [&] {
+        return static_cast<char>(rng());
+    });
+    return str;
+}
+
+// Текст, который не нужно кодировать
+std::string MakePlainText(size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string str(size, ' ');
+    std::generate(str.begin(), str.end(), [&] {
+        return static_cast<char>(letter(rng));
+    });
+    return str;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"urlencode", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t size = (options.positional.empty() ? 16 : std::stoul(options.positional[0])) << 20;
+
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(options.seed));
+    std::vector<Corpus> corpora;
+    corpora.push_back({"query", MakeQueryValues(size, rng)});
+    corpora.push_back({"json", MakeJson(size, rng)});
+    corpora.push_back({"binary", MakeBinary(size, rng)});
+    corpora.push_back({"plain", MakePlainText(size, rng)});
+
+    std::vector<char> buffer(3 * (size + 64));
+
+    for (const Corpus& corpus : corpora) {
+        const std::string& input = corpus.data;
+        const std::string name = "UrlEncode/"s + corpus.name;
+        suite.Run(name + "/string", [&] {
+            bench::DoNotOptimize(UrlEncode(input).size());
+        }, input.size());
+        suite.Run(name + "/buffer", [&] {
+            bench::DoNotOptimize(UrlEncode(input, buffer.data()));
+        }, input.size());
+        suite.Run(name + "/size", [&] {
+            bench::DoNotOptimize(UrlEncodedSize(input));
+        }, input.size());
+    }
+    return suite.Finish();
+}
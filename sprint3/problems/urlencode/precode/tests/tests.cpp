@@ -1,11 +1,91 @@
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <iterator>
+#include <random>
+
 #include "../src/urlencode.h"
 
 using namespace std::literals;
 
 TEST(UrlEncodeTestSuite, OrdinaryCharsAreNotEncoded) {
     EXPECT_EQ(UrlEncode("hello"sv), "hello"s);
+    EXPECT_EQ(UrlEncode("AZaz09-._~"sv), "AZaz09-._~"s);
+}
+
+TEST(UrlEncodeTestSuite, EmptyString) {
+    EXPECT_EQ(UrlEncode(""sv), ""s);
+}
+
+TEST(UrlEncodeTestSuite, SpaceBecomesPlus) {
+    EXPECT_EQ(UrlEncode("hello world"sv), "hello+world"s);
+    EXPECT_EQ(UrlEncode("  "sv), "++"s);
+}
+
+TEST(UrlEncodeTestSuite, ReservedCharsAreEncoded) {
+    EXPECT_EQ(UrlEncode("!#$&'()*+,/:;=?@[]"sv),
+              "%21%23%24%26%27%28%29%2A%2B%2C%2F%3A%3B%3D%3F%40%5B%5D"s);
+}
+
+TEST(UrlEncodeTestSuite, OtherCharsAreEncoded) {
+    EXPECT_EQ(UrlEncode("a b%c\n"sv), "a+b%25c%0A"s);
+    EXPECT_EQ(UrlEncode("\x00\x7f\x80\xff"sv), "%00%7F%80%FF"s);
+}
+
+TEST(UrlEncodeTestSuite, EncodedSizeIsExact) {
+    for (const auto str : {""sv, "hello"sv, "a b"sv, "/path?q=1&r=2"sv, "\xd0\xbf"sv}) {
+        EXPECT_EQ(UrlEncodedSize(str), UrlEncode(str).size()) << str;
+    }
+}
+
+TEST(UrlEncodeTestSuite, EncodesToOutputIterator) {
+    std::string out = "Location: "s;
+    UrlEncode("/a b/c?d"sv, std::back_inserter(out));
+    EXPECT_EQ(out, "Location: %2Fa+b%2Fc%3Fd"s);
+
+    char buffer[16];
+    char* end = UrlEncode("x/y"sv, buffer);
+    EXPECT_EQ(std::string_view(buffer, end - buffer), "x%2Fy"sv);
+}
+
+namespace {
+
+// Посимвольная эталонная реализация, с которой сравниваются быстрые пути
+std::string ReferenceUrlEncode(std::string_view str) {
+    std::string result;
+    for (const char c : str) {
+        const auto byte = static_cast<unsigned char>(c);
+        if ((byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9')
+            || c == '-' || c == '.' || c == '_' || c == '~') {
+            result += c;
+        } else if (c == ' ') {
+            result += '+';
+        } else {
+            char escape[4];
+            std::snprintf(escape, sizeof(escape), "%%%02X", byte);
+            result += escape;
+        }
+    }
+    return result;
 }
 
-/* Напишите остальные тесты самостоятельно */
+}  // namespace
+
+TEST(UrlEncodeTestSuite, MatchesReferenceOnRandomInput) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> length(0, 100);
+    for (int i = 0; i < 20000; ++i) {
+        std::string str(length(rng), '\0');
+        for (char& c : str) {
+            // Половина символов из ASCII, чтобы в строках были и длинные участки без кодирования
+            c = static_cast<char>(rng() % 2 ? rng() % 128 : rng());
+        }
+        const std::string expected = ReferenceUrlEncode(str);
+        ASSERT_EQ(UrlEncode(str), expected);
+        ASSERT_EQ(UrlEncodedSize(str), expected.size());
+
+        std::string buffer(expected.size(), '\0');
+        ASSERT_EQ(UrlEncode(str, buffer.data()), buffer.data() + buffer.size());
+        ASSERT_EQ(buffer, expected);
+    }
+}
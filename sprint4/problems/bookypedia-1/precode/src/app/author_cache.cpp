@@ -0,0 +1,199 @@
+#include "author_cache.h"
+
+#include <stdexcept>
+
+namespace app {
+using namespace domain;
+
+AuthorCache::AuthorCache(size_t capacity)
+    : capacity_{capacity} {
+    if (capacity == 0) {
+        throw std::invalid_argument("Author cache capacity must be positive");
+    }
+}
+
+std::optional<Author> AuthorCache::FindById(const AuthorId& id) {
+    std::lock_guard lock{mutex_};
+    const auto it = by_id_.find(id);
+    if (it == by_id_.end()) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+    return Touch(it->second);
+}
+
+std::optional<Author> AuthorCache::FindByName(const std::string& name) {
+    std::lock_guard lock{mutex_};
+    const auto it = by_name_.find(name);
+    if (it == by_name_.end()) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+    return Touch(it->second);
+}
+
+uint64_t AuthorCache::GetVersion() const {
+    std::lock_guard lock{mutex_};
+    return version_;
+}
+
+void AuthorCache::Put(const Author& author, uint64_t version) {
+    std::lock_guard lock{mutex_};
+    if (version != version_ || by_id_.count(author.GetId()) || by_name_.count(author.GetName())) {
+        return;
+    }
+    if (entries_.size() == capacity_) {
+        Erase(std::prev(entries_.end()));
+    }
+    entries_.push_front(author);
+    by_id_.emplace(author.GetId(), entries_.begin());
+    by_name_.emplace(author.GetName(), entries_.begin());
+}
+
+void AuthorCache::Invalidate(const Author& author) {
+    std::lock_guard lock{mutex_};
+    ++version_;
+    if (const auto it = by_id_.find(author.GetId()); it != by_id_.end()) {
+        Erase(it->second);
+    }
+    if (const auto it = by_name_.find(author.GetName()); it != by_name_.end()) {
+        Erase(it->second);
+    }
+}
+
+AuthorCache::Stats AuthorCache::GetStats() const {
+    std::lock_guard lock{mutex_};
+    return stats_;
+}
+
+void AuthorCache::Erase(Entries::iterator it) {
+    by_id_.erase(it->GetId());
+    by_name_.erase(it->GetName());
+    entries_.erase(it);
+}
+
+std::optional<Author> AuthorCache::Touch(Entries::iterator it) {
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it);
+    return *it;
+}
+
+void CachingAuthorRepository::Save(const Author& author) {
+    // Инвалидация до записи: параллельное чтение старой строки не попадёт в кэш
+    cache_.Invalidate(author);
+    saved_.push_back(author);
+    inner_.Save(author);
+}
+
+size_t CachingAuthorRepository::Import(const std::function<std::optional<Author>()>& next) {
+    // Импорт только добавляет авторов с новыми id и именами, а промахи не кэшируются
+    return inner_.Import(next);
+}
+
+std::vector<Author> CachingAuthorRepository::GetPageByName(const std::optional<std::string>& after,
+                                                           size_t limit) {
+    return inner_.GetPageByName(after, limit);
+}
+
+std::optional<Author> CachingAuthorRepository::FindById(const AuthorId& id) {
+    if (!saved_.empty()) {
+        return inner_.FindById(id);
+    }
+    if (auto author = cache_.FindById(id)) {
+        return author;
+    }
+    const uint64_t version = cache_.GetVersion();
+    auto author = inner_.FindById(id);
+    if (author) {
+        cache_.Put(*author, version);
+    }
+    return author;
+}
+
+std::optional<Author> CachingAuthorRepository::FindByName(const std::string& name) {
+    if (!saved_.empty()) {
+        return inner_.FindByName(name);
+    }
+    if (auto author = cache_.FindByName(name)) {
+        return author;
+    }
+    const uint64_t version = cache_.GetVersion();
+    auto author = inner_.FindByName(name);
+    if (author) {
+        cache_.Put(*author, version);
+    }
+    return author;
+}
+
+std::vector<Author> CachingAuthorRepository::FindByIds(const std::vector<AuthorId>& ids) {
+    if (!saved_.empty()) {
+        return inner_.FindByIds(ids);
+    }
+    std::vector<Author> found;
+    std::vector<AuthorId> missing;
+    for (const AuthorId& id : ids) {
+        if (auto author = cache_.FindById(id)) {
+            found.push_back(std::move(*author));
+        } else {
+            missing.push_back(id);
+        }
+    }
+    if (missing.empty()) {
+        return found;
+    }
+    const uint64_t version = cache_.GetVersion();
+    for (Author& author : inner_.FindByIds(missing)) {
+        cache_.Put(author, version);
+        found.push_back(std::move(author));
+    }
+    return found;
+}
+
+// Результаты поиска зависят от запроса и не кэшируются
+std::vector<Author> CachingAuthorRepository::SearchByName(const std::string& query, size_t limit) {
+    return inner_.SearchByName(query, limit);
+}
+
+void CachingAuthorRepository::OnCommit() {
+    // До фиксации другие единицы работы могли прочитать и закэшировать старые строки
+    for (const Author& author : saved_) {
+        cache_.Invalidate(author);
+    }
+    saved_.clear();
+}
+
+namespace {
+
+class CachingUnitOfWork : public UnitOfWork {
+public:
+    CachingUnitOfWork(UnitOfWorkHolder inner, AuthorCache& cache)
+        : inner_{std::move(inner)}
+        , authors_{inner_->Authors(), cache} {
+    }
+
+    AuthorRepository& Authors() override {
+        return authors_;
+    }
+
+    // Книги не кэшируются
+    BookRepository& Books() override {
+        return inner_->Books();
+    }
+
+    void Commit() override {
+        inner_->Commit();
+        authors_.OnCommit();
+    }
+
+private:
+    UnitOfWorkHolder inner_;
+    CachingAuthorRepository authors_;
+};
+
+}  // namespace
+
+UnitOfWorkHolder CachingUnitOfWorkFactory::CreateUnitOfWork() {
+    return std::make_unique<CachingUnitOfWork>(inner_.CreateUnitOfWork(), cache_);
+}
+
+}  // namespace app
@@ -0,0 +1,110 @@
+#pragma once
+#include <boost/uuid/uuid_hash.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/author.h"
+#include "unit_of_work.h"
+
+namespace app {
+
+/*
+Потокобезопасный LRU-кэш авторов с поиском по id и по имени, общий для всех единиц работы.
+Промахи не кэшируются, поэтому от добавления новых авторов кэш не устаревает
+*/
+class AuthorCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    explicit AuthorCache(size_t capacity);
+
+    std::optional<domain::Author> FindById(const domain::AuthorId& id);
+    std::optional<domain::Author> FindByName(const std::string& name);
+
+    /*
+    Версия меняется при каждой инвалидации. Прочитанный из базы автор кладётся в кэш
+    с версией, взятой до чтения, и отбрасывается, если за это время автор мог измениться
+    */
+    uint64_t GetVersion() const;
+    void Put(const domain::Author& author, uint64_t version);
+
+    // Удаляет записи с id и с именем автора
+    void Invalidate(const domain::Author& author);
+
+    Stats GetStats() const;
+
+private:
+    using Entries = std::list<domain::Author>;
+
+    void Erase(Entries::iterator it);
+    std::optional<domain::Author> Touch(Entries::iterator it);
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    // Недавно использованные авторы в начале списка
+    Entries entries_;
+    std::unordered_map<domain::AuthorId, Entries::iterator, util::TaggedHasher<domain::AuthorId>> by_id_;
+    std::unordered_map<std::string, Entries::iterator> by_name_;
+    uint64_t version_ = 0;
+    Stats stats_;
+};
+
+/*
+Декоратор репозитория единицы работы: поиск сначала идёт в общий кэш.
+После первого Save единица работы читает только из базы, чтобы видеть свои изменения,
+и ничего не добавляет в кэш, так как её изменения ещё могут быть отменены
+*/
+class CachingAuthorRepository : public domain::AuthorRepository {
+public:
+    CachingAuthorRepository(domain::AuthorRepository& inner, AuthorCache& cache)
+        : inner_{inner}
+        , cache_{cache} {
+    }
+
+    void Save(const domain::Author& author) override;
+    size_t Import(const std::function<std::optional<domain::Author>()>& next) override;
+    std::vector<domain::Author> GetPageByName(const std::optional<std::string>& after,
+                                              size_t limit) override;
+    std::optional<domain::Author> FindById(const domain::AuthorId& id) override;
+    std::optional<domain::Author> FindByName(const std::string& name) override;
+    // Найденные в кэше авторы не запрашиваются, остальные загружаются одним запросом
+    std::vector<domain::Author> FindByIds(const std::vector<domain::AuthorId>& ids) override;
+    std::vector<domain::Author> SearchByName(const std::string& query, size_t limit) override;
+
+    // Повторно инвалидирует сохранённых авторов после фиксации транзакции
+    void OnCommit();
+
+private:
+    domain::AuthorRepository& inner_;
+    AuthorCache& cache_;
+    std::vector<domain::Author> saved_;
+};
+
+// Фабрика единиц работы, репозитории которых читают авторов через общий кэш
+class CachingUnitOfWorkFactory : public UnitOfWorkFactory {
+public:
+    CachingUnitOfWorkFactory(UnitOfWorkFactory& inner, size_t cache_capacity)
+        : inner_{inner}
+        , cache_{cache_capacity} {
+    }
+
+    UnitOfWorkHolder CreateUnitOfWork() override;
+
+    AuthorCache::Stats GetCacheStats() const {
+        return cache_.GetStats();
+    }
+
+private:
+    UnitOfWorkFactory& inner_;
+    AuthorCache cache_;
+};
+
+}  // namespace app
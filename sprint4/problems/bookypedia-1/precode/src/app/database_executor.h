@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+#include "unit_of_work.h"
+
+namespace app {
+
+/*
+Выполняет обращения к базе в собственных потоках, чтобы вызывающий поток не ждал сервер,
+а независимые запросы выполнялись одновременно на разных соединениях пула.
+Каждая задача получает свою единицу работы, которая фиксируется, если задача завершилась
+без исключения. Результат или исключение задачи передаётся через std::future.
+Потоков не имеет смысла заводить больше, чем соединений в пуле: лишние будут ждать соединения
+*/
+class DatabaseExecutor {
+public:
+    DatabaseExecutor(UnitOfWorkFactory& unit_factory, size_t thread_count)
+        : unit_factory_{unit_factory}
+        , pool_{std::max<size_t>(thread_count, 1)} {
+    }
+
+    DatabaseExecutor(const DatabaseExecutor&) = delete;
+    DatabaseExecutor& operator=(const DatabaseExecutor&) = delete;
+
+    // Дожидается завершения уже поставленных задач
+    ~DatabaseExecutor() {
+        pool_.join();
+    }
+
+    // Ставит в очередь fn(UnitOfWork&) и сразу возвращает будущий результат
+    template <typename Fn>
+    auto Execute(Fn fn) -> std::future<std::invoke_result_t<Fn&, UnitOfWork&>> {
+        using Result = std::invoke_result_t<Fn&, UnitOfWork&>;
+
+        // packaged_task некопируемый, а обработчики asio должны копироваться
+        auto task = std::make_shared<std::packaged_task<Result()>>([this, fn = std::move(fn)]() mutable {
+            auto unit = unit_factory_.CreateUnitOfWork();
+            if constexpr (std::is_void_v<Result>) {
+                fn(*unit);
+                unit->Commit();
+            } else {
+                Result result = fn(*unit);
+                unit->Commit();
+                return result;
+            }
+        });
+        auto result = task->get_future();
+        boost::asio::post(pool_, [task] {
+            (*task)();
+        });
+        return result;
+    }
+
+private:
+    UnitOfWorkFactory& unit_factory_;
+    boost::asio::thread_pool pool_;
+};
+
+}  // namespace app
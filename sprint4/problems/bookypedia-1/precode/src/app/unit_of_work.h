@@ -0,0 +1,32 @@
+#pragma once
+#include <memory>
+
+#include "../domain/author_fwd.h"
+#include "../domain/book_fwd.h"
+
+namespace app {
+
+/*
+Единица работы: всё, что сохранено через её репозитории, попадает в базу одной транзакцией
+при вызове Commit. Если Commit не был вызван, изменения отменяются при разрушении объекта
+*/
+class UnitOfWork {
+public:
+    virtual domain::AuthorRepository& Authors() = 0;
+    virtual domain::BookRepository& Books() = 0;
+    virtual void Commit() = 0;
+
+    virtual ~UnitOfWork() = default;
+};
+
+using UnitOfWorkHolder = std::unique_ptr<UnitOfWork>;
+
+class UnitOfWorkFactory {
+public:
+    virtual UnitOfWorkHolder CreateUnitOfWork() = 0;
+
+protected:
+    ~UnitOfWorkFactory() = default;
+};
+
+}  // namespace app
@@ -1,12 +1,48 @@
 #pragma once
 
+#include <functional>
+#include <iosfwd>
 #include <string>
+#include <vector>
+
+#include "../domain/author_fwd.h"
 
 namespace app {
 
+// Книга для показа пользователю вместе с именем автора
+struct BookInfo {
+    std::string title;
+    std::string author_name;
+    int publication_year = 0;
+};
+
 class UseCases {
 public:
     virtual void AddAuthor(const std::string& name) = 0;
+    // Добавляет много авторов сразу, фиксируя их в базе порциями
+    virtual void ImportAuthors(const std::vector<std::string>& names) = 0;
+    /*
+    Потоково добавляет авторов из CSV-файла, по имени в первом столбце каждой записи.
+    Пустые имена и имена, которые уже есть в базе, пропускаются.
+    Возвращает количество добавленных авторов
+    */
+    virtual size_t ImportAuthorsFromCsv(std::istream& input) = 0;
+    /*
+    Передаёт visit всех авторов в порядке имён. Авторы загружаются из базы страницами,
+    поэтому память не зависит от размера каталога, а первые авторы приходят сразу
+    */
+    virtual void ForEachAuthor(const std::function<void(const domain::Author&)>& visit) = 0;
+    // Ищет авторов по части имени, допуская опечатки. Самые похожие имена идут первыми
+    virtual std::vector<domain::Author> FindAuthors(const std::string& query) = 0;
+
+    // author_id - id автора в текстовом виде
+    virtual void AddBook(const std::string& author_id, const std::string& title, int publication_year) = 0;
+    /*
+    Книги с именами авторов. Сколько бы ни было книг и авторов, список читается
+    из базы постоянным числом запросов
+    */
+    virtual std::vector<BookInfo> GetBooks() = 0;
+    virtual std::vector<BookInfo> GetAuthorBooks(const std::string& author_id) = 0;
 
 protected:
     ~UseCases() = default;
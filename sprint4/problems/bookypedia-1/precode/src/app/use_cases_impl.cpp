@@ -1,12 +1,152 @@
 #include "use_cases_impl.h"
 
+#include <algorithm>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/uuid/uuid_hash.hpp>
+#include <exception>
+#include <future>
+#include <unordered_map>
+
 #include "../domain/author.h"
+#include "../domain/book.h"
+#include "../util/csv.h"
+#include "../util/tagged_uuid.h"
 
 namespace app {
 using namespace domain;
 
+namespace {
+
+// Имена авторов всех книг загружаются одним запросом, а не отдельным запросом на книгу
+std::vector<BookInfo> ToBookInfos(AuthorRepository& authors, const std::vector<Book>& books) {
+    std::unordered_map<AuthorId, std::string, util::TaggedHasher<AuthorId>> names;
+    for (const Book& book : books) {
+        names.try_emplace(book.GetAuthorId());
+    }
+    if (!names.empty()) {
+        std::vector<AuthorId> ids;
+        ids.reserve(names.size());
+        for (const auto& [id, name] : names) {
+            ids.push_back(id);
+        }
+        for (const Author& author : authors.FindByIds(ids)) {
+            names[author.GetId()] = author.GetName();
+        }
+    }
+
+    std::vector<BookInfo> infos;
+    infos.reserve(books.size());
+    for (const Book& book : books) {
+        infos.push_back({book.GetTitle(), names.at(book.GetAuthorId()), book.GetPublicationYear()});
+    }
+    return infos;
+}
+
+}  // namespace
+
 void UseCasesImpl::AddAuthor(const std::string& name) {
-    authors_.Save({AuthorId::New(), name});
+    auto unit = unit_factory_.CreateUnitOfWork();
+    unit->Authors().Save({AuthorId::New(), name});
+    unit->Commit();
+}
+
+void UseCasesImpl::ImportAuthors(const std::vector<std::string>& names) {
+    // Пакеты фиксируются независимо друг от друга, поэтому выполняются одновременно
+    std::vector<std::future<void>> batches;
+    for (size_t begin = 0; begin < names.size(); begin += kImportBatchSize) {
+        const size_t end = std::min(names.size(), begin + kImportBatchSize);
+        batches.push_back(executor_.Execute([&names, begin, end](UnitOfWork& unit) {
+            util::ReserveUUIDs(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                unit.Authors().Save({AuthorId::New(), names[i]});
+            }
+        }));
+    }
+
+    // Пакеты читают names по ссылке, поэтому дожидаемся всех, даже если один из них завершился ошибкой
+    std::exception_ptr error;
+    for (auto& batch : batches) {
+        try {
+            batch.get();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+size_t UseCasesImpl::ImportAuthorsFromCsv(std::istream& input) {
+    auto unit = unit_factory_.CreateUnitOfWork();
+    std::vector<std::string> fields;
+    const size_t imported = unit->Authors().Import([&]() -> std::optional<Author> {
+        while (util::ReadCsvRecord(input, fields)) {
+            std::string& name = fields.front();
+            boost::algorithm::trim(name);
+            if (!name.empty()) {
+                return Author{AuthorId::New(), std::move(name)};
+            }
+        }
+        return std::nullopt;
+    });
+    unit->Commit();
+    return imported;
+}
+
+void UseCasesImpl::ForEachAuthor(const std::function<void(const Author&)>& visit) {
+    // Страницы продолжаются после имени последнего показанного автора. Каждая читается
+    // в своей короткой транзакции, чтобы медленный вывод не держал соединение с базой
+    const auto read_page = [this](std::optional<std::string> after) {
+        return executor_.Execute([after = std::move(after)](UnitOfWork& unit) {
+            return unit.Authors().GetPageByName(after, kListPageSize);
+        });
+    };
+
+    auto next_page = read_page(std::nullopt);
+    for (;;) {
+        const std::vector<Author> page = next_page.get();
+        const bool is_last = page.size() < kListPageSize;
+        // Следующая страница загружается, пока visit обрабатывает текущую
+        if (!is_last) {
+            next_page = read_page(page.back().GetName());
+        }
+        for (const Author& author : page) {
+            visit(author);
+        }
+        if (is_last) {
+            return;
+        }
+    }
+}
+
+std::vector<Author> UseCasesImpl::FindAuthors(const std::string& query) {
+    auto unit = unit_factory_.CreateUnitOfWork();
+    auto authors = unit->Authors().SearchByName(query, kSearchLimit);
+    unit->Commit();
+    return authors;
+}
+
+void UseCasesImpl::AddBook(const std::string& author_id, const std::string& title, int publication_year) {
+    auto unit = unit_factory_.CreateUnitOfWork();
+    unit->Books().Save({BookId::New(), AuthorId::FromString(author_id), title, publication_year});
+    unit->Commit();
+}
+
+std::vector<BookInfo> UseCasesImpl::GetBooks() {
+    auto unit = unit_factory_.CreateUnitOfWork();
+    auto books = ToBookInfos(unit->Authors(), unit->Books().GetAll());
+    unit->Commit();
+    return books;
+}
+
+std::vector<BookInfo> UseCasesImpl::GetAuthorBooks(const std::string& author_id) {
+    auto unit = unit_factory_.CreateUnitOfWork();
+    auto books = ToBookInfos(unit->Authors(), unit->Books().GetByAuthor(AuthorId::FromString(author_id)));
+    unit->Commit();
+    return books;
 }
 
 }  // namespace app
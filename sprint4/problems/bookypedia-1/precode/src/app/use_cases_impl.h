@@ -1,19 +1,37 @@
 #pragma once
-#include "../domain/author_fwd.h"
+#include "database_executor.h"
+#include "unit_of_work.h"
 #include "use_cases.h"
 
 namespace app {
 
 class UseCasesImpl : public UseCases {
 public:
-    explicit UseCasesImpl(domain::AuthorRepository& authors)
-        : authors_{authors} {
+    // Сколько авторов импортируется в одной транзакции
+    static constexpr size_t kImportBatchSize = 1000;
+    // Сколько авторов загружается за один запрос при обходе каталога
+    static constexpr size_t kListPageSize = 500;
+    // Сколько найденных авторов показывать
+    static constexpr size_t kSearchLimit = 20;
+
+    // Запросы, которые можно выполнять параллельно с вызывающим потоком, идут через executor
+    UseCasesImpl(UnitOfWorkFactory& unit_factory, DatabaseExecutor& executor)
+        : unit_factory_{unit_factory}
+        , executor_{executor} {
     }
 
     void AddAuthor(const std::string& name) override;
+    void ImportAuthors(const std::vector<std::string>& names) override;
+    size_t ImportAuthorsFromCsv(std::istream& input) override;
+    void ForEachAuthor(const std::function<void(const domain::Author&)>& visit) override;
+    std::vector<domain::Author> FindAuthors(const std::string& query) override;
+    void AddBook(const std::string& author_id, const std::string& title, int publication_year) override;
+    std::vector<BookInfo> GetBooks() override;
+    std::vector<BookInfo> GetAuthorBooks(const std::string& author_id) override;
 
 private:
-    domain::AuthorRepository& authors_;
+    UnitOfWorkFactory& unit_factory_;
+    DatabaseExecutor& executor_;
 };
 
 }  // namespace app
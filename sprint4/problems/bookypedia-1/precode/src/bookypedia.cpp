@@ -1,21 +1,37 @@
 #include "bookypedia.h"
 
 #include <iostream>
+#include <sstream>
 
 #include "menu/menu.h"
 #include "postgres/postgres.h"
+#include "ui/script_runner.h"
 #include "ui/view.h"
+#include "util/tagged_uuid.h"
 
 namespace bookypedia {
 
 using namespace std::literals;
 
 Application::Application(const AppConfig& config)
-    : db_{pqxx::connection{config.db_url}} {
+    : unit_factory_{OpenDatabase(config), config.author_cache_size}
+    // По потоку на соединение: каждая задача занимает соединение на всё время выполнения
+    , db_executor_{unit_factory_, config.db_pool_size} {
+    util::SetNewUUIDVersion(config.time_ordered_ids ? util::UUIDVersion::TIME_ORDERED
+                                                    : util::UUIDVersion::RANDOM);
 }
 
-void Application::Run() {
-    menu::Menu menu{std::cin, std::cout};
+app::UnitOfWorkFactory& Application::OpenDatabase(const AppConfig& config) {
+    if (config.in_memory_db) {
+        return in_memory_db_.emplace().GetUnitOfWorkFactory();
+    }
+    return postgres_db_.emplace(postgres::DatabaseConfig{config.db_url, config.db_pool_size})
+        .GetUnitOfWorkFactory();
+}
+
+namespace {
+
+void AddMenuActions(menu::Menu& menu) {
     menu.AddAction("Help"s, {}, "Show instructions"s, [&menu](std::istream&) {
         menu.ShowInstructions();
         return true;
@@ -23,8 +39,26 @@ void Application::Run() {
     menu.AddAction("Exit"s, {}, "Exit program"s, [&menu](std::istream&) {
         return false;
     });
+}
+
+}  // namespace
+
+void Application::Run() {
+    menu::Menu menu{std::cin, std::cout};
+    AddMenuActions(menu);
     ui::View view{menu, use_cases_, std::cin, std::cout};
     menu.Run();
 }
 
+void Application::RunScript(std::istream& script) {
+    // Команды, которые в интерактивном режиме задают вопросы (например, выбор автора),
+    // получают пустой ввод и отменяются
+    std::istringstream no_input;
+    menu::Menu menu{no_input, std::cout};
+    AddMenuActions(menu);
+    ui::View view{menu, use_cases_, no_input, std::cout};
+    ui::ScriptRunner runner{menu, use_cases_, std::cout};
+    std::cerr << runner.Run(script);
+}
+
 }  // namespace bookypedia
@@ -1,13 +1,25 @@
 #pragma once
+#include <optional>
 #include <pqxx/pqxx>
 
+#include "app/author_cache.h"
+#include "app/database_executor.h"
 #include "app/use_cases_impl.h"
+#include "in_memory/in_memory.h"
 #include "postgres/postgres.h"
 
 namespace bookypedia {
 
 struct AppConfig {
     std::string db_url;
+    // Хранить данные в памяти процесса вместо PostgreSQL, например для замеров сценариев
+    bool in_memory_db = false;
+    // Сколько соединений с базой открыть для параллельно выполняемых сценариев
+    size_t db_pool_size = 1;
+    // Сколько авторов держать в кэше поверх базы
+    size_t author_cache_size = 10000;
+    // Создавать идентификаторы UUIDv7, упорядоченные по времени
+    bool time_ordered_ids = false;
 };
 
 class Application {
@@ -15,10 +27,17 @@ public:
     explicit Application(const AppConfig& config);
 
     void Run();
+    // Выполняет команды из script без участия пользователя и выводит время каждого этапа
+    void RunScript(std::istream& script);
 
 private:
-    postgres::Database db_;
-    app::UseCasesImpl use_cases_{db_.GetAuthors()};
+    app::UnitOfWorkFactory& OpenDatabase(const AppConfig& config);
+
+    std::optional<postgres::Database> postgres_db_;
+    std::optional<in_memory::Database> in_memory_db_;
+    app::CachingUnitOfWorkFactory unit_factory_;
+    app::DatabaseExecutor db_executor_;
+    app::UseCasesImpl use_cases_{unit_factory_, db_executor_};
 };
 
 }  // namespace bookypedia
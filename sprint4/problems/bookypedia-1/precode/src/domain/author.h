@@ -1,5 +1,8 @@
 #pragma once
+#include <functional>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "../util/tagged_uuid.h"
 
@@ -35,6 +38,34 @@ class AuthorRepository {
 public:
     virtual void Save(const Author& author) = 0;
 
+    /*
+    Сохраняет авторов, которых по одному возвращает next, пока он не вернёт std::nullopt.
+    В отличие от Save, авторы с уже занятыми именами пропускаются.
+    Возвращает количество добавленных авторов
+    */
+    virtual size_t Import(const std::function<std::optional<Author>()>& next) = 0;
+
+    /*
+    Возвращает не больше limit авторов в порядке имён, начиная с первого после after
+    либо с самого первого, если after не задан
+    */
+    virtual std::vector<Author> GetPageByName(const std::optional<std::string>& after, size_t limit) = 0;
+
+    virtual std::optional<Author> FindById(const AuthorId& id) = 0;
+    virtual std::optional<Author> FindByName(const std::string& name) = 0;
+
+    /*
+    Возвращает найденных авторов с указанными id в любом порядке. Загружает всех одним
+    запросом, поэтому подходит для списков, где у каждой строки свой автор
+    */
+    virtual std::vector<Author> FindByIds(const std::vector<AuthorId>& ids) = 0;
+
+    /*
+    Нечёткий поиск по части имени: возвращает не больше limit авторов, имя которых содержит
+    query или похоже на него, более похожие первыми
+    */
+    virtual std::vector<Author> SearchByName(const std::string& query, size_t limit) = 0;
+
 protected:
     ~AuthorRepository() = default;
 };
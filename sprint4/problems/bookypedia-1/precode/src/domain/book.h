@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "../util/tagged_uuid.h"
+#include "author.h"
+
+namespace domain {
+
+namespace detail {
+struct BookTag {};
+}  // namespace detail
+
+using BookId = util::TaggedUUID<detail::BookTag>;
+
+class Book {
+public:
+    Book(BookId id, AuthorId author_id, std::string title, int publication_year)
+        : id_(std::move(id))
+        , author_id_(std::move(author_id))
+        , title_(std::move(title))
+        , publication_year_(publication_year) {
+    }
+
+    const BookId& GetId() const noexcept {
+        return id_;
+    }
+
+    const AuthorId& GetAuthorId() const noexcept {
+        return author_id_;
+    }
+
+    const std::string& GetTitle() const noexcept {
+        return title_;
+    }
+
+    int GetPublicationYear() const noexcept {
+        return publication_year_;
+    }
+
+private:
+    BookId id_;
+    AuthorId author_id_;
+    std::string title_;
+    int publication_year_;
+};
+
+/*
+Книги хранят только id автора. Чтобы показать имена авторов списка книг, их загружают
+одним вызовом AuthorRepository::FindByIds на весь список, а не поиском по каждой книге
+*/
+class BookRepository {
+public:
+    virtual void Save(const Book& book) = 0;
+
+    // Все книги в порядке названий
+    virtual std::vector<Book> GetAll() = 0;
+
+    // Книги автора в порядке года издания
+    virtual std::vector<Book> GetByAuthor(const AuthorId& author_id) = 0;
+
+protected:
+    ~BookRepository() = default;
+};
+
+}  // namespace domain
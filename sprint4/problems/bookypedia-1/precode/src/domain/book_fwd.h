@@ -0,0 +1,9 @@
+#pragma once
+
+namespace domain {
+
+class Book;
+
+class BookRepository;
+
+}  // namespace domain
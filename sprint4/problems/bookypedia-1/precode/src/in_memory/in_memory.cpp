@@ -0,0 +1,248 @@
+#include "in_memory.h"
+
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+#include <unordered_set>
+
+namespace in_memory {
+
+using namespace std::literals;
+using detail::Tables;
+
+namespace {
+
+// Ограничение varchar(100) схемы
+constexpr size_t kMaxNameLength = 100;
+
+// Длина строки UTF-8 в символах, как char_length в PostgreSQL
+size_t CharLength(std::string_view str) {
+    return std::count_if(str.begin(), str.end(), [](char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    });
+}
+
+// Заменяет строку с id на value или удаляет её, если value пусто, вместе с записями в индексах
+void SetAuthorRow(Tables& tables, const domain::AuthorId& id, const std::optional<domain::Author>& value) {
+    if (const auto it = tables.authors.find(id); it != tables.authors.end()) {
+        tables.author_names.erase(it->second.GetName());
+        tables.authors.erase(it);
+    }
+    if (value) {
+        tables.author_names.emplace(value->GetName(), id);
+        tables.authors.emplace(id, *value);
+    }
+}
+
+void SetBookRow(Tables& tables, const domain::BookId& id, const std::optional<domain::Book>& value) {
+    if (const auto it = tables.books.find(id); it != tables.books.end()) {
+        auto [begin, end] = tables.books_by_author.equal_range(it->second.GetAuthorId());
+        tables.books_by_author.erase(std::find_if(begin, end, [&id](const auto& entry) {
+            return entry.second == id;
+        }));
+        tables.books.erase(it);
+    }
+    if (value) {
+        tables.books_by_author.emplace(value->GetAuthorId(), id);
+        tables.books.emplace(id, *value);
+    }
+}
+
+std::optional<domain::Author> FindAuthor(const Tables& tables, const domain::AuthorId& id) {
+    if (const auto it = tables.authors.find(id); it != tables.authors.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+bool IsNameTakenByOther(const Tables& tables, std::string_view name, const domain::AuthorId& id) {
+    const auto it = tables.author_names.find(name);
+    return it != tables.author_names.end() && it->second != id;
+}
+
+std::string ToLowerAscii(std::string_view str) {
+    std::string result{str};
+    for (char& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+}  // namespace
+
+void AuthorRepositoryImpl::Save(const domain::Author& author) {
+    unit_.PutAuthor(author);
+}
+
+size_t AuthorRepositoryImpl::Import(const std::function<std::optional<domain::Author>()>& next) {
+    Tables& tables = unit_.BeginWrite();
+    // Как INSERT ... ON CONFLICT DO NOTHING: занятые id и имена и неподходящие по длине имена пропускаются
+    size_t imported = 0;
+    while (auto author = next()) {
+        const size_t length = CharLength(author->GetName());
+        if (length == 0 || length > kMaxNameLength || tables.authors.count(author->GetId())
+            || tables.author_names.count(author->GetName())) {
+            continue;
+        }
+        unit_.undo_log_.push_back(UnitOfWorkImpl::AuthorUndo{author->GetId(), std::nullopt});
+        SetAuthorRow(tables, author->GetId(), author);
+        ++imported;
+    }
+    return imported;
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::GetPageByName(const std::optional<std::string>& after,
+                                                                size_t limit) {
+    return unit_.Read([&](const Tables& tables) {
+        std::vector<domain::Author> page;
+        auto it = after ? tables.author_names.upper_bound(*after) : tables.author_names.begin();
+        for (; it != tables.author_names.end() && page.size() < limit; ++it) {
+            page.push_back(tables.authors.at(it->second));
+        }
+        return page;
+    });
+}
+
+std::optional<domain::Author> AuthorRepositoryImpl::FindById(const domain::AuthorId& id) {
+    return unit_.Read([&](const Tables& tables) {
+        return FindAuthor(tables, id);
+    });
+}
+
+std::optional<domain::Author> AuthorRepositoryImpl::FindByName(const std::string& name) {
+    return unit_.Read([&](const Tables& tables) -> std::optional<domain::Author> {
+        if (const auto it = tables.author_names.find(name); it != tables.author_names.end()) {
+            return tables.authors.at(it->second);
+        }
+        return std::nullopt;
+    });
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::FindByIds(const std::vector<domain::AuthorId>& ids) {
+    return unit_.Read([&](const Tables& tables) {
+        // Как id = ANY(...): каждый автор возвращается один раз, сколько бы раз ни встретился его id
+        std::unordered_set<domain::AuthorId, Tables::AuthorHasher> seen;
+        std::vector<domain::Author> found;
+        for (const auto& id : ids) {
+            if (auto author = FindAuthor(tables, id); author && seen.insert(id).second) {
+                found.push_back(std::move(*author));
+            }
+        }
+        return found;
+    });
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::SearchByName(const std::string& query, size_t limit) {
+    const std::string pattern = ToLowerAscii(query);
+    return unit_.Read([&](const Tables& tables) {
+        std::vector<domain::Author> found;
+        for (auto it = tables.author_names.begin(); it != tables.author_names.end() && found.size() < limit;
+             ++it) {
+            if (ToLowerAscii(it->first).find(pattern) != std::string::npos) {
+                found.push_back(tables.authors.at(it->second));
+            }
+        }
+        return found;
+    });
+}
+
+void BookRepositoryImpl::Save(const domain::Book& book) {
+    unit_.PutBook(book);
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetAll() {
+    auto books = unit_.Read([](const Tables& tables) {
+        std::vector<domain::Book> books;
+        books.reserve(tables.books.size());
+        for (const auto& [id, book] : tables.books) {
+            books.push_back(book);
+        }
+        return books;
+    });
+    std::sort(books.begin(), books.end(), [](const domain::Book& lhs, const domain::Book& rhs) {
+        return std::make_tuple(std::cref(lhs.GetTitle()), lhs.GetPublicationYear())
+             < std::make_tuple(std::cref(rhs.GetTitle()), rhs.GetPublicationYear());
+    });
+    return books;
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetByAuthor(const domain::AuthorId& author_id) {
+    auto books = unit_.Read([&](const Tables& tables) {
+        std::vector<domain::Book> books;
+        auto [begin, end] = tables.books_by_author.equal_range(author_id);
+        for (auto it = begin; it != end; ++it) {
+            books.push_back(tables.books.at(it->second));
+        }
+        return books;
+    });
+    std::sort(books.begin(), books.end(), [](const domain::Book& lhs, const domain::Book& rhs) {
+        return std::make_tuple(lhs.GetPublicationYear(), std::cref(lhs.GetTitle()))
+             < std::make_tuple(rhs.GetPublicationYear(), std::cref(rhs.GetTitle()));
+    });
+    return books;
+}
+
+UnitOfWorkImpl::~UnitOfWorkImpl() {
+    // Прежние значения восстанавливаются в обратном порядке, так что повторные изменения
+    // одной строки тоже отменяются
+    Tables& tables = storage_.tables;
+    for (auto it = undo_log_.rbegin(); it != undo_log_.rend(); ++it) {
+        if (const auto* author = std::get_if<AuthorUndo>(&*it)) {
+            SetAuthorRow(tables, author->id, author->previous);
+        } else {
+            const auto& book = std::get<BookUndo>(*it);
+            SetBookRow(tables, book.id, book.previous);
+        }
+    }
+}
+
+void UnitOfWorkImpl::Commit() {
+    undo_log_.clear();
+    if (write_lock_.owns_lock()) {
+        write_lock_.unlock();
+    }
+}
+
+void UnitOfWorkImpl::PutAuthor(const domain::Author& author) {
+    Tables& tables = BeginWrite();
+    if (CharLength(author.GetName()) > kMaxNameLength) {
+        throw ConstraintViolation("Author name is too long: "s + author.GetName());
+    }
+    if (IsNameTakenByOther(tables, author.GetName(), author.GetId())) {
+        throw ConstraintViolation("Author name is already taken: "s + author.GetName());
+    }
+    undo_log_.push_back(AuthorUndo{author.GetId(), FindAuthor(tables, author.GetId())});
+    SetAuthorRow(tables, author.GetId(), author);
+}
+
+void UnitOfWorkImpl::PutBook(const domain::Book& book) {
+    Tables& tables = BeginWrite();
+    if (CharLength(book.GetTitle()) > kMaxNameLength) {
+        throw ConstraintViolation("Book title is too long: "s + book.GetTitle());
+    }
+    if (!tables.authors.count(book.GetAuthorId())) {
+        throw ConstraintViolation("Book author doesn't exist: "s + book.GetAuthorId().ToString());
+    }
+    std::optional<domain::Book> previous;
+    if (const auto it = tables.books.find(book.GetId()); it != tables.books.end()) {
+        previous = it->second;
+    }
+    undo_log_.push_back(BookUndo{book.GetId(), std::move(previous)});
+    SetBookRow(tables, book.GetId(), book);
+}
+
+size_t Database::FlushTo(app::UnitOfWorkFactory& target) {
+    auto unit = target.CreateUnitOfWork();
+    std::shared_lock lock{storage_.mutex};
+    const Tables& tables = storage_.tables;
+    for (const auto& [name, id] : tables.author_names) {
+        unit->Authors().Save(tables.authors.at(id));
+    }
+    for (const auto& [id, book] : tables.books) {
+        unit->Books().Save(book);
+    }
+    unit->Commit();
+    return tables.authors.size() + tables.books.size();
+}
+
+}  // namespace in_memory
@@ -0,0 +1,193 @@
+#pragma once
+#include <boost/uuid/uuid_hash.hpp>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "../app/unit_of_work.h"
+#include "../domain/author.h"
+#include "../domain/book.h"
+
+namespace in_memory {
+
+// Нарушено ограничение схемы: занятое имя, слишком длинная строка, книга без автора
+class ConstraintViolation : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+
+/*
+Таблицы базы с теми же ограничениями, что и схема PostgreSQL:
+id и имена авторов уникальны, имена и названия не длиннее 100 символов,
+книга ссылается на существующего автора
+*/
+struct Tables {
+    using AuthorHasher = util::TaggedHasher<domain::AuthorId>;
+    using BookHasher = util::TaggedHasher<domain::BookId>;
+
+    std::unordered_map<domain::AuthorId, domain::Author, AuthorHasher> authors;
+    // Уникальный индекс имён. Упорядочен, так как по нему же идёт постраничный обход
+    std::map<std::string, domain::AuthorId, std::less<>> author_names;
+    std::unordered_map<domain::BookId, domain::Book, BookHasher> books;
+    std::unordered_multimap<domain::AuthorId, domain::BookId, AuthorHasher> books_by_author;
+};
+
+struct Storage {
+    std::shared_mutex mutex;
+    Tables tables;
+};
+
+}  // namespace detail
+
+class UnitOfWorkImpl;
+
+class AuthorRepositoryImpl : public domain::AuthorRepository {
+public:
+    explicit AuthorRepositoryImpl(UnitOfWorkImpl& unit)
+        : unit_{unit} {
+    }
+
+    void Save(const domain::Author& author) override;
+    size_t Import(const std::function<std::optional<domain::Author>()>& next) override;
+    std::vector<domain::Author> GetPageByName(const std::optional<std::string>& after,
+                                              size_t limit) override;
+    std::optional<domain::Author> FindById(const domain::AuthorId& id) override;
+    std::optional<domain::Author> FindByName(const std::string& name) override;
+    std::vector<domain::Author> FindByIds(const std::vector<domain::AuthorId>& ids) override;
+    // Находит имена, содержащие query без учёта регистра латиницы, как ILIKE. Похожие
+    // с опечаткой имена, в отличие от триграммного поиска PostgreSQL, не находятся
+    std::vector<domain::Author> SearchByName(const std::string& query, size_t limit) override;
+
+private:
+    UnitOfWorkImpl& unit_;
+};
+
+class BookRepositoryImpl : public domain::BookRepository {
+public:
+    explicit BookRepositoryImpl(UnitOfWorkImpl& unit)
+        : unit_{unit} {
+    }
+
+    void Save(const domain::Book& book) override;
+    std::vector<domain::Book> GetAll() override;
+    std::vector<domain::Book> GetByAuthor(const domain::AuthorId& author_id) override;
+
+private:
+    UnitOfWorkImpl& unit_;
+};
+
+/*
+Единица работы над базой в памяти. Чтение идёт под разделяемой блокировкой базы,
+а первое изменение берёт исключительную блокировку и держит её до Commit или разрушения
+объекта, поэтому другие единицы работы не видят незафиксированных изменений.
+Изменения сразу вносятся в таблицы, а журнал прежних значений позволяет их отменить
+*/
+class UnitOfWorkImpl : public app::UnitOfWork {
+public:
+    explicit UnitOfWorkImpl(detail::Storage& storage)
+        : storage_{storage}
+        , write_lock_{storage.mutex, std::defer_lock} {
+    }
+
+    UnitOfWorkImpl(const UnitOfWorkImpl&) = delete;
+    UnitOfWorkImpl& operator=(const UnitOfWorkImpl&) = delete;
+
+    // Отменяет незафиксированные изменения
+    ~UnitOfWorkImpl() override;
+
+    domain::AuthorRepository& Authors() override {
+        return authors_;
+    }
+
+    domain::BookRepository& Books() override {
+        return books_;
+    }
+
+    void Commit() override;
+
+private:
+    friend class AuthorRepositoryImpl;
+    friend class BookRepositoryImpl;
+
+    // Прежнее состояние строки с id: std::nullopt, если её не было
+    struct AuthorUndo {
+        domain::AuthorId id;
+        std::optional<domain::Author> previous;
+    };
+    struct BookUndo {
+        domain::BookId id;
+        std::optional<domain::Book> previous;
+    };
+
+    // Выполняет fn(const Tables&). Единица работы, уже что-то изменившая, читает под своей блокировкой
+    template <typename Fn>
+    auto Read(Fn&& fn) {
+        if (write_lock_.owns_lock()) {
+            return fn(static_cast<const detail::Tables&>(storage_.tables));
+        }
+        std::shared_lock lock{storage_.mutex};
+        return fn(static_cast<const detail::Tables&>(storage_.tables));
+    }
+
+    detail::Tables& BeginWrite() {
+        if (!write_lock_.owns_lock()) {
+            write_lock_.lock();
+        }
+        return storage_.tables;
+    }
+
+    void PutAuthor(const domain::Author& author);
+    void PutBook(const domain::Book& book);
+
+    detail::Storage& storage_;
+    std::unique_lock<std::shared_mutex> write_lock_;
+    std::vector<std::variant<AuthorUndo, BookUndo>> undo_log_;
+    AuthorRepositoryImpl authors_{*this};
+    BookRepositoryImpl books_{*this};
+};
+
+class UnitOfWorkFactoryImpl : public app::UnitOfWorkFactory {
+public:
+    explicit UnitOfWorkFactoryImpl(detail::Storage& storage)
+        : storage_{storage} {
+    }
+
+    app::UnitOfWorkHolder CreateUnitOfWork() override {
+        return std::make_unique<UnitOfWorkImpl>(storage_);
+    }
+
+private:
+    detail::Storage& storage_;
+};
+
+/*
+База в памяти процесса. Заменяет PostgreSQL там, где важна логика сценариев, а не сеть:
+в тестах и замерах производительности. Пакетные задачи могут собрать данные здесь
+и затем одним вызовом FlushTo перенести их в настоящую базу
+*/
+class Database {
+public:
+    UnitOfWorkFactoryImpl& GetUnitOfWorkFactory() & {
+        return unit_factory_;
+    }
+
+    /*
+    Сохраняет все зафиксированные данные в одной единице работы target и фиксирует её.
+    Авторы сохраняются раньше ссылающихся на них книг. Возвращает количество авторов и книг
+    */
+    size_t FlushTo(app::UnitOfWorkFactory& target);
+
+private:
+    detail::Storage storage_;
+    UnitOfWorkFactoryImpl unit_factory_{storage_};
+};
+
+}  // namespace in_memory
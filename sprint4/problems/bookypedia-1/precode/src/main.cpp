@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
 
 #include "bookypedia.h"
 
@@ -9,23 +13,48 @@ using namespace std::literals;
 namespace {
 
 constexpr const char DB_URL_ENV_NAME[]{"BOOKYPEDIA_DB_URL"};
+constexpr const char DB_POOL_SIZE_ENV_NAME[]{"BOOKYPEDIA_DB_POOL_SIZE"};
+constexpr const char TIME_ORDERED_IDS_ENV_NAME[]{"BOOKYPEDIA_TIME_ORDERED_IDS"};
+// Значение BOOKYPEDIA_DB_URL, при котором данные хранятся в памяти процесса
+constexpr std::string_view IN_MEMORY_DB_URL{"memory:"};
 
 bookypedia::AppConfig GetConfigFromEnv() {
     bookypedia::AppConfig config;
     if (const auto* url = std::getenv(DB_URL_ENV_NAME)) {
         config.db_url = url;
+        config.in_memory_db = url == IN_MEMORY_DB_URL;
     } else {
         throw std::runtime_error(DB_URL_ENV_NAME + " environment variable not found"s);
     }
+    if (const auto* pool_size = std::getenv(DB_POOL_SIZE_ENV_NAME)) {
+        config.db_pool_size = std::stoul(pool_size);
+    } else {
+        config.db_pool_size = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (const auto* time_ordered = std::getenv(TIME_ORDERED_IDS_ENV_NAME)) {
+        config.time_ordered_ids = time_ordered == "1"sv;
+    }
     return config;
 }
 
 }  // namespace
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] const char* argv[]) {
+int main(int argc, const char* argv[]) {
+    if (argc != 1 && !(argc == 3 && argv[1] == "--script"sv)) {
+        std::cerr << "Usage: "sv << argv[0] << " [--script <command file>]"sv << std::endl;
+        return EXIT_FAILURE;
+    }
     try {
         bookypedia::Application app{GetConfigFromEnv()};
-        app.Run();
+        if (argc == 3) {
+            std::ifstream script{argv[2]};
+            if (!script) {
+                throw std::runtime_error("Failed to open "s + argv[2]);
+            }
+            app.RunScript(script);
+        } else {
+            app.Run();
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
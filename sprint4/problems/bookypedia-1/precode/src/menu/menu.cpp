@@ -1,10 +1,39 @@
 #include "menu.h"
 
+#include <algorithm>
 #include <iomanip>
-#include <sstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <utility>
+#include <vector>
 
 namespace menu {
 
+namespace {
+
+// Пробельные символы, которые пропускает operator>> в локали "C"
+constexpr std::string_view WHITESPACE = " \t\n\v\f\r";
+
+// Буфер потока, читающий прямо из чужой строки. В отличие от std::istringstream,
+// не копирует строку и не выделяет память на каждую команду
+class ViewStreamBuf : public std::streambuf {
+public:
+    void Reset(std::string_view text) {
+        char* begin = const_cast<char*>(text.data());
+        setg(begin, begin, begin + text.size());
+    }
+};
+
+}  // namespace
+
+std::pair<std::string_view, std::string_view> SplitCommand(std::string_view line) {
+    const size_t begin = std::min(line.find_first_not_of(WHITESPACE), line.size());
+    const size_t end = std::min(line.find_first_of(WHITESPACE, begin), line.size());
+    return {line.substr(begin, end - begin), line.substr(end)};
+}
+
 Menu::Menu(std::istream& input, std::ostream& output)
     : input_{input}
     , output_{output} {
@@ -21,25 +50,45 @@ void Menu::AddAction(std::string action_name, std::string args, std::string desc
 }
 
 void Menu::Run() {
+    // Строка, буфер и поток аргументов переиспользуются для всех команд
     std::string line;
+    ViewStreamBuf args_buf;
+    std::istream args{&args_buf};
     while (std::getline(input_, line)) {
-        std::istringstream cmd_stream{std::move(line)};
-        if (!ParseCommand(cmd_stream)) {
+        const auto [cmd, cmd_args] = SplitCommand(line);
+        args_buf.Reset(cmd_args);
+        args.clear();
+        if (!ExecuteCommand(cmd, args)) {
             break;
         }
     }
 }
 
+bool Menu::ExecuteLine(std::string_view line) {
+    const auto [cmd, cmd_args] = SplitCommand(line);
+    ViewStreamBuf args_buf;
+    args_buf.Reset(cmd_args);
+    std::istream args{&args_buf};
+    return ExecuteCommand(cmd, args);
+}
+
 void Menu::ShowInstructions() const {
     if (actions_.empty()) {
         return;
     }
+    // Команды хранятся в хеш-таблице, а показываются по алфавиту
+    std::vector<const decltype(actions_)::value_type*> sorted_actions;
+    sorted_actions.reserve(actions_.size());
     size_t actions_width = 0;
     size_t args_width = 0;
-    for (const auto& [action_name, info] : actions_) {
-        actions_width = std::max(actions_width, action_name.length());
-        args_width = std::max(args_width, info.args.length());
+    for (const auto& action : actions_) {
+        sorted_actions.push_back(&action);
+        actions_width = std::max(actions_width, action.first.length());
+        args_width = std::max(args_width, action.second.args.length());
     }
+    std::sort(sorted_actions.begin(), sorted_actions.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->first < rhs->first;
+    });
 
     const auto old_flags = output_.flags();
     const auto old_fill = output_.fill();
@@ -50,7 +99,8 @@ void Menu::ShowInstructions() const {
 
     try {
         output_ << std::left << std::setfill(' ');
-        for (const auto& [action_name, info] : actions_) {
+        for (const auto* action : sorted_actions) {
+            const auto& [action_name, info] = *action;
             output_ << std::setw(actions_width + 1) << action_name;
             output_ << std::setw(args_width + 1) << info.args;
             output_ << info.description << std::endl;
@@ -62,14 +112,13 @@ void Menu::ShowInstructions() const {
     restore_flags();
 }
 
-bool Menu::ParseCommand(std::istream& input) {
+bool Menu::ExecuteCommand(std::string_view cmd, std::istream& args) {
     using namespace std::literals;
 
     try {
-        std::string cmd;
-        if (input >> cmd) {
+        if (!cmd.empty()) {
             if (const auto it = actions_.find(cmd); it != actions_.cend()) {
-                if (!it->second.handler(input)) {
+                if (!it->second.handler(args)) {
                     return false;
                 }
             } else {
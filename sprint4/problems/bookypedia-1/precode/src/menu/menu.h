@@ -1,11 +1,16 @@
 #pragma once
 #include <functional>
 #include <iosfwd>
-#include <map>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 
 namespace menu {
 
+// Делит строку на имя команды и остаток с аргументами, как это делал бы input >> cmd
+std::pair<std::string_view, std::string_view> SplitCommand(std::string_view line);
+
 class Menu {
 public:
     using Handler = std::function<bool(std::istream&)>;
@@ -17,6 +22,9 @@ public:
 
     void Run();
 
+    // Выполняет одну команду. Возвращает false, если команда требует завершить работу
+    bool ExecuteLine(std::string_view line);
+
     void ShowInstructions() const;
 
 private:
@@ -26,11 +34,20 @@ private:
         std::string description;
     };
 
-    [[nodiscard]] bool ParseCommand(std::istream& input);
+    // Позволяет искать команду по std::string_view без создания std::string
+    struct NameHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const noexcept {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    [[nodiscard]] bool ExecuteCommand(std::string_view cmd, std::istream& args);
 
     std::istream& input_;
     std::ostream& output_;
-    std::map<std::string, ActionInfo> actions_;
+    std::unordered_map<std::string, ActionInfo, NameHash, std::equal_to<>> actions_;
 };
 
 }  // namespace menu
@@ -1,5 +1,7 @@
 #include "postgres.h"
 
+#include <cstddef>
+#include <pqxx/stream_to>
 #include <pqxx/zview.hxx>
 
 namespace postgres {
@@ -7,34 +9,290 @@ namespace postgres {
 using namespace std::literals;
 using pqxx::operator"" _zv;
 
-void AuthorRepositoryImpl::Save(const domain::Author& author) {
-    // Пока каждое обращение к репозиторию выполняется внутри отдельной транзакции
-    // В будущих уроках вы узнаете про паттерн Unit of Work, при помощи которого сможете несколько
-    // запросов выполнить в рамках одной транзакции.
-    // Вы также может самостоятельно почитать информацию про этот паттерн и применить его здесь.
-    pqxx::work work{connection_};
-    work.exec_params(
-        R"(
-INSERT INTO authors (id, name) VALUES ($1, $2)
-ON CONFLICT (id) DO UPDATE SET name=$2;
-)"_zv,
-        author.GetId().ToString(), author.GetName());
-    work.commit();
-}
+namespace {
+
+/*
+Все запросы репозиториев готовятся на каждом соединении один раз, при его открытии,
+и затем выполняются по имени, без повторного разбора и планирования сервером
+*/
+struct PreparedStatement {
+    pqxx::zview name;
+    pqxx::zview sql;
+};
 
-Database::Database(pqxx::connection connection)
-    : connection_{std::move(connection)} {
-    pqxx::work work{connection_};
+/*
+Массивы позволяют одним подготовленным запросом сохранить пакет любого размера.
+id пакета передаются подряд по 16 байт в одном двоичном параметре, а не текстовым массивом
+*/
+constexpr auto SAVE_AUTHORS = "save_authors"_zv;
+// Постраничный обход по уникальному индексу на name: каждая страница начинается поиском
+// в индексе, а не пропуском OFFSET строк
+constexpr auto AUTHORS_FIRST_PAGE = "authors_first_page"_zv;
+constexpr auto AUTHORS_PAGE_AFTER = "authors_page_after"_zv;
+constexpr auto AUTHOR_BY_ID = "author_by_id"_zv;
+constexpr auto AUTHOR_BY_NAME = "author_by_name"_zv;
+// Авторы списка книг одним запросом: id передаются так же, как в SAVE_AUTHORS
+constexpr auto AUTHORS_BY_IDS = "authors_by_ids"_zv;
+constexpr auto SAVE_BOOK = "save_book"_zv;
+constexpr auto ALL_BOOKS = "all_books"_zv;
+constexpr auto BOOKS_BY_AUTHOR = "books_by_author"_zv;
+/*
+Оба условия проверяются по триграммному GIN-индексу на name: ILIKE находит имена,
+содержащие запрос целиком, а <% — имена со словом, похожим на запрос, например с опечаткой
+*/
+constexpr auto SEARCH_AUTHORS = "search_authors"_zv;
+
+constexpr PreparedStatement PREPARED_STATEMENTS[] = {
+    {SAVE_AUTHORS, R"(
+INSERT INTO authors (id, name)
+SELECT encode(substring($1::bytea FROM (i::int - 1) * 16 + 1 FOR 16), 'hex')::uuid, name
+FROM unnest($2::varchar(100)[]) WITH ORDINALITY AS batch(name, i)
+ON CONFLICT (id) DO UPDATE SET name=EXCLUDED.name;
+)"_zv},
+    {AUTHORS_FIRST_PAGE, "SELECT id, name FROM authors ORDER BY name LIMIT $1;"_zv},
+    {AUTHORS_PAGE_AFTER, "SELECT id, name FROM authors WHERE name > $1 ORDER BY name LIMIT $2;"_zv},
+    {AUTHOR_BY_ID, "SELECT id, name FROM authors WHERE id = $1;"_zv},
+    {AUTHOR_BY_NAME, "SELECT id, name FROM authors WHERE name = $1;"_zv},
+    {AUTHORS_BY_IDS, R"(
+SELECT id, name FROM authors
+WHERE id = ANY(ARRAY(
+    SELECT encode(substring($1::bytea FROM (i - 1) * 16 + 1 FOR 16), 'hex')::uuid
+    FROM generate_series(1, length($1::bytea) / 16) AS i
+));
+)"_zv},
+    {SAVE_BOOK, R"(
+INSERT INTO books (id, author_id, title, publication_year) VALUES ($1, $2, $3, $4)
+ON CONFLICT (id) DO UPDATE
+SET author_id=EXCLUDED.author_id, title=EXCLUDED.title, publication_year=EXCLUDED.publication_year;
+)"_zv},
+    {ALL_BOOKS, "SELECT id, author_id, title, publication_year FROM books ORDER BY title, publication_year;"_zv},
+    {BOOKS_BY_AUTHOR, R"(
+SELECT id, author_id, title, publication_year FROM books
+WHERE author_id = $1
+ORDER BY publication_year, title;
+)"_zv},
+    {SEARCH_AUTHORS, R"(
+SELECT id, name FROM authors
+WHERE name ILIKE $2 OR $1 <% name
+ORDER BY word_similarity($1, name) DESC, name
+LIMIT $3;
+)"_zv},
+};
+
+void CreateSchema(pqxx::connection& connection) {
+    pqxx::work work{connection};
     work.exec(R"(
 CREATE TABLE IF NOT EXISTS authors (
     id UUID CONSTRAINT author_id_constraint PRIMARY KEY,
     name varchar(100) UNIQUE NOT NULL
 );
+CREATE EXTENSION IF NOT EXISTS pg_trgm;
+CREATE INDEX IF NOT EXISTS authors_name_trgm_idx ON authors USING GIN (name gin_trgm_ops);
+CREATE TABLE IF NOT EXISTS books (
+    id UUID CONSTRAINT book_id_constraint PRIMARY KEY,
+    author_id UUID NOT NULL REFERENCES authors (id),
+    title varchar(100) NOT NULL,
+    publication_year integer NOT NULL
+);
+CREATE INDEX IF NOT EXISTS books_author_id_idx ON books (author_id);
 )"_zv);
-    // ... создать другие таблицы
 
     // коммитим изменения
     work.commit();
 }
 
-}  // namespace postgres
\ No newline at end of file
+/*
+Открывает соединение для пула. Подготовить запрос можно только к существующим таблицам,
+поэтому сначала создаётся схема: для уже созданных таблиц CREATE TABLE IF NOT EXISTS
+почти ничего не стоит, а соединения открываются редко
+*/
+std::unique_ptr<pqxx::connection> Connect(const std::string& url) {
+    auto connection = std::make_unique<pqxx::connection>(url);
+    CreateSchema(*connection);
+    for (const auto& [name, sql] : PREPARED_STATEMENTS) {
+        connection->prepare(name, sql);
+    }
+    return connection;
+}
+
+// UUID передаются в базу 16 байтами в двоичном формате, без форматирования в текст
+template <typename Tag>
+std::basic_string_view<std::byte> ToBinary(const util::TaggedUUID<Tag>& id) {
+    return {reinterpret_cast<const std::byte*>((*id).data), (*id).size()};
+}
+
+domain::Author ToAuthor(const pqxx::row& row) {
+    // id разбирается прямо из буфера результата, без промежуточной строки
+    return {domain::AuthorId::FromString(row[0].view()), row[1].as<std::string>()};
+}
+
+std::optional<domain::Author> ToOptionalAuthor(const pqxx::result& rows) {
+    if (rows.empty()) {
+        return std::nullopt;
+    }
+    return ToAuthor(rows.front());
+}
+
+std::vector<domain::Author> ToAuthors(const pqxx::result& rows) {
+    std::vector<domain::Author> authors;
+    authors.reserve(rows.size());
+    for (const auto& row : rows) {
+        authors.push_back(ToAuthor(row));
+    }
+    return authors;
+}
+
+domain::Book ToBook(const pqxx::row& row) {
+    return {domain::BookId::FromString(row[0].view()), domain::AuthorId::FromString(row[1].view()),
+            row[2].as<std::string>(), row[3].as<int>()};
+}
+
+std::vector<domain::Book> ToBooks(const pqxx::result& rows) {
+    std::vector<domain::Book> books;
+    books.reserve(rows.size());
+    for (const auto& row : rows) {
+        books.push_back(ToBook(row));
+    }
+    return books;
+}
+
+// Шаблон LIKE для поиска подстроки: символы % и _ из запроса ищутся буквально
+std::string ToContainsPattern(std::string_view query) {
+    std::string pattern;
+    pattern.reserve(query.size() + 2);
+    pattern += '%';
+    for (const char c : query) {
+        if (c == '%' || c == '_' || c == '\\') {
+            pattern += '\\';
+        }
+        pattern += c;
+    }
+    pattern += '%';
+    return pattern;
+}
+
+}  // namespace
+
+void AuthorRepositoryImpl::Save(const domain::Author& author) {
+    auto [it, inserted] = pending_index_.try_emplace(author.GetId().ToString(), pending_.size());
+    if (!inserted) {
+        pending_[it->second] = author;
+        return;
+    }
+    pending_.push_back(author);
+    if (pending_.size() == kMaxBatchSize) {
+        Flush();
+    }
+}
+
+void AuthorRepositoryImpl::Flush() {
+    if (pending_.empty()) {
+        return;
+    }
+
+    std::basic_string<std::byte> ids;
+    std::vector<std::string> names;
+    ids.reserve(pending_.size() * sizeof(boost::uuids::uuid));
+    names.reserve(pending_.size());
+    for (const auto& author : pending_) {
+        ids += ToBinary(author.GetId());
+        names.push_back(author.GetName());
+    }
+    work_.exec_prepared(SAVE_AUTHORS, ids, names);
+
+    pending_.clear();
+    pending_index_.clear();
+}
+
+size_t AuthorRepositoryImpl::Import(const std::function<std::optional<domain::Author>()>& next) {
+    // Отложенные Save попадают в базу раньше, чтобы импорт учитывал их имена
+    Flush();
+
+    // Авторы копируются через COPY во временную таблицу без ограничений, а в authors
+    // переносятся одним запросом, который и разрешает конфликты
+    work_.exec(R"(
+CREATE TEMP TABLE IF NOT EXISTS authors_import (id UUID, name text) ON COMMIT DROP;
+TRUNCATE authors_import;
+)"_zv);
+    auto stream = pqxx::stream_to::table(work_, {"authors_import"sv}, {"id"sv, "name"sv});
+    while (auto author = next()) {
+        stream.write_values(author->GetId().ToString(), author->GetName());
+    }
+    stream.complete();
+
+    // Повторы имён внутри файла, уже занятые и слишком длинные имена пропускаются
+    const auto result = work_.exec(R"(
+INSERT INTO authors (id, name)
+SELECT DISTINCT ON (name) id, name FROM authors_import
+WHERE char_length(name) BETWEEN 1 AND 100
+ON CONFLICT DO NOTHING;
+)"_zv);
+    return static_cast<size_t>(result.affected_rows());
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::GetPageByName(const std::optional<std::string>& after,
+                                                                size_t limit) {
+    // Страница должна включать авторов, сохранённых в этой же единице работы
+    Flush();
+
+    return ToAuthors(after ? work_.exec_prepared(AUTHORS_PAGE_AFTER, *after, limit)
+                           : work_.exec_prepared(AUTHORS_FIRST_PAGE, limit));
+}
+
+std::optional<domain::Author> AuthorRepositoryImpl::FindById(const domain::AuthorId& id) {
+    Flush();
+    return ToOptionalAuthor(work_.exec_prepared(AUTHOR_BY_ID, ToBinary(id)));
+}
+
+std::optional<domain::Author> AuthorRepositoryImpl::FindByName(const std::string& name) {
+    Flush();
+    return ToOptionalAuthor(work_.exec_prepared(AUTHOR_BY_NAME, name));
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::FindByIds(const std::vector<domain::AuthorId>& ids) {
+    if (ids.empty()) {
+        return {};
+    }
+    Flush();
+
+    std::basic_string<std::byte> binary_ids;
+    binary_ids.reserve(ids.size() * sizeof(boost::uuids::uuid));
+    for (const auto& id : ids) {
+        binary_ids += ToBinary(id);
+    }
+    return ToAuthors(work_.exec_prepared(AUTHORS_BY_IDS, binary_ids));
+}
+
+std::vector<domain::Author> AuthorRepositoryImpl::SearchByName(const std::string& query, size_t limit) {
+    Flush();
+    return ToAuthors(work_.exec_prepared(SEARCH_AUTHORS, query, ToContainsPattern(query), limit));
+}
+
+void BookRepositoryImpl::Save(const domain::Book& book) {
+    authors_.Flush();
+    work_.exec_prepared(SAVE_BOOK, ToBinary(book.GetId()), ToBinary(book.GetAuthorId()), book.GetTitle(),
+                        book.GetPublicationYear());
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetAll() {
+    return ToBooks(work_.exec_prepared(ALL_BOOKS));
+}
+
+std::vector<domain::Book> BookRepositoryImpl::GetByAuthor(const domain::AuthorId& author_id) {
+    return ToBooks(work_.exec_prepared(BOOKS_BY_AUTHOR, ToBinary(author_id)));
+}
+
+void UnitOfWorkImpl::Commit() {
+    authors_.Flush();
+    work_.commit();
+}
+
+Database::Database(const DatabaseConfig& config)
+    : pool_{config.pool_size,
+            [url = config.url] {
+                return Connect(url);
+            },
+            config.wait_timeout} {
+}
+
+}  // namespace postgres
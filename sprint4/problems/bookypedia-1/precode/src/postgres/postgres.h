@@ -1,34 +1,127 @@
 #pragma once
+#include <chrono>
 #include <pqxx/connection>
 #include <pqxx/transaction>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "../app/unit_of_work.h"
 #include "../domain/author.h"
+#include "../domain/book.h"
+#include "connection_pool.h"
 
 namespace postgres {
 
+using ConnectionPool = BasicConnectionPool<pqxx::connection>;
+
+/*
+Репозиторий авторов внутри транзакции. Сохраняемые авторы копятся и отправляются в базу
+одним подготовленным запросом, когда их набирается kMaxBatchSize, или при вызове Flush
+*/
 class AuthorRepositoryImpl : public domain::AuthorRepository {
 public:
-    explicit AuthorRepositoryImpl(pqxx::connection& connection)
-        : connection_{connection} {
+    static constexpr size_t kMaxBatchSize = 1000;
+
+    explicit AuthorRepositoryImpl(pqxx::work& work)
+        : work_{work} {
     }
 
     void Save(const domain::Author& author) override;
+    size_t Import(const std::function<std::optional<domain::Author>()>& next) override;
+    std::vector<domain::Author> GetPageByName(const std::optional<std::string>& after,
+                                              size_t limit) override;
+    std::optional<domain::Author> FindById(const domain::AuthorId& id) override;
+    std::optional<domain::Author> FindByName(const std::string& name) override;
+    std::vector<domain::Author> FindByIds(const std::vector<domain::AuthorId>& ids) override;
+    std::vector<domain::Author> SearchByName(const std::string& query, size_t limit) override;
+
+    void Flush();
 
 private:
-    pqxx::connection& connection_;
+    pqxx::work& work_;
+    std::vector<domain::Author> pending_;
+    // Позиция автора в pending_ по его id: повторное сохранение заменяет запись в пакете,
+    // так как один INSERT ... ON CONFLICT не может изменить строку дважды
+    std::unordered_map<std::string, size_t> pending_index_;
 };
 
-class Database {
+/*
+Репозиторий книг внутри транзакции. Книга ссылается на автора внешним ключом, поэтому
+перед её сохранением в базу отправляются отложенные авторы этой же единицы работы
+*/
+class BookRepositoryImpl : public domain::BookRepository {
 public:
-    explicit Database(pqxx::connection connection);
+    BookRepositoryImpl(pqxx::work& work, AuthorRepositoryImpl& authors)
+        : work_{work}
+        , authors_{authors} {
+    }
+
+    void Save(const domain::Book& book) override;
+    std::vector<domain::Book> GetAll() override;
+    std::vector<domain::Book> GetByAuthor(const domain::AuthorId& author_id) override;
+
+private:
+    pqxx::work& work_;
+    AuthorRepositoryImpl& authors_;
+};
 
-    AuthorRepositoryImpl& GetAuthors() & {
+// Единица работы владеет взятым из пула соединением и транзакцией на нём
+class UnitOfWorkImpl : public app::UnitOfWork {
+public:
+    explicit UnitOfWorkImpl(ConnectionPool::ConnectionWrapper&& connection)
+        : connection_{std::move(connection)} {
+    }
+
+    domain::AuthorRepository& Authors() override {
         return authors_;
     }
 
+    domain::BookRepository& Books() override {
+        return books_;
+    }
+
+    void Commit() override;
+
+private:
+    ConnectionPool::ConnectionWrapper connection_;
+    pqxx::work work_{*connection_};
+    AuthorRepositoryImpl authors_{work_};
+    BookRepositoryImpl books_{work_, authors_};
+};
+
+class UnitOfWorkFactoryImpl : public app::UnitOfWorkFactory {
+public:
+    explicit UnitOfWorkFactoryImpl(ConnectionPool& pool)
+        : pool_{pool} {
+    }
+
+    app::UnitOfWorkHolder CreateUnitOfWork() override {
+        return std::make_unique<UnitOfWorkImpl>(pool_.GetConnection());
+    }
+
+private:
+    ConnectionPool& pool_;
+};
+
+struct DatabaseConfig {
+    std::string url;
+    size_t pool_size = 1;
+    // Сколько ждать свободного соединения, прежде чем сообщить об ошибке
+    std::chrono::milliseconds wait_timeout{5000};
+};
+
+class Database {
+public:
+    explicit Database(const DatabaseConfig& config);
+
+    UnitOfWorkFactoryImpl& GetUnitOfWorkFactory() & {
+        return unit_factory_;
+    }
+
 private:
-    pqxx::connection connection_;
-    AuthorRepositoryImpl authors_{connection_};
+    ConnectionPool pool_;
+    UnitOfWorkFactoryImpl unit_factory_{pool_};
 };
 
-}  // namespace postgres
\ No newline at end of file
+}  // namespace postgres
@@ -0,0 +1,102 @@
+#include "script_runner.h"
+
+#include <boost/algorithm/string/trim.hpp>
+#include <iostream>
+#include <string_view>
+
+#include "../app/use_cases.h"
+#include "../menu/menu.h"
+
+using namespace std::literals;
+
+namespace ui {
+
+namespace {
+
+constexpr std::string_view ADD_AUTHOR_COMMAND = "AddAuthor"sv;
+
+struct Command {
+    std::string_view line;
+    std::string_view name;
+    std::string_view args;
+};
+
+double ToMilliseconds(ScriptRunner::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}  // namespace
+
+ScriptRunner::ScriptRunner(menu::Menu& menu, app::UseCases& use_cases, std::ostream& output)
+    : menu_{menu}
+    , use_cases_{use_cases}
+    , output_{output} {
+}
+
+ScriptRunner::Stats ScriptRunner::Run(std::istream& script) {
+    Stats stats;
+
+    auto start = Clock::now();
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(script, line);) {
+        lines.push_back(std::move(line));
+    }
+    // Команды ссылаются на строки, поэтому разбираются, когда lines больше не растёт
+    std::vector<Command> commands;
+    commands.reserve(lines.size());
+    for (const auto& line : lines) {
+        const auto [name, args] = menu::SplitCommand(line);
+        commands.push_back({line, name, args});
+    }
+    stats.commands = commands.size();
+    stats.parse_time = Clock::now() - start;
+
+    std::vector<std::string> authors;
+    for (const auto& [line, name, args] : commands) {
+        if (name == ADD_AUTHOR_COMMAND) {
+            std::string author{args};
+            boost::algorithm::trim(author);
+            authors.push_back(std::move(author));
+            continue;
+        }
+
+        // Следующая команда может читать авторов, поэтому накопленные сохраняются до неё
+        AddAuthors(authors, stats);
+        start = Clock::now();
+        ++stats.other_commands;
+        const bool proceed = menu_.ExecuteLine(line);
+        stats.other_time += Clock::now() - start;
+        if (!proceed) {
+            return stats;
+        }
+    }
+    AddAuthors(authors, stats);
+    return stats;
+}
+
+void ScriptRunner::AddAuthors(std::vector<std::string>& names, Stats& stats) {
+    if (names.empty()) {
+        return;
+    }
+    const auto start = Clock::now();
+    try {
+        use_cases_.ImportAuthors(names);
+        stats.authors_added += names.size();
+    } catch (const std::exception&) {
+        output_ << "Failed to add "sv << names.size() << " authors"sv << std::endl;
+    }
+    ++stats.author_groups;
+    stats.authors_time += Clock::now() - start;
+    names.clear();
+}
+
+std::ostream& operator<<(std::ostream& out, const ScriptRunner::Stats& stats) {
+    out << "Parsed "sv << stats.commands << " commands in "sv << ToMilliseconds(stats.parse_time) << " ms\n"sv;
+    out << "Added "sv << stats.authors_added << " authors in "sv << stats.author_groups << " groups in "sv
+        << ToMilliseconds(stats.authors_time) << " ms\n"sv;
+    out << "Executed "sv << stats.other_commands << " other commands in "sv
+        << ToMilliseconds(stats.other_time) << " ms\n"sv;
+    return out;
+}
+
+}  // namespace ui
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace menu {
+class Menu;
+}
+
+namespace app {
+class UseCases;
+}
+
+namespace ui {
+
+/*
+Выполняет команды из файла без участия пользователя. Файл целиком разбирается заранее.
+Подряд идущие AddAuthor сохраняются вместе через UseCases::ImportAuthors, то есть крупными
+транзакциями, а не транзакцией на каждого автора. Остальные команды выполняются меню по одной,
+после того как сохранены все авторы, добавленные выше по файлу
+*/
+class ScriptRunner {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t commands = 0;
+        size_t authors_added = 0;
+        // Сколько раз подряд идущие AddAuthor сохранялись вместе
+        size_t author_groups = 0;
+        size_t other_commands = 0;
+        Clock::duration parse_time{};
+        Clock::duration authors_time{};
+        Clock::duration other_time{};
+    };
+
+    ScriptRunner(menu::Menu& menu, app::UseCases& use_cases, std::ostream& output);
+
+    Stats Run(std::istream& script);
+
+private:
+    void AddAuthors(std::vector<std::string>& names, Stats& stats);
+
+    menu::Menu& menu_;
+    app::UseCases& use_cases_;
+    std::ostream& output_;
+};
+
+std::ostream& operator<<(std::ostream& out, const ScriptRunner::Stats& stats);
+
+}  // namespace ui
@@ -1,10 +1,11 @@
 #include "view.h"
 
 #include <boost/algorithm/string/trim.hpp>
-#include <cassert>
+#include <fstream>
 #include <iostream>
 
 #include "../app/use_cases.h"
+#include "../domain/author.h"
 #include "../menu/menu.h"
 
 using namespace std::literals;
@@ -19,7 +20,11 @@ std::ostream& operator<<(std::ostream& out, const AuthorInfo& author) {
 }
 
 std::ostream& operator<<(std::ostream& out, const BookInfo& book) {
-    out << book.title << ", " << book.publication_year;
+    out << book.title;
+    if (!book.author_name.empty()) {
+        out << " by " << book.author_name;
+    }
+    out << ", " << book.publication_year;
     return out;
 }
 
@@ -43,9 +48,13 @@ View::View(menu::Menu& menu, app::UseCases& use_cases, std::istream& input, std:
         // либо
         // [this](auto& cmd_input) { return AddAuthor(cmd_input); }
     );
+    menu_.AddAction("ImportAuthors"s, "<csv file>"s, "Imports authors from a CSV file"s,
+                    std::bind(&View::ImportAuthors, this, ph::_1));
     menu_.AddAction("AddBook"s, "<pub year> <title>"s, "Adds book"s,
                     std::bind(&View::AddBook, this, ph::_1));
     menu_.AddAction("ShowAuthors"s, {}, "Show authors"s, std::bind(&View::ShowAuthors, this));
+    menu_.AddAction("FindAuthors"s, "<part of name>"s, "Finds authors by part of name"s,
+                    std::bind(&View::FindAuthors, this, ph::_1));
     menu_.AddAction("ShowBooks"s, {}, "Show books"s, std::bind(&View::ShowBooks, this));
     menu_.AddAction("ShowAuthorBooks"s, {}, "Show author books"s,
                     std::bind(&View::ShowAuthorBooks, this));
@@ -63,10 +72,27 @@ bool View::AddAuthor(std::istream& cmd_input) const {
     return true;
 }
 
+bool View::ImportAuthors(std::istream& cmd_input) const {
+    try {
+        std::string path;
+        std::getline(cmd_input, path);
+        boost::algorithm::trim(path);
+        std::ifstream file{path, std::ios::binary};
+        if (!file) {
+            output_ << "Failed to open "sv << path << std::endl;
+            return true;
+        }
+        output_ << "Imported "sv << use_cases_.ImportAuthorsFromCsv(file) << " authors"sv << std::endl;
+    } catch (const std::exception&) {
+        output_ << "Failed to import authors"sv << std::endl;
+    }
+    return true;
+}
+
 bool View::AddBook(std::istream& cmd_input) const {
     try {
         if (auto params = GetBookParams(cmd_input)) {
-            assert(!"TODO: implement book adding");
+            use_cases_.AddBook(params->author_id, params->title, params->publication_year);
         }
     } catch (const std::exception&) {
         output_ << "Failed to add book"sv << std::endl;
@@ -75,7 +101,28 @@ bool View::AddBook(std::istream& cmd_input) const {
 }
 
 bool View::ShowAuthors() const {
-    PrintVector(output_, GetAuthors());
+    // Авторы выводятся по мере загрузки, без сбора всего каталога в память
+    int i = 1;
+    use_cases_.ForEachAuthor([this, &i](const domain::Author& author) {
+        output_ << i++ << " " << author.GetName() << '\n';
+    });
+    output_.flush();
+    return true;
+}
+
+bool View::FindAuthors(std::istream& cmd_input) const {
+    try {
+        std::string query;
+        std::getline(cmd_input, query);
+        boost::algorithm::trim(query);
+        int i = 1;
+        for (const auto& author : use_cases_.FindAuthors(query)) {
+            output_ << i++ << " " << author.GetName() << '\n';
+        }
+        output_.flush();
+    } catch (const std::exception&) {
+        output_ << "Failed to find authors"sv << std::endl;
+    }
     return true;
 }
 
@@ -139,20 +186,27 @@ std::optional<std::string> View::SelectAuthor() const {
 }
 
 std::vector<detail::AuthorInfo> View::GetAuthors() const {
+    // Выбор автора по номеру требует всего списка сразу
     std::vector<detail::AuthorInfo> dst_autors;
-    assert(!"TODO: implement GetAuthors()");
+    use_cases_.ForEachAuthor([&dst_autors](const domain::Author& author) {
+        dst_autors.push_back({author.GetId().ToString(), author.GetName()});
+    });
     return dst_autors;
 }
 
 std::vector<detail::BookInfo> View::GetBooks() const {
     std::vector<detail::BookInfo> books;
-    assert(!"TODO: implement GetBooks()");
+    for (auto& book : use_cases_.GetBooks()) {
+        books.push_back({std::move(book.title), std::move(book.author_name), book.publication_year});
+    }
     return books;
 }
 
 std::vector<detail::BookInfo> View::GetAuthorBooks(const std::string& author_id) const {
     std::vector<detail::BookInfo> books;
-    assert(!"TODO: implement GetAuthorBooks()");
+    for (auto& book : use_cases_.GetAuthorBooks(author_id)) {
+        books.push_back({std::move(book.title), {}, book.publication_year});
+    }
     return books;
 }
 
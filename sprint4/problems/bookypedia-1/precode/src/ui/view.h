@@ -28,6 +28,8 @@ struct AuthorInfo {
 
 struct BookInfo {
     std::string title;
+    // Пустое, если все книги списка одного автора
+    std::string author_name;
     int publication_year;
 };
 
@@ -39,8 +41,10 @@ public:
 
 private:
     bool AddAuthor(std::istream& cmd_input) const;
+    bool ImportAuthors(std::istream& cmd_input) const;
     bool AddBook(std::istream& cmd_input) const;
     bool ShowAuthors() const;
+    bool FindAuthors(std::istream& cmd_input) const;
     bool ShowBooks() const;
     bool ShowAuthorBooks() const;
 
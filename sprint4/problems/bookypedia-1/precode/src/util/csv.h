@@ -0,0 +1,15 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace util {
+
+/*
+Читает из input одну запись CSV в fields. Поля в кавычках могут содержать запятые,
+переводы строк и удвоенные кавычки, записи разделяются \n или \r\n.
+Возвращает false, если записей больше нет
+*/
+bool ReadCsvRecord(std::istream& input, std::vector<std::string>& fields);
+
+}  // namespace util
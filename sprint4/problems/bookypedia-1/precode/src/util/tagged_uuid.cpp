@@ -1,24 +1,224 @@
 #include "tagged_uuid.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/string_generator.hpp>
-#include <boost/uuid/uuid_io.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/random.h>
+#endif
 
 namespace util {
 namespace detail {
 
+namespace {
+
+constexpr size_t UUID_TEXT_SIZE = 36;
+// После этих байтов в каноническом представлении стоит дефис
+constexpr bool IsDashAfter(size_t byte) {
+    return byte == 3 || byte == 5 || byte == 7 || byte == 9;
+}
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+// Значение шестнадцатеричной цифры либо -1
+constexpr std::array<int8_t, 256> HEX_VALUES = [] {
+    std::array<int8_t, 256> values{};
+    for (auto& value : values) {
+        value = -1;
+    }
+    for (int i = 0; i < 10; ++i) {
+        values['0' + i] = static_cast<int8_t>(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+        values['a' + i] = values['A' + i] = static_cast<int8_t>(10 + i);
+    }
+    return values;
+}();
+
+std::atomic<UUIDVersion> new_uuid_version{UUIDVersion::RANDOM};
+
+#if defined(__linux__)
+
+// Увеличивается в дочернем процессе после fork, чтобы он не выдал UUID из буфера родителя
+std::atomic<unsigned> fork_generation{0};
+
+void FillRandom(uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t read = getrandom(data, size, 0);
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "getrandom");
+        }
+        data += read;
+        size -= static_cast<size_t>(read);
+    }
+}
+
+#else
+
+void FillRandom(uint8_t* data, size_t size) {
+    boost::uuids::random_generator generator;
+    while (size > 0) {
+        const UUIDType random = generator();
+        const size_t n = std::min(size, random.size());
+        std::memcpy(data, random.data, n);
+        data += n;
+        size -= n;
+    }
+}
+
+#endif
+
+/*
+Случайные байты для UUID, полученные от системы блоками. boost::uuids::random_generator
+делает системный вызов на каждый UUID, а блок в 4 КБ обслуживает 256 UUID одним вызовом
+*/
+class EntropyBuffer {
+public:
+    static constexpr size_t BLOCK_SIZE = 4096;
+    static constexpr size_t MAX_RESERVE = 1 << 20;
+
+    void Read(uint8_t* out, size_t size) {
+        if (Available() < size) {
+            Refill(BLOCK_SIZE);
+        }
+        std::memcpy(out, data_.data() + pos_, size);
+        pos_ += size;
+    }
+
+    void Reserve(size_t size) {
+        size = std::min(size, MAX_RESERVE);
+        if (Available() < size) {
+            Refill(std::max(size, BLOCK_SIZE));
+        }
+    }
+
+private:
+    size_t Available() const {
+#if defined(__linux__)
+        if (generation_ != fork_generation.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+#endif
+        return data_.size() - pos_;
+    }
+
+    void Refill(size_t size) {
+#if defined(__linux__)
+        static const bool registered = [] {
+            pthread_atfork(nullptr, nullptr, [] {
+                fork_generation.fetch_add(1, std::memory_order_relaxed);
+            });
+            return true;
+        }();
+        (void)registered;
+        generation_ = fork_generation.load(std::memory_order_relaxed);
+#endif
+        data_.resize(size);
+        FillRandom(data_.data(), size);
+        pos_ = 0;
+    }
+
+    std::vector<uint8_t> data_;
+    size_t pos_ = 0;
+    unsigned generation_ = 0;
+};
+
+EntropyBuffer& Entropy() {
+    thread_local EntropyBuffer buffer;
+    return buffer;
+}
+
+// Проставляет версию и вариант RFC 9562 поверх случайных битов
+UUIDType& SetVersion(UUIDType& uuid, uint8_t version) {
+    uuid.data[6] = static_cast<uint8_t>(version << 4 | (uuid.data[6] & 0x0F));
+    uuid.data[8] = static_cast<uint8_t>(0x80 | (uuid.data[8] & 0x3F));
+    return uuid;
+}
+
+}  // namespace
+
 UUIDType NewUUID() {
-    return boost::uuids::random_generator()();
+    return new_uuid_version.load(std::memory_order_relaxed) == UUIDVersion::TIME_ORDERED
+             ? NewTimeOrderedUUID()
+             : NewRandomUUID();
+}
+
+UUIDType NewRandomUUID() {
+    UUIDType uuid;
+    Entropy().Read(uuid.data, uuid.size());
+    return SetVersion(uuid, 4);
+}
+
+UUIDType NewTimeOrderedUUID() {
+    using namespace std::chrono;
+
+    UUIDType uuid;
+    Entropy().Read(uuid.data, uuid.size());
+    const auto ms = static_cast<uint64_t>(
+        duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+    for (size_t i = 0; i < 6; ++i) {
+        uuid.data[i] = static_cast<uint8_t>(ms >> (40 - 8 * i));
+    }
+    return SetVersion(uuid, 7);
 }
 
 std::string UUIDToString(const UUIDType& uuid) {
-    return to_string(uuid);
+    std::string str(UUID_TEXT_SIZE, '-');
+    char* out = str.data();
+    for (size_t i = 0; i < uuid.size(); ++i) {
+        *out++ = HEX_DIGITS[uuid.data[i] >> 4];
+        *out++ = HEX_DIGITS[uuid.data[i] & 0xF];
+        out += IsDashAfter(i);
+    }
+    return str;
 }
 
 UUIDType UUIDFromString(std::string_view str) {
+    // Быстрый путь для канонической записи xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx,
+    // в которой UUID приходят из базы и из ToString
+    if (str.size() == UUID_TEXT_SIZE) {
+        UUIDType uuid;
+        const char* in = str.data();
+        bool valid = true;
+        for (size_t i = 0; i < uuid.size(); ++i) {
+            const int high = HEX_VALUES[static_cast<unsigned char>(in[0])];
+            const int low = HEX_VALUES[static_cast<unsigned char>(in[1])];
+            valid &= (high | low) >= 0;
+            uuid.data[i] = static_cast<uint8_t>((high & 0xF) << 4 | (low & 0xF));
+            in += 2;
+            if (IsDashAfter(i)) {
+                valid &= *in++ == '-';
+            }
+        }
+        if (valid) {
+            return uuid;
+        }
+    }
+    // Остальные формы записи (без дефисов, в фигурных скобках) и ошибки разбирает boost
     boost::uuids::string_generator gen;
     return gen(str.begin(), str.end());
 }
 
 }  // namespace detail
+
+void SetNewUUIDVersion(UUIDVersion version) noexcept {
+    detail::new_uuid_version.store(version, std::memory_order_relaxed);
+}
+
+void ReserveUUIDs(size_t count) {
+    detail::Entropy().Reserve(count * sizeof(detail::UUIDType));
+}
+
 }  // namespace util
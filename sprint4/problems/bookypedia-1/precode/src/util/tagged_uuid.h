@@ -2,16 +2,39 @@
 #include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <string>
+#include <string_view>
 
 #include "tagged.h"
 
 namespace util {
 
+enum class UUIDVersion {
+    // Случайные UUIDv4
+    RANDOM,
+    /*
+    UUIDv7: первые 48 бит содержат время создания в миллисекундах. Новые ключи попадают
+    в конец B-дерева индекса, а не в случайные его страницы
+    */
+    TIME_ORDERED,
+};
+
+// Выбирает, какие UUID создаёт TaggedUUID::New. По умолчанию UUIDVersion::RANDOM
+void SetNewUUIDVersion(UUIDVersion version) noexcept;
+
+/*
+Заранее запасает в текущем потоке случайные байты для count новых UUID, чтобы массовое
+создание идентификаторов не прерывалось обращениями к системному источнику энтропии
+*/
+void ReserveUUIDs(size_t count);
+
 namespace detail {
 
 using UUIDType = boost::uuids::uuid;
 
+// UUID версии, выбранной SetNewUUIDVersion
 UUIDType NewUUID();
+UUIDType NewRandomUUID();
+UUIDType NewTimeOrderedUUID();
 constexpr UUIDType ZeroUUID{{0}};
 
 std::string UUIDToString(const UUIDType& uuid);
@@ -33,7 +56,11 @@ public:
         return TaggedUUID{detail::NewUUID()};
     }
 
-    static TaggedUUID FromString(const std::string& uuid_as_text) {
+    static TaggedUUID NewTimeOrdered() {
+        return TaggedUUID{detail::NewTimeOrderedUUID()};
+    }
+
+    static TaggedUUID FromString(std::string_view uuid_as_text) {
         return TaggedUUID{detail::UUIDFromString(uuid_as_text)};
     }
 
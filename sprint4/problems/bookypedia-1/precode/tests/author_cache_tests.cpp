@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+
+#include "../src/app/author_cache.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Репозиторий в памяти, считающий обращения к «базе»
+struct CountingAuthorRepository : domain::AuthorRepository {
+    std::vector<domain::Author> authors;
+    int lookups = 0;
+
+    void Save(const domain::Author& author) override {
+        for (auto& stored : authors) {
+            if (stored.GetId() == author.GetId()) {
+                stored = author;
+                return;
+            }
+        }
+        authors.push_back(author);
+    }
+
+    size_t Import(const std::function<std::optional<domain::Author>()>& next) override {
+        size_t imported = 0;
+        for (; auto author = next(); ++imported) {
+            Save(*author);
+        }
+        return imported;
+    }
+
+    std::vector<domain::Author> GetPageByName(const std::optional<std::string>&, size_t) override {
+        return authors;
+    }
+
+    std::vector<domain::Author> SearchByName(const std::string&, size_t) override {
+        return authors;
+    }
+
+    std::optional<domain::Author> FindById(const domain::AuthorId& id) override {
+        ++lookups;
+        for (const auto& author : authors) {
+            if (author.GetId() == id) {
+                return author;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<domain::Author> FindByIds(const std::vector<domain::AuthorId>& ids) override {
+        ++lookups;
+        std::vector<domain::Author> found;
+        for (const auto& author : authors) {
+            if (std::find(ids.begin(), ids.end(), author.GetId()) != ids.end()) {
+                found.push_back(author);
+            }
+        }
+        return found;
+    }
+
+    std::optional<domain::Author> FindByName(const std::string& name) override {
+        ++lookups;
+        for (const auto& author : authors) {
+            if (author.GetName() == name) {
+                return author;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+struct Fixture {
+    CountingAuthorRepository db;
+    app::AuthorCache cache{2};
+    const domain::Author rowling{domain::AuthorId::New(), "Joanne Rowling"s};
+    const domain::Author tolkien{domain::AuthorId::New(), "J. R. R. Tolkien"s};
+    const domain::Author king{domain::AuthorId::New(), "Stephen King"s};
+
+    Fixture() {
+        db.authors = {rowling, tolkien, king};
+    }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(Fixture, "Repeated lookups are served from the cache") {
+    app::CachingAuthorRepository authors{db, cache};
+
+    CHECK(authors.FindById(rowling.GetId())->GetName() == rowling.GetName());
+    CHECK(authors.FindByName(rowling.GetName())->GetId() == rowling.GetId());
+    CHECK(authors.FindById(rowling.GetId()).has_value());
+    CHECK(db.lookups == 1);
+    CHECK(cache.GetStats().hits == 2);
+    CHECK(cache.GetStats().misses == 1);
+
+    // Отсутствующие авторы не кэшируются
+    CHECK_FALSE(authors.FindByName("Nobody"s).has_value());
+    CHECK_FALSE(authors.FindByName("Nobody"s).has_value());
+    CHECK(db.lookups == 3);
+}
+
+TEST_CASE_METHOD(Fixture, "Bulk lookup queries only authors missing from the cache") {
+    app::CachingAuthorRepository authors{db, cache};
+    authors.FindById(rowling.GetId());
+
+    const auto found = authors.FindByIds({rowling.GetId(), tolkien.GetId(), domain::AuthorId::New()});
+    CHECK(found.size() == 2);
+    CHECK(db.lookups == 2);
+
+    // Загруженный пакетом автор тоже попадает в кэш
+    CHECK(authors.FindById(tolkien.GetId()).has_value());
+    CHECK(db.lookups == 2);
+}
+
+TEST_CASE_METHOD(Fixture, "Least recently used authors are evicted") {
+    app::CachingAuthorRepository authors{db, cache};
+
+    authors.FindById(rowling.GetId());
+    authors.FindById(tolkien.GetId());
+    authors.FindById(rowling.GetId());
+    authors.FindById(king.GetId());
+    CHECK(db.lookups == 3);
+
+    // Tolkien вытеснен как давно не использованный, Rowling остался
+    authors.FindByName(rowling.GetName());
+    CHECK(db.lookups == 3);
+    authors.FindByName(tolkien.GetName());
+    CHECK(db.lookups == 4);
+}
+
+TEST_CASE_METHOD(Fixture, "Saving an author invalidates it") {
+    app::CachingAuthorRepository reader{db, cache};
+    reader.FindById(rowling.GetId());
+
+    app::CachingAuthorRepository writer{db, cache};
+    const domain::Author renamed{rowling.GetId(), "J. K. Rowling"s};
+    writer.Save(renamed);
+    // После Save единица работы читает из базы и видит своё изменение
+    CHECK(writer.FindById(rowling.GetId())->GetName() == renamed.GetName());
+    writer.OnCommit();
+
+    CHECK(reader.FindById(rowling.GetId())->GetName() == renamed.GetName());
+    CHECK_FALSE(reader.FindByName(rowling.GetName()).has_value());
+    CHECK(reader.FindByName(renamed.GetName())->GetId() == rowling.GetId());
+}
+
+TEST_CASE_METHOD(Fixture, "A read that races with an invalidation is not cached") {
+    const uint64_t version = cache.GetVersion();
+    cache.Invalidate(rowling);
+    cache.Put(rowling, version);
+    CHECK_FALSE(cache.FindById(rowling.GetId()).has_value());
+
+    cache.Put(rowling, cache.GetVersion());
+    CHECK(cache.FindById(rowling.GetId()).has_value());
+}
+
+TEST_CASE_METHOD(Fixture, "Caching unit of work factory shares one cache") {
+    struct Factory : app::UnitOfWorkFactory {
+        struct Unit : app::UnitOfWork {
+            CountingAuthorRepository& db;
+            explicit Unit(CountingAuthorRepository& db)
+                : db{db} {
+            }
+            domain::AuthorRepository& Authors() override {
+                return db;
+            }
+            domain::BookRepository& Books() override {
+                throw std::logic_error("not used");
+            }
+            void Commit() override {
+            }
+        };
+        CountingAuthorRepository& db;
+        explicit Factory(CountingAuthorRepository& db)
+            : db{db} {
+        }
+        app::UnitOfWorkHolder CreateUnitOfWork() override {
+            return std::make_unique<Unit>(db);
+        }
+    } inner{db};
+
+    app::CachingUnitOfWorkFactory factory{inner, 10};
+    factory.CreateUnitOfWork()->Authors().FindById(king.GetId());
+    factory.CreateUnitOfWork()->Authors().FindById(king.GetId());
+    CHECK(db.lookups == 1);
+    CHECK(factory.GetCacheStats().hits == 1);
+    CHECK(factory.GetCacheStats().misses == 1);
+}
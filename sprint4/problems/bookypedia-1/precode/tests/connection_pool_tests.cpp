@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "connection_pool.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct FakeConnection {
+    int id = 0;
+    bool open = true;
+
+    bool is_open() const noexcept {
+        return open;
+    }
+};
+
+using Pool = postgres::BasicConnectionPool<FakeConnection>;
+
+struct Fixture {
+    int created = 0;
+    bool fail = false;
+
+    Pool::ConnectionFactory MakeFactory() {
+        return [this] {
+            if (fail) {
+                throw std::runtime_error("connection refused");
+            }
+            return std::make_unique<FakeConnection>(FakeConnection{++created});
+        };
+    }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(Fixture, "Connections are opened upfront and reused") {
+    Pool pool{2, MakeFactory(), 100ms};
+    CHECK(created == 2);
+
+    int first_id = 0;
+    {
+        auto connection = pool.GetConnection();
+        first_id = connection->id;
+    }
+    auto connection = pool.GetConnection();
+    CHECK(connection->id == first_id);
+    CHECK(created == 2);
+}
+
+TEST_CASE_METHOD(Fixture, "GetConnection waits a bounded time for a free connection") {
+    Pool pool{1, MakeFactory(), 50ms};
+    auto connection = pool.GetConnection();
+    CHECK_THROWS_AS(pool.GetConnection(), postgres::ConnectionPoolTimeout);
+
+    std::thread returner{[connection = std::move(connection)]() mutable {
+        std::this_thread::sleep_for(10ms);
+        // Соединение возвращается в пул при разрушении connection в конце потока
+    }};
+    auto next = pool.GetConnection();
+    CHECK(next->id == 1);
+    returner.join();
+}
+
+TEST_CASE_METHOD(Fixture, "Closed connections are replaced") {
+    Pool pool{1, MakeFactory(), 100ms};
+    pool.GetConnection()->open = false;
+
+    auto connection = pool.GetConnection();
+    CHECK(connection->id == 2);
+    CHECK(connection->is_open());
+}
+
+TEST_CASE_METHOD(Fixture, "A failed reconnect does not shrink the pool") {
+    Pool pool{1, MakeFactory(), 100ms};
+    pool.GetConnection()->open = false;
+
+    fail = true;
+    CHECK_THROWS_AS(pool.GetConnection(), std::runtime_error);
+
+    fail = false;
+    CHECK(pool.GetConnection()->id == 2);
+}
+
+TEST_CASE_METHOD(Fixture, "Concurrent borrowers never share a connection") {
+    constexpr size_t kCapacity = 3;
+    Pool pool{kCapacity, MakeFactory(), 5s};
+    std::vector<std::atomic<int>> borrowers(kCapacity + 1);
+    std::atomic<bool> shared = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 1000; ++j) {
+                auto connection = pool.GetConnection();
+                if (++borrowers[connection->id] > 1) {
+                    shared = true;
+                }
+                --borrowers[connection->id];
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK_FALSE(shared);
+    CHECK(created == static_cast<int>(kCapacity));
+}
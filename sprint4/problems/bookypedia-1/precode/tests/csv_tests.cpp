@@ -0,0 +1,38 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+
+#include "../src/util/csv.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::vector<std::vector<std::string>> ReadAll(const std::string& text) {
+    std::istringstream input{text};
+    std::vector<std::vector<std::string>> records;
+    std::vector<std::string> fields;
+    while (util::ReadCsvRecord(input, fields)) {
+        records.push_back(fields);
+    }
+    return records;
+}
+
+}  // namespace
+
+TEST_CASE("CSV records are split into fields") {
+    using Records = std::vector<std::vector<std::string>>;
+
+    CHECK(ReadAll(""s).empty());
+    CHECK(ReadAll("a,b\nc\n"s) == Records{{"a"s, "b"s}, {"c"s}});
+    CHECK(ReadAll("a,b\r\nc"s) == Records{{"a"s, "b"s}, {"c"s}});
+    CHECK(ReadAll("\n,\n"s) == Records{{""s}, {""s, ""s}});
+}
+
+TEST_CASE("Quoted CSV fields keep separators and quotes") {
+    using Records = std::vector<std::vector<std::string>>;
+
+    CHECK(ReadAll("\"Tolkien, J. R. R.\",1892\n"s) == Records{{"Tolkien, J. R. R."s, "1892"s}});
+    CHECK(ReadAll("\"say \"\"hi\"\"\"\n"s) == Records{{"say \"hi\""s}});
+    CHECK(ReadAll("\"two\nlines\",x"s) == Records{{"two\nlines"s, "x"s}});
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <latch>
+#include <stdexcept>
+#include <thread>
+
+#include "../src/app/database_executor.h"
+#include "../src/domain/author.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct FakeUnitOfWork : app::UnitOfWork {
+    std::atomic<int>& commits;
+
+    explicit FakeUnitOfWork(std::atomic<int>& commits)
+        : commits{commits} {
+    }
+
+    domain::AuthorRepository& Authors() override {
+        throw std::logic_error("not used");
+    }
+
+    domain::BookRepository& Books() override {
+        throw std::logic_error("not used");
+    }
+
+    void Commit() override {
+        ++commits;
+    }
+};
+
+struct FakeUnitOfWorkFactory : app::UnitOfWorkFactory {
+    std::atomic<int> created = 0;
+    std::atomic<int> commits = 0;
+
+    app::UnitOfWorkHolder CreateUnitOfWork() override {
+        ++created;
+        return std::make_unique<FakeUnitOfWork>(commits);
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Database executor runs tasks in its own threads") {
+    FakeUnitOfWorkFactory unit_factory;
+    app::DatabaseExecutor executor{unit_factory, 2};
+
+    auto thread_id = executor.Execute([](app::UnitOfWork&) {
+        return std::this_thread::get_id();
+    });
+    CHECK(thread_id.get() != std::this_thread::get_id());
+    CHECK(unit_factory.created == 1);
+    CHECK(unit_factory.commits == 1);
+}
+
+TEST_CASE("Database executor does not commit a failed task") {
+    FakeUnitOfWorkFactory unit_factory;
+    app::DatabaseExecutor executor{unit_factory, 1};
+
+    auto result = executor.Execute([](app::UnitOfWork&) -> int {
+        throw std::runtime_error("query failed");
+    });
+    CHECK_THROWS_AS(result.get(), std::runtime_error);
+    CHECK(unit_factory.commits == 0);
+
+    // Ошибка одной задачи не мешает следующим
+    auto next = executor.Execute([](app::UnitOfWork&) {});
+    next.get();
+    CHECK(unit_factory.commits == 1);
+}
+
+TEST_CASE("Database executor overlaps independent tasks") {
+    FakeUnitOfWorkFactory unit_factory;
+    app::DatabaseExecutor executor{unit_factory, 2};
+
+    // Каждая задача ждёт другую, поэтому обе завершатся, только если выполняются одновременно
+    std::latch both_started{2};
+    const auto task = [&both_started](app::UnitOfWork&) {
+        both_started.arrive_and_wait();
+        return true;
+    };
+    auto first = executor.Execute(task);
+    auto second = executor.Execute(task);
+    CHECK(first.get());
+    CHECK(second.get());
+    CHECK(unit_factory.commits == 2);
+}
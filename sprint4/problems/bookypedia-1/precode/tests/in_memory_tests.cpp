@@ -0,0 +1,134 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/app/use_cases_impl.h"
+#include "../src/in_memory/in_memory.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Fixture {
+    in_memory::Database db;
+    app::UnitOfWorkFactory& unit_factory = db.GetUnitOfWorkFactory();
+    const domain::Author rowling{domain::AuthorId::New(), "Joanne Rowling"s};
+    const domain::Author tolkien{domain::AuthorId::New(), "J. R. R. Tolkien"s};
+
+    Fixture() {
+        auto unit = unit_factory.CreateUnitOfWork();
+        unit->Authors().Save(rowling);
+        unit->Authors().Save(tolkien);
+        unit->Commit();
+    }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(Fixture, "Authors are found by id, by name and page by page") {
+    auto unit = unit_factory.CreateUnitOfWork();
+    auto& authors = unit->Authors();
+
+    CHECK(authors.FindById(rowling.GetId())->GetName() == rowling.GetName());
+    CHECK(authors.FindByName(tolkien.GetName())->GetId() == tolkien.GetId());
+    CHECK_FALSE(authors.FindByName("Nobody"s).has_value());
+    CHECK(authors.FindByIds({rowling.GetId(), rowling.GetId(), domain::AuthorId::New()}).size() == 1);
+
+    const auto first = authors.GetPageByName(std::nullopt, 1);
+    REQUIRE(first.size() == 1);
+    CHECK(first.front().GetName() == tolkien.GetName());
+    const auto second = authors.GetPageByName(first.back().GetName(), 10);
+    REQUIRE(second.size() == 1);
+    CHECK(second.front().GetName() == rowling.GetName());
+
+    CHECK(authors.SearchByName("rowl"s, 10).size() == 1);
+}
+
+TEST_CASE_METHOD(Fixture, "Names are unique as in the SQL schema") {
+    auto unit = unit_factory.CreateUnitOfWork();
+    CHECK_THROWS_AS(unit->Authors().Save({domain::AuthorId::New(), rowling.GetName()}),
+                    in_memory::ConstraintViolation);
+    CHECK_THROWS_AS(unit->Authors().Save({domain::AuthorId::New(), std::string(101, 'a')}),
+                    in_memory::ConstraintViolation);
+    // Автор может сохранить своё же имя
+    unit->Authors().Save({rowling.GetId(), "J. K. Rowling"s});
+    unit->Commit();
+
+    auto reader = unit_factory.CreateUnitOfWork();
+    CHECK(reader->Authors().FindByName("J. K. Rowling"s)->GetId() == rowling.GetId());
+    CHECK_FALSE(reader->Authors().FindByName(rowling.GetName()).has_value());
+}
+
+TEST_CASE_METHOD(Fixture, "Import skips taken and invalid names") {
+    std::vector<domain::Author> batch{{domain::AuthorId::New(), rowling.GetName()},
+                                      {domain::AuthorId::New(), "Stephen King"s},
+                                      {domain::AuthorId::New(), "Stephen King"s},
+                                      {domain::AuthorId::New(), ""s}};
+    size_t next = 0;
+    auto unit = unit_factory.CreateUnitOfWork();
+    CHECK(unit->Authors().Import([&]() -> std::optional<domain::Author> {
+        return next < batch.size() ? std::optional{batch[next++]} : std::nullopt;
+    }) == 1);
+}
+
+TEST_CASE_METHOD(Fixture, "Uncommitted changes are rolled back") {
+    {
+        auto unit = unit_factory.CreateUnitOfWork();
+        unit->Authors().Save({rowling.GetId(), "Renamed"s});
+        unit->Authors().Save({domain::AuthorId::New(), "Stephen King"s});
+        unit->Books().Save({domain::BookId::New(), tolkien.GetId(), "The Hobbit"s, 1937});
+    }
+    auto unit = unit_factory.CreateUnitOfWork();
+    CHECK(unit->Authors().FindById(rowling.GetId())->GetName() == rowling.GetName());
+    CHECK_FALSE(unit->Authors().FindByName("Stephen King"s).has_value());
+    CHECK(unit->Books().GetAll().empty());
+}
+
+TEST_CASE_METHOD(Fixture, "Books reference existing authors") {
+    auto unit = unit_factory.CreateUnitOfWork();
+    CHECK_THROWS_AS(unit->Books().Save({domain::BookId::New(), domain::AuthorId::New(), "Orphan"s, 2000}),
+                    in_memory::ConstraintViolation);
+    unit->Books().Save({domain::BookId::New(), tolkien.GetId(), "The Silmarillion"s, 1977});
+    unit->Books().Save({domain::BookId::New(), tolkien.GetId(), "The Hobbit"s, 1937});
+    unit->Books().Save({domain::BookId::New(), rowling.GetId(), "Harry Potter"s, 1997});
+
+    const auto by_author = unit->Books().GetByAuthor(tolkien.GetId());
+    REQUIRE(by_author.size() == 2);
+    CHECK(by_author.front().GetTitle() == "The Hobbit"s);
+    CHECK(unit->Books().GetAll().front().GetTitle() == "Harry Potter"s);
+}
+
+TEST_CASE_METHOD(Fixture, "Use cases run against the in-memory database") {
+    app::DatabaseExecutor executor{unit_factory, 4};
+    app::UseCasesImpl use_cases{unit_factory, executor};
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 3 * app::UseCasesImpl::kImportBatchSize; ++i) {
+        names.push_back("Author " + std::to_string(i));
+    }
+    use_cases.ImportAuthors(names);
+    use_cases.AddBook(tolkien.GetId().ToString(), "The Hobbit"s, 1937);
+
+    size_t visited = 0;
+    use_cases.ForEachAuthor([&visited](const domain::Author&) {
+        ++visited;
+    });
+    CHECK(visited == names.size() + 2);
+    const auto books = use_cases.GetBooks();
+    REQUIRE(books.size() == 1);
+    CHECK(books.front().author_name == tolkien.GetName());
+}
+
+TEST_CASE_METHOD(Fixture, "Staged data is flushed to another database in one unit of work") {
+    auto unit = unit_factory.CreateUnitOfWork();
+    unit->Books().Save({domain::BookId::New(), tolkien.GetId(), "The Hobbit"s, 1937});
+    unit->Commit();
+
+    in_memory::Database target;
+    CHECK(db.FlushTo(target.GetUnitOfWorkFactory()) == 3);
+    auto reader = target.GetUnitOfWorkFactory().CreateUnitOfWork();
+    CHECK(reader->Authors().FindByName(rowling.GetName()).has_value());
+    CHECK(reader->Books().GetByAuthor(tolkien.GetId()).size() == 1);
+}
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/menu/menu.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Fixture {
+    std::istringstream input;
+    std::ostringstream output;
+    menu::Menu menu{input, output};
+    std::vector<std::string> calls;
+
+    Fixture() {
+        menu.AddAction("Add"s, "<a> <b>"s, "Adds numbers"s, [this](std::istream& args) {
+            int a = 0, b = 0;
+            args >> a >> b;
+            calls.push_back("Add " + std::to_string(a + b));
+            return true;
+        });
+        menu.AddAction("Echo"s, "<text>"s, "Prints the rest of the line"s, [this](std::istream& args) {
+            std::string text;
+            std::getline(args, text);
+            calls.push_back("Echo" + text);
+            return true;
+        });
+        menu.AddAction("Exit"s, {}, "Exit program"s, [](std::istream&) {
+            return false;
+        });
+    }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(Fixture, "Menu dispatches commands with their arguments") {
+    input.str("Add 2 3\n  \tEcho  hello world\r\nAdd 10 -4\n"s);
+    menu.Run();
+
+    CHECK(calls == std::vector{"Add 5"s, "Echo  hello world\r"s, "Add 6"s});
+    CHECK(output.str().empty());
+}
+
+TEST_CASE_METHOD(Fixture, "Menu reports unknown and empty commands") {
+    input.str("Ad 1 2\n\n   \nAddition\n"s);
+    menu.Run();
+
+    CHECK(calls.empty());
+    CHECK(output.str()
+          == "Command 'Ad' has not been found.\n"
+             "Invalid command\n"
+             "Invalid command\n"
+             "Command 'Addition' has not been found.\n"s);
+}
+
+TEST_CASE_METHOD(Fixture, "Menu stops when a handler returns false") {
+    input.str("Add 1 1\nExit\nAdd 2 2\n"s);
+    menu.Run();
+
+    CHECK(calls == std::vector{"Add 2"s});
+}
+
+TEST_CASE_METHOD(Fixture, "Menu shows instructions sorted by command name") {
+    menu.ShowInstructions();
+    CHECK(output.str()
+          == "Add  <a> <b> Adds numbers\n"
+             "Echo <text>  Prints the rest of the line\n"
+             "Exit         Exit program\n"s);
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/app/use_cases.h"
+#include "../src/domain/author.h"
+#include "../src/menu/menu.h"
+#include "../src/ui/script_runner.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Записывает вызовы сценариев в общий журнал вместе с командами меню
+struct FakeUseCases : app::UseCases {
+    std::vector<std::string>& log;
+    bool fail = false;
+
+    explicit FakeUseCases(std::vector<std::string>& log)
+        : log{log} {
+    }
+
+    void AddAuthor(const std::string& name) override {
+        log.push_back("AddAuthor " + name);
+    }
+
+    void ImportAuthors(const std::vector<std::string>& names) override {
+        if (fail) {
+            throw std::runtime_error("database is down");
+        }
+        std::string entry = "ImportAuthors";
+        for (const auto& name : names) {
+            entry += " [" + name + "]";
+        }
+        log.push_back(std::move(entry));
+    }
+
+    size_t ImportAuthorsFromCsv(std::istream&) override {
+        return 0;
+    }
+
+    void ForEachAuthor(const std::function<void(const domain::Author&)>&) override {
+    }
+
+    std::vector<domain::Author> FindAuthors(const std::string&) override {
+        return {};
+    }
+
+    void AddBook(const std::string&, const std::string& title, int) override {
+        log.push_back("AddBook " + title);
+    }
+
+    std::vector<app::BookInfo> GetBooks() override {
+        return {};
+    }
+
+    std::vector<app::BookInfo> GetAuthorBooks(const std::string&) override {
+        return {};
+    }
+};
+
+struct Fixture {
+    std::vector<std::string> log;
+    FakeUseCases use_cases{log};
+    std::istringstream no_input;
+    std::ostringstream output;
+    menu::Menu menu{no_input, output};
+    ui::ScriptRunner runner{menu, use_cases, output};
+
+    Fixture() {
+        menu.AddAction("ShowAuthors"s, {}, "Show authors"s, [this](std::istream&) {
+            log.push_back("ShowAuthors");
+            return true;
+        });
+        menu.AddAction("Exit"s, {}, "Exit program"s, [](std::istream&) {
+            return false;
+        });
+    }
+};
+
+}  // namespace
+
+TEST_CASE_METHOD(Fixture, "Consecutive authors are added together") {
+    std::istringstream script{
+        "AddAuthor Joanne Rowling\n"
+        "AddAuthor   J. R. R. Tolkien  \n"
+        "ShowAuthors\n"
+        "AddAuthor Stephen King\n"s};
+    const auto stats = runner.Run(script);
+
+    CHECK(log
+          == std::vector{"ImportAuthors [Joanne Rowling] [J. R. R. Tolkien]"s, "ShowAuthors"s,
+                         "ImportAuthors [Stephen King]"s});
+    CHECK(stats.commands == 4);
+    CHECK(stats.authors_added == 3);
+    CHECK(stats.author_groups == 2);
+    CHECK(stats.other_commands == 1);
+    CHECK(output.str().empty());
+}
+
+TEST_CASE_METHOD(Fixture, "Script stops at Exit after saving the authors above it") {
+    std::istringstream script{"AddAuthor Joanne Rowling\nExit\nAddAuthor Stephen King\n"s};
+    const auto stats = runner.Run(script);
+
+    CHECK(log == std::vector{"ImportAuthors [Joanne Rowling]"s});
+    CHECK(stats.authors_added == 1);
+}
+
+TEST_CASE_METHOD(Fixture, "A failed group is reported and the script goes on") {
+    use_cases.fail = true;
+    std::istringstream script{"AddAuthor Joanne Rowling\nAddAuthor Stephen King\nShowAuthors\n"s};
+    const auto stats = runner.Run(script);
+
+    CHECK(log == std::vector{"ShowAuthors"s});
+    CHECK(stats.authors_added == 0);
+    CHECK(output.str() == "Failed to add 2 authors\n"s);
+}
@@ -1,8 +1,20 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <boost/uuid/uuid_io.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "../src/util/tagged_uuid.h"
 
 using util::TaggedUUID;
+using namespace std::literals;
 
 namespace {
 struct TestTag {};
@@ -13,4 +25,80 @@ TEST_CASE("UUID-String conversion") {
     auto uuid = TestUUID::New();
     auto s = uuid.ToString();
     CHECK(TestUUID::FromString(s) == uuid);
-}
\ No newline at end of file
+}
+
+TEST_CASE("UUID text codec matches boost") {
+    for (int i = 0; i < 1000; ++i) {
+        const auto uuid = TestUUID::New();
+        CHECK(uuid.ToString() == to_string(*uuid));
+    }
+
+    const auto canonical = "0123abcd-4567-89ef-ABCD-0123456789ab"s;
+    const auto uuid = TestUUID::FromString(canonical);
+    CHECK(uuid.ToString() == "0123abcd-4567-89ef-abcd-0123456789ab"s);
+    // Другие формы записи по-прежнему принимаются
+    CHECK(TestUUID::FromString("{0123abcd-4567-89ef-abcd-0123456789ab}"s) == uuid);
+    CHECK(TestUUID::FromString("0123abcd456789efabcd0123456789ab"s) == uuid);
+}
+
+TEST_CASE("Malformed UUID text is rejected") {
+    CHECK_THROWS_AS(TestUUID::FromString("0123abcd-4567-89ef-abcd-0123456789ag"s), std::runtime_error);
+    CHECK_THROWS_AS(TestUUID::FromString("0123abcd+4567-89ef-abcd-0123456789ab"s), std::runtime_error);
+    CHECK_THROWS_AS(TestUUID::FromString("0123"s), std::runtime_error);
+}
+
+TEST_CASE("New UUIDs carry version and variant bits") {
+    const auto random = TestUUID::New();
+    CHECK((*random).version() == boost::uuids::uuid::version_random_number_based);
+    CHECK((*random).variant() == boost::uuids::uuid::variant_rfc_4122);
+
+    const auto time_ordered = TestUUID::NewTimeOrdered();
+    CHECK(((*time_ordered).data[6] >> 4) == 7);
+    CHECK((*time_ordered).variant() == boost::uuids::uuid::variant_rfc_4122);
+}
+
+TEST_CASE("New UUIDs are unique") {
+    util::ReserveUUIDs(1000);
+    std::unordered_set<std::string> seen;
+    for (int i = 0; i < 100000; ++i) {
+        REQUIRE(seen.insert(TestUUID::New().ToString()).second);
+        REQUIRE(seen.insert(TestUUID::NewTimeOrdered().ToString()).second);
+    }
+}
+
+TEST_CASE("Time-ordered UUIDs sort by creation time") {
+    const auto first = TestUUID::NewTimeOrdered();
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    const auto second = TestUUID::NewTimeOrdered();
+    CHECK(*first < *second);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    util::SetNewUUIDVersion(util::UUIDVersion::TIME_ORDERED);
+    const auto third = TestUUID::New();
+    util::SetNewUUIDVersion(util::UUIDVersion::RANDOM);
+    CHECK(((*third).data[6] >> 4) == 7);
+    CHECK(*second < *third);
+}
+
+#if defined(__linux__)
+TEST_CASE("A forked child does not repeat the parent's UUIDs") {
+    // Буфер случайных байтов заполнен до fork и копируется в дочерний процесс
+    util::ReserveUUIDs(10);
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    const pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        const auto uuid = TestUUID::New();
+        [[maybe_unused]] auto written = write(fds[1], (*uuid).data, (*uuid).size());
+        _exit(0);
+    }
+    const auto uuid = TestUUID::New();
+    TestUUID::ValueType child_uuid;
+    REQUIRE(read(fds[0], child_uuid.data, child_uuid.size()) == static_cast<ssize_t>(child_uuid.size()));
+    waitpid(pid, nullptr, 0);
+    close(fds[0]);
+    close(fds[1]);
+    CHECK(child_uuid != *uuid);
+}
+#endif
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <sstream>
 
 #include "../src/app/use_cases_impl.h"
 #include "../src/domain/author.h"
+#include "../src/domain/book.h"
 
 namespace {
 
@@ -11,17 +14,168 @@ struct MockAuthorRepository : domain::AuthorRepository {
     void Save(const domain::Author& author) override {
         saved_authors.emplace_back(author);
     }
+
+    size_t Import(const std::function<std::optional<domain::Author>()>& next) override {
+        size_t imported = 0;
+        while (auto author = next()) {
+            Save(*author);
+            ++imported;
+        }
+        return imported;
+    }
+
+    std::vector<domain::Author> GetPageByName(const std::optional<std::string>& after,
+                                              size_t limit) override {
+        if (committed) {
+            return committed->GetPageByName(after, limit);
+        }
+        ++pages_read;
+        std::vector<domain::Author> sorted = saved_authors;
+        std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.GetName() < rhs.GetName();
+        });
+        std::vector<domain::Author> page;
+        for (const auto& author : sorted) {
+            if ((!after || author.GetName() > *after) && page.size() < limit) {
+                page.push_back(author);
+            }
+        }
+        return page;
+    }
+
+    std::optional<domain::Author> FindById(const domain::AuthorId& id) override {
+        for (const auto& author : committed ? committed->saved_authors : saved_authors) {
+            if (author.GetId() == id) {
+                return author;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<domain::Author> FindByName(const std::string& name) override {
+        for (const auto& author : committed ? committed->saved_authors : saved_authors) {
+            if (author.GetName() == name) {
+                return author;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<domain::Author> FindByIds(const std::vector<domain::AuthorId>& ids) override {
+        ++(committed ? committed->bulk_lookups : bulk_lookups);
+        std::vector<domain::Author> found;
+        for (const auto& author : committed ? committed->saved_authors : saved_authors) {
+            if (std::find(ids.begin(), ids.end(), author.GetId()) != ids.end()) {
+                found.push_back(author);
+            }
+        }
+        return found;
+    }
+
+    std::vector<domain::Author> SearchByName(const std::string& query, size_t limit) override {
+        std::vector<domain::Author> found;
+        for (const auto& author : committed ? committed->saved_authors : saved_authors) {
+            if (author.GetName().find(query) != std::string::npos && found.size() < limit) {
+                found.push_back(author);
+            }
+        }
+        return found;
+    }
+
+    int pages_read = 0;
+    int bulk_lookups = 0;
+    // Если задан, чтение идёт из него: так единица работы видит уже зафиксированных авторов
+    MockAuthorRepository* committed = nullptr;
 };
 
-struct Fixture {
+struct MockBookRepository : domain::BookRepository {
+    std::vector<domain::Book> saved_books;
+
+    void Save(const domain::Book& book) override {
+        saved_books.emplace_back(book);
+    }
+
+    std::vector<domain::Book> GetAll() override {
+        std::vector<domain::Book> books = committed ? committed->saved_books : saved_books;
+        std::sort(books.begin(), books.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.GetTitle() < rhs.GetTitle();
+        });
+        return books;
+    }
+
+    std::vector<domain::Book> GetByAuthor(const domain::AuthorId& author_id) override {
+        std::vector<domain::Book> books;
+        for (const auto& book : GetAll()) {
+            if (book.GetAuthorId() == author_id) {
+                books.push_back(book);
+            }
+        }
+        return books;
+    }
+
+    MockBookRepository* committed = nullptr;
+};
+
+// Сохранённые авторы попадают в общий репозиторий только при Commit, как в транзакции
+struct MockUnitOfWork : app::UnitOfWork {
+    MockAuthorRepository& committed;
+    MockBookRepository& committed_books;
+    int& commits;
+    MockAuthorRepository pending;
+    MockBookRepository pending_books;
+
+    MockUnitOfWork(MockAuthorRepository& committed, MockBookRepository& committed_books, int& commits)
+        : committed{committed}
+        , committed_books{committed_books}
+        , commits{commits} {
+        pending.committed = &committed;
+        pending_books.committed = &committed_books;
+    }
+
+    domain::AuthorRepository& Authors() override {
+        return pending;
+    }
+
+    domain::BookRepository& Books() override {
+        return pending_books;
+    }
+
+    void Commit() override {
+        for (const auto& author : pending.saved_authors) {
+            committed.Save(author);
+        }
+        pending.saved_authors.clear();
+        for (const auto& book : pending_books.saved_books) {
+            committed_books.Save(book);
+        }
+        pending_books.saved_books.clear();
+        ++commits;
+    }
+};
+
+struct MockUnitOfWorkFactory : app::UnitOfWorkFactory {
     MockAuthorRepository authors;
+    MockBookRepository books;
+    int commits = 0;
+
+    app::UnitOfWorkHolder CreateUnitOfWork() override {
+        return std::make_unique<MockUnitOfWork>(authors, books, commits);
+    }
+};
+
+struct Fixture {
+    MockUnitOfWorkFactory unit_factory;
+    MockAuthorRepository& authors = unit_factory.authors;
+    MockBookRepository& books = unit_factory.books;
+    // Один поток: пакеты импорта фиксируются по порядку, а моки не нужно защищать мьютексом
+    app::DatabaseExecutor executor{unit_factory, 1};
 };
 
 }  // namespace
 
 SCENARIO_METHOD(Fixture, "Book Adding") {
     GIVEN("Use cases") {
-        app::UseCasesImpl use_cases{authors};
+        app::UseCasesImpl use_cases{unit_factory, executor};
 
         WHEN("Adding an author") {
             const auto author_name = "Joanne Rowling";
@@ -31,7 +185,103 @@ SCENARIO_METHOD(Fixture, "Book Adding") {
                 REQUIRE(authors.saved_authors.size() == 1);
                 CHECK(authors.saved_authors.at(0).GetName() == author_name);
                 CHECK(authors.saved_authors.at(0).GetId() != domain::AuthorId{});
+                CHECK(unit_factory.commits == 1);
+            }
+        }
+
+        WHEN("Importing many authors") {
+            const size_t count = 2 * app::UseCasesImpl::kImportBatchSize + 1;
+            std::vector<std::string> names;
+            for (size_t i = 0; i < count; ++i) {
+                names.push_back("Author " + std::to_string(i));
+            }
+            use_cases.ImportAuthors(names);
+
+            THEN("all of them are saved with one commit per batch") {
+                REQUIRE(authors.saved_authors.size() == count);
+                CHECK(authors.saved_authors.back().GetName() == names.back());
+                CHECK(unit_factory.commits == 3);
+            }
+        }
+
+        WHEN("Importing authors from a CSV file") {
+            std::istringstream csv{"Joanne Rowling\n\"Tolkien, J. R. R.\",1892\r\n\n  \nStephen King"};
+            const size_t imported = use_cases.ImportAuthorsFromCsv(csv);
+
+            THEN("names from the first column are saved in one commit, blank ones are skipped") {
+                CHECK(imported == 3);
+                REQUIRE(authors.saved_authors.size() == 3);
+                CHECK(authors.saved_authors.at(0).GetName() == "Joanne Rowling");
+                CHECK(authors.saved_authors.at(1).GetName() == "Tolkien, J. R. R.");
+                CHECK(authors.saved_authors.at(2).GetName() == "Stephen King");
+                CHECK(unit_factory.commits == 1);
+            }
+        }
+
+        WHEN("Listing authors") {
+            const size_t count = app::UseCasesImpl::kListPageSize + 10;
+            for (size_t i = 0; i < count; ++i) {
+                authors.Save({domain::AuthorId::New(), "Author " + std::to_string(count - i)});
+            }
+            std::vector<std::string> names;
+            use_cases.ForEachAuthor([&names](const domain::Author& author) {
+                names.push_back(author.GetName());
+            });
+
+            THEN("all authors are visited once, in name order, page by page") {
+                REQUIRE(names.size() == count);
+                CHECK(std::is_sorted(names.begin(), names.end()));
+                CHECK(std::adjacent_find(names.begin(), names.end()) == names.end());
+                CHECK(authors.pages_read == 2);
+            }
+        }
+
+        WHEN("Searching authors by part of the name") {
+            for (size_t i = 0; i < 2 * app::UseCasesImpl::kSearchLimit; ++i) {
+                authors.Save({domain::AuthorId::New(), "Author " + std::to_string(i)});
+            }
+            authors.Save({domain::AuthorId::New(), "Joanne Rowling"});
+
+            THEN("matching authors are returned, at most kSearchLimit of them") {
+                const auto found = use_cases.FindAuthors("Rowl");
+                REQUIRE(found.size() == 1);
+                CHECK(found.front().GetName() == "Joanne Rowling");
+                CHECK(use_cases.FindAuthors("Author").size() == app::UseCasesImpl::kSearchLimit);
+            }
+        }
+
+        WHEN("Adding a book") {
+            const domain::Author rowling{domain::AuthorId::New(), "Joanne Rowling"};
+            authors.Save(rowling);
+            use_cases.AddBook(rowling.GetId().ToString(), "Harry Potter", 1997);
+
+            THEN("the book of the selected author is saved in one commit") {
+                REQUIRE(books.saved_books.size() == 1);
+                CHECK(books.saved_books.at(0).GetTitle() == "Harry Potter");
+                CHECK(books.saved_books.at(0).GetAuthorId() == rowling.GetId());
+                CHECK(books.saved_books.at(0).GetPublicationYear() == 1997);
+                CHECK(unit_factory.commits == 1);
+            }
+        }
+
+        WHEN("Listing books of many authors") {
+            const size_t count = 50;
+            for (size_t i = 0; i < count; ++i) {
+                const domain::Author author{domain::AuthorId::New(), "Author " + std::to_string(i)};
+                authors.Save(author);
+                books.Save({domain::BookId::New(), author.GetId(), "Book " + std::to_string(i), 2000});
+                books.Save({domain::BookId::New(), author.GetId(), "Sequel " + std::to_string(i), 2001});
+            }
+            const auto listed = use_cases.GetBooks();
+
+            THEN("every book has its author name, and all authors are loaded at once") {
+                REQUIRE(listed.size() == 2 * count);
+                CHECK(listed.front().title == "Book 0");
+                CHECK(listed.front().author_name == "Author 0");
+                CHECK(listed.back().title == "Sequel 9");
+                CHECK(listed.back().author_name == "Author 9");
+                CHECK(authors.bulk_lookups == 1);
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,75 @@
+#include "background_saver.h"
+
+#include <utility>
+
+namespace serialization {
+
+BackgroundSaver::BackgroundSaver(StateLog& log)
+    : log_{log}
+    , worker_{[this](std::stop_token stop) {
+        Run(stop);
+    }} {
+}
+
+BackgroundSaver::~BackgroundSaver() {
+    {
+        std::unique_lock lk{mutex_};
+        cv_.wait(lk, [this] {
+            return !writing_;
+        });
+    }
+    worker_.request_stop();
+}
+
+bool BackgroundSaver::Save(model::DogRegistry& dogs) {
+    std::lock_guard lk{mutex_};
+    RethrowError();
+    if (writing_) {
+        return false;
+    }
+    // Захват выполняется в потоке вызывающего, пока рабочий поток ждёт заданий,
+    // поэтому Capture не пересекается с Write
+    pending_.emplace(log_.Capture(dogs));
+    writing_ = true;
+    cv_.notify_all();
+    return true;
+}
+
+void BackgroundSaver::Wait() {
+    std::unique_lock lk{mutex_};
+    cv_.wait(lk, [this] {
+        return !writing_;
+    });
+    RethrowError();
+}
+
+void BackgroundSaver::RethrowError() {
+    if (auto error = std::exchange(error_, nullptr)) {
+        std::rethrow_exception(error);
+    }
+}
+
+void BackgroundSaver::Run(std::stop_token stop) {
+    std::unique_lock lk{mutex_};
+    while (cv_.wait(lk, stop, [this] {
+        return pending_.has_value();
+    })) {
+        auto changes = std::move(*pending_);
+        pending_.reset();
+        lk.unlock();
+        std::exception_ptr error;
+        try {
+            log_.Write(changes);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        // Копия собак освобождается вне мьютекса
+        changes = {};
+        lk.lock();
+        error_ = error;
+        writing_ = false;
+        cv_.notify_all();
+    }
+}
+
+}  // namespace serialization
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "state_log.h"
+
+namespace serialization {
+
+/*
+ * Записывает состояние собак в StateLog в отдельном потоке.
+ * Save лишь захватывает изменения (копирует столбцы реестра или изменившихся собак),
+ * а сериализация, запись и fsync выполняются в фоне, поэтому тик на время записи
+ * на диск не останавливается.
+ * Одновременно выполняется не более одной записи. Если предыдущая запись не закончилась,
+ * Save ничего не захватывает: изменения остаются отмеченными в реестре
+ * и попадут в следующее сохранение.
+ */
+class BackgroundSaver {
+public:
+    // Журнал должен существовать дольше BackgroundSaver
+    explicit BackgroundSaver(StateLog& log);
+
+    BackgroundSaver(const BackgroundSaver&) = delete;
+    BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+
+    // Дожидается окончания записи
+    ~BackgroundSaver();
+
+    // Захватывает изменения dogs и начинает их запись. Возвращает false, если предыдущая
+    // запись ещё выполняется. Если предыдущая запись завершилась ошибкой,
+    // выбрасывает её исключение
+    bool Save(model::DogRegistry& dogs);
+
+    // Дожидается окончания записи и выбрасывает исключение, если запись не удалась
+    void Wait();
+
+private:
+    void Run(std::stop_token stop);
+    void RethrowError();
+
+    StateLog& log_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::optional<StateLog::Changes> pending_;
+    bool writing_ = false;
+    std::exception_ptr error_;
+
+    // Поток объявлен последним, чтобы остановиться раньше разрушения остальных полей
+    std::jthread worker_;
+};
+
+}  // namespace serialization
@@ -0,0 +1,359 @@
+#include "dog_archive.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace serialization {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr std::array<char, 4> MAGIC{'D', 'O', 'G', 'S'};
+
+template <typename T>
+T ToLittleEndian(T value) noexcept {
+    if constexpr (std::endian::native == std::endian::little || sizeof(T) == 1) {
+        return value;
+    } else {
+        auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(value);
+        std::reverse(bytes.begin(), bytes.end());
+        return std::bit_cast<T>(bytes);
+    }
+}
+
+class Writer {
+public:
+    explicit Writer(std::string& out) noexcept
+        : out_{out} {
+    }
+
+    template <typename T>
+    void Write(T value) {
+        static_assert(std::is_arithmetic_v<T>);
+        value = ToLittleEndian(value);
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Записывает столбец. На little-endian платформе - одним копированием
+    template <typename T>
+    void WriteColumn(const std::vector<T>& column) {
+        if constexpr (std::endian::native == std::endian::little) {
+            out_.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+        } else {
+            for (const T value : column) {
+                Write(value);
+            }
+        }
+    }
+
+    // Координаты записываются как f64 независимо от geom::Coord
+    template <typename Coord>
+    void WriteCoords(const std::vector<Coord>& column) {
+        if constexpr (std::is_same_v<Coord, double>) {
+            WriteColumn(column);
+        } else {
+            for (const double value : column) {
+                Write(value);
+            }
+        }
+    }
+
+    void WriteBytes(std::string_view bytes) {
+        out_.append(bytes);
+    }
+
+private:
+    std::string& out_;
+};
+
+// Читатель не выбрасывает исключений: при нехватке данных он запоминает ошибку
+// и дальше возвращает нули и пустые столбцы, а вызывающий проверяет Failed
+// после чтения группы полей
+class Reader {
+public:
+    explicit Reader(std::string_view data) noexcept
+        : data_{data} {
+    }
+
+    template <typename T>
+    T Read() noexcept {
+        const auto bytes = Take(sizeof(T));
+        if (bytes.empty()) {
+            return T{};
+        }
+        T value;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return ToLittleEndian(value);
+    }
+
+    template <typename T>
+    std::vector<T> ReadColumn(size_t count) {
+        if (failed_ || count > data_.size() / sizeof(T)) {
+            failed_ = true;
+            return {};
+        }
+        std::vector<T> column(count);
+        if (count == 0) {
+            return column;
+        }
+        std::memcpy(column.data(), Take(count * sizeof(T)).data(), count * sizeof(T));
+        if constexpr (std::endian::native != std::endian::little) {
+            for (auto& value : column) {
+                value = ToLittleEndian(value);
+            }
+        }
+        return column;
+    }
+
+    template <typename Coord = geom::Coord>
+    std::vector<Coord> ReadCoords(size_t count) {
+        auto column = ReadColumn<double>(count);
+        if constexpr (std::is_same_v<Coord, double>) {
+            return column;
+        } else {
+            return {column.begin(), column.end()};
+        }
+    }
+
+    std::string_view Take(size_t size) noexcept {
+        if (failed_ || size > data_.size()) {
+            failed_ = true;
+            return {};
+        }
+        const auto bytes = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return bytes;
+    }
+
+    std::string_view GetRest() const noexcept {
+        return data_;
+    }
+
+    bool Failed() const noexcept {
+        return failed_;
+    }
+
+    [[noreturn]] static void Fail() {
+        throw std::runtime_error("Dog archive is corrupted"s);
+    }
+
+private:
+    std::string_view data_;
+    bool failed_ = false;
+};
+
+// Проверяет, что смещения концов не убывают и не выходят за size
+bool CheckEnds(const std::vector<std::uint32_t>& ends, size_t size) noexcept {
+    std::uint32_t prev = 0;
+    bool valid = true;
+    for (const auto end : ends) {
+        valid &= end >= prev && end <= size;
+        prev = end;
+    }
+    return valid;
+}
+
+}  // namespace
+
+void WriteDogs(const model::DogRegistry& dogs, std::string& out) {
+    const auto& motion = dogs.GetMotion();
+    const size_t count = dogs.Size();
+
+    Writer writer{out};
+    writer.WriteBytes({MAGIC.data(), MAGIC.size()});
+    writer.Write(DOG_ARCHIVE_VERSION);
+    writer.Write(std::uint16_t{0});
+    writer.Write(static_cast<std::uint32_t>(count));
+
+    for (size_t i = 0; i < count; ++i) {
+        writer.Write(*dogs.GetId(i));
+    }
+    writer.WriteCoords(motion.x);
+    writer.WriteCoords(motion.y);
+    writer.WriteCoords(motion.speed_x);
+    writer.WriteCoords(motion.speed_y);
+    for (const auto direction : motion.direction) {
+        writer.Write(static_cast<std::uint8_t>(direction));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writer.Write(static_cast<std::uint32_t>(dogs.GetProfile(i).bag_capacity));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writer.Write(static_cast<std::uint32_t>(dogs.GetProfile(i).score));
+    }
+
+    std::uint32_t names_end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        names_end += static_cast<std::uint32_t>(dogs.GetProfile(i).name.size());
+        writer.Write(names_end);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        writer.WriteBytes(dogs.GetProfile(i).name);
+    }
+
+    std::uint32_t bags_end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        bags_end += static_cast<std::uint32_t>(dogs.GetProfile(i).bag.size());
+        writer.Write(bags_end);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        for (const auto& item : dogs.GetProfile(i).bag) {
+            writer.Write(*item.id);
+            writer.Write(static_cast<std::uint32_t>(item.type));
+        }
+    }
+}
+
+std::optional<model::DogRegistry> TryReadDogs(std::string_view& data) {
+    Reader reader{data};
+    if (reader.Take(MAGIC.size()) != std::string_view{MAGIC.data(), MAGIC.size()}) {
+        return std::nullopt;
+    }
+    const auto version = reader.Read<std::uint16_t>();
+    if (version == 0 || version > DOG_ARCHIVE_VERSION) {
+        return std::nullopt;
+    }
+    reader.Read<std::uint16_t>();
+    const size_t count = reader.Read<std::uint32_t>();
+
+    model::DogRegistry::Columns columns;
+    const auto ids = reader.ReadColumn<std::uint32_t>(count);
+    columns.x = reader.ReadCoords(count);
+    columns.y = reader.ReadCoords(count);
+    columns.speed_x = reader.ReadCoords(count);
+    columns.speed_y = reader.ReadCoords(count);
+    const auto directions = reader.ReadColumn<std::uint8_t>(count);
+    const auto bag_capacities = reader.ReadColumn<std::uint32_t>(count);
+    const auto scores = reader.ReadColumn<std::uint32_t>(count);
+
+    const auto name_ends = reader.ReadColumn<std::uint32_t>(count);
+    if (reader.Failed() || !CheckEnds(name_ends, reader.GetRest().size())) {
+        return std::nullopt;
+    }
+    const auto names = reader.Take(count ? name_ends.back() : 0);
+
+    const auto bag_ends = reader.ReadColumn<std::uint32_t>(count);
+    if (reader.Failed() || !CheckEnds(bag_ends, reader.GetRest().size() / (2 * sizeof(std::uint32_t)))) {
+        return std::nullopt;
+    }
+    const auto items = reader.ReadColumn<std::uint32_t>(count ? 2 * size_t{bag_ends.back()} : 0);
+    if (reader.Failed()) {
+        return std::nullopt;
+    }
+
+    // Все собаки проверяются одним проходом до создания профилей
+    bool valid = true;
+    std::uint32_t bag_begin = 0;
+    for (size_t i = 0; i < count; ++i) {
+        valid &= directions[i] <= static_cast<std::uint8_t>(model::Direction::SOUTH)
+                 && bag_capacities[i] <= model::Dog::MAX_BAG_CAPACITY
+                 && bag_ends[i] - bag_begin <= bag_capacities[i];
+        bag_begin = bag_ends[i];
+    }
+    if (!valid) {
+        return std::nullopt;
+    }
+
+    columns.ids.reserve(count);
+    columns.direction.reserve(count);
+    columns.profiles.resize(count);
+    std::uint32_t name_begin = 0;
+    bag_begin = 0;
+    for (size_t i = 0; i < count; ++i) {
+        columns.ids.emplace_back(ids[i]);
+        columns.direction.push_back(static_cast<model::Direction>(directions[i]));
+        auto& profile = columns.profiles[i];
+        profile.name = names.substr(name_begin, name_ends[i] - name_begin);
+        profile.bag_capacity = bag_capacities[i];
+        profile.score = scores[i];
+        // Вместимость рюкзака проверена выше
+        for (std::uint32_t item = bag_begin; item < bag_ends[i]; ++item) {
+            profile.bag.push_back({model::FoundObject::Id{items[2 * item]}, items[2 * item + 1]});
+        }
+        name_begin = name_ends[i];
+        bag_begin = bag_ends[i];
+    }
+
+    auto dogs = model::DogRegistry::FromColumns(std::move(columns));
+    if (dogs) {
+        data = reader.GetRest();
+    }
+    return dogs;
+}
+
+model::DogRegistry ReadDogs(std::string_view& data) {
+    std::string_view rest = data;
+    auto dogs = TryReadDogs(rest);
+    if (!dogs) {
+        Reader::Fail();
+    }
+    data = rest;
+    return std::move(*dogs);
+}
+
+std::vector<std::optional<model::DogRegistry>> ReadDogsParallel(std::span<const std::string_view> archives,
+                                                                size_t thread_count) {
+    std::vector<std::optional<model::DogRegistry>> results(archives.size());
+    std::atomic<size_t> next{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto read_archives = [&] {
+        // Архивы разбираются по одному: крупный архив не задерживает разбор остальных
+        for (size_t i = next++; i < archives.size(); i = next++) {
+            try {
+                auto rest = archives[i];
+                auto dogs = TryReadDogs(rest);
+                if (dogs && rest.empty()) {
+                    results[i] = std::move(dogs);
+                }
+            } catch (...) {
+                // Повреждённые данные не выбрасывают исключений, остаётся нехватка памяти
+                std::lock_guard lk{error_mutex};
+                error = std::current_exception();
+                next = archives.size();
+            }
+        }
+    };
+
+    thread_count = std::clamp<size_t>(thread_count, 1, archives.size() ? archives.size() : 1);
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t i = 1; i < thread_count; ++i) {
+            threads.emplace_back(read_archives);
+        }
+        read_archives();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return results;
+}
+
+void WriteU32Array(const std::vector<std::uint32_t>& values, std::string& out) {
+    Writer writer{out};
+    writer.Write(static_cast<std::uint32_t>(values.size()));
+    writer.WriteColumn(values);
+}
+
+std::vector<std::uint32_t> ReadU32Array(std::string_view& data) {
+    Reader reader{data};
+    const size_t count = reader.Read<std::uint32_t>();
+    auto values = reader.ReadColumn<std::uint32_t>(count);
+    if (reader.Failed()) {
+        Reader::Fail();
+    }
+    data = reader.GetRest();
+    return values;
+}
+
+}  // namespace serialization
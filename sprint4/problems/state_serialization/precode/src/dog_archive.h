@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+
+namespace serialization {
+
+/*
+ * Компактный двоичный формат для собак игрового сеанса.
+ * Собаки записываются по столбцам в том же порядке, в каком их хранит DogRegistry,
+ * поэтому числовые столбцы копируются целиком, а не по одному полю. Числа записываются
+ * в порядке little-endian, строки и содержимое рюкзаков - одним блоком со смещениями.
+ * Блок начинается с сигнатуры и номера версии схемы. Читатель понимает все версии
+ * до DOG_ARCHIVE_VERSION включительно и отвергает более новые.
+ *
+ *  magic "DOGS" | u16 version | u16 reserved | u32 count
+ *  u32 id[count] | f64 x[count] | f64 y[count] | f64 speed_x[count] | f64 speed_y[count]
+ *  u8 direction[count] | u32 bag_capacity[count] | u32 score[count]
+ *  u32 name_end[count] | char names[name_end[count - 1]]
+ *  u32 bag_end[count] | (u32 id, u32 type) items[bag_end[count - 1]]
+ */
+constexpr std::uint16_t DOG_ARCHIVE_VERSION = 1;
+
+// Дописывает в out собак реестра dogs
+void WriteDogs(const model::DogRegistry& dogs, std::string& out);
+
+// Читает собак, записанных WriteDogs, из начала data и сдвигает data за прочитанный блок.
+// Столбцы архива проверяются целиком и переносятся в реестр без сборки каждой собаки.
+// Если данные повреждены или записаны более новой версией, возвращает nullopt
+// и оставляет data без изменений
+std::optional<model::DogRegistry> TryReadDogs(std::string_view& data);
+
+// То же, что TryReadDogs, но при повреждённых данных выбрасывает std::runtime_error
+model::DogRegistry ReadDogs(std::string_view& data);
+
+// Читает независимые архивы, например собак разных игровых сеансов, в thread_count потоках.
+// Каждый архив должен содержать ровно один блок WriteDogs. Вместо повреждённого архива
+// возвращается nullopt, остальные архивы при этом загружаются
+std::vector<std::optional<model::DogRegistry>> ReadDogsParallel(
+    std::span<const std::string_view> archives, size_t thread_count = std::thread::hardware_concurrency());
+
+// Дописывает в out и читает из начала data последовательность 32-битных чисел с длиной
+void WriteU32Array(const std::vector<std::uint32_t>& values, std::string& out);
+std::vector<std::uint32_t> ReadU32Array(std::string_view& data);
+
+}  // namespace serialization
@@ -0,0 +1,107 @@
+#include "durable_file.h"
+
+#include <boost/crc.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace serialization {
+
+using namespace std::literals;
+
+File::File(const std::filesystem::path& path, int flags)
+    : fd_{::open(path.c_str(), flags | O_CLOEXEC, 0644)} {
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open "s + path.string());
+    }
+}
+
+File::~File() {
+    ::close(fd_);
+}
+
+void File::Write(std::string_view data) {
+    while (!data.empty()) {
+        const auto written = ::write(fd_, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+void File::Sync() {
+    if (::fsync(fd_) != 0) {
+        throw std::system_error(errno, std::generic_category(), "fsync");
+    }
+}
+
+void ReplaceFile(const std::filesystem::path& path, std::string_view data) {
+    auto tmp_path = path;
+    tmp_path += ".tmp"sv;
+    {
+        File file{tmp_path, O_WRONLY | O_CREAT | O_TRUNC};
+        file.Write(data);
+        file.Sync();
+    }
+    std::filesystem::rename(tmp_path, path);
+    // Переименование становится надёжным после синхронизации каталога
+    File dir{path.has_parent_path() ? path.parent_path() : ".", O_RDONLY | O_DIRECTORY};
+    dir.Sync();
+}
+
+std::uintmax_t GetFileSize(const std::filesystem::path& path) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : size;
+}
+
+std::optional<std::string> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        return std::nullopt;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    return std::move(content).str();
+}
+
+std::uint32_t Checksum(std::string_view data) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+    return crc.checksum();
+}
+
+void AppendRecord(std::string& out, std::string_view payload) {
+    const RecordHeader header{static_cast<std::uint32_t>(payload.size()), Checksum(payload)};
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(payload);
+}
+
+std::optional<std::string_view> ReadRecord(std::string_view& data) {
+    RecordHeader header;
+    if (data.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (header.size > data.size() - sizeof(header)) {
+        return std::nullopt;
+    }
+    const auto payload = data.substr(sizeof(header), header.size);
+    if (Checksum(payload) != header.crc) {
+        return std::nullopt;
+    }
+    data.remove_prefix(sizeof(header) + header.size);
+    return payload;
+}
+
+}  // namespace serialization
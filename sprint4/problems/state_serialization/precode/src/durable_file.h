@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace serialization {
+
+// Дескриптор файла, закрываемый в деструкторе
+class File {
+public:
+    // flags - флаги open(2)
+    File(const std::filesystem::path& path, int flags);
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File();
+
+    void Write(std::string_view data);
+
+    // Дожидается, пока данные файла попадут на носитель
+    void Sync();
+
+private:
+    int fd_;
+};
+
+// Заменяет файл path содержимым data так, что после сбоя файл содержит либо старые,
+// либо новые данные целиком
+void ReplaceFile(const std::filesystem::path& path, std::string_view data);
+
+// Размер файла либо 0, если файла нет
+std::uintmax_t GetFileSize(const std::filesystem::path& path);
+
+// Содержимое файла либо nullopt, если файла нет
+std::optional<std::string> ReadFile(const std::filesystem::path& path);
+
+/*
+ * Записи журналов снабжаются заголовком с длиной и контрольной суммой, чтобы запись,
+ * оборванная при аварийном завершении, распознавалась при чтении.
+ * Заголовок хранится в порядке байтов платформы: журналы читаются там же, где записаны
+ */
+struct RecordHeader {
+    std::uint32_t size;
+    std::uint32_t crc;
+};
+
+std::uint32_t Checksum(std::string_view data);
+
+// Дописывает в out запись с содержимым payload
+void AppendRecord(std::string& out, std::string_view payload);
+
+// Читает запись из начала data и сдвигает data за неё. Если запись оборвана
+// или повреждена, возвращает nullopt
+std::optional<std::string_view> ReadRecord(std::string_view& data);
+
+}  // namespace serialization
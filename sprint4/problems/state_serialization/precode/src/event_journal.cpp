@@ -0,0 +1,389 @@
+#include "event_journal.h"
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "dog_archive.h"
+
+namespace serialization {
+
+using namespace std::literals;
+
+namespace {
+
+/*
+ * Контрольная точка:
+ *  magic "GJRN" | u16 version | u16 reserved | i64 now | u32 next_dog_id | собаки (dog_archive.h)
+ *  i64 last_active[count] | i64 joined_at[count]
+ *  f64 min_x[count] | f64 max_x[count] | f64 min_y[count] | f64 max_y[count] | u8 bounds_dirty[count]
+ * Группа событий - последовательность событий, каждое начинается с типа:
+ *  JOIN: f64 x | f64 y | u32 bag_capacity | u32 name_size | char name[name_size]
+ *  MOVE: u32 dog_id | f64 speed_x | f64 speed_y | u8 direction
+ *  TICK: i64 dt
+ * Время записывается в миллисекундах
+ */
+constexpr std::array<char, 4> MAGIC{'G', 'J', 'R', 'N'};
+constexpr std::uint16_t VERSION = 1;
+
+enum class EventType : std::uint8_t {
+    JOIN = 1,
+    MOVE,
+    TICK,
+};
+
+class Encoder {
+public:
+    explicit Encoder(std::string& out) noexcept
+        : out_{out} {
+    }
+
+    template <typename T>
+    void Put(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void PutBytes(std::string_view bytes) {
+        out_.append(bytes);
+    }
+
+private:
+    std::string& out_;
+};
+
+class Decoder {
+public:
+    explicit Decoder(std::string_view data) noexcept
+        : data_{data} {
+    }
+
+    template <typename T>
+    T Get() {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        T value;
+        std::memcpy(&value, Take(sizeof(T)).data(), sizeof(T));
+        return value;
+    }
+
+    std::string_view Take(size_t size) {
+        if (size > data_.size()) {
+            Fail();
+        }
+        const auto bytes = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return bytes;
+    }
+
+    bool AtEnd() const noexcept {
+        return data_.empty();
+    }
+
+    // Непрочитанные данные. Сдвигается вызывающим, если он читает их сам
+    std::string_view& GetRest() noexcept {
+        return data_;
+    }
+
+    [[noreturn]] static void Fail() {
+        throw std::runtime_error("Event journal is corrupted"s);
+    }
+
+private:
+    std::string_view data_;
+};
+
+void EncodeEvent(const GameEvent& event, std::string& out) {
+    Encoder encoder{out};
+    if (const auto* join = std::get_if<JoinEvent>(&event)) {
+        encoder.Put(EventType::JOIN);
+        encoder.Put(join->position.x);
+        encoder.Put(join->position.y);
+        encoder.Put(static_cast<std::uint32_t>(join->bag_capacity));
+        encoder.Put(static_cast<std::uint32_t>(join->name.size()));
+        encoder.PutBytes(join->name);
+    } else if (const auto* move = std::get_if<MoveEvent>(&event)) {
+        encoder.Put(EventType::MOVE);
+        encoder.Put(*move->dog_id);
+        encoder.Put(move->speed.x);
+        encoder.Put(move->speed.y);
+        encoder.Put(static_cast<std::uint8_t>(move->direction));
+    } else {
+        encoder.Put(EventType::TICK);
+        encoder.Put(static_cast<std::int64_t>(std::get<TickEvent>(event).dt.count()));
+    }
+}
+
+GameEvent DecodeEvent(Decoder& decoder) {
+    switch (decoder.Get<EventType>()) {
+        case EventType::JOIN: {
+            JoinEvent join;
+            join.position.x = decoder.Get<double>();
+            join.position.y = decoder.Get<double>();
+            join.bag_capacity = decoder.Get<std::uint32_t>();
+            join.name = decoder.Take(decoder.Get<std::uint32_t>());
+            return join;
+        }
+        case EventType::MOVE: {
+            MoveEvent move;
+            move.dog_id = model::Dog::Id{decoder.Get<std::uint32_t>()};
+            move.speed.x = decoder.Get<double>();
+            move.speed.y = decoder.Get<double>();
+            const auto direction = decoder.Get<std::uint8_t>();
+            if (direction > static_cast<std::uint8_t>(model::Direction::SOUTH)) {
+                Decoder::Fail();
+            }
+            move.direction = static_cast<model::Direction>(direction);
+            return move;
+        }
+        case EventType::TICK:
+            return TickEvent{model::TimeInterval{decoder.Get<std::int64_t>()}};
+    }
+    Decoder::Fail();
+}
+
+std::string EncodeCheckpoint(const model::GameSession& session) {
+    const auto& dogs = session.GetDogs();
+    const auto& motion = dogs.GetMotion();
+    const size_t count = dogs.Size();
+
+    std::string data;
+    Encoder encoder{data};
+    encoder.PutBytes({MAGIC.data(), MAGIC.size()});
+    encoder.Put(VERSION);
+    encoder.Put(std::uint16_t{0});
+    encoder.Put(static_cast<std::int64_t>(session.GetTime().count()));
+    encoder.Put(session.GetNextDogId());
+    WriteDogs(dogs, data);
+
+    for (const auto last_active : motion.last_active) {
+        encoder.Put(static_cast<std::int64_t>(last_active.count()));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        encoder.Put(static_cast<std::int64_t>(dogs.GetProfile(i).joined_at.count()));
+    }
+    // Пределы движения сохраняются, а не пересчитываются при восстановлении:
+    // собака с диагональной скоростью ограничена пределами от точки, где скорость была задана
+    for (const auto* column : {&motion.min_x, &motion.max_x, &motion.min_y, &motion.max_y}) {
+        for (const double value : *column) {
+            encoder.Put(value);
+        }
+    }
+    for (const auto dirty : motion.bounds_dirty) {
+        encoder.Put(dirty);
+    }
+    return data;
+}
+
+}  // namespace
+
+void RestoreCheckpoint(std::string_view checkpoint, model::GameSession& session) {
+    Decoder decoder{checkpoint};
+    if (decoder.Take(MAGIC.size()) != std::string_view{MAGIC.data(), MAGIC.size()}) {
+        throw std::runtime_error("Not an event journal"s);
+    }
+    const auto version = decoder.Get<std::uint16_t>();
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported event journal version "s + std::to_string(version));
+    }
+    decoder.Get<std::uint16_t>();
+    const model::TimeInterval now{decoder.Get<std::int64_t>()};
+    const auto next_dog_id = decoder.Get<std::uint32_t>();
+    auto dogs = ReadDogs(decoder.GetRest());
+
+    auto& motion = dogs.GetMotion();
+    const size_t count = dogs.Size();
+    for (auto& last_active : motion.last_active) {
+        last_active = model::TimeInterval{decoder.Get<std::int64_t>()};
+    }
+    for (size_t i = 0; i < count; ++i) {
+        dogs.GetProfile(i).joined_at = model::TimeInterval{decoder.Get<std::int64_t>()};
+    }
+    for (auto* column : {&motion.min_x, &motion.max_x, &motion.min_y, &motion.max_y}) {
+        for (auto& value : *column) {
+            value = decoder.Get<double>();
+        }
+    }
+    for (auto& dirty : motion.bounds_dirty) {
+        dirty = decoder.Get<std::uint8_t>();
+    }
+    if (!decoder.AtEnd()) {
+        Decoder::Fail();
+    }
+    session.Restore(std::move(dogs), now, next_dog_id);
+}
+
+void ForEachEvent(std::string_view group, const std::function<void(const GameEvent&)>& fn) {
+    for (Decoder decoder{group}; !decoder.AtEnd();) {
+        fn(DecodeEvent(decoder));
+    }
+}
+
+std::optional<model::Dog::Id> ApplyEvent(model::GameSession& session, const GameEvent& event) {
+    if (const auto* join = std::get_if<JoinEvent>(&event)) {
+        return session.AddDog(join->name, join->position, join->bag_capacity);
+    }
+    if (const auto* move = std::get_if<MoveEvent>(&event)) {
+        auto& dogs = session.GetDogs();
+        if (const auto index = dogs.FindIndex(move->dog_id)) {
+            dogs.SetSpeed(*index, move->speed);
+            dogs.SetDirection(*index, move->direction);
+        }
+        return std::nullopt;
+    }
+    session.Tick(std::get<TickEvent>(event).dt);
+    return std::nullopt;
+}
+
+EventJournal::EventJournal(std::filesystem::path path, const model::GameSession& session,
+                           Observer observer)
+    : path_{std::move(path)}
+    , observer_{std::move(observer)} {
+    const auto checkpoint = EncodeCheckpoint(session);
+    std::string data;
+    AppendRecord(data, checkpoint);
+    ReplaceFile(path_, data);
+    file_.emplace(path_, O_WRONLY | O_APPEND);
+    if (observer_) {
+        observer_(JournalRecord::CHECKPOINT, checkpoint);
+    }
+    // Поток запускается после записи контрольной точки, чтобы не обращаться к file_ одновременно
+    worker_ = std::jthread{[this](std::stop_token stop) {
+        Run(stop);
+    }};
+}
+
+EventJournal::~EventJournal() {
+    // Поток записывает остаток очереди и завершается, деструктор jthread дожидается его
+    worker_.request_stop();
+}
+
+void EventJournal::Append(const GameEvent& event) {
+    {
+        std::lock_guard lk{mutex_};
+        if (broken_) {
+            return;
+        }
+        EncodeEvent(event, pending_);
+        ++appended_;
+    }
+    cv_.notify_all();
+}
+
+void EventJournal::Checkpoint(const model::GameSession& session) {
+    auto checkpoint = EncodeCheckpoint(session);
+    {
+        std::lock_guard lk{mutex_};
+        // Ещё не записанные события уже учтены в контрольной точке
+        checkpoint_ = std::move(checkpoint);
+        pending_.clear();
+        broken_ = false;
+        ++appended_;
+    }
+    cv_.notify_all();
+}
+
+void EventJournal::Flush() {
+    std::unique_lock lk{mutex_};
+    cv_.wait(lk, [this] {
+        return written_ == appended_ || error_;
+    });
+    if (auto error = std::exchange(error_, nullptr)) {
+        std::rethrow_exception(error);
+    }
+}
+
+void EventJournal::Run(std::stop_token stop) {
+    std::unique_lock lk{mutex_};
+    const auto has_pending = [this] {
+        return !pending_.empty() || checkpoint_.has_value();
+    };
+    while (cv_.wait(lk, stop, has_pending)) {
+        WritePending(lk);
+    }
+    if (has_pending()) {
+        WritePending(lk);
+    }
+}
+
+void EventJournal::WritePending(std::unique_lock<std::mutex>& lk) {
+    auto checkpoint = std::exchange(checkpoint_, std::nullopt);
+    const auto events = std::exchange(pending_, {});
+    const auto target = appended_;
+    lk.unlock();
+
+    std::exception_ptr error;
+    try {
+        if (checkpoint) {
+            std::string data;
+            AppendRecord(data, *checkpoint);
+            if (!events.empty()) {
+                AppendRecord(data, events);
+            }
+            file_.reset();
+            ReplaceFile(path_, data);
+            file_.emplace(path_, O_WRONLY | O_APPEND);
+        } else {
+            std::string record;
+            AppendRecord(record, events);
+            file_->Write(record);
+            file_->Sync();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Наблюдатель получает только то, что есть в файле, иначе резервная копия разошлась бы
+    // с журналом. После неудачной записи он получит следующую контрольную точку
+    if (observer_ && !error) {
+        if (checkpoint) {
+            observer_(JournalRecord::CHECKPOINT, *checkpoint);
+        }
+        if (!events.empty()) {
+            observer_(JournalRecord::EVENTS, events);
+        }
+    }
+
+    lk.lock();
+    written_ = std::max(written_, target);
+    if (error) {
+        error_ = error;
+        // События, добавленные во время записи, следовали бы за пропуском. Если за это время
+        // запрошена контрольная точка, журнал начнётся с неё
+        if (!checkpoint_) {
+            pending_.clear();
+            written_ = appended_;
+            broken_ = true;
+        }
+    }
+    cv_.notify_all();
+}
+
+size_t RecoverSession(const std::filesystem::path& path, model::GameSession& session) {
+    const auto content = ReadFile(path);
+    if (!content) {
+        return 0;
+    }
+    std::string_view rest = *content;
+    // Контрольная точка записывается атомарной заменой файла и не может быть оборвана
+    const auto checkpoint = ReadRecord(rest);
+    if (!checkpoint) {
+        throw std::runtime_error("Event journal checkpoint is corrupted"s);
+    }
+    RestoreCheckpoint(*checkpoint, session);
+
+    size_t count = 0;
+    // Оборванная группа событий в конце журнала отбрасывается
+    while (const auto group = ReadRecord(rest)) {
+        ForEachEvent(*group, [&session, &count](const GameEvent& event) {
+            ApplyEvent(session, event);
+            ++count;
+        });
+    }
+    return count;
+}
+
+}  // namespace serialization
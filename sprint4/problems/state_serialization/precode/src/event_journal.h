@@ -0,0 +1,153 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <variant>
+
+#include "durable_file.h"
+#include "model.h"
+
+namespace serialization {
+
+// Игрок вошёл в игру. Id собаки не записывается: сеанс выдаёт его сам в порядке входа
+struct JoinEvent {
+    std::string name;
+    geom::Point2D position;
+    size_t bag_capacity = 0;
+};
+
+// Игрок сменил скорость и направление собаки
+struct MoveEvent {
+    model::Dog::Id dog_id{0};
+    geom::Vec2D speed;
+    model::Direction direction = model::Direction::NORTH;
+};
+
+// Граница тика: время сеанса продвинулось на dt
+struct TickEvent {
+    model::TimeInterval dt{};
+};
+
+using GameEvent = std::variant<JoinEvent, MoveEvent, TickEvent>;
+
+// Применяет событие к сеансу. Для JoinEvent возвращает Id вошедшей собаки.
+// Смена скорости собаки, уже покинувшей игру, пропускается
+std::optional<model::Dog::Id> ApplyEvent(model::GameSession& session, const GameEvent& event);
+
+// Вид записи журнала
+enum class JournalRecord : std::uint8_t {
+    // Полное состояние сеанса, см. RestoreCheckpoint
+    CHECKPOINT,
+    // Группа событий, см. ForEachEvent
+    EVENTS,
+};
+
+// Заменяет состояние сеанса контрольной точкой из записи CHECKPOINT.
+// Если запись повреждена, выбрасывает std::runtime_error
+void RestoreCheckpoint(std::string_view checkpoint, model::GameSession& session);
+
+// Вызывает fn(const GameEvent&) для каждого события группы из записи EVENTS.
+// Если группа повреждена, выбрасывает std::runtime_error
+void ForEachEvent(std::string_view group, const std::function<void(const GameEvent&)>& fn);
+
+/*
+ * Журнал событий игрового сеанса для быстрого восстановления после сбоя.
+ * Файл журнала начинается с контрольной точки - полного состояния сеанса, включая время
+ * сеанса, сроки бездействия и пределы движения собак, - за которой следуют действия игроков
+ * и границы тиков в компактном двоичном виде. Сеанс детерминирован, поэтому
+ * RecoverSession, применив к контрольной точке записанные события, получает то же
+ * состояние, что было перед сбоем. Событие занимает десятки байт, поэтому журнал
+ * не зависит от размера мира, а контрольные точки можно делать редко: время
+ * восстановления ограничено числом событий с последней из них.
+ *
+ * Append лишь кодирует событие в буфер. Буфер записывается на диск и синхронизируется
+ * в отдельном потоке: пока выполняется fsync, новые события накапливаются и уходят
+ * следующей записью (групповая фиксация), поэтому одна синхронизация приходится
+ * на много событий, а сеанс её не ждёт. Каждая запись снабжена длиной и контрольной
+ * суммой: запись, оборванная при сбое, при восстановлении отбрасывается вместе со всеми
+ * следующими, и сеанс восстанавливается на границе последней записанной группы.
+ *
+ * Checkpoint атомарно заменяет файл журнала новой контрольной точкой, после чего
+ * прежние события больше не нужны. Если запись не удалась, события перестают
+ * записываться до следующего Checkpoint, чтобы журнал не содержал пропусков.
+ *
+ * Наблюдатель, если он задан, получает каждую запись журнала после того, как она попала
+ * на носитель, в том порядке, в каком записи следуют в файле. Так журнал передаётся
+ * на резервный узел (см. JournalShipper) без задержки тика.
+ *
+ * Append и Checkpoint вызываются там же, где изменяется сеанс, в порядке применения
+ * событий. Flush можно вызывать из любого потока. Журнал хранит числа в порядке байтов
+ * платформы и читается там же, где записан
+ */
+class EventJournal {
+public:
+    // Вызывается потоком записи журнала и не должен его надолго задерживать.
+    // Содержимое записи действительно только во время вызова
+    using Observer = std::function<void(JournalRecord kind, std::string_view payload)>;
+
+    // Начинает журнал path с контрольной точки текущего состояния session,
+    // например восстановленного RecoverSession. Наблюдатель получает эту контрольную
+    // точку в потоке конструктора
+    EventJournal(std::filesystem::path path, const model::GameSession& session,
+                 Observer observer = {});
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    // Записывает накопленные события и дожидается окончания записи
+    ~EventJournal();
+
+    // Ставит событие, уже применённое к сеансу, в очередь записи
+    void Append(const GameEvent& event);
+
+    // Заменяет журнал контрольной точкой текущего состояния session
+    void Checkpoint(const model::GameSession& session);
+
+    // Дожидается, пока все добавленные события попадут на носитель.
+    // Если запись не удалась, выбрасывает её исключение
+    void Flush();
+
+    const std::filesystem::path& GetPath() const noexcept {
+        return path_;
+    }
+
+private:
+    void Run(std::stop_token stop);
+    // Записывает очередь на диск. Вызывается под мьютексом lk
+    void WritePending(std::unique_lock<std::mutex>& lk);
+
+    std::filesystem::path path_;
+    Observer observer_;
+    // Файл журнала, открытый на дозапись. Используется только потоком записи
+    std::optional<File> file_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    // Закодированные события, ожидающие записи
+    std::string pending_;
+    // Контрольная точка, которой нужно заменить журнал перед записью pending_
+    std::optional<std::string> checkpoint_;
+    // Номера последнего добавленного и последнего записанного изменения журнала
+    std::uint64_t appended_ = 0;
+    std::uint64_t written_ = 0;
+    // Журнал содержит пропуск, и события не записываются до контрольной точки
+    bool broken_ = false;
+    std::exception_ptr error_;
+
+    // Поток объявлен последним, чтобы остановиться раньше разрушения остальных полей
+    std::jthread worker_;
+};
+
+// Восстанавливает сеанс из журнала path: загружает контрольную точку и применяет
+// записанные после неё события. Возвращает число применённых событий.
+// Если журнала нет, оставляет сеанс без изменений и возвращает 0.
+// Если контрольная точка повреждена, выбрасывает std::runtime_error
+size_t RecoverSession(const std::filesystem::path& path, model::GameSession& session);
+
+}  // namespace serialization
@@ -0,0 +1,92 @@
+#include "game_sessions.h"
+
+#include <boost/asio/post.hpp>
+
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace app {
+
+GameSessions::GameSessions(std::vector<net::io_context*> contexts, Ticker::Step tick_step,
+                           model::TimeInterval retirement_time, RetirementHandler on_retired)
+    : contexts_{std::move(contexts)}
+    , tick_step_{tick_step}
+    , retirement_time_{retirement_time}
+    , on_retired_{std::move(on_retired)} {
+    if (contexts_.empty()) {
+        throw std::invalid_argument("At least one io_context is required");
+    }
+}
+
+void GameSessions::AddSession(const model::Map& map) {
+    if (sessions_.contains(map.GetId())) {
+        return;
+    }
+    // Очередной сеанс попадает в следующий контекст
+    net::io_context& ioc = *contexts_[sessions_.size() % contexts_.size()];
+    auto entry = std::make_unique<Entry>(map, retirement_time_, net::make_strand(ioc));
+    entry->ticker = std::make_shared<Ticker>(entry->strand, tick_step_, [this, entry = entry.get()](const TickInfo& tick) {
+        OnTick(*entry, tick);
+    });
+    sessions_.emplace(map.GetId(), std::move(entry));
+}
+
+void GameSessions::Start() {
+    for (const auto& [id, entry] : sessions_) {
+        entry->ticker->Start();
+    }
+}
+
+void GameSessions::Stop() {
+    for (const auto& [id, entry] : sessions_) {
+        entry->ticker->Stop();
+        // Тиков больше не будет, поэтому собаки, передача которых отложена из-за перегрузки,
+        // передаются сразу. Остановка тикера выполняется в strand раньше
+        net::post(entry->strand, [this, entry = entry.get()] {
+            FlushRetired(*entry);
+        });
+    }
+}
+
+void GameSessions::OnTick(Entry& entry, const TickInfo& tick) {
+    entry.session.Tick(tick.dt);
+    auto retired = entry.session.TakeRetired();
+    if (!on_retired_) {
+        return;
+    }
+    if (entry.deferred_retired.empty()) {
+        entry.deferred_retired = std::move(retired);
+    } else {
+        std::move(retired.begin(), retired.end(), std::back_inserter(entry.deferred_retired));
+    }
+    if (entry.deferred_retired.empty()) {
+        return;
+    }
+    if (tick.overloaded && ++entry.deferred_ticks < RETIREMENT_DEFERRAL_TICKS) {
+        return;
+    }
+    FlushRetired(entry);
+}
+
+void GameSessions::FlushRetired(Entry& entry) {
+    entry.deferred_ticks = 0;
+    if (!entry.deferred_retired.empty() && on_retired_) {
+        on_retired_(std::exchange(entry.deferred_retired, {}));
+    }
+}
+
+const GameSessions::Strand* GameSessions::FindStrand(const model::Map::Id& map_id) const noexcept {
+    const auto it = sessions_.find(map_id);
+    return it == sessions_.end() ? nullptr : &it->second->strand;
+}
+
+std::optional<TickerStatus> GameSessions::GetTickerStatus(const model::Map::Id& map_id) const noexcept {
+    const auto it = sessions_.find(map_id);
+    if (it == sessions_.end()) {
+        return std::nullopt;
+    }
+    return it->second->ticker->GetStatus();
+}
+
+}  // namespace app
@@ -0,0 +1,109 @@
+#pragma once
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "model.h"
+#include "ticker.h"
+
+namespace app {
+
+namespace net = boost::asio;
+
+/*
+ * Игровые сеансы, по одному на карту. У каждого сеанса свой strand, в котором выполняются
+ * его Tick и все запросы к нему, поэтому сеансы не нуждаются в блокировках и не мешают друг другу.
+ *
+ * Сеансы распределяются по переданным io_context по кругу. Если каждый контекст обслуживается
+ * одним потоком (см. http_server::IoContextPool), сеанс всегда выполняется на одном ядре,
+ * а сеансы разных карт - на разных. С одним многопоточным io_context strand'ы сеансов
+ * распределяются по потокам пула самим io_context.
+ *
+ * Собаки, покинувшие игру из-за бездействия, передаются обработчику on_retired, например
+ * для записи в таблицу рекордов. Обработчик вызывается в strand сеанса после его тика
+ * и не должен надолго его задерживать. Передача ушедших собак - необязательная работа тика:
+ * пока тикер сеанса перегружен (см. Ticker), они накапливаются и передаются не чаще раза
+ * в RETIREMENT_DEFERRAL_TICKS тиков, а не после каждого тика.
+ *
+ * Сеансы добавляются до Start. После этого набор сеансов не меняется,
+ * и Dispatch можно вызывать из любого потока без синхронизации
+ */
+class GameSessions {
+public:
+    using Strand = Ticker::Strand;
+    using RetirementHandler = std::function<void(std::vector<model::RetiredDog> retired)>;
+
+    constexpr static unsigned RETIREMENT_DEFERRAL_TICKS = 10;
+
+    GameSessions(std::vector<net::io_context*> contexts, Ticker::Step tick_step,
+                 model::TimeInterval retirement_time = model::GameSession::DEFAULT_RETIREMENT_TIME,
+                 RetirementHandler on_retired = {});
+
+    GameSessions(const GameSessions&) = delete;
+    GameSessions& operator=(const GameSessions&) = delete;
+
+    // Создаёт сеанс для карты, если его ещё нет. Карта должна существовать дольше сеансов
+    void AddSession(const model::Map& map);
+
+    // Запускает тики всех сеансов
+    void Start();
+    // Останавливает тики всех сеансов и передаёт обработчику on_retired собак, передача которых
+    // была отложена. Передача выполняется в strand сеансов, поэтому их io_context должны
+    // поработать после Stop. Может быть вызван из любого потока
+    void Stop();
+
+    // Выполняет handler(model::GameSession&) в strand сеанса карты map_id.
+    // Возвращает false, если сеанса для карты нет
+    template <typename Handler>
+    bool Dispatch(const model::Map::Id& map_id, Handler&& handler) const {
+        const auto it = sessions_.find(map_id);
+        if (it == sessions_.end()) {
+            return false;
+        }
+        Entry* entry = it->second.get();
+        net::dispatch(entry->strand, [entry, handler = std::forward<Handler>(handler)]() mutable {
+            handler(entry->session);
+        });
+        return true;
+    }
+
+    // Strand сеанса карты map_id либо nullptr
+    const Strand* FindStrand(const model::Map::Id& map_id) const noexcept;
+
+    // Показатели нагрузки тикера сеанса карты map_id. Может быть вызван из любого потока
+    std::optional<TickerStatus> GetTickerStatus(const model::Map::Id& map_id) const noexcept;
+
+private:
+    struct Entry {
+        Entry(const model::Map& map, model::TimeInterval retirement_time, Strand s)
+            : session{map, retirement_time}
+            , strand{std::move(s)} {
+        }
+
+        model::GameSession session;
+        Strand strand;
+        std::shared_ptr<Ticker> ticker;
+        // Собаки, ушедшие во время перегрузки, и сколько тиков их передача откладывается
+        std::vector<model::RetiredDog> deferred_retired;
+        unsigned deferred_ticks = 0;
+    };
+
+    void OnTick(Entry& entry, const TickInfo& tick);
+    void FlushRetired(Entry& entry);
+
+    using MapIdHasher = util::TaggedHasher<model::Map::Id>;
+
+    std::vector<net::io_context*> contexts_;
+    Ticker::Step tick_step_;
+    model::TimeInterval retirement_time_;
+    RetirementHandler on_retired_;
+    std::unordered_map<model::Map::Id, std::unique_ptr<Entry>, MapIdHasher> sessions_;
+};
+
+}  // namespace app
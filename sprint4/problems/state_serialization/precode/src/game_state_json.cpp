@@ -0,0 +1,187 @@
+#include "game_state_json.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace app {
+
+using namespace std::literals;
+
+namespace {
+
+// Самая длинная кратчайшая запись double, например -2.2250738585072014e-308
+constexpr size_t MAX_DOUBLE_LENGTH = 24;
+constexpr size_t MAX_UINT32_LENGTH = std::numeric_limits<uint32_t>::digits10 + 1;
+constexpr size_t MAX_UINT64_LENGTH = std::numeric_limits<uint64_t>::digits10 + 1;
+
+constexpr auto TICK = R"({"tick":)"sv;
+constexpr auto SINCE = R"(,"since":)"sv;
+constexpr auto PLAYERS = R"(,"players":{)"sv;
+constexpr auto REMOVED = R"(},"removed":[)"sv;
+constexpr auto POS = R"(":{"pos":[)"sv;
+constexpr auto SPEED = R"(],"speed":[)"sv;
+constexpr auto DIR = R"(],"dir":")"sv;
+constexpr auto BAG = R"(","bag":[)"sv;
+constexpr auto ITEM_ID = R"({"id":)"sv;
+constexpr auto ITEM_TYPE = R"(,"type":)"sv;
+constexpr auto SCORE = R"(],"score":)"sv;
+
+// Длина записи одной собаки без предметов рюкзака: ,"<id>":{...}
+constexpr size_t MAX_DOG_LENGTH = 2 + MAX_UINT32_LENGTH + POS.size() + MAX_DOUBLE_LENGTH * 4 + 2 + SPEED.size()
+                                + DIR.size() + 1 + BAG.size() + SCORE.size() + MAX_UINT32_LENGTH + 1;
+// Длина записи всего, кроме собак и удалённых собак
+constexpr size_t MAX_HEADER_LENGTH = TICK.size() + MAX_UINT64_LENGTH + SINCE.size() + MAX_UINT64_LENGTH
+                                   + PLAYERS.size() + REMOVED.size() + 2;
+// Длина записи одного предмета: ,{"id":<id>,"type":<type>}
+constexpr size_t MAX_ITEM_LENGTH = 1 + ITEM_ID.size() + MAX_UINT32_LENGTH + ITEM_TYPE.size() + MAX_UINT32_LENGTH + 1;
+
+char DirectionLetter(model::Direction direction) noexcept {
+    switch (direction) {
+        case model::Direction::NORTH:
+            return 'U';
+        case model::Direction::SOUTH:
+            return 'D';
+        case model::Direction::WEST:
+            return 'L';
+        case model::Direction::EAST:
+            return 'R';
+    }
+    return 'U';
+}
+
+// Пишет в буфер, размер которого заранее достаточен, поэтому не проверяет границы
+class Writer {
+public:
+    explicit Writer(char* pos) noexcept
+        : pos_{pos} {
+    }
+
+    char* GetPos() const noexcept {
+        return pos_;
+    }
+
+    Writer& operator<<(std::string_view text) noexcept {
+        std::memcpy(pos_, text.data(), text.size());
+        pos_ += text.size();
+        return *this;
+    }
+
+    Writer& operator<<(char c) noexcept {
+        *pos_++ = c;
+        return *this;
+    }
+
+    Writer& operator<<(uint32_t value) noexcept {
+        pos_ = std::to_chars(pos_, pos_ + MAX_UINT32_LENGTH, value).ptr;
+        return *this;
+    }
+
+    Writer& operator<<(uint64_t value) noexcept {
+        pos_ = std::to_chars(pos_, pos_ + MAX_UINT64_LENGTH, value).ptr;
+        return *this;
+    }
+
+    Writer& operator<<(double value) noexcept {
+        pos_ = std::to_chars(pos_, pos_ + MAX_DOUBLE_LENGTH, value).ptr;
+        return *this;
+    }
+
+private:
+    char* pos_;
+};
+
+size_t GetDogSizeBound(const model::DogRegistry& dogs, size_t index) noexcept {
+    return MAX_DOG_LENGTH + dogs.GetProfile(index).bag.size() * MAX_ITEM_LENGTH;
+}
+
+// Пишет собаку index в виде "<id>":{...}, перед которой при необходимости ставит запятую
+void WriteDog(const model::DogRegistry& dogs, size_t index, bool first, Writer& writer) noexcept {
+    const auto& motion = dogs.GetMotion();
+    const auto& profile = dogs.GetProfile(index);
+    if (!first) {
+        writer << ',';
+    }
+    writer << '"' << *dogs.GetId(index) << POS << motion.x[index] << ',' << motion.y[index] << SPEED
+           << motion.speed_x[index] << ',' << motion.speed_y[index] << DIR
+           << DirectionLetter(motion.direction[index]) << BAG;
+    for (size_t j = 0; j < profile.bag.size(); ++j) {
+        if (j != 0) {
+            writer << ',';
+        }
+        writer << ITEM_ID << *profile.bag[j].id << ITEM_TYPE << uint32_t{profile.bag[j].type} << '}';
+    }
+    writer << SCORE << uint32_t{profile.score} << '}';
+}
+
+// Записывает изменения после тика since_tick. Если изменения уже забыты, возвращает false
+bool WriteDelta(const model::DogRegistry& dogs, std::uint64_t since_tick, std::string& out) {
+    size_t size = MAX_HEADER_LENGTH;
+    const bool known = dogs.ForEachChangeSince(
+        since_tick,
+        [&](size_t index) {
+            size += GetDogSizeBound(dogs, index);
+        },
+        [&](const model::Dog::Id&) {
+            size += MAX_UINT32_LENGTH + 1;
+        });
+    if (!known) {
+        return false;
+    }
+    out.resize(size);
+
+    Writer writer{out.data()};
+    writer << TICK << dogs.GetTick() << SINCE << since_tick << PLAYERS;
+    bool first = true;
+    dogs.ForEachChangeSince(
+        since_tick,
+        [&](size_t index) {
+            WriteDog(dogs, index, first, writer);
+            first = false;
+        },
+        [](const model::Dog::Id&) {});
+    writer << REMOVED;
+    first = true;
+    dogs.ForEachChangeSince(
+        since_tick, [](size_t) {},
+        [&](const model::Dog::Id& id) {
+            if (!first) {
+                writer << ',';
+            }
+            writer << *id;
+            first = false;
+        });
+    writer << "]}"sv;
+
+    out.resize(writer.GetPos() - out.data());
+    return true;
+}
+
+}  // namespace
+
+size_t GetGameStateSizeBound(const model::DogRegistry& dogs) noexcept {
+    size_t size = MAX_HEADER_LENGTH;
+    for (size_t i = 0; i < dogs.Size(); ++i) {
+        size += GetDogSizeBound(dogs, i);
+    }
+    return size;
+}
+
+void WriteGameState(const model::DogRegistry& dogs, std::string& out, std::optional<std::uint64_t> since_tick) {
+    if (since_tick && WriteDelta(dogs, *since_tick, out)) {
+        return;
+    }
+    out.resize(GetGameStateSizeBound(dogs));
+
+    Writer writer{out.data()};
+    writer << TICK << dogs.GetTick() << PLAYERS;
+    for (size_t i = 0; i < dogs.Size(); ++i) {
+        WriteDog(dogs, i, i == 0, writer);
+    }
+    writer << "}}"sv;
+
+    out.resize(writer.GetPos() - out.data());
+}
+
+}  // namespace app
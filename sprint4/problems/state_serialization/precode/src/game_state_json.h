@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "model.h"
+
+namespace app {
+
+/*
+ * Записывает состояние собак сеанса в out в формате ответа /api/v1/game/state:
+ *
+ *  {"tick":5,"players":{"<id>":{"pos":[x,y],"speed":[vx,vy],"dir":"U","bag":[{"id":1,"type":0}],"score":0}}}
+ *
+ * tick - номер последнего завершённого тика сеанса (DogRegistry::GetTick). Клиент передаёт его
+ * в следующем запросе как since_tick и получает только собак, изменившихся после этого тика,
+ * и номера удалённых собак:
+ *
+ *  {"tick":7,"since":5,"players":{...},"removed":[3,4]}
+ *
+ * Если клиент отстал больше чем на DogRegistry::CHANGE_HISTORY_TICKS тиков, записывается
+ * полное состояние без поля "since".
+ *
+ * Текст пишется прямо из столбцов DogRegistry в буфер, размер которого заранее вычисляется
+ * по числу собак и предметов в рюкзаках, поэтому запись выполняется за один проход
+ * и выделяет память не более одного раза. Числа форматируются std::to_chars: дробные -
+ * кратчайшей записью, при разборе которой получается то же значение.
+ * Прежнее содержимое out заменяется, а его ёмкость используется повторно, поэтому
+ * out можно передавать, например, как тело ответа http::string_body
+ */
+void WriteGameState(const model::DogRegistry& dogs, std::string& out,
+                    std::optional<std::uint64_t> since_tick = std::nullopt);
+
+// Верхняя граница длины полного состояния, которое запишет WriteGameState
+size_t GetGameStateSizeBound(const model::DogRegistry& dogs) noexcept;
+
+}  // namespace app
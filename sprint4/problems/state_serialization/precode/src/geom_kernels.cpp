@@ -0,0 +1,189 @@
+#include "geom_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GEOM_KERNELS_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GEOM_KERNELS_NEON 1
+#endif
+
+namespace geom {
+
+namespace {
+
+using MoveClampedFn = void (*)(double*, double*, const double*, const double*, double,
+                               size_t) noexcept;
+using MoveClampedFixedFn = void (*)(Fixed*, Fixed*, const Fixed*, const Fixed*, Fixed::Raw,
+                                    size_t) noexcept;
+
+// Векторные реализации читают столбцы Fixed как массивы 32-битных чисел
+static_assert(sizeof(Fixed) == sizeof(std::int32_t));
+
+// Скалярная реализация для хвостов массивов и процессоров без векторных расширений.
+// Умножение и сложение выполняются раздельно, как и в векторных реализациях
+void MoveClampedScalar(double* pos, double* speed, const double* lo, const double* hi,
+                       double dt, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const double moved = pos[i] + speed[i] * dt;
+        const double clamped = std::min(std::max(moved, lo[i]), hi[i]);
+        pos[i] = clamped;
+        if (clamped != moved) {
+            speed[i] = 0;
+        }
+    }
+}
+
+// Сдвигает pos на speed * step. От 64-битного произведения берутся биты с FRACTION_BITS
+// по FRACTION_BITS + 31, а сложение переполняется по модулю 2^32, как в векторных реализациях
+Fixed::Raw MoveRaw(Fixed::Raw pos, Fixed::Raw speed, Fixed::Raw step) noexcept {
+    const auto product = static_cast<std::uint64_t>(std::int64_t{speed} * step);
+    const auto delta = static_cast<std::uint32_t>(product >> Fixed::FRACTION_BITS);
+    return static_cast<Fixed::Raw>(static_cast<std::uint32_t>(pos) + delta);
+}
+
+void MoveClampedFixedScalar(Fixed* pos, Fixed* speed, const Fixed* lo, const Fixed* hi,
+                            Fixed::Raw step, size_t count) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const auto moved = MoveRaw(pos[i].GetRaw(), speed[i].GetRaw(), step);
+        const auto clamped = std::min(std::max(moved, lo[i].GetRaw()), hi[i].GetRaw());
+        pos[i] = Fixed::FromRaw(clamped);
+        if (clamped != moved) {
+            speed[i] = Fixed{};
+        }
+    }
+}
+
+#if defined(GEOM_KERNELS_AVX2)
+
+__attribute__((target("avx2"))) void MoveClampedAvx2(double* pos, double* speed,
+                                                     const double* lo, const double* hi,
+                                                     double dt, size_t count) noexcept {
+    const __m256d step = _mm256_set1_pd(dt);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d v = _mm256_loadu_pd(speed + i);
+        const __m256d moved = _mm256_add_pd(_mm256_loadu_pd(pos + i), _mm256_mul_pd(v, step));
+        const __m256d clamped = _mm256_min_pd(_mm256_max_pd(moved, _mm256_loadu_pd(lo + i)),
+                                              _mm256_loadu_pd(hi + i));
+        _mm256_storeu_pd(pos + i, clamped);
+        // Скорость сохраняется только там, где ограничивать не пришлось
+        const __m256d kept = _mm256_cmp_pd(clamped, moved, _CMP_EQ_OQ);
+        _mm256_storeu_pd(speed + i, _mm256_and_pd(v, kept));
+    }
+    MoveClampedScalar(pos + i, speed + i, lo + i, hi + i, dt, count - i);
+}
+
+__attribute__((target("avx2"))) void MoveClampedFixedAvx2(Fixed* pos, Fixed* speed,
+                                                          const Fixed* lo, const Fixed* hi,
+                                                          Fixed::Raw step, size_t count) noexcept {
+    auto* const pos_vec = reinterpret_cast<__m256i*>(pos);
+    auto* const speed_vec = reinterpret_cast<__m256i*>(speed);
+    const auto* const lo_vec = reinterpret_cast<const __m256i*>(lo);
+    const auto* const hi_vec = reinterpret_cast<const __m256i*>(hi);
+    const __m256i steps = _mm256_set1_epi32(step);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const size_t k = i / 8;
+        const __m256i v = _mm256_loadu_si256(speed_vec + k);
+        // _mm256_mul_epi32 перемножает чётные элементы в 64-битные произведения.
+        // Нужные 32 бита чётных произведений сдвигаются в младшую половину, нечётных - в старшую
+        const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(v, steps), Fixed::FRACTION_BITS);
+        const __m256i odd = _mm256_slli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(v, 32), steps),
+                                              32 - Fixed::FRACTION_BITS);
+        const __m256i delta = _mm256_blend_epi32(even, odd, 0b10101010);
+        const __m256i moved = _mm256_add_epi32(_mm256_loadu_si256(pos_vec + k), delta);
+        const __m256i clamped = _mm256_min_epi32(_mm256_max_epi32(moved, _mm256_loadu_si256(lo_vec + k)),
+                                                 _mm256_loadu_si256(hi_vec + k));
+        _mm256_storeu_si256(pos_vec + k, clamped);
+        const __m256i kept = _mm256_cmpeq_epi32(clamped, moved);
+        _mm256_storeu_si256(speed_vec + k, _mm256_and_si256(v, kept));
+    }
+    MoveClampedFixedScalar(pos + i, speed + i, lo + i, hi + i, step, count - i);
+}
+
+#elif defined(GEOM_KERNELS_NEON)
+
+void MoveClampedNeon(double* pos, double* speed, const double* lo, const double* hi, double dt,
+                     size_t count) noexcept {
+    const float64x2_t step = vdupq_n_f64(dt);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const float64x2_t v = vld1q_f64(speed + i);
+        const float64x2_t moved = vaddq_f64(vld1q_f64(pos + i), vmulq_f64(v, step));
+        const float64x2_t clamped =
+            vminq_f64(vmaxq_f64(moved, vld1q_f64(lo + i)), vld1q_f64(hi + i));
+        vst1q_f64(pos + i, clamped);
+        const uint64x2_t kept = vceqq_f64(clamped, moved);
+        vst1q_f64(speed + i, vbslq_f64(kept, v, vdupq_n_f64(0)));
+    }
+    MoveClampedScalar(pos + i, speed + i, lo + i, hi + i, dt, count - i);
+}
+
+void MoveClampedFixedNeon(Fixed* pos, Fixed* speed, const Fixed* lo, const Fixed* hi,
+                          Fixed::Raw step, size_t count) noexcept {
+    auto* const pos_raw = reinterpret_cast<std::int32_t*>(pos);
+    auto* const speed_raw = reinterpret_cast<std::int32_t*>(speed);
+    const auto* const lo_raw = reinterpret_cast<const std::int32_t*>(lo);
+    const auto* const hi_raw = reinterpret_cast<const std::int32_t*>(hi);
+    const int32x4_t steps = vdupq_n_s32(step);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int32x4_t v = vld1q_s32(speed_raw + i);
+        // vshrn берёт от 64-битных произведений биты с FRACTION_BITS по FRACTION_BITS + 31
+        const int32x4_t delta =
+            vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(v), vget_low_s32(steps)), Fixed::FRACTION_BITS),
+                         vshrn_n_s64(vmull_high_s32(v, steps), Fixed::FRACTION_BITS));
+        const int32x4_t moved = vaddq_s32(vld1q_s32(pos_raw + i), delta);
+        const int32x4_t clamped = vminq_s32(vmaxq_s32(moved, vld1q_s32(lo_raw + i)), vld1q_s32(hi_raw + i));
+        vst1q_s32(pos_raw + i, clamped);
+        const uint32x4_t kept = vceqq_s32(clamped, moved);
+        vst1q_s32(speed_raw + i, vbslq_s32(kept, v, vdupq_n_s32(0)));
+    }
+    MoveClampedFixedScalar(pos + i, speed + i, lo + i, hi + i, step, count - i);
+}
+
+#endif
+
+struct Kernels {
+    MoveClampedFn move_clamped;
+    MoveClampedFixedFn move_clamped_fixed;
+    const char* name;
+};
+
+Kernels SelectKernels() noexcept {
+#if defined(GEOM_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return {MoveClampedAvx2, MoveClampedFixedAvx2, "avx2"};
+    }
+#elif defined(GEOM_KERNELS_NEON)
+    return {MoveClampedNeon, MoveClampedFixedNeon, "neon"};
+#endif
+    return {MoveClampedScalar, MoveClampedFixedScalar, "scalar"};
+}
+
+const Kernels& GetKernels() noexcept {
+    static const Kernels kernels = SelectKernels();
+    return kernels;
+}
+
+}  // namespace
+
+void MoveClamped(double* pos, double* speed, const double* lo, const double* hi, double dt,
+                 size_t count) noexcept {
+    GetKernels().move_clamped(pos, speed, lo, hi, dt, count);
+}
+
+void MoveClamped(Fixed* pos, Fixed* speed, const Fixed* lo, const Fixed* hi, double dt,
+                 size_t count) noexcept {
+    GetKernels().move_clamped_fixed(pos, speed, lo, hi, Fixed{dt}.GetRaw(), count);
+}
+
+const char* GetKernelsName() noexcept {
+    return GetKernels().name;
+}
+
+}  // namespace geom
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+
+#include "geom.h"
+
+namespace geom {
+
+/*
+ * Векторные операции над координатами, хранящимися по столбцам.
+ * Реализация выбирается при первом вызове по возможностям процессора: AVX2 на x86-64,
+ * NEON на AArch64, иначе скалярный цикл. Все реализации выполняют одни и те же
+ * операции в том же порядке, без слияния умножения и сложения в FMA на x86-64.
+ */
+
+// Для каждого i перемещает pos[i] на speed[i] * dt и ограничивает отрезком [lo[i], hi[i]].
+// Если pos[i] пришлось ограничить, обнуляет speed[i]
+void MoveClamped(double* pos, double* speed, const double* lo, const double* hi, double dt,
+                 size_t count) noexcept;
+
+// То же для координат с фиксированной точкой. Смещение speed[i] * dt округляется вниз
+// до шага Fixed. Векторные реализации обрабатывают вдвое больше элементов за операцию,
+// а результат не зависит от выбранной реализации
+void MoveClamped(Fixed* pos, Fixed* speed, const Fixed* lo, const Fixed* hi, double dt,
+                 size_t count) noexcept;
+
+// Название выбранной реализации, например для журнала запуска
+const char* GetKernelsName() noexcept;
+
+}  // namespace geom
@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace util {
+
+/*
+ * Последовательность не более чем из Capacity элементов, хранящихся внутри объекта.
+ * В отличие от std::vector не выделяет динамическую память, поэтому копирование
+ * объекта, содержащего InlineVector, сводится к копированию его байтов.
+ * Элементы за пределами size() сконструированы по умолчанию
+ */
+template <typename T, size_t Capacity>
+class InlineVector {
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr static size_t CAPACITY = Capacity;
+
+    InlineVector() = default;
+
+    // Выбрасывает std::length_error, если элементов больше Capacity
+    InlineVector(std::initializer_list<T> items) {
+        if (items.size() > Capacity) {
+            throw std::length_error("Too many items for InlineVector");
+        }
+        std::copy(items.begin(), items.end(), items_.begin());
+        size_ = items.size();
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr static size_t capacity() noexcept {
+        return Capacity;
+    }
+
+    // Добавляет элемент. Вызывающий проверяет, что место есть
+    void push_back(const T& item) noexcept {
+        assert(size_ < Capacity);
+        items_[size_++] = item;
+    }
+
+    void clear() noexcept {
+        std::fill_n(items_.begin(), size_, T{});
+        size_ = 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return items_[index];
+    }
+
+    T* data() noexcept {
+        return items_.data();
+    }
+
+    const T* data() const noexcept {
+        return items_.data();
+    }
+
+    iterator begin() noexcept {
+        return items_.data();
+    }
+
+    iterator end() noexcept {
+        return items_.data() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return items_.data();
+    }
+
+    const_iterator end() const noexcept {
+        return items_.data() + size_;
+    }
+
+    bool operator==(const InlineVector& other) const noexcept {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+private:
+    std::array<T, Capacity> items_{};
+    size_t size_ = 0;
+};
+
+}  // namespace util
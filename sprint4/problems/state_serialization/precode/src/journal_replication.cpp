@@ -0,0 +1,381 @@
+#include "journal_replication.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <cstring>
+#include <stdexcept>
+
+namespace serialization {
+
+using namespace std::literals;
+
+namespace {
+
+// Вид кадра, которым основной узел сообщает, что он работает, когда записей нет
+constexpr std::uint8_t HEARTBEAT = 2;
+// Заголовок кадра: kind, sequence и sent_at
+constexpr size_t FRAME_HEADER_SIZE = sizeof(std::uint8_t) + sizeof(std::uint64_t) + sizeof(std::int64_t);
+// Кадры большего размера считаются повреждёнными
+constexpr std::uint32_t MAX_FRAME_SIZE = 256 * 1024 * 1024;
+
+std::int64_t GetSystemTimeMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T Get(std::string_view& data) {
+    T value;
+    std::memcpy(&value, data.data(), sizeof(T));
+    data.remove_prefix(sizeof(T));
+    return value;
+}
+
+}  // namespace
+
+JournalShipper::JournalShipper(net::io_context& ioc, tcp::endpoint follower,
+                               std::function<void()> request_checkpoint,
+                               std::uint64_t max_buffered_bytes)
+    : strand_{net::make_strand(ioc)}
+    , socket_{strand_}
+    , reconnect_timer_{strand_}
+    , heartbeat_timer_{strand_}
+    , follower_{std::move(follower)}
+    , request_checkpoint_{std::move(request_checkpoint)}
+    , max_buffered_bytes_{max_buffered_bytes} {
+    net::dispatch(strand_, [this] {
+        Connect();
+    });
+}
+
+void JournalShipper::Ship(JournalRecord kind, std::string_view payload) {
+    // Пока резервный узел недоступен, записи ему не нужны: после подключения
+    // он всё равно начнёт с контрольной точки
+    if (!status_connected_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    net::post(strand_, [this, kind, payload = std::string{payload}] {
+        Enqueue(static_cast<std::uint8_t>(kind), payload);
+    });
+}
+
+void JournalShipper::Stop() {
+    net::dispatch(strand_, [this] {
+        stopped_ = true;
+        reconnect_timer_.cancel();
+        Disconnect();
+    });
+}
+
+ShipperStatus JournalShipper::GetStatus() const noexcept {
+    return {.connected = status_connected_.load(std::memory_order_relaxed),
+            .shipped = shipped_.load(std::memory_order_relaxed),
+            .acknowledged = acknowledged_.load(std::memory_order_relaxed),
+            .buffered_bytes = buffered_bytes_.load(std::memory_order_relaxed),
+            .resyncs = resyncs_.load(std::memory_order_relaxed)};
+}
+
+void JournalShipper::Connect() {
+    if (stopped_) {
+        return;
+    }
+    socket_.async_connect(follower_, [this, connection = connection_](sys::error_code ec) {
+        if (connection == connection_) {
+            OnConnect(ec);
+        }
+    });
+}
+
+void JournalShipper::OnConnect(sys::error_code ec) {
+    if (ec) {
+        return Disconnect();
+    }
+    sys::error_code ignored;
+    socket_.set_option(tcp::no_delay{true}, ignored);
+    connected_ = true;
+    status_connected_.store(true, std::memory_order_relaxed);
+    ReadAck();
+    ScheduleHeartbeat();
+    // Резервный узел начинает с полного состояния сеанса
+    request_checkpoint_();
+}
+
+void JournalShipper::Enqueue(std::uint8_t kind, std::string_view payload) {
+    if (!connected_) {
+        return;
+    }
+    if (kind == static_cast<std::uint8_t>(JournalRecord::CHECKPOINT)) {
+        // Контрольная точка заменяет все события, ещё не отправленные до неё
+        queue_.clear();
+        synced_ = true;
+    } else if (kind == static_cast<std::uint8_t>(JournalRecord::EVENTS)) {
+        if (!synced_) {
+            return;
+        }
+        if (queue_.size() + payload.size() > max_buffered_bytes_) {
+            // Резервный узел отстал слишком сильно. Вместо накопления событий
+            // он получит следующую контрольную точку
+            queue_.clear();
+            synced_ = false;
+            resyncs_.fetch_add(1, std::memory_order_relaxed);
+            buffered_bytes_.store(sending_.size(), std::memory_order_relaxed);
+            request_checkpoint_();
+            return;
+        }
+    }
+
+    const auto sequence = next_sequence_++;
+    frame_.clear();
+    Put(frame_, kind);
+    Put(frame_, sequence);
+    Put(frame_, GetSystemTimeMs());
+    frame_.append(payload);
+    AppendRecord(queue_, frame_);
+    shipped_.store(sequence, std::memory_order_relaxed);
+    buffered_bytes_.store(queue_.size() + sending_.size(), std::memory_order_relaxed);
+    Write();
+}
+
+void JournalShipper::Write() {
+    if (writing_ || queue_.empty() || !connected_) {
+        return;
+    }
+    // Все накопившиеся кадры уходят одной записью
+    std::swap(sending_, queue_);
+    queue_.clear();
+    writing_ = true;
+    net::async_write(socket_, net::buffer(sending_),
+                     [this, connection = connection_](sys::error_code ec, std::size_t) {
+                         if (connection != connection_) {
+                             return;
+                         }
+                         writing_ = false;
+                         if (ec) {
+                             return Disconnect();
+                         }
+                         sending_.clear();
+                         buffered_bytes_.store(queue_.size(), std::memory_order_relaxed);
+                         Write();
+                     });
+}
+
+void JournalShipper::ReadAck() {
+    net::async_read(socket_, net::buffer(ack_buffer_),
+                    [this, connection = connection_](sys::error_code ec, std::size_t) {
+                        if (connection != connection_) {
+                            return;
+                        }
+                        if (ec) {
+                            return Disconnect();
+                        }
+                        std::uint64_t acknowledged = 0;
+                        std::memcpy(&acknowledged, ack_buffer_.data(), sizeof(acknowledged));
+                        acknowledged_.store(acknowledged, std::memory_order_relaxed);
+                        ReadAck();
+                    });
+}
+
+void JournalShipper::ScheduleHeartbeat() {
+    heartbeat_timer_.expires_after(HEARTBEAT_INTERVAL);
+    heartbeat_timer_.async_wait([this, connection = connection_](sys::error_code ec) {
+        if (ec || connection != connection_) {
+            return;
+        }
+        Enqueue(HEARTBEAT, {});
+        ScheduleHeartbeat();
+    });
+}
+
+void JournalShipper::Disconnect() {
+    ++connection_;
+    connected_ = false;
+    status_connected_.store(false, std::memory_order_relaxed);
+    synced_ = false;
+    writing_ = false;
+    queue_.clear();
+    sending_.clear();
+    buffered_bytes_.store(0, std::memory_order_relaxed);
+    sys::error_code ignored;
+    socket_.close(ignored);
+    heartbeat_timer_.cancel();
+    if (stopped_) {
+        return;
+    }
+    reconnect_timer_.expires_after(RECONNECT_DELAY);
+    reconnect_timer_.async_wait([this](sys::error_code ec) {
+        if (!ec) {
+            Connect();
+        }
+    });
+}
+
+JournalFollower::JournalFollower(Strand strand, const tcp::endpoint& endpoint,
+                                 model::GameSession& session, std::filesystem::path journal_path)
+    : strand_{std::move(strand)}
+    , acceptor_{strand_, endpoint}
+    , session_{session}
+    , journal_path_{std::move(journal_path)}
+    , last_frame_at_{Clock::now().time_since_epoch().count()} {
+    net::dispatch(strand_, [this] {
+        Accept();
+    });
+}
+
+tcp::endpoint JournalFollower::GetEndpoint() const {
+    return acceptor_.local_endpoint();
+}
+
+void JournalFollower::Promote(PromoteHandler handler) {
+    net::dispatch(strand_, [this, handler = std::move(handler)] {
+        promoted_ = true;
+        sys::error_code ignored;
+        acceptor_.close(ignored);
+        CloseConnection();
+        ready_.store(false, std::memory_order_relaxed);
+        handler(std::move(journal_));
+    });
+}
+
+FollowerStatus JournalFollower::GetStatus() const noexcept {
+    const Clock::time_point last_frame_at{
+        Clock::duration{last_frame_at_.load(std::memory_order_relaxed)}};
+    return {.connected = status_connected_.load(std::memory_order_relaxed),
+            .ready = ready_.load(std::memory_order_relaxed),
+            .applied = applied_.load(std::memory_order_relaxed),
+            .lag = std::chrono::milliseconds{lag_ms_.load(std::memory_order_relaxed)},
+            .silence = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now()
+                                                                             - last_frame_at)};
+}
+
+void JournalFollower::Accept() {
+    acceptor_.async_accept(strand_, [this](sys::error_code ec, tcp::socket socket) {
+        if (promoted_ || ec == net::error::operation_aborted) {
+            return;
+        }
+        if (!ec) {
+            // Основной узел переподключился: прежнее соединение больше не нужно.
+            // Новое соединение начнётся с контрольной точки
+            CloseConnection();
+            sys::error_code ignored;
+            socket.set_option(tcp::no_delay{true}, ignored);
+            socket_.emplace(std::move(socket));
+            status_connected_.store(true, std::memory_order_relaxed);
+            ReadHeader();
+        }
+        Accept();
+    });
+}
+
+void JournalFollower::ReadHeader() {
+    net::async_read(*socket_, net::buffer(&header_, sizeof(header_)),
+                    [this, connection = connection_](sys::error_code ec, std::size_t) {
+                        if (connection != connection_) {
+                            return;
+                        }
+                        if (ec || header_.size < FRAME_HEADER_SIZE || header_.size > MAX_FRAME_SIZE) {
+                            return CloseConnection();
+                        }
+                        ReadPayload();
+                    });
+}
+
+void JournalFollower::ReadPayload() {
+    // Буфер сохраняет выделенную память между кадрами
+    payload_.resize(header_.size);
+    net::async_read(*socket_, net::buffer(payload_),
+                    [this, connection = connection_](sys::error_code ec, std::size_t) {
+                        if (connection != connection_) {
+                            return;
+                        }
+                        if (ec || Checksum(payload_) != header_.crc) {
+                            return CloseConnection();
+                        }
+                        try {
+                            Apply();
+                        } catch (const std::exception&) {
+                            // Копия сеанса могла измениться частично. Она станет пригодной
+                            // после контрольной точки, с которой начнётся новое соединение
+                            journal_.reset();
+                            ready_.store(false, std::memory_order_relaxed);
+                            return CloseConnection();
+                        }
+                        WriteAck();
+                        ReadHeader();
+                    });
+}
+
+void JournalFollower::Apply() {
+    std::string_view data = payload_;
+    const auto kind = Get<std::uint8_t>(data);
+    const auto sequence = Get<std::uint64_t>(data);
+    const auto sent_at = Get<std::int64_t>(data);
+
+    if (kind == static_cast<std::uint8_t>(JournalRecord::CHECKPOINT)) {
+        RestoreCheckpoint(data, session_);
+        if (journal_) {
+            journal_->Checkpoint(session_);
+        } else {
+            journal_ = std::make_unique<EventJournal>(journal_path_, session_);
+        }
+        ready_.store(true, std::memory_order_relaxed);
+    } else if (kind == static_cast<std::uint8_t>(JournalRecord::EVENTS)) {
+        if (!journal_) {
+            throw std::runtime_error("Journal events before checkpoint"s);
+        }
+        ForEachEvent(data, [this](const GameEvent& event) {
+            ApplyEvent(session_, event);
+            journal_->Append(event);
+        });
+    } else if (kind != HEARTBEAT) {
+        throw std::runtime_error("Unknown journal frame "s + std::to_string(kind));
+    }
+
+    applied_.store(sequence, std::memory_order_relaxed);
+    lag_ms_.store(std::max<std::int64_t>(0, GetSystemTimeMs() - sent_at), std::memory_order_relaxed);
+    last_frame_at_.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void JournalFollower::WriteAck() {
+    const auto applied = applied_.load(std::memory_order_relaxed);
+    if (writing_ack_ || acked_ == applied) {
+        return;
+    }
+    // Подтверждается только последний применённый кадр, поэтому подтверждения
+    // кадров, применённых во время записи, объединяются
+    acked_ = applied;
+    std::memcpy(ack_buffer_.data(), &acked_, sizeof(acked_));
+    writing_ack_ = true;
+    net::async_write(*socket_, net::buffer(ack_buffer_),
+                     [this, connection = connection_](sys::error_code ec, std::size_t) {
+                         if (connection != connection_) {
+                             return;
+                         }
+                         writing_ack_ = false;
+                         if (ec) {
+                             return CloseConnection();
+                         }
+                         WriteAck();
+                     });
+}
+
+void JournalFollower::CloseConnection() {
+    ++connection_;
+    if (socket_) {
+        sys::error_code ignored;
+        socket_->close(ignored);
+        socket_.reset();
+    }
+    status_connected_.store(false, std::memory_order_relaxed);
+    writing_ack_ = false;
+    acked_ = 0;
+}
+
+}  // namespace serialization
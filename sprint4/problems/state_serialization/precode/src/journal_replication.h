@@ -0,0 +1,208 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "event_journal.h"
+
+namespace serialization {
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+using tcp = net::ip::tcp;
+
+/*
+ * Передача журнала событий сеанса на резервный узел (горячий резерв).
+ * Основной узел передаёт JournalShipper'у записи своего журнала (EventJournal::Observer),
+ * а резервный узел применяет их к своей копии сеанса в JournalFollower и ведёт собственный
+ * журнал. Записи уходят после того, как попали на носитель основного узла, и передаются
+ * в потоке io_context, поэтому тик основного узла не ждёт ни сети, ни резервного узла.
+ *
+ * По соединению передаются кадры в формате записей журнала (AppendRecord):
+ *  u8 kind | u64 sequence | i64 sent_at | содержимое
+ * где kind - JournalRecord или HEARTBEAT, sequence - номер кадра, а sent_at - время отправки
+ * по системным часам основного узла в миллисекундах. В ответ резервный узел передаёт
+ * номер последнего применённого кадра (u64), по которому основной узел оценивает отставание.
+ * Числа передаются в порядке байтов платформы, как и в журнале
+ */
+
+// Состояние передачи на основном узле
+struct ShipperStatus {
+    bool connected = false;
+    // Номер последнего отправленного и последнего применённого резервным узлом кадра
+    std::uint64_t shipped = 0;
+    std::uint64_t acknowledged = 0;
+    // Объём записей, ожидающих отправки
+    std::uint64_t buffered_bytes = 0;
+    // Сколько раз отставание превысило предел и передача начиналась заново
+    std::uint64_t resyncs = 0;
+};
+
+/*
+ * Отправляет записи журнала резервному узлу, переподключаясь при обрыве соединения.
+ * После подключения и после переполнения буфера резервному узлу сначала нужно полное
+ * состояние сеанса, поэтому события отбрасываются до ближайшей контрольной точки,
+ * а обработчик request_checkpoint просит её у владельца сеанса: например, вызывает
+ * EventJournal::Checkpoint в strand сеанса. Обработчик вызывается в потоке io_context.
+ *
+ * Буфер неотправленных записей ограничен max_buffered_bytes, поэтому медленный или
+ * недоступный резервный узел не расходует память основного без предела.
+ *
+ * Ship можно вызывать из любого потока. Журнал, передающий записи, должен быть уничтожен
+ * раньше JournalShipper, а JournalShipper должен существовать, пока работает io_context
+ */
+class JournalShipper {
+public:
+    constexpr static std::uint64_t DEFAULT_MAX_BUFFERED_BYTES = 64 * 1024 * 1024;
+    constexpr static std::chrono::milliseconds HEARTBEAT_INTERVAL{500};
+    constexpr static std::chrono::milliseconds RECONNECT_DELAY{1000};
+
+    JournalShipper(net::io_context& ioc, tcp::endpoint follower,
+                   std::function<void()> request_checkpoint,
+                   std::uint64_t max_buffered_bytes = DEFAULT_MAX_BUFFERED_BYTES);
+
+    JournalShipper(const JournalShipper&) = delete;
+    JournalShipper& operator=(const JournalShipper&) = delete;
+
+    // Ставит запись журнала в очередь отправки. Подходит в качестве EventJournal::Observer
+    void Ship(JournalRecord kind, std::string_view payload);
+
+    // Закрывает соединение и прекращает переподключение. Может быть вызван из любого потока
+    void Stop();
+
+    ShipperStatus GetStatus() const noexcept;
+
+private:
+    void Connect();
+    void OnConnect(sys::error_code ec);
+    void Enqueue(std::uint8_t kind, std::string_view payload);
+    void Write();
+    void ReadAck();
+    void ScheduleHeartbeat();
+    void Disconnect();
+
+    net::strand<net::io_context::executor_type> strand_;
+    tcp::socket socket_;
+    net::steady_timer reconnect_timer_;
+    net::steady_timer heartbeat_timer_;
+    tcp::endpoint follower_;
+    std::function<void()> request_checkpoint_;
+    std::uint64_t max_buffered_bytes_;
+
+    // Поля ниже используются только в strand_
+    bool connected_ = false;
+    bool stopped_ = false;
+    // Резервный узел получил контрольную точку, и ему можно отправлять события
+    bool synced_ = false;
+    bool writing_ = false;
+    // Номер текущего соединения. Обработчики операций прежних соединений ничего не делают
+    std::uint64_t connection_ = 0;
+    // Кадры, ожидающие отправки, и кадры, отправляемые сейчас. Буферы используются повторно
+    std::string queue_;
+    std::string sending_;
+    std::string frame_;
+    std::array<char, sizeof(std::uint64_t)> ack_buffer_{};
+    std::uint64_t next_sequence_ = 1;
+
+    std::atomic<bool> status_connected_{false};
+    std::atomic<std::uint64_t> shipped_{0};
+    std::atomic<std::uint64_t> acknowledged_{0};
+    std::atomic<std::uint64_t> buffered_bytes_{0};
+    std::atomic<std::uint64_t> resyncs_{0};
+};
+
+// Состояние резервного узла
+struct FollowerStatus {
+    bool connected = false;
+    // Получена контрольная точка, и копия сеанса готова к повышению до основной
+    bool ready = false;
+    std::uint64_t applied = 0;
+    // Насколько применённое состояние отстаёт от основного узла по времени отправки
+    // последнего кадра. Зависит от расхождения часов узлов
+    std::chrono::milliseconds lag{0};
+    // Сколько прошло с получения последнего кадра. Основной узел присылает кадры не реже
+    // HEARTBEAT_INTERVAL, поэтому большое значение означает, что основной узел недоступен
+    std::chrono::milliseconds silence{0};
+};
+
+/*
+ * Резервный узел: принимает соединение основного узла, применяет полученные записи
+ * к своей копии сеанса и записывает их в собственный журнал journal_path.
+ * Копия сеанса изменяется только в strand, переданном в конструктор (обычно strand сеанса),
+ * и в нём же должны выполняться остальные обращения к сеансу.
+ *
+ * Promote прекращает приём записей и передаёт обработчику журнал резервного узла.
+ * Копия сеанса уже совпадает с последним применённым состоянием основного узла,
+ * а журнал уже содержит его, поэтому сеанс сразу продолжает работу как основной:
+ * тики запускаются, а события дописываются в тот же журнал.
+ *
+ * Объект должен существовать, пока работает io_context
+ */
+class JournalFollower {
+public:
+    using Strand = net::strand<net::io_context::executor_type>;
+    // Получает журнал резервного узла либо nullptr, если контрольная точка ещё не получена
+    using PromoteHandler = std::function<void(std::unique_ptr<EventJournal> journal)>;
+
+    JournalFollower(Strand strand, const tcp::endpoint& endpoint, model::GameSession& session,
+                    std::filesystem::path journal_path);
+
+    JournalFollower(const JournalFollower&) = delete;
+    JournalFollower& operator=(const JournalFollower&) = delete;
+
+    // Адрес, на котором резервный узел принимает соединение
+    tcp::endpoint GetEndpoint() const;
+
+    // Прекращает репликацию и вызывает handler в strand сеанса. Может быть вызван
+    // из любого потока
+    void Promote(PromoteHandler handler);
+
+    FollowerStatus GetStatus() const noexcept;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Accept();
+    void ReadHeader();
+    void ReadPayload();
+    // Применяет принятый кадр. Если кадр повреждён, выбрасывает std::runtime_error
+    void Apply();
+    void WriteAck();
+    void CloseConnection();
+
+    Strand strand_;
+    tcp::acceptor acceptor_;
+    std::optional<tcp::socket> socket_;
+    model::GameSession& session_;
+    std::filesystem::path journal_path_;
+    std::unique_ptr<EventJournal> journal_;
+
+    // Поля ниже используются только в strand_
+    bool promoted_ = false;
+    // Номер текущего соединения. Обработчики операций прежних соединений ничего не делают
+    std::uint64_t connection_ = 0;
+    RecordHeader header_{};
+    std::string payload_;
+    bool writing_ack_ = false;
+    std::uint64_t acked_ = 0;
+    std::array<char, sizeof(std::uint64_t)> ack_buffer_{};
+
+    std::atomic<bool> status_connected_{false};
+    std::atomic<bool> ready_{false};
+    std::atomic<std::uint64_t> applied_{0};
+    std::atomic<std::int64_t> lag_ms_{0};
+    std::atomic<Clock::rep> last_frame_at_{0};
+};
+
+}  // namespace serialization
@@ -0,0 +1,139 @@
+#include "leaderboard.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <stdexcept>
+
+namespace app {
+
+using namespace std::literals;
+
+namespace {
+
+void AppendNumber(std::string& out, auto value) {
+    std::array<char, 32> buffer;
+    const auto end = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr;
+    out.append(buffer.data(), end);
+}
+
+void AppendJsonString(std::string& out, std::string_view text) {
+    constexpr auto HEX_DIGITS = "0123456789abcdef"sv;
+    out += '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += "\\u00"sv;
+            out += HEX_DIGITS[(c >> 4) & 0xF];
+            out += HEX_DIGITS[c & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Курсор - очки, время игры в миллисекундах и id последней записи страницы через точку
+std::string FormatCursor(const RecordKey& key) {
+    std::string cursor;
+    AppendNumber(cursor, key.score);
+    cursor += '.';
+    AppendNumber(cursor, key.play_time.count());
+    cursor += '.';
+    AppendNumber(cursor, key.id);
+    return cursor;
+}
+
+std::optional<RecordKey> ParseCursor(std::string_view cursor) {
+    RecordKey key;
+    model::TimeInterval::rep play_time = 0;
+    const char* pos = cursor.data();
+    const char* const end = cursor.data() + cursor.size();
+    const auto parse = [&](auto& value, bool last) {
+        const auto [ptr, ec] = std::from_chars(pos, end, value);
+        if (ec != std::errc{} || (last ? ptr != end : ptr == end || *ptr != '.')) {
+            return false;
+        }
+        pos = last ? ptr : ptr + 1;
+        return true;
+    };
+    if (!parse(key.score, false) || !parse(play_time, false) || !parse(key.id, true) || play_time < 0) {
+        return std::nullopt;
+    }
+    key.play_time = model::TimeInterval{play_time};
+    return key;
+}
+
+// Записывает страницу из count первых записей records
+std::shared_ptr<const std::string> MakePage(const std::vector<PlayerRecord>& records, size_t count) {
+    count = std::min(count, records.size());
+    std::string page;
+    page.reserve(32 + count * 64);
+    page += R"({"records":[)"sv;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& record = records[i];
+        page += i == 0 ? R"({"name":)"sv : R"(,{"name":)"sv;
+        AppendJsonString(page, record.name);
+        page += R"(,"score":)"sv;
+        AppendNumber(page, record.score);
+        page += R"(,"playTime":)"sv;
+        AppendNumber(page, std::chrono::duration<double>(record.play_time).count());
+        page += '}';
+    }
+    page += ']';
+    if (records.size() > count && count > 0) {
+        page += R"(,"next":)"sv;
+        AppendJsonString(page, FormatCursor(RecordKey::Of(records[count - 1])));
+    }
+    page += '}';
+    return std::make_shared<const std::string>(std::move(page));
+}
+
+}  // namespace
+
+Leaderboard::Leaderboard(RecordsRepository& repository, std::chrono::milliseconds first_page_ttl)
+    : repository_{repository}
+    , first_page_ttl_{first_page_ttl} {
+}
+
+std::shared_ptr<const std::string> Leaderboard::GetPage(std::string_view cursor, size_t max_items) {
+    if (max_items == 0 || max_items > MAX_PAGE_SIZE) {
+        throw std::invalid_argument("Page size must be from 1 to "s + std::to_string(MAX_PAGE_SIZE));
+    }
+    if (cursor.empty()) {
+        const auto first_page = GetFirstPage();
+        return max_items == MAX_PAGE_SIZE ? first_page->full_page : MakePage(first_page->records, max_items);
+    }
+    const auto after = ParseCursor(cursor);
+    if (!after) {
+        throw std::invalid_argument("Invalid page cursor");
+    }
+    // Лишняя запись показывает, есть ли следующая страница
+    return MakePage(repository_.GetRecords(after, max_items + 1), max_items);
+}
+
+std::shared_ptr<const Leaderboard::FirstPage> Leaderboard::GetFirstPage() {
+    const auto find_fresh = [this] {
+        std::lock_guard lk{mutex_};
+        return first_page_ && Clock::now() < first_page_->expires_at ? first_page_ : nullptr;
+    };
+    if (auto page = find_fresh()) {
+        return page;
+    }
+    // Страницу из базы запрашивает один поток, остальные дожидаются его результата
+    std::lock_guard refresh_lk{refresh_mutex_};
+    if (auto page = find_fresh()) {
+        return page;
+    }
+    auto records = repository_.GetRecords(std::nullopt, MAX_PAGE_SIZE + 1);
+    auto full_page = MakePage(records, MAX_PAGE_SIZE);
+    auto page = std::make_shared<const FirstPage>(
+        FirstPage{std::move(records), std::move(full_page), Clock::now() + first_page_ttl_});
+    std::lock_guard lk{mutex_};
+    first_page_ = page;
+    return page;
+}
+
+}  // namespace app
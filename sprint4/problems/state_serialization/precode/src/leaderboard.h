@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "model.h"
+
+namespace app {
+
+// Запись таблицы рекордов
+struct PlayerRecord {
+    std::uint64_t id = 0;
+    std::string name;
+    model::Score score = 0;
+    model::TimeInterval play_time{};
+};
+
+// Положение записи в таблице рекордов. Записи упорядочены по убыванию очков,
+// затем по возрастанию времени игры, затем по возрастанию id
+struct RecordKey {
+    model::Score score = 0;
+    model::TimeInterval play_time{};
+    std::uint64_t id = 0;
+
+    static RecordKey Of(const PlayerRecord& record) noexcept {
+        return {record.score, record.play_time, record.id};
+    }
+};
+
+class RecordsRepository {
+public:
+    // Возвращает не больше limit записей, следующих в порядке таблицы за записью after,
+    // или первые записи таблицы
+    virtual std::vector<PlayerRecord> GetRecords(const std::optional<RecordKey>& after, size_t limit) = 0;
+
+protected:
+    ~RecordsRepository() = default;
+};
+
+/*
+ * Таблица рекордов для ответа /api/v1/game/records:
+ *
+ *  {"records":[{"name":"Rex","score":42,"playTime":12.5}],"next":"42.12500.7"}
+ *
+ * Страницы выдаются по курсору: "next" - непрозрачная строка, которую клиент передаёт
+ * за следующей страницей. Курсор задаёт положение последней записи страницы, поэтому
+ * база находит начало страницы поиском в индексе, а не пропуском предыдущих записей,
+ * и страница не смещается, когда в таблицу добавляются игроки. На последней странице
+ * поля "next" нет.
+ * Почти все запросы приходятся на первую страницу. Её записи хранятся в памяти
+ * first_page_ttl и запрашиваются из базы не чаще раза за этот срок: одновременные запросы
+ * с истёкшим сроком дожидаются одного обращения к базе.
+ * Методы класса можно вызывать из разных потоков
+ */
+class Leaderboard {
+public:
+    constexpr static size_t MAX_PAGE_SIZE = 100;
+    constexpr static std::chrono::milliseconds DEFAULT_FIRST_PAGE_TTL{1000};
+
+    // Хранилище должно существовать дольше Leaderboard
+    explicit Leaderboard(RecordsRepository& repository,
+                         std::chrono::milliseconds first_page_ttl = DEFAULT_FIRST_PAGE_TTL);
+
+    Leaderboard(const Leaderboard&) = delete;
+    Leaderboard& operator=(const Leaderboard&) = delete;
+
+    // Возвращает JSON страницы из не более чем max_items записей, начиная за курсором cursor.
+    // Пустой курсор означает первую страницу. Если курсор некорректен или max_items
+    // не лежит в пределах от 1 до MAX_PAGE_SIZE, выбрасывает std::invalid_argument
+    std::shared_ptr<const std::string> GetPage(std::string_view cursor, size_t max_items = MAX_PAGE_SIZE);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct FirstPage {
+        // Не больше MAX_PAGE_SIZE + 1 записей: лишняя показывает, есть ли следующая страница
+        std::vector<PlayerRecord> records;
+        // JSON первой страницы из MAX_PAGE_SIZE записей
+        std::shared_ptr<const std::string> full_page;
+        Clock::time_point expires_at;
+    };
+
+    std::shared_ptr<const FirstPage> GetFirstPage();
+
+    RecordsRepository& repository_;
+    std::chrono::milliseconds first_page_ttl_;
+
+    std::mutex mutex_;
+    std::shared_ptr<const FirstPage> first_page_;
+    // Удерживается на время обновления первой страницы из базы
+    std::mutex refresh_mutex_;
+};
+
+}  // namespace app
@@ -0,0 +1,100 @@
+#include "leaderboard_writer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace app {
+
+LeaderboardWriter::LeaderboardWriter(RetiredPlayerRepository& repository,
+                                     std::chrono::milliseconds flush_interval)
+    : repository_{repository}
+    , flush_interval_{flush_interval}
+    , worker_{[this](std::stop_token stop) {
+        Run(stop);
+    }} {
+}
+
+LeaderboardWriter::~LeaderboardWriter() {
+    // Поток записывает остаток очереди и завершается, деструктор jthread дожидается его
+    worker_.request_stop();
+}
+
+void LeaderboardWriter::Add(std::vector<model::RetiredDog> players) {
+    if (players.empty()) {
+        return;
+    }
+    {
+        std::lock_guard lk{mutex_};
+        pending_.insert(pending_.end(), std::make_move_iterator(players.begin()),
+                        std::make_move_iterator(players.end()));
+    }
+    cv_.notify_all();
+}
+
+void LeaderboardWriter::Flush() {
+    std::unique_lock lk{mutex_};
+    error_ = nullptr;
+    flush_requested_ = true;
+    cv_.notify_all();
+    cv_.wait(lk, [this] {
+        return (pending_.empty() && !writing_) || error_;
+    });
+    flush_requested_ = false;
+    if (auto error = std::exchange(error_, nullptr)) {
+        std::rethrow_exception(error);
+    }
+}
+
+void LeaderboardWriter::Run(std::stop_token stop) {
+    std::unique_lock lk{mutex_};
+    while (cv_.wait(lk, stop, [this] {
+        return !pending_.empty();
+    })) {
+        // Ждём, пока наберётся полный пакет, но не дольше интервала
+        cv_.wait_for(lk, stop, flush_interval_, [this] {
+            return pending_.size() >= MAX_BATCH_SIZE || flush_requested_;
+        });
+        if (stop.stop_requested()) {
+            break;
+        }
+        if (!WriteBatch(lk)) {
+            // Повторяем запись не раньше чем через интервал, чтобы не нагружать недоступную базу
+            cv_.wait_for(lk, stop, flush_interval_, [] {
+                return false;
+            });
+        }
+    }
+    // При остановке остаток очереди записывается без повторных попыток
+    while (!pending_.empty() && WriteBatch(lk)) {
+    }
+}
+
+bool LeaderboardWriter::WriteBatch(std::unique_lock<std::mutex>& lk) {
+    const auto batch_end = pending_.begin() + static_cast<std::ptrdiff_t>(std::min(pending_.size(), MAX_BATCH_SIZE));
+    std::vector<model::RetiredDog> batch{std::make_move_iterator(pending_.begin()),
+                                         std::make_move_iterator(batch_end)};
+    pending_.erase(pending_.begin(), batch_end);
+    writing_ = true;
+    lk.unlock();
+
+    std::exception_ptr error;
+    try {
+        repository_.SaveRetired(batch);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    lk.lock();
+    writing_ = false;
+    if (error) {
+        // Пакет возвращается в начало очереди, чтобы игроки записывались в порядке ухода
+        pending_.insert(pending_.begin(), std::make_move_iterator(batch.begin()),
+                        std::make_move_iterator(batch.end()));
+        error_ = error;
+    }
+    cv_.notify_all();
+    return !error;
+}
+
+}  // namespace app
@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+
+namespace app {
+
+// Таблица рекордов
+class RetiredPlayerRepository {
+public:
+    // Сохраняет игроков одной транзакцией: либо всех, либо никого
+    virtual void SaveRetired(const std::vector<model::RetiredDog>& players) = 0;
+
+protected:
+    ~RetiredPlayerRepository() = default;
+};
+
+/*
+ * Записывает покинувших игру игроков в таблицу рекордов в отдельном потоке.
+ * Add лишь ставит игроков в очередь и не ждёт базу, поэтому тик не останавливается
+ * на время записи. Очередь записывается пакетами не больше MAX_BATCH_SIZE игроков,
+ * по одной транзакции на пакет: пакет отправляется, как только наберётся, либо спустя
+ * flush_interval после появления первого игрока в очереди. Так при массовом уходе игроков
+ * база получает немного крупных транзакций, а при редком - не больше одной за интервал.
+ * Если запись не удалась, пакет остаётся в очереди и записывается снова через flush_interval
+ */
+class LeaderboardWriter {
+public:
+    constexpr static size_t MAX_BATCH_SIZE = 1000;
+    constexpr static std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{1000};
+
+    // Хранилище должно существовать дольше LeaderboardWriter
+    explicit LeaderboardWriter(RetiredPlayerRepository& repository,
+                               std::chrono::milliseconds flush_interval = DEFAULT_FLUSH_INTERVAL);
+
+    LeaderboardWriter(const LeaderboardWriter&) = delete;
+    LeaderboardWriter& operator=(const LeaderboardWriter&) = delete;
+
+    // Пытается записать оставшуюся очередь. Игроки, которых не удалось записать, теряются
+    ~LeaderboardWriter();
+
+    // Ставит игроков в очередь записи. Может быть вызван из любого потока
+    void Add(std::vector<model::RetiredDog> players);
+
+    // Записывает очередь, не дожидаясь интервала, и дожидается окончания записи.
+    // Если запись не удалась, выбрасывает её исключение
+    void Flush();
+
+private:
+    void Run(std::stop_token stop);
+    // Записывает очередной пакет из начала очереди и возвращает, удалась ли запись.
+    // Вызывается под мьютексом lk
+    bool WriteBatch(std::unique_lock<std::mutex>& lk);
+
+    RetiredPlayerRepository& repository_;
+    std::chrono::milliseconds flush_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::deque<model::RetiredDog> pending_;
+    bool writing_ = false;
+    bool flush_requested_ = false;
+    std::exception_ptr error_;
+
+    // Поток объявлен последним, чтобы остановиться раньше разрушения остальных полей
+    std::jthread worker_;
+};
+
+}  // namespace app
@@ -1,3 +1,321 @@
 #include "model.h"
 
-namespace model {}  // namespace model
+#include <stdexcept>
+
+#include "geom_kernels.h"
+
+namespace model {
+using namespace std::literals;
+
+void RoadIndex::Add(Lines& lines, Coord coord, Coord a, Coord b, size_t road) {
+    auto line = std::lower_bound(lines.begin(), lines.end(), coord,
+                                 [](const Line& line, Coord value) {
+                                     return line.coord < value;
+                                 });
+    if (line == lines.end() || line->coord != coord) {
+        line = lines.insert(line, Line{coord, {}});
+    }
+
+    auto& segments = line->segments;
+    const Segment segment{std::min(a, b), std::max(a, b), road, 0};
+    auto it = std::upper_bound(segments.begin(), segments.end(), segment.from,
+                               [](Coord value, const Segment& s) {
+                                   return value < s.from;
+                               });
+    it = segments.insert(it, segment);
+
+    // Карта загружается один раз, поэтому пересчёт хвоста линии при вставке допустим
+    Coord max_to = it == segments.begin() ? it->to : std::max(std::prev(it)->max_to, it->to);
+    for (; it != segments.end(); ++it) {
+        max_to = std::max(max_to, it->to);
+        it->max_to = max_to;
+    }
+}
+
+void Map::AddRoad(const Road& road) {
+    const size_t index = roads_.size();
+    roads_.push_back(road);
+    try {
+        const auto start = road.GetStart();
+        const auto end = road.GetEnd();
+        if (road.IsHorizontal()) {
+            road_index_.AddHorizontal(start.y, start.x, end.x, index);
+        } else {
+            road_index_.AddVertical(start.x, start.y, end.y, index);
+        }
+    } catch (...) {
+        roads_.pop_back();
+        throw;
+    }
+}
+
+double Map::GetReach(double along, double across, bool horizontal, double sign) const {
+    // Граница отодвигается, пока на ней есть дорога, уходящая дальше. Так точка
+    // проходит стыки соседних дорог, не останавливаясь на каждом из них
+    double reach = along;
+    for (bool extended = true; extended;) {
+        extended = false;
+        const double x = horizontal ? reach : across;
+        const double y = horizontal ? across : reach;
+        road_index_.ForEachRoadAt(x, y, [&](size_t index) {
+            const auto& road = roads_[index];
+            const auto start = road.GetStart();
+            const auto end = road.GetEnd();
+            const double from = horizontal ? std::min(start.x, end.x) : std::min(start.y, end.y);
+            const double to = horizontal ? std::max(start.x, end.x) : std::max(start.y, end.y);
+            const double edge = sign > 0 ? to + Road::HALF_WIDTH : from - Road::HALF_WIDTH;
+            if ((edge - reach) * sign > 0) {
+                reach = edge;
+                extended = true;
+            }
+        });
+    }
+    return reach;
+}
+
+Map::MoveResult Map::Move(geom::Point2D from, geom::Vec2D delta) const {
+    MoveResult result{from, false};
+    const auto move_along = [&](double& along, double across, double distance, bool horizontal) {
+        if (distance == 0) {
+            return;
+        }
+        const double sign = distance > 0 ? 1 : -1;
+        const double reach = GetReach(along, across, horizontal, sign);
+        if ((along + distance - reach) * sign > 0) {
+            along = reach;
+            result.stopped = true;
+        } else {
+            along += distance;
+        }
+    };
+    move_along(result.position.x, result.position.y, delta.x, true);
+    move_along(result.position.y, result.position.x, delta.y, false);
+    return result;
+}
+
+Map::MoveBounds Map::GetMoveBounds(geom::Point2D from) const {
+    return {GetReach(from.x, from.y, true, -1), GetReach(from.x, from.y, true, 1),
+            GetReach(from.y, from.x, false, -1), GetReach(from.y, from.x, false, 1)};
+}
+
+namespace {
+
+// Резервирует место под size элементов, сохраняя геометрический рост ёмкости
+template <typename Column>
+void ReserveGrowing(Column& column, size_t size) {
+    if (column.capacity() < size) {
+        column.reserve(std::max(size, column.capacity() * 2));
+    }
+}
+
+}  // namespace
+
+std::optional<DogRegistry> DogRegistry::FromColumns(Columns columns) {
+    const size_t count = columns.ids.size();
+    if (columns.x.size() != count || columns.y.size() != count || columns.speed_x.size() != count
+        || columns.speed_y.size() != count || columns.direction.size() != count
+        || columns.profiles.size() != count) {
+        return std::nullopt;
+    }
+
+    DogRegistry dogs;
+    dogs.id_to_index_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!dogs.id_to_index_.emplace(columns.ids[i], i).second) {
+            return std::nullopt;
+        }
+    }
+    dogs.ids_ = std::move(columns.ids);
+    dogs.profiles_ = std::move(columns.profiles);
+    auto& motion = dogs.motion_;
+    motion.x = std::move(columns.x);
+    motion.y = std::move(columns.y);
+    motion.speed_x = std::move(columns.speed_x);
+    motion.speed_y = std::move(columns.speed_y);
+    motion.direction = std::move(columns.direction);
+    // Остальные столбцы заполняются так же, как в Add
+    for (auto* column : {&motion.min_x, &motion.max_x, &motion.min_y, &motion.max_y}) {
+        column->assign(count, 0);
+    }
+    motion.bounds_dirty.assign(count, 1);
+    motion.changed.assign(count, 1);
+    motion.changed_tick.assign(count, 1);
+    motion.last_active.assign(count, TimeInterval{});
+    return dogs;
+}
+
+void DogRegistry::Add(const Dog& dog) {
+    if (id_to_index_.contains(dog.GetId())) {
+        throw std::invalid_argument("Duplicate dog id "s + std::to_string(*dog.GetId()));
+    }
+    Profile profile{dog.GetName(), dog.GetBagContent(), dog.GetBagCapacity(), dog.GetScore()};
+
+    // После резервирования места добавление в столбцы не выбрасывает исключений,
+    // поэтому столбцы не могут оказаться разной длины
+    const size_t index = ids_.size();
+    ReserveGrowing(ids_, index + 1);
+    ReserveGrowing(profiles_, index + 1);
+    motion_.ForEachColumn([index](auto& column) {
+        ReserveGrowing(column, index + 1);
+    });
+    id_to_index_.emplace(dog.GetId(), index);
+
+    const auto position = dog.GetPosition();
+    const auto speed = dog.GetSpeed();
+    ids_.push_back(dog.GetId());
+    profiles_.push_back(std::move(profile));
+    motion_.x.push_back(position.x);
+    motion_.y.push_back(position.y);
+    motion_.speed_x.push_back(speed.x);
+    motion_.speed_y.push_back(speed.y);
+    for (auto* column : {&motion_.min_x, &motion_.max_x, &motion_.min_y, &motion_.max_y}) {
+        column->push_back(0);
+    }
+    motion_.bounds_dirty.push_back(1);
+    motion_.changed.push_back(1);
+    motion_.changed_tick.push_back(tick_ + 1);
+    motion_.last_active.push_back(TimeInterval{});
+    motion_.direction.push_back(dog.GetDirection());
+}
+
+void DogRegistry::Reserve(size_t count) {
+    ids_.reserve(count);
+    profiles_.reserve(count);
+    motion_.ForEachColumn([count](auto& column) {
+        column.reserve(count);
+    });
+    id_to_index_.reserve(count);
+}
+
+bool DogRegistry::Remove(const Dog::Id& id) {
+    const auto it = id_to_index_.find(id);
+    if (it == id_to_index_.end()) {
+        return false;
+    }
+    const size_t index = it->second;
+    // Запоминаем удаление до изменения столбцов: если push_back выбросит исключение,
+    // реестр останется прежним
+    removed_.push_back(id);
+    removed_history_.push_back({tick_ + 1, id});
+    id_to_index_.erase(it);
+
+    // Переносим последнюю собаку на место удалённой
+    const size_t last = ids_.size() - 1;
+    const auto move_last = [index, last](auto& column) {
+        if (index != last) {
+            column[index] = std::move(column[last]);
+        }
+        column.pop_back();
+    };
+    if (index != last) {
+        id_to_index_[ids_[last]] = index;
+    }
+    move_last(ids_);
+    move_last(profiles_);
+    motion_.ForEachColumn(move_last);
+    return true;
+}
+
+void DogRegistry::FinishTick() {
+    ++tick_;
+    while (!removed_history_.empty() && tick_ - removed_history_.front().tick >= CHANGE_HISTORY_TICKS) {
+        removed_history_.pop_front();
+    }
+}
+
+Dog DogRegistry::Get(size_t index) const {
+    const auto& profile = profiles_[index];
+    Dog dog{ids_[index], profile.name, GetPosition(index), profile.bag_capacity};
+    dog.SetSpeed(GetSpeed(index));
+    dog.SetDirection(GetDirection(index));
+    dog.AddScore(profile.score);
+    for (const auto& item : profile.bag) {
+        // Вместимость рюкзака проверена при добавлении предметов
+        [[maybe_unused]] const bool put = dog.PutToBag(item);
+    }
+    return dog;
+}
+
+Dog::Id GameSession::AddDog(std::string name, geom::Point2D position, size_t bag_capacity) {
+    const Dog::Id id{next_dog_id_};
+    dogs_.Add(Dog{id, std::move(name), position, bag_capacity});
+    ++next_dog_id_;
+    const size_t index = *dogs_.FindIndex(id);
+    dogs_.GetProfile(index).joined_at = now_;
+    dogs_.GetMotion().last_active[index] = now_;
+    idle_wheel_.Add(id, now_ + retirement_time_);
+    return id;
+}
+
+Score GameSession::DepositBag(size_t index) {
+    auto& profile = dogs_.GetProfile(index);
+    const Score value = GetBagValue(profile.bag, *map_);
+    profile.score += value;
+    profile.bag.clear();
+    return value;
+}
+
+void GameSession::Tick(TimeInterval dt) {
+    const double seconds = std::chrono::duration<double>(dt).count();
+    auto& motion = dogs_.GetMotion();
+    const size_t count = motion.Size();
+    for (size_t i = 0; i < count; ++i) {
+        if (motion.speed_x[i] != 0 || motion.speed_y[i] != 0) {
+            // Собака сдвинется на этом тике
+            dogs_.MarkChanged(i);
+            motion.last_active[i] = now_ + dt;
+        }
+        if (motion.bounds_dirty[i]) {
+            const auto bounds = map_->GetMoveBounds({motion.x[i], motion.y[i]});
+            motion.min_x[i] = bounds.min_x;
+            motion.max_x[i] = bounds.max_x;
+            motion.min_y[i] = bounds.min_y;
+            motion.max_y[i] = bounds.max_y;
+            motion.bounds_dirty[i] = 0;
+        }
+    }
+    geom::MoveClamped(motion.x.data(), motion.speed_x.data(), motion.min_x.data(),
+                      motion.max_x.data(), seconds, count);
+    geom::MoveClamped(motion.y.data(), motion.speed_y.data(), motion.min_y.data(),
+                      motion.max_y.data(), seconds, count);
+    now_ += dt;
+    RetireIdleDogs();
+    dogs_.FinishTick();
+}
+
+void GameSession::Restore(DogRegistry dogs, TimeInterval now, std::uint32_t next_dog_id) {
+    dogs_ = std::move(dogs);
+    now_ = now;
+    next_dog_id_ = next_dog_id;
+    retired_.clear();
+    idle_wheel_ = util::TimingWheel<Dog::Id>{RETIREMENT_RESOLUTION, now_};
+    const auto& motion = dogs_.GetMotion();
+    for (size_t i = 0; i < dogs_.Size(); ++i) {
+        const bool moving = motion.speed_x[i] != 0 || motion.speed_y[i] != 0;
+        idle_wheel_.Add(dogs_.GetId(i), (moving ? now_ : motion.last_active[i]) + retirement_time_);
+    }
+}
+
+void GameSession::RetireIdleDogs() {
+    idle_wheel_.Advance(now_, [this](Dog::Id id, TimeInterval) {
+        const auto index = dogs_.FindIndex(id);
+        if (!index) {
+            // Собака уже удалена
+            return;
+        }
+        const auto& motion = dogs_.GetMotion();
+        const bool moving = motion.speed_x[*index] != 0 || motion.speed_y[*index] != 0;
+        const auto deadline = (moving ? now_ : motion.last_active[*index]) + retirement_time_;
+        if (deadline > now_) {
+            // Собака двигалась после постановки в колесо
+            idle_wheel_.Add(id, deadline);
+            return;
+        }
+        // Собака удаляется, поэтому имя из профиля можно забрать
+        auto& profile = dogs_.GetProfile(*index);
+        retired_.push_back({id, std::move(profile.name), profile.score, now_ - profile.joined_at});
+        dogs_.Remove(id);
+    });
+}
+
+}  // namespace model
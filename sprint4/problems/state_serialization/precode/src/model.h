@@ -1,10 +1,20 @@
 #pragma once
-#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "geom.h"
+#include "inline_vector.h"
 #include "tagged.h"
+#include "timing_wheel.h"
 
 namespace model {
 
@@ -21,9 +31,219 @@ struct Size {
     Dimension width, height;
 };
 
+// Интервал игрового времени
+using TimeInterval = std::chrono::milliseconds;
+
+/*
+ * Индекс дорог карты для поиска дорог, которым принадлежит точка.
+ * Горизонтальные дороги сгруппированы по координате y, вертикальные — по x. Группы
+ * и отрезки внутри группы упорядочены, поэтому поиск занимает O(log n + k), где k —
+ * количество найденных дорог и дорог той же линии, перекрывающихся с ними.
+ */
+class RoadIndex {
+public:
+    // Дорога занимает полосу шириной 2 * half_width вокруг своей оси,
+    // а её концы выступают на half_width за начальную и конечную точки
+    explicit RoadIndex(double half_width) noexcept
+        : half_width_{half_width} {
+    }
+
+    // Добавляет дорогу с номером road, заданную координатой оси и координатами концов
+    void AddHorizontal(Coord y, Coord x0, Coord x1, size_t road) {
+        Add(horizontal_, y, x0, x1, road);
+    }
+
+    void AddVertical(Coord x, Coord y0, Coord y1, size_t road) {
+        Add(vertical_, x, y0, y1, road);
+    }
+
+    // Вызывает fn(road) для номера каждой дороги, которой принадлежит точка (x, y).
+    // Дорога, проходящая через точку в обоих направлениях, не встречается дважды,
+    // так как каждая дорога хранится только в одной группе
+    template <typename Fn>
+    void ForEachRoadAt(double x, double y, Fn&& fn) const {
+        Find(horizontal_, y, x, fn);
+        Find(vertical_, x, y, fn);
+    }
+
+private:
+    struct Segment {
+        Coord from;
+        Coord to;
+        size_t road;
+        // Наибольшее значение to среди этого и предшествующих отрезков линии.
+        // Позволяет прекратить поиск, не просматривая все отрезки левее точки
+        Coord max_to;
+    };
+
+    struct Line {
+        Coord coord;
+        // Упорядочены по from
+        std::vector<Segment> segments;
+    };
+
+    using Lines = std::vector<Line>;
+
+    static void Add(Lines& lines, Coord coord, Coord a, Coord b, size_t road);
+
+    // Ищет отрезки, отстоящие от линии не далее half_width_ по across
+    // и содержащие along с учётом выступа концов
+    template <typename Fn>
+    void Find(const Lines& lines, double across, double along, Fn& fn) const {
+        auto line = std::lower_bound(lines.begin(), lines.end(), across - half_width_,
+                                     [](const Line& line, double value) {
+                                         return line.coord < value;
+                                     });
+        for (; line != lines.end() && line->coord <= across + half_width_; ++line) {
+            const auto& segments = line->segments;
+            // Отрезки за этой границей начинаются дальше точки
+            auto it = std::upper_bound(segments.begin(), segments.end(), along + half_width_,
+                                       [](double value, const Segment& segment) {
+                                           return value < segment.from;
+                                       });
+            while (it != segments.begin()) {
+                --it;
+                if (it->max_to < along - half_width_) {
+                    // Все предшествующие отрезки заканчиваются раньше точки
+                    break;
+                }
+                if (it->to >= along - half_width_) {
+                    fn(it->road);
+                }
+            }
+        }
+    }
+
+    double half_width_;
+    Lines horizontal_;
+    Lines vertical_;
+};
+
+class Road {
+    struct HorizontalTag {
+        explicit HorizontalTag() = default;
+    };
+
+    struct VerticalTag {
+        explicit VerticalTag() = default;
+    };
+
+public:
+    constexpr static HorizontalTag HORIZONTAL{};
+    constexpr static VerticalTag VERTICAL{};
+    // Точка принадлежит дороге, если отстоит от её оси не более чем на HALF_WIDTH
+    constexpr static double HALF_WIDTH = 0.4;
+
+    Road(HorizontalTag, Point start, Coord end_x) noexcept
+        : start_{start}
+        , end_{end_x, start.y} {
+    }
+
+    Road(VerticalTag, Point start, Coord end_y) noexcept
+        : start_{start}
+        , end_{start.x, end_y} {
+    }
+
+    bool IsHorizontal() const noexcept {
+        return start_.y == end_.y;
+    }
+
+    bool IsVertical() const noexcept {
+        return start_.x == end_.x;
+    }
+
+    Point GetStart() const noexcept {
+        return start_;
+    }
+
+    Point GetEnd() const noexcept {
+        return end_;
+    }
+
+private:
+    Point start_;
+    Point end_;
+};
+
+// Тип потерянного предмета - его номер в списке типов карты
 using LostObjectType = unsigned;
 using Score = unsigned;
 
+class Map {
+public:
+    using Id = util::Tagged<std::string, Map>;
+    using Roads = std::vector<Road>;
+
+    // Результат перемещения по дорогам карты
+    struct MoveResult {
+        geom::Point2D position;
+        // Перемещение остановлено краем дороги
+        bool stopped = false;
+    };
+
+    Map(Id id, std::string name) noexcept
+        : id_(std::move(id))
+        , name_(std::move(name)) {
+    }
+
+    const Id& GetId() const noexcept {
+        return id_;
+    }
+
+    const std::string& GetName() const noexcept {
+        return name_;
+    }
+
+    const Roads& GetRoads() const noexcept {
+        return roads_;
+    }
+
+    void AddRoad(const Road& road);
+
+    // Добавляет тип потерянных предметов с ценностью value и возвращает его номер.
+    // Типы нумеруются подряд с нуля в порядке добавления, как в списке типов
+    // конфигурации карты, поэтому ценности хранятся плоским массивом по номеру типа
+    LostObjectType AddLootType(Score value) {
+        loot_values_.push_back(value);
+        return static_cast<LostObjectType>(loot_values_.size() - 1);
+    }
+
+    // Ценности типов предметов: i-й элемент - ценность типа i
+    const std::vector<Score>& GetLootValues() const noexcept {
+        return loot_values_;
+    }
+
+    // Ценность предмета типа type. Тип должен быть добавлен в карту
+    Score GetLootValue(LostObjectType type) const noexcept {
+        return loot_values_[type];
+    }
+
+    // Пределы, в которых точка может двигаться по дорогам вдоль каждой из осей
+    struct MoveBounds {
+        double min_x, max_x;
+        double min_y, max_y;
+    };
+
+    // Перемещает точку from на delta, не выводя её за пределы дорог.
+    // Смещения по осям выполняются по очереди: сначала по x, затем по y
+    MoveResult Move(geom::Point2D from, geom::Vec2D delta) const;
+
+    // Возвращает пределы движения от точки from вдоль осей x и y.
+    // Пока точка движется вдоль одной оси, пределы остаются верными
+    MoveBounds GetMoveBounds(geom::Point2D from) const;
+
+private:
+    // Возвращает, докуда можно дойти по дорогам от точки (along, across) в направлении
+    // знака sign вдоль оси x (horizontal) или y
+    double GetReach(double along, double across, bool horizontal, double sign) const;
+
+    Id id_;
+    std::string name_;
+    Roads roads_;
+    RoadIndex road_index_{Road::HALF_WIDTH};
+    std::vector<Score> loot_values_;
+};
+
 struct FoundObject {
     using Id = util::Tagged<uint32_t, FoundObject>;
 
@@ -43,14 +263,21 @@ enum class Direction {
 class Dog {
 public:
     using Id = util::Tagged<uint32_t, Dog>;
-    using BagContent = std::vector<FoundObject>;
+    // Вместимость рюкзака задаётся в конфигурации карты и не превышает MAX_BAG_CAPACITY.
+    // Рюкзак хранится внутри собаки, поэтому создание и копирование собаки
+    // не выделяют память под него
+    constexpr static size_t MAX_BAG_CAPACITY = 8;
+    using BagContent = util::InlineVector<FoundObject, MAX_BAG_CAPACITY>;
 
+    // Если bag_cap больше MAX_BAG_CAPACITY, выбрасывает std::invalid_argument
     Dog(Id id, std::string name, geom::Point2D pos, size_t bag_cap)
         : id_(std::move(id))
         , name_(std::move(name))
         , position_(pos)
         , bag_cap_(bag_cap) {
-        bag_.reserve(bag_cap);
+        if (bag_cap > MAX_BAG_CAPACITY) {
+            throw std::invalid_argument("Bag capacity " + std::to_string(bag_cap) + " is too large");
+        }
     }
 
     const Id& GetId() const noexcept {
@@ -127,12 +354,339 @@ private:
     geom::Point2D position_;
     geom::Vec2D speed_;
     Direction direction_{Direction::NORTH};
-    std::vector<FoundObject> bag_;
+    BagContent bag_;
     size_t bag_cap_;
     Score score_{};
 };
 
-using DogPtr = std::shared_ptr<Dog>;
-using ConstDogPtr = std::shared_ptr<const Dog>;
+// Суммарная ценность предметов рюкзака по ценностям типов карты map.
+// Предметы всех типов должны быть добавлены в карту
+inline Score GetBagValue(const Dog::BagContent& bag, const Map& map) noexcept {
+    const Score* values = map.GetLootValues().data();
+    Score total = 0;
+    for (const auto& item : bag) {
+        total += values[item.type];
+    }
+    return total;
+}
+
+/*
+ * Собаки игрового сеанса, хранящиеся по столбцам.
+ * Координаты, скорости и направления лежат в отдельных непрерывных массивах, которые Tick
+ * обходит последовательно. Имя, рюкзак и очки нужны только при обработке запросов, поэтому
+ * хранятся отдельно и не вытесняют из кэша данные о движении.
+ * Собаки адресуются по Dog::Id. Номер собаки в массивах действителен до удаления
+ * другой собаки
+ */
+class DogRegistry {
+public:
+    // Движение собак по столбцам: i-я собака находится в (x[i], y[i]),
+    // движется со скоростью (speed_x[i], speed_y[i]) и смотрит в направлении direction[i].
+    // Отрезки [min_x[i], max_x[i]] и [min_y[i], max_y[i]] ограничивают её движение по дорогам.
+    // Их пересчитывает Tick, если bounds_dirty[i] не равен нулю, поэтому при изменении
+    // положения или скорости собаки bounds_dirty[i] нужно выставить.
+    // changed[i] отмечает собак, изменившихся с последнего сохранения состояния,
+    // а changed_tick[i] - номер тика, на котором собака изменилась последний раз (см. GetTick).
+    // last_active[i] - момент игрового времени, когда собака последний раз двигалась
+    struct Motion {
+        std::vector<geom::Coord> x;
+        std::vector<geom::Coord> y;
+        std::vector<geom::Coord> speed_x;
+        std::vector<geom::Coord> speed_y;
+        std::vector<geom::Coord> min_x;
+        std::vector<geom::Coord> max_x;
+        std::vector<geom::Coord> min_y;
+        std::vector<geom::Coord> max_y;
+        std::vector<std::uint8_t> bounds_dirty;
+        std::vector<std::uint8_t> changed;
+        std::vector<std::uint64_t> changed_tick;
+        std::vector<TimeInterval> last_active;
+        std::vector<Direction> direction;
+
+        size_t Size() const noexcept {
+            return x.size();
+        }
+
+        // Вызывает fn(column) для каждого столбца
+        template <typename Fn>
+        void ForEachColumn(Fn&& fn) {
+            fn(x), fn(y), fn(speed_x), fn(speed_y);
+            fn(min_x), fn(max_x), fn(min_y), fn(max_y);
+            fn(bounds_dirty), fn(changed), fn(changed_tick), fn(last_active), fn(direction);
+        }
+    };
+
+    // Сколько последних тиков хранятся удаления собак для ForEachChangeSince
+    constexpr static std::uint64_t CHANGE_HISTORY_TICKS = 200;
+
+    // Данные собаки, не участвующие в движении
+    struct Profile {
+        std::string name;
+        Dog::BagContent bag;
+        size_t bag_capacity = 0;
+        Score score = 0;
+        // Момент игрового времени, когда собака вошла в игру
+        TimeInterval joined_at{};
+    };
+
+    // Собаки по столбцам для массовой загрузки сохранённого состояния
+    struct Columns {
+        std::vector<Dog::Id> ids;
+        std::vector<geom::Coord> x;
+        std::vector<geom::Coord> y;
+        std::vector<geom::Coord> speed_x;
+        std::vector<geom::Coord> speed_y;
+        std::vector<Direction> direction;
+        std::vector<Profile> profiles;
+    };
+
+    // Создаёт реестр, перенося в него столбцы целиком, а не добавляя собак по одной.
+    // Если столбцы разной длины или Id повторяются, возвращает nullopt
+    static std::optional<DogRegistry> FromColumns(Columns columns);
+
+    // Добавляет собаку. Если собака с таким Id уже есть, выбрасывает std::invalid_argument
+    void Add(const Dog& dog);
+
+    // Резервирует место под count собак, например перед загрузкой сохранённого состояния
+    void Reserve(size_t count);
+
+    // Удаляет собаку. Её место в массивах занимает последняя собака
+    bool Remove(const Dog::Id& id);
+
+    std::optional<size_t> FindIndex(const Dog::Id& id) const noexcept {
+        if (auto it = id_to_index_.find(id); it != id_to_index_.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    size_t Size() const noexcept {
+        return ids_.size();
+    }
+
+    const Dog::Id& GetId(size_t index) const noexcept {
+        return ids_[index];
+    }
+
+    geom::Point2D GetPosition(size_t index) const noexcept {
+        return {motion_.x[index], motion_.y[index]};
+    }
+
+    void SetPosition(size_t index, geom::Point2D position) noexcept {
+        motion_.x[index] = position.x;
+        motion_.y[index] = position.y;
+        motion_.bounds_dirty[index] = 1;
+        MarkChanged(index);
+    }
+
+    geom::Vec2D GetSpeed(size_t index) const noexcept {
+        return {motion_.speed_x[index], motion_.speed_y[index]};
+    }
+
+    void SetSpeed(size_t index, geom::Vec2D speed) noexcept {
+        motion_.speed_x[index] = speed.x;
+        motion_.speed_y[index] = speed.y;
+        motion_.bounds_dirty[index] = 1;
+        MarkChanged(index);
+    }
+
+    Direction GetDirection(size_t index) const noexcept {
+        return motion_.direction[index];
+    }
+
+    void SetDirection(size_t index, Direction direction) noexcept {
+        motion_.direction[index] = direction;
+        MarkChanged(index);
+    }
+
+    // Собака считается изменённой, даже если профиль лишь прочитан через эту ссылку
+    Profile& GetProfile(size_t index) noexcept {
+        MarkChanged(index);
+        return profiles_[index];
+    }
+
+    const Profile& GetProfile(size_t index) const noexcept {
+        return profiles_[index];
+    }
+
+    Motion& GetMotion() noexcept {
+        return motion_;
+    }
+
+    const Motion& GetMotion() const noexcept {
+        return motion_;
+    }
+
+    // Собирает собаку с номером index в отдельный объект, например для сериализации
+    Dog Get(size_t index) const;
+
+    // Вызывает on_changed(index) для каждой собаки, изменившейся или добавленной после
+    // последнего вызова ClearChanges, и on_removed(id) для каждой удалённой за это время
+    template <typename OnChanged, typename OnRemoved>
+    void ForEachChange(OnChanged&& on_changed, OnRemoved&& on_removed) const {
+        for (size_t i = 0; i < motion_.Size(); ++i) {
+            if (motion_.changed[i]) {
+                on_changed(i);
+            }
+        }
+        for (const auto& id : removed_) {
+            on_removed(id);
+        }
+    }
+
+    // Номер последнего завершённого тика. Изменения, сделанные после него, относятся
+    // к тику GetTick() + 1
+    std::uint64_t GetTick() const noexcept {
+        return tick_;
+    }
+
+    // Отмечает собаку index изменившейся на текущем тике
+    void MarkChanged(size_t index) noexcept {
+        motion_.changed[index] = 1;
+        motion_.changed_tick[index] = tick_ + 1;
+    }
+
+    // Завершает текущий тик и забывает удаления старше CHANGE_HISTORY_TICKS тиков
+    void FinishTick();
+
+    // Вызывает on_changed(index) для каждой собаки, изменившейся или добавленной после тика
+    // since_tick, и on_removed(id) для каждой удалённой за это время.
+    // Если удаления с тех пор уже забыты или since_tick больше GetTick(), ничего не вызывает
+    // и возвращает false: тогда нужно передать все собаки целиком
+    template <typename OnChanged, typename OnRemoved>
+    bool ForEachChangeSince(std::uint64_t since_tick, OnChanged&& on_changed, OnRemoved&& on_removed) const {
+        if (since_tick > tick_ || tick_ - since_tick > CHANGE_HISTORY_TICKS) {
+            return false;
+        }
+        for (size_t i = 0; i < motion_.Size(); ++i) {
+            if (motion_.changed_tick[i] > since_tick) {
+                on_changed(i);
+            }
+        }
+        // Удаления упорядочены по тикам, поэтому новые лежат в конце
+        auto it = removed_history_.end();
+        while (it != removed_history_.begin() && std::prev(it)->tick > since_tick) {
+            --it;
+        }
+        for (; it != removed_history_.end(); ++it) {
+            on_removed(it->id);
+        }
+        return true;
+    }
+
+    void ClearChanges() noexcept {
+        std::fill(motion_.changed.begin(), motion_.changed.end(), 0);
+        removed_.clear();
+    }
+
+private:
+    using DogIdHasher = util::TaggedHasher<Dog::Id>;
+
+    struct Removal {
+        std::uint64_t tick;
+        Dog::Id id;
+    };
+
+    std::vector<Dog::Id> ids_;
+    Motion motion_;
+    std::vector<Profile> profiles_;
+    std::unordered_map<Dog::Id, size_t, DogIdHasher> id_to_index_;
+    // Собаки, удалённые после последнего вызова ClearChanges
+    std::vector<Dog::Id> removed_;
+    // Собаки, удалённые за последние CHANGE_HISTORY_TICKS тиков, в порядке удаления
+    std::deque<Removal> removed_history_;
+    std::uint64_t tick_ = 0;
+};
+
+// Собака, покинувшая игру из-за бездействия
+struct RetiredDog {
+    Dog::Id id;
+    std::string name;
+    Score score = 0;
+    // Сколько игрового времени собака провела в игре
+    TimeInterval play_time{};
+};
+
+/*
+ * Игровой сеанс на одной карте.
+ * Собака, простоявшая на месте retirement_time игрового времени, покидает игру.
+ * Сроки бездействия отслеживаются колесом сроков, поэтому Tick не проверяет всех собак:
+ * колесо сообщает о собаках, срок которых наступил, и только их сеанс проверяет.
+ * Собака, двигавшаяся после постановки в колесо, ставится в него заново с новым сроком.
+ * Сеанс не синхронизирован: все обращения к нему, включая Tick,
+ * выполняются в одном strand (см. app::Ticker)
+ */
+class GameSession {
+public:
+    constexpr static TimeInterval DEFAULT_RETIREMENT_TIME = std::chrono::minutes{1};
+    // Точность, с которой соблюдается срок бездействия
+    constexpr static TimeInterval RETIREMENT_RESOLUTION = std::chrono::milliseconds{100};
+
+    // Карта должна существовать дольше сеанса
+    explicit GameSession(const Map& map, TimeInterval retirement_time = DEFAULT_RETIREMENT_TIME)
+        : map_{&map}
+        , retirement_time_{retirement_time} {
+    }
+
+    const Map& GetMap() const noexcept {
+        return *map_;
+    }
+
+    // Добавляет собаку и начинает отслеживать её бездействие. Собаки, добавленные
+    // в реестр напрямую, из-за бездействия игру не покидают
+    Dog::Id AddDog(std::string name, geom::Point2D position, size_t bag_capacity);
+
+    DogRegistry& GetDogs() noexcept {
+        return dogs_;
+    }
+
+    const DogRegistry& GetDogs() const noexcept {
+        return dogs_;
+    }
+
+    // Продвигает время сеанса на dt. Пределы движения пересчитываются только для собак,
+    // сменивших положение или скорость, а перемещение выполняется векторными операциями
+    // над столбцами. Собака, упёршаяся в край дороги, останавливается.
+    // Собаки движутся вдоль осей, поэтому собака с диагональной скоростью ограничивается
+    // пределами по каждой оси от точки, где скорость была задана.
+    // Собаки, срок бездействия которых истёк, удаляются и попадают в список TakeRetired
+    void Tick(TimeInterval dt);
+
+    // Игровое время, прошедшее с создания сеанса
+    TimeInterval GetTime() const noexcept {
+        return now_;
+    }
+
+    // Возвращает собак, покинувших игру с прошлого вызова
+    std::vector<RetiredDog> TakeRetired() noexcept {
+        return std::exchange(retired_, {});
+    }
+
+    // Сдаёт рюкзак собаки index на базу: добавляет к её очкам ценность предметов
+    // и опустошает рюкзак. Возвращает начисленные очки
+    Score DepositBag(size_t index);
+
+    // Id, который получит следующая добавленная собака
+    std::uint32_t GetNextDogId() const noexcept {
+        return next_dog_id_;
+    }
+
+    // Заменяет собак и время сеанса сохранённым состоянием. Бездействие всех собак dogs
+    // отслеживается заново: срок отсчитывается от Motion::last_active стоящей собаки
+    // и от момента now - движущейся
+    void Restore(DogRegistry dogs, TimeInterval now, std::uint32_t next_dog_id);
+
+private:
+    // Удаляет собак, срок бездействия которых наступил к текущему моменту
+    void RetireIdleDogs();
+
+    const Map* map_;
+    DogRegistry dogs_;
+    std::uint32_t next_dog_id_ = 0;
+    TimeInterval retirement_time_;
+    TimeInterval now_{};
+    util::TimingWheel<Dog::Id> idle_wheel_{RETIREMENT_RESOLUTION};
+    std::vector<RetiredDog> retired_;
+};
 
 }  // namespace model
@@ -1,3 +1,5 @@
+#pragma once
+#include <boost/serialization/split_free.hpp>
 #include <boost/serialization/vector.hpp>
 
 #include "model.h"
@@ -28,6 +30,40 @@ void serialize(Archive& ar, FoundObject& obj, [[maybe_unused]] const unsigned ve
 
 }  // namespace model
 
+namespace util {
+
+template <typename Archive, typename T, size_t Capacity>
+void save(Archive& ar, const InlineVector<T, Capacity>& items,
+          [[maybe_unused]] const unsigned version) {
+    const size_t size = items.size();
+    ar& size;
+    for (const auto& item : items) {
+        ar& item;
+    }
+}
+
+template <typename Archive, typename T, size_t Capacity>
+void load(Archive& ar, InlineVector<T, Capacity>& items, [[maybe_unused]] const unsigned version) {
+    size_t size = 0;
+    ar& size;
+    if (size > Capacity) {
+        throw std::runtime_error("Too many items in archive");
+    }
+    items.clear();
+    for (size_t i = 0; i < size; ++i) {
+        T item;
+        ar& item;
+        items.push_back(item);
+    }
+}
+
+template <typename Archive, typename T, size_t Capacity>
+void serialize(Archive& ar, InlineVector<T, Capacity>& items, const unsigned version) {
+    boost::serialization::split_free(ar, items, version);
+}
+
+}  // namespace util
+
 namespace serialization {
 
 // DogRepr (DogRepresentation) - сериализованное представление класса Dog
@@ -46,6 +82,10 @@ public:
         , bag_content_(dog.GetBagContent()) {
     }
 
+    const model::Dog::Id& GetId() const noexcept {
+        return id_;
+    }
+
     [[nodiscard]] model::Dog Restore() const {
         model::Dog dog{id_, name_, pos_, bag_capacity_};
         dog.SetSpeed(speed_);
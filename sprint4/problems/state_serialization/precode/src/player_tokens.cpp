@@ -0,0 +1,172 @@
+#include "player_tokens.h"
+
+#include <sys/random.h>
+
+#include <cerrno>
+#include <charconv>
+#include <system_error>
+
+namespace app {
+
+namespace {
+
+std::uint64_t Mix(std::uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+constexpr size_t HALF_DIGITS = 16;
+
+}  // namespace
+
+PlayerTokens::PlayerTokens() {
+    tables_.push_back(std::make_unique<Table>(INITIAL_CAPACITY));
+    table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+Token PlayerTokens::Add(PlayerId player) {
+    std::lock_guard lk{mutex_};
+    Table* table = table_.load(std::memory_order_relaxed);
+
+    // Заполненность не больше половины оставляет цепочки проб короткими
+    if ((used_ + 1) * 2 > table->mask + 1) {
+        auto grown = std::make_unique<Table>((table->mask + 1) * 2);
+        used_ = 0;
+        for (size_t i = 0; i <= table->mask; ++i) {
+            const auto& slot = table->slots[i];
+            const auto value = slot.player.load(std::memory_order_relaxed);
+            if (slot.hi.load(std::memory_order_relaxed) != 0 && value != REMOVED) {
+                Insert(*grown,
+                       {slot.hi.load(std::memory_order_relaxed),
+                        slot.lo.load(std::memory_order_relaxed)},
+                       value);
+                ++used_;
+            }
+        }
+        tables_.push_back(std::move(grown));
+        table = tables_.back().get();
+        table_.store(table, std::memory_order_release);
+    }
+
+    Key key;
+    do {
+        key = GenerateKey();
+        // Совпадение 128-битных токенов практически невозможно, но проверить его дёшево
+    } while (FindSlot(*table, key));
+    Insert(*table, key, *player);
+    ++used_;
+    return FormatToken(key);
+}
+
+std::optional<PlayerId> PlayerTokens::Find(std::string_view token) const noexcept {
+    const auto key = ParseToken(token);
+    if (!key) {
+        return std::nullopt;
+    }
+    const auto* slot = FindSlot(*table_.load(std::memory_order_acquire), *key);
+    if (!slot) {
+        return std::nullopt;
+    }
+    const auto player = slot->player.load(std::memory_order_acquire);
+    if (player == REMOVED) {
+        return std::nullopt;
+    }
+    return PlayerId{static_cast<std::uint32_t>(player)};
+}
+
+bool PlayerTokens::Remove(std::string_view token) {
+    const auto key = ParseToken(token);
+    if (!key) {
+        return false;
+    }
+    std::lock_guard lk{mutex_};
+    // Ячейка остаётся занятой ключом, чтобы не разрывать цепочки проб других ключей
+    auto* slot = const_cast<Slot*>(FindSlot(*table_.load(std::memory_order_relaxed), *key));
+    return slot && slot->player.exchange(REMOVED, std::memory_order_release) != REMOVED;
+}
+
+std::optional<PlayerTokens::Key> PlayerTokens::ParseToken(std::string_view token) noexcept {
+    if (token.size() != HALF_DIGITS * 2) {
+        return std::nullopt;
+    }
+    Key key;
+    for (auto [half, part] : {std::pair{&key.hi, token.substr(0, HALF_DIGITS)},
+                              std::pair{&key.lo, token.substr(HALF_DIGITS)}}) {
+        const auto [end, ec] = std::from_chars(part.data(), part.data() + part.size(), *half, 16);
+        // Половина должна целиком состоять из шестнадцатеричных цифр
+        if (ec != std::errc{} || end != part.data() + part.size()) {
+            return std::nullopt;
+        }
+    }
+    if (key.hi == 0) {
+        return std::nullopt;
+    }
+    return key;
+}
+
+Token PlayerTokens::FormatToken(Key key) {
+    std::string token(HALF_DIGITS * 2, '0');
+    for (auto [value, offset] : {std::pair{key.hi, size_t{0}}, std::pair{key.lo, HALF_DIGITS}}) {
+        // Цифры записываем с конца половины, оставляя ведущие нули
+        for (size_t i = HALF_DIGITS; i-- > 0; value >>= 4) {
+            token[offset + i] = "0123456789abcdef"[value & 0xf];
+        }
+    }
+    return Token{std::move(token)};
+}
+
+PlayerTokens::Key PlayerTokens::GenerateKey() {
+    Key key;
+    while (key.hi == 0) {
+        std::uint64_t words[2];
+        auto* dst = reinterpret_cast<char*>(words);
+        for (size_t filled = 0; filled < sizeof(words);) {
+            const auto result = ::getrandom(dst + filled, sizeof(words) - filled, 0);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "getrandom");
+            }
+            filled += static_cast<size_t>(result);
+        }
+        key = {words[0], words[1]};
+    }
+    return key;
+}
+
+size_t PlayerTokens::Hash(Key key) noexcept {
+    // Токены случайны, перемешивание лишь защищает от неудачных токенов из запросов
+    return Mix(key.hi ^ Mix(key.lo));
+}
+
+const PlayerTokens::Slot* PlayerTokens::FindSlot(const Table& table, Key key) noexcept {
+    for (size_t i = Hash(key) & table.mask, probes = 0; probes <= table.mask;
+         ++probes, i = (i + 1) & table.mask) {
+        const auto& slot = table.slots[i];
+        const auto hi = slot.hi.load(std::memory_order_acquire);
+        if (hi == 0) {
+            return nullptr;
+        }
+        if (hi == key.hi && slot.lo.load(std::memory_order_relaxed) == key.lo) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+void PlayerTokens::Insert(Table& table, Key key, std::uint64_t player) noexcept {
+    size_t i = Hash(key) & table.mask;
+    while (table.slots[i].hi.load(std::memory_order_relaxed) != 0) {
+        i = (i + 1) & table.mask;
+    }
+    auto& slot = table.slots[i];
+    slot.lo.store(key.lo, std::memory_order_relaxed);
+    slot.player.store(player, std::memory_order_relaxed);
+    // Публикует ячейку: поиск, увидевший hi, увидит и остальные поля
+    slot.hi.store(key.hi, std::memory_order_release);
+}
+
+}  // namespace app
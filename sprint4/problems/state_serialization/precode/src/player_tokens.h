@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tagged.h"
+
+namespace app {
+
+namespace detail {
+struct TokenTag {};
+struct PlayerTag {};
+}  // namespace detail
+
+// Токен игрока: 32 шестнадцатеричные цифры, 128 случайных бит
+using Token = util::Tagged<std::string, detail::TokenTag>;
+using PlayerId = util::Tagged<std::uint32_t, detail::PlayerTag>;
+
+/*
+ * Индекс токенов игроков для проверки запросов.
+ * Поиск не захватывает блокировок и не выделяет память: таблица с открытой адресацией
+ * хранит токены в виде пар 64-битных чисел в атомарных ячейках, а новая таблица при росте
+ * публикуется атомарным указателем. Поиск, начатый до роста, дочитывает старую таблицу,
+ * поэтому старые таблицы освобождаются только вместе с индексом. Их суммарный размер
+ * не превышает размера текущей таблицы.
+ * Добавление и удаление выполняются под мьютексом: игроки входят в игру гораздо реже,
+ * чем отправляют запросы.
+ */
+class PlayerTokens {
+public:
+    PlayerTokens();
+
+    PlayerTokens(const PlayerTokens&) = delete;
+    PlayerTokens& operator=(const PlayerTokens&) = delete;
+
+    // Создаёт для игрока новый токен из криптографически стойкого генератора
+    // и добавляет его в индекс
+    Token Add(PlayerId player);
+
+    // Возвращает игрока с токеном token. Может вызываться из любого потока
+    // одновременно с Add и Remove
+    std::optional<PlayerId> Find(std::string_view token) const noexcept;
+
+    // Удаляет токен. Возвращает false, если токена нет в индексе
+    bool Remove(std::string_view token);
+
+private:
+    // Токен в виде двух чисел. Старшая половина никогда не равна нулю:
+    // нулём отмечены свободные ячейки
+    struct Key {
+        std::uint64_t hi = 0;
+        std::uint64_t lo = 0;
+    };
+
+    struct Slot {
+        // Записывается последним: ненулевое значение означает, что lo и player уже записаны
+        std::atomic<std::uint64_t> hi{0};
+        std::atomic<std::uint64_t> lo{0};
+        std::atomic<std::uint64_t> player{REMOVED};
+    };
+
+    struct Table {
+        explicit Table(size_t capacity)
+            : mask{capacity - 1}
+            , slots{std::make_unique<Slot[]>(capacity)} {
+        }
+
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    constexpr static std::uint64_t REMOVED = UINT64_MAX;
+    constexpr static size_t INITIAL_CAPACITY = 64;
+
+    static std::optional<Key> ParseToken(std::string_view token) noexcept;
+    static Token FormatToken(Key key);
+    static Key GenerateKey();
+    static size_t Hash(Key key) noexcept;
+    static const Slot* FindSlot(const Table& table, Key key) noexcept;
+    // Занимает ячейку для ключа. Вызывается под мьютексом
+    static void Insert(Table& table, Key key, std::uint64_t player) noexcept;
+
+    std::atomic<Table*> table_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Table>> tables_;
+    // Количество занятых ячеек текущей таблицы, включая удалённые токены
+    size_t used_ = 0;
+};
+
+}  // namespace app
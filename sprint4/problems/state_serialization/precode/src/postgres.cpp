@@ -0,0 +1,141 @@
+#include "postgres.h"
+
+#include <memory>
+#include <pqxx/transaction>
+#include <pqxx/zview.hxx>
+
+#include "tracing.h"
+
+namespace postgres {
+
+using pqxx::operator"" _zv;
+
+namespace {
+
+struct PreparedStatement {
+    pqxx::zview name;
+    pqxx::zview sql;
+};
+
+// Массивы позволяют одним подготовленным запросом сохранить пакет любого размера
+constexpr auto SAVE_RETIRED = "save_retired"_zv;
+/*
+ * Порядок таблицы рекордов выражен одним возрастающим ключом (-score, play_time_ms, id),
+ * поэтому продолжение страницы - сравнение строк, которое выполняется поиском в индексе.
+ * Индекс включает name и score, и страница читается только из индекса
+ */
+constexpr auto RECORDS_FIRST_PAGE = "records_first_page"_zv;
+constexpr auto RECORDS_PAGE_AFTER = "records_page_after"_zv;
+
+constexpr PreparedStatement PREPARED_STATEMENTS[] = {
+    {SAVE_RETIRED, R"(
+INSERT INTO retired_players (name, score, play_time_ms)
+SELECT * FROM unnest($1::varchar(100)[], $2::bigint[], $3::bigint[]);
+)"_zv},
+    {RECORDS_FIRST_PAGE, R"(
+SELECT id, name, score, play_time_ms FROM retired_players
+ORDER BY (-score), play_time_ms, id
+LIMIT $1;
+)"_zv},
+    {RECORDS_PAGE_AFTER, R"(
+SELECT id, name, score, play_time_ms FROM retired_players
+WHERE ((-score), play_time_ms, id) > (-$1::bigint, $2::bigint, $3::bigint)
+ORDER BY (-score), play_time_ms, id
+LIMIT $4;
+)"_zv},
+};
+
+// Открывает соединение для пула и готовит на нём запросы
+std::unique_ptr<pqxx::connection> Connect(const std::string& url) {
+    auto connection = std::make_unique<pqxx::connection>(url);
+    for (const auto& [name, sql] : PREPARED_STATEMENTS) {
+        connection->prepare(name, sql);
+    }
+    return connection;
+}
+
+std::vector<app::PlayerRecord> ToRecords(const pqxx::result& rows) {
+    std::vector<app::PlayerRecord> records;
+    records.reserve(rows.size());
+    for (const auto& row : rows) {
+        records.push_back({row[0].as<std::uint64_t>(), row[1].as<std::string>(),
+                           row[2].as<model::Score>(), model::TimeInterval{row[3].as<long long>()}});
+    }
+    return records;
+}
+
+}  // namespace
+
+ConnectionPool::ConnectionWrapper RetiredPlayerRepositoryImpl::AcquireConnection(const tracing::Span& parent) {
+    // Ожидание свободного соединения пула - отдельный интервал трассы
+    tracing::Span span{"db.acquire", parent.GetContext()};
+    return pool_.GetConnection();
+}
+
+void RetiredPlayerRepositoryImpl::SaveRetired(const std::vector<model::RetiredDog>& players) {
+    if (players.empty()) {
+        return;
+    }
+
+    std::vector<std::string> names;
+    std::vector<long long> scores;
+    std::vector<long long> play_times;
+    names.reserve(players.size());
+    scores.reserve(players.size());
+    play_times.reserve(players.size());
+    for (const auto& player : players) {
+        names.push_back(player.name);
+        scores.push_back(player.score);
+        play_times.push_back(player.play_time.count());
+    }
+
+    // Запись выполняет поток LeaderboardWriter, поэтому интервал обычно начинает свою трассу
+    const auto span = tracing::StartSpan("db.save_retired");
+    auto connection = AcquireConnection(span);
+    tracing::Span query{"db.query", span.GetContext()};
+    pqxx::work work{*connection};
+    work.exec_prepared(SAVE_RETIRED, names, scores, play_times);
+    work.commit();
+}
+
+std::vector<app::PlayerRecord> RetiredPlayerRepositoryImpl::GetRecords(const std::optional<app::RecordKey>& after,
+                                                                       size_t limit) {
+    const auto span = tracing::StartSpan("db.get_records");
+    auto connection = AcquireConnection(span);
+    tracing::Span query{"db.query", span.GetContext()};
+    pqxx::read_transaction work{*connection};
+    if (!after) {
+        return ToRecords(work.exec_prepared(RECORDS_FIRST_PAGE, limit));
+    }
+    return ToRecords(work.exec_prepared(RECORDS_PAGE_AFTER, static_cast<long long>(after->score),
+                                        static_cast<long long>(after->play_time.count()), after->id, limit));
+}
+
+bool Database::CreateSchema(const std::string& url) {
+    pqxx::connection connection{url};
+    pqxx::work work{connection};
+    work.exec(R"(
+CREATE TABLE IF NOT EXISTS retired_players (
+    id bigint GENERATED ALWAYS AS IDENTITY PRIMARY KEY,
+    name varchar(100) NOT NULL,
+    score bigint NOT NULL,
+    play_time_ms bigint NOT NULL
+);
+DROP INDEX IF EXISTS retired_players_score_idx;
+CREATE INDEX IF NOT EXISTS retired_players_records_idx
+    ON retired_players ((-score), play_time_ms, id) INCLUDE (name, score);
+)"_zv);
+    work.commit();
+    return true;
+}
+
+Database::Database(const DatabaseConfig& config)
+    : schema_created_{CreateSchema(config.url)}
+    , pool_{config.pool_size,
+            [url = config.url] {
+                return Connect(url);
+            },
+            config.wait_timeout} {
+}
+
+}  // namespace postgres
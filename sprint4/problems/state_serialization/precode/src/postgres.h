@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <optional>
+#include <pqxx/connection>
+#include <string>
+#include <vector>
+
+#include "connection_pool.h"
+#include "leaderboard.h"
+#include "leaderboard_writer.h"
+#include "tracing.h"
+
+namespace postgres {
+
+using ConnectionPool = BasicConnectionPool<pqxx::connection>;
+
+/*
+ * Таблица рекордов в PostgreSQL.
+ * Пакет игроков сохраняется одним подготовленным запросом в одной транзакции.
+ * Страница рекордов читается по покрывающему индексу в порядке таблицы: начало страницы
+ * находится поиском в индексе по ключу последней записи предыдущей страницы,
+ * а строки таблицы не читаются
+ */
+class RetiredPlayerRepositoryImpl : public app::RetiredPlayerRepository, public app::RecordsRepository {
+public:
+    explicit RetiredPlayerRepositoryImpl(ConnectionPool& pool)
+        : pool_{pool} {
+    }
+
+    void SaveRetired(const std::vector<model::RetiredDog>& players) override;
+    std::vector<app::PlayerRecord> GetRecords(const std::optional<app::RecordKey>& after,
+                                              size_t limit) override;
+
+private:
+    ConnectionPool::ConnectionWrapper AcquireConnection(const tracing::Span& parent);
+
+    ConnectionPool& pool_;
+};
+
+struct DatabaseConfig {
+    std::string url;
+    // Одно соединение занимает LeaderboardWriter, остальные обслуживают чтение рекордов
+    size_t pool_size = 2;
+    // Сколько ждать свободного соединения, прежде чем сообщить об ошибке
+    std::chrono::milliseconds wait_timeout{5000};
+};
+
+class Database {
+public:
+    // Создаёт таблицы и индексы, если их нет, и открывает соединения пула
+    explicit Database(const DatabaseConfig& config);
+
+    RetiredPlayerRepositoryImpl& GetRetiredPlayers() & {
+        return retired_players_;
+    }
+
+private:
+    static bool CreateSchema(const std::string& url);
+
+    // Запросы готовятся на соединениях пула при их открытии, а подготовить запрос можно
+    // только к существующим таблицам. Поэтому схема создаётся отдельным соединением
+    // при инициализации этого поля, объявленного раньше пула
+    bool schema_created_;
+    ConnectionPool pool_;
+    RetiredPlayerRepositoryImpl retired_players_{pool_};
+};
+
+}  // namespace postgres
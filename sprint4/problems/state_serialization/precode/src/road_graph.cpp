@@ -0,0 +1,267 @@
+#include "road_graph.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+namespace model {
+
+namespace {
+
+// Дорога как отрезок на прямой: line - общая координата точек дороги, [from, to] - диапазон другой
+struct Segment {
+    size_t road;
+    Coord line;
+    Coord from;
+    Coord to;
+};
+
+Point MakePoint(bool horizontal, Coord line, Coord along) noexcept {
+    return horizontal ? Point{along, line} : Point{line, along};
+}
+
+RoadGraph::Distance Manhattan(Point lhs, Point rhs) noexcept {
+    return std::abs(RoadGraph::Distance{lhs.x} - rhs.x) + std::abs(RoadGraph::Distance{lhs.y} - rhs.y);
+}
+
+}  // namespace
+
+RoadGraph::RoadGraph(const Map::Roads& roads) {
+    // Дорога нулевой длины считается горизонтальной
+    std::vector<Segment> horizontal;
+    std::vector<Segment> vertical;
+    for (size_t i = 0; i < roads.size(); ++i) {
+        const auto start = roads[i].GetStart();
+        const auto end = roads[i].GetEnd();
+        if (roads[i].IsHorizontal()) {
+            horizontal.push_back({i, start.y, std::min(start.x, end.x), std::max(start.x, end.x)});
+        } else {
+            vertical.push_back({i, start.x, std::min(start.y, end.y), std::max(start.y, end.y)});
+        }
+    }
+
+    // Координаты вершин вдоль каждой дороги: её концы и перекрёстки с другими дорогами
+    std::vector<std::vector<Coord>> stops(roads.size());
+    for (const auto* segments : {&horizontal, &vertical}) {
+        for (const auto& segment : *segments) {
+            stops[segment.road] = {segment.from, segment.to};
+        }
+    }
+
+    // Пересечения горизонтальных и вертикальных дорог. Вертикальные упорядочены по x,
+    // поэтому для горизонтальной дороги перебираются только те, что лежат в её диапазоне
+    auto by_line = [](const Segment& lhs, const Segment& rhs) {
+        return std::tie(lhs.line, lhs.from) < std::tie(rhs.line, rhs.from);
+    };
+    std::sort(vertical.begin(), vertical.end(), by_line);
+    for (const auto& h : horizontal) {
+        auto it = std::lower_bound(vertical.begin(), vertical.end(), h.from, [](const Segment& v, Coord x) {
+            return v.line < x;
+        });
+        for (; it != vertical.end() && it->line <= h.to; ++it) {
+            if (it->from <= h.line && h.line <= it->to) {
+                stops[h.road].push_back(it->line);
+                stops[it->road].push_back(h.line);
+            }
+        }
+    }
+
+    // Дороги на одной прямой, которые перекрываются или стыкуются, получают концы друг друга,
+    // чтобы общий участок состоял из одних и тех же вершин
+    std::sort(horizontal.begin(), horizontal.end(), by_line);
+    for (const auto* segments : {&horizontal, &vertical}) {
+        for (auto first = segments->begin(); first != segments->end(); ++first) {
+            for (auto second = std::next(first);
+                 second != segments->end() && second->line == first->line && second->from <= first->to;
+                 ++second) {
+                for (const Coord end : {second->from, second->to}) {
+                    if (end <= first->to) {
+                        stops[first->road].push_back(end);
+                    }
+                }
+                if (first->to <= second->to) {
+                    stops[second->road].push_back(first->to);
+                }
+            }
+        }
+    }
+
+    // Вершины и рёбра между соседними вершинами каждой дороги
+    auto get_node = [this](Point point) {
+        auto [it, inserted] = node_ids_.try_emplace(point, static_cast<NodeId>(nodes_.size()));
+        if (inserted) {
+            if (nodes_.size() == NO_NODE) {
+                throw std::length_error("Too many road graph nodes");
+            }
+            nodes_.push_back(point);
+        }
+        return it->second;
+    };
+    std::vector<std::tuple<NodeId, NodeId, Distance>> links;
+    for (size_t i = 0; i < roads.size(); ++i) {
+        auto& road_stops = stops[i];
+        std::sort(road_stops.begin(), road_stops.end());
+        road_stops.erase(std::unique(road_stops.begin(), road_stops.end()), road_stops.end());
+
+        const bool is_horizontal = roads[i].IsHorizontal();
+        const Coord line = is_horizontal ? roads[i].GetStart().y : roads[i].GetStart().x;
+        NodeId prev = get_node(MakePoint(is_horizontal, line, road_stops.front()));
+        for (size_t j = 1; j < road_stops.size(); ++j) {
+            const NodeId node = get_node(MakePoint(is_horizontal, line, road_stops[j]));
+            const Distance length = Distance{road_stops[j]} - road_stops[j - 1];
+            links.emplace_back(prev, node, length);
+            links.emplace_back(node, prev, length);
+            prev = node;
+        }
+    }
+
+    // Перекрывающиеся дороги дают одинаковые рёбра, в списках соседей они остаются по одному разу
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end(),
+                            [](const auto& lhs, const auto& rhs) {
+                                return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs);
+                            }),
+                links.end());
+    offsets_.assign(nodes_.size() + 1, 0);
+    edges_.reserve(links.size());
+    for (const auto& [from, to, length] : links) {
+        ++offsets_[from + 1];
+        edges_.push_back({to, length});
+    }
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+    if (nodes_.size() <= ALL_PAIRS_LIMIT) {
+        ComputeAllPairs();
+    }
+}
+
+std::optional<RoadGraph::NodeId> RoadGraph::FindNode(Point point) const {
+    if (const auto it = node_ids_.find(point); it != node_ids_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<RoadGraph::Distance> RoadGraph::GetDistance(NodeId from, NodeId to) const {
+    const size_t n = nodes_.size();
+    if (!all_distances_.empty()) {
+        const Distance distance = all_distances_[from * n + to];
+        return distance == UNREACHABLE ? std::nullopt : std::optional{distance};
+    }
+
+    // Расстояние симметрично, поэтому пара хранится в кэше один раз
+    const std::uint64_t key = (std::uint64_t(std::min(from, to)) << 32) | std::max(from, to);
+    {
+        std::lock_guard lock{cache_->mutex};
+        if (const auto it = cache_->distances.find(key); it != cache_->distances.end()) {
+            return it->second == UNREACHABLE ? std::nullopt : std::optional{it->second};
+        }
+    }
+    std::vector<Distance> distances;
+    std::vector<NodeId> parents;
+    const Distance distance = Search(from, to, distances, parents);
+    {
+        std::lock_guard lock{cache_->mutex};
+        if (cache_->distances.size() >= MAX_CACHED_DISTANCES) {
+            cache_->distances.clear();
+        }
+        cache_->distances.emplace(key, distance);
+    }
+    return distance == UNREACHABLE ? std::nullopt : std::optional{distance};
+}
+
+std::vector<RoadGraph::NodeId> RoadGraph::FindPath(NodeId from, NodeId to) const {
+    const size_t n = nodes_.size();
+    std::vector<NodeId> path;
+    if (!all_distances_.empty()) {
+        if (all_distances_[from * n + to] == UNREACHABLE) {
+            return path;
+        }
+        path.push_back(from);
+        for (NodeId node = from; node != to;) {
+            node = next_hops_[node * n + to];
+            path.push_back(node);
+        }
+        return path;
+    }
+
+    std::vector<Distance> distances;
+    std::vector<NodeId> parents;
+    if (Search(from, to, distances, parents) == UNREACHABLE) {
+        return path;
+    }
+    for (NodeId node = to; node != NO_NODE; node = parents[node]) {
+        path.push_back(node);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+RoadGraph::Distance RoadGraph::Search(NodeId from, std::optional<NodeId> target,
+                                      std::vector<Distance>& distances, std::vector<NodeId>& parents) const {
+    distances.assign(nodes_.size(), UNREACHABLE);
+    parents.assign(nodes_.size(), NO_NODE);
+    // Без цели оценка нулевая, и A* превращается в алгоритм Дейкстры
+    auto estimate = [&](NodeId node) -> Distance {
+        return target ? Manhattan(nodes_[node], nodes_[*target]) : 0;
+    };
+
+    // Элементы очереди - (расстояние + оценка, вершина), первой извлекается наименьшая сумма
+    using Entry = std::pair<Distance, NodeId>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+    distances[from] = 0;
+    queue.emplace(estimate(from), from);
+    while (!queue.empty()) {
+        const auto [priority, node] = queue.top();
+        queue.pop();
+        if (priority - estimate(node) > distances[node]) {
+            continue;  // Устаревшая запись: вершина уже извлечена с меньшим расстоянием
+        }
+        if (target && node == *target) {
+            return distances[node];
+        }
+        for (const auto& edge : GetNeighbours(node)) {
+            const Distance distance = distances[node] + edge.length;
+            if (distances[edge.to] == UNREACHABLE || distance < distances[edge.to]) {
+                distances[edge.to] = distance;
+                parents[edge.to] = node;
+                queue.emplace(distance + estimate(edge.to), edge.to);
+            }
+        }
+    }
+    return target ? distances[*target] : UNREACHABLE;
+}
+
+void RoadGraph::ComputeAllPairs() {
+    const size_t n = nodes_.size();
+    all_distances_.assign(n * n, UNREACHABLE);
+    next_hops_.assign(n * n, NO_NODE);
+
+    std::vector<Distance> distances;
+    std::vector<NodeId> parents;
+    std::vector<NodeId> order(n);
+    for (NodeId from = 0; from < n; ++from) {
+        Search(from, std::nullopt, distances, parents);
+        std::copy(distances.begin(), distances.end(), all_distances_.begin() + from * n);
+
+        // Первый шаг пути к вершине совпадает с первым шагом пути к её предшественнику.
+        // Вершины обходятся по возрастанию расстояния, так что предшественник уже обработан
+        std::iota(order.begin(), order.end(), NodeId{0});
+        std::sort(order.begin(), order.end(), [&distances](NodeId lhs, NodeId rhs) {
+            return distances[lhs] < distances[rhs];
+        });
+        NodeId* hops = next_hops_.data() + from * n;
+        for (const NodeId node : order) {
+            if (distances[node] == UNREACHABLE || node == from) {
+                continue;
+            }
+            hops[node] = parents[node] == from ? node : hops[parents[node]];
+        }
+    }
+}
+
+}  // namespace model
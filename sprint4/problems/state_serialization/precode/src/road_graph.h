@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "model.h"
+
+namespace model {
+
+/*
+ * Граф перекрёстков дорог карты для перехода с дороги на дорогу и поиска путей.
+ * Вершины - концы дорог и точки, где дороги пересекаются, примыкают друг к другу
+ * или перекрываются. Рёбра - участки дорог между соседними вершинами одной дороги.
+ * Граф строится один раз после загрузки карты. Вершина находится по точке через хеш-таблицу,
+ * а её соседи лежат подряд в одном массиве, поэтому оба действия занимают O(1).
+ *
+ * Кратчайшие расстояния по дорогам для небольших карт, не больше ALL_PAIRS_LIMIT вершин,
+ * вычисляются заранее для всех пар вместе с первым шагом пути. На больших картах путь
+ * ищется A* с манхэттенским расстоянием в качестве оценки: по дорогам, параллельным осям,
+ * путь не бывает короче. Найденные расстояния кэшируются. Методы поиска можно вызывать
+ * из разных потоков одновременно
+ */
+class RoadGraph {
+public:
+    using NodeId = std::uint32_t;
+    using Distance = std::int64_t;
+
+    constexpr static size_t ALL_PAIRS_LIMIT = 256;
+    // При переполнении кэш расстояний очищается целиком
+    constexpr static size_t MAX_CACHED_DISTANCES = 1 << 16;
+
+    struct Edge {
+        NodeId to;
+        Distance length;
+    };
+
+    explicit RoadGraph(const Map::Roads& roads);
+
+    explicit RoadGraph(const Map& map)
+        : RoadGraph(map.GetRoads()) {
+    }
+
+    size_t GetNodeCount() const noexcept {
+        return nodes_.size();
+    }
+
+    Point GetNode(NodeId node) const noexcept {
+        return nodes_[node];
+    }
+
+    // Вершина в точке point, если там конец дороги или перекрёсток
+    std::optional<NodeId> FindNode(Point point) const;
+
+    // Соседние вершины, в которые можно попасть, не проходя через другие вершины
+    std::span<const Edge> GetNeighbours(NodeId node) const noexcept {
+        return {edges_.data() + offsets_[node], edges_.data() + offsets_[node + 1]};
+    }
+
+    // Длина кратчайшего пути по дорогам либо std::nullopt, если to недостижима из from
+    std::optional<Distance> GetDistance(NodeId from, NodeId to) const;
+
+    // Вершины кратчайшего пути от from до to включительно. Пуст, если to недостижима
+    std::vector<NodeId> FindPath(NodeId from, NodeId to) const;
+
+private:
+    struct PointHasher {
+        size_t operator()(Point point) const noexcept {
+            return std::hash<std::uint64_t>{}((std::uint64_t(std::uint32_t(point.x)) << 32)
+                                              | std::uint32_t(point.y));
+        }
+    };
+
+    struct DistanceCache {
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, Distance> distances;
+    };
+
+    constexpr static Distance UNREACHABLE = -1;
+    constexpr static NodeId NO_NODE = ~NodeId{0};
+
+    /*
+     * Дейкстра от from, или A* с остановкой в target, если он задан. Заполняет расстояния
+     * и предшественников найденных вершин. Возвращает расстояние до target
+     */
+    Distance Search(NodeId from, std::optional<NodeId> target, std::vector<Distance>& distances,
+                    std::vector<NodeId>& parents) const;
+    void ComputeAllPairs();
+
+    std::vector<Point> nodes_;
+    std::unordered_map<Point, NodeId, PointHasher> node_ids_;
+    // Соседи вершины i - edges_[offsets_[i]] .. edges_[offsets_[i + 1] - 1]
+    std::vector<size_t> offsets_;
+    std::vector<Edge> edges_;
+
+    // Для небольших карт: расстояние и первый шаг пути из i в j в ячейке i * n + j
+    std::vector<Distance> all_distances_;
+    std::vector<NodeId> next_hops_;
+    // Для больших карт. В unique_ptr, чтобы граф можно было перемещать
+    std::unique_ptr<DistanceCache> cache_ = std::make_unique<DistanceCache>();
+};
+
+}  // namespace model
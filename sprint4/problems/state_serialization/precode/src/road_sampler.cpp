@@ -0,0 +1,76 @@
+#include "road_sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace model {
+
+RoadSampler::RoadSampler(const Map::Roads& roads) {
+    const size_t count = roads.size();
+    if (count == 0) {
+        throw std::invalid_argument("Map has no roads to place objects on");
+    }
+    if (count > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Too many roads");
+    }
+
+    start_x_.reserve(count);
+    start_y_.reserve(count);
+    dx_.reserve(count);
+    dy_.reserve(count);
+    double total_length = 0;
+    for (const auto& road : roads) {
+        const auto start = road.GetStart();
+        const auto end = road.GetEnd();
+        start_x_.push_back(start.x);
+        start_y_.push_back(start.y);
+        dx_.push_back(end.x - start.x);
+        dy_.push_back(end.y - start.y);
+        // Дороги параллельны осям, поэтому длина — сумма модулей смещений
+        total_length += std::abs(dx_.back()) + std::abs(dy_.back());
+    }
+
+    // Масштабируем длины так, чтобы их среднее было равно 1
+    std::vector<double> weights(count, 1.0);
+    if (total_length > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            weights[i] = (std::abs(dx_[i]) + std::abs(dy_[i])) * count / total_length;
+        }
+    }
+
+    // Алгоритм Воуза: ячейке лёгкой дороги достаётся недостающая часть тяжёлой
+    threshold_.assign(count, 1.0);
+    alias_.resize(count);
+    std::vector<std::uint32_t> light, heavy;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        alias_[i] = i;
+        (weights[i] < 1 ? light : heavy).push_back(i);
+    }
+    while (!light.empty() && !heavy.empty()) {
+        const auto small = light.back();
+        const auto large = heavy.back();
+        light.pop_back();
+        threshold_[small] = weights[small];
+        alias_[small] = large;
+        weights[large] -= 1 - weights[small];
+        if (weights[large] < 1) {
+            heavy.pop_back();
+            light.push_back(large);
+        }
+    }
+    // Оставшиеся ячейки отличаются от 1 лишь на погрешность округления
+    // и целиком принадлежат своим дорогам
+}
+
+geom::Point2D RoadSampler::GetPoint(double road_choice, double offset) const noexcept {
+    const size_t count = threshold_.size();
+    const double scaled = std::clamp(road_choice, 0.0, 1.0) * count;
+    const size_t cell = std::min(static_cast<size_t>(scaled), count - 1);
+    const size_t road = scaled - cell < threshold_[cell] ? cell : alias_[cell];
+    offset = std::clamp(offset, 0.0, 1.0);
+    return {start_x_[road] + dx_[road] * offset, start_y_[road] + dy_[road] * offset};
+}
+
+}  // namespace model
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "geom.h"
+#include "model.h"
+
+namespace model {
+
+/*
+ * Выбор случайной точки на дорогах карты, например для размещения потерянных предметов.
+ * Точка равномерно распределена по длине всех дорог: дорога выбирается с вероятностью,
+ * пропорциональной её длине, по таблице псевдонимов (alias method), а точка на дороге —
+ * равномерно вдоль её оси. Поэтому выбор занимает O(1) независимо от количества дорог.
+ * Таблица строится один раз после загрузки карты, за O(n)
+ */
+class RoadSampler {
+public:
+    // Если на карте нет дорог, выбрасывает std::invalid_argument.
+    // Если все дороги нулевой длины, каждая из них выбирается с равной вероятностью
+    explicit RoadSampler(const Map::Roads& roads);
+
+    explicit RoadSampler(const Map& map)
+        : RoadSampler(map.GetRoads()) {
+    }
+
+    size_t GetRoadsCount() const noexcept {
+        return start_x_.size();
+    }
+
+    // Возвращает точку, заданную двумя числами из [0, 1]: road_choice выбирает дорогу,
+    // offset — положение точки вдоль неё
+    geom::Point2D GetPoint(double road_choice, double offset) const noexcept;
+
+    // Возвращает случайную точку. random() возвращает равномерно распределённые числа
+    // в [0, 1], как и генератор у loot_gen::LootGenerator
+    template <typename Random>
+    geom::Point2D GetRandomPoint(Random&& random) const {
+        const double road_choice = random();
+        return GetPoint(road_choice, random());
+    }
+
+    // Заполняет points случайными точками. Удобно, когда генератор добыч вернул
+    // сразу несколько новых предметов
+    template <typename Random>
+    void GetRandomPoints(std::span<geom::Point2D> points, Random&& random) const {
+        for (auto& point : points) {
+            point = GetRandomPoint(random);
+        }
+    }
+
+private:
+    // Дорога i начинается в (start_x_[i], start_y_[i]) и смещается до конца на (dx_[i], dy_[i])
+    std::vector<double> start_x_;
+    std::vector<double> start_y_;
+    std::vector<double> dx_;
+    std::vector<double> dy_;
+    // Таблица псевдонимов: ячейка i выбирает дорогу i с вероятностью threshold_[i]
+    // и дорогу alias_[i] в остальных случаях
+    std::vector<double> threshold_;
+    std::vector<std::uint32_t> alias_;
+};
+
+}  // namespace model
@@ -0,0 +1,142 @@
+#include "state_log.h"
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "dog_archive.h"
+#include "durable_file.h"
+
+namespace serialization {
+
+using namespace std::literals;
+
+namespace {
+
+// Запись журнала: собаки, изменившиеся между двумя сохранениями, и номера удалённых собак
+std::string DeltaToArchive(const StateLog::Changes& changes) {
+    std::string data;
+    WriteDogs(changes.changed, data);
+    WriteU32Array(changes.removed, data);
+    return data;
+}
+
+StateLog::Changes DeltaFromArchive(std::string_view data) {
+    StateLog::Changes changes;
+    changes.changed = ReadDogs(data);
+    changes.removed = ReadU32Array(data);
+    if (!data.empty()) {
+        throw std::runtime_error("Unexpected data after state log record"s);
+    }
+    return changes;
+}
+
+}  // namespace
+
+StateLog::StateLog(std::filesystem::path path)
+    : snapshot_path_{std::move(path)}
+    , log_path_{snapshot_path_.string() + ".log"s}
+    , snapshot_size_{GetFileSize(snapshot_path_)}
+    , log_size_{GetFileSize(log_path_)} {
+}
+
+StateLog::Changes StateLog::Capture(model::DogRegistry& dogs) const {
+    Changes changes;
+    // Первое сохранение сразу записывает снимок. Снимок никогда не бывает пустым:
+    // архив содержит как минимум заголовок
+    if (snapshot_size_ == 0 || log_size_ > std::max(snapshot_size_, MIN_COMPACTION_SIZE)) {
+        changes.snapshot.emplace(dogs);
+    } else {
+        dogs.ForEachChange(
+            [&](size_t index) {
+                changes.changed.Add(dogs.Get(index));
+            },
+            [&](const model::Dog::Id& id) {
+                changes.removed.push_back(*id);
+            });
+    }
+    dogs.ClearChanges();
+    return changes;
+}
+
+void StateLog::Write(const Changes& changes) {
+    try {
+        if (changes.snapshot) {
+            WriteSnapshot(*changes.snapshot);
+        } else {
+            AppendDelta(changes);
+        }
+    } catch (...) {
+        // Изменения уже не отмечены в реестре, поэтому восстановить целостность
+        // журнала может только полный снимок
+        snapshot_size_ = 0;
+        throw;
+    }
+}
+
+void StateLog::WriteSnapshot(const model::DogRegistry& dogs) {
+    std::string data;
+    WriteDogs(dogs, data);
+
+    // Журнал очищается после замены снимка: если процесс завершится между этими шагами,
+    // записи журнала лишь повторят состояние снимка
+    ReplaceFile(snapshot_path_, data);
+    File{log_path_, O_WRONLY | O_CREAT | O_TRUNC}.Sync();
+    snapshot_size_ = data.size();
+    log_size_ = 0;
+}
+
+void StateLog::AppendDelta(const Changes& changes) {
+    if (changes.changed.Size() == 0 && changes.removed.empty()) {
+        return;
+    }
+
+    std::string record;
+    AppendRecord(record, DeltaToArchive(changes));
+    File file{log_path_, O_WRONLY | O_CREAT | O_APPEND};
+    file.Write(record);
+    file.Sync();
+    log_size_ += record.size();
+}
+
+std::vector<model::Dog> StateLog::Load() const {
+    model::DogRegistry state;
+
+    if (const auto data = ReadFile(snapshot_path_)) {
+        std::string_view rest = *data;
+        state = ReadDogs(rest);
+        if (!rest.empty()) {
+            throw std::runtime_error("Unexpected data after state snapshot"s);
+        }
+    }
+
+    if (const auto log = ReadFile(log_path_)) {
+        std::string_view rest = *log;
+        // Оборванная запись в конце журнала отбрасывается
+        while (const auto data = ReadRecord(rest)) {
+            // Удаления применяются первыми: собака могла быть удалена и добавлена заново
+            const auto delta = DeltaFromArchive(*data);
+            for (const auto id : delta.removed) {
+                state.Remove(model::Dog::Id{id});
+            }
+            for (size_t i = 0; i < delta.changed.Size(); ++i) {
+                state.Remove(delta.changed.GetId(i));
+                state.Add(delta.changed.Get(i));
+            }
+        }
+    }
+
+    // Собаки упорядочены по Id, чтобы порядок восстановления не зависел от истории изменений
+    std::vector<model::Dog> dogs;
+    dogs.reserve(state.Size());
+    for (size_t i = 0; i < state.Size(); ++i) {
+        dogs.push_back(state.Get(i));
+    }
+    std::sort(dogs.begin(), dogs.end(), [](const model::Dog& lhs, const model::Dog& rhs) {
+        return *lhs.GetId() < *rhs.GetId();
+    });
+    return dogs;
+}
+
+}  // namespace serialization
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "model.h"
+
+namespace serialization {
+
+/*
+ * Инкрементальное сохранение состояния собак игрового сеанса.
+ * Состояние хранится в двух файлах: полном снимке path и журнале изменений path.log.
+ * Каждое сохранение дописывает в журнал только собак, изменившихся с прошлого сохранения,
+ * и удалённых собак, поэтому его стоимость пропорциональна числу изменений, а не размеру
+ * мира. Первое сохранение и сохранение, при котором журнал оказался больше снимка,
+ * записывают полный снимок и очищают журнал. Так суммарная стоимость сохранений
+ * остаётся пропорциональной числу изменений.
+ * Снимок и записи журнала хранят собак в формате dog_archive.h.
+ * Записи журнала снабжены длиной и контрольной суммой: запись, оборванная при аварийном
+ * завершении, при загрузке отбрасывается вместе со всеми следующими.
+ *
+ * Сохранение разделено на два шага. Capture быстро копирует изменения и выполняется там же,
+ * где изменяется мир. Write сериализует и записывает их на диск и может выполняться
+ * в другом потоке (см. BackgroundSaver)
+ */
+class StateLog {
+public:
+    // Изменения, захваченные для записи
+    struct Changes {
+        // Копия всех собак, если нужно записать полный снимок. Копирование столбцов
+        // обходится дешевле, чем сборка каждой собаки в отдельный объект
+        std::optional<model::DogRegistry> snapshot;
+        model::DogRegistry changed;
+        std::vector<std::uint32_t> removed;
+    };
+
+    explicit StateLog(std::filesystem::path path);
+
+    // Захватывает изменения собак dogs и сбрасывает отметки об изменениях.
+    // Не должен выполняться одновременно с Write
+    Changes Capture(model::DogRegistry& dogs) const;
+
+    // Записывает изменения на диск и дожидается, пока они попадут на носитель.
+    // Если запись не удалась, следующий Capture захватит полный снимок
+    void Write(const Changes& changes);
+
+    // Захватывает и сразу записывает изменения
+    void Save(model::DogRegistry& dogs) {
+        Write(Capture(dogs));
+    }
+
+    // Загружает собак из снимка и журнала. Если файлов нет, возвращает пустой вектор
+    std::vector<model::Dog> Load() const;
+
+    const std::filesystem::path& GetSnapshotPath() const noexcept {
+        return snapshot_path_;
+    }
+
+    const std::filesystem::path& GetLogPath() const noexcept {
+        return log_path_;
+    }
+
+private:
+    // Журнал не сжимается, пока меньше этого размера
+    constexpr static std::uintmax_t MIN_COMPACTION_SIZE = 64 * 1024;
+
+    void WriteSnapshot(const model::DogRegistry& dogs);
+    void AppendDelta(const Changes& changes);
+
+    std::filesystem::path snapshot_path_;
+    std::filesystem::path log_path_;
+    std::uintmax_t snapshot_size_ = 0;
+    std::uintmax_t log_size_ = 0;
+};
+
+}  // namespace serialization
@@ -0,0 +1,110 @@
+#include "ticker.h"
+
+#include <boost/asio/dispatch.hpp>
+
+#include "tracing.h"
+
+namespace app {
+
+TickInfo TickPacer::BeginTick(Clock::time_point now) noexcept {
+    // Шаг next_tick_ наступил, каждый следующий полный шаг до now пропущен
+    const auto missed = static_cast<std::uint64_t>(std::max(now - next_tick_, Clock::duration{}) / step_);
+    const auto steps = static_cast<unsigned>(std::min<std::uint64_t>(missed + 1, MAX_COALESCED_STEPS));
+    if (steps > 1) {
+        coalesced_steps_.fetch_add(steps - 1, std::memory_order_relaxed);
+    }
+    if (missed + 1 > steps) {
+        dropped_steps_.fetch_add(missed + 1 - steps, std::memory_order_relaxed);
+        next_tick_ = now + step_;
+    } else {
+        next_tick_ += step_ * steps;
+    }
+    lagging_ = steps > 1;
+    return {.dt = step_ * steps, .steps = steps, .overloaded = overloaded_};
+}
+
+void TickPacer::EndTick(Clock::time_point start, Clock::time_point end) noexcept {
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+    if (overloaded_) {
+        overloaded_ticks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    const auto duration = end - start;
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    last_duration_us_.store(us, std::memory_order_relaxed);
+    if (us > max_duration_us_.load(std::memory_order_relaxed)) {
+        // Пишет только владелец расписания, поэтому сравнение и запись не гонятся друг с другом
+        max_duration_us_.store(us, std::memory_order_relaxed);
+    }
+    const bool overrun = duration > step_;
+    if (overrun) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (overrun || lagging_) {
+        overloaded_ = true;
+        calm_ticks_ = 0;
+    } else if (overloaded_) {
+        calm_ticks_ = duration * 2 <= step_ ? calm_ticks_ + 1 : 0;
+        overloaded_ = calm_ticks_ < RECOVERY_TICKS;
+    }
+    status_overloaded_.store(overloaded_, std::memory_order_relaxed);
+}
+
+TickerStatus TickPacer::GetStatus() const noexcept {
+    return {.overloaded = status_overloaded_.load(std::memory_order_relaxed),
+            .ticks = ticks_.load(std::memory_order_relaxed),
+            .coalesced_steps = coalesced_steps_.load(std::memory_order_relaxed),
+            .dropped_steps = dropped_steps_.load(std::memory_order_relaxed),
+            .overruns = overruns_.load(std::memory_order_relaxed),
+            .overloaded_ticks = overloaded_ticks_.load(std::memory_order_relaxed),
+            .last_duration = std::chrono::microseconds{last_duration_us_.load(std::memory_order_relaxed)},
+            .max_duration = std::chrono::microseconds{max_duration_us_.load(std::memory_order_relaxed)}};
+}
+
+Ticker::Ticker(Strand strand, Step step, Handler handler)
+    : strand_{strand}
+    , timer_{strand_}
+    , handler_{std::move(handler)}
+    , pacer_{step} {
+}
+
+void Ticker::Start() {
+    net::dispatch(strand_, [self = shared_from_this()] {
+        self->stopped_ = false;
+        self->pacer_.Start(Clock::now());
+        self->ScheduleTick();
+    });
+}
+
+void Ticker::Stop() {
+    net::dispatch(strand_, [self = shared_from_this()] {
+        self->stopped_ = true;
+        self->timer_.cancel();
+    });
+}
+
+void Ticker::ScheduleTick() {
+    timer_.expires_at(pacer_.GetNextTick());
+    // Таймер создан с исполнителем strand_, поэтому обработчик выполняется в strand
+    timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+        self->OnTick(ec);
+    });
+}
+
+void Ticker::OnTick(sys::error_code ec) {
+    if (ec || stopped_) {
+        return;
+    }
+    const auto start = Clock::now();
+    const auto tick = pacer_.BeginTick(start);
+    {
+        // Каждый тик - корневой интервал своей трассы. Работа, которую обработчик передаёт
+        // дальше через tracing::BindContext, попадает в ту же трассу
+        const auto span = tracing::Span::StartRoot("game.tick");
+        const tracing::ContextScope scope{span.GetContext()};
+        handler_(tick);
+    }
+    pacer_.EndTick(start, Clock::now());
+    ScheduleTick();
+}
+
+}  // namespace app
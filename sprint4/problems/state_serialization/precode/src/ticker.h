@@ -0,0 +1,153 @@
+#pragma once
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace app {
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+
+// Один вызов обработчика Ticker
+struct TickInfo {
+    // Игровое время, на которое продвигается тик: шаг, умноженный на steps
+    std::chrono::milliseconds dt{};
+    // Сколько шагов объединено в тик. Больше 1, если вызовы отстали от реального времени
+    unsigned steps = 1;
+    // Тики не укладываются в шаг. Обработчику следует пропускать необязательную работу
+    bool overloaded = false;
+};
+
+// Показатели нагрузки Ticker
+struct TickerStatus {
+    bool overloaded = false;
+    std::uint64_t ticks = 0;
+    // Шаги, объединённые с другими, и шаги, отброшенные сверх MAX_COALESCED_STEPS
+    std::uint64_t coalesced_steps = 0;
+    std::uint64_t dropped_steps = 0;
+    // Тики, обработка которых заняла больше шага
+    std::uint64_t overruns = 0;
+    // Тики, выполненные в режиме перегрузки
+    std::uint64_t overloaded_ticks = 0;
+    std::chrono::microseconds last_duration{};
+    std::chrono::microseconds max_duration{};
+};
+
+/*
+ * Расписание тиков Ticker без таймера: объединение пропущенных шагов и учёт перегрузки.
+ * Моменты времени передаются явно, поэтому расписание можно проверить, не дожидаясь таймера.
+ *
+ * Если тик наступил позже своего момента, пропущенные шаги объединяются с ним в один тик
+ * с большим dt, но не более MAX_COALESCED_STEPS: остальное отставание отбрасывается,
+ * чтобы перегруженный сервер не пытался догнать время бесконечно.
+ * Бюджет тика - его шаг. Тик, превысивший бюджет, или отставание включают режим перегрузки,
+ * а RECOVERY_TICKS тиков подряд без отставания и не дольше половины шага выключают его.
+ *
+ * Не синхронизирован, кроме GetStatus, который можно вызывать из любого потока
+ */
+class TickPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Step = std::chrono::milliseconds;
+
+    constexpr static unsigned MAX_COALESCED_STEPS = 5;
+    constexpr static unsigned RECOVERY_TICKS = 20;
+
+    explicit TickPacer(Step step) noexcept
+        : step_{std::max(step, Step{1})} {
+    }
+
+    TickPacer(const TickPacer&) = delete;
+    TickPacer& operator=(const TickPacer&) = delete;
+
+    // Первый тик наступит через шаг после now
+    void Start(Clock::time_point now) noexcept {
+        next_tick_ = now + step_;
+    }
+
+    Clock::time_point GetNextTick() const noexcept {
+        return next_tick_;
+    }
+
+    // Начинает тик в момент now, не раньше GetNextTick(), и переносит следующий тик
+    TickInfo BeginTick(Clock::time_point now) noexcept;
+    // Завершает тик, начатый BeginTick(start), в момент end
+    void EndTick(Clock::time_point start, Clock::time_point end) noexcept;
+
+    TickerStatus GetStatus() const noexcept;
+
+private:
+    Step step_;
+    Clock::time_point next_tick_;
+    bool overloaded_ = false;
+    // Текущий тик объединил несколько шагов
+    bool lagging_ = false;
+    // Тики подряд, уложившиеся в половину шага, с начала перегрузки
+    unsigned calm_ticks_ = 0;
+
+    std::atomic<bool> status_overloaded_{false};
+    std::atomic<std::uint64_t> ticks_{0};
+    std::atomic<std::uint64_t> coalesced_steps_{0};
+    std::atomic<std::uint64_t> dropped_steps_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+    std::atomic<std::uint64_t> overloaded_ticks_{0};
+    std::atomic<std::int64_t> last_duration_us_{0};
+    std::atomic<std::int64_t> max_duration_us_{0};
+};
+
+/*
+ * Вызывает обработчик в strand с фиксированным шагом игрового времени.
+ * Моменты вызовов отсчитываются от запуска, поэтому задержки обработчиков не накапливаются.
+ * Отставшие тики объединяются, а длительность каждого вызова обработчика измеряется
+ * (см. TickPacer). В режиме перегрузки обработчик получает TickInfo::overloaded и может
+ * пропускать необязательную работу, например генерацию предметов или частую рассылку состояния.
+ *
+ * Каждому игровому сеансу полагается свой strand, в котором выполняются и Tick, и все
+ * остальные обращения к сеансу:
+ *
+ *  auto strand = net::make_strand(ioc);
+ *  auto ticker = std::make_shared<Ticker>(strand, 50ms, [&session](const TickInfo& tick) {
+ *      session.Tick(tick.dt);
+ *  });
+ *  ticker->Start();
+ */
+class Ticker : public std::enable_shared_from_this<Ticker> {
+public:
+    using Strand = net::strand<net::io_context::executor_type>;
+    using Clock = TickPacer::Clock;
+    using Step = TickPacer::Step;
+    using Handler = std::function<void(const TickInfo& tick)>;
+
+    Ticker(Strand strand, Step step, Handler handler);
+
+    Ticker(const Ticker&) = delete;
+    Ticker& operator=(const Ticker&) = delete;
+
+    // Может быть вызван из любого потока
+    void Start();
+    // Прекращает вызовы обработчика. Может быть вызван из любого потока
+    void Stop();
+
+    // Может быть вызван из любого потока
+    TickerStatus GetStatus() const noexcept {
+        return pacer_.GetStatus();
+    }
+
+private:
+    void ScheduleTick();
+    void OnTick(sys::error_code ec);
+
+    Strand strand_;
+    net::steady_timer timer_;
+    Handler handler_;
+    TickPacer pacer_;
+    bool stopped_ = false;
+};
+
+}  // namespace app
@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ * Иерархическое колесо сроков, отсчитываемых в игровом времени.
+ * Время делится на ячейки длиной resolution. Ближайшие сроки хранятся в ячейках
+ * младшего уровня, дальние - в более крупных ячейках старших уровней и переносятся вниз,
+ * когда до них доходит очередь. Добавление элемента выполняется за O(1), а продвижение
+ * времени просматривает только ячейки, срок которых наступил, независимо от количества
+ * элементов в колесе.
+ * Колесо не умеет удалять и переносить элементы. Если срок элемента изменился, владелец
+ * проверяет его, когда колесо сообщит о наступлении старого срока, и при необходимости
+ * добавляет элемент заново.
+ * Колесо не синхронизировано
+ */
+template <typename Key>
+class TimingWheel {
+public:
+    using Duration = std::chrono::milliseconds;
+
+    // Колесо начинает отсчёт с момента start: более ранние сроки наступят
+    // при первом продвижении
+    explicit TimingWheel(Duration resolution, Duration start = {})
+        : resolution_{std::max(resolution, Duration{1})}
+        , current_slot_{static_cast<std::uint64_t>(std::max(start, Duration{0}) / resolution_)} {
+    }
+
+    // Добавляет элемент со сроком deadline. Уже наступивший срок будет обработан
+    // при следующем продвижении колеса
+    void Add(Key key, Duration deadline) {
+        Insert({std::move(key), deadline}, current_slot_ + 1);
+        ++size_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    // Продвигает время колеса до момента now и вызывает on_due(key, deadline) для каждого
+    // элемента, срок которого наступил. Элемент удаляется из колеса до вызова,
+    // поэтому on_due может добавить его снова
+    template <typename OnDue>
+    void Advance(Duration now, OnDue&& on_due) {
+        const auto target_slot = static_cast<std::uint64_t>(std::max(now, Duration{0}) / resolution_);
+        while (current_slot_ < target_slot) {
+            ++current_slot_;
+
+            // Когда младший уровень делает полный оборот, элементы очередной ячейки
+            // старшего уровня распределяются по младшим уровням
+            for (size_t level = 1; level < LEVEL_COUNT; ++level) {
+                if (((current_slot_ >> ((level - 1) * SLOT_BITS)) & SLOT_MASK) != 0) {
+                    break;
+                }
+                Slot cascade;
+                cascade.swap(levels_[level][(current_slot_ >> (level * SLOT_BITS)) & SLOT_MASK]);
+                for (auto& item : cascade) {
+                    Insert(std::move(item), current_slot_);
+                }
+            }
+
+            Slot due;
+            due.swap(levels_[0][current_slot_ & SLOT_MASK]);
+            size_ -= due.size();
+            for (auto& item : due) {
+                on_due(std::move(item.key), item.deadline);
+            }
+        }
+    }
+
+private:
+    struct Item {
+        Key key;
+        Duration deadline;
+    };
+
+    constexpr static size_t SLOT_BITS = 6;
+    constexpr static size_t SLOTS_PER_LEVEL = size_t{1} << SLOT_BITS;
+    constexpr static size_t SLOT_MASK = SLOTS_PER_LEVEL - 1;
+    // С ячейками по 100 мс четыре уровня покрывают больше 19 суток. Более далёкие сроки
+    // попадают на последний уровень и распределяются заново, когда до них доходит очередь
+    constexpr static size_t LEVEL_COUNT = 4;
+    constexpr static std::uint64_t MAX_DELAY = (std::uint64_t{1} << (LEVEL_COUNT * SLOT_BITS)) - 1;
+
+    using Slot = std::vector<Item>;
+    using Level = std::array<Slot, SLOTS_PER_LEVEL>;
+
+    // Помещает элемент в ячейку его срока, но не раньше ячейки min_slot
+    void Insert(Item item, std::uint64_t min_slot) {
+        // Номер ячейки, в конце которой наступает срок, с округлением вверх
+        const auto deadline = std::max(item.deadline, Duration{0});
+        const auto due_slot = static_cast<std::uint64_t>((deadline + resolution_ - Duration{1}) / resolution_);
+        const auto delay = std::min(std::max(due_slot, min_slot) - current_slot_, MAX_DELAY);
+
+        size_t level = 0;
+        while (level + 1 < LEVEL_COUNT && delay >= (std::uint64_t{1} << ((level + 1) * SLOT_BITS))) {
+            ++level;
+        }
+        const auto slot = current_slot_ + delay;
+        levels_[level][(slot >> (level * SLOT_BITS)) & SLOT_MASK].push_back(std::move(item));
+    }
+
+    Duration resolution_;
+    std::array<Level, LEVEL_COUNT> levels_;
+    // Ячейки с номерами до current_slot_ включительно уже обработаны
+    std::uint64_t current_slot_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,110 @@
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/dog_archive.h"
+#include "../src/model.h"
+#include "../src/model_serialization.h"
+#include "bench_harness.h"
+
+/*
+ * Замеры сериализации собак: по одной через DogRepr и boost.serialization
+ * и реестром целиком через столбцовый архив WriteDogs/ReadDogs.
+ * Запускаются отдельной программой game_server_benchmarks, например:
+ *   game_server_benchmarks --filter archive [количество собак, по умолчанию 10000]
+ * Параметры замеров описаны в bench_harness.h
+ */
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+DogRegistry MakeDogs(size_t count, std::mt19937_64& random) {
+    std::uniform_real_distribution<double> coord{0, 100};
+    std::uniform_real_distribution<double> speed{-3, 3};
+    std::uniform_int_distribution<unsigned> bag{0, 3};
+    DogRegistry dogs;
+    for (size_t i = 0; i < count; ++i) {
+        Dog dog{Dog::Id{static_cast<std::uint32_t>(i)}, "Dog "s + std::to_string(i),
+                {coord(random), coord(random)}, 3};
+        dog.SetSpeed({speed(random), speed(random)});
+        dog.AddScore(static_cast<Score>(random() % 1000));
+        for (unsigned item = bag(random); item > 0; --item) {
+            [[maybe_unused]] const bool put = dog.PutToBag({FoundObject::Id{item}, item % 3});
+        }
+        dogs.Add(dog);
+    }
+    return dogs;
+}
+
+template <typename OutputArchive>
+std::string SaveReprs(const DogRegistry& dogs) {
+    std::ostringstream out;
+    OutputArchive archive{out};
+    for (size_t i = 0; i < dogs.Size(); ++i) {
+        const serialization::DogRepr repr{dogs.Get(i)};
+        archive << repr;
+    }
+    return std::move(out).str();
+}
+
+template <typename InputArchive>
+size_t LoadReprs(const std::string& data, size_t count) {
+    std::istringstream in{data};
+    InputArchive archive{in};
+    size_t restored = 0;
+    for (size_t i = 0; i < count; ++i) {
+        serialization::DogRepr repr;
+        archive >> repr;
+        restored += repr.Restore().GetBagContent().size();
+    }
+    return restored;
+}
+
+template <typename OutputArchive, typename InputArchive>
+void RunReprBenchmarks(bench::Suite& suite, const std::string& format, const DogRegistry& dogs) {
+    const auto name = "DogRepr/"s + format + "/"s + std::to_string(dogs.Size());
+    const auto data = SaveReprs<OutputArchive>(dogs);
+    suite.Run(name + "/save", [&] {
+        bench::DoNotOptimize(SaveReprs<OutputArchive>(dogs).size());
+    }, data.size());
+    suite.Run(name + "/load", [&] {
+        bench::DoNotOptimize(LoadReprs<InputArchive>(data, dogs.Size()));
+    }, data.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite{"state_serialization", bench::ParseOptions(argc, argv)};
+    const auto& options = suite.GetOptions();
+    const size_t count = options.positional.empty() ? 10'000 : std::stoul(options.positional[0]);
+
+    std::mt19937_64 random{options.seed};
+    const auto dogs = MakeDogs(count, random);
+
+    RunReprBenchmarks<boost::archive::text_oarchive, boost::archive::text_iarchive>(suite, "text"s,
+                                                                                    dogs);
+    RunReprBenchmarks<boost::archive::binary_oarchive, boost::archive::binary_iarchive>(
+        suite, "binary"s, dogs);
+
+    const auto name = "DogArchive/"s + std::to_string(count);
+    std::string data;
+    serialization::WriteDogs(dogs, data);
+    suite.Run(name + "/write", [&] {
+        std::string out;
+        serialization::WriteDogs(dogs, out);
+        bench::DoNotOptimize(out.size());
+    }, data.size());
+    suite.Run(name + "/read", [&] {
+        std::string_view rest = data;
+        bench::DoNotOptimize(serialization::ReadDogs(rest).Size());
+    }, data.size());
+    return suite.Finish();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <catch2/catch_approx.hpp>
+
+#include "../src/geom.h"
+
+// Сравнение координат и скоростей, прошедших через столбцы DogRegistry. В сборке
+// с GEOM_FIXED_POINT они округляются до шага 1/65536, так что точно совпадают с double
+// только двоично-рациональные значения вроде 0.5 или 17
+inline Catch::Approx CoordApprox(double value) {
+    return Catch::Approx(value).margin(1 / geom::Fixed::ONE);
+}
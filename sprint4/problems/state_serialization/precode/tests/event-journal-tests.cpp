@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+
+#include "../src/event_journal.h"
+
+using namespace model;
+using namespace std::literals;
+using namespace serialization;
+
+namespace {
+
+struct EventJournalFixture {
+    EventJournalFixture() {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 100});
+        map.AddRoad({Road::VERTICAL, {10, 0}, 100});
+    }
+
+    ~EventJournalFixture() {
+        std::filesystem::remove_all(dir);
+    }
+
+    // Применяет событие к сеансу и записывает его в журнал
+    std::optional<Dog::Id> Play(GameSession& session, EventJournal& journal, const GameEvent& event) {
+        const auto id = ApplyEvent(session, event);
+        journal.Append(event);
+        return id;
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "event_journal_tests";
+    std::filesystem::path path = dir / "journal";
+    Map map{Map::Id{"map1"s}, "Map 1"s};
+};
+
+void CheckSameState(const GameSession& actual, const GameSession& expected) {
+    CHECK(actual.GetTime() == expected.GetTime());
+    CHECK(actual.GetNextDogId() == expected.GetNextDogId());
+    const auto& actual_dogs = actual.GetDogs();
+    const auto& expected_dogs = expected.GetDogs();
+    REQUIRE(actual_dogs.Size() == expected_dogs.Size());
+    for (size_t i = 0; i < expected_dogs.Size(); ++i) {
+        const auto id = expected_dogs.GetId(i);
+        const auto index = actual_dogs.FindIndex(id);
+        REQUIRE(index.has_value());
+        CHECK(actual_dogs.GetProfile(*index).name == expected_dogs.GetProfile(i).name);
+        CHECK(actual_dogs.GetPosition(*index) == expected_dogs.GetPosition(i));
+        CHECK(actual_dogs.GetSpeed(*index) == expected_dogs.GetSpeed(i));
+        CHECK(actual_dogs.GetDirection(*index) == expected_dogs.GetDirection(i));
+        CHECK(actual_dogs.GetMotion().last_active[*index] == expected_dogs.GetMotion().last_active[i]);
+        CHECK(actual_dogs.GetProfile(*index).joined_at == expected_dogs.GetProfile(i).joined_at);
+    }
+}
+
+}  // namespace
+
+SCENARIO_METHOD(EventJournalFixture, "Event journal recovery") {
+    GIVEN("a session whose actions are journaled") {
+        GameSession session{map, 10s};
+        EventJournal journal{path, session};
+        const auto rex = *Play(session, journal, JoinEvent{"Rex"s, {0, 0}, 3});
+        const auto bobik = *Play(session, journal, JoinEvent{"Bobik"s, {10, 50}, 2});
+        Play(session, journal, MoveEvent{rex, {4, 0}, Direction::EAST});
+        for (int i = 0; i < 20; ++i) {
+            Play(session, journal, TickEvent{100ms});
+        }
+        Play(session, journal, MoveEvent{bobik, {0, -3}, Direction::NORTH});
+        Play(session, journal, TickEvent{250ms});
+        journal.Flush();
+
+        WHEN("the session is recovered from the journal") {
+            GameSession recovered{map, 10s};
+            CHECK(RecoverSession(path, recovered) == 25);
+
+            THEN("it has the same dogs, positions and clock") {
+                CheckSameState(recovered, session);
+            }
+
+            THEN("it evolves the same way, including idle retirement") {
+                for (int i = 0; i < 300; ++i) {
+                    session.Tick(100ms);
+                    recovered.Tick(100ms);
+                }
+                CheckSameState(recovered, session);
+                // Bobik упёрся в конец дороги и простоял дольше срока бездействия
+                const auto retired = recovered.TakeRetired();
+                REQUIRE(retired.size() == 1);
+                CHECK(retired[0].id == bobik);
+                CHECK(session.TakeRetired().size() == 1);
+            }
+        }
+
+        WHEN("a checkpoint is taken and the session goes on") {
+            journal.Checkpoint(session);
+            Play(session, journal, MoveEvent{rex, {0, 0}, Direction::WEST});
+            Play(session, journal, TickEvent{100ms});
+            journal.Flush();
+
+            THEN("recovery starts from the checkpoint and replays only the later events") {
+                GameSession recovered{map, 10s};
+                CHECK(RecoverSession(path, recovered) == 2);
+                CheckSameState(recovered, session);
+            }
+        }
+
+        WHEN("the last group of events is torn by a crash") {
+            const auto durable_time = session.GetTime();
+            Play(session, journal, TickEvent{100ms});
+            journal.Flush();
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+            THEN("the session is recovered up to the last complete group") {
+                GameSession recovered{map, 10s};
+                CHECK(RecoverSession(path, recovered) == 25);
+                CHECK(recovered.GetTime() == durable_time);
+            }
+        }
+    }
+
+    GIVEN("no journal") {
+        GameSession session{map};
+        session.AddDog("Rex"s, {0, 0}, 3);
+
+        THEN("recovery leaves the session unchanged") {
+            CHECK(RecoverSession(path, session) == 0);
+            CHECK(session.GetDogs().Size() == 1);
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../src/game_sessions.h"
+
+using namespace app;
+using namespace std::literals;
+
+namespace {
+
+model::Map MakeMap(std::string id) {
+    model::Map map{model::Map::Id{std::move(id)}, "Map"s};
+    map.AddRoad({model::Road::HORIZONTAL, {0, 0}, 10});
+    return map;
+}
+
+}  // namespace
+
+SCENARIO("Game sessions") {
+    GIVEN("two maps and sessions spread over two io_contexts") {
+        const auto map1 = MakeMap("map1"s);
+        const auto map2 = MakeMap("map2"s);
+        net::io_context ioc1{1};
+        net::io_context ioc2{1};
+        GameSessions sessions{{&ioc1, &ioc2}, 50ms};
+        sessions.AddSession(map1);
+        sessions.AddSession(map2);
+
+        THEN("each session gets a strand in its own io_context") {
+            const auto* strand1 = sessions.FindStrand(map1.GetId());
+            const auto* strand2 = sessions.FindStrand(map2.GetId());
+            REQUIRE(strand1 != nullptr);
+            REQUIRE(strand2 != nullptr);
+            CHECK(&strand1->get_inner_executor().context() == &ioc1);
+            CHECK(&strand2->get_inner_executor().context() == &ioc2);
+            CHECK(sessions.FindStrand(model::Map::Id{"unknown"s}) == nullptr);
+        }
+
+        WHEN("requests are dispatched from several threads") {
+            constexpr int requests_per_thread = 1000;
+            constexpr int threads = 4;
+            std::atomic<int> outside_strand = 0;
+            {
+                auto work1 = net::make_work_guard(ioc1);
+                auto work2 = net::make_work_guard(ioc2);
+                std::jthread runner1{[&ioc1] {
+                    ioc1.run();
+                }};
+                std::jthread runner2{[&ioc2] {
+                    ioc2.run();
+                }};
+                {
+                    std::vector<std::jthread> clients;
+                    for (int t = 0; t < threads; ++t) {
+                        clients.emplace_back([&, t] {
+                            const auto& map = t % 2 == 0 ? map1 : map2;
+                            const auto* strand = sessions.FindStrand(map.GetId());
+                            for (int i = 0; i < requests_per_thread; ++i) {
+                                sessions.Dispatch(map.GetId(), [&, strand](model::GameSession& session) {
+                                    if (!strand->running_in_this_thread()) {
+                                        ++outside_strand;
+                                    }
+                                    session.AddDog("Dog"s, {0, 0}, 3);
+                                });
+                            }
+                        });
+                    }
+                }
+                work1.reset();
+                work2.reset();
+            }
+
+            THEN("every request runs in the strand of its session") {
+                CHECK(outside_strand == 0);
+                int dogs = 0;
+                for (const auto* map : {&map1, &map2}) {
+                    sessions.Dispatch(map->GetId(), [&](model::GameSession& session) {
+                        CHECK(session.GetDogs().Size() == threads / 2 * requests_per_thread);
+                        ++dogs;
+                    });
+                }
+                ioc1.restart();
+                ioc2.restart();
+                ioc1.run();
+                ioc2.run();
+                CHECK(dogs == 2);
+            }
+        }
+
+        WHEN("a request targets a map without a session") {
+            bool called = false;
+            const bool dispatched = sessions.Dispatch(model::Map::Id{"unknown"s}, [&](model::GameSession&) {
+                called = true;
+            });
+            ioc1.run();
+            ioc2.run();
+
+            THEN("it is rejected") {
+                CHECK_FALSE(dispatched);
+                CHECK_FALSE(called);
+            }
+        }
+    }
+}
+
+SCENARIO("Tick pacing under overload") {
+    using Clock = TickPacer::Clock;
+    constexpr auto step = 10ms;
+    const Clock::time_point start{};
+
+    GIVEN("a pacer whose ticks fit into the step") {
+        TickPacer pacer{step};
+        pacer.Start(start);
+        for (int i = 0; i < 3; ++i) {
+            const auto now = pacer.GetNextTick();
+            const auto tick = pacer.BeginTick(now);
+            CHECK(tick.steps == 1);
+            CHECK(tick.dt == step);
+            CHECK_FALSE(tick.overloaded);
+            pacer.EndTick(now, now + 2ms);
+        }
+
+        THEN("ticks follow each other with the step and no overload is reported") {
+            CHECK(pacer.GetNextTick() == start + step * 4);
+            const auto status = pacer.GetStatus();
+            CHECK(status.ticks == 3);
+            CHECK(status.coalesced_steps == 0);
+            CHECK(status.overruns == 0);
+            CHECK_FALSE(status.overloaded);
+            CHECK(status.last_duration == 2ms);
+        }
+    }
+
+    GIVEN("a tick that takes longer than the step") {
+        TickPacer pacer{step};
+        pacer.Start(start);
+        auto now = pacer.GetNextTick();
+        CHECK_FALSE(pacer.BeginTick(now).overloaded);
+        pacer.EndTick(now, now + step * 3 + 1ms);
+        // Следующий тик начинается, когда закончился предыдущий
+        now += step * 3 + 1ms;
+        const auto tick = pacer.BeginTick(now);
+
+        THEN("missed steps are coalesced into one longer tick in overload mode") {
+            CHECK(tick.steps == 3);
+            CHECK(tick.dt == step * 3);
+            CHECK(tick.overloaded);
+            CHECK(pacer.GetNextTick() == start + step * 5);
+            const auto status = pacer.GetStatus();
+            CHECK(status.overruns == 1);
+            CHECK(status.coalesced_steps == 2);
+            CHECK(status.overloaded);
+            CHECK(status.max_duration == step * 3 + 1ms);
+        }
+
+        WHEN("the following ticks are fast") {
+            pacer.EndTick(now, now + 1ms);
+            unsigned calm = 0;
+            while (pacer.GetStatus().overloaded) {
+                const auto at = pacer.GetNextTick();
+                CHECK(pacer.BeginTick(at).steps == 1);
+                pacer.EndTick(at, at + 1ms);
+                ++calm;
+            }
+
+            THEN("the overload ends after RECOVERY_TICKS of them") {
+                CHECK(calm == TickPacer::RECOVERY_TICKS);
+                CHECK(pacer.GetStatus().overloaded_ticks == TickPacer::RECOVERY_TICKS + 1);
+            }
+        }
+    }
+
+    GIVEN("a tick that starts later than the coalescing limit") {
+        TickPacer pacer{step};
+        pacer.Start(start);
+        const auto now = pacer.GetNextTick() + step * (TickPacer::MAX_COALESCED_STEPS * 2) + 1ms;
+        const auto tick = pacer.BeginTick(now);
+
+        THEN("the rest of the backlog is dropped") {
+            CHECK(tick.steps == TickPacer::MAX_COALESCED_STEPS);
+            CHECK(pacer.GetStatus().dropped_steps == TickPacer::MAX_COALESCED_STEPS + 1);
+            CHECK(pacer.GetNextTick() == now + step);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <charconv>
+#include <limits>
+
+#include "../src/game_state_json.h"
+
+using namespace model;
+using namespace std::literals;
+
+SCENARIO("Game state JSON") {
+    GIVEN("a registry of dogs") {
+        DogRegistry dogs;
+        std::string out = "stale content"s;
+
+        WHEN("there are no dogs") {
+            app::WriteGameState(dogs, out);
+
+            THEN("an empty players object is written") {
+                CHECK(out == R"({"tick":0,"players":{}})"s);
+            }
+        }
+
+        WHEN("dogs have positions, speeds, directions and bags") {
+            // Значения точно представимы и в double, и в GEOM_FIXED_POINT
+            Dog first{Dog::Id{0u}, "Rex"s, {1.5, 0}, 3};
+            first.SetSpeed({-0.125, 0});
+            first.SetDirection(Direction::WEST);
+            dogs.Add(first);
+
+            Dog second{Dog::Id{7u}, "Pluto"s, {10, 2.25}, 3};
+            second.SetDirection(Direction::SOUTH);
+            CHECK(second.PutToBag({FoundObject::Id{4u}, 1u}));
+            CHECK(second.PutToBag({FoundObject::Id{9u}, 0u}));
+            second.AddScore(30);
+            dogs.Add(second);
+
+            app::WriteGameState(dogs, out);
+
+            THEN("all of them are written in registry order") {
+                CHECK(out
+                      == R"({"tick":0,"players":{)"
+                         R"("0":{"pos":[1.5,0],"speed":[-0.125,0],"dir":"L","bag":[],"score":0},)"
+                         R"("7":{"pos":[10,2.25],"speed":[0,0],"dir":"D","bag":[{"id":4,"type":1},{"id":9,"type":0}],"score":30}}})"s);
+                CHECK(out.size() <= app::GetGameStateSizeBound(dogs));
+            }
+        }
+
+        WHEN("coordinates need the longest number format") {
+            constexpr double value = -std::numeric_limits<double>::denorm_min() * 3;
+            Dog dog{Dog::Id{std::numeric_limits<uint32_t>::max()}, "Rex"s, {value, value}, Dog::MAX_BAG_CAPACITY};
+            dog.SetSpeed({-2.2250738585072014e-308, 1.0 / 3});
+            for (size_t i = 0; i < Dog::MAX_BAG_CAPACITY; ++i) {
+                CHECK(dog.PutToBag({FoundObject::Id{std::numeric_limits<uint32_t>::max()},
+                                    std::numeric_limits<LostObjectType>::max()}));
+            }
+            dog.AddScore(std::numeric_limits<Score>::max());
+            dogs.Add(dog);
+            app::WriteGameState(dogs, out);
+
+            THEN("the text fits the size bound and numbers round-trip") {
+                CHECK(out.size() <= app::GetGameStateSizeBound(dogs));
+#ifndef GEOM_FIXED_POINT
+                // Субнормальные значения в фиксированной точке обращаются в ноль
+                const auto pos = out.find(R"("speed":[)"sv) + 9;
+                double speed_x = 0;
+                std::from_chars(out.data() + pos, out.data() + out.size(), speed_x);
+                CHECK(speed_x == -2.2250738585072014e-308);
+                CHECK(out.find("0.3333333333333333]"sv) != std::string::npos);
+#endif
+            }
+        }
+    }
+
+    GIVEN("a session whose dogs change over several ticks") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 100});
+        GameSession session{map};
+        const auto rex = session.AddDog("Rex"s, {0, 0}, 3);
+        session.AddDog("Pluto"s, {50, 0}, 3);
+        const auto goofy = session.AddDog("Goofy"s, {70, 0}, 3);
+        session.Tick(100ms);
+        auto& dogs = session.GetDogs();
+        const auto seen_tick = dogs.GetTick();
+
+        // Шаг в 1/8 секунды точно представим и в GEOM_FIXED_POINT
+        dogs.SetSpeed(*dogs.FindIndex(rex), {8, 0});
+        dogs.Remove(goofy);
+        session.Tick(125ms);
+        std::string out;
+
+        WHEN("a client asks for changes since the tick it has seen") {
+            app::WriteGameState(dogs, out, seen_tick);
+
+            THEN("only the changed dog and the removed dog are written") {
+                CHECK(out
+                      == R"({"tick":2,"since":1,"players":{)"
+                         R"("0":{"pos":[1,0],"speed":[8,0],"dir":"U","bag":[],"score":0}},"removed":[2]})"s);
+            }
+        }
+
+        WHEN("nothing changed since the tick the client has seen") {
+            app::WriteGameState(dogs, out, dogs.GetTick());
+
+            THEN("the delta is empty") {
+                CHECK(out == R"({"tick":2,"since":2,"players":{},"removed":[]})"s);
+            }
+        }
+
+        WHEN("the client is too far behind") {
+            for (uint64_t i = 0; i < DogRegistry::CHANGE_HISTORY_TICKS; ++i) {
+                session.Tick(0ms);
+            }
+            app::WriteGameState(dogs, out, seen_tick);
+
+            THEN("the full state is written") {
+                CHECK(out.starts_with(R"({"tick":202,"players":{)"sv));
+                CHECK(out.find(R"("1":{"pos":[50,0])"sv) != std::string::npos);
+            }
+        }
+
+        WHEN("the client reports a tick from the future") {
+            app::WriteGameState(dogs, out, dogs.GetTick() + 1);
+
+            THEN("the full state is written") {
+                CHECK(out.find(R"("since")"sv) == std::string::npos);
+                CHECK(out.find(R"("1":{)"sv) != std::string::npos);
+            }
+        }
+
+    }
+}
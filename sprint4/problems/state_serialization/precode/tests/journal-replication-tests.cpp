@@ -0,0 +1,205 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <thread>
+
+#include "../src/journal_replication.h"
+
+using namespace model;
+using namespace std::literals;
+using namespace serialization;
+
+namespace {
+
+Map MakeMap() {
+    Map map{Map::Id{"map1"s}, "Map 1"s};
+    map.AddRoad({Road::HORIZONTAL, {0, 0}, 100});
+    map.AddRoad({Road::VERTICAL, {10, 0}, 100});
+    return map;
+}
+
+// Основной узел и резервный узел в одном io_context
+struct ReplicationFixture {
+    explicit ReplicationFixture(std::uint64_t max_buffered_bytes = JournalShipper::DEFAULT_MAX_BUFFERED_BYTES) {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+
+        follower.emplace(strand, tcp::endpoint{net::ip::address_v4::loopback(), 0}, standby,
+                         dir / "standby");
+        shipper.emplace(ioc, follower->GetEndpoint(),
+                        [this] {
+                            checkpoint_requested = true;
+                        },
+                        max_buffered_bytes);
+        journal.emplace(dir / "primary", primary, [this](JournalRecord kind, std::string_view payload) {
+            shipper->Ship(kind, payload);
+        });
+        runner = std::jthread{[this] {
+            ioc.run();
+        }};
+    }
+
+    ~ReplicationFixture() {
+        journal.reset();
+        work.reset();
+        ioc.stop();
+        runner.join();
+        std::filesystem::remove_all(dir);
+    }
+
+    // Отвечает на запрос контрольной точки так, как это делал бы strand сеанса
+    void ServeCheckpointRequest() {
+        REQUIRE(WaitFor([this] {
+            return checkpoint_requested.load();
+        }));
+        checkpoint_requested = false;
+        journal->Checkpoint(primary);
+    }
+
+    std::optional<Dog::Id> Play(const GameEvent& event) {
+        const auto id = ApplyEvent(primary, event);
+        journal->Append(event);
+        return id;
+    }
+
+    // Дожидается, пока резервная копия догонит основной сеанс, а основной узел получит
+    // подтверждение всех отправленных кадров
+    bool WaitForStandby() {
+        journal->Flush();
+        return WaitFor([this] {
+            bool same = false;
+            WithStandby([this, &same](const GameSession& standby) {
+                same = standby.GetTime() == primary.GetTime()
+                    && standby.GetNextDogId() == primary.GetNextDogId()
+                    && standby.GetDogs().Size() == primary.GetDogs().Size();
+            });
+            const auto status = shipper->GetStatus();
+            return same && status.acknowledged == status.shipped;
+        });
+    }
+
+    template <typename Predicate>
+    static bool WaitFor(Predicate predicate) {
+        for (int i = 0; i < 500; ++i) {
+            if (predicate()) {
+                return true;
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        return false;
+    }
+
+    // Выполняет fn(standby), пока strand резервной копии сеанса занят и не изменяет её.
+    // Проверки выполняются в потоке теста, а не в потоке io_context
+    template <typename Fn>
+    void WithStandby(Fn fn) {
+        std::promise<void> entered;
+        std::promise<void> release;
+        net::dispatch(strand, [&entered, left = release.get_future()]() mutable {
+            entered.set_value();
+            left.wait();
+        });
+        entered.get_future().wait();
+        fn(standby);
+        release.set_value();
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "journal_replication_tests";
+    Map map = MakeMap();
+    GameSession primary{map, 10s};
+    GameSession standby{map, 10s};
+
+    net::io_context ioc;
+    net::executor_work_guard<net::io_context::executor_type> work = net::make_work_guard(ioc);
+    JournalFollower::Strand strand = net::make_strand(ioc);
+    std::atomic<bool> checkpoint_requested = false;
+    std::optional<JournalFollower> follower;
+    std::optional<JournalShipper> shipper;
+    std::optional<EventJournal> journal;
+    std::jthread runner;
+};
+
+void CheckSameState(const GameSession& actual, const GameSession& expected) {
+    CHECK(actual.GetTime() == expected.GetTime());
+    CHECK(actual.GetNextDogId() == expected.GetNextDogId());
+    const auto& actual_dogs = actual.GetDogs();
+    const auto& expected_dogs = expected.GetDogs();
+    REQUIRE(actual_dogs.Size() == expected_dogs.Size());
+    for (size_t i = 0; i < expected_dogs.Size(); ++i) {
+        const auto index = actual_dogs.FindIndex(expected_dogs.GetId(i));
+        REQUIRE(index.has_value());
+        CHECK(actual_dogs.GetPosition(*index) == expected_dogs.GetPosition(i));
+        CHECK(actual_dogs.GetSpeed(*index) == expected_dogs.GetSpeed(i));
+        CHECK(actual_dogs.GetDirection(*index) == expected_dogs.GetDirection(i));
+    }
+}
+
+}  // namespace
+
+SCENARIO("Journal replication to a hot standby") {
+    GIVEN("a primary whose journal is shipped to a standby") {
+        ReplicationFixture fixture;
+        fixture.ServeCheckpointRequest();
+
+        const auto rex = *fixture.Play(JoinEvent{"Rex"s, {0, 0}, 3});
+        fixture.Play(JoinEvent{"Bobik"s, {10, 50}, 2});
+        fixture.Play(MoveEvent{rex, {4, 0}, Direction::EAST});
+        for (int i = 0; i < 20; ++i) {
+            fixture.Play(TickEvent{100ms});
+        }
+        REQUIRE(fixture.WaitForStandby());
+
+        THEN("the standby copy follows the primary") {
+            const auto status = fixture.follower->GetStatus();
+            CHECK(status.connected);
+            CHECK(status.ready);
+            CHECK(fixture.shipper->GetStatus().connected);
+            fixture.WithStandby([&fixture](const GameSession& standby) {
+                CheckSameState(standby, fixture.primary);
+            });
+        }
+
+        WHEN("the standby is promoted") {
+            std::promise<std::unique_ptr<EventJournal>> promoted;
+            fixture.follower->Promote([&promoted](std::unique_ptr<EventJournal> journal) {
+                promoted.set_value(std::move(journal));
+            });
+            auto journal = promoted.get_future().get();
+            REQUIRE(journal != nullptr);
+
+            THEN("it goes on from the replicated state with its own journal") {
+                fixture.WithStandby([&](GameSession& standby) {
+                    CheckSameState(standby, fixture.primary);
+                    const GameEvent tick = TickEvent{500ms};
+                    ApplyEvent(standby, tick);
+                    journal->Append(tick);
+                    journal->Flush();
+
+                    // Журнал резервного узла содержит и полученные события, и новое
+                    GameSession recovered{fixture.map, 10s};
+                    CHECK(RecoverSession(journal->GetPath(), recovered) == 24);
+                    CheckSameState(recovered, standby);
+                });
+                CHECK_FALSE(fixture.follower->GetStatus().ready);
+            }
+        }
+    }
+
+    GIVEN("a standby that falls behind the shipping buffer limit") {
+        ReplicationFixture fixture{1};
+        fixture.ServeCheckpointRequest();
+        fixture.Play(JoinEvent{"Rex"s, {0, 0}, 3});
+        fixture.journal->Flush();
+
+        THEN("events are dropped and the standby catches up from the next checkpoint") {
+            fixture.ServeCheckpointRequest();
+            CHECK(fixture.shipper->GetStatus().resyncs >= 1);
+            REQUIRE(fixture.WaitForStandby());
+            fixture.WithStandby([&fixture](const GameSession& standby) {
+                CheckSameState(standby, fixture.primary);
+            });
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "../src/leaderboard.h"
+
+using namespace app;
+using namespace std::literals;
+
+namespace {
+
+// Хранит записи в памяти в порядке таблицы рекордов и считает обращения
+class FakeRecords : public RecordsRepository {
+public:
+    std::vector<PlayerRecord> GetRecords(const std::optional<RecordKey>& after, size_t limit) override {
+        ++calls;
+        auto it = records.begin();
+        if (after) {
+            it = std::upper_bound(records.begin(), records.end(), *after, [](const RecordKey& key, const PlayerRecord& record) {
+                return Less(key, RecordKey::Of(record));
+            });
+        }
+        const auto end = it + std::min<size_t>(limit, records.end() - it);
+        return {it, end};
+    }
+
+    void Add(PlayerRecord record) {
+        record.id = records.size() + 1;
+        records.push_back(std::move(record));
+        std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) {
+            return Less(RecordKey::Of(lhs), RecordKey::Of(rhs));
+        });
+    }
+
+    std::vector<PlayerRecord> records;
+    size_t calls = 0;
+
+private:
+    static bool Less(const RecordKey& lhs, const RecordKey& rhs) {
+        return std::tuple{rhs.score, lhs.play_time, lhs.id} < std::tuple{lhs.score, rhs.play_time, rhs.id};
+    }
+};
+
+}  // namespace
+
+SCENARIO("Leaderboard") {
+    GIVEN("a leaderboard over three retired players") {
+        FakeRecords repository;
+        repository.Add({0, "Rex"s, 10, 2s});
+        repository.Add({0, "Pluto \"the dog\""s, 30, 5s});
+        repository.Add({0, "Goofy"s, 10, 1500ms});
+        Leaderboard leaderboard{repository, 1h};
+
+        WHEN("the first page is requested") {
+            const auto page = leaderboard.GetPage(""sv);
+
+            THEN("players are ordered by score and then by play time") {
+                CHECK(*page
+                      == R"({"records":[{"name":"Pluto \"the dog\"","score":30,"playTime":5},)"
+                         R"({"name":"Goofy","score":10,"playTime":1.5},{"name":"Rex","score":10,"playTime":2}]})"s);
+            }
+
+            THEN("it is served from memory until it expires") {
+                CHECK(leaderboard.GetPage(""sv) == page);
+                CHECK(*leaderboard.GetPage(""sv, 1) == R"({"records":[{"name":"Pluto \"the dog\"","score":30,"playTime":5}],"next":"30.5000.2"})"s);
+                CHECK(repository.calls == 1);
+            }
+        }
+
+        WHEN("pages are requested by cursor") {
+            const auto first = leaderboard.GetPage(""sv, 2);
+            REQUIRE(first->ends_with(R"(,"next":"10.1500.3"})"sv));
+            const auto second = leaderboard.GetPage("10.1500.3"sv, 2);
+
+            THEN("the next page starts after the last record of the previous one") {
+                CHECK(*second == R"({"records":[{"name":"Rex","score":10,"playTime":2}]})"s);
+            }
+        }
+
+        WHEN("the cursor or the page size is invalid") {
+            THEN("the request is rejected") {
+                CHECK_THROWS_AS(leaderboard.GetPage("abc"sv), std::invalid_argument);
+                CHECK_THROWS_AS(leaderboard.GetPage("10.1500"sv), std::invalid_argument);
+                CHECK_THROWS_AS(leaderboard.GetPage("10.-1.3"sv), std::invalid_argument);
+                CHECK_THROWS_AS(leaderboard.GetPage("10.1500.3."sv), std::invalid_argument);
+                CHECK_THROWS_AS(leaderboard.GetPage(""sv, 0), std::invalid_argument);
+                CHECK_THROWS_AS(leaderboard.GetPage(""sv, Leaderboard::MAX_PAGE_SIZE + 1), std::invalid_argument);
+            }
+        }
+    }
+
+    GIVEN("a leaderboard with a short first page lifetime") {
+        FakeRecords repository;
+        repository.Add({0, "Rex"s, 10, 2s});
+        Leaderboard leaderboard{repository, 10ms};
+        leaderboard.GetPage(""sv);
+        repository.Add({0, "Pluto"s, 30, 5s});
+
+        WHEN("the lifetime expires") {
+            std::this_thread::sleep_for(20ms);
+
+            THEN("the first page is read again") {
+                CHECK(leaderboard.GetPage(""sv)->find("Pluto"sv) != std::string::npos);
+                CHECK(repository.calls == 2);
+            }
+        }
+    }
+}
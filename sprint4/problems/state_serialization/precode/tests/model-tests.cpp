@@ -0,0 +1,375 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "../src/geom_kernels.h"
+#include "../src/model.h"
+#include "../src/road_graph.h"
+#include "../src/road_sampler.h"
+#include "coord-approx.h"
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+// Квадрат из четырёх дорог 0..10 по каждой оси и дорога, продолжающая нижнюю сторону
+Map MakeMap() {
+    Map map{Map::Id{"map1"s}, "Map 1"s};
+    map.AddRoad({Road::HORIZONTAL, {0, 0}, 10});
+    map.AddRoad({Road::VERTICAL, {10, 0}, 10});
+    map.AddRoad({Road::HORIZONTAL, {10, 10}, 0});
+    map.AddRoad({Road::VERTICAL, {0, 10}, 0});
+    map.AddRoad({Road::HORIZONTAL, {10, 0}, 20});
+    return map;
+}
+
+}  // namespace
+
+SCENARIO("Game session tick") {
+    GIVEN("a session with a dog on a road") {
+        const Map map = MakeMap();
+        GameSession session{map};
+        const auto id = session.AddDog("Pluto"s, {2, 0}, 3);
+        auto& dogs = session.GetDogs();
+        const size_t dog = *dogs.FindIndex(id);
+
+        WHEN("the dog moves within the road") {
+            dogs.SetSpeed(dog, {4, 0});
+            session.Tick(500ms);
+
+            THEN("it moves by speed * dt and keeps its speed") {
+                CHECK(dogs.GetPosition(dog) == geom::Point2D{4, 0});
+                CHECK(dogs.GetSpeed(dog) == geom::Vec2D{4, 0});
+            }
+        }
+
+        WHEN("the dog passes a junction of collinear roads") {
+            dogs.SetSpeed(dog, {10, 0});
+            session.Tick(1500ms);
+
+            THEN("it continues along the next road") {
+                CHECK(dogs.GetPosition(dog) == geom::Point2D{17, 0});
+            }
+        }
+
+        WHEN("the dog runs into the end of the road") {
+            dogs.SetSpeed(dog, {100, 0});
+            session.Tick(1s);
+
+            THEN("it stops at the road edge") {
+                CHECK(dogs.GetPosition(dog).x == CoordApprox(20 + Road::HALF_WIDTH));
+                CHECK(dogs.GetPosition(dog).y == 0);
+                CHECK(dogs.GetSpeed(dog) == geom::Vec2D{});
+            }
+        }
+
+        WHEN("the dog runs across the road") {
+            dogs.SetSpeed(dog, {0, -3});
+            session.Tick(1s);
+
+            THEN("it stops at the road side") {
+                CHECK(dogs.GetPosition(dog).x == 2);
+                CHECK(dogs.GetPosition(dog).y == CoordApprox(-Road::HALF_WIDTH));
+                CHECK(dogs.GetSpeed(dog) == geom::Vec2D{});
+            }
+        }
+
+        WHEN("the dog turns at a crossroad") {
+            dogs.SetPosition(dog, {10, 0});
+            dogs.SetSpeed(dog, {0, 4});
+            session.Tick(2s);
+
+            THEN("it moves along the crossing road") {
+                CHECK(dogs.GetPosition(dog) == geom::Point2D{10, 8});
+            }
+        }
+    }
+}
+
+SCENARIO("Dog registry") {
+    GIVEN("a registry with several dogs") {
+        DogRegistry dogs;
+        for (uint32_t i = 0; i < 3; ++i) {
+            Dog dog{Dog::Id{i}, "Dog "s + std::to_string(i), {double(i), 0}, 2};
+            CHECK(dog.PutToBag({FoundObject::Id{i}, i}));
+            dog.AddScore(i * 10);
+            dogs.Add(dog);
+        }
+
+        THEN("a dog can be assembled back from the columns") {
+            const Dog dog = dogs.Get(*dogs.FindIndex(Dog::Id{1u}));
+            CHECK(dog.GetName() == "Dog 1"s);
+            CHECK(dog.GetPosition() == geom::Point2D{1, 0});
+            CHECK(dog.GetScore() == 10u);
+            CHECK(dog.GetBagContent() == Dog::BagContent{{FoundObject::Id{1u}, 1u}});
+        }
+
+        THEN("a dog with the same id is rejected") {
+            CHECK_THROWS_AS(dogs.Add(Dog{Dog::Id{0u}, "Copy"s, {}, 1}), std::invalid_argument);
+            CHECK(dogs.Size() == 3);
+        }
+
+        WHEN("a dog is removed") {
+            CHECK(dogs.Remove(Dog::Id{0u}));
+
+            THEN("other dogs remain available by id") {
+                CHECK(dogs.Size() == 2);
+                CHECK(!dogs.FindIndex(Dog::Id{0u}));
+                const size_t last = *dogs.FindIndex(Dog::Id{2u});
+                CHECK(dogs.GetPosition(last) == geom::Point2D{2, 0});
+                CHECK(dogs.GetProfile(last).name == "Dog 2"s);
+            }
+        }
+    }
+}
+
+SCENARIO("Dog bag") {
+    GIVEN("a dog with a bag of capacity 2") {
+        Dog dog{Dog::Id{1u}, "Rex"s, {}, 2};
+
+        THEN("items are put until the bag is full") {
+            CHECK(dog.PutToBag({FoundObject::Id{1u}, 0u}));
+            CHECK(dog.PutToBag({FoundObject::Id{2u}, 1u}));
+            CHECK(dog.IsBagFull());
+            CHECK(!dog.PutToBag({FoundObject::Id{3u}, 0u}));
+            CHECK(dog.GetBagContent().size() == 2);
+
+            AND_THEN("an emptied bag accepts items again") {
+                CHECK(dog.EmptyBag() == 2);
+                CHECK(dog.GetBagContent().empty());
+                CHECK(dog.PutToBag({FoundObject::Id{3u}, 0u}));
+            }
+        }
+    }
+
+    THEN("a bag larger than the inline storage is rejected") {
+        CHECK_THROWS_AS((Dog{Dog::Id{1u}, "Rex"s, {}, Dog::MAX_BAG_CAPACITY + 1}),
+                        std::invalid_argument);
+    }
+}
+
+SCENARIO("Depositing a bag") {
+    GIVEN("a map with loot types of different values") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 10});
+        CHECK(map.AddLootType(10) == 0);
+        CHECK(map.AddLootType(30) == 1);
+        CHECK(map.GetLootValue(1) == 30);
+        GameSession session{map};
+        const auto id = session.AddDog("Rex"s, {0, 0}, 3);
+        const size_t index = *session.GetDogs().FindIndex(id);
+        auto& bag = session.GetDogs().GetProfile(index).bag;
+        bag.push_back({FoundObject::Id{1u}, 1u});
+        bag.push_back({FoundObject::Id{2u}, 0u});
+        bag.push_back({FoundObject::Id{3u}, 1u});
+
+        WHEN("the dog deposits its bag") {
+            CHECK(GetBagValue(session.GetDogs().GetProfile(index).bag, map) == 70);
+            CHECK(session.DepositBag(index) == 70);
+
+            THEN("the score grows by the value of the items and the bag is emptied") {
+                const auto& profile = std::as_const(session.GetDogs()).GetProfile(index);
+                CHECK(profile.score == 70);
+                CHECK(profile.bag.empty());
+                CHECK(session.DepositBag(index) == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Road sampler") {
+    GIVEN("a map with roads of different lengths") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 10});
+        map.AddRoad({Road::VERTICAL, {5, 5}, 5});
+        map.AddRoad({Road::VERTICAL, {20, 30}, 0});
+        const RoadSampler sampler{map};
+
+        THEN("roads are chosen in proportion to their lengths") {
+            constexpr int SAMPLES = 4000;
+            int on_horizontal = 0, on_vertical = 0;
+            for (int i = 0; i < SAMPLES; ++i) {
+                const auto point = sampler.GetPoint((i + 0.5) / SAMPLES, 0.5);
+                if (point == geom::Point2D{5, 0}) {
+                    ++on_horizontal;
+                } else if (point == geom::Point2D{20, 15}) {
+                    ++on_vertical;
+                }
+            }
+            CHECK(on_horizontal == SAMPLES / 4);
+            CHECK(on_vertical == SAMPLES * 3 / 4);
+        }
+
+        THEN("a batch of points is placed along the roads") {
+            double value = 0;
+            const auto random = [&value] {
+                value = std::fmod(value + 0.377, 1.0);
+                return value;
+            };
+            std::vector<geom::Point2D> points(100);
+            sampler.GetRandomPoints(points, random);
+            for (const auto& point : points) {
+                const bool on_horizontal = point.y == 0 && point.x >= 0 && point.x <= 10;
+                const bool on_vertical = point.x == 20 && point.y >= 0 && point.y <= 30;
+                CHECK((on_horizontal || on_vertical));
+            }
+        }
+
+        THEN("the ends of the unit interval stay on the roads") {
+            CHECK(sampler.GetPoint(0, 0) == geom::Point2D{0, 0});
+            CHECK(sampler.GetPoint(1, 1) == geom::Point2D{20, 0});
+        }
+    }
+
+    THEN("a map without roads is rejected") {
+        CHECK_THROWS_AS(RoadSampler{Map::Roads{}}, std::invalid_argument);
+    }
+}
+
+SCENARIO("Road graph") {
+    GIVEN("a map with crossing, touching, overlapping and isolated roads") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 10});
+        map.AddRoad({Road::VERTICAL, {5, -5}, 5});
+        map.AddRoad({Road::VERTICAL, {10, 0}, 10});
+        map.AddRoad({Road::HORIZONTAL, {20, 10}, 8});
+        map.AddRoad({Road::HORIZONTAL, {15, 10}, 25});
+        map.AddRoad({Road::HORIZONTAL, {40, 40}, 50});
+        const RoadGraph graph{map};
+
+        auto node = [&graph](Point point) {
+            const auto id = graph.FindNode(point);
+            REQUIRE(id.has_value());
+            return *id;
+        };
+
+        THEN("road ends and crossings become nodes") {
+            CHECK(graph.GetNodeCount() == 12);
+            CHECK(graph.FindNode({5, 0}).has_value());
+            CHECK(graph.FindNode({15, 10}).has_value());
+            CHECK_FALSE(graph.FindNode({3, 0}).has_value());
+        }
+
+        THEN("neighbours are the nearest nodes along the roads") {
+            std::vector<Point> neighbours;
+            for (const auto& edge : graph.GetNeighbours(node({5, 0}))) {
+                neighbours.push_back(graph.GetNode(edge.to));
+                CHECK(edge.length == 5);
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+            CHECK(neighbours == std::vector<Point>{{0, 0}, {5, -5}, {5, 5}, {10, 0}});
+        }
+
+        THEN("overlapping roads share their common section") {
+            const auto neighbours = graph.GetNeighbours(node({15, 10}));
+            REQUIRE(neighbours.size() == 2);
+            CHECK(graph.GetNode(neighbours[0].to) == Point{10, 10});
+            CHECK(graph.GetNode(neighbours[1].to) == Point{20, 10});
+        }
+
+        THEN("the shortest path goes along the roads") {
+            CHECK(graph.GetDistance(node({0, 0}), node({25, 10})) == 35);
+            CHECK(graph.GetDistance(node({25, 10}), node({0, 0})) == 35);
+            CHECK(graph.GetDistance(node({5, 5}), node({5, 5})) == 0);
+            const auto path = graph.FindPath(node({5, -5}), node({8, 10}));
+            std::vector<Point> points;
+            std::transform(path.begin(), path.end(), std::back_inserter(points), [&graph](auto id) {
+                return graph.GetNode(id);
+            });
+            CHECK(points == std::vector<Point>{{5, -5}, {5, 0}, {10, 0}, {10, 10}, {8, 10}});
+        }
+
+        THEN("isolated roads are unreachable") {
+            CHECK_FALSE(graph.GetDistance(node({0, 0}), node({40, 40})).has_value());
+            CHECK(graph.FindPath(node({0, 0}), node({50, 40})).empty());
+        }
+    }
+
+    GIVEN("a grid too large to precompute all distances") {
+        constexpr int SIZE = 20;
+        Map map{Map::Id{"grid"s}, "Grid"s};
+        for (int i = 0; i < SIZE; ++i) {
+            map.AddRoad({Road::HORIZONTAL, {0, i}, SIZE - 1});
+            map.AddRoad({Road::VERTICAL, {i, 0}, SIZE - 1});
+        }
+        const RoadGraph graph{map};
+        REQUIRE(graph.GetNodeCount() > RoadGraph::ALL_PAIRS_LIMIT);
+
+        THEN("distances and paths are found by search") {
+            const auto from = *graph.FindNode({0, 0});
+            const auto to = *graph.FindNode({SIZE - 1, 7});
+            CHECK(graph.GetDistance(from, to) == SIZE - 1 + 7);
+            CHECK(graph.GetDistance(to, from) == SIZE - 1 + 7);
+            const auto path = graph.FindPath(from, to);
+            REQUIRE(path.size() == SIZE + 7);
+            CHECK(path.front() == from);
+            CHECK(path.back() == to);
+        }
+    }
+}
+
+SCENARIO("Clamped movement kernel") {
+    GIVEN("columns longer than a vector register with a tail") {
+        constexpr size_t COUNT = 7;
+        std::vector<double> pos(COUNT, 1.0);
+        std::vector<double> speed{1, -1, 2, -2, 0, 10, -10};
+        const std::vector<double> lo(COUNT, 0.0);
+        const std::vector<double> hi(COUNT, 3.0);
+
+        WHEN("points are moved for one second") {
+            geom::MoveClamped(pos.data(), speed.data(), lo.data(), hi.data(), 1.0, COUNT);
+
+            THEN("they are clamped to their bounds and stopped at them") {
+                CHECK(pos == std::vector<double>{2, 0, 3, 0, 1, 3, 0});
+                CHECK(speed == std::vector<double>{1, -1, 2, 0, 0, 0, 0});
+            }
+        }
+    }
+}
+
+SCENARIO("Fixed-point clamped movement kernel") {
+    GIVEN("fixed-point numbers") {
+        THEN("they round to the nearest step and saturate at the range ends") {
+            CHECK(geom::Fixed{0.5}.GetRaw() == 32768);
+            CHECK(geom::Fixed{-0.1}.GetRaw() == -6554);
+            CHECK(double(geom::Fixed{2.25}) == 2.25);
+            CHECK(geom::Fixed{1e9}.GetRaw() == std::numeric_limits<geom::Fixed::Raw>::max());
+            CHECK(geom::Fixed{-1e9}.GetRaw() == std::numeric_limits<geom::Fixed::Raw>::min());
+        }
+    }
+
+    GIVEN("columns longer than two vector registers with a tail") {
+        constexpr size_t COUNT = 19;
+        std::vector<geom::Fixed> pos, speed, lo, hi;
+        for (size_t i = 0; i < COUNT; ++i) {
+            const double sign = i % 2 ? -1 : 1;
+            pos.emplace_back(10.0 + i * 0.37);
+            speed.emplace_back(sign * (i * 1.73 + 0.01));
+            lo.emplace_back(0.0);
+            hi.emplace_back(20.0);
+        }
+        const auto initial_pos = pos;
+        const auto initial_speed = speed;
+
+        WHEN("points are moved by the selected kernel") {
+            constexpr double DT = 0.7;
+            geom::MoveClamped(pos.data(), speed.data(), lo.data(), hi.data(), DT, COUNT);
+
+            THEN("every element matches the scalar fixed-point formula bit for bit") {
+                const std::int64_t step = geom::Fixed{DT}.GetRaw();
+                for (size_t i = 0; i < COUNT; ++i) {
+                    const auto moved = initial_pos[i].GetRaw()
+                                       + ((initial_speed[i].GetRaw() * step) >> geom::Fixed::FRACTION_BITS);
+                    const auto clamped = std::clamp<std::int64_t>(moved, lo[i].GetRaw(), hi[i].GetRaw());
+                    CHECK(pos[i].GetRaw() == clamped);
+                    CHECK(speed[i].GetRaw() == (clamped == moved ? initial_speed[i].GetRaw() : 0));
+                }
+            }
+        }
+    }
+}
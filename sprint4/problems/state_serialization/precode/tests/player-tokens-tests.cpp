@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../src/player_tokens.h"
+
+using namespace app;
+using namespace std::literals;
+
+SCENARIO("Player tokens") {
+    GIVEN("a token index") {
+        PlayerTokens tokens;
+
+        WHEN("a player is added") {
+            const auto token = tokens.Add(PlayerId{7u});
+
+            THEN("the token consists of 32 hex digits and resolves to the player") {
+                CHECK((*token).size() == 32);
+                CHECK((*token).find_first_not_of("0123456789abcdef"sv) == std::string::npos);
+                CHECK(tokens.Find(*token) == PlayerId{7u});
+            }
+
+            THEN("malformed and unknown tokens are not found") {
+                CHECK(!tokens.Find(""sv));
+                CHECK(!tokens.Find((*token).substr(1)));
+                CHECK(!tokens.Find("0x" + (*token).substr(2)));
+                CHECK(!tokens.Find("00000000000000000000000000000000"sv));
+                auto other = *token;
+                other[31] = other[31] == '0' ? '1' : '0';
+                CHECK(!tokens.Find(other));
+            }
+
+            AND_WHEN("the token is removed") {
+                CHECK(tokens.Remove(*token));
+
+                THEN("it is no longer found") {
+                    CHECK(!tokens.Find(*token));
+                    CHECK(!tokens.Remove(*token));
+                }
+            }
+        }
+
+        WHEN("many players are added while other threads look tokens up") {
+            constexpr uint32_t PLAYER_COUNT = 10000;
+            const auto first = tokens.Add(PlayerId{0u});
+            std::atomic<bool> done{false};
+            std::atomic<bool> lost{false};
+            std::vector<std::jthread> readers;
+            for (int i = 0; i < 4; ++i) {
+                readers.emplace_back([&] {
+                    while (!done.load()) {
+                        if (tokens.Find(*first) != PlayerId{0u}) {
+                            lost = true;
+                        }
+                    }
+                });
+            }
+            std::vector<Token> added;
+            for (uint32_t i = 1; i < PLAYER_COUNT; ++i) {
+                added.push_back(tokens.Add(PlayerId{i}));
+            }
+            done = true;
+            readers.clear();
+
+            THEN("every token resolves to its player") {
+                CHECK(!lost);
+                bool all_found = true;
+                for (uint32_t i = 1; i < PLAYER_COUNT; ++i) {
+                    all_found = all_found && tokens.Find(*added[i - 1]) == PlayerId{i};
+                }
+                CHECK(all_found);
+            }
+        }
+    }
+}
@@ -0,0 +1,212 @@
+#include <catch2/catch_test_macros.hpp>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "../src/leaderboard_writer.h"
+#include "../src/timing_wheel.h"
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+// Запоминает сохранённые пакеты. Пока fail не сброшен, сохранение не удаётся
+class FakeRepository : public app::RetiredPlayerRepository {
+public:
+    void SaveRetired(const std::vector<RetiredDog>& players) override {
+        std::lock_guard lk{mutex};
+        if (fail) {
+            throw std::runtime_error("Database is unavailable");
+        }
+        batches.push_back(players);
+    }
+
+    std::mutex mutex;
+    std::vector<std::vector<RetiredDog>> batches;
+    bool fail = false;
+};
+
+std::vector<RetiredDog> MakePlayers(size_t count) {
+    std::vector<RetiredDog> players;
+    for (size_t i = 0; i < count; ++i) {
+        players.push_back({Dog::Id{static_cast<uint32_t>(i)}, "Dog "s + std::to_string(i), 10, 1s});
+    }
+    return players;
+}
+
+}  // namespace
+
+SCENARIO("Timing wheel") {
+    GIVEN("a wheel with 100 ms slots") {
+        util::TimingWheel<int> wheel{100ms};
+        std::vector<int> due;
+        const auto collect = [&due](int key, TimeInterval) {
+            due.push_back(key);
+        };
+
+        WHEN("items with near and far deadlines are added") {
+            wheel.Add(1, 250ms);
+            wheel.Add(2, 10s);
+            wheel.Add(3, 1h);
+            CHECK(wheel.Size() == 3);
+
+            THEN("each item is reported once its deadline has passed") {
+                wheel.Advance(200ms, collect);
+                CHECK(due.empty());
+                wheel.Advance(300ms, collect);
+                CHECK(due == std::vector{1});
+                wheel.Advance(9900ms, collect);
+                CHECK(due == std::vector{1});
+                wheel.Advance(10s, collect);
+                CHECK(due == std::vector{1, 2});
+                wheel.Advance(1h - 100ms, collect);
+                CHECK(due == std::vector{1, 2});
+                wheel.Advance(1h + 50ms, collect);
+                CHECK(due == std::vector{1, 2, 3});
+                CHECK(wheel.Size() == 0);
+            }
+        }
+
+        WHEN("an item is re-added from the due callback") {
+            wheel.Add(1, 100ms);
+            wheel.Advance(100ms, [&](int key, TimeInterval deadline) {
+                due.push_back(key);
+                wheel.Add(key, deadline + 1s);
+            });
+
+            THEN("it is reported again at the new deadline") {
+                CHECK(due == std::vector{1});
+                wheel.Advance(1s, collect);
+                CHECK(due == std::vector{1});
+                wheel.Advance(1100ms, collect);
+                CHECK(due == std::vector{1, 1});
+            }
+        }
+    }
+}
+
+SCENARIO("Idle dog retirement") {
+    GIVEN("a session where dogs retire after 10 seconds of standing still") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad({Road::HORIZONTAL, {0, 0}, 1000});
+        GameSession session{map, 10s};
+        const auto idle = session.AddDog("Idle"s, {0, 0}, 3);
+        const auto runner = session.AddDog("Runner"s, {0, 0}, 3);
+        auto& dogs = session.GetDogs();
+        dogs.GetProfile(*dogs.FindIndex(idle)).score = 42;
+
+        WHEN("one dog keeps moving and the other stands still") {
+            dogs.SetSpeed(*dogs.FindIndex(runner), {1, 0});
+            for (int i = 0; i < 99; ++i) {
+                session.Tick(100ms);
+            }
+
+            THEN("neither retires before the retirement time") {
+                CHECK(dogs.Size() == 2);
+                CHECK(session.TakeRetired().empty());
+            }
+
+            session.Tick(100ms);
+
+            THEN("only the dog standing still retires with its score and play time") {
+                CHECK(dogs.Size() == 1);
+                CHECK(dogs.FindIndex(runner).has_value());
+                const auto retired = session.TakeRetired();
+                REQUIRE(retired.size() == 1);
+                CHECK(retired[0].id == idle);
+                CHECK(retired[0].name == "Idle"s);
+                CHECK(retired[0].score == 42);
+                CHECK(retired[0].play_time == 10s);
+                CHECK(session.TakeRetired().empty());
+            }
+        }
+
+        WHEN("a dog stops after moving for a while") {
+            const auto index = *dogs.FindIndex(runner);
+            dogs.SetSpeed(index, {1, 0});
+            for (int i = 0; i < 50; ++i) {
+                session.Tick(100ms);
+            }
+            dogs.SetSpeed(*dogs.FindIndex(runner), {0, 0});
+            for (int i = 0; i < 99; ++i) {
+                session.Tick(100ms);
+            }
+
+            THEN("it retires the retirement time after it stopped") {
+                CHECK(dogs.FindIndex(runner).has_value());
+                // Собака, не двигавшаяся с начала, ушла раньше
+                CHECK(session.TakeRetired().size() == 1);
+                session.Tick(100ms);
+                CHECK_FALSE(dogs.FindIndex(runner).has_value());
+                const auto retired = session.TakeRetired();
+                REQUIRE(retired.size() == 1);
+                CHECK(retired[0].play_time == 15s);
+            }
+        }
+    }
+}
+
+SCENARIO("Leaderboard writer") {
+    GIVEN("a writer over a repository") {
+        FakeRepository repository;
+
+        WHEN("more players than fit into one batch retire") {
+            {
+                app::LeaderboardWriter writer{repository, 1h};
+                writer.Add(MakePlayers(app::LeaderboardWriter::MAX_BATCH_SIZE + 1));
+                writer.Flush();
+            }
+
+            THEN("they are saved in full batches in the order of retirement") {
+                REQUIRE(repository.batches.size() == 2);
+                CHECK(repository.batches[0].size() == app::LeaderboardWriter::MAX_BATCH_SIZE);
+                CHECK(repository.batches[0].front().name == "Dog 0"s);
+                REQUIRE(repository.batches[1].size() == 1);
+                CHECK(repository.batches[1][0].name == "Dog 1000"s);
+            }
+        }
+
+        WHEN("players retire one by one within the flush interval") {
+            app::LeaderboardWriter writer{repository, 50ms};
+            for (int i = 0; i < 5; ++i) {
+                writer.Add(MakePlayers(1));
+            }
+            writer.Flush();
+
+            THEN("they are saved in a single transaction") {
+                REQUIRE(repository.batches.size() == 1);
+                CHECK(repository.batches[0].size() == 5);
+            }
+        }
+
+        WHEN("the database is unavailable") {
+            app::LeaderboardWriter writer{repository, 10ms};
+            repository.fail = true;
+            writer.Add(MakePlayers(3));
+
+            THEN("flush reports the error and the players are saved after the database recovers") {
+                CHECK_THROWS_AS(writer.Flush(), std::runtime_error);
+                {
+                    std::lock_guard lk{repository.mutex};
+                    repository.fail = false;
+                }
+                writer.Flush();
+                REQUIRE(repository.batches.size() == 1);
+                CHECK(repository.batches[0].size() == 3);
+            }
+        }
+
+        WHEN("the writer is destroyed with players in the queue") {
+            {
+                app::LeaderboardWriter writer{repository, 1h};
+                writer.Add(MakePlayers(2));
+            }
+
+            THEN("they are saved before the writer stops") {
+                REQUIRE(repository.batches.size() == 1);
+                CHECK(repository.batches[0].size() == 2);
+            }
+        }
+    }
+}
@@ -1,10 +1,15 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <filesystem>
 #include <sstream>
 
+#include "../src/background_saver.h"
+#include "../src/dog_archive.h"
 #include "../src/model.h"
 #include "../src/model_serialization.h"
+#include "../src/state_log.h"
+#include "coord-approx.h"
 
 using namespace model;
 using namespace std::literals;
@@ -69,3 +74,179 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+SCENARIO("Dog archive") {
+    GIVEN("a registry with dogs carrying loot") {
+        DogRegistry dogs;
+        Dog dog{Dog::Id{42}, "Pluto"s, {42.2, 12.5}, 3};
+        dog.SetSpeed({2.3, -1.2});
+        dog.SetDirection(Direction::WEST);
+        dog.AddScore(42);
+        CHECK(dog.PutToBag({FoundObject::Id{10}, 2u}));
+        CHECK(dog.PutToBag({FoundObject::Id{11}, 3u}));
+        dogs.Add(dog);
+        dogs.Add(Dog{Dog::Id{7}, ""s, {0, 0}, 0});
+
+        WHEN("the registry is archived") {
+            std::string data;
+            serialization::WriteDogs(dogs, data);
+
+            THEN("the same dogs are read back") {
+                std::string_view rest = data;
+                const auto restored = serialization::ReadDogs(rest);
+                CHECK(rest.empty());
+                REQUIRE(restored.Size() == 2);
+                const auto restored_dog = restored.Get(*restored.FindIndex(Dog::Id{42}));
+                CHECK(restored_dog.GetName() == dog.GetName());
+                CHECK(restored_dog.GetPosition().x == CoordApprox(dog.GetPosition().x));
+                CHECK(restored_dog.GetPosition().y == CoordApprox(dog.GetPosition().y));
+                CHECK(restored_dog.GetSpeed().x == CoordApprox(dog.GetSpeed().x));
+                CHECK(restored_dog.GetSpeed().y == CoordApprox(dog.GetSpeed().y));
+                CHECK(restored_dog.GetDirection() == dog.GetDirection());
+                CHECK(restored_dog.GetScore() == dog.GetScore());
+                CHECK(restored_dog.GetBagCapacity() == dog.GetBagCapacity());
+                CHECK(restored_dog.GetBagContent() == dog.GetBagContent());
+                CHECK(restored.Get(*restored.FindIndex(Dog::Id{7})).GetName().empty());
+            }
+
+            THEN("truncated data is rejected") {
+                for (size_t size = 0; size < data.size(); ++size) {
+                    std::string_view truncated{data.data(), size};
+                    CHECK_THROWS_AS(serialization::ReadDogs(truncated), std::runtime_error);
+                }
+            }
+
+            THEN("data of a newer version is rejected") {
+                data[4] = static_cast<char>(serialization::DOG_ARCHIVE_VERSION + 1);
+                std::string_view rest = data;
+                CHECK_THROWS_AS(serialization::ReadDogs(rest), std::runtime_error);
+                CHECK_FALSE(serialization::TryReadDogs(rest).has_value());
+                CHECK(rest.size() == data.size());
+            }
+
+            THEN("archives of several sessions are read in parallel, and a corrupted one is skipped") {
+                std::vector<std::string_view> archives(9, data);
+                archives[4] = std::string_view{data}.substr(0, data.size() - 1);
+                const auto restored = serialization::ReadDogsParallel(archives, 4);
+                REQUIRE(restored.size() == archives.size());
+                for (size_t i = 0; i < restored.size(); ++i) {
+                    REQUIRE(restored[i].has_value() == (i != 4));
+                    if (restored[i]) {
+                        CHECK(restored[i]->Size() == 2);
+                        CHECK(restored[i]->Get(*restored[i]->FindIndex(Dog::Id{42})).GetBagContent()
+                              == dog.GetBagContent());
+                    }
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+struct StateLogFixture {
+    StateLogFixture() {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    ~StateLogFixture() {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "state_log_tests";
+    std::filesystem::path path = dir / "state";
+};
+
+}  // namespace
+
+SCENARIO_METHOD(StateLogFixture, "Incremental state log") {
+    GIVEN("a registry saved once") {
+        DogRegistry dogs;
+        for (uint32_t i = 0; i < 3; ++i) {
+            dogs.Add(Dog{Dog::Id{i}, "Dog "s + std::to_string(i), {double(i), 0}, 2});
+        }
+        serialization::StateLog log{path};
+        log.Save(dogs);
+
+        WHEN("some dogs change and one is removed") {
+            dogs.SetPosition(*dogs.FindIndex(Dog::Id{1u}), {5, 5});
+            dogs.GetProfile(*dogs.FindIndex(Dog::Id{2u})).score = 30;
+            CHECK(dogs.Remove(Dog::Id{0u}));
+            log.Save(dogs);
+
+            THEN("the state is restored from the snapshot and the log") {
+                const auto restored = serialization::StateLog{path}.Load();
+                REQUIRE(restored.size() == 2);
+                CHECK(restored[0].GetId() == Dog::Id{1u});
+                CHECK(restored[0].GetPosition() == geom::Point2D{5, 5});
+                CHECK(restored[1].GetScore() == 30u);
+            }
+
+            AND_WHEN("the last log record is torn") {
+                dogs.SetPosition(*dogs.FindIndex(Dog::Id{1u}), {7, 7});
+                log.Save(dogs);
+                std::filesystem::resize_file(log.GetLogPath(),
+                                             std::filesystem::file_size(log.GetLogPath()) - 1);
+
+                THEN("the torn record is ignored") {
+                    const auto restored = serialization::StateLog{path}.Load();
+                    REQUIRE(restored.size() == 2);
+                    CHECK(restored[0].GetPosition() == geom::Point2D{5, 5});
+                }
+            }
+        }
+
+        WHEN("nothing changes") {
+            log.Save(dogs);
+
+            THEN("nothing is appended") {
+                CHECK(std::filesystem::file_size(log.GetLogPath()) == 0);
+            }
+        }
+
+        WHEN("the log grows larger than the snapshot") {
+            for (int save = 0; save < 1000; ++save) {
+                dogs.SetPosition(*dogs.FindIndex(Dog::Id{save % 3u}), {double(save), 0});
+                log.Save(dogs);
+            }
+
+            THEN("it is compacted into the snapshot") {
+                CHECK(std::filesystem::file_size(log.GetLogPath()) < 64 * 1024);
+                const auto restored = serialization::StateLog{path}.Load();
+                REQUIRE(restored.size() == 3);
+                CHECK(restored[0].GetPosition() == geom::Point2D{999, 0});
+            }
+        }
+    }
+}
+
+SCENARIO_METHOD(StateLogFixture, "Background state saving") {
+    GIVEN("a background saver") {
+        DogRegistry dogs;
+        for (uint32_t i = 0; i < 100; ++i) {
+            dogs.Add(Dog{Dog::Id{i}, "Dog "s + std::to_string(i), {double(i), 0}, 2});
+        }
+        serialization::StateLog log{path};
+        serialization::BackgroundSaver saver{log};
+
+        WHEN("the world keeps changing while saves are written") {
+            for (int step = 0; step < 50; ++step) {
+                dogs.SetPosition(*dogs.FindIndex(Dog::Id{step % 100u}), {double(step), 1});
+                saver.Save(dogs);
+            }
+            saver.Wait();
+            // Изменения, пропущенные из-за незаконченных записей, попадают в последнее сохранение
+            CHECK(saver.Save(dogs));
+            saver.Wait();
+
+            THEN("the saved state matches the world") {
+                const auto restored = serialization::StateLog{path}.Load();
+                REQUIRE(restored.size() == dogs.Size());
+                for (const auto& dog : restored) {
+                    CHECK(dog.GetPosition() == dogs.GetPosition(*dogs.FindIndex(dog.GetId())));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+
+#include "../src/ticker.h"
+#include "tracing.h"
+
+using namespace tracing;
+using namespace std::literals;
+namespace net = boost::asio;
+
+namespace {
+
+// Включает запись всех трасс и отбрасывает интервалы, оставшиеся от других тестов
+struct TracingFixture {
+    TracingFixture() {
+        Tracer::Instance().SetSampleRate(1.0);
+        Tracer::Instance().Drain();
+    }
+
+    ~TracingFixture() {
+        Tracer::Instance().SetSampleRate(0.0);
+        Tracer::Instance().Drain();
+    }
+
+    const SpanRecord* Find(const std::vector<SpanRecord>& spans, std::string_view name) const {
+        for (const auto& span : spans) {
+            if (span.name == name) {
+                return &span;
+            }
+        }
+        return nullptr;
+    }
+};
+
+}  // namespace
+
+SCENARIO_METHOD(TracingFixture, "Tracing spans") {
+    GIVEN("a root span with a child handled in a strand") {
+        net::io_context io;
+        auto strand = net::make_strand(io);
+        auto root = Span::StartRoot("request");
+        {
+            const ContextScope scope{root.GetContext()};
+            net::post(strand, BindContext([&strand] {
+                          // Обёртка сохраняет исполнитель обработчика
+                          CHECK(strand.running_in_this_thread());
+                          Span child{"handler", GetCurrentContext()};
+                      }));
+        }
+        CHECK(!GetCurrentContext().IsSampled());
+        io.run();
+        root.End();
+
+        THEN("the child belongs to the trace of the root") {
+            const auto spans = Tracer::Instance().Drain();
+            REQUIRE(spans.size() == 2);
+            const auto* request = Find(spans, "request");
+            const auto* handler = Find(spans, "handler");
+            REQUIRE(request);
+            REQUIRE(handler);
+            CHECK(request->parent_id == 0);
+            CHECK(handler->parent_id == request->context.span_id);
+            CHECK(handler->context.trace_id_low == request->context.trace_id_low);
+            CHECK(handler->context.trace_id_high == request->context.trace_id_high);
+            CHECK(request->start_ns <= handler->start_ns);
+            CHECK(handler->end_ns <= request->end_ns);
+
+            AND_THEN("spans are exported in Chrome and OTLP formats") {
+                std::ostringstream chrome;
+                WriteChromeEvents(chrome, spans, true);
+                CHECK(chrome.str().find("\"name\":\"handler\""s) != std::string::npos);
+                std::ostringstream otlp;
+                WriteOtlpBatch(otlp, spans, "game_server"sv, Tracer::Instance().GetUnixOffset());
+                CHECK(otlp.str().find("\"stringValue\":\"game_server\""s) != std::string::npos);
+                CHECK(otlp.str().find("\"parentSpanId\""s) != std::string::npos);
+            }
+        }
+    }
+
+    GIVEN("sampling is disabled") {
+        Tracer::Instance().SetSampleRate(0.0);
+        {
+            auto root = Span::StartRoot("request");
+            CHECK(!root.IsRecording());
+            Span child{"handler", root.GetContext()};
+            CHECK(!child.IsRecording());
+        }
+
+        THEN("nothing is recorded") {
+            CHECK(Tracer::Instance().Drain().empty());
+        }
+    }
+
+    GIVEN("a traceparent header") {
+        const auto header = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"sv;
+
+        THEN("the remote trace is continued") {
+            const auto remote = ParseTraceParent(header);
+            REQUIRE(remote);
+            CHECK(FormatTraceParent(*remote) == header);
+            Span::StartRoot("request", remote);
+            const auto spans = Tracer::Instance().Drain();
+            REQUIRE(spans.size() == 1);
+            CHECK(spans[0].parent_id == 0x00f067aa0ba902b7);
+            CHECK(spans[0].context.trace_id_high == 0x4bf92f3577b34da6);
+        }
+
+        THEN("a trace not sampled by the sender is not recorded") {
+            const auto remote = ParseTraceParent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00"sv);
+            REQUIRE(remote);
+            CHECK(!Span::StartRoot("request", remote).IsRecording());
+        }
+
+        THEN("malformed headers are ignored") {
+            CHECK(!ParseTraceParent("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7"sv));
+            CHECK(!ParseTraceParent("00-00000000000000000000000000000000-00f067aa0ba902b7-01"sv));
+            CHECK(!ParseTraceParent("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01"sv));
+        }
+    }
+
+    GIVEN("a ticker") {
+        net::io_context io;
+        auto ticker = std::make_shared<app::Ticker>(net::make_strand(io), 5ms, [&io](auto) {
+            // Работа тика попадает в его трассу
+            Span span{"session.tick", GetCurrentContext()};
+            io.stop();
+        });
+        ticker->Start();
+        io.run();
+
+        THEN("each tick is the root of its own trace") {
+            const auto spans = Tracer::Instance().Drain();
+            const auto* tick = Find(spans, "game.tick");
+            const auto* session = Find(spans, "session.tick");
+            REQUIRE(tick);
+            REQUIRE(session);
+            CHECK(session->parent_id == tick->context.span_id);
+        }
+    }
+}